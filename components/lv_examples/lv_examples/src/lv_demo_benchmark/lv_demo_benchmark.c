@@ -76,6 +76,7 @@ LV_FONT_DECLARE(lv_font_montserrat_12_compr_az);
 LV_FONT_DECLARE(lv_font_montserrat_16_compr_az);
 LV_FONT_DECLARE(lv_font_montserrat_28_compr_az);
 
+static void benchmark_init(void);
 static void monitor_cb(lv_disp_drv_t * drv, uint32_t time, uint32_t px);
 static void scene_next_task_cb(lv_task_t * task);
 static void rect_create(lv_style_t * style);
@@ -630,6 +631,41 @@ void lv_demo_benchmark(void)
     lv_disp_t * disp = lv_disp_get_next(NULL);
     disp->driver.monitor_cb = monitor_cb;
 
+    benchmark_init();
+
+    /*Manually start scenes*/
+    scene_next_task_cb(NULL);
+}
+
+const char * lv_demo_benchmark_get_scene_name(uint32_t scene_no)
+{
+    if(scene_no >= sizeof(scenes) / sizeof(scene_dsc_t) - 1) return NULL;
+
+    return scenes[scene_no].name;
+}
+
+void lv_demo_benchmark_run_scene(uint32_t scene_no, bool opa)
+{
+    if(lv_demo_benchmark_get_scene_name(scene_no) == NULL) return;
+
+    if(scene_bg == NULL) benchmark_init();
+    else lv_obj_clean(scene_bg);
+
+    scene_act = scene_no;
+    opa_mode = opa;
+    lv_label_set_text_fmt(title, "%d/%d: %s%s", scene_act * 2 + (opa_mode ? 1 : 0), (sizeof(scenes) / sizeof(scene_dsc_t) * 2) - 2,  scenes[scene_act].name, opa_mode ? " + opa" : "");
+    lv_label_set_text(subtitle, "");
+
+    rnd_reset();
+    scenes[scene_act].create_cb();
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void benchmark_init(void)
+{
     lv_obj_t * scr = lv_scr_act();
     lv_obj_reset_style_list(scr, LV_OBJ_PART_MAIN);
     lv_obj_set_style_local_bg_opa(scr, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, LV_OPA_COVER);
@@ -646,15 +682,8 @@ void lv_demo_benchmark(void)
     lv_obj_align(scene_bg, NULL, LV_ALIGN_IN_BOTTOM_MID, 0, 0);
 
     lv_style_init(&style_common);
-
-    /*Manually start scenes*/
-    scene_next_task_cb(NULL);
 }
 
-/**********************
- *   STATIC FUNCTIONS
- **********************/
-
 static void monitor_cb(lv_disp_drv_t * drv, uint32_t time, uint32_t px)
 {
     if(opa_mode) {
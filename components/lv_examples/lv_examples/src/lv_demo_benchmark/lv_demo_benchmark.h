@@ -27,6 +27,21 @@ extern "C" {
  **********************/
 void lv_demo_benchmark(void);
 
+/**
+ * Get the name of a scene
+ * @param scene_no index of the scene
+ * @return name of the scene or NULL if there are less scenes
+ */
+const char * lv_demo_benchmark_get_scene_name(uint32_t scene_no);
+
+/**
+ * Show a scene and keep it running, e.g. to measure it without display.
+ * The benchmark doesn't step to the next scene by itself.
+ * @param scene_no index of the scene
+ * @param opa true: draw with opacity (the "+ opa" variant)
+ */
+void lv_demo_benchmark_run_scene(uint32_t scene_no, bool opa);
+
 /**********************
  *      MACROS
  **********************/
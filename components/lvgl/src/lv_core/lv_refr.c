@@ -15,13 +15,17 @@
 #include "../lv_misc/lv_mem.h"
 #include "../lv_misc/lv_math.h"
 #include "../lv_misc/lv_gc.h"
+#include "../lv_misc/lv_prof.h"
 #include "../lv_draw/lv_draw.h"
 #include "../lv_font/lv_font_fmt_txt.h"
 #include "../lv_gpu/lv_gpu_stm32_dma2d.h"
 
-#if LV_USE_PERF_MONITOR
+#if LV_USE_PERF_MONITOR || LV_USE_PROFILER_OVERLAY
     #include "../lv_widgets/lv_label.h"
 #endif
+#if LV_USE_PROFILER_OVERLAY
+    #include "../lv_misc/lv_printf.h"
+#endif
 
 /*********************
  *      DEFINES
@@ -29,31 +33,73 @@
 /* Draw translucent random colored areas on the invalidated (redrawn) areas*/
 #define MASK_AREA_DEBUG 0
 
+#if LV_INV_TILE_SIZE
+#define TILE_BIT(col) ((uint32_t)1 << ((col) & 0x1F))
+#define TILE_IS_DIRTY(map, row, col) (((map)[row][(col) >> 5] & TILE_BIT(col)) != 0)
+#endif
+
 /**********************
  *      TYPEDEFS
  **********************/
+#if LV_REFR_OCCLUDER_MAX
+/*Opaque areas of objects drawn later than the ones being drawn. The next to draw is the last.*/
+typedef struct {
+    lv_area_t area[LV_REFR_OCCLUDER_MAX];
+    const lv_obj_t * obj[LV_REFR_OCCLUDER_MAX];
+    uint8_t cnt;
+    uint8_t masked : 1; /*A parent masks its children (e.g. clipped corners): they are not opaque*/
+} lv_refr_occ_t;
+#else
+typedef uint8_t lv_refr_occ_t; /*Unused*/
+#endif
 
 /**********************
  *  STATIC PROTOTYPES
  **********************/
 static void lv_refr_join_area(void);
 static void lv_refr_areas(void);
+#if LV_INV_TILE_SIZE
+static void lv_inv_tiles_mark(lv_disp_t * disp, const lv_area_t * area_p);
+static bool lv_inv_tiles_fit(lv_disp_t * disp);
+static bool lv_refr_tiles_next(lv_area_t * area_p);
+static void lv_refr_tiles(void);
+#endif
+static void lv_refr_copy_area(const lv_area_t * area_p, uint8_t * buf_act, uint8_t * buf_ina, lv_color_t * copy_buf);
 static void lv_refr_area(const lv_area_t * area_p);
 static void lv_refr_area_part(const lv_area_t * area_p);
 static lv_obj_t * lv_refr_get_top_obj(const lv_area_t * area_p, lv_obj_t * obj);
-static void lv_refr_obj_and_children(lv_obj_t * top_p, const lv_area_t * mask_p);
-static void lv_refr_obj(lv_obj_t * obj, const lv_area_t * mask_ori_p);
+static void lv_refr_obj_and_children(lv_obj_t * top_p, const lv_area_t * mask_p, const lv_refr_occ_t * base_p);
+static void lv_refr_obj_parts(lv_obj_t * obj, const lv_area_t * mask_p, const lv_refr_occ_t * occ_p);
+static void lv_refr_obj(lv_obj_t * obj, const lv_area_t * mask_ori_p, const lv_refr_occ_t * occ_p);
+#if LV_REFR_OCCLUDER_MAX
+static bool lv_refr_get_opaque_area(lv_obj_t * obj, const lv_area_t * mask_p, lv_area_t * res_p);
+static void lv_refr_occ_add(lv_refr_occ_t * occ_p, lv_obj_t * obj, const lv_area_t * mask_p);
+static void lv_refr_occ_add_younger(lv_refr_occ_t * occ_p, lv_obj_t * border_p, const lv_area_t * mask_p);
+static void lv_refr_occ_inherit(lv_refr_occ_t * occ_p, const lv_refr_occ_t * from_p, const lv_area_t * mask_p);
+static void lv_refr_occ_pop(lv_refr_occ_t * occ_p, const lv_obj_t * obj);
+static uint8_t lv_refr_get_visible_parts(const lv_area_t * mask_p, const lv_refr_occ_t * occ_p, lv_area_t * parts);
+#endif
 static void lv_refr_vdb_flush(void);
+#if LV_USE_PROFILER_OVERLAY && LV_USE_LABEL
+static void lv_refr_prof_overlay(bool refreshed);
+#endif
 
 /**********************
  *  STATIC VARIABLES
  **********************/
 static uint32_t px_num;
 static lv_disp_t * disp_refr; /*Display being refreshed*/
+static lv_refr_stat_t stat;
+#if LV_REFR_OCCLUDER_MAX
+    static bool occlusion_en = true;
+#endif
 #if LV_USE_PERF_MONITOR
     static uint32_t fps_sum_cnt;
     static uint32_t fps_sum_all;
 #endif
+#if LV_INV_TILE_SIZE
+    static uint32_t tiles_left[LV_INV_TILE_ROWS][LV_INV_TILE_WORDS]; /*Dirty tiles not refreshed yet*/
+#endif
 
 /**********************
  *      MACROS
@@ -111,6 +157,9 @@ void _lv_inv_area(lv_disp_t * disp, const lv_area_t * area_p)
     /*Clear the invalidate buffer if the parameter is NULL*/
     if(area_p == NULL) {
         disp->inv_p = 0;
+#if LV_INV_TILE_SIZE
+        disp->inv_tiled = 0;
+#endif
         return;
     }
 
@@ -129,6 +178,15 @@ void _lv_inv_area(lv_disp_t * disp, const lv_area_t * area_p)
     if(suc != false) {
         if(disp->driver.rounder_cb) disp->driver.rounder_cb(&disp->driver, &com_area);
 
+#if LV_INV_TILE_SIZE
+        /*The buffer has overflowed: mark the tiles of the area*/
+        if(disp->inv_tiled) {
+            lv_inv_tiles_mark(disp, &com_area);
+            lv_task_set_prio(disp->refr_task, LV_REFR_TASK_PRIO);
+            return;
+        }
+#endif
+
         /*Save only if this area is not in one of the saved areas*/
         uint16_t i;
         for(i = 0; i < disp->inv_p; i++) {
@@ -138,16 +196,78 @@ void _lv_inv_area(lv_disp_t * disp, const lv_area_t * area_p)
         /*Save the area*/
         if(disp->inv_p < LV_INV_BUF_SIZE) {
             lv_area_copy(&disp->inv_areas[disp->inv_p], &com_area);
+            disp->inv_p++;
+        }
+#if LV_INV_TILE_SIZE
+        /*If no place for the area move all areas to the tile map. `inv_p` stays at the buffer size.*/
+        else if(lv_inv_tiles_fit(disp)) {
+            _lv_memset_00(disp->inv_tiles, sizeof(disp->inv_tiles));
+            for(i = 0; i < disp->inv_p; i++) {
+                lv_inv_tiles_mark(disp, &disp->inv_areas[i]);
+            }
+            lv_inv_tiles_mark(disp, &com_area);
+            disp->inv_tiled = 1;
         }
+#endif
         else {   /*If no place for the area add the screen*/
             disp->inv_p = 0;
             lv_area_copy(&disp->inv_areas[disp->inv_p], &scr_area);
+            disp->inv_p++;
         }
-        disp->inv_p++;
         lv_task_set_prio(disp->refr_task, LV_REFR_TASK_PRIO);
     }
 }
 
+/**
+ * Get the rendering counters
+ * @param stat_p pointer to a variable to copy the counters to
+ */
+void lv_refr_get_stat(lv_refr_stat_t * stat_p)
+{
+    _lv_memcpy(stat_p, &stat, sizeof(lv_refr_stat_t));
+}
+
+/**
+ * Clear the rendering counters
+ */
+void lv_refr_reset_stat(void)
+{
+    _lv_memset_00(&stat, sizeof(stat));
+}
+
+/**
+ * Get the overdraw ratio since `lv_refr_reset_stat`
+ * @return blended pixels per refreshed pixel in percent (100: every pixel was blended once)
+ */
+uint32_t lv_refr_get_overdraw(void)
+{
+    if(stat.px_cnt == 0) return 0;
+    return (uint32_t)(((uint64_t)stat.blend_px_cnt * 100) / stat.px_cnt);
+}
+
+/**
+ * Enable or disable skipping objects hidden by opaque objects above them
+ * @param en true: skip hidden objects and parts (default); false: draw every object under the top object
+ */
+void lv_refr_set_occlusion(bool en)
+{
+#if LV_REFR_OCCLUDER_MAX
+    occlusion_en = en;
+#else
+    LV_UNUSED(en);
+#endif
+}
+
+/**
+ * Count pixels passed to the blending functions. Called by the draw functions.
+ * @param px number of pixels
+ */
+void _lv_refr_stat_blend(uint32_t px)
+{
+    stat.blend_px_cnt += px;
+    LV_PROF_PX(px);
+}
+
 /**
  * Get the display which is being refreshed
  * @return the display being refreshed
@@ -191,12 +311,26 @@ void _lv_disp_refr_task(lv_task_t * task)
     /*Do nothing if there is no active screen*/
     if(disp_refr->act_scr == NULL) {
         disp_refr->inv_p = 0;
+#if LV_INV_TILE_SIZE
+        disp_refr->inv_tiled = 0;
+#endif
         return;
     }
 
-    lv_refr_join_area();
+    LV_PROF_FRAME_BEGIN();
 
-    lv_refr_areas();
+#if LV_INV_TILE_SIZE
+    if(disp_refr->inv_tiled) {
+        lv_refr_tiles();
+    }
+    else
+#endif
+    {
+        LV_PROF_BEGIN(LV_PROF_JOIN);
+        lv_refr_join_area();
+        LV_PROF_END(LV_PROF_JOIN);
+        lv_refr_areas();
+    }
 
     /*If refresh happened ...*/
     if(disp_refr->inv_p != 0) {
@@ -215,7 +349,11 @@ void _lv_disp_refr_task(lv_task_t * task)
                 /* With true double buffering the flushing should be only the address change of the
                  * current frame buffer. Wait until the address change is ready and copy the changed
                  * content to the other frame buffer (new active VDB) to keep the buffers synchronized*/
-                while(vdb->flushing);
+                if(vdb->flushing) {
+                    LV_PROF_BEGIN(LV_PROF_FLUSH);
+                    while(vdb->flushing);
+                    LV_PROF_END(LV_PROF_FLUSH);
+                }
 
                 lv_color_t * copy_buf = NULL;
 #if LV_USE_GPU_STM32_DMA2D
@@ -227,30 +365,22 @@ void _lv_disp_refr_task(lv_task_t * task)
                 uint8_t * buf_act = (uint8_t *)vdb->buf_act;
                 uint8_t * buf_ina = (uint8_t *)vdb->buf_act == vdb->buf1 ? vdb->buf2 : vdb->buf1;
 
-                lv_coord_t hres = lv_disp_get_hor_res(disp_refr);
-                uint16_t a;
-                for(a = 0; a < disp_refr->inv_p; a++) {
-                    if(disp_refr->inv_area_joined[a] == 0) {
-                        uint32_t start_offs =
-                            (hres * disp_refr->inv_areas[a].y1 + disp_refr->inv_areas[a].x1) * sizeof(lv_color_t);
-#if LV_USE_GPU_STM32_DMA2D
-                        lv_gpu_stm32_dma2d_copy((lv_color_t *)(buf_act + start_offs), disp_refr->driver.hor_res,
-                                                (lv_color_t *)(buf_ina + start_offs), disp_refr->driver.hor_res,
-                                                lv_area_get_width(&disp_refr->inv_areas[a]),
-                                                lv_area_get_height(&disp_refr->inv_areas[a]));
-#else
-
-                        lv_coord_t y;
-                        uint32_t line_length = lv_area_get_width(&disp_refr->inv_areas[a]) * sizeof(lv_color_t);
-
-                        for(y = disp_refr->inv_areas[a].y1; y <= disp_refr->inv_areas[a].y2; y++) {
-                            /* The frame buffer is probably in an external RAM where sequential access is much faster.
-                             * So first copy a line into a buffer and write it back the ext. RAM */
-                            _lv_memcpy(copy_buf, buf_ina + start_offs, line_length);
-                            _lv_memcpy(buf_act + start_offs, copy_buf, line_length);
-                            start_offs += hres * sizeof(lv_color_t);
-                        }
+#if LV_INV_TILE_SIZE
+                if(disp_refr->inv_tiled) {
+                    lv_area_t area;
+                    _lv_memcpy(tiles_left, disp_refr->inv_tiles, sizeof(tiles_left));
+                    while(lv_refr_tiles_next(&area)) {
+                        lv_refr_copy_area(&area, buf_act, buf_ina, copy_buf);
+                    }
+                }
+                else
 #endif
+                {
+                    uint16_t a;
+                    for(a = 0; a < disp_refr->inv_p; a++) {
+                        if(disp_refr->inv_area_joined[a] == 0) {
+                            lv_refr_copy_area(&disp_refr->inv_areas[a], buf_act, buf_ina, copy_buf);
+                        }
                     }
                 }
 
@@ -262,6 +392,11 @@ void _lv_disp_refr_task(lv_task_t * task)
         _lv_memset_00(disp_refr->inv_areas, sizeof(disp_refr->inv_areas));
         _lv_memset_00(disp_refr->inv_area_joined, sizeof(disp_refr->inv_area_joined));
         disp_refr->inv_p = 0;
+#if LV_INV_TILE_SIZE
+        disp_refr->inv_tiled = 0;
+#endif
+
+        stat.px_cnt += px_num;
 
         elaps = lv_tick_elaps(start);
         /*Call monitor cb if present*/
@@ -273,6 +408,11 @@ void _lv_disp_refr_task(lv_task_t * task)
     _lv_mem_buf_free_all();
     _lv_font_clean_up_fmt_txt();
 
+    LV_PROF_FRAME_END(px_num != 0);
+#if LV_USE_PROFILER_OVERLAY && LV_USE_LABEL
+    lv_refr_prof_overlay(px_num != 0);
+#endif
+
 #if LV_USE_PERF_MONITOR && LV_USE_LABEL
     static lv_obj_t * perf_label = NULL;
     if(perf_label == NULL) {
@@ -404,6 +544,152 @@ static void lv_refr_areas(void)
     }
 }
 
+#if LV_INV_TILE_SIZE
+/**
+ * Mark the tiles of an area in the dirty map
+ * @param disp pointer to a display whose resolution fits the map (see `lv_inv_tiles_fit`)
+ * @param area_p pointer to an area on the screen
+ */
+static void lv_inv_tiles_mark(lv_disp_t * disp, const lv_area_t * area_p)
+{
+    uint32_t col1 = area_p->x1 / LV_INV_TILE_SIZE;
+    uint32_t col2 = area_p->x2 / LV_INV_TILE_SIZE;
+    uint32_t row1 = area_p->y1 / LV_INV_TILE_SIZE;
+    uint32_t row2 = area_p->y2 / LV_INV_TILE_SIZE;
+    uint32_t row;
+    uint32_t col;
+    for(row = row1; row <= row2; row++) {
+        for(col = col1; col <= col2; col++) {
+            disp->inv_tiles[row][col >> 5] |= TILE_BIT(col);
+        }
+    }
+}
+
+/**
+ * Tell whether the screen of a display is covered by the tile map
+ * (`LV_HOR_RES_MAX` and `LV_VER_RES_MAX` might be smaller than the rotated resolution)
+ * @param disp pointer to a display
+ * @return true: the tile map can be used
+ */
+static bool lv_inv_tiles_fit(lv_disp_t * disp)
+{
+    return lv_disp_get_hor_res(disp) <= LV_INV_TILE_COLS * LV_INV_TILE_SIZE &&
+           lv_disp_get_ver_res(disp) <= LV_INV_TILE_ROWS * LV_INV_TILE_SIZE;
+}
+
+/**
+ * Take the next rectangle of dirty tiles from `tiles_left`: the run of dirty tiles from the first
+ * dirty tile to the right, extended down while the whole run is dirty in the next row.
+ * @param area_p store the area of the rectangle here, clipped to the screen
+ * @return false: no dirty tile left
+ */
+static bool lv_refr_tiles_next(lv_area_t * area_p)
+{
+    uint32_t row;
+    uint32_t col = 0;
+    bool found = false;
+    for(row = 0; row < LV_INV_TILE_ROWS && found == false; row++) {
+        for(col = 0; col < LV_INV_TILE_COLS; col++) {
+            /*Skip clean words at once*/
+            if(tiles_left[row][col >> 5] == 0) {
+                col |= 0x1F;
+                continue;
+            }
+            if(TILE_IS_DIRTY(tiles_left, row, col)) {
+                found = true;
+                break;
+            }
+        }
+    }
+    if(found == false) return false;
+    row--;
+
+    uint32_t col_end = col + 1;
+    while(col_end < LV_INV_TILE_COLS && TILE_IS_DIRTY(tiles_left, row, col_end)) col_end++;
+
+    uint32_t row_end;
+    uint32_t c;
+    for(row_end = row + 1; row_end < LV_INV_TILE_ROWS; row_end++) {
+        for(c = col; c < col_end; c++) {
+            if(TILE_IS_DIRTY(tiles_left, row_end, c) == false) break;
+        }
+        if(c < col_end) break;
+    }
+
+    uint32_t r;
+    for(r = row; r < row_end; r++) {
+        for(c = col; c < col_end; c++) {
+            tiles_left[r][c >> 5] &= ~TILE_BIT(c);
+        }
+    }
+
+    area_p->x1 = col * LV_INV_TILE_SIZE;
+    area_p->y1 = row * LV_INV_TILE_SIZE;
+    area_p->x2 = LV_MATH_MIN(col_end * LV_INV_TILE_SIZE, (uint32_t)lv_disp_get_hor_res(disp_refr)) - 1;
+    area_p->y2 = LV_MATH_MIN(row_end * LV_INV_TILE_SIZE, (uint32_t)lv_disp_get_ver_res(disp_refr)) - 1;
+    if(disp_refr->driver.rounder_cb) disp_refr->driver.rounder_cb(&disp_refr->driver, area_p);
+
+    return true;
+}
+
+/**
+ * Refresh the dirty tiles as rectangles
+ */
+static void lv_refr_tiles(void)
+{
+    px_num = 0;
+
+    disp_refr->driver.buffer->last_area = 0;
+    disp_refr->driver.buffer->last_part = 0;
+
+    /*Look one rectangle ahead to know the last one*/
+    lv_area_t area;
+    lv_area_t next_area;
+    _lv_memcpy(tiles_left, disp_refr->inv_tiles, sizeof(tiles_left));
+    bool next = lv_refr_tiles_next(&next_area);
+    while(next) {
+        lv_area_copy(&area, &next_area);
+        next = lv_refr_tiles_next(&next_area);
+        if(next == false) disp_refr->driver.buffer->last_area = 1;
+        disp_refr->driver.buffer->last_part = 0;
+        lv_refr_area(&area);
+
+        px_num += lv_area_get_size(&area);
+    }
+}
+#endif
+
+/**
+ * Copy a refreshed area from the inactive frame buffer to the new active one (true double buffering)
+ * @param area_p pointer to the refreshed area
+ * @param buf_act the new active frame buffer
+ * @param buf_ina the frame buffer just flushed
+ * @param copy_buf a line buffer (not used with GPU)
+ */
+static void lv_refr_copy_area(const lv_area_t * area_p, uint8_t * buf_act, uint8_t * buf_ina, lv_color_t * copy_buf)
+{
+    lv_coord_t hres = lv_disp_get_hor_res(disp_refr);
+    uint32_t start_offs = (hres * area_p->y1 + area_p->x1) * sizeof(lv_color_t);
+#if LV_USE_GPU_STM32_DMA2D
+    LV_UNUSED(hres);
+    LV_UNUSED(copy_buf);
+    lv_gpu_stm32_dma2d_copy((lv_color_t *)(buf_act + start_offs), disp_refr->driver.hor_res,
+                            (lv_color_t *)(buf_ina + start_offs), disp_refr->driver.hor_res,
+                            lv_area_get_width(area_p), lv_area_get_height(area_p));
+#else
+    lv_coord_t y;
+    uint32_t line_length = lv_area_get_width(area_p) * sizeof(lv_color_t);
+
+    for(y = area_p->y1; y <= area_p->y2; y++) {
+        /* The frame buffer is probably in an external RAM where sequential access is much faster.
+         * So first copy a line into a buffer and write it back the ext. RAM */
+        _lv_memcpy(copy_buf, buf_ina + start_offs, line_length);
+        _lv_memcpy(buf_act + start_offs, copy_buf, line_length);
+        start_offs += hres * sizeof(lv_color_t);
+    }
+#endif
+}
+
 /**
  * Refresh an area if there is Virtual Display Buffer
  * @param area_p pointer to an area to refresh
@@ -500,14 +786,29 @@ static void lv_refr_area_part(const lv_area_t * area_p)
 {
     lv_disp_buf_t * vdb = lv_disp_get_buf(disp_refr);
 
+    /*With a ring of buffers wait only until the buffer of this part is flushed,
+     * the other bands can be still being flushed. (`flushing` is set only by rotated flushes.)*/
+    if(vdb->ring_cnt) {
+        if(vdb->ring_flushing[vdb->ring_act] || vdb->flushing) {
+            LV_PROF_BEGIN(LV_PROF_FLUSH);
+            while(vdb->ring_flushing[vdb->ring_act] || vdb->flushing) {
+                if(disp_refr->driver.wait_cb) disp_refr->driver.wait_cb(&disp_refr->driver);
+            }
+            LV_PROF_END(LV_PROF_FLUSH);
+        }
+    }
     /*In non double buffered mode, before rendering the next part wait until the previous image is
      * flushed*/
-    if(lv_disp_is_double_buf(disp_refr) == false) {
+    else if(lv_disp_is_double_buf(disp_refr) == false && vdb->flushing) {
+        LV_PROF_BEGIN(LV_PROF_FLUSH);
         while(vdb->flushing) {
             if(disp_refr->driver.wait_cb) disp_refr->driver.wait_cb(&disp_refr->driver);
         }
+        LV_PROF_END(LV_PROF_FLUSH);
     }
 
+    LV_PROF_BEGIN(LV_PROF_OBJ);
+
     lv_obj_t * top_act_scr = NULL;
     lv_obj_t * top_prev_scr = NULL;
 
@@ -522,6 +823,22 @@ static void lv_refr_area_part(const lv_area_t * area_p)
         top_prev_scr = lv_refr_get_top_obj(&start_mask, disp_refr->prev_scr);
     }
 
+    /*Opaque children of the top and system layers hide the screens*/
+    const lv_refr_occ_t * layer_occ_p = NULL;
+#if LV_REFR_OCCLUDER_MAX
+    lv_refr_occ_t layer_occ;
+    uint8_t sys_occ_cnt = 0;
+    if(occlusion_en) {
+        lv_obj_t * i;
+        layer_occ.cnt = 0;
+        layer_occ.masked = 0;
+        _LV_LL_READ(lv_disp_get_layer_sys(disp_refr)->child_ll, i) lv_refr_occ_add(&layer_occ, i, &start_mask);
+        sys_occ_cnt = layer_occ.cnt;
+        _LV_LL_READ(lv_disp_get_layer_top(disp_refr)->child_ll, i) lv_refr_occ_add(&layer_occ, i, &start_mask);
+        layer_occ_p = &layer_occ;
+    }
+#endif
+
     /*Draw a display background if there is no top object*/
     if(top_act_scr == NULL && top_prev_scr == NULL) {
         if(disp_refr->bg_img) {
@@ -556,7 +873,7 @@ static void lv_refr_area_part(const lv_area_t * area_p)
             top_prev_scr = disp_refr->prev_scr;
         }
         /*Do the refreshing from the top object*/
-        lv_refr_obj_and_children(top_prev_scr, &start_mask);
+        lv_refr_obj_and_children(top_prev_scr, &start_mask, layer_occ_p);
 
     }
 
@@ -564,11 +881,16 @@ static void lv_refr_area_part(const lv_area_t * area_p)
         top_act_scr = disp_refr->act_scr;
     }
     /*Do the refreshing from the top object*/
-    lv_refr_obj_and_children(top_act_scr, &start_mask);
+    lv_refr_obj_and_children(top_act_scr, &start_mask, layer_occ_p);
 
     /*Also refresh top and sys layer unconditionally*/
-    lv_refr_obj_and_children(lv_disp_get_layer_top(disp_refr), &start_mask);
-    lv_refr_obj_and_children(lv_disp_get_layer_sys(disp_refr), &start_mask);
+#if LV_REFR_OCCLUDER_MAX
+    layer_occ.cnt = sys_occ_cnt;
+#endif
+    lv_refr_obj_and_children(lv_disp_get_layer_top(disp_refr), &start_mask, layer_occ_p);
+    lv_refr_obj_and_children(lv_disp_get_layer_sys(disp_refr), &start_mask, NULL);
+
+    LV_PROF_END(LV_PROF_OBJ);
 
     /* In true double buffered mode flush only once when all areas were rendered.
      * In normal mode flush after every area */
@@ -623,8 +945,9 @@ static lv_obj_t * lv_refr_get_top_obj(const lv_area_t * area_p, lv_obj_t * obj)
  * Make the refreshing from an object. Draw all its children and the youngers too.
  * @param top_p pointer to an objects. Start the drawing from it.
  * @param mask_p pointer to an area, the objects will be drawn only here
+ * @param base_p opaque areas drawn after all of these objects (NULL: none)
  */
-static void lv_refr_obj_and_children(lv_obj_t * top_p, const lv_area_t * mask_p)
+static void lv_refr_obj_and_children(lv_obj_t * top_p, const lv_area_t * mask_p, const lv_refr_occ_t * base_p)
 {
     /* Normally always will be a top_obj (at least the screen)
      * but in special cases (e.g. if the screen has alpha) it won't.
@@ -632,8 +955,20 @@ static void lv_refr_obj_and_children(lv_obj_t * top_p, const lv_area_t * mask_p)
     if(top_p == NULL) top_p = lv_disp_get_scr_act(disp_refr);
     if(top_p == NULL) return;  /*Shouldn't happen*/
 
+    lv_refr_occ_t * occ_p = NULL;
+#if LV_REFR_OCCLUDER_MAX
+    lv_refr_occ_t occ;
+    if(occlusion_en) {
+        lv_refr_occ_inherit(&occ, base_p, mask_p);
+        lv_refr_occ_add_younger(&occ, top_p, mask_p);
+        occ_p = &occ;
+    }
+#else
+    LV_UNUSED(base_p);
+#endif
+
     /*Refresh the top object and its children*/
-    lv_refr_obj(top_p, mask_p);
+    lv_refr_obj_parts(top_p, mask_p, occ_p);
 
     /*Draw the 'younger' sibling objects because they can be on top_obj */
     lv_obj_t * par;
@@ -648,7 +983,10 @@ static void lv_refr_obj_and_children(lv_obj_t * top_p, const lv_area_t * mask_p)
 
         while(i != NULL) {
             /*Refresh the objects*/
-            lv_refr_obj(i, mask_p);
+#if LV_REFR_OCCLUDER_MAX
+            if(occ_p) lv_refr_occ_pop(occ_p, i);
+#endif
+            lv_refr_obj_parts(i, mask_p, occ_p);
             i = _lv_ll_get_prev(&(par->child_ll), i);
         }
 
@@ -663,12 +1001,42 @@ static void lv_refr_obj_and_children(lv_obj_t * top_p, const lv_area_t * mask_p)
     }
 }
 
+/**
+ * Refresh an object and its children only where the opaque areas drawn later leave it visible
+ * @param obj pointer to an object to refresh
+ * @param mask_p pointer to an area, the objects will be drawn only here
+ * @param occ_p opaque areas drawn later (NULL: draw in the whole mask)
+ */
+static void lv_refr_obj_parts(lv_obj_t * obj, const lv_area_t * mask_p, const lv_refr_occ_t * occ_p)
+{
+#if LV_REFR_OCCLUDER_MAX
+    if(occ_p && occ_p->cnt > 0 && obj->hidden == 0) {
+        lv_area_t parts[LV_REFR_SPLIT_MAX];
+        uint8_t part_cnt = lv_refr_get_visible_parts(mask_p, occ_p, parts);
+        if(part_cnt == 0) {
+            stat.cull_cnt++;
+            return;
+        }
+
+        stat.split_cnt += part_cnt - 1;
+        uint8_t p;
+        for(p = 0; p < part_cnt; p++) {
+            lv_refr_obj(obj, &parts[p], occ_p);
+        }
+        return;
+    }
+#endif
+
+    lv_refr_obj(obj, mask_p, occ_p);
+}
+
 /**
  * Refresh an object an all of its children. (Called recursively)
  * @param obj pointer to an object to refresh
  * @param mask_ori_p pointer to an area, the objects will be drawn only here
+ * @param occ_p opaque areas drawn after this object (NULL: none)
  */
-static void lv_refr_obj(lv_obj_t * obj, const lv_area_t * mask_ori_p)
+static void lv_refr_obj(lv_obj_t * obj, const lv_area_t * mask_ori_p, const lv_refr_occ_t * occ_p)
 {
     /*Do not refresh hidden objects*/
     if(obj->hidden != 0) return;
@@ -691,7 +1059,10 @@ static void lv_refr_obj(lv_obj_t * obj, const lv_area_t * mask_ori_p)
     if(union_ok != false) {
 
         /* Redraw the object */
-        if(obj->design_cb) obj->design_cb(obj, &obj_ext_mask, LV_DESIGN_DRAW_MAIN);
+        if(obj->design_cb) {
+            obj->design_cb(obj, &obj_ext_mask, LV_DESIGN_DRAW_MAIN);
+            stat.draw_cnt++;
+        }
 
 #if MASK_AREA_DEBUG
         static lv_color_t debug_color = LV_COLOR_RED;
@@ -717,7 +1088,28 @@ static void lv_refr_obj(lv_obj_t * obj, const lv_area_t * mask_ori_p)
             lv_area_t mask_child; /*Mask from obj and its child*/
             lv_obj_t * child_p;
             lv_area_t child_area;
+            lv_refr_occ_t * occ_child_p = NULL;
+#if LV_REFR_OCCLUDER_MAX
+            /*The younger children cover the older ones, as the objects drawn after this one do*/
+            lv_refr_occ_t occ_child;
+            if(occlusion_en && _lv_ll_get_head(&obj->child_ll) != NULL) {
+                lv_refr_occ_inherit(&occ_child, occ_p, &obj_mask);
+                if(occ_child.masked == 0 && obj->design_cb &&
+                   obj->design_cb(obj, &obj_mask, LV_DESIGN_COVER_CHK) == LV_DESIGN_RES_MASKED) {
+                    occ_child.masked = 1;
+                }
+                if(occ_child.masked == 0) {
+                    _LV_LL_READ(obj->child_ll, child_p) lv_refr_occ_add(&occ_child, child_p, &obj_mask);
+                }
+                occ_child_p = &occ_child;
+            }
+#else
+            LV_UNUSED(occ_p);
+#endif
             _LV_LL_READ_BACK(obj->child_ll, child_p) {
+#if LV_REFR_OCCLUDER_MAX
+                if(occ_child_p) lv_refr_occ_pop(occ_child_p, child_p);
+#endif
                 lv_obj_get_coords(child_p, &child_area);
                 ext_size = child_p->ext_draw_pad;
                 child_area.x1 -= ext_size;
@@ -731,7 +1123,7 @@ static void lv_refr_obj(lv_obj_t * obj, const lv_area_t * mask_ori_p)
                 /*If the parent and the child has common area then refresh the child */
                 if(union_ok) {
                     /*Refresh the next children*/
-                    lv_refr_obj(child_p, &mask_child);
+                    lv_refr_obj_parts(child_p, &mask_child, occ_child_p);
                 }
             }
         }
@@ -741,6 +1133,162 @@ static void lv_refr_obj(lv_obj_t * obj, const lv_area_t * mask_ori_p)
     }
 }
 
+#if LV_REFR_OCCLUDER_MAX
+/**
+ * Get the area where an object surely covers everything below it
+ * @param obj pointer to an object
+ * @param mask_p only this area is of interest
+ * @param res_p store the opaque area here
+ * @return true: `res_p` is valid; false: no opaque area is known
+ */
+static bool lv_refr_get_opaque_area(lv_obj_t * obj, const lv_area_t * mask_p, lv_area_t * res_p)
+{
+    if(obj->hidden != 0 || obj->design_cb == NULL) return false;
+    if(_lv_area_intersect(res_p, mask_p, &obj->coords) == false) return false;
+
+#if LV_USE_OPA_SCALE
+    if(lv_obj_get_style_opa_scale(obj, LV_OBJ_PART_MAIN) != LV_OPA_COVER) return false;
+#endif
+
+    lv_design_res_t design_res = obj->design_cb(obj, res_p, LV_DESIGN_COVER_CHK);
+    if(design_res == LV_DESIGN_RES_COVER) return true;
+    if(design_res != LV_DESIGN_RES_NOT_COVER) return false;
+
+    /*With rounded corners the columns between the corners can still be covered*/
+    lv_coord_t r = lv_obj_get_style_radius(obj, LV_OBJ_PART_MAIN);
+    lv_coord_t short_side = LV_MATH_MIN(lv_obj_get_width(obj), lv_obj_get_height(obj));
+    r = LV_MATH_MIN(r, short_side / 2);
+    if(r <= 0) return false;
+
+    lv_area_t mid;
+    lv_area_copy(&mid, &obj->coords);
+    mid.x1 += r + 1;
+    mid.x2 -= r + 1;
+    if(_lv_area_intersect(res_p, mask_p, &mid) == false) return false;
+    return obj->design_cb(obj, res_p, LV_DESIGN_COVER_CHK) == LV_DESIGN_RES_COVER;
+}
+
+/**
+ * Add the opaque area of an object to the occluders if there is room
+ * @param occ_p pointer to the occluders
+ * @param obj pointer to an object drawn after the ones already added
+ * @param mask_p only this area is of interest
+ */
+static void lv_refr_occ_add(lv_refr_occ_t * occ_p, lv_obj_t * obj, const lv_area_t * mask_p)
+{
+    if(occ_p->cnt >= LV_REFR_OCCLUDER_MAX) return;
+
+    if(lv_refr_get_opaque_area(obj, mask_p, &occ_p->area[occ_p->cnt])) {
+        occ_p->obj[occ_p->cnt] = obj;
+        occ_p->cnt++;
+    }
+}
+
+/**
+ * Add the 'younger' siblings of an object and of its parents to the occluders.
+ * They are drawn after the object: the parents' siblings last.
+ * @param occ_p pointer to the occluders
+ * @param border_p pointer to an object
+ * @param mask_p only this area is of interest
+ */
+static void lv_refr_occ_add_younger(lv_refr_occ_t * occ_p, lv_obj_t * border_p, const lv_area_t * mask_p)
+{
+    lv_obj_t * par = lv_obj_get_parent(border_p);
+    if(par == NULL) return;
+
+    lv_refr_occ_add_younger(occ_p, par, mask_p);
+
+    lv_obj_t * i = _lv_ll_get_head(&par->child_ll);
+    while(i != NULL && i != border_p) {
+        lv_refr_occ_add(occ_p, i, mask_p);
+        i = _lv_ll_get_next(&par->child_ll, i);
+    }
+}
+
+/**
+ * Start the occluders of an object's children from the ones of the object
+ * @param occ_p pointer to the occluders to initialize
+ * @param from_p occluders of the object (NULL: none)
+ * @param mask_p keep only the occluders on this area
+ */
+static void lv_refr_occ_inherit(lv_refr_occ_t * occ_p, const lv_refr_occ_t * from_p, const lv_area_t * mask_p)
+{
+    occ_p->cnt = 0;
+    occ_p->masked = 0;
+    if(from_p == NULL) return;
+
+    occ_p->masked = from_p->masked;
+    uint8_t i;
+    for(i = 0; i < from_p->cnt; i++) {
+        if(_lv_area_is_on(&from_p->area[i], mask_p)) {
+            lv_area_copy(&occ_p->area[occ_p->cnt], &from_p->area[i]);
+            occ_p->obj[occ_p->cnt] = from_p->obj[i];
+            occ_p->cnt++;
+        }
+    }
+}
+
+/**
+ * Remove an object from the occluders before drawing it
+ * @param occ_p pointer to the occluders
+ * @param obj pointer to the object to draw
+ */
+static void lv_refr_occ_pop(lv_refr_occ_t * occ_p, const lv_obj_t * obj)
+{
+    if(occ_p->cnt > 0 && occ_p->obj[occ_p->cnt - 1] == obj) occ_p->cnt--;
+}
+
+/**
+ * Subtract the occluders from an area
+ * @param mask_p pointer to an area
+ * @param occ_p pointer to the occluders
+ * @param parts store the visible parts here (`LV_REFR_SPLIT_MAX` areas)
+ * @return number of visible parts, 0 if the area is fully hidden
+ */
+static uint8_t lv_refr_get_visible_parts(const lv_area_t * mask_p, const lv_refr_occ_t * occ_p, lv_area_t * parts)
+{
+    lv_area_t res[LV_REFR_SPLIT_MAX];
+    uint8_t part_cnt = 1;
+    lv_area_copy(&parts[0], mask_p);
+
+    uint8_t o;
+    for(o = 0; o < occ_p->cnt && part_cnt > 0; o++) {
+        const lv_area_t * occ_a = &occ_p->area[o];
+        uint8_t res_cnt = 0;
+        uint8_t p;
+        for(p = 0; p < part_cnt; p++) {
+            const lv_area_t * a = &parts[p];
+            lv_area_t com;
+            if(_lv_area_intersect(&com, a, occ_a) == false) {
+                if(res_cnt == LV_REFR_SPLIT_MAX) break;
+                lv_area_copy(&res[res_cnt++], a);
+                continue;
+            }
+
+            /*Full width stripes above and below the occluder, the sides next to it*/
+            lv_area_t piece[4];
+            uint8_t piece_cnt = 0;
+            if(com.y1 > a->y1) lv_area_set(&piece[piece_cnt++], a->x1, a->y1, a->x2, com.y1 - 1);
+            if(com.y2 < a->y2) lv_area_set(&piece[piece_cnt++], a->x1, com.y2 + 1, a->x2, a->y2);
+            if(com.x1 > a->x1) lv_area_set(&piece[piece_cnt++], a->x1, com.y1, com.x1 - 1, com.y2);
+            if(com.x2 < a->x2) lv_area_set(&piece[piece_cnt++], com.x2 + 1, com.y1, a->x2, com.y2);
+
+            if(res_cnt + piece_cnt > LV_REFR_SPLIT_MAX) break;
+            _lv_memcpy(&res[res_cnt], piece, piece_cnt * sizeof(lv_area_t));
+            res_cnt += piece_cnt;
+        }
+
+        /*Too many parts: draw under this occluder too*/
+        if(p < part_cnt) continue;
+
+        _lv_memcpy(parts, res, res_cnt * sizeof(lv_area_t));
+        part_cnt = res_cnt;
+    }
+
+    return part_cnt;
+}
+#endif
+
 static void lv_refr_vdb_rotate_180(lv_disp_drv_t *drv, lv_area_t *area, lv_color_t *color_p) {
     lv_coord_t area_w = lv_area_get_width(area);
     lv_coord_t area_h = lv_area_get_height(area);
@@ -906,6 +1454,9 @@ static void lv_refr_vdb_flush(void)
     lv_disp_buf_t * vdb = lv_disp_get_buf(disp_refr);
     lv_color_t * color_p = vdb->buf_act;
 
+    LV_PROF_BEGIN(LV_PROF_FLUSH);
+    LV_PROF_PX(lv_area_get_size(&vdb->area));
+
     /*In double buffered mode wait until the other buffer is flushed before flushing the current
      * one*/
     if(lv_disp_is_double_buf(disp_refr)) {
@@ -914,7 +1465,9 @@ static void lv_refr_vdb_flush(void)
         }
     }
 
-    vdb->flushing = 1;
+    bool rotate = disp_refr->driver.rotated != LV_DISP_ROT_NONE && disp_refr->driver.sw_rotate;
+    if(vdb->ring_cnt && !rotate) vdb->ring_flushing[vdb->ring_act] = 1;
+    else vdb->flushing = 1;
 
     if(disp_refr->driver.buffer->last_area && disp_refr->driver.buffer->last_part) vdb->flushing_last = 1;
     else vdb->flushing_last = 0;
@@ -931,10 +1484,73 @@ static void lv_refr_vdb_flush(void)
             disp->driver.flush_cb(&disp->driver, &vdb->area, color_p);
         }
     }
-    if(vdb->buf1 && vdb->buf2) {
+    /*Draw the next band in the next buffer of the ring, it's waited for only before drawing*/
+    if(vdb->ring_cnt) {
+        vdb->ring_act = vdb->ring_act + 1 < vdb->ring_cnt ? vdb->ring_act + 1 : 0;
+        vdb->buf_act = vdb->ring[vdb->ring_act];
+    }
+    else if(vdb->buf1 && vdb->buf2) {
         if(vdb->buf_act == vdb->buf1)
             vdb->buf_act = vdb->buf2;
         else
             vdb->buf_act = vdb->buf1;
     }
+
+    LV_PROF_END(LV_PROF_FLUSH);
 }
+
+#if LV_USE_PROFILER_OVERLAY && LV_USE_LABEL
+/**
+ * Show the average time per frame of the phases on the system layer. Updated every second.
+ * @param refreshed true: the last refresh drew something
+ */
+static void lv_refr_prof_overlay(bool refreshed)
+{
+    static lv_obj_t * prof_label = NULL;
+    static lv_prof_frame_t sum;
+    static uint32_t frame_cnt = 0;
+    static uint32_t last_time = 0;
+
+    if(prof_label == NULL) {
+        prof_label = lv_label_create(lv_layer_sys(), NULL);
+        lv_obj_set_style_local_bg_opa(prof_label, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, LV_OPA_COVER);
+        lv_obj_set_style_local_bg_color(prof_label, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, LV_COLOR_BLACK);
+        lv_obj_set_style_local_text_color(prof_label, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, LV_COLOR_WHITE);
+        lv_obj_set_style_local_pad_top(prof_label, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, 3);
+        lv_obj_set_style_local_pad_bottom(prof_label, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, 3);
+        lv_obj_set_style_local_pad_left(prof_label, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, 3);
+        lv_obj_set_style_local_pad_right(prof_label, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, 3);
+        lv_label_set_text(prof_label, "?");
+        lv_obj_align(prof_label, NULL, LV_ALIGN_IN_TOP_LEFT, 0, 0);
+    }
+
+    uint32_t i;
+    if(refreshed) {
+        lv_prof_frame_t frame;
+        lv_prof_get_frame(&frame);
+        for(i = 0; i < _LV_PROF_NUM; i++) sum.phase[i].time_us += frame.phase[i].time_us;
+        sum.time_us += frame.time_us;
+        frame_cnt++;
+    }
+
+    if(lv_tick_elaps(last_time) < 1000 || frame_cnt == 0) return;
+    last_time = lv_tick_get();
+
+    /*One line per phase which took time: "rect 1.25" [ms per frame]*/
+    char buf[(_LV_PROF_NUM + 1) * 16];
+    uint32_t avg = sum.time_us / frame_cnt;
+    int len = lv_snprintf(buf, sizeof(buf), "frame %d.%02d", (int)(avg / 1000), (int)(avg % 1000) / 10);
+    for(i = 0; i < _LV_PROF_NUM && len < (int)sizeof(buf); i++) {
+        avg = sum.phase[i].time_us / frame_cnt;
+        if(avg < 10) continue;
+        len += lv_snprintf(buf + len, sizeof(buf) - len, "\n%s %d.%02d", lv_prof_get_phase_name(i),
+                           (int)(avg / 1000), (int)(avg % 1000) / 10);
+    }
+
+    _lv_memset_00(&sum, sizeof(sum));
+    frame_cnt = 0;
+
+    lv_label_set_text(prof_label, buf);
+    lv_obj_align(prof_label, NULL, LV_ALIGN_IN_TOP_LEFT, 0, 0);
+}
+#endif
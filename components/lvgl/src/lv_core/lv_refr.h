@@ -22,10 +22,32 @@ extern "C" {
 
 #define LV_REFR_TASK_PRIO LV_TASK_PRIO_MID
 
+/*Opaque objects remembered while drawing the ones below them: what they cover is not drawn.
+ *0: draw everything under the top object as before*/
+#ifndef LV_REFR_OCCLUDER_MAX
+#define LV_REFR_OCCLUDER_MAX 8
+#endif
+
+/*A partly covered object is drawn in at most this many visible parts, else in one piece*/
+#ifndef LV_REFR_SPLIT_MAX
+#define LV_REFR_SPLIT_MAX 4
+#endif
+
 /**********************
  *      TYPEDEFS
  **********************/
 
+/**
+ * Rendering counters since `lv_refr_reset_stat`
+ */
+typedef struct {
+    uint32_t px_cnt;        /**< Pixels of the refreshed areas*/
+    uint32_t blend_px_cnt;  /**< Pixels filled or copied by the blending functions, overdraw included*/
+    uint32_t draw_cnt;      /**< Objects (or visible parts of objects) drawn*/
+    uint32_t cull_cnt;      /**< Objects skipped because opaque objects above hide them*/
+    uint32_t split_cnt;     /**< Extra draws of partly covered objects drawn in parts*/
+} lv_refr_stat_t;
+
 /**********************
  *  STATIC PROTOTYPES
  **********************/
@@ -86,6 +108,35 @@ void _lv_refr_set_disp_refreshing(lv_disp_t * disp);
 uint32_t lv_refr_get_fps_avg(void);
 #endif
 
+/**
+ * Get the rendering counters
+ * @param stat pointer to a variable to copy the counters to
+ */
+void lv_refr_get_stat(lv_refr_stat_t * stat);
+
+/**
+ * Clear the rendering counters
+ */
+void lv_refr_reset_stat(void);
+
+/**
+ * Get the overdraw ratio since `lv_refr_reset_stat`
+ * @return blended pixels per refreshed pixel in percent (100: every pixel was blended once)
+ */
+uint32_t lv_refr_get_overdraw(void);
+
+/**
+ * Enable or disable skipping objects hidden by opaque objects above them
+ * @param en true: skip hidden objects and parts (default); false: draw every object under the top object
+ */
+void lv_refr_set_occlusion(bool en);
+
+/**
+ * Count pixels passed to the blending functions. Called by the draw functions.
+ * @param px number of pixels
+ */
+void _lv_refr_stat_blend(uint32_t px);
+
 /**
  * Called periodically to handle the refreshing
  * @param task pointer to the task itself
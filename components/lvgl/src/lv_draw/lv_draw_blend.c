@@ -25,6 +25,24 @@
  *********************/
 #define GPU_SIZE_LIMIT      240
 
+#if LV_DRAW_BLEND_WIDE && (LV_COLOR_DEPTH == 16 || LV_COLOR_DEPTH == 32)
+#define BLEND_WIDE 1
+#else
+#define BLEND_WIDE 0
+#endif
+
+#if BLEND_WIDE
+/*x / 255 on both half words, the same as LV_MATH_UDIV255 for x < 65535*/
+#define WIDE_DIV255(x)      ((((x) + 0x00010001 + (((x) >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF)
+#define WIDE_ROUND          (LV_COLOR_MIX_ROUND_OFS * 0x00010001)
+/*RGB565 of one or two pixels in a word from the buffer format and back*/
+#if LV_COLOR_16_SWAP
+#define WIDE_SWAP(w)        ((((w) >> 8) & 0x00FF00FF) | (((w) & 0x00FF00FF) << 8))
+#else
+#define WIDE_SWAP(w)        (w)
+#endif
+#endif
+
 /**********************
  *      TYPEDEFS
  **********************/
@@ -66,6 +84,14 @@ static inline lv_color_t color_blend_true_color_additive(lv_color_t fg, lv_color
 static inline lv_color_t color_blend_true_color_subtractive(lv_color_t fg, lv_color_t bg, lv_opa_t opa);
 #endif
 
+#if BLEND_WIDE
+LV_ATTRIBUTE_FAST_MEM static inline lv_color_t wide_mix(lv_color_t c1, lv_color_t c2, uint32_t mix);
+#if LV_COLOR_DEPTH == 16
+LV_ATTRIBUTE_FAST_MEM static void wide_fill_opa(lv_color_t * dest, int32_t len, lv_color_t color, lv_opa_t opa);
+#endif
+LV_ATTRIBUTE_FAST_MEM static void wide_map_opa(lv_color_t * dest, const lv_color_t * src, int32_t len, lv_opa_t opa);
+#endif
+
 /**********************
  *  STATIC VARIABLES
  **********************/
@@ -78,10 +104,16 @@ static inline lv_color_t color_blend_true_color_subtractive(lv_color_t fg, lv_co
  *      MACROS
  **********************/
 
+#if BLEND_WIDE
+#define BLEND_MIX(c1, c2, mix) wide_mix(c1, c2, mix)
+#else
+#define BLEND_MIX(c1, c2, mix) lv_color_mix(c1, c2, mix)
+#endif
+
 #define FILL_NORMAL_MASK_PX(out_x,  color)                                                          \
     if(*mask_tmp_x) {          \
         if(*mask_tmp_x == LV_OPA_COVER) disp_buf_first[out_x] = color;                                 \
-        else disp_buf_first[out_x] = lv_color_mix(color, disp_buf_first[out_x], *mask_tmp_x);            \
+        else disp_buf_first[out_x] = BLEND_MIX(color, disp_buf_first[out_x], *mask_tmp_x);               \
     }                                                                                               \
     mask_tmp_x++;
 
@@ -90,14 +122,14 @@ static inline lv_color_t color_blend_true_color_subtractive(lv_color_t fg, lv_co
         if(*mask_tmp_x == LV_OPA_COVER) disp_buf_first[out_x] = color;                                 \
         else if(disp->driver.screen_transp) lv_color_mix_with_alpha(disp_buf_first[out_x], disp_buf_first[out_x].ch.alpha,              \
                                                                         color, *mask_tmp_x, &disp_buf_first[out_x], &disp_buf_first[out_x].ch.alpha);           \
-        else disp_buf_first[out_x] = lv_color_mix(color, disp_buf_first[out_x], *mask_tmp_x);            \
+        else disp_buf_first[out_x] = BLEND_MIX(color, disp_buf_first[out_x], *mask_tmp_x);               \
     }                                                                                                      \
     mask_tmp_x++;
 
 #define MAP_NORMAL_MASK_PX(x)                                                          \
     if(*mask_tmp_x) {          \
         if(*mask_tmp_x == LV_OPA_COVER) disp_buf_first[x] = map_buf_first[x];                                 \
-        else disp_buf_first[x] = lv_color_mix(map_buf_first[x], disp_buf_first[x], *mask_tmp_x);            \
+        else disp_buf_first[x] = BLEND_MIX(map_buf_first[x], disp_buf_first[x], *mask_tmp_x);               \
     }                                                                                               \
     mask_tmp_x++;
 
@@ -106,7 +138,7 @@ static inline lv_color_t color_blend_true_color_subtractive(lv_color_t fg, lv_co
         if(*mask_tmp_x == LV_OPA_COVER) disp_buf_first[x] = map_buf_first[x];                                 \
         else if(disp->driver.screen_transp) lv_color_mix_with_alpha(disp_buf_first[x], disp_buf_first[x].ch.alpha,              \
                                                                         map_buf_first[x], *mask_tmp_x, &disp_buf_first[x], &disp_buf_first[x].ch.alpha);                  \
-        else disp_buf_first[x] = lv_color_mix(map_buf_first[x], disp_buf_first[x], *mask_tmp_x);            \
+        else disp_buf_first[x] = BLEND_MIX(map_buf_first[x], disp_buf_first[x], *mask_tmp_x);               \
     }                                                                                               \
     mask_tmp_x++;
 
@@ -149,6 +181,8 @@ LV_ATTRIBUTE_FAST_MEM void _lv_blend_fill(const lv_area_t * clip_area, const lv_
     is_common = _lv_area_intersect(&draw_area, clip_area, fill_area);
     if(!is_common) return;
 
+    _lv_refr_stat_blend(lv_area_get_size(&draw_area));
+
     /* Now `draw_area` has absolute coordinates.
      * Make it relative to `disp_area` to simplify draw to `disp_buf`*/
     draw_area.x1 -= disp_area->x1;
@@ -210,6 +244,8 @@ LV_ATTRIBUTE_FAST_MEM void _lv_blend_map(const lv_area_t * clip_area, const lv_a
     is_common = _lv_area_intersect(&draw_area, clip_area, map_area);
     if(!is_common) return;
 
+    _lv_refr_stat_blend(lv_area_get_size(&draw_area));
+
     lv_disp_t * disp = _lv_refr_get_disp_refreshing();
     lv_disp_buf_t * vdb = lv_disp_get_buf(disp);
     const lv_area_t * disp_area = &vdb->area;
@@ -405,6 +441,15 @@ LV_ATTRIBUTE_FAST_MEM static void fill_normal(const lv_area_t * disp_area, lv_co
                 return;
             }
 #endif
+#if BLEND_WIDE && LV_COLOR_DEPTH == 16
+            {
+                for(y = 0; y < draw_area_h; y++) {
+                    wide_fill_opa(disp_buf_first, draw_area_w, color, opa);
+                    disp_buf_first += disp_w;
+                }
+                return;
+            }
+#endif
             lv_color_t last_dest_color = LV_COLOR_BLACK;
             lv_color_t last_res_color = lv_color_mix(color, last_dest_color, opa);
 
@@ -533,7 +578,7 @@ LV_ATTRIBUTE_FAST_MEM static void fill_normal(const lv_area_t * disp_area, lv_co
 #endif
                             {
                                 if(opa_tmp == LV_OPA_COVER) last_res_color = color;
-                                else last_res_color = lv_color_mix(color, disp_buf_first[x], opa_tmp);
+                                else last_res_color = BLEND_MIX(color, disp_buf_first[x], opa_tmp);
                             }
                             last_mask = *mask_tmp_x;
                             last_dest_color.full = disp_buf_first[x].full;
@@ -843,6 +888,17 @@ LV_ATTRIBUTE_FAST_MEM static void map_normal(const lv_area_t * disp_area, lv_col
             /*Software rendering*/
 
             for(y = 0; y < draw_area_h; y++) {
+#if BLEND_WIDE
+#if LV_COLOR_SCREEN_TRANSP
+                if(disp->driver.screen_transp == 0)
+#endif
+                {
+                    wide_map_opa(disp_buf_first, map_buf_first, draw_area_w, opa);
+                    disp_buf_first += disp_w;
+                    map_buf_first += map_w;
+                    continue;
+                }
+#endif
                 for(x = 0; x < draw_area_w; x++) {
 #if LV_COLOR_SCREEN_TRANSP
                     if(disp->driver.screen_transp) {
@@ -938,7 +994,7 @@ LV_ATTRIBUTE_FAST_MEM static void map_normal(const lv_area_t * disp_area, lv_col
                         else
 #endif
                         {
-                            disp_buf_first[x] = lv_color_mix(map_buf_first[x], disp_buf_first[x], opa_tmp);
+                            disp_buf_first[x] = BLEND_MIX(map_buf_first[x], disp_buf_first[x], opa_tmp);
                         }
                     }
                 }
@@ -1101,3 +1157,98 @@ static inline lv_color_t color_blend_true_color_subtractive(lv_color_t fg, lv_co
     return lv_color_mix(fg, bg, opa);
 }
 #endif
+
+#if BLEND_WIDE
+/**
+ * Mix two colors like `lv_color_mix` but with red and blue in the two halves of one word
+ * @param c1 the first color
+ * @param c2 the second color
+ * @param mix the ratio of the colors. 0: full `c2`, 255: full `c1`
+ * @return the mixed color, the same as `lv_color_mix(c1, c2, mix)`
+ */
+LV_ATTRIBUTE_FAST_MEM static inline lv_color_t wide_mix(lv_color_t c1, lv_color_t c2, uint32_t mix)
+{
+    uint32_t mix_inv = 255 - mix;
+    lv_color_t ret;
+#if LV_COLOR_DEPTH == 32
+    uint32_t rb = (c1.full & 0x00FF00FF) * mix + (c2.full & 0x00FF00FF) * mix_inv + WIDE_ROUND;
+    uint32_t g = ((c1.full >> 8) & 0xFF) * mix + ((c2.full >> 8) & 0xFF) * mix_inv + LV_COLOR_MIX_ROUND_OFS;
+    ret.full = 0xFF000000 | WIDE_DIV255(rb) | (WIDE_DIV255(g) << 8);
+#else
+    uint32_t v1 = WIDE_SWAP((uint32_t)c1.full);
+    uint32_t v2 = WIDE_SWAP((uint32_t)c2.full);
+    uint32_t rb = (((v1 & 0xF800) << 5) | (v1 & 0x1F)) * mix + (((v2 & 0xF800) << 5) | (v2 & 0x1F)) * mix_inv + WIDE_ROUND;
+    uint32_t g = ((v1 >> 5) & 0x3F) * mix + ((v2 >> 5) & 0x3F) * mix_inv + LV_COLOR_MIX_ROUND_OFS;
+    rb = WIDE_DIV255(rb);
+    ret.full = (uint16_t)WIDE_SWAP((rb >> 5) | (WIDE_DIV255(g) << 5) | (rb & 0x1F));
+#endif
+    return ret;
+}
+
+#if LV_COLOR_DEPTH == 16
+/**
+ * Mix a color with the same opacity onto a line of 16 bit pixels.
+ * The pixels are mixed in pairs: a channel of both pixels in one word.
+ * 32 bit pixels stay on the cached premultiplied loop: it is faster on one color backgrounds.
+ * @param dest pointer to the first pixel
+ * @param len number of pixels
+ * @param color the color to mix
+ * @param opa opacity of the color
+ */
+LV_ATTRIBUTE_FAST_MEM static void wide_fill_opa(lv_color_t * dest, int32_t len, lv_color_t color, lv_opa_t opa)
+{
+    uint32_t opa_inv = 255 - opa;
+    uint32_t last_dest;
+    uint32_t last_res = 0;
+    int32_t x;
+    /*Backgrounds are often of one color: mix only when the destination changes*/
+    uint32_t c = WIDE_SWAP((uint32_t)color.full * 0x00010001);
+    uint32_t r_premult = ((c >> 11) & 0x001F001F) * opa + WIDE_ROUND;
+    uint32_t g_premult = ((c >> 5) & 0x003F003F) * opa + WIDE_ROUND;
+    uint32_t b_premult = (c & 0x001F001F) * opa + WIDE_ROUND;
+    last_dest = ~(dest[0].full | ((uint32_t)dest[len > 1 ? 1 : 0].full << 16));
+    for(x = 0; x < len - 1; x += 2) {
+        uint32_t d = dest[x].full | ((uint32_t)dest[x + 1].full << 16);
+        if(d != last_dest) {
+            last_dest = d;
+            d = WIDE_SWAP(d);
+            last_res = WIDE_SWAP((WIDE_DIV255(r_premult + ((d >> 11) & 0x001F001F) * opa_inv) << 11) |
+                                 (WIDE_DIV255(g_premult + ((d >> 5) & 0x003F003F) * opa_inv) << 5) |
+                                 WIDE_DIV255(b_premult + (d & 0x001F001F) * opa_inv));
+        }
+        dest[x].full = (uint16_t)last_res;
+        dest[x + 1].full = (uint16_t)(last_res >> 16);
+    }
+    if(x < len) dest[x] = wide_mix(color, dest[x], opa);
+}
+#endif
+
+/**
+ * Mix a line of an image with the same opacity onto a line of pixels.
+ * 16 bit pixels are mixed in pairs: a channel of both pixels in one word.
+ * @param dest pointer to the first pixel
+ * @param src pointer to the first pixel of the image
+ * @param len number of pixels
+ * @param opa opacity of the image
+ */
+LV_ATTRIBUTE_FAST_MEM static void wide_map_opa(lv_color_t * dest, const lv_color_t * src, int32_t len, lv_opa_t opa)
+{
+    int32_t x = 0;
+#if LV_COLOR_DEPTH == 16
+    uint32_t opa_inv = 255 - opa;
+    for(; x < len - 1; x += 2) {
+        uint32_t s = WIDE_SWAP(src[x].full | ((uint32_t)src[x + 1].full << 16));
+        uint32_t d = WIDE_SWAP(dest[x].full | ((uint32_t)dest[x + 1].full << 16));
+        uint32_t r = ((s >> 11) & 0x001F001F) * opa + ((d >> 11) & 0x001F001F) * opa_inv + WIDE_ROUND;
+        uint32_t g = ((s >> 5) & 0x003F003F) * opa + ((d >> 5) & 0x003F003F) * opa_inv + WIDE_ROUND;
+        uint32_t b = (s & 0x001F001F) * opa + (d & 0x001F001F) * opa_inv + WIDE_ROUND;
+        uint32_t res = WIDE_SWAP((WIDE_DIV255(r) << 11) | (WIDE_DIV255(g) << 5) | WIDE_DIV255(b));
+        dest[x].full = (uint16_t)res;
+        dest[x + 1].full = (uint16_t)(res >> 16);
+    }
+#endif
+    for(; x < len; x++) {
+        dest[x] = wide_mix(src[x], dest[x], opa);
+    }
+}
+#endif
@@ -20,6 +20,11 @@ extern "C" {
 /*********************
  *      DEFINES
  *********************/
+/*Mix the color channels of 16 and 32 bit pixels a word at a time instead of channel by channel.
+ *The result is the same as with `lv_color_mix`.*/
+#ifndef LV_DRAW_BLEND_WIDE
+#define LV_DRAW_BLEND_WIDE 1
+#endif
 
 /**********************
  *      TYPEDEFS
@@ -13,6 +13,7 @@
 #include "../lv_core/lv_refr.h"
 #include "../lv_misc/lv_mem.h"
 #include "../lv_misc/lv_math.h"
+#include "../lv_misc/lv_prof.h"
 #if LV_USE_GPU_STM32_DMA2D
     #include "../lv_gpu/lv_gpu_stm32_dma2d.h"
 #elif LV_USE_GPU_NXP_PXP
@@ -81,8 +82,10 @@ void lv_draw_img(const lv_area_t * coords, const lv_area_t * mask, const void *
 
     if(dsc->opa <= LV_OPA_MIN) return;
 
+    LV_PROF_BEGIN(LV_PROF_IMG);
     lv_res_t res;
     res = lv_img_draw_core(coords, mask, src, dsc);
+    LV_PROF_END(LV_PROF_IMG);
 
     if(res == LV_RES_INV) {
         LV_LOG_WARN("Image draw error");
@@ -12,6 +12,7 @@
 #include "../lv_core/lv_refr.h"
 #include "../lv_misc/lv_bidi.h"
 #include "../lv_misc/lv_debug.h"
+#include "../lv_misc/lv_prof.h"
 
 /*********************
  *      DEFINES
@@ -128,6 +129,8 @@ LV_ATTRIBUTE_FAST_MEM void lv_draw_label(const lv_area_t * coords, const lv_area
     bool clip_ok = _lv_area_intersect(&clipped_area, coords, mask);
     if(!clip_ok) return;
 
+    LV_PROF_BEGIN(LV_PROF_LABEL);
+
     if((dsc->flag & LV_TXT_FLAG_EXPAND) == 0) {
         /*Normally use the label's width as width*/
         w = lv_area_get_width(coords);
@@ -189,7 +192,10 @@ LV_ATTRIBUTE_FAST_MEM void lv_draw_label(const lv_area_t * coords, const lv_area
             hint->coord_y    = coords->y1;
         }
 
-        if(txt[line_start] == '\0') return;
+        if(txt[line_start] == '\0') {
+            LV_PROF_END(LV_PROF_LABEL);
+            return;
+        }
     }
 
     /*Align to middle*/
@@ -376,9 +382,10 @@ LV_ATTRIBUTE_FAST_MEM void lv_draw_label(const lv_area_t * coords, const lv_area
         /*Go the next line position*/
         pos.y += line_height;
 
-        if(pos.y > mask->y2) return;
+        if(pos.y > mask->y2) break;
     }
 
+    LV_PROF_END(LV_PROF_LABEL);
     LV_ASSERT_MEM_INTEGRITY();
 }
 
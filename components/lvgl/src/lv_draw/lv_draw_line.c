@@ -11,6 +11,7 @@
 #include "lv_draw_mask.h"
 #include "lv_draw_blend.h"
 #include "../lv_core/lv_refr.h"
+#include "../lv_misc/lv_prof.h"
 #include "../lv_misc/lv_math.h"
 
 /*********************
@@ -79,6 +80,8 @@ LV_ATTRIBUTE_FAST_MEM void lv_draw_line(const lv_point_t * point1, const lv_poin
     is_common = _lv_area_intersect(&clip_line, &clip_line, clip);
     if(!is_common) return;
 
+    LV_PROF_BEGIN(LV_PROF_LINE);
+
     if(point1->y == point2->y) draw_line_hor(point1, point2, &clip_line, dsc);
     else if(point1->x == point2->x) draw_line_ver(point1, point2, &clip_line, dsc);
     else draw_line_skew(point1, point2, &clip_line, dsc);
@@ -110,6 +113,8 @@ LV_ATTRIBUTE_FAST_MEM void lv_draw_line(const lv_point_t * point1, const lv_poin
             lv_draw_rect(&cir_area, clip, &cir_dsc);
         }
     }
+
+    LV_PROF_END(LV_PROF_LINE);
 }
 
 /**********************
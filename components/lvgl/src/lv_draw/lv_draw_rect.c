@@ -13,6 +13,7 @@
 #include "../lv_misc/lv_txt_ap.h"
 #include "../lv_core/lv_refr.h"
 #include "../lv_misc/lv_debug.h"
+#include "../lv_misc/lv_prof.h"
 
 /*********************
  *      DEFINES
@@ -103,6 +104,7 @@ LV_ATTRIBUTE_FAST_MEM void lv_draw_rect_dsc_init(lv_draw_rect_dsc_t * dsc)
 void lv_draw_rect(const lv_area_t * coords, const lv_area_t * clip, const lv_draw_rect_dsc_t * dsc)
 {
     if(lv_area_get_height(coords) < 1 || lv_area_get_width(coords) < 1) return;
+    LV_PROF_BEGIN(LV_PROF_RECT);
 #if LV_USE_SHADOW
     draw_shadow(coords, clip, dsc);
 #endif
@@ -122,6 +124,7 @@ void lv_draw_rect(const lv_area_t * coords, const lv_area_t * clip, const lv_dra
     draw_outline(coords, clip, dsc);
 #endif
 
+    LV_PROF_END(LV_PROF_RECT);
     LV_ASSERT_MEM_INTEGRITY();
 }
 
@@ -108,6 +108,33 @@ void lv_disp_buf_init(lv_disp_buf_t * disp_buf, void * buf1, void * buf2, uint32
     disp_buf->size    = size_in_px_cnt;
 }
 
+/**
+ * Initialize a display buffer with a ring of band buffers.
+ * A band is drawn in the next buffer while the previous ones are still being flushed,
+ * rendering waits only when the buffer it needs is not flushed yet.
+ * `flush_cb` has to send the bands in the order it gets them (e.g. queued DMA)
+ * and call `lv_disp_flush_ready()` once per band.
+ * @param disp_buf pointer `lv_disp_buf_t` variable to initialize
+ * @param bufs array of `buf_cnt` buffers of `size_in_px_cnt` pixels
+ * @param buf_cnt number of buffers, 1 .. `LV_DISP_BUF_RING_MAX`
+ * @param size_in_px_cnt size of every buffer in pixel count
+ */
+void lv_disp_buf_init_ring(lv_disp_buf_t * disp_buf, void * bufs[], uint8_t buf_cnt, uint32_t size_in_px_cnt)
+{
+    LV_ASSERT_NULL(bufs);
+    if(buf_cnt > LV_DISP_BUF_RING_MAX) {
+        LV_LOG_WARN("lv_disp_buf_init_ring: only LV_DISP_BUF_RING_MAX buffers are used");
+        buf_cnt = LV_DISP_BUF_RING_MAX;
+    }
+
+    /*Not double buffered for the rest of the library: `buf2` stays NULL*/
+    lv_disp_buf_init(disp_buf, bufs[0], NULL, size_in_px_cnt);
+
+    uint8_t i;
+    for(i = 0; i < buf_cnt; i++) disp_buf->ring[i] = bufs[i];
+    disp_buf->ring_cnt = buf_cnt;
+}
+
 /**
  * Register an initialized display driver.
  * Automatically set the first display as active.
@@ -139,6 +166,9 @@ lv_disp_t * lv_disp_drv_register(lv_disp_drv_t * driver)
     if(disp->refr_task == NULL) return NULL;
 
     disp->inv_p = 0;
+#if LV_INV_TILE_SIZE
+    disp->inv_tiled = 0;
+#endif
     disp->last_activity_time = 0;
 
     disp->bg_color = LV_COLOR_WHITE;
@@ -196,6 +226,9 @@ void lv_disp_drv_update(lv_disp_t * disp, lv_disp_drv_t * new_drv)
     _lv_memset_00(disp->inv_areas, sizeof(disp->inv_areas));
     _lv_memset_00(disp->inv_area_joined, sizeof(disp->inv_area_joined));
     disp->inv_p = 0;
+#if LV_INV_TILE_SIZE
+    disp->inv_tiled = 0;
+#endif
     if(disp->act_scr != NULL)
         lv_obj_invalidate(disp->act_scr);
 }
@@ -346,10 +379,26 @@ lv_disp_size_t lv_disp_get_size_category(lv_disp_t * disp)
  */
 LV_ATTRIBUTE_FLUSH_READY void lv_disp_flush_ready(lv_disp_drv_t * disp_drv)
 {
+    lv_disp_buf_t * vdb = disp_drv->buffer;
+
+    /*The bands of a ring are flushed in order: this one is the oldest still being flushed.
+     *Rotated flushes don't use the ring.*/
+    if(vdb->ring_cnt && vdb->ring_flushing[vdb->ring_tail]) {
+        uint8_t tail = vdb->ring_tail;
+#if LV_COLOR_SCREEN_TRANSP
+        if(disp_drv->screen_transp) {
+            _lv_memset_00(vdb->ring[tail], vdb->size * sizeof(lv_color32_t));
+        }
+#endif
+        vdb->ring_tail = tail + 1 < vdb->ring_cnt ? tail + 1 : 0;
+        vdb->ring_flushing[tail] = 0;
+        return;
+    }
+
     /*If the screen is transparent initialize it when the flushing is ready*/
 #if LV_COLOR_SCREEN_TRANSP
     if(disp_drv->screen_transp) {
-        _lv_memset_00(disp_drv->buffer->buf_act, disp_drv->buffer->size * sizeof(lv_color32_t));
+        _lv_memset_00(vdb->buf_act, vdb->size * sizeof(lv_color32_t));
     }
 #endif
 
@@ -406,6 +455,10 @@ uint16_t lv_disp_get_inv_buf_size(lv_disp_t * disp)
  */
 void _lv_disp_pop_from_inv_buf(lv_disp_t * disp, uint16_t num)
 {
+#if LV_INV_TILE_SIZE
+    /*The areas are merged in the tile map, keep them all*/
+    if(disp->inv_tiled) return;
+#endif
 
     if(disp->inv_p < num)
         disp->inv_p = 0;
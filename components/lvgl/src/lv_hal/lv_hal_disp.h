@@ -30,6 +30,20 @@ extern "C" {
 #define LV_INV_BUF_SIZE 32 /*Buffer size for invalid areas */
 #endif
 
+#ifndef LV_INV_TILE_SIZE
+#define LV_INV_TILE_SIZE 8 /*Tile size [px] of the dirty map used once the invalid area buffer is full (0: redraw the screen instead)*/
+#endif
+
+#if LV_INV_TILE_SIZE
+#define LV_INV_TILE_COLS ((LV_HOR_RES_MAX + LV_INV_TILE_SIZE - 1) / LV_INV_TILE_SIZE)
+#define LV_INV_TILE_ROWS ((LV_VER_RES_MAX + LV_INV_TILE_SIZE - 1) / LV_INV_TILE_SIZE)
+#define LV_INV_TILE_WORDS ((LV_INV_TILE_COLS + 31) / 32)
+#endif
+
+#ifndef LV_DISP_BUF_RING_MAX
+#define LV_DISP_BUF_RING_MAX 4 /*Max. number of band buffers given to `lv_disp_buf_init_ring()`*/
+#endif
+
 #ifndef LV_ATTRIBUTE_FLUSH_READY
 #define LV_ATTRIBUTE_FLUSH_READY
 #endif
@@ -58,6 +72,14 @@ typedef struct {
     volatile int flushing_last;
     volatile uint32_t last_area         : 1; /*1: the last area is being rendered*/
     volatile uint32_t last_part         : 1; /*1: the last part of the current area is being rendered*/
+
+    /*Band buffers set by `lv_disp_buf_init_ring()`, `ring_cnt` is 0 otherwise*/
+    void * ring[LV_DISP_BUF_RING_MAX];
+    uint8_t ring_cnt;
+    uint8_t ring_act;           /*Index of `buf_act`, changed only by the refresh*/
+    volatile uint8_t ring_tail; /*Index of the oldest buffer being flushed, changed only by `lv_disp_flush_ready()`*/
+    /*1: the buffer is being flushed. (One byte per buffer as they are cleared from IRQ)*/
+    volatile uint8_t ring_flushing[LV_DISP_BUF_RING_MAX];
 } lv_disp_buf_t;
 
 
@@ -181,6 +203,10 @@ uint8_t del_prev  :
     lv_area_t inv_areas[LV_INV_BUF_SIZE];
     uint8_t inv_area_joined[LV_INV_BUF_SIZE];
     uint32_t inv_p : 10;
+#if LV_INV_TILE_SIZE
+    uint32_t inv_tiled : 1;     /**< 1: `inv_areas` overflowed, every dirty area is in `inv_tiles`*/
+    uint32_t inv_tiles[LV_INV_TILE_ROWS][LV_INV_TILE_WORDS]; /**< Dirty map, a bit per tile, row by row*/
+#endif
 
     /*Miscellaneous data*/
     uint32_t last_activity_time; /**< Last time there was activity on this display */
@@ -222,6 +248,19 @@ void lv_disp_drv_init(lv_disp_drv_t * driver);
  */
 void lv_disp_buf_init(lv_disp_buf_t * disp_buf, void * buf1, void * buf2, uint32_t size_in_px_cnt);
 
+/**
+ * Initialize a display buffer with a ring of band buffers.
+ * A band is drawn in the next buffer while the previous ones are still being flushed,
+ * rendering waits only when the buffer it needs is not flushed yet.
+ * `flush_cb` has to send the bands in the order it gets them (e.g. queued DMA)
+ * and call `lv_disp_flush_ready()` once per band.
+ * @param disp_buf pointer `lv_disp_buf_t` variable to initialize
+ * @param bufs array of `buf_cnt` buffers of `size_in_px_cnt` pixels
+ * @param buf_cnt number of buffers, 1 .. `LV_DISP_BUF_RING_MAX`
+ * @param size_in_px_cnt size of every buffer in pixel count
+ */
+void lv_disp_buf_init_ring(lv_disp_buf_t * disp_buf, void * bufs[], uint8_t buf_cnt, uint32_t size_in_px_cnt);
+
 /**
  * Register an initialized display driver.
  * Automatically set the first display as active.
@@ -308,6 +347,7 @@ lv_disp_rot_t lv_disp_get_rotation(lv_disp_t * disp);
 
 /**
  * Call in the display driver's `flush_cb` function when the flushing is finished
+ * With a ring of buffers it releases the oldest band being flushed.
  * @param disp_drv pointer to display driver in `flush_cb` where this function is called
  */
 LV_ATTRIBUTE_FLUSH_READY void lv_disp_flush_ready(lv_disp_drv_t * disp_drv);
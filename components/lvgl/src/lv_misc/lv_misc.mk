@@ -15,6 +15,7 @@ CSRCS += lv_async.c
 CSRCS += lv_printf.c
 CSRCS += lv_bidi.c
 CSRCS += lv_debug.c
+CSRCS += lv_prof.c
 
 DEPPATH += --dep-path $(LVGL_DIR)/$(LVGL_DIR_NAME)/src/lv_misc
 VPATH += :$(LVGL_DIR)/$(LVGL_DIR_NAME)/src/lv_misc
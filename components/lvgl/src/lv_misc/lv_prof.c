@@ -0,0 +1,204 @@
+/**
+ * @file lv_prof.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "lv_prof.h"
+
+#if LV_USE_PROFILER
+
+#include "lv_mem.h"
+#include "lv_log.h"
+#ifdef LV_PROFILER_TIME_INCLUDE
+    #include LV_PROFILER_TIME_INCLUDE
+#endif
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void phase_switch(void);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static lv_prof_frame_t frame_act;   /*The refresh being measured*/
+static lv_prof_frame_t frame_last;
+static lv_prof_frame_t frame_sum;
+static uint32_t frame_sum_cnt;
+static lv_prof_frame_cb_t frame_cb;
+static lv_prof_phase_t stack[LV_PROF_DEPTH_MAX];
+static uint32_t depth;              /*0: not in a refresh. Can be more than `LV_PROF_DEPTH_MAX`.*/
+static uint32_t switch_time;        /*When the current phase was entered or resumed*/
+
+static const char * const phase_names[_LV_PROF_NUM] = {
+    "other", "join", "obj", "rect", "label", "img", "line", "mask", "flush"
+};
+
+/**********************
+ *      MACROS
+ **********************/
+#define STACK_TOP() stack[(depth < LV_PROF_DEPTH_MAX ? depth : LV_PROF_DEPTH_MAX) - 1]
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+/**
+ * Get the phases of the last refresh which drew something
+ * @param frame store the result here
+ */
+void lv_prof_get_frame(lv_prof_frame_t * frame)
+{
+    _lv_memcpy_small(frame, &frame_last, sizeof(lv_prof_frame_t));
+}
+
+/**
+ * Get the sum of the phases since `lv_prof_reset()`
+ * @param sum store the result here
+ * @return number of frames in the sum
+ */
+uint32_t lv_prof_get_sum(lv_prof_frame_t * sum)
+{
+    _lv_memcpy_small(sum, &frame_sum, sizeof(lv_prof_frame_t));
+    return frame_sum_cnt;
+}
+
+/**
+ * Clear the sum of `lv_prof_get_sum()`
+ */
+void lv_prof_reset(void)
+{
+    _lv_memset_00(&frame_sum, sizeof(frame_sum));
+    frame_sum_cnt = 0;
+}
+
+/**
+ * Set a function to call with the phases at the end of every refresh which drew something.
+ * E.g. to log them.
+ * @param cb the callback. NULL to remove it.
+ */
+void lv_prof_set_frame_cb(lv_prof_frame_cb_t cb)
+{
+    frame_cb = cb;
+}
+
+/**
+ * Get the short name of a phase
+ * @param phase a phase from `LV_PROF_...`
+ * @return its name, e.g. "rect"
+ */
+const char * lv_prof_get_phase_name(lv_prof_phase_t phase)
+{
+    if(phase >= _LV_PROF_NUM) return "?";
+    return phase_names[phase];
+}
+
+/**
+ * Start measuring a refresh. Called by the refresh task.
+ */
+void _lv_prof_frame_begin(void)
+{
+    _lv_memset_00(&frame_act, sizeof(frame_act));
+    stack[0] = LV_PROF_OTHER;
+    depth = 1;
+    frame_act.phase[LV_PROF_OTHER].call_cnt = 1;
+    switch_time = LV_PROFILER_TIME_EXPR;
+}
+
+/**
+ * Finish measuring a refresh. Called by the refresh task.
+ * @param keep true: the refresh drew something, publish its phases; false: drop them
+ */
+void _lv_prof_frame_end(bool keep)
+{
+    if(depth == 0) return;
+
+    phase_switch();
+    depth = 0;
+    if(!keep) return;
+
+    uint32_t i;
+    for(i = 0; i < _LV_PROF_NUM; i++) {
+        frame_act.time_us += frame_act.phase[i].time_us;
+        frame_sum.phase[i].time_us += frame_act.phase[i].time_us;
+        frame_sum.phase[i].call_cnt += frame_act.phase[i].call_cnt;
+        frame_sum.phase[i].px_cnt += frame_act.phase[i].px_cnt;
+    }
+    frame_sum.time_us += frame_act.time_us;
+    frame_sum_cnt++;
+
+    _lv_memcpy_small(&frame_last, &frame_act, sizeof(lv_prof_frame_t));
+    if(frame_cb) frame_cb(&frame_last);
+}
+
+/**
+ * Enter a phase. Outside of a refresh (e.g. drawing on a canvas) nothing is measured.
+ * @param phase the phase
+ */
+void _lv_prof_begin(lv_prof_phase_t phase)
+{
+    if(depth == 0) return;
+
+    if(depth < LV_PROF_DEPTH_MAX) {
+        phase_switch();
+        stack[depth] = phase;
+        frame_act.phase[phase].call_cnt++;
+    }
+    depth++;
+}
+
+/**
+ * Leave the phase entered last
+ * @param phase the phase, to check the pairs
+ */
+void _lv_prof_end(lv_prof_phase_t phase)
+{
+    /*The frame's base phase is left only by `_lv_prof_frame_end`*/
+    if(depth <= 1) return;
+
+    if(depth <= LV_PROF_DEPTH_MAX) {
+        if(STACK_TOP() != phase) {
+            LV_LOG_WARN("_lv_prof_end: not the phase entered last");
+        }
+        phase_switch();
+    }
+    depth--;
+}
+
+/**
+ * Count pixels in the current phase
+ * @param px number of pixels
+ */
+void _lv_prof_px(uint32_t px)
+{
+    if(depth == 0) return;
+
+    frame_act.phase[STACK_TOP()].px_cnt += px;
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/**
+ * Add the time since the last switch to the current phase
+ */
+static void phase_switch(void)
+{
+    uint32_t now = LV_PROFILER_TIME_EXPR;
+    frame_act.phase[STACK_TOP()].time_us += now - switch_time;
+    switch_time = now;
+}
+
+#endif /*LV_USE_PROFILER*/
@@ -0,0 +1,184 @@
+/**
+ * @file lv_prof.h
+ * Per frame timing of the rendering phases
+ */
+
+#ifndef LV_PROF_H
+#define LV_PROF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "../lv_conf_internal.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/*Time the phases of each refresh and count their calls and pixels.
+ *0: the hooks in `lv_refr.c` and `lv_draw_*.c` compile to nothing*/
+#ifndef LV_USE_PROFILER
+#  ifdef CONFIG_LV_USE_PROFILER
+#    define LV_USE_PROFILER CONFIG_LV_USE_PROFILER
+#  else
+#    define LV_USE_PROFILER 0
+#  endif
+#endif
+
+#if LV_USE_PROFILER
+/*Show the average ms per frame of the phases in the top left corner*/
+#ifndef LV_USE_PROFILER_OVERLAY
+#  ifdef CONFIG_LV_USE_PROFILER_OVERLAY
+#    define LV_USE_PROFILER_OVERLAY CONFIG_LV_USE_PROFILER_OVERLAY
+#  else
+#    define LV_USE_PROFILER_OVERLAY 0
+#  endif
+#endif
+
+/*A free running [us] counter. It is read at every phase change, so it should be cheap.*/
+#ifndef LV_PROFILER_TIME_EXPR
+#  ifdef ESP_PLATFORM
+#    define LV_PROFILER_TIME_INCLUDE "esp_timer.h"
+#    define LV_PROFILER_TIME_EXPR ((uint32_t)esp_timer_get_time())
+#  else
+#    error "LV_USE_PROFILER needs a microsecond counter in LV_PROFILER_TIME_EXPR"
+#  endif
+#endif
+
+/*Nesting depth of the phases. Deeper phases are counted in their parent.*/
+#define LV_PROF_DEPTH_MAX 8
+#else
+#define LV_USE_PROFILER_OVERLAY 0
+#endif
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/*Phases of a refresh. Nested phases are excluded from the time of their parent.*/
+enum {
+    LV_PROF_OTHER,  /**< In the refresh task but in no other phase (e.g. copying between the buffers)*/
+    LV_PROF_JOIN,   /**< Joining the invalid areas*/
+    LV_PROF_OBJ,    /**< Finding and walking the objects of a buffer part and their design functions*/
+    LV_PROF_RECT,   /**< `lv_draw_rect`*/
+    LV_PROF_LABEL,  /**< `lv_draw_label`*/
+    LV_PROF_IMG,    /**< `lv_draw_img`*/
+    LV_PROF_LINE,   /**< `lv_draw_line`*/
+    LV_PROF_MASK,   /**< `lv_draw_mask_apply`*/
+    LV_PROF_FLUSH,  /**< Waiting for the display and calling `flush_cb`*/
+    _LV_PROF_NUM
+};
+typedef uint8_t lv_prof_phase_t;
+
+typedef struct {
+    uint32_t time_us;   /**< Time spent in the phase, nested phases excluded*/
+    uint32_t call_cnt;  /**< Times the phase was entered*/
+    uint32_t px_cnt;    /**< Pixels blended by the phase; masked by MASK, flushed by FLUSH*/
+} lv_prof_phase_stat_t;
+
+typedef struct {
+    lv_prof_phase_stat_t phase[_LV_PROF_NUM];
+    uint32_t time_us;   /**< The whole refresh: the sum of the phases*/
+} lv_prof_frame_t;
+
+typedef void (*lv_prof_frame_cb_t)(const lv_prof_frame_t * frame);
+
+#if LV_USE_PROFILER
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/**
+ * Get the phases of the last refresh which drew something
+ * @param frame store the result here
+ */
+void lv_prof_get_frame(lv_prof_frame_t * frame);
+
+/**
+ * Get the sum of the phases since `lv_prof_reset()`
+ * @param sum store the result here
+ * @return number of frames in the sum
+ */
+uint32_t lv_prof_get_sum(lv_prof_frame_t * sum);
+
+/**
+ * Clear the sum of `lv_prof_get_sum()`
+ */
+void lv_prof_reset(void);
+
+/**
+ * Set a function to call with the phases at the end of every refresh which drew something.
+ * E.g. to log them.
+ * @param cb the callback. NULL to remove it.
+ */
+void lv_prof_set_frame_cb(lv_prof_frame_cb_t cb);
+
+/**
+ * Get the short name of a phase
+ * @param phase a phase from `LV_PROF_...`
+ * @return its name, e.g. "rect"
+ */
+const char * lv_prof_get_phase_name(lv_prof_phase_t phase);
+
+/**
+ * Start measuring a refresh. Called by the refresh task.
+ */
+void _lv_prof_frame_begin(void);
+
+/**
+ * Finish measuring a refresh. Called by the refresh task.
+ * @param keep true: the refresh drew something, publish its phases; false: drop them
+ */
+void _lv_prof_frame_end(bool keep);
+
+/**
+ * Enter a phase. Outside of a refresh (e.g. drawing on a canvas) nothing is measured.
+ * @param phase the phase
+ */
+void _lv_prof_begin(lv_prof_phase_t phase);
+
+/**
+ * Leave the phase entered last
+ * @param phase the phase, to check the pairs
+ */
+void _lv_prof_end(lv_prof_phase_t phase);
+
+/**
+ * Count pixels in the current phase
+ * @param px number of pixels
+ */
+void _lv_prof_px(uint32_t px);
+
+/**********************
+ *      MACROS
+ **********************/
+
+#define LV_PROF_BEGIN(phase)    _lv_prof_begin(phase)
+#define LV_PROF_END(phase)      _lv_prof_end(phase)
+#define LV_PROF_PX(px)          _lv_prof_px(px)
+#define LV_PROF_FRAME_BEGIN()   _lv_prof_frame_begin()
+#define LV_PROF_FRAME_END(keep) _lv_prof_frame_end(keep)
+
+#else /*LV_USE_PROFILER*/
+
+/*Do nothing if `LV_USE_PROFILER 0`*/
+#define LV_PROF_BEGIN(phase)
+#define LV_PROF_END(phase)
+#define LV_PROF_PX(px)
+#define LV_PROF_FRAME_BEGIN()
+#define LV_PROF_FRAME_END(keep)
+
+#endif /*LV_USE_PROFILER*/
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*LV_PROF_H*/
@@ -37,6 +37,10 @@ static lv_coord_t get_row_height(lv_obj_t * table, uint16_t row_id, const lv_fon
                                  lv_style_int_t * letter_space, lv_style_int_t * line_space,
                                  lv_style_int_t * cell_left, lv_style_int_t * cell_right, lv_style_int_t * cell_top, lv_style_int_t * cell_bottom);
 static void refr_size(lv_obj_t * table);
+static void refr_cell(lv_obj_t * table, uint16_t row, uint16_t col);
+static void get_cell_style(lv_obj_t * table, const lv_font_t ** font, lv_style_int_t * letter_space,
+                           lv_style_int_t * line_space, lv_style_int_t * cell_left, lv_style_int_t * cell_right,
+                           lv_style_int_t * cell_top, lv_style_int_t * cell_bottom);
 
 /**********************
  *  STATIC VARIABLES
@@ -188,7 +192,7 @@ void lv_table_set_cell_value(lv_obj_t * table, uint16_t row, uint16_t col, const
 #endif
 
     ext->cell_data[cell][0] = format.format_byte;
-    refr_size(table);
+    refr_cell(table, row, col);
 }
 
 /**
@@ -283,7 +287,7 @@ void lv_table_set_cell_value_fmt(lv_obj_t * table, uint16_t row, uint16_t col, c
     va_end(ap2);
 
     ext->cell_data[cell][0] = format.format_byte;
-    refr_size(table);
+    refr_cell(table, row, col);
 }
 
 /**
@@ -1102,16 +1106,7 @@ static void refr_size(lv_obj_t * table)
     lv_style_int_t line_space[LV_TABLE_CELL_STYLE_CNT];
     const lv_font_t * font[LV_TABLE_CELL_STYLE_CNT];
 
-    for(i = 0; i < LV_TABLE_CELL_STYLE_CNT; i++) {
-        if((ext->cell_types & (1 << i)) == 0) continue; /*Skip unused cell types*/
-        cell_left[i] = lv_obj_get_style_pad_left(table, LV_TABLE_PART_CELL1 + i);
-        cell_right[i] = lv_obj_get_style_pad_right(table, LV_TABLE_PART_CELL1 + i);
-        cell_top[i] = lv_obj_get_style_pad_top(table, LV_TABLE_PART_CELL1 + i);
-        cell_bottom[i] = lv_obj_get_style_pad_bottom(table, LV_TABLE_PART_CELL1 + i);
-        letter_space[i] = lv_obj_get_style_text_letter_space(table, LV_TABLE_PART_CELL1 + i);
-        line_space[i] = lv_obj_get_style_text_line_space(table, LV_TABLE_PART_CELL1 + i);
-        font[i] = lv_obj_get_style_text_font(table, LV_TABLE_PART_CELL1 + i);
-    }
+    get_cell_style(table, font, letter_space, line_space, cell_left, cell_right, cell_top, cell_bottom);
 
     for(i = 0; i < ext->row_cnt; i++) {
         ext->row_h[i] = get_row_height(table, i, font, letter_space, line_space,
@@ -1130,6 +1125,103 @@ static void refr_size(lv_obj_t * table)
     lv_obj_invalidate(table); /*Always invalidate even if the size hasn't changed*/
 }
 
+/**
+ * Refresh the table after the text of one cell has changed.
+ * If the height of its row is the same only the cell is invalidated (the whole row if it is merged),
+ * else the size of the table is refreshed as by `refr_size`.
+ * @param table pointer to a Table object
+ * @param row id of the row
+ * @param col id of the column
+ */
+static void refr_cell(lv_obj_t * table, uint16_t row, uint16_t col)
+{
+    lv_table_ext_t * ext = lv_obj_get_ext_attr(table);
+
+    lv_style_int_t cell_left[LV_TABLE_CELL_STYLE_CNT];
+    lv_style_int_t cell_right[LV_TABLE_CELL_STYLE_CNT];
+    lv_style_int_t cell_top[LV_TABLE_CELL_STYLE_CNT];
+    lv_style_int_t cell_bottom[LV_TABLE_CELL_STYLE_CNT];
+    lv_style_int_t letter_space[LV_TABLE_CELL_STYLE_CNT];
+    lv_style_int_t line_space[LV_TABLE_CELL_STYLE_CNT];
+    const lv_font_t * font[LV_TABLE_CELL_STYLE_CNT];
+
+    get_cell_style(table, font, letter_space, line_space, cell_left, cell_right, cell_top, cell_bottom);
+
+    lv_coord_t h_row = get_row_height(table, row, font, letter_space, line_space,
+                                      cell_left, cell_right, cell_top, cell_bottom);
+    if(h_row != ext->row_h[row]) {
+        refr_size(table);
+        return;
+    }
+
+    lv_style_int_t bg_top = lv_obj_get_style_pad_top(table, LV_TABLE_PART_BG);
+    lv_style_int_t bg_left = lv_obj_get_style_pad_left(table, LV_TABLE_PART_BG);
+
+    lv_area_t cell_area;
+    uint16_t i;
+    cell_area.y1 = table->coords.y1 + bg_top;
+    for(i = 0; i < row; i++) {
+        cell_area.y1 += ext->row_h[i];
+    }
+    cell_area.y2 = cell_area.y1 + h_row - 1;
+
+    /*The text of merged cells can span the row, with RTL the columns are mirrored*/
+    uint32_t cell = row * ext->col_cnt + col;
+    bool merged = false;
+    lv_table_cell_format_t format;
+    if(ext->cell_data[cell]) {
+        format.format_byte = ext->cell_data[cell][0];
+        if(format.s.right_merge) merged = true;
+    }
+    if(col > 0 && ext->cell_data[cell - 1]) {
+        format.format_byte = ext->cell_data[cell - 1][0];
+        if(format.s.right_merge) merged = true;
+    }
+
+    if(merged || lv_obj_get_base_dir(table) == LV_BIDI_DIR_RTL) {
+        cell_area.x1 = table->coords.x1;
+        cell_area.x2 = table->coords.x2;
+    }
+    else {
+        cell_area.x1 = table->coords.x1 + bg_left;
+        for(i = 0; i < col; i++) {
+            cell_area.x1 += ext->col_w[i];
+        }
+        cell_area.x2 = cell_area.x1 + ext->col_w[col] - 1;
+    }
+
+    lv_obj_invalidate_area(table, &cell_area);
+}
+
+/**
+ * Get the style properties of the cell types in use
+ * @param table pointer to a Table object
+ * @param font arrays of `LV_TABLE_CELL_STYLE_CNT` elements to fill, as the others
+ * @param letter_space
+ * @param line_space
+ * @param cell_left
+ * @param cell_right
+ * @param cell_top
+ * @param cell_bottom
+ */
+static void get_cell_style(lv_obj_t * table, const lv_font_t ** font, lv_style_int_t * letter_space,
+                           lv_style_int_t * line_space, lv_style_int_t * cell_left, lv_style_int_t * cell_right,
+                           lv_style_int_t * cell_top, lv_style_int_t * cell_bottom)
+{
+    lv_table_ext_t * ext = lv_obj_get_ext_attr(table);
+    uint16_t i;
+    for(i = 0; i < LV_TABLE_CELL_STYLE_CNT; i++) {
+        if((ext->cell_types & (1 << i)) == 0) continue; /*Skip unused cell types*/
+        cell_left[i] = lv_obj_get_style_pad_left(table, LV_TABLE_PART_CELL1 + i);
+        cell_right[i] = lv_obj_get_style_pad_right(table, LV_TABLE_PART_CELL1 + i);
+        cell_top[i] = lv_obj_get_style_pad_top(table, LV_TABLE_PART_CELL1 + i);
+        cell_bottom[i] = lv_obj_get_style_pad_bottom(table, LV_TABLE_PART_CELL1 + i);
+        letter_space[i] = lv_obj_get_style_text_letter_space(table, LV_TABLE_PART_CELL1 + i);
+        line_space[i] = lv_obj_get_style_text_line_space(table, LV_TABLE_PART_CELL1 + i);
+        font[i] = lv_obj_get_style_text_font(table, LV_TABLE_PART_CELL1 + i);
+    }
+}
+
 static lv_coord_t get_row_height(lv_obj_t * table, uint16_t row_id, const lv_font_t ** font,
                                  lv_style_int_t * letter_space, lv_style_int_t * line_space,
                                  lv_style_int_t * cell_left, lv_style_int_t * cell_right, lv_style_int_t * cell_top, lv_style_int_t * cell_bottom)
@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+
+# Headless benchmark: the lv_demo_benchmark scenes and lv_demo_stress (lv_bench_main.c)
+# built in the color formats of build.py at the 320x240 of the device.
+# Frames are deterministic, so the drawn pixels and draw calls only change with the code;
+# ms/frame is measured on the host.
+#
+# Usage: ./bench.py [--prof | --bands] [baseline.json]
+# The results are written to bench.json. With a baseline, every change is listed. Scenes drawing
+# more or using more memory, and configurations slower in sum by more than `tolerance_pct`,
+# are regressions: the exit code is 1. Single scenes are too short to fail on their time.
+# --prof builds with LV_USE_PROFILER and lists the us per frame of the phases (lv_prof.h) per scene.
+# The profiler slows the rendering, so these results are not compared with a baseline.
+# --bands measures the rgb565_swap build with 1 .. `band_bufs` band buffers (a ring if more than 1)
+# and a flush sending `flush_ns_px` per pixel in the background (the SPI of the device, scaled to the host),
+# and lists ms/frame per buffer count. These results are not compared with a baseline.
+
+import json
+import os
+import subprocess
+import sys
+
+import build
+
+frames = 30
+runs = 5                # ms/frame is the best of the runs
+tolerance_pct = 20
+tolerance_ms = 0.05     # Frames faster than this are not compared
+counters = ["refr_px", "blend_px", "draw_cnt", "mem_peak"]
+band_bufs = 4           # LV_DISP_BUF_RING_MAX
+flush_ns_px = 40        # 400 ns for 16 bit pixels on a 40 MHz SPI, divided as the host draws ~10x faster than the device
+
+bench_common = build.all_obj_all_features.copy()
+bench_common.update({"LV_HOR_RES_MAX":320, "LV_VER_RES_MAX":240, "LV_MEM_SIZE":128*1024})
+
+def config(**defines):
+  c = bench_common.copy()
+  c.update(defines)
+  return c
+
+configs = {
+  "argb8888":           config(LV_COLOR_DEPTH=32),
+  "rgb565":             config(LV_COLOR_DEPTH=16, LV_COLOR_SCREEN_TRANSP=0),
+  "rgb565_swap":        config(LV_COLOR_DEPTH=16, LV_COLOR_16_SWAP=1, LV_COLOR_SCREEN_TRANSP=0),
+  "rgb565_swap_no_aa":  config(LV_COLOR_DEPTH=16, LV_COLOR_16_SWAP=1, LV_COLOR_SCREEN_TRANSP=0, LV_ANTIALIAS=0),
+  "rgb332":             config(LV_COLOR_DEPTH=8, LV_COLOR_SCREEN_TRANSP=0),
+}
+
+prof = "--prof" in sys.argv
+bands = "--bands" in sys.argv
+args = [a for a in sys.argv[1:] if a not in ["--prof", "--bands"]]
+
+def bench_build(name, defines):
+  print("=============================")
+  print(name)
+  print("=============================")
+
+  os.system("make clean LVGL_DIR_NAME=" + build.lvgldirname + " > /dev/null")
+  os.system("rm -f ./bench.bin")
+  cmd = "make -j8 bench BENCH_BIN=bench.bin LVGL_DIR_NAME=" + build.lvgldirname + " DEFINES=" + build.defines_arg(defines) + " OPTIMIZATION=" + build.optimization
+  ret = os.system(cmd + " > /dev/null")
+  if(ret != 0):
+    print("BUILD ERROR! (error code " + str(ret) + ")")
+    exit(1)
+
+def bench_run(*bench_args):
+  scenes = {}
+  for r in range(runs):
+    out = subprocess.run(["./bench.bin", str(frames)] + [str(a) for a in bench_args], stdout=subprocess.PIPE, universal_newlines=True)
+    if(out.returncode != 0):
+      print("RUN ERROR! (error code " + str(out.returncode) + ")")
+      exit(1)
+
+    for line in out.stdout.splitlines():
+      if line.startswith("{"):
+        s = json.loads(line)
+        scene = s["scene"] + (" + opa" if s["opa"] else "")
+        if scene in scenes:
+          s["ms_per_frame"] = min(s["ms_per_frame"], scenes[scene]["ms_per_frame"])
+        scenes[scene] = s
+  return scenes
+
+def bench(name, defines):
+  bench_build(name, defines)
+  scenes = bench_run()
+
+  print("%-32s %9s %10s %10s %8s %8s" % ("scene", "ms/frame", "refr px", "blend px", "draws", "mem"))
+  for scene in scenes:
+    s = scenes[scene]
+    print("%-32s %9.3f %10d %10d %8d %8d" % (scene, s["ms_per_frame"], s["refr_px"], s["blend_px"], s["draw_cnt"], s["mem_peak"]))
+  print("%-32s %9.3f" % ("sum", sum(s["ms_per_frame"] for s in scenes.values())))
+
+  if prof:
+    phases = list(next(iter(scenes.values()))["prof_us"])
+    print("")
+    print("%-32s" % "us/frame" + "".join("%8s" % p for p in phases))
+    for scene in scenes:
+      print("%-32s" % scene + "".join("%8.1f" % scenes[scene]["prof_us"][p] for p in phases))
+  return scenes
+
+def bench_bands(name, defines):
+  bench_build(name + ", " + str(flush_ns_px) + " ns/px flush", defines)
+  results = {}
+  for b in range(1, band_bufs + 1):
+    results[name + "_bufs" + str(b)] = bench_run(b, flush_ns_px)
+
+  cols = list(results)
+  print("%-32s" % "ms/frame" + "".join("%9s" % ("bufs=" + c[-1]) for c in cols))
+  for scene in results[cols[0]]:
+    print("%-32s" % scene + "".join("%9.3f" % results[c][scene]["ms_per_frame"] for c in cols))
+  print("%-32s" % "sum" + "".join("%9.3f" % sum(s["ms_per_frame"] for s in results[c].values()) for c in cols))
+  return results
+
+def compare(results, baseline):
+  regressions = 0
+  for name in results:
+    for scene in results[name]:
+      if name not in baseline or scene not in baseline[name]:
+        continue
+      new = results[name][scene]
+      old = baseline[name][scene]
+      for c in counters:
+        if new[c] != old[c]:
+          worse = new[c] > old[c]
+          regressions += worse
+          print("%s %s, %s: %s: %d -> %d" % ("REGRESSION" if worse else "improved", name, scene, c, old[c], new[c]))
+
+      ms_new = new["ms_per_frame"]
+      ms_old = old["ms_per_frame"]
+      if max(ms_new, ms_old) < tolerance_ms:
+        continue
+      if ms_new > ms_old * (100 + tolerance_pct) / 100:
+        print("slower %s, %s: ms/frame: %.3f -> %.3f" % (name, scene, ms_old, ms_new))
+      elif ms_new < ms_old * (100 - tolerance_pct) / 100:
+        print("faster %s, %s: ms/frame: %.3f -> %.3f" % (name, scene, ms_old, ms_new))
+
+    common = [scene for scene in results[name] if scene in baseline.get(name, {})]
+    ms_new = sum(results[name][scene]["ms_per_frame"] for scene in common)
+    ms_old = sum(baseline[name][scene]["ms_per_frame"] for scene in common)
+    if ms_new > ms_old * (100 + tolerance_pct) / 100:
+      regressions += 1
+      print("REGRESSION %s: sum of ms/frame: %.3f -> %.3f" % (name, ms_old, ms_new))
+    else:
+      print("%s: sum of ms/frame: %.3f -> %.3f" % (name, ms_old, ms_new))
+  return regressions
+
+results = {}
+if bands:
+  results = bench_bands("rgb565_swap", configs["rgb565_swap"])
+else:
+  for name in configs:
+    defines = configs[name].copy()
+    if prof:
+      defines["LV_USE_PROFILER"] = 1
+    results[name] = bench(name, defines)
+
+with open("bench.json", "w") as f:
+  json.dump(results, f, indent=1)
+
+if len(args) > 0 and not prof and not bands:
+  with open(args[0]) as f:
+    baseline = json.load(f)
+  regressions = compare(results, baseline)
+  print("---------------------------")
+  print(str(regressions) + " regressions")
+  if regressions:
+    exit(1)
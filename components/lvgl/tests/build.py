@@ -9,6 +9,15 @@ lvgldirname = '"' + lvgldirname + '"'
 base_defines = '"-DLV_CONF_PATH=' + lvgldirname +'/tests/lv_test_conf.h -DLV_BUILD_TEST"'
 optimization = '"-O3 -g0"'
 
+def defines_arg(defines):
+  d_all = base_defines[:-1] + " ";
+
+  for d in defines:
+    d_all += " -D" + d + "=" + str(defines[d])
+
+  d_all += '"'
+  return d_all
+
 def build(name, defines):
   global base_defines, optimization
 
@@ -16,13 +25,7 @@ def build(name, defines):
   print(name)
   print("=============================")
 
-  d_all = base_defines[:-1] + " ";
-
-  for d in defines:
-    d_all += " -D" + d + "=" + str(defines[d])
-
-  d_all += '"'
-  cmd = "make -j8 BIN=test.bin LVGL_DIR_NAME=" + lvgldirname + " DEFINES=" + d_all + " OPTIMIZATION=" + optimization
+  cmd = "make -j8 BIN=test.bin LVGL_DIR_NAME=" + lvgldirname + " DEFINES=" + defines_arg(defines) + " OPTIMIZATION=" + optimization
 
   print("---------------------------")
   print("Clean")
@@ -282,6 +285,10 @@ all_obj_all_features = {
   "LV_USE_WIN":1
 }
 
+# RGB565 with swapped bytes, as SPI displays are driven
+rgb565_swap = all_obj_all_features.copy()
+rgb565_swap.update({"LV_COLOR_DEPTH":16, "LV_COLOR_16_SWAP":1, "LV_COLOR_SCREEN_TRANSP":0})
+
 advanced_features = {
   "LV_DPI":100,
   "LV_MEM_SIZE":4*1024*1024,
@@ -301,6 +308,7 @@ advanced_features = {
   "LV_USE_USER_DATA":1,
   "LV_IMG_CACHE_DEF_SIZE":32,
   "LV_USE_LOG":1,
+  "LV_USE_PROFILER":1,
   "LV_USE_THEME_MATERIAL":1,
   "LV_USE_THEME_EMPTY":1,
   "LV_USE_THEME_TEMPLATE":1,
@@ -369,7 +377,9 @@ advanced_features = {
   "LV_USE_WIN":1
 }
 
-build("Minimal monochrome", minimal_monochrome)
-build("All objects, minimal features", all_obj_minimal_features)
-build("All objects, all common features", all_obj_all_features)
-build("All objects, with advanced features", advanced_features)
+if __name__ == "__main__":
+  build("Minimal monochrome", minimal_monochrome)
+  build("All objects, minimal features", all_obj_minimal_features)
+  build("All objects, all common features", all_obj_all_features)
+  build("All objects, RGB565 swapped", rgb565_swap)
+  build("All objects, with advanced features", advanced_features)
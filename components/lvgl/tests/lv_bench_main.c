@@ -0,0 +1,228 @@
+/**
+ * @file lv_bench_main.c
+ * Headless run of the lv_demo_benchmark scenes and lv_demo_stress.
+ * The tick advances one refresh period per frame, not with the time spent,
+ * so every build draws the same frames.
+ * A JSON object is printed per scene on a line, see bench.py.
+ * With `LV_USE_PROFILER` it also has the us per frame of each phase.
+ * Usage: bench.bin [frames] [buffers] [flush ns/px]
+ * The band buffers are a ring of `buffers` (`lv_disp_buf_init_ring()`) if more than 1.
+ * With a flush time the bands are "sent" in the background as by DMA,
+ * the measured time of a frame includes waiting for its last band to be sent.
+ */
+
+#include "../lvgl.h"
+#include "lv_examples.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if LV_BUILD_TEST && LV_USE_DEMO_BENCHMARK && LV_USE_DEMO_STRESS
+
+/*********************
+ *      DEFINES
+ *********************/
+#define BENCH_FRAMES        30      /*Frames per scene: the 1 s of a benchmark scene*/
+#define BENCH_STRESS_FRAMES 300
+#define BENCH_BUF_SIZE      (LV_HOR_RES_MAX * LV_VER_RES_MAX / 10)     /*As on the device*/
+#define BENCH_FLUSH_MAX     LV_DISP_BUF_RING_MAX                        /*Bands being flushed at most*/
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void hal_init(uint8_t buf_cnt);
+static void dummy_flush_cb(lv_disp_drv_t * disp_drv, const lv_area_t * area, lv_color_t * color_p);
+static void latency_flush_cb(lv_disp_drv_t * disp_drv, const lv_area_t * area, lv_color_t * color_p);
+static void latency_wait_cb(lv_disp_drv_t * disp_drv);
+static void latency_drain(void);
+static void scene_measure(const char * name, bool opa, uint32_t frame_cnt);
+static uint64_t time_us(void);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static lv_disp_drv_t * bench_drv;
+static uint32_t flush_ns_px;                    /*0: flushed at once*/
+static uint64_t flush_end_us[BENCH_FLUSH_MAX];  /*End of the bands being flushed, in order*/
+static uint32_t flush_head;
+static uint32_t flush_cnt;
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+int main(int argc, char ** argv)
+{
+    uint32_t frame_cnt = argc > 1 ? (uint32_t)atoi(argv[1]) : BENCH_FRAMES;
+    if(frame_cnt == 0) frame_cnt = BENCH_FRAMES;
+    int buf_cnt = argc > 2 ? atoi(argv[2]) : 1;
+    if(buf_cnt < 1) buf_cnt = 1;
+    if(buf_cnt > LV_DISP_BUF_RING_MAX) buf_cnt = LV_DISP_BUF_RING_MAX;
+    flush_ns_px = argc > 3 ? (uint32_t)atoi(argv[3]) : 0;
+
+    lv_init();
+    hal_init((uint8_t)buf_cnt);
+
+    uint32_t i;
+    for(i = 0; lv_demo_benchmark_get_scene_name(i); i++) {
+        lv_demo_benchmark_run_scene(i, false);
+        scene_measure(lv_demo_benchmark_get_scene_name(i), false, frame_cnt);
+        lv_demo_benchmark_run_scene(i, true);
+        scene_measure(lv_demo_benchmark_get_scene_name(i), true, frame_cnt);
+    }
+
+    /*The benchmark's objects are deleted, it can't be used after this*/
+    lv_obj_clean(lv_scr_act());
+    lv_demo_stress();
+    scene_measure("Stress", false, BENCH_STRESS_FRAMES * frame_cnt / BENCH_FRAMES);
+
+    return 0;
+}
+
+/*LV_PROFILER_TIME_EXPR of lv_test_conf.h*/
+uint32_t custom_time_us(void)
+{
+    return (uint32_t)time_us();
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+static void hal_init(uint8_t buf_cnt)
+{
+    static lv_disp_buf_t disp_buf;
+    static lv_color_t buf[LV_DISP_BUF_RING_MAX][BENCH_BUF_SIZE];
+    if(buf_cnt == 1) {
+        lv_disp_buf_init(&disp_buf, buf[0], NULL, BENCH_BUF_SIZE);
+    }
+    else {
+        void * bufs[LV_DISP_BUF_RING_MAX];
+        uint8_t i;
+        for(i = 0; i < buf_cnt; i++) bufs[i] = buf[i];
+        lv_disp_buf_init_ring(&disp_buf, bufs, buf_cnt, BENCH_BUF_SIZE);
+    }
+
+    lv_disp_drv_t disp_drv;
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.buffer = &disp_buf;
+    if(flush_ns_px) {
+        disp_drv.flush_cb = latency_flush_cb;
+        disp_drv.wait_cb = latency_wait_cb;
+    }
+    else {
+        disp_drv.flush_cb = dummy_flush_cb;
+    }
+    bench_drv = &lv_disp_drv_register(&disp_drv)->driver;
+}
+
+static void dummy_flush_cb(lv_disp_drv_t * disp_drv, const lv_area_t * area, lv_color_t * color_p)
+{
+    LV_UNUSED(area);
+    LV_UNUSED(color_p);
+
+    lv_disp_flush_ready(disp_drv);
+}
+
+/**
+ * Start "sending" a band: it ends `flush_ns_px` per pixel after the previous band ended.
+ * The flush ready is signalled from `latency_wait_cb()` while LVGL waits for a buffer.
+ */
+static void latency_flush_cb(lv_disp_drv_t * disp_drv, const lv_area_t * area, lv_color_t * color_p)
+{
+    LV_UNUSED(disp_drv);
+    LV_UNUSED(color_p);
+
+    uint64_t start = time_us();
+    if(flush_cnt) {
+        uint64_t prev_end = flush_end_us[(flush_head + flush_cnt - 1) % BENCH_FLUSH_MAX];
+        if(prev_end > start) start = prev_end;
+    }
+    flush_end_us[(flush_head + flush_cnt) % BENCH_FLUSH_MAX] = start + (uint64_t)lv_area_get_size(area) * flush_ns_px / 1000;
+    flush_cnt++;
+}
+
+/**
+ * Signal the flush ready of the bands sent by now, as the DMA interrupt would.
+ */
+static void latency_wait_cb(lv_disp_drv_t * disp_drv)
+{
+    uint64_t now = time_us();
+    while(flush_cnt && flush_end_us[flush_head] <= now) {
+        flush_head = (flush_head + 1) % BENCH_FLUSH_MAX;
+        flush_cnt--;
+        lv_disp_flush_ready(disp_drv);
+    }
+}
+
+/**
+ * Wait until the last band of the frame is sent.
+ */
+static void latency_drain(void)
+{
+    while(flush_cnt) latency_wait_cb(bench_drv);
+}
+
+/**
+ * Draw the frames of the active scene and print what they cost.
+ * The first frame draws the new scene on the whole screen and is not measured.
+ * @param name name of the scene
+ * @param opa true: the "+ opa" variant
+ * @param frame_cnt number of measured frames
+ */
+static void scene_measure(const char * name, bool opa, uint32_t frame_cnt)
+{
+    lv_mem_monitor_t mon;
+    lv_refr_stat_t stat;
+    uint64_t sum_us = 0;
+    uint32_t mem_peak = 0;
+    uint32_t i;
+
+    lv_tick_inc(LV_DISP_DEF_REFR_PERIOD);
+    lv_task_handler();
+    latency_drain();
+    lv_refr_reset_stat();
+#if LV_USE_PROFILER
+    lv_prof_reset();
+#endif
+
+    for(i = 0; i < frame_cnt; i++) {
+        lv_tick_inc(LV_DISP_DEF_REFR_PERIOD);
+        uint64_t start = time_us();
+        lv_task_handler();
+        latency_drain();
+        sum_us += time_us() - start;
+
+        /*Memory used between frames: the draw buffers of the frame are still kept*/
+        lv_mem_monitor(&mon);
+        if(mon.total_size - mon.free_size > mem_peak) mem_peak = mon.total_size - mon.free_size;
+    }
+
+    lv_refr_get_stat(&stat);
+    printf("{\"scene\":\"%s\",\"opa\":%s,\"frames\":%u,\"ms_per_frame\":%.3f,\"refr_px\":%u,\"blend_px\":%u,"
+           "\"draw_cnt\":%u,\"cull_cnt\":%u,\"mem_peak\":%u",
+           name, opa ? "true" : "false", (unsigned)frame_cnt, (double)sum_us / 1000.0 / frame_cnt,
+           (unsigned)stat.px_cnt, (unsigned)stat.blend_px_cnt, (unsigned)stat.draw_cnt, (unsigned)stat.cull_cnt,
+           (unsigned)mem_peak);
+#if LV_USE_PROFILER
+    /*Frames without change are not in the sum, average on all of them as ms_per_frame*/
+    lv_prof_frame_t prof;
+    lv_prof_get_sum(&prof);
+    printf(",\"prof_us\":{");
+    for(i = 0; i < _LV_PROF_NUM; i++) {
+        printf("%s\"%s\":%.1f", i ? "," : "", lv_prof_get_phase_name(i), (double)prof.phase[i].time_us / frame_cnt);
+    }
+    printf("}");
+#endif
+    printf("}\n");
+    fflush(stdout);
+}
+
+static uint64_t time_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+#endif
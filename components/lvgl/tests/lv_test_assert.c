@@ -161,11 +161,11 @@ void lv_test_assert_color_eq(lv_color_t c_ref, lv_color_t c_act, const char * s)
 {
     if(c_ref.full != c_act.full) {
         lv_test_error("   FAIL: %s. (Expected:  R:%02x, G:%02x, B:%02x, Actual: R:%02x, G:%02x, B:%02x)",  s,
-                c_ref.ch.red, c_ref.ch.green, c_ref.ch.blue,
-                c_act.ch.red, c_act.ch.green, c_act.ch.blue);
+                LV_COLOR_GET_R(c_ref), LV_COLOR_GET_G(c_ref), LV_COLOR_GET_B(c_ref),
+                LV_COLOR_GET_R(c_act), LV_COLOR_GET_G(c_act), LV_COLOR_GET_B(c_act));
     } else {
         lv_test_print("   PASS: %s. (Expected: R:%02x, G:%02x, B:%02x)", s,
-                c_ref.ch.red, c_ref.ch.green, c_ref.ch.blue);
+                LV_COLOR_GET_R(c_ref), LV_COLOR_GET_G(c_ref), LV_COLOR_GET_B(c_ref));
     }
 }
 
@@ -0,0 +1,301 @@
+/**
+ * @file lv_test_blend.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "../../lvgl.h"
+#include "../lv_test_assert.h"
+#include "lv_test_blend.h"
+
+#if LV_BUILD_TEST
+#include <string.h>
+#include <time.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define BUF_W           64
+#define BUF_H           8
+#define BENCH_W         240
+#define BENCH_H         32
+#define BENCH_PX        (4 * 1024 * 1024)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef enum {
+    CASE_FILL_OPA,      /*Fill with opacity, no mask*/
+    CASE_FILL_MASK,     /*Fill with a mask (anti-aliased edges, text)*/
+    CASE_MAP_OPA,       /*Image with opacity, no mask*/
+    CASE_MAP_MASK,      /*Image with a mask (rounded image)*/
+} blend_case_t;
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static uint32_t rand_next(void);
+static lv_color_t rand_color(void);
+static void rand_mask(lv_opa_t * mask, uint32_t len);
+static lv_color_t ref_px(lv_color_t fg, lv_color_t bg, lv_opa_t opa, const lv_opa_t * mask, bool map);
+static void blend(blend_case_t c, const lv_area_t * area, lv_color_t color, lv_opa_t opa);
+static uint32_t check_exact(blend_case_t c, lv_coord_t x1, lv_coord_t w, lv_coord_t h, lv_opa_t opa);
+static void exact(void);
+static void bench(void);
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static lv_color_t dest_buf[BENCH_W * BENCH_H];
+static lv_color_t orig_buf[BENCH_W * BENCH_H];
+static lv_color_t map_buf[BENCH_W * BENCH_H];
+static lv_opa_t mask_buf[BENCH_W * BENCH_H];
+static uint32_t rand_state = 7;
+static const char * case_name[] = {"fill opa", "fill mask", "map opa", "map mask"};
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void lv_test_blend(void)
+{
+    lv_test_print("");
+    lv_test_print("========================");
+    lv_test_print("Start lv_draw_blend tests");
+    lv_test_print("========================");
+
+    /*Blend into a buffer of the test instead of the display's*/
+    lv_disp_t * disp = lv_disp_get_default();
+    lv_disp_buf_t * vdb = lv_disp_get_buf(disp);
+    lv_disp_t * disp_refr_ori = _lv_refr_get_disp_refreshing();
+    lv_area_t area_ori = vdb->area;
+    void * buf_ori = vdb->buf_act;
+    _lv_refr_set_disp_refreshing(disp);
+    vdb->buf_act = dest_buf;
+#if LV_COLOR_SCREEN_TRANSP
+    /*Mixing with the screen's alpha is not compared*/
+    uint32_t screen_transp_ori = disp->driver.screen_transp;
+    disp->driver.screen_transp = 0;
+#endif
+
+    exact();
+    bench();
+
+#if LV_COLOR_SCREEN_TRANSP
+    disp->driver.screen_transp = screen_transp_ori;
+#endif
+    vdb->area = area_ori;
+    vdb->buf_act = buf_ori;
+    _lv_refr_set_disp_refreshing(disp_refr_ori);
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/**
+ * Deterministic pseudo random numbers
+ */
+static uint32_t rand_next(void)
+{
+    rand_state = rand_state * 1103515245 + 12345;
+    return rand_state >> 8;
+}
+
+static lv_color_t rand_color(void)
+{
+    lv_color_t c;
+    c.full = (rand_next() << 16) ^ rand_next();
+    return c;
+}
+
+/**
+ * Random mask in groups of 4: transparent, opaque or mixed values as on the edges of shapes
+ */
+static void rand_mask(lv_opa_t * mask, uint32_t len)
+{
+    uint32_t kind = 0;
+    uint32_t i;
+    for(i = 0; i < len; i++) {
+        if(i % 4 == 0) kind = rand_next() % 3;
+        if(kind == 0) mask[i] = LV_OPA_TRANSP;
+        else if(kind == 1) mask[i] = LV_OPA_COVER;
+        else mask[i] = rand_next() & 0xFF;
+    }
+}
+
+/**
+ * A pixel as the scalar blending computes it
+ * @param fg the fill color or the image's pixel
+ * @param bg the pixel in the buffer
+ * @param opa opacity of the fill or image
+ * @param mask pointer to the mask value of the pixel, NULL: not masked
+ * @param map true: image; false: fill
+ * @return the result
+ */
+static lv_color_t ref_px(lv_color_t fg, lv_color_t bg, lv_opa_t opa, const lv_opa_t * mask, bool map)
+{
+    if(mask == NULL && map) return opa > LV_OPA_MAX ? fg : lv_color_mix(fg, bg, opa);
+    if(mask == NULL) {
+        /*Fills mix pre-multiplied: the same as `lv_color_mix` except with 1 bit color*/
+        uint16_t premult[3];
+        lv_color_premult(fg, opa, premult);
+        return opa > LV_OPA_MAX ? fg : lv_color_mix_premult(premult, bg, 255 - opa);
+    }
+    if(*mask == LV_OPA_TRANSP) return bg;
+    if(opa > LV_OPA_MAX) return *mask == LV_OPA_COVER ? fg : lv_color_mix(fg, bg, *mask);
+
+    if(map) return lv_color_mix(fg, bg, *mask >= LV_OPA_MAX ? opa : (opa * *mask) >> 8);
+
+    lv_opa_t opa_tmp = *mask == LV_OPA_COVER ? opa : (*mask * opa) >> 8;
+    return opa_tmp == LV_OPA_COVER ? fg : lv_color_mix(fg, bg, opa_tmp);
+}
+
+/**
+ * Blend the test's color, image and mask to an area of the buffer
+ */
+static void blend(blend_case_t c, const lv_area_t * area, lv_color_t color, lv_opa_t opa)
+{
+    bool masked = c == CASE_FILL_MASK || c == CASE_MAP_MASK;
+    lv_draw_mask_res_t mask_res = masked ? LV_DRAW_MASK_RES_CHANGED : LV_DRAW_MASK_RES_FULL_COVER;
+    lv_opa_t * mask = masked ? mask_buf : NULL;
+    if(c == CASE_FILL_OPA || c == CASE_FILL_MASK) {
+        _lv_blend_fill(area, area, color, mask, mask_res, opa, LV_BLEND_MODE_NORMAL);
+    }
+    else {
+        _lv_blend_map(area, area, map_buf, mask, mask_res, opa, LV_BLEND_MODE_NORMAL);
+    }
+}
+
+/**
+ * Blend to random pixels and compare every pixel with the scalar result
+ * @return number of different pixels
+ */
+static uint32_t check_exact(blend_case_t c, lv_coord_t x1, lv_coord_t w, lv_coord_t h, lv_opa_t opa)
+{
+    lv_disp_buf_t * vdb = lv_disp_get_buf(lv_disp_get_default());
+    lv_area_set(&vdb->area, 0, 0, BUF_W - 1, BUF_H - 1);
+
+    uint32_t i;
+    for(i = 0; i < BUF_W * BUF_H; i++) {
+        dest_buf[i] = rand_color();
+        map_buf[i] = rand_color();
+    }
+    /*Runs of one color as on backgrounds*/
+    for(i = BUF_W; i < 2 * BUF_W; i++) dest_buf[i] = dest_buf[BUF_W - 1];
+    rand_mask(mask_buf, BUF_W * BUF_H);
+    memcpy(orig_buf, dest_buf, sizeof(orig_buf));
+
+    lv_color_t color = rand_color();
+    lv_area_t area;
+    lv_area_set(&area, x1, 0, x1 + w - 1, h - 1);
+    bool masked = c == CASE_FILL_MASK || c == CASE_MAP_MASK;
+    bool map = c == CASE_MAP_OPA || c == CASE_MAP_MASK;
+    blend(c, &area, color, opa);
+
+    /*The image and the mask are as wide as the area*/
+    uint32_t diff = 0;
+    lv_coord_t x;
+    lv_coord_t y;
+    for(y = 0; y < BUF_H; y++) {
+        for(x = 0; x < BUF_W; x++) {
+            lv_color_t exp = orig_buf[y * BUF_W + x];
+            if(x >= area.x1 && x <= area.x2 && y <= area.y2) {
+                uint32_t i_area = y * w + x - x1;
+                lv_color_t fg = map ? map_buf[i_area] : color;
+                exp = ref_px(fg, exp, opa, masked ? &mask_buf[i_area] : NULL, map);
+            }
+            diff += exp.full != dest_buf[y * BUF_W + x].full;
+        }
+    }
+    return diff;
+}
+
+/**
+ * Every blending case, on even and odd pixels, of short and long lines
+ */
+static void exact(void)
+{
+    static const lv_opa_t opa_list[] = {LV_OPA_COVER, LV_OPA_MAX, 254, 200, LV_OPA_50, 77, LV_OPA_MIN};
+    static const lv_coord_t w_list[] = {1, 2, 3, 7, BUF_W - 1};
+
+    lv_test_print("");
+    lv_test_print("Same pixels as the scalar blending");
+    lv_test_print("---------------------------");
+
+    uint32_t c;
+    for(c = 0; c <= CASE_MAP_MASK; c++) {
+        uint32_t diff = 0;
+        uint32_t o;
+        for(o = 0; o < sizeof(opa_list) / sizeof(opa_list[0]); o++) {
+            uint32_t k;
+            for(k = 0; k < sizeof(w_list) / sizeof(w_list[0]); k++) {
+                lv_coord_t w = w_list[k];
+                diff += check_exact((blend_case_t)c, 0, w, BUF_H, opa_list[o]);
+                diff += check_exact((blend_case_t)c, BUF_W - w, w, BUF_H / 2, opa_list[o]);
+            }
+        }
+        lv_test_assert_int_eq(0, diff, case_name[c]);
+    }
+}
+
+/**
+ * Blended pixels per microsecond of each case on random and on one color backgrounds.
+ * The scalar reference mixes every pixel with `lv_color_mix`.
+ */
+static void bench(void)
+{
+    lv_disp_buf_t * vdb = lv_disp_get_buf(lv_disp_get_default());
+    lv_area_set(&vdb->area, 0, 0, BENCH_W - 1, BENCH_H - 1);
+    lv_area_t area;
+    lv_area_set(&area, 1, 0, BENCH_W - 1, BENCH_H - 1);
+    uint32_t area_px = lv_area_get_size(&area);
+    uint32_t reps = BENCH_PX / area_px;
+
+    lv_test_print("");
+    lv_test_print("Blending %dx%d px, %d bit color (px/us)", BENCH_W - 1, BENCH_H, LV_COLOR_DEPTH);
+    lv_test_print("---------------------------");
+
+    uint32_t i;
+    for(i = 0; i < BENCH_W * BENCH_H; i++) map_buf[i] = rand_color();
+    rand_mask(mask_buf, BENCH_W * BENCH_H);
+    lv_color_t color = rand_color();
+
+    uint32_t c;
+    for(c = 0; c <= CASE_MAP_MASK; c++) {
+        uint32_t speed[3];
+        uint32_t k;
+        for(k = 0; k < 3; k++) {
+            /*Random background, one color background, scalar reference on the random one*/
+            lv_color_t bg = rand_color();
+            for(i = 0; i < BENCH_W * BENCH_H; i++) dest_buf[i] = k == 1 ? bg : rand_color();
+
+            clock_t start = clock();
+            uint32_t r;
+            for(r = 0; r < reps; r++) {
+                if(k < 2) {
+                    blend((blend_case_t)c, &area, color, LV_OPA_60);
+                }
+                else {
+                    bool map = c == CASE_MAP_OPA || c == CASE_MAP_MASK;
+                    bool masked = c == CASE_FILL_MASK || c == CASE_MAP_MASK;
+                    for(i = 0; i < area_px; i++) {
+                        lv_opa_t mix = masked ? (lv_opa_t)((mask_buf[i] * LV_OPA_60) >> 8) : LV_OPA_60;
+                        dest_buf[i] = lv_color_mix(map ? map_buf[i] : color, dest_buf[i], mix);
+                    }
+                }
+            }
+            uint32_t us = (uint32_t)(((uint64_t)(clock() - start) * 1000000) / CLOCKS_PER_SEC);
+            speed[k] = (uint32_t)(((uint64_t)reps * area_px) / (us ? us : 1));
+        }
+        lv_test_print("%s: %d random bg, %d one color bg, scalar lv_color_mix %d", case_name[c],
+                      speed[0], speed[1], speed[2]);
+    }
+}
+#endif
@@ -13,6 +13,9 @@
 #include "lv_test_obj.h"
 #include "lv_test_style.h"
 #include "lv_test_font_loader.h"
+#include "lv_test_refr.h"
+#include "lv_test_blend.h"
+#include "lv_test_prof.h"
 
 /*********************
  *      DEFINES
@@ -48,6 +51,9 @@ void lv_test_core(void)
     lv_test_obj();
     lv_test_style();
     lv_test_font_loader();
+    lv_test_refr();
+    lv_test_blend();
+    lv_test_prof();
 }
 
 /**********************
@@ -0,0 +1,217 @@
+/**
+ * @file lv_test_prof.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "../../lvgl.h"
+#include "../lv_test_assert.h"
+#include "lv_test_prof.h"
+
+#if LV_BUILD_TEST
+
+/*********************
+ *      DEFINES
+ *********************/
+#define IMG_W   8
+#define IMG_H   8
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+#if LV_USE_PROFILER && LV_USE_LABEL && LV_USE_IMG && LV_USE_LINE
+static void frame_cb(const lv_prof_frame_t * frame);
+static void phases(void);
+static void outside_refr(void);
+#endif
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+#if LV_USE_PROFILER && LV_USE_LABEL && LV_USE_IMG && LV_USE_LINE
+static lv_color_t img_map[IMG_W * IMG_H];
+static lv_img_dsc_t img_dsc;
+static uint32_t frame_cb_cnt;
+#endif
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void lv_test_prof(void)
+{
+    lv_test_print("");
+    lv_test_print("===================");
+    lv_test_print("Start lv_prof tests");
+    lv_test_print("===================");
+
+#if LV_USE_PROFILER && LV_USE_LABEL && LV_USE_IMG && LV_USE_LINE
+    phases();
+    outside_refr();
+#elif LV_USE_PROFILER
+    lv_test_print("Skip: needs labels, images and lines");
+#else
+    lv_test_print("Skip: LV_USE_PROFILER == 0");
+#endif
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+#if LV_USE_PROFILER && LV_USE_LABEL && LV_USE_IMG && LV_USE_LINE
+
+static void frame_cb(const lv_prof_frame_t * frame)
+{
+    LV_UNUSED(frame);
+    frame_cb_cnt++;
+}
+
+/**
+ * Draw one of each primitive and check what the phases counted
+ */
+static void phases(void)
+{
+    lv_test_print("");
+    lv_test_print("Phases of a full screen refresh");
+    lv_test_print("---------------------------");
+
+    lv_obj_clean(lv_scr_act());
+
+    /*Rounded corners are drawn with masks*/
+    lv_obj_t * rect = lv_obj_create(lv_scr_act(), NULL);
+    lv_obj_set_pos(rect, 10, 10);
+    lv_obj_set_size(rect, 60, 40);
+    lv_obj_set_style_local_radius(rect, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, 10);
+
+    lv_obj_t * label = lv_label_create(lv_scr_act(), NULL);
+    lv_obj_set_pos(label, 10, 60);
+    lv_label_set_text(label, "Profiler");
+
+    img_dsc.header.cf = LV_IMG_CF_TRUE_COLOR;
+    img_dsc.header.w = IMG_W;
+    img_dsc.header.h = IMG_H;
+    img_dsc.data_size = sizeof(img_map);
+    img_dsc.data = (const uint8_t *)img_map;
+    lv_obj_t * img = lv_img_create(lv_scr_act(), NULL);
+    lv_obj_set_pos(img, 80, 10);
+    lv_img_set_src(img, &img_dsc);
+
+    static lv_point_t line_points[] = {{0, 0}, {30, 20}};
+    lv_obj_t * line = lv_line_create(lv_scr_act(), NULL);
+    lv_obj_set_pos(line, 100, 10);
+    lv_line_set_points(line, line_points, 2);
+    lv_obj_set_style_local_line_width(line, LV_LINE_PART_MAIN, LV_STATE_DEFAULT, 2);
+
+    /*Drop the frames of the objects' creation*/
+    lv_refr_now(NULL);
+
+    lv_prof_reset();
+    lv_prof_set_frame_cb(frame_cb);
+    frame_cb_cnt = 0;
+    lv_refr_reset_stat();
+
+    lv_obj_invalidate(lv_scr_act());
+    lv_refr_now(NULL);
+
+    lv_prof_frame_t frame;
+    lv_prof_frame_t sum;
+    lv_refr_stat_t stat;
+    lv_prof_get_frame(&frame);
+    lv_refr_get_stat(&stat);
+    lv_test_assert_int_eq(1, lv_prof_get_sum(&sum), "One frame in the sum");
+    lv_test_assert_int_eq(1, frame_cb_cnt, "Frame callback called once");
+    lv_test_assert_int_eq(frame.time_us, sum.time_us, "The sum is the frame");
+
+    uint32_t time_sum = 0;
+    uint32_t blend_px = 0;
+    uint32_t i;
+    for(i = 0; i < _LV_PROF_NUM; i++) {
+        lv_prof_phase_stat_t * p = &frame.phase[i];
+        lv_test_print("%-6s %4d calls %8d px %6d us", lv_prof_get_phase_name(i), (int)p->call_cnt, (int)p->px_cnt,
+                      (int)p->time_us);
+        time_sum += p->time_us;
+        if(i != LV_PROF_MASK && i != LV_PROF_FLUSH) blend_px += p->px_cnt;
+    }
+    lv_test_print("frame  %6d us", (int)frame.time_us);
+
+    lv_test_assert_int_eq(time_sum, frame.time_us, "Phases add up to the frame");
+    lv_test_assert_int_eq(stat.blend_px_cnt, blend_px, "Every blended pixel in a drawing phase");
+
+    lv_coord_t hres = lv_disp_get_hor_res(NULL);
+    lv_coord_t vres = lv_disp_get_ver_res(NULL);
+    lv_test_assert_int_eq(hres * vres, frame.phase[LV_PROF_FLUSH].px_cnt, "Whole screen flushed");
+    lv_test_assert_int_eq(1, frame.phase[LV_PROF_JOIN].call_cnt, "Areas joined once");
+    lv_test_assert_int_gt(0, frame.phase[LV_PROF_OBJ].call_cnt, "Objects walked");
+    lv_test_assert_int_gt(0, frame.phase[LV_PROF_RECT].call_cnt, "Rectangles drawn");
+    lv_test_assert_int_gt(0, frame.phase[LV_PROF_RECT].px_cnt, "Rectangles blended");
+    lv_test_assert_int_gt(0, frame.phase[LV_PROF_LABEL].call_cnt, "Label drawn");
+    lv_test_assert_int_gt(0, frame.phase[LV_PROF_LABEL].px_cnt, "Label blended");
+    lv_test_assert_int_eq(1, frame.phase[LV_PROF_IMG].call_cnt, "Image drawn once");
+    lv_test_assert_int_eq(IMG_W * IMG_H, frame.phase[LV_PROF_IMG].px_cnt, "Image blended");
+    lv_test_assert_int_eq(1, frame.phase[LV_PROF_LINE].call_cnt, "Line drawn once");
+    lv_test_assert_int_gt(0, frame.phase[LV_PROF_MASK].call_cnt, "Rounded corners masked");
+    lv_test_assert_str_eq("rect", lv_prof_get_phase_name(LV_PROF_RECT), "Phase name");
+
+    /*Nothing to draw: the frame is not counted*/
+    lv_refr_now(NULL);
+    lv_test_assert_int_eq(1, lv_prof_get_sum(&sum), "Empty refresh not counted");
+    lv_test_assert_int_eq(1, frame_cb_cnt, "No callback for an empty refresh");
+
+    lv_obj_invalidate(rect);
+    lv_refr_now(NULL);
+    lv_test_assert_int_eq(2, lv_prof_get_sum(&sum), "Second frame in the sum");
+    lv_prof_get_frame(&frame);
+    lv_test_assert_int_eq(0, frame.phase[LV_PROF_IMG].call_cnt, "Image not redrawn");
+    lv_test_assert_int_eq(frame.time_us + time_sum, sum.time_us, "Frames summed");
+
+    lv_prof_set_frame_cb(NULL);
+    lv_obj_clean(lv_scr_act());
+    lv_refr_now(NULL);
+}
+
+/**
+ * Drawing outside of a refresh (e.g. on a canvas) is not measured
+ */
+static void outside_refr(void)
+{
+    lv_test_print("");
+    lv_test_print("Drawing outside of a refresh");
+    lv_test_print("---------------------------");
+
+    lv_prof_frame_t before;
+    lv_prof_frame_t after;
+    lv_prof_reset();
+    lv_prof_get_frame(&before);
+
+#if LV_USE_CANVAS
+    static lv_color_t cbuf[LV_CANVAS_BUF_SIZE_TRUE_COLOR(IMG_W, IMG_H)];
+    lv_obj_t * canvas = lv_canvas_create(lv_scr_act(), NULL);
+    lv_canvas_set_buffer(canvas, cbuf, IMG_W, IMG_H, LV_IMG_CF_TRUE_COLOR);
+    lv_obj_set_hidden(canvas, true);
+
+    lv_draw_rect_dsc_t dsc;
+    lv_draw_rect_dsc_init(&dsc);
+    dsc.radius = 3;
+    lv_canvas_draw_rect(canvas, 0, 0, IMG_W, IMG_H, &dsc);
+    lv_obj_del(canvas);
+#endif
+
+    lv_prof_frame_t sum;
+    lv_test_assert_int_eq(0, lv_prof_get_sum(&sum), "No frame measured");
+    lv_prof_get_frame(&after);
+    lv_test_assert_array_eq((const uint8_t *)&before, (const uint8_t *)&after, sizeof(before), "Last frame unchanged");
+}
+
+#endif
+#endif
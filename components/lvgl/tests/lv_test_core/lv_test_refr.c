@@ -0,0 +1,548 @@
+/**
+ * @file lv_test_refr.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "../../lvgl.h"
+#include "../lv_test_assert.h"
+#include "lv_test_refr.h"
+
+#if LV_BUILD_TEST
+#include <string.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define AREA_CNT        (LV_INV_BUF_SIZE + 40)
+#define CELL_COLS       12
+#define CELL_ROWS       8
+#define BENCH_FRAMES    10
+#define WIN_CNT         4
+#define TAB_CNT         3
+#define RING_CNT        3
+#define RING_BAND_ROWS  8       /*Rows of a band buffer: many bands per screen*/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void shadow_flush_cb(lv_disp_drv_t * disp_drv, const lv_area_t * area, lv_color_t * color_p);
+static uint32_t refr_px(void);
+static uint32_t rand_next(void);
+static void many_areas(void);
+static void ring_flush_cb(lv_disp_drv_t * disp_drv, const lv_area_t * area, lv_color_t * color_p);
+static void ring_release(lv_disp_drv_t * disp_drv);
+static uint32_t shadow_hash(void);
+static void band_ring(void);
+#if LV_MEM_CUSTOM || LV_MEM_SIZE >= (32U * 1024U)
+static uint32_t tile_px(const lv_area_t * area);
+static void dashboard_bench(void);
+static lv_obj_t * panel_create(lv_obj_t * parent, lv_coord_t x, lv_coord_t y, lv_coord_t w, lv_coord_t h, uint32_t seed);
+static void overlap_bench(void);
+#endif
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+static lv_color_t shadow_fb[LV_HOR_RES_MAX * LV_VER_RES_MAX];  /*The screen as flushed*/
+#if LV_MEM_CUSTOM || LV_MEM_SIZE >= (32U * 1024U)
+static lv_color_t prev_fb[LV_HOR_RES_MAX * LV_VER_RES_MAX];
+#endif
+static uint8_t drawn[LV_HOR_RES_MAX * LV_VER_RES_MAX];          /*1: flushed by the last refresh*/
+static uint32_t flush_px;
+static uint32_t rand_state = 1;
+static lv_area_t ring_area[RING_CNT];     /*Bands being "sent", oldest first*/
+static lv_color_t * ring_color[RING_CNT];
+static uint32_t ring_pending;
+static uint32_t ring_pending_max;
+static uint32_t ring_band_cnt;
+static bool ring_in_order;                /*Every band drawn in the buffer after the previous one*/
+static lv_color_t * ring_next;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void lv_test_refr(void)
+{
+    lv_test_print("");
+    lv_test_print("===================");
+    lv_test_print("Start lv_refr tests");
+    lv_test_print("===================");
+
+    many_areas();
+    band_ring();
+#if LV_MEM_CUSTOM == 0 && LV_MEM_SIZE < (32U * 1024U)
+    lv_test_print("Skip dashboard benchmark: LV_MEM_SIZE < 32 kB");
+#else
+    dashboard_bench();
+    overlap_bench();
+#endif
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+/**
+ * Copy the flushed area to its place in the shadow frame buffer
+ */
+static void shadow_flush_cb(lv_disp_drv_t * disp_drv, const lv_area_t * area, lv_color_t * color_p)
+{
+    lv_coord_t w = lv_area_get_width(area);
+    lv_coord_t y;
+    for(y = area->y1; y <= area->y2; y++) {
+        uint32_t offs = (uint32_t)y * LV_HOR_RES + area->x1;
+        memcpy(&shadow_fb[offs], &color_p[(y - area->y1) * w], w * sizeof(lv_color_t));
+        memset(&drawn[offs], 1, w);
+    }
+    flush_px += lv_area_get_size(area);
+
+    lv_disp_flush_ready(disp_drv);
+}
+
+/**
+ * Refresh the screen now into the shadow frame buffer
+ * @return pixels flushed
+ */
+static uint32_t refr_px(void)
+{
+    lv_disp_t * disp = lv_disp_get_default();
+    void (*flush_cb)(lv_disp_drv_t *, const lv_area_t *, lv_color_t *) = disp->driver.flush_cb;
+    disp->driver.flush_cb = shadow_flush_cb;
+    memset(drawn, 0, sizeof(drawn));
+    flush_px = 0;
+    lv_refr_now(disp);
+    disp->driver.flush_cb = flush_cb;
+    return flush_px;
+}
+
+/**
+ * Deterministic pseudo random numbers
+ */
+static uint32_t rand_next(void)
+{
+    rand_state = rand_state * 1103515245 + 12345;
+    return rand_state >> 8;
+}
+
+static void many_areas(void)
+{
+    lv_test_print("");
+    lv_test_print("Invalidate more areas than LV_INV_BUF_SIZE");
+    lv_test_print("---------------------------");
+
+#if LV_INV_TILE_SIZE
+    lv_disp_t * disp = lv_disp_get_default();
+    lv_coord_t hres = LV_HOR_RES;
+    lv_coord_t vres = LV_VER_RES;
+    lv_area_t areas[AREA_CNT];
+    uint32_t i;
+    refr_px();
+
+    /*Small areas on the left half*/
+    for(i = 0; i < AREA_CNT; i++) {
+        areas[i].x1 = rand_next() % (hres / 2 - 3);
+        areas[i].y1 = rand_next() % (vres - 3);
+        areas[i].x2 = areas[i].x1 + 2;
+        areas[i].y2 = areas[i].y1 + 2;
+        _lv_inv_area(disp, &areas[i]);
+    }
+    lv_test_assert_int_eq(1, disp->inv_tiled, "Areas moved to the tile map");
+    lv_test_assert_int_eq(LV_INV_BUF_SIZE, lv_disp_get_inv_buf_size(disp), "Area count stays at the buffer size");
+
+    /*Expected: every dirty tile exactly once*/
+    static uint8_t dirty[LV_INV_TILE_ROWS][LV_INV_TILE_COLS];
+    memset(dirty, 0, sizeof(dirty));
+    for(i = 0; i < AREA_CNT; i++) {
+        lv_coord_t row;
+        lv_coord_t col;
+        for(row = areas[i].y1 / LV_INV_TILE_SIZE; row <= areas[i].y2 / LV_INV_TILE_SIZE; row++) {
+            for(col = areas[i].x1 / LV_INV_TILE_SIZE; col <= areas[i].x2 / LV_INV_TILE_SIZE; col++) {
+                dirty[row][col] = 1;
+            }
+        }
+    }
+    uint32_t tiles_px = 0;
+    lv_coord_t row;
+    lv_coord_t col;
+    for(row = 0; row < LV_INV_TILE_ROWS; row++) {
+        for(col = 0; col < LV_INV_TILE_COLS; col++) {
+            if(dirty[row][col]) {
+                tiles_px += LV_MATH_MIN(LV_INV_TILE_SIZE, hres - col * LV_INV_TILE_SIZE) *
+                            LV_MATH_MIN(LV_INV_TILE_SIZE, vres - row * LV_INV_TILE_SIZE);
+            }
+        }
+    }
+
+    uint32_t px = refr_px();
+    lv_test_print("%d areas of 3x3 px: %d px redrawn of %d", AREA_CNT, px, hres * vres);
+    lv_test_assert_int_eq(tiles_px, px, "Dirty tiles redrawn once");
+    lv_test_assert_int_eq(0, disp->inv_tiled, "Tile map reset after refresh");
+
+    bool covered = true;
+    for(i = 0; i < AREA_CNT; i++) {
+        lv_coord_t x;
+        lv_coord_t y;
+        for(y = areas[i].y1; y <= areas[i].y2; y++) {
+            for(x = areas[i].x1; x <= areas[i].x2; x++) {
+                covered &= drawn[y * hres + x] == 1;
+            }
+        }
+    }
+    lv_test_assert_true(covered, "Every invalidated pixel redrawn");
+
+    bool right_clean = true;
+    lv_coord_t x0 = ((hres / 2 + LV_INV_TILE_SIZE - 1) / LV_INV_TILE_SIZE) * LV_INV_TILE_SIZE;
+    lv_coord_t y;
+    for(y = 0; y < vres; y++) {
+        lv_coord_t x;
+        for(x = x0; x < hres; x++) {
+            right_clean &= drawn[y * hres + x] == 0;
+        }
+    }
+    lv_test_assert_true(right_clean, "Right half not redrawn");
+
+    /*Clearing drops the tiles too*/
+    for(i = 0; i < AREA_CNT; i++) {
+        _lv_inv_area(disp, &areas[i]);
+    }
+    _lv_inv_area(disp, NULL);
+    lv_test_assert_int_eq(0, refr_px(), "Nothing redrawn after clearing");
+#else
+    lv_test_print("Skip tile map test: LV_INV_TILE_SIZE == 0");
+#endif
+}
+
+/**
+ * Keep the band as in flight, it's copied to the shadow frame buffer only when released.
+ * A buffer drawn again before that would show up on the shadow frame buffer.
+ */
+static void ring_flush_cb(lv_disp_drv_t * disp_drv, const lv_area_t * area, lv_color_t * color_p)
+{
+    lv_disp_buf_t * vdb = disp_drv->buffer;
+    if(ring_next && color_p != ring_next) ring_in_order = false;
+    uint32_t i;
+    for(i = 0; i < vdb->ring_cnt; i++) {
+        if(vdb->ring[i] == color_p) ring_next = vdb->ring[(i + 1) % vdb->ring_cnt];
+    }
+
+    ring_area[ring_pending] = *area;
+    ring_color[ring_pending] = color_p;
+    ring_pending++;
+    if(ring_pending > ring_pending_max) ring_pending_max = ring_pending;
+    ring_band_cnt++;
+}
+
+/**
+ * Finish sending the oldest band, the `wait_cb` while LVGL waits for a buffer
+ */
+static void ring_release(lv_disp_drv_t * disp_drv)
+{
+    if(ring_pending == 0) return;
+
+    lv_area_t * area = &ring_area[0];
+    lv_coord_t w = lv_area_get_width(area);
+    lv_coord_t y;
+    for(y = area->y1; y <= area->y2; y++) {
+        memcpy(&shadow_fb[(uint32_t)y * LV_HOR_RES + area->x1], &ring_color[0][(y - area->y1) * w], w * sizeof(lv_color_t));
+    }
+    ring_pending--;
+    memmove(&ring_area[0], &ring_area[1], ring_pending * sizeof(lv_area_t));
+    memmove(&ring_color[0], &ring_color[1], ring_pending * sizeof(lv_color_t *));
+
+    lv_disp_flush_ready(disp_drv);
+}
+
+/**
+ * FNV-1a hash of the shadow frame buffer
+ */
+static uint32_t shadow_hash(void)
+{
+    const uint8_t * p = (const uint8_t *)shadow_fb;
+    uint32_t h = 2166136261U;
+    uint32_t i;
+    for(i = 0; i < (uint32_t)LV_HOR_RES * LV_VER_RES * sizeof(lv_color_t); i++) {
+        h = (h ^ p[i]) * 16777619U;
+    }
+    return h;
+}
+
+/**
+ * Draw the screen into a ring of band buffers with flushes finishing only when a buffer is needed
+ * and compare it with the screen drawn in the single buffer.
+ */
+static void band_ring(void)
+{
+    lv_test_print("");
+    lv_test_print("Ring of %d band buffers", RING_CNT);
+    lv_test_print("---------------------------");
+
+    lv_disp_t * disp = lv_disp_get_default();
+    lv_obj_t * obj = lv_obj_create(lv_scr_act(), NULL);
+    lv_obj_set_style_local_bg_grad_color(obj, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, LV_COLOR_RED);
+    lv_obj_set_style_local_bg_grad_dir(obj, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, LV_GRAD_DIR_VER);
+    lv_obj_set_size(obj, LV_HOR_RES / 2, LV_VER_RES - 4);
+    lv_obj_set_pos(obj, LV_HOR_RES / 4, 2);
+
+    lv_obj_invalidate(lv_scr_act());
+    refr_px();
+    uint32_t ref_hash = shadow_hash();
+    memset(shadow_fb, 0, sizeof(shadow_fb));
+
+    static lv_disp_buf_t ring_buf;
+    static lv_color_t ring_mem[RING_CNT][LV_HOR_RES_MAX * RING_BAND_ROWS];
+    void * bufs[RING_CNT];
+    uint32_t i;
+    for(i = 0; i < RING_CNT; i++) bufs[i] = ring_mem[i];
+    lv_disp_buf_init_ring(&ring_buf, bufs, RING_CNT, LV_HOR_RES_MAX * RING_BAND_ROWS);
+
+    lv_disp_buf_t * disp_buf = disp->driver.buffer;
+    void (*flush_cb)(lv_disp_drv_t *, const lv_area_t *, lv_color_t *) = disp->driver.flush_cb;
+    disp->driver.buffer = &ring_buf;
+    disp->driver.flush_cb = ring_flush_cb;
+    disp->driver.wait_cb = ring_release;
+    ring_pending = 0;
+    ring_pending_max = 0;
+    ring_band_cnt = 0;
+    ring_in_order = true;
+    ring_next = NULL;
+
+    lv_obj_invalidate(lv_scr_act());
+    lv_refr_now(disp);
+    uint32_t pending_end = ring_pending;
+    while(ring_pending) ring_release(&disp->driver);
+
+    disp->driver.buffer = disp_buf;
+    disp->driver.flush_cb = flush_cb;
+    disp->driver.wait_cb = NULL;
+    lv_obj_del(obj);
+
+    lv_test_print("%d bands, %d flushing at most, %d still flushing after the refresh", ring_band_cnt, ring_pending_max,
+                  pending_end);
+    lv_test_assert_true(ring_band_cnt > RING_CNT, "Buffers reused");
+    lv_test_assert_true(ring_in_order, "Buffers used in ring order");
+    lv_test_assert_int_eq(RING_CNT, ring_pending_max, "Every buffer flushing while drawing");
+    lv_test_assert_true(pending_end > 0, "Refresh not waiting for the last bands");
+    uint32_t flushing = 0;
+    for(i = 0; i < RING_CNT; i++) flushing += ring_buf.ring_flushing[i];
+    lv_test_assert_int_eq(0, flushing, "Every buffer released");
+    lv_test_assert_int_eq(ref_hash, shadow_hash(), "Same screen as with a single buffer");
+}
+
+#if LV_MEM_CUSTOM || LV_MEM_SIZE >= (32U * 1024U)
+/**
+ * Pixels of the tiles touched by an area: redrawn at most for it once the buffer overflowed
+ * @param area an area on the screen
+ * @return pixel count, the area itself without tiles
+ */
+static uint32_t tile_px(const lv_area_t * area)
+{
+#if LV_INV_TILE_SIZE
+    uint32_t w = (area->x2 / LV_INV_TILE_SIZE - area->x1 / LV_INV_TILE_SIZE + 1) * LV_INV_TILE_SIZE;
+    uint32_t h = (area->y2 / LV_INV_TILE_SIZE - area->y1 / LV_INV_TILE_SIZE + 1) * LV_INV_TILE_SIZE;
+    return w * h;
+#else
+    return lv_area_get_size(area);
+#endif
+}
+
+/**
+ * A grid of small value cells, some of them changing color every frame.
+ * Compare the pixels redrawn with the pixels changed, and with redrawing the screen
+ * as it happened without tile map once LV_INV_BUF_SIZE areas were invalidated.
+ */
+static void dashboard_bench(void)
+{
+    static const uint32_t update_cnt[] = {8, 24, 64, CELL_COLS * CELL_ROWS};
+    lv_coord_t hres = LV_HOR_RES;
+    lv_coord_t vres = LV_VER_RES;
+    uint32_t screen_px = (uint32_t)hres * vres;
+
+    lv_test_print("");
+    lv_test_print("Dashboard of %dx%d cells", CELL_COLS, CELL_ROWS);
+    lv_test_print("---------------------------");
+
+    lv_obj_t * cells[CELL_COLS * CELL_ROWS];
+    uint8_t order[CELL_COLS * CELL_ROWS];
+    uint8_t color_idx[CELL_COLS * CELL_ROWS];
+    lv_coord_t cell_w = hres / CELL_COLS;
+    lv_coord_t cell_h = vres / CELL_ROWS;
+    uint32_t i;
+    for(i = 0; i < CELL_COLS * CELL_ROWS; i++) {
+        cells[i] = lv_obj_create(lv_scr_act(), NULL);
+        lv_obj_reset_style_list(cells[i], LV_OBJ_PART_MAIN);
+        lv_obj_set_style_local_bg_opa(cells[i], LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, LV_OPA_COVER);
+        lv_obj_set_style_local_bg_color(cells[i], LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, LV_COLOR_BLUE);
+        /*A value field in the middle of the cell*/
+        lv_obj_set_size(cells[i], cell_w / 2, cell_h / 3);
+        lv_obj_set_pos(cells[i], (i % CELL_COLS) * cell_w + cell_w / 4, (i / CELL_COLS) * cell_h + cell_h / 3);
+        order[i] = (uint8_t)i;
+        color_idx[i] = 0;
+    }
+    refr_px();
+
+    uint32_t k;
+    for(k = 0; k < sizeof(update_cnt) / sizeof(update_cnt[0]); k++) {
+        uint32_t inv_px = 0;
+        uint32_t inv_tile_px = 0;
+        uint32_t changed_px = 0;
+        uint32_t redrawn_px = 0;
+        uint32_t frame;
+        for(frame = 0; frame < BENCH_FRAMES; frame++) {
+            memcpy(prev_fb, shadow_fb, sizeof(prev_fb));
+            /*Update the first cells of a shuffled order*/
+            for(i = 0; i < update_cnt[k]; i++) {
+                uint32_t j = i + rand_next() % (CELL_COLS * CELL_ROWS - i);
+                uint8_t tmp = order[i];
+                order[i] = order[j];
+                order[j] = tmp;
+                lv_obj_t * cell = cells[order[i]];
+                color_idx[order[i]] ^= 1;
+                lv_obj_set_style_local_bg_color(cell, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT,
+                                                color_idx[order[i]] ? LV_COLOR_RED : LV_COLOR_BLUE);
+                lv_area_t area;
+                lv_obj_get_coords(cell, &area);
+                inv_px += lv_area_get_size(&area);
+                inv_tile_px += tile_px(&area);
+            }
+            redrawn_px += refr_px();
+            uint32_t p;
+            for(p = 0; p < screen_px; p++) {
+                changed_px += memcmp(&prev_fb[p], &shadow_fb[p], sizeof(lv_color_t)) != 0;
+            }
+        }
+        uint32_t old_px = update_cnt[k] > LV_INV_BUF_SIZE ? screen_px : inv_px / BENCH_FRAMES;
+        lv_test_print("%d cells/frame: %d px changed, %d invalidated, %d redrawn (was %d)", update_cnt[k],
+                      changed_px / BENCH_FRAMES, inv_px / BENCH_FRAMES, redrawn_px / BENCH_FRAMES, old_px);
+        lv_test_assert_true(redrawn_px <= inv_tile_px, "Redrawn at most the tiles of the invalidated cells");
+        lv_test_assert_true(redrawn_px >= changed_px, "Every changed pixel redrawn");
+        if(update_cnt[k] > LV_INV_BUF_SIZE && update_cnt[k] < CELL_COLS * CELL_ROWS) {
+            lv_test_assert_true(redrawn_px / BENCH_FRAMES < screen_px / 2, "No full screen redraw on overflow");
+        }
+    }
+
+    /*The incremental frames add up to the same screen as a full redraw*/
+    memcpy(prev_fb, shadow_fb, sizeof(prev_fb));
+    lv_obj_invalidate(lv_scr_act());
+    refr_px();
+    lv_test_assert_true(memcmp(prev_fb, shadow_fb, screen_px * sizeof(lv_color_t)) == 0,
+                        "Same screen as a full redraw");
+
+    for(i = 0; i < CELL_COLS * CELL_ROWS; i++) {
+        lv_obj_del(cells[i]);
+    }
+}
+
+/**
+ * An opaque window with a title bar and some content
+ * @param parent parent of the window
+ * @param x, y, w, h position and size of the window
+ * @param seed varies the colors
+ * @return the window
+ */
+static lv_obj_t * panel_create(lv_obj_t * parent, lv_coord_t x, lv_coord_t y, lv_coord_t w, lv_coord_t h, uint32_t seed)
+{
+    lv_obj_t * win = lv_obj_create(parent, NULL);
+    lv_obj_set_pos(win, x, y);
+    lv_obj_set_size(win, w, h);
+    lv_obj_set_style_local_bg_opa(win, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, LV_OPA_COVER);
+    lv_obj_set_style_local_bg_color(win, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, lv_color_hex(0x404040 + seed * 0x102030));
+    lv_obj_set_style_local_radius(win, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, 6);
+    lv_obj_set_style_local_border_width(win, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, 1);
+
+    lv_obj_t * title = lv_obj_create(win, NULL);
+    lv_obj_set_pos(title, 0, 0);
+    lv_obj_set_size(title, w, h / 6);
+    lv_obj_set_style_local_bg_opa(title, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, LV_OPA_COVER);
+    lv_obj_set_style_local_radius(title, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, 0);
+
+    /*A 2x2 grid of controls*/
+    uint32_t i;
+    for(i = 0; i < 4; i++) {
+        lv_obj_t * item = lv_obj_create(win, NULL);
+        lv_obj_set_size(item, w / 3, h / 4);
+        lv_obj_set_pos(item, w / 9 + (i % 2) * (w * 4 / 9), h / 4 + (i / 2) * (h * 5 / 16));
+        lv_obj_set_style_local_bg_color(item, LV_OBJ_PART_MAIN, LV_STATE_DEFAULT,
+                                        lv_color_hex(0x2060A0 + (seed + i) * 0x0A1408));
+#if LV_USE_LABEL
+        lv_obj_t * label = lv_label_create(item, NULL);
+        lv_label_set_text(label, "Value");
+#endif
+    }
+
+    return win;
+}
+
+/**
+ * Overlapping windows and stacked tabs: draw the screen with and without skipping the hidden
+ * objects and parts. Compare the draw calls and the blended pixels.
+ */
+static void overlap_bench(void)
+{
+    lv_coord_t hres = LV_HOR_RES;
+    lv_coord_t vres = LV_VER_RES;
+    uint32_t screen_px = (uint32_t)hres * vres;
+
+    lv_test_print("");
+    lv_test_print("%d overlapping windows on %d stacked tabs", WIN_CNT, TAB_CNT);
+    lv_test_print("---------------------------");
+
+    /*Tabs on each other below a header: only the last one is visible*/
+    lv_obj_t * tabs[TAB_CNT];
+    uint32_t i;
+    for(i = 0; i < TAB_CNT; i++) {
+        tabs[i] = panel_create(lv_scr_act(), 0, vres / 8, hres, vres - vres / 8, i);
+        lv_obj_set_style_local_radius(tabs[i], LV_OBJ_PART_MAIN, LV_STATE_DEFAULT, 0);
+    }
+
+    /*Cascaded windows on the visible tab*/
+    lv_coord_t step_x = hres / (2 * WIN_CNT);
+    lv_coord_t step_y = vres / (2 * WIN_CNT);
+    for(i = 0; i < WIN_CNT; i++) {
+        panel_create(tabs[TAB_CNT - 1], i * step_x, i * step_y, hres / 2, vres / 2, i + TAB_CNT);
+    }
+
+    lv_refr_stat_t stat[2];
+    uint32_t overdraw[2];
+    uint32_t k;
+    for(k = 0; k < 2; k++) {
+        memcpy(prev_fb, shadow_fb, sizeof(prev_fb));
+        lv_refr_set_occlusion(k == 1);
+        lv_obj_invalidate(lv_scr_act());
+        lv_refr_reset_stat();
+        refr_px();
+        lv_refr_get_stat(&stat[k]);
+        overdraw[k] = lv_refr_get_overdraw();
+        lv_test_print("Occlusion %s: %d draw calls, %d px blended, overdraw %d%%, %d culled, %d split",
+                      k ? "on" : "off", stat[k].draw_cnt, stat[k].blend_px_cnt, overdraw[k],
+                      stat[k].cull_cnt, stat[k].split_cnt);
+    }
+    lv_refr_set_occlusion(true);
+
+    lv_test_assert_true(memcmp(prev_fb, shadow_fb, screen_px * sizeof(lv_color_t)) == 0,
+                        "Same screen with occlusion culling");
+    lv_test_assert_int_eq(screen_px, stat[1].px_cnt, "Every pixel refreshed");
+#if LV_REFR_OCCLUDER_MAX
+    lv_test_assert_true(stat[1].cull_cnt > 0, "Hidden objects skipped");
+    lv_test_assert_true(stat[1].draw_cnt < stat[0].draw_cnt, "Less draw calls");
+    lv_test_assert_true(overdraw[1] < overdraw[0], "Less overdraw");
+#endif
+
+    for(i = 0; i < TAB_CNT; i++) {
+        lv_obj_del(tabs[i]);
+    }
+}
+#endif
+
+#endif
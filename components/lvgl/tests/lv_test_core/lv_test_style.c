@@ -33,6 +33,7 @@ static void mem_leak(void);
 /**********************
  *  STATIC VARIABLES
  **********************/
+static lv_font_t dummy_font[2];     /*Distinct font pointers, never drawn*/
 
 /**********************
  *      MACROS
@@ -215,7 +216,7 @@ static void cascade(void)
 
     _lv_style_set_int(&style_second, LV_STYLE_TEXT_LINE_SPACE, 10);
     _lv_style_set_opa(&style_second, LV_STYLE_BG_OPA, LV_OPA_60);
-    _lv_style_set_ptr(&style_second, LV_STYLE_TEXT_FONT, LV_THEME_DEFAULT_FONT_NORMAL + 1);
+    _lv_style_set_ptr(&style_second, LV_STYLE_TEXT_FONT, &dummy_font[0]);
     _lv_style_set_color(&style_second, LV_STYLE_BG_COLOR, LV_COLOR_BLUE);
 
     found = _lv_style_list_get_int(&style_list, LV_STYLE_TEXT_LINE_SPACE, &value);
@@ -228,7 +229,7 @@ static void cascade(void)
 
     found = _lv_style_list_get_ptr(&style_list, LV_STYLE_TEXT_FONT, &ptr);
     lv_test_assert_int_eq(LV_RES_OK, found, "Get an overwritten 'ptr' property");
-    lv_test_assert_ptr_eq(LV_THEME_DEFAULT_FONT_NORMAL + 1, ptr, "Get the value of an overwritten 'ptr' property");
+    lv_test_assert_ptr_eq(&dummy_font[0], ptr, "Get the value of an overwritten 'ptr' property");
 
     found = _lv_style_list_get_color(&style_list, LV_STYLE_BG_COLOR, &color);
     lv_test_assert_int_eq(LV_RES_OK, found, "Get an overwritten 'color' property");
@@ -237,7 +238,7 @@ static void cascade(void)
     lv_test_print("Overwrite the properties with the local style");
     _lv_style_list_set_local_int(&style_list, LV_STYLE_TEXT_LINE_SPACE, 20);
     _lv_style_list_set_local_opa(&style_list, LV_STYLE_BG_OPA, LV_OPA_70);
-    _lv_style_list_set_local_ptr(&style_list, LV_STYLE_TEXT_FONT, LV_THEME_DEFAULT_FONT_NORMAL + 2);
+    _lv_style_list_set_local_ptr(&style_list, LV_STYLE_TEXT_FONT, &dummy_font[1]);
     _lv_style_list_set_local_color(&style_list, LV_STYLE_BG_COLOR, LV_COLOR_LIME);
 
     found = _lv_style_list_get_int(&style_list, LV_STYLE_TEXT_LINE_SPACE, &value);
@@ -250,7 +251,7 @@ static void cascade(void)
 
     found = _lv_style_list_get_ptr(&style_list, LV_STYLE_TEXT_FONT, &ptr);
     lv_test_assert_int_eq(LV_RES_OK, found, "Get a local 'ptr' property");
-    lv_test_assert_ptr_eq(LV_THEME_DEFAULT_FONT_NORMAL + 2, ptr, "Get the value of a local'ptr' property");
+    lv_test_assert_ptr_eq(&dummy_font[1], ptr, "Get the value of a local'ptr' property");
 
     found = _lv_style_list_get_color(&style_list, LV_STYLE_BG_COLOR, &color);
     lv_test_assert_int_eq(LV_RES_OK, found, "Get a local 'color' property");
@@ -0,0 +1,32 @@
+/**
+ * @file lv_test_ex_conf.h
+ * lv_examples configuration of the headless benchmark (lv_bench_main.c)
+ */
+
+#ifndef LV_TEST_EX_CONF_H
+#define LV_TEST_EX_CONF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#define LV_EX_PRINTF       0
+#define LV_EX_KEYBOARD     0
+#define LV_EX_MOUSEWHEEL   0
+
+#define LV_USE_DEMO_WIDGETS             0
+#define LV_USE_DEMO_PRINTER             0
+#define LV_USE_DEMO_KEYPAD_AND_ENCODER  0
+#define LV_USE_DEMO_BENCHMARK           1
+#define LV_USE_DEMO_STRESS              1
+#define LV_USE_DEMO_MUSIC               0
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /*LV_TEST_EX_CONF_H*/
@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include "lv_test_core/lv_test_core.h"
 #include "lv_test_widgets/lv_test_label.h"
+#include "lv_test_widgets/lv_test_table.h"
 
 #if LV_BUILD_TEST
 #include <sys/time.h>
@@ -11,6 +12,7 @@ static void hal_init(void);
 static void dummy_flush_cb(lv_disp_drv_t * disp_drv, const lv_area_t * area, lv_color_t * color_p);
 
 lv_color_t test_fb[LV_HOR_RES_MAX * LV_VER_RES_MAX];
+uint32_t test_flush_px;
 
 int main(void)
 {
@@ -21,6 +23,7 @@ int main(void)
 
     lv_test_core();
     lv_test_label();
+    lv_test_table();
 
     printf("Exit with success!\n");
     return 0;
@@ -120,6 +123,7 @@ static void dummy_flush_cb(lv_disp_drv_t * disp_drv, const lv_area_t * area, lv_
     LV_UNUSED(color_p);
 
     memcpy(test_fb, color_p, lv_area_get_size(area) * sizeof(lv_color_t));
+    test_flush_px += lv_area_get_size(area);
 
     lv_disp_flush_ready(disp_drv);
 }
@@ -142,4 +146,11 @@ uint32_t custom_tick_get(void)
     return time_ms;
 }
 
+uint32_t custom_time_us(void)
+{
+    struct timeval tv_now;
+    gettimeofday(&tv_now, NULL);
+    return (uint32_t)(tv_now.tv_sec * 1000000 + tv_now.tv_usec);
+}
+
 #endif
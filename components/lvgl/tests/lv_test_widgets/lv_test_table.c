@@ -0,0 +1,185 @@
+/**
+ * @file lv_test_table.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "../../lvgl.h"
+#include "../lv_test_assert.h"
+#include "lv_test_table.h"
+
+#if LV_BUILD_TEST
+
+/*********************
+ *      DEFINES
+ *********************/
+#define SENSOR_CNT      50
+#define COL_CNT         5
+#define CHART_POINTS    60
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+#if LV_USE_TABLE && LV_USE_CHART
+static uint32_t refr_px(void);
+static void cell_update(void);
+#if LV_MEM_CUSTOM || LV_MEM_SIZE >= (32U * 1024U)
+static void dashboard_bench(void);
+#endif
+#endif
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+void lv_test_table(void)
+{
+    lv_test_print("");
+    lv_test_print("===================");
+    lv_test_print("Start lv_table tests");
+    lv_test_print("===================");
+
+#if LV_USE_TABLE && LV_USE_CHART
+    cell_update();
+#if LV_MEM_CUSTOM == 0 && LV_MEM_SIZE < (32U * 1024U)
+    lv_test_print("Skip dashboard benchmark: LV_MEM_SIZE < 32 kB");
+#else
+    dashboard_bench();
+#endif
+#else
+    lv_test_print("Skip table test: LV_USE_TABLE == 0 or LV_USE_CHART == 0");
+#endif
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+#if LV_USE_TABLE && LV_USE_CHART
+/**
+ * Refresh the screen now
+ * @return pixels passed to the (dummy) flush callback
+ */
+static uint32_t refr_px(void)
+{
+    extern uint32_t test_flush_px;
+    test_flush_px = 0;
+    lv_refr_now(NULL);
+    return test_flush_px;
+}
+
+static void cell_update(void)
+{
+    lv_test_print("");
+    lv_test_print("Set the value of a cell");
+    lv_test_print("---------------------------");
+
+    lv_obj_t * table = lv_table_create(lv_scr_act(), NULL);
+    lv_table_set_col_cnt(table, 2);
+    lv_table_set_col_width(table, 0, 60);
+    lv_table_set_col_width(table, 1, 60);
+    lv_table_set_cell_value(table, 0, 0, "a");
+    lv_table_set_cell_value(table, 1, 1, "b");
+    lv_coord_t h = lv_obj_get_height(table);
+    refr_px();
+
+    lv_table_set_cell_value(table, 1, 1, "c");
+    lv_coord_t row_h = (lv_obj_get_height(table) - 1) / 2;
+    uint32_t px = refr_px();
+    lv_test_assert_int_eq(h, lv_obj_get_height(table), "Same height with same line count");
+    lv_test_assert_true(px > 0 && px <= (uint32_t)(60 * row_h), "Only the cell is redrawn");
+
+    lv_table_set_cell_value(table, 1, 1, "c\nd");
+    lv_test_assert_int_gt(h, lv_obj_get_height(table), "Taller row with two lines");
+    lv_test_assert_int_gt(60 * row_h, refr_px(), "Whole table is redrawn when the row grows");
+
+    lv_table_set_cell_merge_right(table, 0, 0, true);
+    refr_px();
+    lv_table_set_cell_value(table, 0, 0, "merged");
+    lv_test_assert_int_gt(60 * row_h, refr_px(), "Whole row is redrawn for a merged cell");
+
+    lv_obj_del(table);
+}
+
+#if LV_MEM_CUSTOM || LV_MEM_SIZE >= (32U * 1024U)
+/**
+ * A sensor dashboard: chart of the selected sensor above a table of sensors.
+ * Compare the pixels redrawn for a new sample with redrawing the whole table.
+ */
+static void dashboard_bench(void)
+{
+    lv_test_print("");
+    lv_test_print("Dashboard with %d sensors", SENSOR_CNT);
+    lv_test_print("---------------------------");
+
+    lv_obj_t * page = lv_page_create(lv_scr_act(), NULL);
+    lv_obj_set_size(page, LV_HOR_RES, LV_VER_RES);
+    lv_page_set_scrl_layout(page, LV_LAYOUT_COLUMN_LEFT);
+
+    lv_obj_t * chart = lv_chart_create(page, NULL);
+    lv_obj_set_size(chart, LV_HOR_RES - 40, LV_VER_RES / 3);
+    lv_chart_set_type(chart, LV_CHART_TYPE_LINE);
+    lv_chart_set_point_count(chart, CHART_POINTS);
+    lv_chart_set_update_mode(chart, LV_CHART_UPDATE_MODE_CIRCULAR);
+    lv_chart_set_range(chart, 0, 400);
+    lv_chart_series_t * ser = lv_chart_add_series(chart, LV_COLOR_RED);
+
+    lv_obj_t * table = lv_table_create(page, NULL);
+    lv_table_set_col_cnt(table, COL_CNT);
+    lv_coord_t col_w = (LV_HOR_RES - 40) / COL_CNT;
+    uint16_t row, col;
+    for(col = 0; col < COL_CNT; col++) {
+        lv_table_set_col_width(table, col, col_w);
+    }
+    for(row = 0; row <= SENSOR_CNT; row++) {
+        for(col = 0; col < COL_CNT; col++) {
+            lv_table_set_cell_value_fmt(table, row, col, "%d", row * 10 + col);
+        }
+    }
+    refr_px();
+
+    uint32_t cell_px = 0;
+    uint32_t chart_px = 0;
+    uint32_t cell_max = 0;
+    uint32_t cell_visible = 0;      /*Updates of rows scrolled out are clipped away*/
+    for(row = 1; row <= SENSOR_CNT; row++) {
+        lv_table_set_cell_value_fmt(table, row, 1, "%d.%d", 20 + row % 10, row % 7);
+        uint32_t px = refr_px();
+        cell_px += px;
+        cell_max = LV_MATH_MAX(cell_max, px);
+        if(px > 0) cell_visible++;
+        lv_chart_set_next(chart, ser, 200 + row);
+        chart_px += refr_px();
+    }
+    lv_obj_invalidate(table);
+    uint32_t table_px = refr_px();
+    lv_obj_invalidate(chart);
+    uint32_t chart_full_px = refr_px();
+
+    lv_test_print("Pixels redrawn per update: cell %d (%d visible rows), chart point %d",
+                  cell_visible ? cell_px / cell_visible : 0, cell_visible, chart_px / SENSOR_CNT);
+    lv_test_print("Pixels redrawn for the whole table %d, chart %d", table_px, chart_full_px);
+    lv_test_assert_true(cell_max <= (uint32_t)col_w * lv_obj_get_height(table) / (SENSOR_CNT + 1),
+                        "Cell update redraws at most one cell");
+    lv_test_assert_true(chart_px / SENSOR_CNT < chart_full_px / 4, "Chart point redraws a strip of the chart");
+
+    lv_obj_del(page);
+}
+#endif
+#endif
+
+#endif
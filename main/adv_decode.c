@@ -0,0 +1,422 @@
+#include <string.h>
+
+#include "adv_decode.h"
+
+/* DEFINES */
+#define UUID_ENV_SENSING    0x181A  /* ATC1441 / pvvx custom firmware */
+#define UUID_BTHOME         0xFCD2
+#define COMPANY_RUUVI       0x0499
+
+#define BTHOME_VER_MASK     0xE0
+#define BTHOME_VER_2        0x40
+#define BTHOME_ENCRYPTED    0x01
+
+#define RUUVI_RAWV2         0x05    /* data format 5 */
+#define RUUVI_INVALID       0x80    /* first byte of 0x8000, value not available */
+
+/* field readers, offset into payload */
+#define RD_U8(d, o)         ((int32_t)(d)[o])
+#define RD_S16LE(d, o)      ((int32_t)(int16_t)((d)[o] | ((d)[(o) + 1] << 8)))
+#define RD_U16LE(d, o)      ((int32_t)((d)[o] | ((d)[(o) + 1] << 8)))
+#define RD_S16BE(d, o)      ((int32_t)(int16_t)(((d)[o] << 8) | (d)[(o) + 1]))
+#define RD_U16BE(d, o)      ((int32_t)(((d)[o] << 8) | (d)[(o) + 1]))
+
+/*
+ * Fixed layouts: one F(member, flag, offset, reader, mul, div) per field, value = reader * mul / div.
+ * FIXED_DECODER expands a layout into a decode function with constant offsets,
+ * payload length is checked by min_len of the table entry.
+ */
+#define LAYOUT_ATC1441(F) \
+    F(temp_centi,  ADV_HAS_TEMP,    6,  S16BE, 10,  1) \
+    F(humid_centi, ADV_HAS_HUMID,   8,  U8,    100, 1) \
+    F(batt_pct,    ADV_HAS_BATT,    9,  U8,    1,   1) \
+    F(counter,     ADV_HAS_COUNTER, 12, U8,    1,   1)
+#define LAYOUT_PVVX(F) \
+    F(temp_centi,  ADV_HAS_TEMP,    6,  S16LE, 1,   1) \
+    F(humid_centi, ADV_HAS_HUMID,   8,  U16LE, 1,   1) \
+    F(batt_pct,    ADV_HAS_BATT,    12, U8,    1,   1) \
+    F(counter,     ADV_HAS_COUNTER, 13, U8,    1,   1)
+#define LAYOUT_RUUVI(F) \
+    F(temp_centi,  ADV_HAS_TEMP,    1,  S16BE, 1,   2) \
+    F(humid_centi, ADV_HAS_HUMID,   3,  U16BE, 1,   4) \
+    F(counter,     ADV_HAS_COUNTER, 17, U8,    1,   1)
+#define LAYOUT_LYWSD03MMC(F) \
+    F(temp_centi,  ADV_HAS_TEMP,    0,  S16LE, 1,   1) \
+    F(humid_centi, ADV_HAS_HUMID,   2,  U8,    100, 1)
+
+#define FIELD_DECODE(member, flag, off, rd, mul, div) \
+    reading->member = RD_##rd(data, off) * (mul) / (div); \
+    reading->flags |= (flag);
+#define FIXED_DECODER(fcn, layout, valid) \
+    static bool fcn(const uint8_t *data, uint8_t len, adv_reading_t *reading) { \
+        (void)len; \
+        if (!(valid)) { \
+            return false; \
+        } \
+        reading->flags = 0; \
+        layout(FIELD_DECODE) \
+        return true; \
+    }
+
+/* STATIC PROTOTYPES */
+static bool decode_atc1441(const uint8_t *data, uint8_t len, adv_reading_t *reading);
+static bool decode_pvvx(const uint8_t *data, uint8_t len, adv_reading_t *reading);
+static bool decode_ruuvi(const uint8_t *data, uint8_t len, adv_reading_t *reading);
+static bool decode_lywsd03mmc(const uint8_t *data, uint8_t len, adv_reading_t *reading);
+static bool decode_bthome(const uint8_t *data, uint8_t len, adv_reading_t *reading);
+static uint32_t bda_hash(const uint8_t *bda);
+
+/* STATIC VARIABLES */
+static adv_decoder_t decoder_tab[ADV_DECODER_MAX];
+static int decoder_num = 0;
+
+static adv_dev_t dev_tab[ADV_DEV_MAX];
+static int dev_num = 0;
+static uint32_t dev_overflow = 0;
+
+/* built-in decoders, checked in order */
+static const adv_decoder_t builtin_decoders[] = {
+    {"ATC1441", ADV_KEY_SERVICE_DATA, UUID_ENV_SENSING, 13, 13,  decode_atc1441},
+    {"pvvx",    ADV_KEY_SERVICE_DATA, UUID_ENV_SENSING, 15, 15,  decode_pvvx},
+    {"BTHome",  ADV_KEY_SERVICE_DATA, UUID_BTHOME,      1,  255, decode_bthome},
+    {"Ruuvi",   ADV_KEY_MANUFACTURER, COMPANY_RUUVI,    24, 24,  decode_ruuvi},
+};
+
+/* sensor types connected to, matched by advertised name */
+static const adv_gatt_t gatt_tab[] = {
+    {"LYWSD03MMC", 10,
+     {0xA6, 0xA3, 0x7D, 0x99, 0xF2, 0x6F, 0x1A, 0x8A, 0x0C, 0x4B, 0x0A, 0x7A, 0xB0, 0xCC, 0xE0, 0xEB},
+     {0xA6, 0xA3, 0x7D, 0x99, 0xF2, 0x6F, 0x1A, 0x8A, 0x0C, 0x4B, 0x0A, 0x7A, 0xC1, 0xCC, 0xE0, 0xEB},
+     3, 255, decode_lywsd03mmc},
+};
+
+/* ATC1441 format: MAC[6], temp int16 BE 0.1 degC, humid %, batt %, batt mV[2], counter */
+FIXED_DECODER(decode_atc1441, LAYOUT_ATC1441, true)
+
+/* pvvx format: MAC[6] LE, temp int16 LE 0.01 degC, humid uint16 LE 0.01 %, batt mV[2], batt %, counter, flags */
+FIXED_DECODER(decode_pvvx, LAYOUT_PVVX, true)
+
+/* Ruuvi RAWv2: format, temp int16 BE 0.005 degC, humid uint16 BE 0.0025 %, pressure, acceleration, power, movement, sequence[2], MAC[6] */
+FIXED_DECODER(decode_ruuvi, LAYOUT_RUUVI, data[0] == RUUVI_RAWV2 && data[1] != RUUVI_INVALID)
+
+/* LYWSD03MMC notification: temp int16 LE 0.01 degC, humid %, batt mV[2] */
+FIXED_DECODER(decode_lywsd03mmc, LAYOUT_LYWSD03MMC, true)
+
+/**
+ * @brief BTHome v2 unencrypted: device info byte, then object id + value pairs
+ *
+ * @param data
+ * @param len
+ * @param reading
+ * @return true if at least one value decoded
+ */
+static bool decode_bthome(const uint8_t *data, uint8_t len, adv_reading_t *reading) {
+    if ((data[0] & BTHOME_VER_MASK) != BTHOME_VER_2 || (data[0] & BTHOME_ENCRYPTED)) {
+        return false;
+    }
+    reading->flags = 0;
+    uint8_t pos = 1;
+    while (pos < len) {
+        uint8_t id = data[pos++];
+        uint8_t size;
+        /* object size by id, parsing stops at first unknown id */
+        switch (id) {
+        case 0x00: case 0x01: case 0x2E:
+            size = 1;
+            break;
+        case 0x02: case 0x03: case 0x0C: case 0x45:
+            size = 2;
+            break;
+        case 0x04: case 0x05:
+            size = 3;
+            break;
+        default:
+            return reading->flags != 0;
+        }
+        if (pos + size > len) {
+            break;
+        }
+        const uint8_t *v = &data[pos];
+        switch (id) {
+        case 0x00:  /* packet id */
+            reading->counter = v[0];
+            reading->flags |= ADV_HAS_COUNTER;
+            break;
+        case 0x01:  /* battery % */
+            reading->batt_pct = v[0];
+            reading->flags |= ADV_HAS_BATT;
+            break;
+        case 0x02:  /* temperature 0.01 degC */
+            reading->temp_centi = (int16_t)(v[0] | (v[1] << 8));
+            reading->flags |= ADV_HAS_TEMP;
+            break;
+        case 0x45:  /* temperature 0.1 degC */
+            reading->temp_centi = (int16_t)((int16_t)(v[0] | (v[1] << 8)) * 10);
+            reading->flags |= ADV_HAS_TEMP;
+            break;
+        case 0x03:  /* humidity 0.01 % */
+            reading->humid_centi = (uint16_t)(v[0] | (v[1] << 8));
+            reading->flags |= ADV_HAS_HUMID;
+            break;
+        case 0x2E:  /* humidity 1 % */
+            reading->humid_centi = (uint16_t)(v[0] * 100);
+            reading->flags |= ADV_HAS_HUMID;
+            break;
+        default:
+            break;
+        }
+        pos = (uint8_t)(pos + size);
+    }
+    return reading->flags != 0;
+}
+
+/**
+ * @brief hash of device address for dev_tab lookup
+ *
+ * @param bda
+ * @return hash value
+ */
+static uint32_t bda_hash(const uint8_t *bda) {
+    /* FNV-1a */
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < ADV_BDA_LEN; i++) {
+        hash = (hash ^ bda[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief reset decoder table to built-in decoders and clear device table
+ *
+ */
+void adv_decode_init(void) {
+    decoder_num = 0;
+    for (unsigned i = 0; i < sizeof(builtin_decoders) / sizeof(builtin_decoders[0]); i++) {
+        adv_decoder_register(&builtin_decoders[i]);
+    }
+    memset(dev_tab, 0, sizeof(dev_tab));
+    dev_num = 0;
+    dev_overflow = 0;
+}
+
+/**
+ * @brief add a decoder, checked after the ones already registered
+ *
+ * @param decoder
+ * @return decoder index or -1 if table is full
+ */
+int adv_decoder_register(const adv_decoder_t *decoder) {
+    if (decoder_num >= ADV_DECODER_MAX) {
+        return -1;
+    }
+    decoder_tab[decoder_num] = *decoder;
+    return decoder_num++;
+}
+
+/**
+ * @brief get decoder by index
+ *
+ * @param idx
+ * @return decoder or NULL
+ */
+const adv_decoder_t *adv_decoder_get(int idx) {
+    if (idx < 0 || idx >= decoder_num) {
+        return NULL;
+    }
+    return &decoder_tab[idx];
+}
+
+/**
+ * @brief walk AD structures of advertisement (+ scan response) and decode the first known service or manufacturer data
+ *
+ * @param adv raw advertising data
+ * @param adv_len
+ * @param reading [out] decoded values
+ * @return decoder index or -1 if nothing decoded
+ */
+int adv_decode(const uint8_t *adv, uint8_t adv_len, adv_reading_t *reading) {
+    uint8_t pos = 0;
+    while (pos + 1 < adv_len) {
+        uint8_t ad_len = adv[pos];
+        if (ad_len == 0 || pos + 1 + ad_len > adv_len) {
+            break;
+        }
+        const uint8_t *ad = &adv[pos + 1];
+        int key = (ad[0] == ADV_TYPE_SERVICE_DATA_16) ? ADV_KEY_SERVICE_DATA :
+                  (ad[0] == ADV_TYPE_MANUFACTURER) ? ADV_KEY_MANUFACTURER : -1;
+        if (key >= 0 && ad_len >= 3) {
+            /* UUID and company ID are both 16-bit LE ahead of the payload */
+            uint16_t id = (uint16_t)(ad[1] | (ad[2] << 8));
+            uint8_t data_len = (uint8_t)(ad_len - 3);
+            for (int idx = 0; idx < decoder_num; idx++) {
+                const adv_decoder_t *dec = &decoder_tab[idx];
+                if (dec->id == id && dec->key == key && data_len >= dec->min_len && data_len <= dec->max_len) {
+                    memset(reading, 0, sizeof(adv_reading_t));
+                    if (dec->decode(&ad[3], data_len, reading)) {
+                        return idx;
+                    }
+                }
+            }
+        }
+        pos = (uint8_t)(pos + 1 + ad_len);
+    }
+    return -1;
+}
+
+/**
+ * @brief get GATT sensor type by index
+ *
+ * @param idx
+ * @return sensor type or NULL
+ */
+const adv_gatt_t *adv_gatt_get(int idx) {
+    if (idx < 0 || idx >= (int)(sizeof(gatt_tab) / sizeof(gatt_tab[0]))) {
+        return NULL;
+    }
+    return &gatt_tab[idx];
+}
+
+/**
+ * @brief find GATT sensor type by local name in advertisement, called per scan result not per sample
+ *
+ * @param adv raw advertising data
+ * @param adv_len
+ * @return sensor type index or -1 if no name matches
+ */
+int adv_gatt_match(const uint8_t *adv, uint8_t adv_len) {
+    uint8_t pos = 0;
+    while (pos + 1 < adv_len) {
+        uint8_t ad_len = adv[pos];
+        if (ad_len == 0 || pos + 1 + ad_len > adv_len) {
+            break;
+        }
+        const uint8_t *ad = &adv[pos + 1];
+        if (ad[0] == ADV_TYPE_NAME_CMPL || ad[0] == ADV_TYPE_NAME_SHORT) {
+            uint8_t name_len = (uint8_t)(ad_len - 1);
+            for (int idx = 0; idx < (int)(sizeof(gatt_tab) / sizeof(gatt_tab[0])); idx++) {
+                if (gatt_tab[idx].name_len == name_len && memcmp(&ad[1], gatt_tab[idx].name, name_len) == 0) {
+                    return idx;
+                }
+            }
+        }
+        pos = (uint8_t)(pos + 1 + ad_len);
+    }
+    return -1;
+}
+
+/**
+ * @brief decode notification of a connected sensor
+ *
+ * @param idx sensor type from adv_gatt_match
+ * @param data notified value
+ * @param len
+ * @param reading [out] decoded values
+ * @return true if decoded
+ */
+bool adv_gatt_decode(int idx, const uint8_t *data, uint16_t len, adv_reading_t *reading) {
+    const adv_gatt_t *gatt = adv_gatt_get(idx);
+    if (gatt == NULL || len < gatt->min_len || len > gatt->max_len) {
+        return false;
+    }
+    memset(reading, 0, sizeof(adv_reading_t));
+    return gatt->decode(data, (uint8_t)len, reading);
+}
+
+/**
+ * @brief store reading as last value of device, drop repeated adverts of the same frame
+ *
+ * @param bda advertiser address
+ * @param decoder index returned by adv_decode
+ * @param reading
+ * @param now_ms
+ * @param is_new [out] true if reading differs from last one
+ * @return device entry or NULL if table is full
+ */
+adv_dev_t *adv_dev_update(const uint8_t *bda, int decoder, const adv_reading_t *reading, uint32_t now_ms, bool *is_new) {
+    uint32_t idx = bda_hash(bda) & (ADV_DEV_MAX - 1);
+    adv_dev_t *dev = NULL;
+
+    *is_new = false;
+    /* linear probing, entries are never removed */
+    for (int probe = 0; probe < ADV_DEV_MAX; probe++) {
+        adv_dev_t *slot = &dev_tab[(idx + probe) & (ADV_DEV_MAX - 1)];
+        if (!slot->used) {
+            if (dev_num >= ADV_DEV_MAX * 3 / 4) {
+                /* keep probe length short */
+                dev_overflow++;
+                return NULL;
+            }
+            slot->used = 1;
+            memcpy(slot->bda, bda, ADV_BDA_LEN);
+            dev_num++;
+            dev = slot;
+            *is_new = true;
+            break;
+        }
+        if (memcmp(slot->bda, bda, ADV_BDA_LEN) == 0) {
+            dev = slot;
+            break;
+        }
+    }
+    if (dev == NULL) {
+        dev_overflow++;
+        return NULL;
+    }
+    dev->rx_count++;
+    if (!*is_new) {
+        if (reading->flags & ADV_HAS_COUNTER) {
+            *is_new = (dev->reading.counter != reading->counter) || !(dev->reading.flags & ADV_HAS_COUNTER);
+        } else {
+            *is_new = memcmp(&dev->reading, reading, sizeof(adv_reading_t)) != 0;
+        }
+    }
+    if (*is_new) {
+        dev->reading = *reading;
+        dev->decoder = (uint8_t)decoder;
+    } else {
+        dev->dup_count++;
+    }
+    dev->last_ms = now_ms;
+    return dev;
+}
+
+/**
+ * @brief get device entry by table index
+ *
+ * @param idx
+ * @return entry or NULL if unused
+ */
+adv_dev_t *adv_dev_get(int idx) {
+    if (idx < 0 || idx >= ADV_DEV_MAX || !dev_tab[idx].used) {
+        return NULL;
+    }
+    return &dev_tab[idx];
+}
+
+/**
+ * @brief get table index of device, used as device id
+ *
+ * @param dev
+ * @return index
+ */
+int adv_dev_index(const adv_dev_t *dev) {
+    return (int)(dev - dev_tab);
+}
+
+/**
+ * @brief number of devices in table
+ *
+ * @return count
+ */
+int adv_dev_count(void) {
+    return dev_num;
+}
+
+/**
+ * @brief number of adverts dropped because the table was full
+ *
+ * @return count
+ */
+uint32_t adv_dev_overflow(void) {
+    return dev_overflow;
+}
@@ -0,0 +1,88 @@
+#ifndef _ADV_DECODE_H_
+#define _ADV_DECODE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* DEFINES */
+#define ADV_DECODER_MAX     8       /* built-in + registered decoders */
+#define ADV_DEV_MAX         256     /* per-device table, power of 2 */
+#define ADV_BDA_LEN         6
+#define ADV_UUID128_LEN     16
+
+/* AD types carrying sensor values or naming a sensor type */
+#define ADV_TYPE_NAME_SHORT         0x08
+#define ADV_TYPE_NAME_CMPL          0x09
+#define ADV_TYPE_SERVICE_DATA_16    0x16
+#define ADV_TYPE_MANUFACTURER       0xFF
+
+/* valid fields of adv_reading_t */
+#define ADV_HAS_TEMP        0x01
+#define ADV_HAS_HUMID       0x02
+#define ADV_HAS_BATT        0x04
+#define ADV_HAS_COUNTER     0x08
+
+/* TYPE DEFINITIONS */
+/* sensor values decoded from one advertisement */
+typedef struct adv_reading_t {
+    int16_t temp_centi;     /* 0.01 degC */
+    uint16_t humid_centi;   /* 0.01 %RH */
+    uint8_t batt_pct;
+    uint8_t counter;        /* frame counter sent by device, used for dedup */
+    uint8_t flags;          /* ADV_HAS_x */
+} adv_reading_t;
+
+/* AD structure a decoder is keyed by */
+typedef enum {
+    ADV_KEY_SERVICE_DATA = 0,   /* 16-bit service data, id is the service UUID */
+    ADV_KEY_MANUFACTURER,       /* manufacturer specific data, id is the company ID */
+} adv_key_t;
+
+/* decoder for one payload layout, payload excludes the UUID or company ID */
+typedef bool (*adv_decode_fcn_t)(const uint8_t *data, uint8_t len, adv_reading_t *reading);
+typedef struct adv_decoder_t {
+    const char *name;
+    uint8_t key;            /* adv_key_t */
+    uint16_t id;            /* service UUID or company ID */
+    uint8_t min_len;        /* payload length range accepted by decode */
+    uint8_t max_len;
+    adv_decode_fcn_t decode;
+} adv_decoder_t;
+
+/* sensor type found by advertised name and read from GATT notifications */
+typedef struct adv_gatt_t {
+    const char *name;       /* complete or shortened local name */
+    uint8_t name_len;
+    uint8_t service_uuid[ADV_UUID128_LEN];
+    uint8_t char_uuid[ADV_UUID128_LEN];     /* notify characteristic */
+    uint8_t min_len;        /* notification length range accepted by decode */
+    uint8_t max_len;
+    adv_decode_fcn_t decode;
+} adv_gatt_t;
+
+/* last value seen from one advertiser */
+typedef struct adv_dev_t {
+    uint8_t bda[ADV_BDA_LEN];
+    uint8_t used;
+    uint8_t decoder;        /* index into decoder table */
+    uint32_t last_ms;
+    uint32_t rx_count;      /* adverts received */
+    uint32_t dup_count;     /* adverts dropped as repeats */
+    adv_reading_t reading;
+} adv_dev_t;
+
+/* PUBLIC PROTOTYPES */
+void adv_decode_init(void);
+int adv_decoder_register(const adv_decoder_t *decoder);
+const adv_decoder_t *adv_decoder_get(int idx);
+int adv_decode(const uint8_t *adv, uint8_t adv_len, adv_reading_t *reading);
+const adv_gatt_t *adv_gatt_get(int idx);
+int adv_gatt_match(const uint8_t *adv, uint8_t adv_len);
+bool adv_gatt_decode(int idx, const uint8_t *data, uint16_t len, adv_reading_t *reading);
+adv_dev_t *adv_dev_update(const uint8_t *bda, int decoder, const adv_reading_t *reading, uint32_t now_ms, bool *is_new);
+adv_dev_t *adv_dev_get(int idx);
+int adv_dev_index(const adv_dev_t *dev);
+int adv_dev_count(void);
+uint32_t adv_dev_overflow(void);
+
+#endif
@@ -0,0 +1,165 @@
+#include <string.h>
+
+#include "ble_cache.h"
+
+/* STATIC PROTOTYPES */
+static ble_cache_dev_t *find_bda(ble_cache_t *cache, const uint8_t *bda);
+
+/**
+ * @brief find entry by remote address
+ *
+ * @param cache
+ * @param bda
+ * @return entry or NULL
+ */
+static ble_cache_dev_t *find_bda(ble_cache_t *cache, const uint8_t *bda) {
+    for (uint32_t idx = 0; idx < cache->blob.count; idx++) {
+        if (memcmp(cache->blob.dev[idx].bda, bda, BLE_BDA_LEN) == 0) {
+            return &cache->blob.dev[idx];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief empty cache, nothing to save until a device is stored
+ *
+ * @param cache
+ */
+void ble_cache_init(ble_cache_t *cache) {
+    memset(cache, 0, sizeof(ble_cache_t));
+    cache->blob.magic = BLE_CACHE_MAGIC;
+}
+
+/**
+ * @brief take over blob read from flash, a blob of another layout leaves the cache empty
+ *
+ * @param cache
+ * @param blob
+ * @param len bytes read
+ * @return true if loaded
+ */
+bool ble_cache_load(ble_cache_t *cache, const void *blob, size_t len) {
+    const ble_cache_blob_t *src = blob;
+    ble_cache_init(cache);
+    if (len != sizeof(ble_cache_blob_t) || src->magic != BLE_CACHE_MAGIC || src->count > BLE_CACHE_MAX) {
+        return false;
+    }
+    memcpy(&cache->blob, src, sizeof(ble_cache_blob_t));
+    return true;
+}
+
+/**
+ * @brief handles of a device to register for notifications without discovery
+ *
+ * @param cache
+ * @param bda
+ * @param gatt_type sensor type matched by the advertisement, entries of another type are ignored
+ * @return entry or NULL
+ */
+const ble_cache_dev_t *ble_cache_lookup(ble_cache_t *cache, const uint8_t *bda, uint8_t gatt_type) {
+    const ble_cache_dev_t *dev = find_bda(cache, bda);
+    if (dev == NULL || dev->gatt_type != gatt_type || dev->char_handle == 0) {
+        cache->miss_count++;
+        return NULL;
+    }
+    cache->hit_count++;
+    return dev;
+}
+
+/**
+ * @brief keep handles of a ready connection, the use time alone does not make the cache dirty,
+ *        it is saved with the next real change
+ *
+ * @param cache
+ * @param entry last_use is ignored
+ * @param evicted [out] entry dropped for BLE_CACHE_REPLACED, may be NULL
+ * @return BLE_CACHE_x
+ */
+ble_cache_res_t ble_cache_store(ble_cache_t *cache, const ble_cache_dev_t *entry, ble_cache_dev_t *evicted) {
+    ble_cache_res_t res;
+    ble_cache_dev_t *dev = find_bda(cache, entry->bda);
+    if (dev) {
+        bool same = dev->addr_type == entry->addr_type && dev->gatt_type == entry->gatt_type &&
+                    dev->service_start == entry->service_start && dev->service_end == entry->service_end &&
+                    dev->char_handle == entry->char_handle;
+        if (!same && dev->gatt_type == entry->gatt_type) {
+            cache->mismatch_count++;
+        }
+        res = same ? BLE_CACHE_SAME : BLE_CACHE_UPDATED;
+    } else if (cache->blob.count < BLE_CACHE_MAX) {
+        dev = &cache->blob.dev[cache->blob.count++];
+        res = BLE_CACHE_ADDED;
+    } else {
+        dev = &cache->blob.dev[0];
+        for (int idx = 1; idx < BLE_CACHE_MAX; idx++) {
+            if (cache->blob.dev[idx].last_use < dev->last_use) {
+                dev = &cache->blob.dev[idx];
+            }
+        }
+        if (evicted) {
+            *evicted = *dev;
+        }
+        res = BLE_CACHE_REPLACED;
+    }
+    *dev = *entry;
+    dev->last_use = ++cache->blob.use_seq;
+    if (res != BLE_CACHE_SAME) {
+        cache->dirty = true;
+    }
+    return res;
+}
+
+/**
+ * @brief forget a device, e.g. its service is gone
+ *
+ * @param cache
+ * @param bda
+ * @return true if it was cached
+ */
+bool ble_cache_invalidate(ble_cache_t *cache, const uint8_t *bda) {
+    ble_cache_dev_t *dev = find_bda(cache, bda);
+    if (dev == NULL) {
+        return false;
+    }
+    /* keep entries packed, order carries no meaning */
+    *dev = cache->blob.dev[--cache->blob.count];
+    cache->dirty = true;
+    return true;
+}
+
+/**
+ * @brief number of cached devices
+ *
+ * @param cache
+ * @return count
+ */
+int ble_cache_count(const ble_cache_t *cache) {
+    return (int)cache->blob.count;
+}
+
+/**
+ * @brief get entry by index, e.g. to fill the whitelist at boot
+ *
+ * @param cache
+ * @param idx 0..ble_cache_count()-1
+ * @return entry or NULL
+ */
+const ble_cache_dev_t *ble_cache_get(const ble_cache_t *cache, int idx) {
+    if (idx < 0 || idx >= (int)cache->blob.count) {
+        return NULL;
+    }
+    return &cache->blob.dev[idx];
+}
+
+/**
+ * @brief blob needs writing, clears the flag
+ *
+ * @param cache
+ * @return true if changed since last call
+ */
+bool ble_cache_take_dirty(ble_cache_t *cache) {
+    bool dirty = cache->dirty;
+    cache->dirty = false;
+    return dirty;
+}
@@ -0,0 +1,60 @@
+#ifndef _BLE_CACHE_H_
+#define _BLE_CACHE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "ble_conn.h"
+
+/* DEFINES */
+#define BLE_CACHE_MAX       8           /* bonded devices kept, least recently used one is replaced */
+#define BLE_CACHE_MAGIC     0x42434831  /* "BCH1", bump when ble_cache_blob_t changes */
+
+/* TYPE DEFINITIONS */
+/* GATT handles found by the last full discovery of one device */
+typedef struct ble_cache_dev_t {
+    uint8_t bda[BLE_BDA_LEN];
+    uint8_t addr_type;      /* esp_ble_addr_type_t, for the controller whitelist */
+    uint8_t gatt_type;      /* adv_gatt_match index the handles belong to */
+    uint16_t service_start;
+    uint16_t service_end;
+    uint16_t char_handle;   /* notify characteristic */
+    uint32_t last_use;      /* use sequence of last ready connection */
+} ble_cache_dev_t;
+
+/* persisted as one NVS blob, written only when handles or devices change */
+typedef struct ble_cache_blob_t {
+    uint32_t magic;
+    uint32_t count;
+    uint32_t use_seq;
+    ble_cache_dev_t dev[BLE_CACHE_MAX];
+} ble_cache_blob_t;
+
+/* outcome of ble_cache_store */
+typedef enum {
+    BLE_CACHE_SAME = 0,     /* entry unchanged, only its use time moved */
+    BLE_CACHE_UPDATED,      /* known device with new handles */
+    BLE_CACHE_ADDED,        /* new device in a free entry */
+    BLE_CACHE_REPLACED,     /* new device, least recently used one evicted */
+} ble_cache_res_t;
+
+typedef struct ble_cache_t {
+    ble_cache_blob_t blob;
+    bool dirty;             /* blob differs from flash */
+    uint32_t hit_count;     /* lookups answered from the cache */
+    uint32_t miss_count;
+    uint32_t mismatch_count;    /* cached handles found stale on reconnect */
+} ble_cache_t;
+
+/* PUBLIC PROTOTYPES */
+void ble_cache_init(ble_cache_t *cache);
+bool ble_cache_load(ble_cache_t *cache, const void *blob, size_t len);
+const ble_cache_dev_t *ble_cache_lookup(ble_cache_t *cache, const uint8_t *bda, uint8_t gatt_type);
+ble_cache_res_t ble_cache_store(ble_cache_t *cache, const ble_cache_dev_t *entry, ble_cache_dev_t *evicted);
+bool ble_cache_invalidate(ble_cache_t *cache, const uint8_t *bda);
+int ble_cache_count(const ble_cache_t *cache);
+const ble_cache_dev_t *ble_cache_get(const ble_cache_t *cache, int idx);
+bool ble_cache_take_dirty(ble_cache_t *cache);
+
+#endif
@@ -0,0 +1,450 @@
+#include <string.h>
+
+#include "ble_conn.h"
+
+/* STATIC VARIABLES */
+static ble_conn_t conn_tab[BLE_CONN_MAX];
+
+/* STATIC PROTOTYPES */
+static ble_conn_t *find_state_id(uint16_t conn_id, ble_conn_state_t state);
+static ble_conn_act_t reg_request(ble_conn_t *conn);
+
+/**
+ * @brief find connected slot by conn_id in the given state
+ *
+ * @param conn_id
+ * @param state
+ * @return slot or NULL
+ */
+static ble_conn_t *find_state_id(uint16_t conn_id, ble_conn_state_t state) {
+    ble_conn_t *conn = ble_conn_find_id(conn_id);
+    if (conn && conn->state == state) {
+        return conn;
+    }
+    return NULL;
+}
+
+/**
+ * @brief register for notifications, or queue behind the registration in progress:
+ *        REG_FOR_NOTIFY_EVT carries no conn_id or address, so only one may be outstanding
+ *
+ * @param conn
+ * @return BLE_CONN_ACT_REG_NOTIFY, or BLE_CONN_ACT_NONE if queued
+ */
+static ble_conn_act_t reg_request(ble_conn_t *conn) {
+    for (int idx = 0; idx < BLE_CONN_MAX; idx++) {
+        if (conn_tab[idx].state != BLE_CONN_FREE && conn_tab[idx].reg_pending) {
+            conn->state = BLE_CONN_REG_QUEUED;
+            return BLE_CONN_ACT_NONE;
+        }
+    }
+    conn->state = BLE_CONN_REGISTERING;
+    conn->reg_pending = true;
+    return BLE_CONN_ACT_REG_NOTIFY;
+}
+
+/**
+ * @brief clear connection table
+ *
+ */
+void ble_conn_init(void) {
+    memset(conn_tab, 0, sizeof(conn_tab));
+}
+
+/**
+ * @brief get slot by index
+ *
+ * @param idx 0..BLE_CONN_MAX-1
+ * @return slot or NULL if out of range
+ */
+ble_conn_t *ble_conn_get(int idx) {
+    if (idx < 0 || idx >= BLE_CONN_MAX) {
+        return NULL;
+    }
+    return &conn_tab[idx];
+}
+
+/**
+ * @brief get index of slot, used as device id
+ *
+ * @param conn
+ * @return index or -1
+ */
+int ble_conn_index(const ble_conn_t *conn) {
+    if (conn < conn_tab || conn >= conn_tab + BLE_CONN_MAX) {
+        return -1;
+    }
+    return (int)(conn - conn_tab);
+}
+
+/**
+ * @brief find connected slot by conn_id
+ *
+ * @param conn_id
+ * @return slot or NULL
+ */
+ble_conn_t *ble_conn_find_id(uint16_t conn_id) {
+    for (int idx = 0; idx < BLE_CONN_MAX; idx++) {
+        /* conn_id is only valid after CONNECT_EVT */
+        if (conn_tab[idx].state > BLE_CONN_OPENING && conn_tab[idx].conn_id == conn_id) {
+            return &conn_tab[idx];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief find used slot by remote address
+ *
+ * @param bda
+ * @return slot or NULL
+ */
+ble_conn_t *ble_conn_find_bda(const uint8_t *bda) {
+    for (int idx = 0; idx < BLE_CONN_MAX; idx++) {
+        if (conn_tab[idx].state != BLE_CONN_FREE && memcmp(conn_tab[idx].remote_bda, bda, BLE_BDA_LEN) == 0) {
+            return &conn_tab[idx];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief count slots in given state
+ *
+ * @param state
+ * @return number of slots
+ */
+int ble_conn_count(ble_conn_state_t state) {
+    int count = 0;
+    for (int idx = 0; idx < BLE_CONN_MAX; idx++) {
+        if (conn_tab[idx].state == state) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief scanning is needed while a slot is free and no open is pending
+ *
+ * @return true if scan should run
+ */
+bool ble_conn_scan_wanted(void) {
+    return (ble_conn_count(BLE_CONN_FREE) > 0) && (ble_conn_count(BLE_CONN_OPENING) == 0);
+}
+
+/**
+ * @brief matched advertisement, reserve a slot and request open
+ *
+ * @param bda remote address
+ * @param p_conn [out] reserved slot
+ * @return BLE_CONN_ACT_OPEN or BLE_CONN_ACT_NONE if known, busy or full
+ */
+ble_conn_act_t ble_conn_on_adv(const uint8_t *bda, ble_conn_t **p_conn) {
+    /* the controller handles one pending open at a time */
+    if (ble_conn_find_bda(bda) || ble_conn_count(BLE_CONN_OPENING) > 0) {
+        return BLE_CONN_ACT_NONE;
+    }
+    for (int idx = 0; idx < BLE_CONN_MAX; idx++) {
+        if (conn_tab[idx].state == BLE_CONN_FREE) {
+            memset(&conn_tab[idx], 0, sizeof(ble_conn_t));
+            memcpy(conn_tab[idx].remote_bda, bda, BLE_BDA_LEN);
+            conn_tab[idx].state = BLE_CONN_OPENING;
+            if (p_conn) {
+                *p_conn = &conn_tab[idx];
+            }
+            return BLE_CONN_ACT_OPEN;
+        }
+    }
+    return BLE_CONN_ACT_NONE;
+}
+
+/**
+ * @brief open failed before CONNECT_EVT, release reserved slot
+ *
+ * @param bda
+ * @return BLE_CONN_ACT_NONE
+ */
+ble_conn_act_t ble_conn_on_open_failed(const uint8_t *bda) {
+    ble_conn_t *conn = ble_conn_find_bda(bda);
+    if (conn && conn->state == BLE_CONN_OPENING) {
+        conn->state = BLE_CONN_FREE;
+    }
+    return BLE_CONN_ACT_NONE;
+}
+
+/**
+ * @brief link established, bind conn_id to slot
+ *
+ * @param conn_id
+ * @param bda
+ * @param p_conn [out] slot
+ * @return BLE_CONN_ACT_MTU_REQ, or BLE_CONN_ACT_CLOSE if no slot is available
+ */
+ble_conn_act_t ble_conn_on_connect(uint16_t conn_id, const uint8_t *bda, ble_conn_t **p_conn) {
+    ble_conn_t *conn = ble_conn_find_bda(bda);
+    if (conn == NULL) {
+        /* connection not initiated by us, e.g. a late one after open timeout */
+        ble_conn_act_t act = ble_conn_on_adv(bda, &conn);
+        if (act != BLE_CONN_ACT_OPEN) {
+            return BLE_CONN_ACT_CLOSE;
+        }
+    }
+    if (conn->state != BLE_CONN_OPENING) {
+        return BLE_CONN_ACT_NONE;
+    }
+    conn->conn_id = conn_id;
+    conn->state = BLE_CONN_MTU;
+    if (p_conn) {
+        *p_conn = conn;
+    }
+    return BLE_CONN_ACT_MTU_REQ;
+}
+
+/**
+ * @brief handles known from an earlier connection, register for notifications
+ *        without waiting for discovery, the database check follows on DIS_SRVC_CMPL
+ *
+ * @param conn_id
+ * @param start_handle
+ * @param end_handle
+ * @param char_handle
+ * @param p_conn [out] slot
+ * @return BLE_CONN_ACT_REG_NOTIFY, BLE_CONN_ACT_NONE if the slot is not waiting for discovery
+ *         or queued behind another registration
+ */
+ble_conn_act_t ble_conn_on_cached(uint16_t conn_id, uint16_t start_handle, uint16_t end_handle, uint16_t char_handle,
+                                  ble_conn_t **p_conn) {
+    ble_conn_t *conn = find_state_id(conn_id, BLE_CONN_MTU);
+    if (conn == NULL || char_handle == 0) {
+        return BLE_CONN_ACT_NONE;
+    }
+    conn->service_found = true;
+    conn->service_start_handle = start_handle;
+    conn->service_end_handle = end_handle;
+    conn->char_handle = char_handle;
+    conn->cached = true;
+    if (p_conn) {
+        *p_conn = conn;
+    }
+    return reg_request(conn);
+}
+
+/**
+ * @brief primary services discovered, search for remote service,
+ *        or check the handles a cached connection is already using
+ *
+ * @param conn_id
+ * @param p_conn [out] slot
+ * @return BLE_CONN_ACT_SEARCH, BLE_CONN_ACT_VERIFY for cached handles
+ */
+ble_conn_act_t ble_conn_on_dis_srvc_cmpl(uint16_t conn_id, ble_conn_t **p_conn) {
+    ble_conn_t *conn = ble_conn_find_id(conn_id);
+    if (conn == NULL) {
+        return BLE_CONN_ACT_NONE;
+    }
+    conn->db_ready = true;
+    if (p_conn) {
+        *p_conn = conn;
+    }
+    if (conn->cached) {
+        return BLE_CONN_ACT_VERIFY;
+    }
+    if (conn->state != BLE_CONN_MTU) {
+        return BLE_CONN_ACT_NONE;
+    }
+    conn->state = BLE_CONN_SEARCHING;
+    conn->service_found = false;
+    return BLE_CONN_ACT_SEARCH;
+}
+
+/**
+ * @brief matched service found, keep its handle range
+ *
+ * @param conn_id
+ * @param start_handle
+ * @param end_handle
+ * @return BLE_CONN_ACT_NONE
+ */
+ble_conn_act_t ble_conn_on_search_res(uint16_t conn_id, uint16_t start_handle, uint16_t end_handle) {
+    ble_conn_t *conn = find_state_id(conn_id, BLE_CONN_SEARCHING);
+    if (conn) {
+        conn->service_found = true;
+        conn->service_start_handle = start_handle;
+        conn->service_end_handle = end_handle;
+    }
+    return BLE_CONN_ACT_NONE;
+}
+
+/**
+ * @brief service search done
+ *
+ * @param conn_id
+ * @param p_conn [out] slot
+ * @return BLE_CONN_ACT_GET_CHAR if service found, else BLE_CONN_ACT_CLOSE
+ */
+ble_conn_act_t ble_conn_on_search_cmpl(uint16_t conn_id, ble_conn_t **p_conn) {
+    ble_conn_t *conn = find_state_id(conn_id, BLE_CONN_SEARCHING);
+    if (conn == NULL) {
+        return BLE_CONN_ACT_NONE;
+    }
+    if (p_conn) {
+        *p_conn = conn;
+    }
+    return conn->service_found ? BLE_CONN_ACT_GET_CHAR : BLE_CONN_ACT_CLOSE;
+}
+
+/**
+ * @brief result of characteristic lookup
+ *
+ * @param conn_id
+ * @param char_handle notify characteristic, INVALID_HANDLE (0) if not found
+ * @param p_conn [out] slot
+ * @return BLE_CONN_ACT_REG_NOTIFY, BLE_CONN_ACT_NONE if queued behind another registration,
+ *         or BLE_CONN_ACT_CLOSE if not found
+ */
+ble_conn_act_t ble_conn_on_char(uint16_t conn_id, uint16_t char_handle, ble_conn_t **p_conn) {
+    ble_conn_t *conn = find_state_id(conn_id, BLE_CONN_SEARCHING);
+    if (conn == NULL) {
+        return BLE_CONN_ACT_NONE;
+    }
+    if (p_conn) {
+        *p_conn = conn;
+    }
+    if (char_handle == 0) {
+        return BLE_CONN_ACT_CLOSE;
+    }
+    conn->char_handle = char_handle;
+    return reg_request(conn);
+}
+
+/**
+ * @brief notify characteristic looked up in the discovered database of a cached connection
+ *
+ * @param conn_id
+ * @param char_handle handle found, INVALID_HANDLE (0) if the characteristic is gone
+ * @param p_conn [out] slot
+ * @return BLE_CONN_ACT_NONE if the cached handle holds, BLE_CONN_ACT_SEARCH to rediscover on mismatch,
+ *         BLE_CONN_ACT_CLOSE if not found
+ */
+ble_conn_act_t ble_conn_on_verify(uint16_t conn_id, uint16_t char_handle, ble_conn_t **p_conn) {
+    ble_conn_t *conn = ble_conn_find_id(conn_id);
+    if (conn == NULL || !conn->cached) {
+        return BLE_CONN_ACT_NONE;
+    }
+    if (p_conn) {
+        *p_conn = conn;
+    }
+    conn->cached = false;
+    if (char_handle == 0) {
+        return BLE_CONN_ACT_CLOSE;
+    }
+    if (char_handle == conn->char_handle) {
+        return BLE_CONN_ACT_NONE;
+    }
+    /* firmware changed the database, service range is stale as well */
+    conn->state = BLE_CONN_SEARCHING;
+    conn->service_found = false;
+    return BLE_CONN_ACT_SEARCH;
+}
+
+/**
+ * @brief notify registration done, REG_FOR_NOTIFY_EVT only carries the handle,
+ *        it belongs to the one slot with a registration outstanding,
+ *        call ble_conn_next_reg after it
+ *
+ * @param char_handle
+ * @param ok registration status
+ * @param p_conn [out] slot
+ * @return BLE_CONN_ACT_NONE, BLE_CONN_ACT_SEARCH if cached handles failed after discovery,
+ *         or BLE_CONN_ACT_CLOSE on failure
+ */
+ble_conn_act_t ble_conn_on_reg_notify(uint16_t char_handle, bool ok, ble_conn_t **p_conn) {
+    for (int idx = 0; idx < BLE_CONN_MAX; idx++) {
+        ble_conn_t *conn = &conn_tab[idx];
+        if (conn->state != BLE_CONN_FREE && conn->reg_pending && conn->char_handle == char_handle) {
+            conn->reg_pending = false;
+            if (p_conn) {
+                *p_conn = conn;
+            }
+            if (conn->state != BLE_CONN_REGISTERING) {
+                /* ready on an early notification, or rediscovering after a failed check */
+                return BLE_CONN_ACT_NONE;
+            }
+            if (ok) {
+                conn->state = BLE_CONN_READY;
+                return BLE_CONN_ACT_NONE;
+            }
+            if (!conn->cached) {
+                return BLE_CONN_ACT_CLOSE;
+            }
+            /* stale cache, fall back to discovery */
+            conn->cached = false;
+            if (!conn->db_ready) {
+                conn->state = BLE_CONN_MTU;
+                return BLE_CONN_ACT_NONE;
+            }
+            conn->state = BLE_CONN_SEARCHING;
+            conn->service_found = false;
+            return BLE_CONN_ACT_SEARCH;
+        }
+    }
+    return BLE_CONN_ACT_NONE;
+}
+
+/**
+ * @brief start the first queued registration once none is outstanding,
+ *        after REG_FOR_NOTIFY_EVT or a disconnect
+ *
+ * @param p_conn [out] slot
+ * @return BLE_CONN_ACT_REG_NOTIFY, or BLE_CONN_ACT_NONE if nothing to start
+ */
+ble_conn_act_t ble_conn_next_reg(ble_conn_t **p_conn) {
+    for (int idx = 0; idx < BLE_CONN_MAX; idx++) {
+        if (conn_tab[idx].state != BLE_CONN_FREE && conn_tab[idx].reg_pending) {
+            return BLE_CONN_ACT_NONE;
+        }
+    }
+    for (int idx = 0; idx < BLE_CONN_MAX; idx++) {
+        if (conn_tab[idx].state == BLE_CONN_REG_QUEUED) {
+            if (p_conn) {
+                *p_conn = &conn_tab[idx];
+            }
+            return reg_request(&conn_tab[idx]);
+        }
+    }
+    return BLE_CONN_ACT_NONE;
+}
+
+/**
+ * @brief notification received
+ *
+ * @param conn_id
+ * @return slot or NULL if conn_id is unknown
+ */
+ble_conn_t *ble_conn_on_notify(uint16_t conn_id) {
+    ble_conn_t *conn = ble_conn_find_id(conn_id);
+    if (conn && conn->state == BLE_CONN_REGISTERING) {
+        /* notify may arrive ahead of REG_FOR_NOTIFY_EVT */
+        conn->state = BLE_CONN_READY;
+    }
+    return conn;
+}
+
+/**
+ * @brief link lost, release slot
+ *
+ * @param conn_id
+ * @param bda
+ * @return BLE_CONN_ACT_NONE
+ */
+ble_conn_act_t ble_conn_on_disconnect(uint16_t conn_id, const uint8_t *bda) {
+    ble_conn_t *conn = ble_conn_find_bda(bda);
+    if (conn == NULL) {
+        conn = ble_conn_find_id(conn_id);
+    }
+    if (conn) {
+        conn->state = BLE_CONN_FREE;
+    }
+    return BLE_CONN_ACT_NONE;
+}
@@ -0,0 +1,85 @@
+#ifndef _BLE_CONN_H_
+#define _BLE_CONN_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+/* DEFINES */
+#ifdef CONFIG_BTDM_CTRL_BLE_MAX_CONN
+#define BLE_CONN_MAX        CONFIG_BTDM_CTRL_BLE_MAX_CONN   /* controller limit */
+#else
+#define BLE_CONN_MAX        3
+#endif
+#define BLE_BDA_LEN         6
+
+/* TYPE DEFINITIONS */
+/* discovery state of one connection slot */
+typedef enum {
+    BLE_CONN_FREE = 0,      /* slot unused */
+    BLE_CONN_OPENING,       /* esp_ble_gattc_open() issued, waiting for CONNECT_EVT */
+    BLE_CONN_MTU,           /* connected, MTU request sent */
+    BLE_CONN_SEARCHING,     /* service search in progress */
+    BLE_CONN_REG_QUEUED,    /* waiting for the registration of another slot to complete */
+    BLE_CONN_REGISTERING,   /* register_for_notify issued */
+    BLE_CONN_READY,         /* receiving notifications */
+} ble_conn_state_t;
+
+/* action requested from the GAP/GATTC glue after an event */
+typedef enum {
+    BLE_CONN_ACT_NONE = 0,
+    BLE_CONN_ACT_OPEN,          /* esp_ble_gattc_open() to remote_bda */
+    BLE_CONN_ACT_MTU_REQ,       /* esp_ble_gattc_send_mtu_req() */
+    BLE_CONN_ACT_SEARCH,        /* esp_ble_gattc_search_service() */
+    BLE_CONN_ACT_GET_CHAR,      /* look up notify characteristic in found service */
+    BLE_CONN_ACT_REG_NOTIFY,    /* esp_ble_gattc_register_for_notify() on char_handle */
+    BLE_CONN_ACT_VERIFY,        /* database discovered, check cached char_handle against it */
+    BLE_CONN_ACT_CLOSE,         /* esp_ble_gattc_close(), discovery failed */
+} ble_conn_act_t;
+
+/* one GATT connection, keyed by conn_id once connected and by remote_bda before */
+typedef struct ble_conn_t {
+    ble_conn_state_t state;
+    uint16_t conn_id;
+    uint16_t service_start_handle;
+    uint16_t service_end_handle;
+    uint16_t char_handle;
+    bool service_found;
+    bool cached;            /* handles taken from the cache, not yet checked against the database */
+    bool db_ready;          /* DIS_SRVC_CMPL seen, the database can be searched */
+    bool reg_pending;       /* REG_FOR_NOTIFY_EVT outstanding, on one slot at most */
+    int8_t rssi;            /* dBm of the advertisement the connection was opened on */
+    uint8_t gatt_type;      /* decoder of notifications, see adv_gatt_match */
+    uint8_t addr_type;      /* esp_ble_addr_type_t of the advertisement */
+    int64_t connect_us;     /* CONNECT_EVT time until the first sample, 0 after */
+    uint8_t remote_bda[BLE_BDA_LEN];
+} ble_conn_t;
+
+/* PUBLIC PROTOTYPES */
+void ble_conn_init(void);
+ble_conn_t *ble_conn_get(int idx);
+int ble_conn_index(const ble_conn_t *conn);
+ble_conn_t *ble_conn_find_id(uint16_t conn_id);
+ble_conn_t *ble_conn_find_bda(const uint8_t *bda);
+int ble_conn_count(ble_conn_state_t state);
+bool ble_conn_scan_wanted(void);
+
+ble_conn_act_t ble_conn_on_adv(const uint8_t *bda, ble_conn_t **p_conn);
+ble_conn_act_t ble_conn_on_open_failed(const uint8_t *bda);
+ble_conn_act_t ble_conn_on_connect(uint16_t conn_id, const uint8_t *bda, ble_conn_t **p_conn);
+ble_conn_act_t ble_conn_on_cached(uint16_t conn_id, uint16_t start_handle, uint16_t end_handle, uint16_t char_handle,
+                                  ble_conn_t **p_conn);
+ble_conn_act_t ble_conn_on_dis_srvc_cmpl(uint16_t conn_id, ble_conn_t **p_conn);
+ble_conn_act_t ble_conn_on_search_res(uint16_t conn_id, uint16_t start_handle, uint16_t end_handle);
+ble_conn_act_t ble_conn_on_search_cmpl(uint16_t conn_id, ble_conn_t **p_conn);
+ble_conn_act_t ble_conn_on_char(uint16_t conn_id, uint16_t char_handle, ble_conn_t **p_conn);
+ble_conn_act_t ble_conn_on_verify(uint16_t conn_id, uint16_t char_handle, ble_conn_t **p_conn);
+ble_conn_act_t ble_conn_on_reg_notify(uint16_t char_handle, bool ok, ble_conn_t **p_conn);
+ble_conn_act_t ble_conn_next_reg(ble_conn_t **p_conn);
+ble_conn_t *ble_conn_on_notify(uint16_t conn_id);
+ble_conn_act_t ble_conn_on_disconnect(uint16_t conn_id, const uint8_t *bda);
+
+#endif
@@ -1,307 +1,843 @@
-#include "main.h"
-
-#include "esp_bt.h"
-#include "esp_gap_ble_api.h"
-#include "esp_gattc_api.h"
-#include "esp_gatt_defs.h"
-#include "esp_bt_main.h"
-#include "esp_gatt_common_api.h"
-
-#include "ble_gatt.h"
-
-/* DEFINES */
-#define TAG                 "BLE-MQTT"
-#define PROFILE_NUM         1
-#define PROFILE_A_APP_ID    0
-#define INVALID_HANDLE      0
-
-/* parameters for Xiaomi Mijia temperature and humidity sensor */
-const char remote_device_name[] = "LYWSD03MMC";
-const uint8_t REMOTE_SERVICE_UUID[ESP_UUID_LEN_128]     = {0xA6, 0xA3, 0x7D, 0x99, 0xF2, 0x6F, 0x1A, 0x8A, 0x0C, 0x4B, 0x0A, 0x7A, 0xB0, 0xCC, 0xE0, 0xEB};
-const uint8_t REMOTE_NOTIFY_CHAR_UUID[ESP_UUID_LEN_128] = {0xA6, 0xA3, 0x7D, 0x99, 0xF2, 0x6F, 0x1A, 0x8A, 0x0C, 0x4B, 0x0A, 0x7A, 0xC1, 0xCC, 0xE0, 0xEB};
-
-/* STATIC VARIABLES */
-static bool connect_flag = false;
-static bool service_flag = false;
-
-static esp_ble_scan_params_t ble_scan_params = {
-    .scan_type              = BLE_SCAN_TYPE_ACTIVE,
-    .own_addr_type          = BLE_ADDR_TYPE_PUBLIC,
-    .scan_filter_policy     = BLE_SCAN_FILTER_ALLOW_ALL,
-    .scan_interval          = 0x50,
-    .scan_window            = 0x30,
-    .scan_duplicate         = BLE_SCAN_DUPLICATE_DISABLE
-};
-
-static esp_bt_uuid_t remote_device_service_uuid = {
-    .len = ESP_UUID_LEN_128,
-    .uuid = {.uuid128 = {0},},
-};
-static esp_bt_uuid_t remote_device_char_uuid = {
-    .len = ESP_UUID_LEN_128,
-    .uuid = {.uuid128 = {0},},
-};
-static esp_gattc_char_elem_t *char_elem_result = NULL;
-
-env_sensor_msg_t sensor_msg = {0.0, 0};
-
-/* STATIC PROTOTYPES */
-static void esp_gap_cb(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param);
-static void esp_gattc_cb(esp_gattc_cb_event_t event, esp_gatt_if_t gattc_if, esp_ble_gattc_cb_param_t *param);
-static void gattc_profile_event_handler(esp_gattc_cb_event_t event, esp_gatt_if_t gattc_if, esp_ble_gattc_cb_param_t *param);
-
-/* GATT-based profile for one app_id and one gattc_if */
-struct gattc_profile_inst {
-    esp_gattc_cb_t gattc_cb;
-    uint16_t gattc_if;
-    uint16_t app_id;
-    uint16_t conn_id;
-    uint16_t service_start_handle;
-    uint16_t service_end_handle;
-    uint16_t char_handle;
-    esp_bd_addr_t remote_bda;
-};
-
-/* array to store the gattc_if returned by ESP_GATTS_REG_EVT */
-static struct gattc_profile_inst gatt_profile_tab[PROFILE_NUM] = {
-    [PROFILE_A_APP_ID] = {
-        .gattc_cb = gattc_profile_event_handler,
-        .gattc_if = ESP_GATT_IF_NONE,       /* initial is ESP_GATT_IF_NONE */ 
-    },
-};
-
-/**
- * @brief Callback function to handle GATT profile events
- * 
- * @param event 
- * @param gattc_if 
- * @param param 
- */
-static void gattc_profile_event_handler(esp_gattc_cb_event_t event, esp_gatt_if_t gattc_if, esp_ble_gattc_cb_param_t *param) {
-    esp_ble_gattc_cb_param_t *p_data = (esp_ble_gattc_cb_param_t *)param;
-
-    ESP_LOGI(TAG, "GATT event handler: core %d\n", xPortGetCoreID());
-    switch (event) {
-    case ESP_GATTC_REG_EVT:
-        /* start scan when GATT callback is registered */
-        ESP_LOGI(TAG, "ESP_GATTC_REG_EVT");
-        esp_ble_gap_set_scan_params(&ble_scan_params);
-        break;
-    case ESP_GATTC_CONNECT_EVT:
-        /* update connection status to GATT profile, then send MTU request */
-        ESP_LOGI(TAG, "ESP_GATTC_CONNECT_EVT conn_id %d, if %d", p_data->connect.conn_id, gattc_if);
-        gatt_profile_tab[PROFILE_A_APP_ID].conn_id = p_data->connect.conn_id;
-        memcpy(gatt_profile_tab[PROFILE_A_APP_ID].remote_bda, p_data->connect.remote_bda, sizeof(esp_bd_addr_t));
-        ESP_LOGI(TAG, "REMOTE BDA:");
-        esp_log_buffer_hex(TAG, gatt_profile_tab[PROFILE_A_APP_ID].remote_bda, sizeof(esp_bd_addr_t));
-        esp_ble_gattc_send_mtu_req (gattc_if, p_data->connect.conn_id);
-        break;
-    case ESP_GATTC_OPEN_EVT:
-        ESP_LOGI(TAG, "ESP_GATTC_OPEN_EVT");
-        break;
-    case ESP_GATTC_DIS_SRVC_CMPL_EVT:
-        /* search for matched service UUID */
-        ESP_LOGI(TAG, "ESP_GATTC_DIS_SRVC_CMPL_EVT");
-        memcpy(remote_device_service_uuid.uuid.uuid128, REMOTE_SERVICE_UUID, ESP_UUID_LEN_128);        
-        esp_ble_gattc_search_service(gattc_if, param->cfg_mtu.conn_id, &remote_device_service_uuid);
-        break;
-    case ESP_GATTC_CFG_MTU_EVT:
-        ESP_LOGI(TAG, "ESP_GATTC_CFG_MTU_EVT, Status %d, MTU %d, conn_id %d", param->cfg_mtu.status, param->cfg_mtu.mtu, param->cfg_mtu.conn_id);
-        break;        
-    case ESP_GATTC_SEARCH_RES_EVT:
-        /* for each found service, check for matched UUID */
-        ESP_LOGI(TAG, "ESP_GATTC_SEARCH_RES_EVT");
-        if (p_data->search_res.srvc_id.uuid.len == ESP_UUID_LEN_128) {
-            ESP_LOGI(TAG, "Service ID:");
-            esp_log_buffer_hex(TAG, p_data->search_res.srvc_id.uuid.uuid.uuid128, ESP_UUID_LEN_128);
-            if (memcmp(p_data->search_res.srvc_id.uuid.uuid.uuid128, REMOTE_SERVICE_UUID, ESP_UUID_LEN_128) == 0){
-                ESP_LOGI(TAG, "service UUID128 found");
-                service_flag = true;
-                gatt_profile_tab[PROFILE_A_APP_ID].service_start_handle = p_data->search_res.start_handle;
-                gatt_profile_tab[PROFILE_A_APP_ID].service_end_handle = p_data->search_res.end_handle;
-            } else {
-                ESP_LOGE(TAG, "service not found");
-            }
-        }
-        break;        
-    case ESP_GATTC_SEARCH_CMPL_EVT:
-        /* if service UUID is matched, check for matched characteristics */
-        ESP_LOGI(TAG, "ESP_GATTC_SEARCH_CMPL_EVT");
-        if (service_flag) {
-            uint16_t count = 0;
-            esp_ble_gattc_get_attr_count(gattc_if,
-                                         p_data->search_cmpl.conn_id,
-                                         ESP_GATT_DB_CHARACTERISTIC,
-                                         gatt_profile_tab[PROFILE_A_APP_ID].service_start_handle,
-                                         gatt_profile_tab[PROFILE_A_APP_ID].service_end_handle,
-                                         INVALID_HANDLE,
-                                         &count);
-            ESP_LOGI(TAG, "ATTR count: %d\n", count);
-            if (count > 0) {
-                /* register for notification */
-                memcpy(remote_device_char_uuid.uuid.uuid128, REMOTE_NOTIFY_CHAR_UUID, ESP_UUID_LEN_128);
-                char_elem_result = (esp_gattc_char_elem_t *)malloc(sizeof(esp_gattc_char_elem_t) *count);
-                if (char_elem_result) {
-                    esp_ble_gattc_get_char_by_uuid(gattc_if,
-                                                   p_data->search_cmpl.conn_id,
-                                                   gatt_profile_tab[PROFILE_A_APP_ID].service_start_handle,
-                                                   gatt_profile_tab[PROFILE_A_APP_ID].service_end_handle,
-                                                   remote_device_char_uuid,
-                                                   char_elem_result,
-                                                   &count);
-                    /* use only first 'char_elem_result' */
-                    if (count > 0 && (char_elem_result[0].properties & ESP_GATT_CHAR_PROP_BIT_NOTIFY)) {
-                        gatt_profile_tab[PROFILE_A_APP_ID].char_handle = char_elem_result[0].char_handle;
-                        esp_ble_gattc_register_for_notify(gattc_if, gatt_profile_tab[PROFILE_A_APP_ID].remote_bda, char_elem_result[0].char_handle);
-                    }
-                } else {
-                    ESP_LOGE(TAG, "gattc no mem");
-                } 
-                /* free char_elem_result */
-                free(char_elem_result);
-            } else {
-                ESP_LOGE(TAG, "no char found");
-            }
-        }
-        break;
-    case ESP_GATTC_REG_FOR_NOTIFY_EVT:
-        ESP_LOGI(TAG, "ESP_GATTC_REG_FOR_NOTIFY_EVT");
-        break;
-    case ESP_GATTC_NOTIFY_EVT:
-        /* send notified data via queue */
-        if (p_data->notify.is_notify){
-            ESP_LOGI(TAG, "ESP_GATTC_NOTIFY_EVT, receive notify value:");
-            esp_log_buffer_hex(TAG, p_data->notify.value, p_data->notify.value_len);
-            sensor_msg.temp_val = (p_data->notify.value[0] | (p_data->notify.value[1] << 8))/100.0;
-            sensor_msg.humid_val = p_data->notify.value[2];
-            env_sensor_msg_t *p_msg;
-            p_msg = &sensor_msg;
-            xQueueSend(env_sensor_q, (void *)&p_msg, (TickType_t)0); // non-blocking
-        } else {
-            ESP_LOGI(TAG, "ESP_GATTC_NOTIFY_EVT, receive indicate value:");
-        }
-        break;        
-    case ESP_GATTC_DISCONNECT_EVT:
-        ESP_LOGI(TAG, "ESP_GATTC_DISCONNECT_EVT");
-        connect_flag = false;
-        service_flag = false;
-        break;        
-    default:
-        break;
-    }  
-}
-
-/**
- * @brief GAP callback, search for matched device name
- * 
- * @param event 
- * @param param 
- */
-static void esp_gap_cb(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param) {
-    uint8_t *adv_name = NULL;
-    uint8_t adv_name_len = 0;
-
-    ESP_LOGI(TAG, "GAP event handler: core %d\n", xPortGetCoreID());
-    switch (event) {    
-    case ESP_GAP_BLE_SCAN_PARAM_SET_COMPLETE_EVT:
-        /* start GAP scanning */
-        ESP_LOGI(TAG, "ESP_GAP_BLE_SCAN_PARAM_SET_COMPLETE_EVT");        
-        esp_ble_gap_start_scanning(30); // duration
-        break;
-    case ESP_GAP_BLE_SCAN_START_COMPLETE_EVT:        
-        ESP_LOGI(TAG, "ESP_GAP_BLE_SCAN_START_COMPLETE_EVT");
-        break;
-    case ESP_GAP_BLE_SCAN_RESULT_EVT: 
-        /* for each scan result, compare device name */
-        ESP_LOGI(TAG, "ESP_GAP_BLE_SCAN_RESULT_EVT");
-        esp_ble_gap_cb_param_t *scan_result = (esp_ble_gap_cb_param_t *)param;
-        switch (scan_result->scan_rst.search_evt) {
-        case ESP_GAP_SEARCH_INQ_RES_EVT:
-            adv_name = esp_ble_resolve_adv_data(scan_result->scan_rst.ble_adv,
-                                                ESP_BLE_AD_TYPE_NAME_CMPL, &adv_name_len);
-            if (adv_name != NULL) {
-                if (strlen(remote_device_name) == adv_name_len && strncmp((char *)adv_name, remote_device_name, adv_name_len) == 0) {
-                    ESP_LOGI(TAG, "Found %s\n", remote_device_name);
-                    /* stop scan and open connection */
-                    if (connect_flag == false) {
-                        connect_flag = true;
-                        esp_ble_gap_stop_scanning();
-                        esp_ble_gattc_open(gatt_profile_tab[PROFILE_A_APP_ID].gattc_if, scan_result->scan_rst.bda, scan_result->scan_rst.ble_addr_type, true);
-                    }
-                }
-            }            
-            break;  
-        case ESP_GAP_SEARCH_INQ_CMPL_EVT:
-            break;
-        default:
-            break;         
-        }
-        break;
-    case ESP_GAP_BLE_SCAN_STOP_COMPLETE_EVT:
-        ESP_LOGI(TAG, "ESP_GAP_BLE_SCAN_STOP_COMPLETE_EVT");
-        break;
-    case ESP_GAP_BLE_ADV_STOP_COMPLETE_EVT:
-        ESP_LOGI(TAG, "ESP_GAP_BLE_ADV_STOP_COMPLETE_EVT");
-        break;
-    case ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT:
-         ESP_LOGI(TAG, "update connection params status = %d, min_int = %d, max_int = %d,conn_int = %d,latency = %d, timeout = %d",
-                  param->update_conn_params.status,
-                  param->update_conn_params.min_int,
-                  param->update_conn_params.max_int,
-                  param->update_conn_params.conn_int,
-                  param->update_conn_params.latency,
-                  param->update_conn_params.timeout);
-        break;        
-    default:
-        break;
-    }
-}
-
-/**
- * @brief GATT callback, forward event to be handled by gattc_profile_event_handler
- * 
- * @param event 
- * @param gattc_if 
- * @param param 
- */
-static void esp_gattc_cb(esp_gattc_cb_event_t event, esp_gatt_if_t gattc_if, esp_ble_gattc_cb_param_t *param) {
-    if (event == ESP_GATTC_REG_EVT) {
-        if (param->reg.status == ESP_GATT_OK) {
-            gatt_profile_tab[param->reg.app_id].gattc_if = gattc_if;
-        } else {
-            ESP_LOGI(TAG, "reg app failed, app_id %04x, status %d",
-                    param->reg.app_id,
-                    param->reg.status);
-            return;
-        }
-    }
-    /* process event by corresponding profile handler */
-    for (int idx = 0; idx < PROFILE_NUM; idx++) {
-        /* ESP_GATT_IF_NONE, not specify a certain gatt_if, need to call every profile cb function */
-        if ((gattc_if == ESP_GATT_IF_NONE) || (gattc_if == gatt_profile_tab[idx].gattc_if)) {
-            if (gatt_profile_tab[idx].gattc_cb) {
-                gatt_profile_tab[idx].gattc_cb(event, gattc_if, param);
-            }
-        }
-    }
-}
-
-/**
- * @brief initialize BLE driver
- * 
- */
-void ble_gatt_init() {
-    /* initialize Bluetooth module */
-    esp_bt_controller_mem_release(ESP_BT_MODE_CLASSIC_BT);
-    esp_bt_controller_config_t bt_cfg = BT_CONTROLLER_INIT_CONFIG_DEFAULT();
-    esp_bt_controller_init(&bt_cfg);
-    esp_bt_controller_enable(ESP_BT_MODE_BLE);
-    esp_bluedroid_init();
-    esp_bluedroid_enable();
-
-    /* register callback functions for GAP/GATT */
-    esp_ble_gap_register_callback(esp_gap_cb);
-    esp_ble_gattc_register_callback(esp_gattc_cb);
-    esp_ble_gattc_app_register(PROFILE_A_APP_ID);
-    esp_ble_gatt_set_local_mtu(500);
+#include "main.h"
+
+#include "esp_bt.h"
+#include "esp_gap_ble_api.h"
+#include "esp_gattc_api.h"
+#include "esp_gatt_defs.h"
+#include "esp_bt_main.h"
+#include "esp_gatt_common_api.h"
+#include "esp_timer.h"
+#include "nvs.h"
+
+#include "ble_gatt.h"
+#include "ble_conn.h"
+#include "ble_scan.h"
+#include "adv_decode.h"
+#include "ble_cache.h"
+#include "remote_cfg.h"
+#include "ble_link.h"
+#include "pipe_trace.h"
+
+/* DEFINES */
+#define TAG                 "BLE-MQTT"
+#define PROFILE_NUM         1
+#define PROFILE_A_APP_ID    0
+#define INVALID_HANDLE      0
+#define BLE_PASSIVE_SCAN    0   /* 1: decode advertisements only, no GATT connection */
+#define BLE_SCAN_RETRY_MS   1000    /* retry after the controller refused to start scanning */
+#define BLE_ADV_DEV_ID(idx) (BLE_CONN_MAX + (idx))  /* advertisers numbered after connection slots */
+#define BLE_NVS_NAMESPACE   "ble"
+#define BLE_NVS_KEY_CACHE   "gatt_cache"    /* ble_cache_blob_t */
+
+/* scan duty by state: fast while devices are missing, sparse once all known ones are connected,
+   duty and sparse period may be changed by ble_gatt_configure */
+static const ble_scan_cfg_t scan_cfg = {
+    .fast = {0x50, 0x30},           /* 50 ms interval, 30 ms window */
+    .slow = {0x320, 0x50},          /* 500 ms interval, 50 ms window */
+    .fast_max_ms = BLE_PASSIVE_SCAN ? 0 : 30000,    /* advertisement mode scans continuously */
+    .slow_scan_ms = 5000,
+    .slow_idle_ms = 55000,
+    .pause_max_ms = 2000,
+    .pause_gap_ms = 1000,
+};
+
+/* connection parameters by notify period: slow sensors get long intervals and slave latency */
+static const ble_link_cfg_t link_policy = {
+    .rssi_period_ms = 30000,
+    .retry_ms = 60000,
+    .slow_ms = 1000,
+    .interval_min_ms = 30,
+    .interval_max_ms = 200,
+    .latency_max = 4,
+    .rssi_weak = -85,
+    .timeout_max = 3,
+};
+
+/* STATIC VARIABLES */
+static bool scan_flag = false;              /* controller told to scan */
+static bool scan_params_pending = false;    /* start once new parameters are set */
+static ble_scan_t scan_sched;
+static SemaphoreHandle_t scan_lock;         /* scan_sched is driven by BTC, esp_timer and main task */
+static esp_timer_handle_t scan_timer;
+static ble_cache_t gatt_cache;              /* handles of bonded devices, BTC task only after init */
+static remote_cfg_t link_cfg;               /* allow list, under scan_lock */
+static ble_link_tab_t link_tab;             /* link quality per device, BTC task and readers under link_lock */
+static SemaphoreHandle_t link_lock;
+
+static esp_ble_scan_params_t ble_scan_params = {
+    .scan_type              = BLE_PASSIVE_SCAN ? BLE_SCAN_TYPE_PASSIVE : BLE_SCAN_TYPE_ACTIVE,
+    .own_addr_type          = BLE_ADDR_TYPE_PUBLIC,
+    .scan_filter_policy     = BLE_SCAN_FILTER_ALLOW_ALL,
+    .scan_interval          = 0,    /* set from scan_cfg by scan scheduler */
+    .scan_window            = 0,
+    .scan_duplicate         = BLE_SCAN_DUPLICATE_DISABLE
+};
+
+static esp_bt_uuid_t remote_device_service_uuid = {
+    .len = ESP_UUID_LEN_128,
+    .uuid = {.uuid128 = {0},},
+};
+static esp_bt_uuid_t remote_device_char_uuid = {
+    .len = ESP_UUID_LEN_128,
+    .uuid = {.uuid128 = {0},},
+};
+
+/* STATIC PROTOTYPES */
+static void esp_gap_cb(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param);
+static void esp_gattc_cb(esp_gattc_cb_event_t event, esp_gatt_if_t gattc_if, esp_ble_gattc_cb_param_t *param);
+static void gattc_profile_event_handler(esp_gattc_cb_event_t event, esp_gatt_if_t gattc_if, esp_ble_gattc_cb_param_t *param);
+static void ble_conn_exec(esp_gatt_if_t gattc_if, ble_conn_act_t act, ble_conn_t *conn);
+static uint16_t ble_find_notify_char(esp_gatt_if_t gattc_if, ble_conn_t *conn, uint16_t start_handle, uint16_t end_handle);
+static void gatt_cache_load(void);
+static void gatt_cache_store(const ble_conn_t *conn);
+static void gatt_cache_save(void);
+static void gatt_whitelist(bool add, const uint8_t *bda, uint8_t addr_type);
+static void ble_scan_update(void);
+static void ble_scan_exec(ble_scan_act_t act);
+static void ble_scan_timer_cb(void *arg);
+static bool ble_adv_process(esp_ble_gap_cb_param_t *scan_result);
+static void ble_sample_push(uint16_t dev_id, int16_t temp_centi, uint16_t humid_centi, int8_t rssi, int64_t rx_us);
+static bool ble_allowed(const uint8_t *bda);
+static void ble_link_notify(ble_conn_t *conn);
+
+/* GATT-based profile for one app_id and one gattc_if, connections are kept in ble_conn table */
+struct gattc_profile_inst {
+    esp_gattc_cb_t gattc_cb;
+    uint16_t gattc_if;
+    uint16_t app_id;
+};
+
+/* array to store the gattc_if returned by ESP_GATTS_REG_EVT */
+static struct gattc_profile_inst gatt_profile_tab[PROFILE_NUM] = {
+    [PROFILE_A_APP_ID] = {
+        .gattc_cb = gattc_profile_event_handler,
+        .gattc_if = ESP_GATT_IF_NONE,       /* initial is ESP_GATT_IF_NONE */ 
+    },
+};
+
+/**
+ * @brief connection table changed, let scan scheduler start, stop or change duty
+ * 
+ */
+static void ble_scan_update(void) {
+    int connected = BLE_CONN_MAX - ble_conn_count(BLE_CONN_FREE) - ble_conn_count(BLE_CONN_OPENING);
+    /* advertising sensors are heard only while scanning, keep sparse windows with every slot used */
+    bool wanted = ble_conn_scan_wanted() || (adv_dev_count() > 0 && ble_conn_count(BLE_CONN_OPENING) == 0);
+    xSemaphoreTake(scan_lock, portMAX_DELAY);
+    /* advertising sensors are not bonded, a filtered scan would miss them */
+    ble_scan_set_whitelist(&scan_sched, ble_cache_count(&gatt_cache) > 0 && adv_dev_count() == 0);
+    ble_scan_exec(ble_scan_on_links(&scan_sched, connected, wanted, esp_timer_get_time()));
+    xSemaphoreGive(scan_lock);
+}
+
+/**
+ * @brief carry out scheduler action and re-arm its timer, scan_lock held
+ * 
+ * @param act 
+ */
+static void ble_scan_exec(ble_scan_act_t act) {
+    if (act == BLE_SCAN_ACT_START) {
+        if (scan_flag) {
+            scan_flag = false;
+            esp_ble_gap_stop_scanning();
+        }
+        esp_ble_scan_filter_t filter = scan_sched.params.known_only ? BLE_SCAN_FILTER_ALLOW_ONLY_WLST : BLE_SCAN_FILTER_ALLOW_ALL;
+        if (ble_scan_params.scan_interval != scan_sched.params.interval || ble_scan_params.scan_window != scan_sched.params.window ||
+            ble_scan_params.scan_filter_policy != filter) {
+            /* started from ESP_GAP_BLE_SCAN_PARAM_SET_COMPLETE_EVT */
+            ble_scan_params.scan_interval = scan_sched.params.interval;
+            ble_scan_params.scan_window = scan_sched.params.window;
+            ble_scan_params.scan_filter_policy = filter;
+            scan_params_pending = true;
+            esp_ble_gap_set_scan_params(&ble_scan_params);
+        } else if (!scan_params_pending) {
+            scan_flag = true;
+            esp_ble_gap_start_scanning(0);
+        }
+    } else if (act == BLE_SCAN_ACT_STOP) {
+        scan_params_pending = false;
+        if (scan_flag) {
+            scan_flag = false;
+            esp_ble_gap_stop_scanning();
+        }
+    }
+    int64_t deadline = ble_scan_deadline(&scan_sched);
+    esp_timer_stop(scan_timer);
+    if (deadline != INT64_MAX) {
+        int64_t wait_us = deadline - esp_timer_get_time();
+        esp_timer_start_once(scan_timer, (wait_us > 0) ? wait_us : 1);
+    }
+}
+
+/**
+ * @brief scheduler deadline or start retry
+ * 
+ * @param arg unused
+ */
+static void ble_scan_timer_cb(void *arg) {
+    int64_t now = esp_timer_get_time();
+    xSemaphoreTake(scan_lock, portMAX_DELAY);
+    if (scan_sched.scanning && !scan_flag && !scan_params_pending) {
+        /* start was refused by the controller */
+        ble_scan_exec(ble_scan_on_stopped(&scan_sched, now));
+    } else {
+        ble_scan_exec(ble_scan_poll(&scan_sched, now));
+    }
+    xSemaphoreGive(scan_lock);
+}
+
+/**
+ * @brief MQTT traffic ahead, pause scanning for hold_ms to leave the shared radio to WiFi
+ * 
+ * @param hold_ms 
+ */
+void ble_gatt_coex_burst(uint32_t hold_ms) {
+    if (scan_lock == NULL) {
+        return;
+    }
+    xSemaphoreTake(scan_lock, portMAX_DELAY);
+    ble_scan_exec(ble_scan_on_burst(&scan_sched, hold_ms, esp_timer_get_time()));
+    xSemaphoreGive(scan_lock);
+}
+
+/**
+ * @brief fill scan settings of remote configuration with the built-in ones
+ * 
+ * @param cfg [out] scan_fast, scan_slow, scan_idle_ms
+ */
+void ble_gatt_cfg_defaults(remote_cfg_t *cfg) {
+    cfg->scan_fast.interval = (uint16_t)(scan_cfg.fast.interval * BLE_SCAN_UNIT_US / 1000);
+    cfg->scan_fast.window = (uint16_t)(scan_cfg.fast.window * BLE_SCAN_UNIT_US / 1000);
+    cfg->scan_slow.interval = (uint16_t)(scan_cfg.slow.interval * BLE_SCAN_UNIT_US / 1000);
+    cfg->scan_slow.window = (uint16_t)(scan_cfg.slow.window * BLE_SCAN_UNIT_US / 1000);
+    cfg->scan_idle_ms = scan_cfg.slow_idle_ms;
+}
+
+/**
+ * @brief apply remote settings: scan duty at once, allow list to new advertisements,
+ *        links to devices no longer allowed are closed on their next notification
+ * 
+ * @param cfg 
+ */
+void ble_gatt_configure(const remote_cfg_t *cfg) {
+    if (scan_lock == NULL) {
+        return;
+    }
+    ble_scan_cfg_t next = scan_cfg;
+    next.fast.interval = (uint16_t)(cfg->scan_fast.interval * 1000 / BLE_SCAN_UNIT_US);
+    next.fast.window = (uint16_t)(cfg->scan_fast.window * 1000 / BLE_SCAN_UNIT_US);
+    next.slow.interval = (uint16_t)(cfg->scan_slow.interval * 1000 / BLE_SCAN_UNIT_US);
+    next.slow.window = (uint16_t)(cfg->scan_slow.window * 1000 / BLE_SCAN_UNIT_US);
+    next.slow_idle_ms = cfg->scan_idle_ms;
+    xSemaphoreTake(scan_lock, portMAX_DELAY);
+    link_cfg = *cfg;
+    ble_scan_exec(ble_scan_set_cfg(&scan_sched, &next, esp_timer_get_time()));
+    xSemaphoreGive(scan_lock);
+}
+
+/**
+ * @brief device passes the remote allow list
+ * 
+ * @param bda 
+ * @return true if allowed
+ */
+static bool ble_allowed(const uint8_t *bda) {
+    xSemaphoreTake(scan_lock, portMAX_DELAY);
+    bool allowed = remote_cfg_allowed(&link_cfg, bda);
+    xSemaphoreGive(scan_lock);
+    return allowed;
+}
+
+/**
+ * @brief look up notify characteristic by UUID, only the first match is used
+ *        so one element on the stack takes the result
+ * 
+ * @param gattc_if 
+ * @param conn 
+ * @param start_handle 
+ * @param end_handle 
+ * @return characteristic handle, INVALID_HANDLE if not found
+ */
+static uint16_t ble_find_notify_char(esp_gatt_if_t gattc_if, ble_conn_t *conn, uint16_t start_handle, uint16_t end_handle) {
+    esp_gattc_char_elem_t char_elem;
+    uint16_t count = 1;
+    memcpy(remote_device_char_uuid.uuid.uuid128, adv_gatt_get(conn->gatt_type)->char_uuid, ESP_UUID_LEN_128);
+    esp_gatt_status_t status = esp_ble_gattc_get_char_by_uuid(gattc_if,
+                                                              conn->conn_id,
+                                                              start_handle,
+                                                              end_handle,
+                                                              remote_device_char_uuid,
+                                                              &char_elem,
+                                                              &count);
+    if (status != ESP_GATT_OK || count == 0 || !(char_elem.properties & ESP_GATT_CHAR_PROP_BIT_NOTIFY)) {
+        ESP_LOGE(TAG, "no char found");
+        return INVALID_HANDLE;
+    }
+    return char_elem.char_handle;
+}
+
+/**
+ * @brief read handle cache from NVS and put its devices in the controller whitelist
+ * 
+ */
+static void gatt_cache_load(void) {
+    ble_cache_blob_t blob;
+    size_t len = sizeof(blob);
+    nvs_handle_t nvs;
+    ble_cache_init(&gatt_cache);
+    if (nvs_open(BLE_NVS_NAMESPACE, NVS_READONLY, &nvs) == ESP_OK) {
+        if (nvs_get_blob(nvs, BLE_NVS_KEY_CACHE, &blob, &len) == ESP_OK && !ble_cache_load(&gatt_cache, &blob, len)) {
+            ESP_LOGW(TAG, "GATT cache of other layout dropped");
+        }
+        nvs_close(nvs);
+    }
+    for (int idx = 0; idx < ble_cache_count(&gatt_cache); idx++) {
+        const ble_cache_dev_t *dev = ble_cache_get(&gatt_cache, idx);
+        gatt_whitelist(true, dev->bda, dev->addr_type);
+    }
+    ESP_LOGI(TAG, "GATT cache: %d devices", ble_cache_count(&gatt_cache));
+}
+
+/**
+ * @brief keep handles of a ready connection, whitelist follows the cached devices
+ * 
+ * @param conn 
+ */
+static void gatt_cache_store(const ble_conn_t *conn) {
+    ble_cache_dev_t entry = {
+        .addr_type = conn->addr_type,
+        .gatt_type = conn->gatt_type,
+        .service_start = conn->service_start_handle,
+        .service_end = conn->service_end_handle,
+        .char_handle = conn->char_handle,
+    };
+    ble_cache_dev_t evicted;
+    memcpy(entry.bda, conn->remote_bda, BLE_BDA_LEN);
+    ble_cache_res_t res = ble_cache_store(&gatt_cache, &entry, &evicted);
+    if (res == BLE_CACHE_REPLACED) {
+        gatt_whitelist(false, evicted.bda, evicted.addr_type);
+    }
+    if (res == BLE_CACHE_ADDED || res == BLE_CACHE_REPLACED) {
+        gatt_whitelist(true, entry.bda, entry.addr_type);
+    }
+    gatt_cache_save();
+}
+
+/**
+ * @brief write handle cache if it changed, a reconnect on valid handles writes nothing
+ * 
+ */
+static void gatt_cache_save(void) {
+    nvs_handle_t nvs;
+    if (!ble_cache_take_dirty(&gatt_cache)) {
+        return;
+    }
+    esp_err_t err = nvs_open(BLE_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(nvs, BLE_NVS_KEY_CACHE, &gatt_cache.blob, sizeof(ble_cache_blob_t));
+        if (err == ESP_OK) {
+            err = nvs_commit(nvs);
+        }
+        nvs_close(nvs);
+    }
+    if (err != ESP_OK) {
+        /* retried with the next change */
+        ESP_LOGE(TAG, "GATT cache not saved: 0x%x", err);
+        gatt_cache.dirty = true;
+    }
+}
+
+/**
+ * @brief add or remove device of the controller whitelist
+ * 
+ * @param add 
+ * @param bda 
+ * @param addr_type esp_ble_addr_type_t
+ */
+static void gatt_whitelist(bool add, const uint8_t *bda, uint8_t addr_type) {
+    esp_bd_addr_t addr;
+    memcpy(addr, bda, sizeof(esp_bd_addr_t));
+    esp_ble_gap_update_whitelist(add, addr, (addr_type == BLE_ADDR_TYPE_PUBLIC) ? BLE_WL_ADDR_TYPE_PUBLIC : BLE_WL_ADDR_TYPE_RANDOM);
+}
+
+/**
+ * @brief carry out the action requested by the connection state machine,
+ *        BLE_CONN_ACT_OPEN is handled by GAP callback as it needs the address type
+ * 
+ * @param gattc_if 
+ * @param act 
+ * @param conn 
+ */
+static void ble_conn_exec(esp_gatt_if_t gattc_if, ble_conn_act_t act, ble_conn_t *conn) {
+    const ble_cache_dev_t *cached;
+
+    switch (act) {
+    case BLE_CONN_ACT_MTU_REQ:
+        esp_ble_gattc_send_mtu_req(gattc_if, conn->conn_id);
+        cached = ble_cache_lookup(&gatt_cache, conn->remote_bda, conn->gatt_type);
+        if (cached) {
+            /* known device: notifications on without waiting for Bluedroid to discover the database */
+            act = ble_conn_on_cached(conn->conn_id, cached->service_start, cached->service_end, cached->char_handle, &conn);
+            ble_conn_exec(gattc_if, act, conn);
+        }
+        break;
+    case BLE_CONN_ACT_SEARCH:
+        memcpy(remote_device_service_uuid.uuid.uuid128, adv_gatt_get(conn->gatt_type)->service_uuid, ESP_UUID_LEN_128);
+        esp_ble_gattc_search_service(gattc_if, conn->conn_id, &remote_device_service_uuid);
+        break;
+    case BLE_CONN_ACT_GET_CHAR:
+        act = ble_conn_on_char(conn->conn_id,
+                               ble_find_notify_char(gattc_if, conn, conn->service_start_handle, conn->service_end_handle), &conn);
+        ble_conn_exec(gattc_if, act, conn);
+        break;
+    case BLE_CONN_ACT_VERIFY:
+        /* the service may have moved too, search the whole database */
+        act = ble_conn_on_verify(conn->conn_id, ble_find_notify_char(gattc_if, conn, 0x0001, 0xFFFF), &conn);
+        if (act == BLE_CONN_ACT_SEARCH) {
+            ESP_LOGW(TAG, "cached handle 0x%04x stale, rediscovering", conn->char_handle);
+        } else if (act == BLE_CONN_ACT_CLOSE && ble_cache_invalidate(&gatt_cache, conn->remote_bda)) {
+            gatt_whitelist(false, conn->remote_bda, conn->addr_type);
+            gatt_cache_save();
+        }
+        ble_conn_exec(gattc_if, act, conn);
+        break;
+    case BLE_CONN_ACT_REG_NOTIFY:
+        esp_ble_gattc_register_for_notify(gattc_if, conn->remote_bda, conn->char_handle);
+        break;
+    case BLE_CONN_ACT_CLOSE:
+        ESP_LOGE(TAG, "close conn_id %d", conn ? conn->conn_id : -1);
+        if (conn) {
+            esp_ble_gattc_close(gattc_if, conn->conn_id);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Callback function to handle GATT profile events
+ * 
+ * @param event 
+ * @param gattc_if 
+ * @param param 
+ */
+static void gattc_profile_event_handler(esp_gattc_cb_event_t event, esp_gatt_if_t gattc_if, esp_ble_gattc_cb_param_t *param) {
+    esp_ble_gattc_cb_param_t *p_data = (esp_ble_gattc_cb_param_t *)param;
+    ble_conn_t *conn = NULL;
+    ble_conn_act_t act = BLE_CONN_ACT_NONE;
+
+    ESP_LOGI(TAG, "GATT event handler: core %d\n", xPortGetCoreID());
+    switch (event) {
+    case ESP_GATTC_REG_EVT:
+        /* start scan when GATT callback is registered */
+        ESP_LOGI(TAG, "ESP_GATTC_REG_EVT");
+        ble_scan_update();
+        break;
+    case ESP_GATTC_CONNECT_EVT:
+        /* bind connection to its slot, then send MTU request */
+        ESP_LOGI(TAG, "ESP_GATTC_CONNECT_EVT conn_id %d, if %d", p_data->connect.conn_id, gattc_if);
+        ESP_LOGI(TAG, "REMOTE BDA:");
+        esp_log_buffer_hex(TAG, p_data->connect.remote_bda, sizeof(esp_bd_addr_t));
+        act = ble_conn_on_connect(p_data->connect.conn_id, p_data->connect.remote_bda, &conn);
+        xSemaphoreTake(link_lock, portMAX_DELAY);
+        ble_link_on_connect(&link_tab, p_data->connect.remote_bda, esp_timer_get_time());
+        xSemaphoreGive(link_lock);
+        if (act == BLE_CONN_ACT_MTU_REQ) {
+            conn->connect_us = esp_timer_get_time();
+        }
+        if (act == BLE_CONN_ACT_CLOSE) {
+            esp_ble_gattc_close(gattc_if, p_data->connect.conn_id);
+        } else {
+            ble_conn_exec(gattc_if, act, conn);
+        }
+        /* keep scanning for the remaining devices */
+        ble_scan_update();
+        break;
+    case ESP_GATTC_OPEN_EVT:
+        ESP_LOGI(TAG, "ESP_GATTC_OPEN_EVT status %d", p_data->open.status);
+        if (p_data->open.status != ESP_GATT_OK) {
+            ble_conn_on_open_failed(p_data->open.remote_bda);
+            ble_scan_update();
+        }
+        break;
+    case ESP_GATTC_DIS_SRVC_CMPL_EVT:
+        /* search for matched service UUID */
+        ESP_LOGI(TAG, "ESP_GATTC_DIS_SRVC_CMPL_EVT");
+        act = ble_conn_on_dis_srvc_cmpl(p_data->dis_srvc_cmpl.conn_id, &conn);
+        ble_conn_exec(gattc_if, act, conn);
+        break;
+    case ESP_GATTC_CFG_MTU_EVT:
+        ESP_LOGI(TAG, "ESP_GATTC_CFG_MTU_EVT, Status %d, MTU %d, conn_id %d", param->cfg_mtu.status, param->cfg_mtu.mtu, param->cfg_mtu.conn_id);
+        break;        
+    case ESP_GATTC_SEARCH_RES_EVT:
+        /* for each found service, check for matched UUID */
+        ESP_LOGI(TAG, "ESP_GATTC_SEARCH_RES_EVT");
+        conn = ble_conn_find_id(p_data->search_res.conn_id);
+        if (conn != NULL && p_data->search_res.srvc_id.uuid.len == ESP_UUID_LEN_128) {
+            ESP_LOGI(TAG, "Service ID:");
+            esp_log_buffer_hex(TAG, p_data->search_res.srvc_id.uuid.uuid.uuid128, ESP_UUID_LEN_128);
+            if (memcmp(p_data->search_res.srvc_id.uuid.uuid.uuid128, adv_gatt_get(conn->gatt_type)->service_uuid, ESP_UUID_LEN_128) == 0){
+                ESP_LOGI(TAG, "service UUID128 found");
+                ble_conn_on_search_res(p_data->search_res.conn_id, p_data->search_res.start_handle, p_data->search_res.end_handle);
+            } else {
+                ESP_LOGE(TAG, "service not found");
+            }
+        }
+        break;        
+    case ESP_GATTC_SEARCH_CMPL_EVT:
+        /* if service UUID is matched, check for matched characteristics */
+        ESP_LOGI(TAG, "ESP_GATTC_SEARCH_CMPL_EVT");
+        act = ble_conn_on_search_cmpl(p_data->search_cmpl.conn_id, &conn);
+        ble_conn_exec(gattc_if, act, conn);
+        break;
+    case ESP_GATTC_REG_FOR_NOTIFY_EVT:
+        ESP_LOGI(TAG, "ESP_GATTC_REG_FOR_NOTIFY_EVT");
+        act = ble_conn_on_reg_notify(p_data->reg_for_notify.handle, p_data->reg_for_notify.status == ESP_GATT_OK, &conn);
+        if (conn && conn->state == BLE_CONN_READY && p_data->reg_for_notify.status == ESP_GATT_OK) {
+            gatt_cache_store(conn);
+        }
+        ble_conn_exec(gattc_if, act, conn);
+        /* one registration at a time, the event does not say which link it is for */
+        act = ble_conn_next_reg(&conn);
+        ble_conn_exec(gattc_if, act, conn);
+        break;
+    case ESP_GATTC_NOTIFY_EVT:
+        /* send notified data via queue */
+        if (p_data->notify.is_notify){
+            int64_t rx_us = esp_timer_get_time();
+            ESP_LOGI(TAG, "ESP_GATTC_NOTIFY_EVT, receive notify value:");
+            esp_log_buffer_hex(TAG, p_data->notify.value, p_data->notify.value_len);
+            conn = ble_conn_on_notify(p_data->notify.conn_id);
+            if (conn && !ble_allowed(conn->remote_bda)) {
+                /* removed from the allow list since connected */
+                ble_conn_exec(gattc_if, BLE_CONN_ACT_CLOSE, conn);
+                break;
+            }
+            if (conn) {
+                ble_link_notify(conn);
+            }
+            adv_reading_t reading;
+            /* decoder picked when the connection was opened, no lookup per notification */
+            if (conn == NULL || p_data->notify.handle != conn->char_handle ||
+                !adv_gatt_decode(conn->gatt_type, p_data->notify.value, p_data->notify.value_len, &reading) ||
+                (reading.flags & (ADV_HAS_TEMP | ADV_HAS_HUMID)) != (ADV_HAS_TEMP | ADV_HAS_HUMID)) {
+                break;
+            }
+            if (conn->connect_us) {
+                ESP_LOGI(TAG, "dev %d first sample %lld ms after connect", ble_conn_index(conn),
+                         (long long)((esp_timer_get_time() - conn->connect_us) / 1000));
+                conn->connect_us = 0;
+            }
+            ble_sample_push(ble_conn_index(conn), reading.temp_centi, reading.humid_centi, conn->rssi, rx_us);
+        } else {
+            ESP_LOGI(TAG, "ESP_GATTC_NOTIFY_EVT, receive indicate value:");
+        }
+        break;        
+    case ESP_GATTC_DISCONNECT_EVT:
+        ESP_LOGI(TAG, "ESP_GATTC_DISCONNECT_EVT conn_id %d, reason 0x%x", p_data->disconnect.conn_id, p_data->disconnect.reason);
+        ble_conn_on_disconnect(p_data->disconnect.conn_id, p_data->disconnect.remote_bda);
+        act = ble_conn_next_reg(&conn);
+        ble_conn_exec(gattc_if, act, conn);
+        xSemaphoreTake(link_lock, portMAX_DELAY);
+        ble_link_on_disconnect(&link_tab, p_data->disconnect.remote_bda, p_data->disconnect.reason);
+        xSemaphoreGive(link_lock);
+        ble_scan_update();
+        break;        
+    default:
+        break;
+    }  
+}
+
+/**
+ * @brief track notify period of the link, read its RSSI and request connection parameters when due
+ * 
+ * @param conn 
+ */
+static void ble_link_notify(ble_conn_t *conn) {
+    ble_link_params_t req;
+    xSemaphoreTake(link_lock, portMAX_DELAY);
+    int act = ble_link_on_notify(&link_tab, conn->remote_bda, esp_timer_get_time(), &req);
+    xSemaphoreGive(link_lock);
+    if (act & BLE_LINK_ACT_READ_RSSI) {
+        esp_ble_gap_read_rssi(conn->remote_bda);
+    }
+    if (act & BLE_LINK_ACT_UPDATE) {
+        esp_ble_conn_update_params_t params = {
+            .min_int = req.interval,
+            .max_int = req.interval,
+            .latency = req.latency,
+            .timeout = req.timeout,
+        };
+        memcpy(params.bda, conn->remote_bda, sizeof(esp_bd_addr_t));
+        ESP_LOGI(TAG, "dev %d request interval %d latency %d timeout %d", ble_conn_index(conn),
+                 req.interval, req.latency, req.timeout);
+        esp_ble_gap_update_conn_params(&params);
+    }
+}
+
+/**
+ * @brief stamp reading and queue it by value to main loop
+ * 
+ * @param dev_id 
+ * @param temp_centi 0.01 degC
+ * @param humid_centi 0.01 %RH
+ * @param rssi dBm, 0 if unknown
+ * @param rx_us esp_timer_get_time() when the event came in
+ */
+static void ble_sample_push(uint16_t dev_id, int16_t temp_centi, uint16_t humid_centi, int8_t rssi, int64_t rx_us) {
+    sensor_sample_t sample = {
+        .ts_us = rx_us,
+        .dev_id = dev_id,
+        .temp_centi = temp_centi,
+        .humid_centi = humid_centi,
+        .rssi = rssi,
+    };
+    if (sample_ring_push(&sample_ring, &sample)) { // non-blocking, overflow is counted by the ring
+        PIPE_TRACE_STAMP(PIPE_TRACE_NOTIFY, sample.seq, dev_id, rx_us);
+        PIPE_TRACE_STAMP(PIPE_TRACE_RING, sample.seq, dev_id, PIPE_TRACE_NOW());
+    }
+    main_notify(MAIN_NOTIFY_SAMPLE);
+}
+
+/**
+ * @brief decode sensor values from advertisement, forward only new readings
+ * 
+ * @param scan_result 
+ * @return true if sent by a known advertising sensor, repeats included
+ */
+static bool ble_adv_process(esp_ble_gap_cb_param_t *scan_result) {
+    adv_reading_t reading;
+    bool is_new;
+    int decoder = adv_decode(scan_result->scan_rst.ble_adv,
+                             scan_result->scan_rst.adv_data_len + scan_result->scan_rst.scan_rsp_len,
+                             &reading);
+    if (decoder < 0) {
+        return false;
+    }
+    if (!ble_allowed(scan_result->scan_rst.bda)) {
+        return true;
+    }
+    uint32_t now_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    adv_dev_t *dev = adv_dev_update(scan_result->scan_rst.bda, decoder, &reading, now_ms, &is_new);
+    if (dev == NULL || !is_new || (reading.flags & (ADV_HAS_TEMP | ADV_HAS_HUMID)) != (ADV_HAS_TEMP | ADV_HAS_HUMID)) {
+        return true;
+    }
+    ESP_LOGI(TAG, "%s adv from dev %d", adv_decoder_get(decoder)->name, adv_dev_index(dev));
+    ble_sample_push(BLE_ADV_DEV_ID(adv_dev_index(dev)), reading.temp_centi, reading.humid_centi, scan_result->scan_rst.rssi,
+                    esp_timer_get_time());
+    return true;
+}
+
+/**
+ * @brief GAP callback, decode advertising sensors and connect to the ones read over GATT
+ * 
+ * @param event 
+ * @param param 
+ */
+static void esp_gap_cb(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param) {
+    int gatt_type;
+
+    ESP_LOGI(TAG, "GAP event handler: core %d\n", xPortGetCoreID());
+    switch (event) {    
+    case ESP_GAP_BLE_SCAN_PARAM_SET_COMPLETE_EVT:
+        /* start GAP scanning with new duty */
+        ESP_LOGI(TAG, "ESP_GAP_BLE_SCAN_PARAM_SET_COMPLETE_EVT");        
+        xSemaphoreTake(scan_lock, portMAX_DELAY);
+        if (scan_params_pending) {
+            scan_params_pending = false;
+            scan_flag = true;
+            esp_ble_gap_start_scanning(0);
+        }
+        xSemaphoreGive(scan_lock);
+        break;
+    case ESP_GAP_BLE_SCAN_START_COMPLETE_EVT:        
+        ESP_LOGI(TAG, "ESP_GAP_BLE_SCAN_START_COMPLETE_EVT");
+        if (param->scan_start_cmpl.status != ESP_BT_STATUS_SUCCESS) {
+            xSemaphoreTake(scan_lock, portMAX_DELAY);
+            scan_flag = false;
+            esp_timer_stop(scan_timer);
+            esp_timer_start_once(scan_timer, BLE_SCAN_RETRY_MS * 1000);
+            xSemaphoreGive(scan_lock);
+        }
+        break;
+    case ESP_GAP_BLE_SCAN_RESULT_EVT: 
+        /* for each scan result, compare device name */
+        ESP_LOGI(TAG, "ESP_GAP_BLE_SCAN_RESULT_EVT");
+        esp_ble_gap_cb_param_t *scan_result = (esp_ble_gap_cb_param_t *)param;
+        switch (scan_result->scan_rst.search_evt) {
+        case ESP_GAP_SEARCH_INQ_RES_EVT:
+            /* advertising sensors are decoded in both modes, a mixed fleet needs no build option */
+            if (ble_adv_process(scan_result) || BLE_PASSIVE_SCAN) {
+                break;
+            }
+            gatt_type = adv_gatt_match(scan_result->scan_rst.ble_adv,
+                                       scan_result->scan_rst.adv_data_len + scan_result->scan_rst.scan_rsp_len);
+            if (gatt_type >= 0 && ble_allowed(scan_result->scan_rst.bda)) {
+                ESP_LOGI(TAG, "Found %s\n", adv_gatt_get(gatt_type)->name);
+                /* open connection if device is new and a slot is free */
+                ble_conn_t *conn = NULL;
+                if (ble_conn_on_adv(scan_result->scan_rst.bda, &conn) == BLE_CONN_ACT_OPEN) {
+                    conn->rssi = scan_result->scan_rst.rssi;
+                    conn->gatt_type = (uint8_t)gatt_type;
+                    conn->addr_type = (uint8_t)scan_result->scan_rst.ble_addr_type;
+                    /* controller cannot initiate while scanning, open pending stops it */
+                    ble_scan_update();
+                    esp_ble_gattc_open(gatt_profile_tab[PROFILE_A_APP_ID].gattc_if, scan_result->scan_rst.bda, scan_result->scan_rst.ble_addr_type, true);
+                }
+            }
+            break;  
+        case ESP_GAP_SEARCH_INQ_CMPL_EVT:
+            /* scan ended by controller, re-arm if still wanted */
+            xSemaphoreTake(scan_lock, portMAX_DELAY);
+            if (scan_flag) {
+                scan_flag = false;
+                ble_scan_exec(ble_scan_on_stopped(&scan_sched, esp_timer_get_time()));
+            }
+            xSemaphoreGive(scan_lock);
+            break;
+        default:
+            break;         
+        }
+        break;
+    case ESP_GAP_BLE_SCAN_STOP_COMPLETE_EVT:
+        ESP_LOGI(TAG, "ESP_GAP_BLE_SCAN_STOP_COMPLETE_EVT");
+        break;
+    case ESP_GAP_BLE_ADV_STOP_COMPLETE_EVT:
+        ESP_LOGI(TAG, "ESP_GAP_BLE_ADV_STOP_COMPLETE_EVT");
+        break;
+    case ESP_GAP_BLE_UPDATE_WHITELIST_COMPLETE_EVT:
+        /* refused while the controller scans on the whitelist, the device is then found by the next unfiltered scan */
+        if (param->update_whitelist_cmpl.status != ESP_BT_STATUS_SUCCESS) {
+            ESP_LOGW(TAG, "whitelist update failed, status %d", param->update_whitelist_cmpl.status);
+        }
+        break;
+    case ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT:
+         ESP_LOGI(TAG, "update connection params status = %d, min_int = %d, max_int = %d,conn_int = %d,latency = %d, timeout = %d",
+                  param->update_conn_params.status,
+                  param->update_conn_params.min_int,
+                  param->update_conn_params.max_int,
+                  param->update_conn_params.conn_int,
+                  param->update_conn_params.latency,
+                  param->update_conn_params.timeout);
+        ble_link_params_t params = {
+            .interval = param->update_conn_params.conn_int,
+            .latency = param->update_conn_params.latency,
+            .timeout = param->update_conn_params.timeout,
+        };
+        xSemaphoreTake(link_lock, portMAX_DELAY);
+        ble_link_on_params(&link_tab, param->update_conn_params.bda, &params,
+                           param->update_conn_params.status == ESP_BT_STATUS_SUCCESS);
+        xSemaphoreGive(link_lock);
+        break;
+    case ESP_GAP_BLE_READ_RSSI_COMPLETE_EVT:
+        /* connection RSSI goes with the samples, the scan RSSI is only seen before connecting */
+        if (param->read_rssi_cmpl.status == ESP_BT_STATUS_SUCCESS) {
+            ble_conn_t *conn = ble_conn_find_bda(param->read_rssi_cmpl.remote_addr);
+            if (conn) {
+                conn->rssi = param->read_rssi_cmpl.rssi;
+            }
+            xSemaphoreTake(link_lock, portMAX_DELAY);
+            ble_link_on_rssi(&link_tab, param->read_rssi_cmpl.remote_addr, param->read_rssi_cmpl.rssi);
+            xSemaphoreGive(link_lock);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief link quality of tracked devices as JSON for MQTT
+ * 
+ * @param buf 
+ * @param size 
+ * @return length, 0 before init or if buf is too small
+ */
+int ble_gatt_link_json(char *buf, int size) {
+    if (link_lock == NULL) {
+        return 0;
+    }
+    xSemaphoreTake(link_lock, portMAX_DELAY);
+    int len = ble_link_json(&link_tab, buf, size);
+    xSemaphoreGive(link_lock);
+    return len;
+}
+
+/**
+ * @brief link quality of tracked devices as text lines for the GUI
+ * 
+ * @param buf 
+ * @param size 
+ * @return length, 0 before init or if buf is too small
+ */
+int ble_gatt_link_text(char *buf, int size) {
+    if (link_lock == NULL) {
+        return 0;
+    }
+    xSemaphoreTake(link_lock, portMAX_DELAY);
+    int len = ble_link_text(&link_tab, buf, size);
+    xSemaphoreGive(link_lock);
+    return len;
+}
+
+/**
+ * @brief GATT callback, forward event to be handled by gattc_profile_event_handler
+ * 
+ * @param event 
+ * @param gattc_if 
+ * @param param 
+ */
+static void esp_gattc_cb(esp_gattc_cb_event_t event, esp_gatt_if_t gattc_if, esp_ble_gattc_cb_param_t *param) {
+    if (event == ESP_GATTC_REG_EVT) {
+        if (param->reg.status == ESP_GATT_OK) {
+            gatt_profile_tab[param->reg.app_id].gattc_if = gattc_if;
+        } else {
+            ESP_LOGI(TAG, "reg app failed, app_id %04x, status %d",
+                    param->reg.app_id,
+                    param->reg.status);
+            return;
+        }
+    }
+    /* process event by corresponding profile handler */
+    for (int idx = 0; idx < PROFILE_NUM; idx++) {
+        /* ESP_GATT_IF_NONE, not specify a certain gatt_if, need to call every profile cb function */
+        if ((gattc_if == ESP_GATT_IF_NONE) || (gattc_if == gatt_profile_tab[idx].gattc_if)) {
+            if (gatt_profile_tab[idx].gattc_cb) {
+                gatt_profile_tab[idx].gattc_cb(event, gattc_if, param);
+            }
+        }
+    }
+}
+
+/**
+ * @brief initialize BLE driver
+ * 
+ */
+void ble_gatt_init() {
+    /* initialize Bluetooth module */
+    esp_bt_controller_mem_release(ESP_BT_MODE_CLASSIC_BT);
+    esp_bt_controller_config_t bt_cfg = BT_CONTROLLER_INIT_CONFIG_DEFAULT();
+    esp_bt_controller_init(&bt_cfg);
+    esp_bt_controller_enable(ESP_BT_MODE_BLE);
+    esp_bluedroid_init();
+    esp_bluedroid_enable();
+
+    /* register callback functions for GAP/GATT */
+    ble_conn_init();
+    adv_decode_init();
+    scan_lock = xSemaphoreCreateMutex();
+    ble_link_init(&link_tab, &link_policy);
+    link_lock = xSemaphoreCreateMutex();
+    const esp_timer_create_args_t timer_args = {
+        .callback = &ble_scan_timer_cb,
+        .name = "ble_scan"
+    };
+    esp_timer_create(&timer_args, &scan_timer);
+    ble_scan_init(&scan_sched, &scan_cfg, esp_timer_get_time());
+    esp_ble_gap_register_callback(esp_gap_cb);
+    gatt_cache_load();
+    esp_ble_gattc_register_callback(esp_gattc_cb);
+    esp_ble_gattc_app_register(PROFILE_A_APP_ID);
+    esp_ble_gatt_set_local_mtu(500);
 }
\ No newline at end of file
@@ -1,13 +1,16 @@
-#ifndef _BLE_GATT_H_
-#define _BLE_GATT_H_
-
-/* PUBLIC PROTOTYPES */
-void ble_gatt_init(void);
-
-/* TYPE DEFINITIONS */
-typedef struct env_sensor_msg_t {
-    float temp_val;
-    uint8_t humid_val;
-} env_sensor_msg_t;
-
+#ifndef _BLE_GATT_H_
+#define _BLE_GATT_H_
+
+#include <stdint.h>
+
+#include "remote_cfg.h"
+
+/* PUBLIC PROTOTYPES */
+void ble_gatt_init(void);
+void ble_gatt_coex_burst(uint32_t hold_ms);
+void ble_gatt_cfg_defaults(remote_cfg_t *cfg);
+void ble_gatt_configure(const remote_cfg_t *cfg);
+int ble_gatt_link_json(char *buf, int size);
+int ble_gatt_link_text(char *buf, int size);
+
 #endif
\ No newline at end of file
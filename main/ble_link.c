@@ -0,0 +1,341 @@
+#include <string.h>
+
+#include "ble_link.h"
+#include "fmt_fixed.h"
+
+/* DEFINES */
+#define REASON_LOCAL        0x16    /* HCI: terminated by local host, our own close */
+#define INTERVAL_SHARE      20      /* interval up to 1/20 of the notify period, delivery delay stays small */
+#define LATENCY_SHARE       4       /* skipped events span up to 1/4 of the period */
+#define TIMEOUT_EVENTS      6       /* supervision timeout in effective intervals, spec needs more than 2 */
+#define TIMEOUT_MIN_MS      2000
+#define TIMEOUT_MAX_MS      32000
+
+/* STATIC PROTOTYPES */
+static uint32_t clamp_u32(uint32_t val, uint32_t lo, uint32_t hi);
+static void gap_measure(ble_link_t *link, uint32_t gap_ms);
+
+/**
+ * @brief limit value to range
+ *
+ * @param val
+ * @param lo
+ * @param hi >= lo
+ * @return val within lo..hi
+ */
+static uint32_t clamp_u32(uint32_t val, uint32_t lo, uint32_t hi) {
+    return (val < lo) ? lo : (val > hi) ? hi : val;
+}
+
+/**
+ * @brief gap between two notifies: one and a half periods or more count as missed notifies,
+ *        shorter ones refine the period estimate, BLE_LINK_GAPS_MIN long ones in a row restart it
+ *        (sensor slowed down)
+ *
+ * @param link
+ * @param gap_ms
+ */
+static void gap_measure(ble_link_t *link, uint32_t gap_ms) {
+    if (link->period_ms && gap_ms >= link->period_ms + link->period_ms / 2) {
+        link->missed_count += (gap_ms + link->period_ms / 2) / link->period_ms - 1;
+        if (++link->long_gaps < BLE_LINK_GAPS_MIN) {
+            return;
+        }
+        link->period_ms = 0;
+        link->gaps = 0;
+    }
+    link->long_gaps = 0;
+    link->period_ms = link->period_ms ? (link->period_ms * 7 + gap_ms + 4) / 8 : gap_ms;
+    if (link->gaps < BLE_LINK_GAPS_MIN) {
+        link->gaps++;
+    }
+}
+
+/**
+ * @brief clear table
+ *
+ * @param tab
+ * @param cfg
+ */
+void ble_link_init(ble_link_tab_t *tab, const ble_link_cfg_t *cfg) {
+    memset(tab, 0, sizeof(ble_link_tab_t));
+    tab->cfg = *cfg;
+}
+
+/**
+ * @brief find tracked device
+ *
+ * @param tab
+ * @param bda
+ * @return entry or NULL
+ */
+ble_link_t *ble_link_find(ble_link_tab_t *tab, const uint8_t *bda) {
+    for (int idx = 0; idx < BLE_LINK_DEV_MAX; idx++) {
+        if (tab->dev[idx].used && memcmp(tab->dev[idx].bda, bda, BLE_BDA_LEN) == 0) {
+            return &tab->dev[idx];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief link up, a new device takes a free entry or the least recently connected unconnected one
+ *
+ * @param tab
+ * @param bda
+ * @param now_us
+ * @return entry or NULL if every entry is connected
+ */
+ble_link_t *ble_link_on_connect(ble_link_tab_t *tab, const uint8_t *bda, int64_t now_us) {
+    ble_link_t *link = ble_link_find(tab, bda);
+    if (link == NULL) {
+        for (int idx = 0; idx < BLE_LINK_DEV_MAX; idx++) {
+            ble_link_t *entry = &tab->dev[idx];
+            if (!entry->used) {
+                link = entry;
+                break;
+            }
+            if (!entry->connected && (link == NULL || entry->connect_us < link->connect_us)) {
+                link = entry;
+            }
+        }
+        if (link == NULL) {
+            return NULL;
+        }
+        memset(link, 0, sizeof(ble_link_t));
+        link->used = true;
+        memcpy(link->bda, bda, BLE_BDA_LEN);
+    }
+    link->connected = true;
+    link->pending = false;
+    link->connect_count++;
+    link->connect_us = now_us;
+    link->notify_us = 0;
+    link->rssi_us = 0;
+    link->request_us = 0;
+    memset(&link->params, 0, sizeof(link->params));
+    return link;
+}
+
+/**
+ * @brief link down, counted as supervision timeout or drop, our own close is not counted
+ *
+ * @param tab
+ * @param bda
+ * @param reason HCI disconnect reason, esp_gatt_conn_reason_t
+ */
+void ble_link_on_disconnect(ble_link_tab_t *tab, const uint8_t *bda, int reason) {
+    ble_link_t *link = ble_link_find(tab, bda);
+    if (link == NULL || !link->connected) {
+        return;
+    }
+    link->connected = false;
+    link->pending = false;
+    if (reason == BLE_LINK_REASON_TIMEOUT) {
+        link->timeout_count++;
+    } else if (reason != REASON_LOCAL) {
+        link->drop_count++;
+    }
+}
+
+/**
+ * @brief notification received: track period and missed notifies, due RSSI read and parameter request
+ *
+ * @param tab
+ * @param bda
+ * @param now_us
+ * @param req [out] parameters to request with BLE_LINK_ACT_UPDATE
+ * @return mask of BLE_LINK_ACT_x
+ */
+int ble_link_on_notify(ble_link_tab_t *tab, const uint8_t *bda, int64_t now_us, ble_link_params_t *req) {
+    ble_link_t *link = ble_link_find(tab, bda);
+    if (link == NULL || !link->connected) {
+        return 0;
+    }
+    int act = 0;
+    link->notify_count++;
+    if (link->notify_us) {
+        gap_measure(link, (uint32_t)((now_us - link->notify_us) / 1000));
+    }
+    link->notify_us = now_us;
+    if (link->rssi_us == 0 || now_us - link->rssi_us >= (int64_t)tab->cfg.rssi_period_ms * 1000) {
+        link->rssi_us = now_us;
+        act |= BLE_LINK_ACT_READ_RSSI;
+    }
+    ble_link_params_t target;
+    if (!link->pending && (link->request_us == 0 || now_us - link->request_us >= (int64_t)tab->cfg.retry_ms * 1000) &&
+        ble_link_target(&tab->cfg, link, &target) && memcmp(&target, &link->params, sizeof(target)) != 0) {
+        link->pending = true;
+        link->request_us = now_us;
+        *req = target;
+        act |= BLE_LINK_ACT_UPDATE;
+    }
+    return act;
+}
+
+/**
+ * @brief connection RSSI read back
+ *
+ * @param tab
+ * @param bda
+ * @param rssi dBm
+ */
+void ble_link_on_rssi(ble_link_tab_t *tab, const uint8_t *bda, int8_t rssi) {
+    ble_link_t *link = ble_link_find(tab, bda);
+    if (link == NULL) {
+        return;
+    }
+    link->rssi = rssi;
+    if (link->rssi_min == 0 || rssi < link->rssi_min) {
+        link->rssi_min = rssi;
+    }
+}
+
+/**
+ * @brief UPDATE_CONN_PARAMS_EVT, answer to our request or an update started by the peer
+ *
+ * @param tab
+ * @param bda
+ * @param params in force, ignored if not ok
+ * @param ok status success
+ */
+void ble_link_on_params(ble_link_tab_t *tab, const uint8_t *bda, const ble_link_params_t *params, bool ok) {
+    ble_link_t *link = ble_link_find(tab, bda);
+    if (link == NULL) {
+        return;
+    }
+    bool requested = link->pending;
+    link->pending = false;
+    if (!ok) {
+        link->reject_count += requested;
+        return;
+    }
+    if (memcmp(params, &link->params, sizeof(ble_link_params_t)) != 0) {
+        link->params = *params;
+        link->update_count++;
+    }
+}
+
+/**
+ * @brief parameters for a device: slow sensors get longer intervals and slave latency so more
+ *        links fit in the radio schedule, weak links keep latency 0, unstable ones their defaults
+ *
+ * @param cfg
+ * @param link
+ * @param params [out]
+ * @return false if the device is left at the parameters it has
+ */
+bool ble_link_target(const ble_link_cfg_t *cfg, const ble_link_t *link, ble_link_params_t *params) {
+    if (link->gaps < BLE_LINK_GAPS_MIN || link->period_ms < cfg->slow_ms || link->timeout_count >= cfg->timeout_max) {
+        return false;
+    }
+    uint32_t interval_ms = clamp_u32(link->period_ms / INTERVAL_SHARE, cfg->interval_min_ms, cfg->interval_max_ms);
+    uint32_t interval = interval_ms * 4 / 5;
+    interval_ms = interval * 5 / 4;
+    uint32_t latency = 0;
+    if (link->rssi == 0 || link->rssi >= cfg->rssi_weak) {
+        uint32_t events = link->period_ms / (LATENCY_SHARE * interval_ms);
+        latency = (events > 1) ? clamp_u32(events - 1, 0, cfg->latency_max) : 0;
+    }
+    uint32_t timeout_ms = clamp_u32((latency + 1) * interval_ms * TIMEOUT_EVENTS, TIMEOUT_MIN_MS, TIMEOUT_MAX_MS);
+    params->interval = (uint16_t)interval;
+    params->latency = (uint16_t)latency;
+    params->timeout = (uint16_t)(timeout_ms / 10);
+    return true;
+}
+
+/**
+ * @brief JSON array, one object per tracked device:
+ *        [{"bda":"a4:c1:38:00:00:01","up":1,"rssi":-72,"rssi_min":-80,"n":120,"miss":2,"conn":3,"to":1,"drop":0,
+ *          "upd":1,"rej":0,"per":6000,"int":150.00,"lat":4,"tmo":3600}]
+ *
+ * @param tab
+ * @param buf
+ * @param size at least BLE_LINK_JSON_LEN + 1
+ * @return length without terminator, 0 if buf is too small
+ */
+int ble_link_json(const ble_link_tab_t *tab, char *buf, int size) {
+    if (size <= BLE_LINK_JSON_LEN) {
+        return 0;
+    }
+    int len = fmt_str(buf, "[");
+    for (int idx = 0; idx < BLE_LINK_DEV_MAX; idx++) {
+        const ble_link_t *link = &tab->dev[idx];
+        if (!link->used) {
+            continue;
+        }
+        len += fmt_str(&buf[len], (len > 1) ? ",{\"bda\":\"" : "{\"bda\":\"");
+        len += fmt_bda(&buf[len], link->bda);
+        len += fmt_str(&buf[len], "\",\"up\":");
+        len += fmt_u32(&buf[len], link->connected);
+        len += fmt_str(&buf[len], ",\"rssi\":");
+        len += fmt_i32(&buf[len], link->rssi);
+        len += fmt_str(&buf[len], ",\"rssi_min\":");
+        len += fmt_i32(&buf[len], link->rssi_min);
+        len += fmt_str(&buf[len], ",\"n\":");
+        len += fmt_u32(&buf[len], link->notify_count);
+        len += fmt_str(&buf[len], ",\"miss\":");
+        len += fmt_u32(&buf[len], link->missed_count);
+        len += fmt_str(&buf[len], ",\"conn\":");
+        len += fmt_u32(&buf[len], link->connect_count);
+        len += fmt_str(&buf[len], ",\"to\":");
+        len += fmt_u32(&buf[len], link->timeout_count);
+        len += fmt_str(&buf[len], ",\"drop\":");
+        len += fmt_u32(&buf[len], link->drop_count);
+        len += fmt_str(&buf[len], ",\"upd\":");
+        len += fmt_u32(&buf[len], link->update_count);
+        len += fmt_str(&buf[len], ",\"rej\":");
+        len += fmt_u32(&buf[len], link->reject_count);
+        len += fmt_str(&buf[len], ",\"per\":");
+        len += fmt_u32(&buf[len], link->period_ms);
+        len += fmt_str(&buf[len], ",\"int\":");
+        len += fmt_centi(&buf[len], (int32_t)link->params.interval * 125, 2);
+        len += fmt_str(&buf[len], ",\"lat\":");
+        len += fmt_u32(&buf[len], link->params.latency);
+        len += fmt_str(&buf[len], ",\"tmo\":");
+        len += fmt_u32(&buf[len], (uint32_t)link->params.timeout * 10);
+        buf[len++] = '}';
+    }
+    buf[len++] = ']';
+    buf[len] = '\0';
+    return len;
+}
+
+/**
+ * @brief text for the debug screen, one line per tracked device
+ *
+ * @param tab
+ * @param buf
+ * @param size at least BLE_LINK_TEXT_LEN + 1
+ * @return length without terminator, 0 if buf is too small
+ */
+int ble_link_text(const ble_link_tab_t *tab, char *buf, int size) {
+    if (size <= BLE_LINK_TEXT_LEN) {
+        return 0;
+    }
+    int len = 0;
+    for (int idx = 0; idx < BLE_LINK_DEV_MAX; idx++) {
+        const ble_link_t *link = &tab->dev[idx];
+        if (!link->used) {
+            continue;
+        }
+        len += fmt_bda(&buf[len], link->bda);
+        if (link->connected) {
+            buf[len++] = ' ';
+            len += fmt_i32(&buf[len], link->rssi);
+            len += fmt_str(&buf[len], " dBm ");
+            len += fmt_centi(&buf[len], (int32_t)link->params.interval * 125, 2);
+            len += fmt_str(&buf[len], " ms L");
+            len += fmt_u32(&buf[len], link->params.latency);
+        } else {
+            len += fmt_str(&buf[len], " down");
+        }
+        len += fmt_str(&buf[len], " miss ");
+        len += fmt_u32(&buf[len], link->missed_count);
+        len += fmt_str(&buf[len], " to ");
+        len += fmt_u32(&buf[len], link->timeout_count);
+        buf[len++] = '\n';
+    }
+    buf[len] = '\0';
+    return len;
+}
@@ -0,0 +1,83 @@
+#ifndef _BLE_LINK_H_
+#define _BLE_LINK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ble_conn.h"
+
+/* DEFINES */
+#define BLE_LINK_DEV_MAX        8           /* devices tracked, least recently connected one is replaced */
+#define BLE_LINK_REASON_TIMEOUT 0x08        /* HCI disconnect reason: supervision timeout, ESP_GATT_CONN_TIMEOUT */
+#define BLE_LINK_GAPS_MIN       3           /* notify gaps seen before the period is trusted */
+#define BLE_LINK_DEV_JSON       264         /* worst-case JSON per device */
+#define BLE_LINK_JSON_LEN       (2 + BLE_LINK_DEV_MAX * BLE_LINK_DEV_JSON)
+#define BLE_LINK_DEV_TEXT       80          /* worst-case debug text per device */
+#define BLE_LINK_TEXT_LEN       (BLE_LINK_DEV_MAX * BLE_LINK_DEV_TEXT)
+
+/* actions for the GAP glue, returned as a mask by ble_link_on_notify */
+#define BLE_LINK_ACT_READ_RSSI  0x01        /* esp_ble_gap_read_rssi() */
+#define BLE_LINK_ACT_UPDATE     0x02        /* esp_ble_gap_update_conn_params() with the returned parameters */
+
+/* TYPE DEFINITIONS */
+/* connection parameters in HCI units */
+typedef struct ble_link_params_t {
+    uint16_t interval;          /* 1.25 ms */
+    uint16_t latency;           /* connection events the peripheral may skip */
+    uint16_t timeout;           /* supervision timeout, 10 ms */
+} ble_link_params_t;
+
+typedef struct ble_link_cfg_t {
+    uint32_t rssi_period_ms;    /* connection RSSI read per device */
+    uint32_t retry_ms;          /* least time between parameter requests of one device */
+    uint32_t slow_ms;           /* notify period from which a sensor gets longer intervals */
+    uint16_t interval_min_ms;
+    uint16_t interval_max_ms;
+    uint16_t latency_max;
+    int8_t rssi_weak;           /* dBm, below this no slave latency */
+    uint8_t timeout_max;        /* supervision timeouts after which a device is left at its defaults */
+} ble_link_cfg_t;
+
+/* one device, kept across connections */
+typedef struct ble_link_t {
+    bool used;
+    bool connected;
+    bool pending;               /* parameter update requested, no UPDATE_CONN_PARAMS_EVT yet */
+    int8_t rssi;                /* dBm of the connection, 0 before the first read */
+    int8_t rssi_min;
+    uint8_t gaps;               /* notify gaps measured, saturates at BLE_LINK_GAPS_MIN */
+    uint8_t long_gaps;          /* gaps in a row counted as missed notifies */
+    uint8_t bda[BLE_BDA_LEN];
+    uint32_t period_ms;         /* estimated notify period, 0: unknown */
+    uint32_t notify_count;
+    uint32_t missed_count;      /* notifies missing from gaps longer than the period */
+    uint32_t connect_count;
+    uint32_t timeout_count;     /* supervision timeouts */
+    uint32_t drop_count;        /* other disconnects */
+    uint32_t update_count;      /* parameter updates in force */
+    uint32_t reject_count;      /* parameter requests refused by the peer or controller */
+    int64_t connect_us;         /* last connect, least recent one is replaced */
+    int64_t notify_us;          /* last notify of this connection, 0: none yet */
+    int64_t rssi_us;            /* last RSSI read request */
+    int64_t request_us;         /* last parameter request */
+    ble_link_params_t params;   /* in force, interval 0: not reported yet */
+} ble_link_t;
+
+typedef struct ble_link_tab_t {
+    ble_link_cfg_t cfg;
+    ble_link_t dev[BLE_LINK_DEV_MAX];
+} ble_link_tab_t;
+
+/* PUBLIC PROTOTYPES */
+void ble_link_init(ble_link_tab_t *tab, const ble_link_cfg_t *cfg);
+ble_link_t *ble_link_find(ble_link_tab_t *tab, const uint8_t *bda);
+ble_link_t *ble_link_on_connect(ble_link_tab_t *tab, const uint8_t *bda, int64_t now_us);
+void ble_link_on_disconnect(ble_link_tab_t *tab, const uint8_t *bda, int reason);
+int ble_link_on_notify(ble_link_tab_t *tab, const uint8_t *bda, int64_t now_us, ble_link_params_t *req);
+void ble_link_on_rssi(ble_link_tab_t *tab, const uint8_t *bda, int8_t rssi);
+void ble_link_on_params(ble_link_tab_t *tab, const uint8_t *bda, const ble_link_params_t *params, bool ok);
+bool ble_link_target(const ble_link_cfg_t *cfg, const ble_link_t *link, ble_link_params_t *params);
+int ble_link_json(const ble_link_tab_t *tab, char *buf, int size);
+int ble_link_text(const ble_link_tab_t *tab, char *buf, int size);
+
+#endif
@@ -0,0 +1,258 @@
+#include <string.h>
+
+#include "ble_scan.h"
+
+/* DEFINES */
+#define MS_TO_US(ms)    ((int64_t)(ms) * 1000)
+
+/* STATIC PROTOTYPES */
+static ble_scan_state_t scan_decide(ble_scan_t *scan, int64_t now_us);
+static ble_scan_act_t scan_apply(ble_scan_t *scan, int64_t now_us);
+static void scan_stopped(ble_scan_t *scan, int64_t now_us);
+
+/**
+ * @brief pick state from links, pause and mode timers
+ *
+ * @param scan
+ * @param now_us
+ * @return new state
+ */
+static ble_scan_state_t scan_decide(ble_scan_t *scan, int64_t now_us) {
+    const ble_scan_cfg_t *cfg = &scan->cfg;
+    bool fast = (cfg->fast_max_ms == 0) || (now_us - scan->fast_since_us < MS_TO_US(cfg->fast_max_ms));
+    if (!scan->slot_free) {
+        scan->slow_since_us = -1;
+        return BLE_SCAN_OFF;
+    }
+    if (now_us < scan->pause_until_us) {
+        return BLE_SCAN_PAUSED;
+    }
+    if (fast) {
+        scan->slow_since_us = -1;
+        return BLE_SCAN_FAST;
+    }
+    scan->reconnecting = false;
+    /* sparse scan cycles, the first one starts with a scan */
+    int64_t cycle_us = MS_TO_US(cfg->slow_scan_ms + cfg->slow_idle_ms);
+    if (scan->slow_since_us < 0) {
+        scan->slow_since_us = now_us;
+    } else if (now_us - scan->slow_since_us >= cycle_us) {
+        scan->slow_since_us += cycle_us * ((now_us - scan->slow_since_us) / cycle_us);
+    }
+    return (now_us - scan->slow_since_us < MS_TO_US(cfg->slow_scan_ms)) ? BLE_SCAN_SLOW : BLE_SCAN_SLOW_IDLE;
+}
+
+/**
+ * @brief account scan time of stopped scan
+ *
+ * @param scan
+ * @param now_us
+ */
+static void scan_stopped(ble_scan_t *scan, int64_t now_us) {
+    if (scan->scanning) {
+        scan->scanning = false;
+        scan->scan_on_us += now_us - scan->scan_since_us;
+    }
+}
+
+/**
+ * @brief update state, request start/stop if the radio should change
+ *
+ * @param scan
+ * @param now_us
+ * @return action for the GAP glue
+ */
+static ble_scan_act_t scan_apply(ble_scan_t *scan, int64_t now_us) {
+    scan->state = scan_decide(scan, now_us);
+    scan->eval_us = now_us;
+    if (scan->state == BLE_SCAN_FAST || scan->state == BLE_SCAN_SLOW) {
+        ble_scan_params_t params = (scan->state == BLE_SCAN_FAST) ? scan->cfg.fast : scan->cfg.slow;
+        /* sparse scans also look for new devices */
+        params.known_only = scan->state == BLE_SCAN_FAST && scan->reconnecting && scan->whitelist;
+        if (scan->scanning && params.interval == scan->params.interval && params.window == scan->params.window &&
+            params.known_only == scan->params.known_only) {
+            return BLE_SCAN_ACT_NONE;
+        }
+        scan_stopped(scan, now_us);
+        scan->params = params;
+        scan->scanning = true;
+        scan->scan_since_us = now_us;
+        scan->start_count++;
+        return BLE_SCAN_ACT_START;
+    }
+    if (scan->scanning) {
+        scan_stopped(scan, now_us);
+        return BLE_SCAN_ACT_STOP;
+    }
+    return BLE_SCAN_ACT_NONE;
+}
+
+/**
+ * @brief reset scheduler, discovery starts in fast mode once a slot is reported free
+ *
+ * @param scan
+ * @param cfg
+ * @param now_us
+ */
+void ble_scan_init(ble_scan_t *scan, const ble_scan_cfg_t *cfg, int64_t now_us) {
+    memset(scan, 0, sizeof(ble_scan_t));
+    scan->cfg = *cfg;
+    scan->state = BLE_SCAN_OFF;
+    scan->fast_since_us = now_us;
+    scan->slow_since_us = -1;
+    scan->eval_us = now_us;
+}
+
+/**
+ * @brief whitelist holds every device a link can be lost to, so the fast scan
+ *        after a link loss may filter on it, applied with the next decision
+ *
+ * @param scan
+ * @param usable false while devices are known only by advertisement
+ */
+void ble_scan_set_whitelist(ble_scan_t *scan, bool usable) {
+    scan->whitelist = usable;
+}
+
+/**
+ * @brief new duty and timing, a running scan is restarted if its parameters changed
+ *
+ * @param scan
+ * @param cfg
+ * @param now_us
+ * @return action
+ */
+ble_scan_act_t ble_scan_set_cfg(ble_scan_t *scan, const ble_scan_cfg_t *cfg, int64_t now_us) {
+    scan->cfg = *cfg;
+    return scan_apply(scan, now_us);
+}
+
+/**
+ * @brief connection table changed: connect, disconnect, open issued or failed
+ *
+ * @param scan
+ * @param connected links past CONNECT_EVT
+ * @param slot_free a slot is free and no open is pending
+ * @param now_us
+ * @return action
+ */
+ble_scan_act_t ble_scan_on_links(ble_scan_t *scan, int connected, bool slot_free, int64_t now_us) {
+    if (connected < scan->connected) {
+        /* link lost, look for the device again at full rate */
+        scan->fast_since_us = now_us;
+        scan->reconnecting = true;
+    } else if (connected > scan->connected) {
+        if (connected > scan->known) {
+            /* new device, more may be around */
+            scan->fast_since_us = now_us;
+            scan->reconnecting = false;
+        } else if (connected == scan->known) {
+            /* every known device is back */
+            scan->fast_since_us = now_us - MS_TO_US(scan->cfg.fast_max_ms);
+            scan->reconnecting = false;
+        }
+    }
+    if (connected > scan->known) {
+        scan->known = connected;
+    }
+    scan->connected = connected;
+    scan->slot_free = slot_free;
+    return scan_apply(scan, now_us);
+}
+
+/**
+ * @brief MQTT burst ahead, leave the radio to WiFi for hold_ms,
+ *        pauses longer than pause_max_ms are cut and followed by pause_gap_ms of scanning
+ *
+ * @param scan
+ * @param hold_ms
+ * @param now_us
+ * @return action
+ */
+ble_scan_act_t ble_scan_on_burst(ble_scan_t *scan, uint32_t hold_ms, int64_t now_us) {
+    ble_scan_state_t state = scan_decide(scan, now_us);
+    if ((state != BLE_SCAN_FAST && state != BLE_SCAN_SLOW && state != BLE_SCAN_PAUSED) || now_us < scan->pause_block_us) {
+        /* radio not scanning or pause budget used up */
+        return scan_apply(scan, now_us);
+    }
+    if (state != BLE_SCAN_PAUSED) {
+        scan->pause_since_us = now_us;
+        scan->pause_count++;
+    }
+    int64_t until = now_us + MS_TO_US(hold_ms);
+    int64_t limit = scan->pause_since_us + MS_TO_US(scan->cfg.pause_max_ms);
+    if (until >= limit) {
+        until = limit;
+        scan->pause_block_us = limit + MS_TO_US(scan->cfg.pause_gap_ms);
+    }
+    if (until > scan->pause_until_us) {
+        scan->pause_until_us = until;
+    }
+    return scan_apply(scan, now_us);
+}
+
+/**
+ * @brief controller stopped scanning on its own: duration elapsed or start failed
+ *
+ * @param scan
+ * @param now_us
+ * @return action, START if scanning is still wanted
+ */
+ble_scan_act_t ble_scan_on_stopped(ble_scan_t *scan, int64_t now_us) {
+    scan_stopped(scan, now_us);
+    return scan_apply(scan, now_us);
+}
+
+/**
+ * @brief timer expired, see ble_scan_deadline
+ *
+ * @param scan
+ * @param now_us
+ * @return action
+ */
+ble_scan_act_t ble_scan_poll(ble_scan_t *scan, int64_t now_us) {
+    return scan_apply(scan, now_us);
+}
+
+/**
+ * @brief next time the decision may change without an event
+ *
+ * @param scan
+ * @return time in us, INT64_MAX if only events can change it
+ */
+int64_t ble_scan_deadline(const ble_scan_t *scan) {
+    const ble_scan_cfg_t *cfg = &scan->cfg;
+    int64_t deadline = INT64_MAX;
+    int64_t due[3] = {INT64_MAX, INT64_MAX, INT64_MAX};
+    if (scan->state == BLE_SCAN_OFF) {
+        return INT64_MAX;
+    }
+    if (scan->state == BLE_SCAN_PAUSED) {
+        due[0] = scan->pause_until_us;
+    }
+    if (cfg->fast_max_ms > 0) {
+        due[1] = scan->fast_since_us + MS_TO_US(cfg->fast_max_ms);
+    }
+    if (scan->slow_since_us >= 0) {
+        int64_t scan_end = scan->slow_since_us + MS_TO_US(cfg->slow_scan_ms);
+        due[2] = (scan->eval_us < scan_end) ? scan_end : scan->slow_since_us + MS_TO_US(cfg->slow_scan_ms + cfg->slow_idle_ms);
+    }
+    for (int idx = 0; idx < 3; idx++) {
+        /* only future changes, past ones are already applied */
+        if (due[idx] > scan->eval_us && due[idx] < deadline) {
+            deadline = due[idx];
+        }
+    }
+    return deadline;
+}
+
+/**
+ * @brief total scanning time, for duty cycle
+ *
+ * @param scan
+ * @param now_us
+ * @return us
+ */
+int64_t ble_scan_on_time(const ble_scan_t *scan, int64_t now_us) {
+    return scan->scan_on_us + (scan->scanning ? now_us - scan->scan_since_us : 0);
+}
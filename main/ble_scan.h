@@ -0,0 +1,77 @@
+#ifndef _BLE_SCAN_H_
+#define _BLE_SCAN_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* DEFINES */
+#define BLE_SCAN_UNIT_US    625     /* scan interval/window unit */
+
+/* TYPE DEFINITIONS */
+/* scheduler state, what the radio should be doing */
+typedef enum {
+    BLE_SCAN_OFF = 0,       /* no free slot or an open is pending, nothing to discover */
+    BLE_SCAN_FAST,          /* devices missing, continuous high duty scan */
+    BLE_SCAN_SLOW,          /* all known devices connected, short sparse scan */
+    BLE_SCAN_SLOW_IDLE,     /* between sparse scans */
+    BLE_SCAN_PAUSED,        /* MQTT burst, radio left to WiFi */
+} ble_scan_state_t;
+
+/* request to the GAP glue */
+typedef enum {
+    BLE_SCAN_ACT_NONE = 0,
+    BLE_SCAN_ACT_START,     /* (re)start scanning with ble_scan_t.params, stop first if scanning */
+    BLE_SCAN_ACT_STOP,
+} ble_scan_act_t;
+
+/* duty cycle of one scan mode, in BLE_SCAN_UNIT_US */
+typedef struct ble_scan_params_t {
+    uint16_t interval;
+    uint16_t window;
+    bool known_only;    /* controller whitelist filter, only set in ble_scan_t.params */
+} ble_scan_params_t;
+
+typedef struct ble_scan_cfg_t {
+    ble_scan_params_t fast;
+    ble_scan_params_t slow;
+    uint32_t fast_max_ms;       /* fall back to slow scans if nothing was found, 0: never */
+    uint32_t slow_scan_ms;      /* length of one sparse scan */
+    uint32_t slow_idle_ms;      /* gap between sparse scans */
+    uint32_t pause_max_ms;      /* longest pause for MQTT bursts */
+    uint32_t pause_gap_ms;      /* scan time owed after a maximal pause before pausing again */
+} ble_scan_cfg_t;
+
+typedef struct ble_scan_t {
+    ble_scan_cfg_t cfg;
+    ble_scan_state_t state;
+    ble_scan_params_t params;   /* duty of the scan running or requested */
+    bool scanning;              /* START issued and not stopped since */
+    bool slot_free;             /* a connection could be opened */
+    bool whitelist;             /* every device we may lose is in the controller whitelist */
+    bool reconnecting;          /* fast scan after link loss, only known devices are looked for */
+    int connected;
+    int known;                  /* most devices connected at once, devices we expect back */
+    int64_t fast_since_us;      /* start of current discovery window */
+    int64_t slow_since_us;      /* start of current sparse scan cycle, -1 outside slow mode */
+    int64_t pause_since_us;
+    int64_t pause_until_us;
+    int64_t pause_block_us;     /* no new pause before this time */
+    int64_t eval_us;            /* time of last decision */
+    int64_t scan_since_us;      /* controller scanning since */
+    int64_t scan_on_us;         /* total time scanning */
+    uint32_t start_count;
+    uint32_t pause_count;
+} ble_scan_t;
+
+/* PUBLIC PROTOTYPES */
+void ble_scan_init(ble_scan_t *scan, const ble_scan_cfg_t *cfg, int64_t now_us);
+void ble_scan_set_whitelist(ble_scan_t *scan, bool usable);
+ble_scan_act_t ble_scan_set_cfg(ble_scan_t *scan, const ble_scan_cfg_t *cfg, int64_t now_us);
+ble_scan_act_t ble_scan_on_links(ble_scan_t *scan, int connected, bool slot_free, int64_t now_us);
+ble_scan_act_t ble_scan_on_burst(ble_scan_t *scan, uint32_t hold_ms, int64_t now_us);
+ble_scan_act_t ble_scan_on_stopped(ble_scan_t *scan, int64_t now_us);
+ble_scan_act_t ble_scan_poll(ble_scan_t *scan, int64_t now_us);
+int64_t ble_scan_deadline(const ble_scan_t *scan);
+int64_t ble_scan_on_time(const ble_scan_t *scan, int64_t now_us);
+
+#endif
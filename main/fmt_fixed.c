@@ -0,0 +1,187 @@
+#include "fmt_fixed.h"
+
+/**
+ * @brief decimal of unsigned value, no terminator
+ *
+ * @param buf at least FMT_U32_LEN chars
+ * @param val
+ * @return length written
+ */
+int fmt_u32(char *buf, uint32_t val) {
+    char tmp[FMT_U32_LEN];
+    int len = 0;
+    do {
+        tmp[len++] = (char)('0' + val % 10);
+        val /= 10;
+    } while (val);
+    for (int i = 0; i < len; i++) {
+        buf[i] = tmp[len - 1 - i];
+    }
+    return len;
+}
+
+/**
+ * @brief decimal of signed value, no terminator
+ *
+ * @param buf at least FMT_I32_LEN chars
+ * @param val
+ * @return length written
+ */
+int fmt_i32(char *buf, int32_t val) {
+    if (val < 0) {
+        buf[0] = '-';
+        return 1 + fmt_u32(buf + 1, (uint32_t)0 - (uint32_t)val);
+    }
+    return fmt_u32(buf, (uint32_t)val);
+}
+
+/**
+ * @brief decimal of 64-bit unsigned value, e.g. esp_timer_get_time(), no terminator
+ *
+ * @param buf at least FMT_U64_LEN chars
+ * @param val
+ * @return length written
+ */
+int fmt_u64(char *buf, uint64_t val) {
+    if (val <= UINT32_MAX) {
+        return fmt_u32(buf, (uint32_t)val);
+    }
+    /* one 64-bit division, the low 9 digits zero padded */
+    int len = fmt_u64(buf, val / 1000000000u);
+    uint32_t low = (uint32_t)(val % 1000000000u);
+    for (int i = 8; i >= 0; i--) {
+        buf[len + i] = (char)('0' + low % 10);
+        low /= 10;
+    }
+    return len + 9;
+}
+
+/**
+ * @brief fixed-point value in hundredths, e.g. 2345 -> "23.45" or "23.5", no terminator
+ *
+ * @param buf at least FMT_CENTI_LEN chars
+ * @param centi value x 100
+ * @param decimals 0..2, rounded half away from zero
+ * @return length written
+ */
+int fmt_centi(char *buf, int32_t centi, int decimals) {
+    static const uint32_t div[] = {100, 10, 1};
+    int len = 0;
+    uint32_t mag = (centi < 0) ? (uint32_t)0 - (uint32_t)centi : (uint32_t)centi;
+    uint32_t scaled = (mag + div[decimals] / 2) / div[decimals];
+    if (centi < 0 && scaled != 0) {
+        buf[len++] = '-';
+    }
+    if (decimals == 0) {
+        return len + fmt_u32(&buf[len], scaled);
+    }
+    uint32_t unit = (decimals == 1) ? 10 : 100;
+    len += fmt_u32(&buf[len], scaled / unit);
+    buf[len++] = '.';
+    uint32_t frac = scaled % unit;
+    if (decimals == 2) {
+        buf[len++] = (char)('0' + frac / 10);
+    }
+    buf[len++] = (char)('0' + frac % 10);
+    return len;
+}
+
+/**
+ * @brief copy string, no terminator
+ *
+ * @param buf
+ * @param str
+ * @return length written
+ */
+int fmt_str(char *buf, const char *str) {
+    int len = 0;
+    while (str[len]) {
+        buf[len] = str[len];
+        len++;
+    }
+    return len;
+}
+
+/**
+ * @brief Bluetooth address as "a4:c1:38:00:00:01", no terminator
+ *
+ * @param buf at least FMT_BDA_LEN chars
+ * @param bda 6 bytes
+ * @return length written
+ */
+int fmt_bda(char *buf, const uint8_t *bda) {
+    static const char hex[] = "0123456789abcdef";
+    int len = 0;
+    for (int idx = 0; idx < 6; idx++) {
+        if (idx > 0) {
+            buf[len++] = ':';
+        }
+        buf[len++] = hex[bda[idx] >> 4];
+        buf[len++] = hex[bda[idx] & 0x0F];
+    }
+    return len;
+}
+
+/**
+ * @brief JSON object of sample: {"dev":1,"seq":7,"temp":23.45,"humid":53.00}, no terminator
+ *
+ * @param buf at least FMT_SAMPLE_JSON_LEN chars
+ * @param sample
+ * @param with_dev include device id
+ * @return length written
+ */
+int fmt_sample_json(char *buf, const sensor_sample_t *sample, bool with_dev) {
+    int len = 0;
+    if (with_dev) {
+        len += fmt_str(&buf[len], "{\"dev\":");
+        len += fmt_u32(&buf[len], sample->dev_id);
+        len += fmt_str(&buf[len], ",\"seq\":");
+    } else {
+        len += fmt_str(&buf[len], "{\"seq\":");
+    }
+    len += fmt_u32(&buf[len], sample->seq);
+    len += fmt_str(&buf[len], ",\"temp\":");
+    len += fmt_centi(&buf[len], sample->temp_centi, 2);
+    len += fmt_str(&buf[len], ",\"humid\":");
+    len += fmt_centi(&buf[len], sample->humid_centi, 2);
+    buf[len++] = '}';
+    return len;
+}
+
+/**
+ * @brief JSON object of summary: {"dev":1,"seq":7,"n":12,"temp":[min,mean,max],"humid":[min,mean,max]},
+ *        no terminator
+ *
+ * @param buf at least FMT_AGG_JSON_LEN chars
+ * @param rec count > 0, see sample_agg.c
+ * @param with_dev include device id
+ * @return length written
+ */
+int fmt_agg_json(char *buf, const sensor_sample_t *rec, bool with_dev) {
+    int len = 0;
+    if (with_dev) {
+        len += fmt_str(&buf[len], "{\"dev\":");
+        len += fmt_u32(&buf[len], rec->dev_id);
+        len += fmt_str(&buf[len], ",\"seq\":");
+    } else {
+        len += fmt_str(&buf[len], "{\"seq\":");
+    }
+    len += fmt_u32(&buf[len], rec->seq);
+    len += fmt_str(&buf[len], ",\"n\":");
+    len += fmt_u32(&buf[len], rec->count);
+    len += fmt_str(&buf[len], ",\"temp\":[");
+    len += fmt_centi(&buf[len], rec->temp_min_centi, 2);
+    buf[len++] = ',';
+    len += fmt_centi(&buf[len], rec->temp_centi, 2);
+    buf[len++] = ',';
+    len += fmt_centi(&buf[len], rec->temp_max_centi, 2);
+    len += fmt_str(&buf[len], "],\"humid\":[");
+    len += fmt_centi(&buf[len], rec->humid_min_centi, 2);
+    buf[len++] = ',';
+    len += fmt_centi(&buf[len], rec->humid_centi, 2);
+    buf[len++] = ',';
+    len += fmt_centi(&buf[len], rec->humid_max_centi, 2);
+    buf[len++] = ']';
+    buf[len++] = '}';
+    return len;
+}
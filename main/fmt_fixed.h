@@ -0,0 +1,28 @@
+#ifndef _FMT_FIXED_H_
+#define _FMT_FIXED_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sample_ring.h"
+
+/* DEFINES */
+#define FMT_U32_LEN         10      /* max chars of fmt_u32 */
+#define FMT_I32_LEN         11      /* max chars of fmt_i32 */
+#define FMT_U64_LEN         20      /* max chars of fmt_u64 */
+#define FMT_CENTI_LEN       (FMT_I32_LEN + 1)
+#define FMT_BDA_LEN         17      /* chars of fmt_bda */
+#define FMT_SAMPLE_JSON_LEN 64      /* max chars of fmt_sample_json */
+#define FMT_AGG_JSON_LEN    104     /* max chars of fmt_agg_json */
+
+/* PUBLIC PROTOTYPES */
+int fmt_u32(char *buf, uint32_t val);
+int fmt_i32(char *buf, int32_t val);
+int fmt_u64(char *buf, uint64_t val);
+int fmt_centi(char *buf, int32_t centi, int decimals);
+int fmt_str(char *buf, const char *str);
+int fmt_bda(char *buf, const uint8_t *bda);
+int fmt_sample_json(char *buf, const sensor_sample_t *sample, bool with_dev);
+int fmt_agg_json(char *buf, const sensor_sample_t *rec, bool with_dev);
+
+#endif
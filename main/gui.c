@@ -4,21 +4,97 @@
 #include "lvgl_helpers.h"
 
 #include "gui.h"
+#include "fmt_fixed.h"
+#include "power_mgr.h"
+#if CONFIG_PM_ENABLE
+#include "esp_pm.h"
+#include "soc/rtc.h"
+#endif
 
 
 /* DEFINES */
 #define LV_TICK_PERIOD_MS   25
 #define SCR_WIDTH           320
 #define SCR_HEIGHT          240
+#define GUI_BAND_PX         ((SCR_WIDTH*SCR_HEIGHT)/10) /* pixels of a band buffer */
+#define GUI_BAND_BUFS       2       /* next band drawn while the previous one is sent by DMA, the panel driver waits for
+                                       the previous transfer in its flush so more buffers don't help (bench.py --bands) */
+#define GUI_LINE_LEN        64
+#define GUI_CELL_LEN        16
+#if defined(CONFIG_LV_TOUCH_CONTROLLER) && !defined(CONFIG_LV_TOUCH_CONTROLLER_NONE)
+#define GUI_HAS_TOUCH       1
+#define GUI_PAGE_CYCLE_MS   0       /* pages switched by header button */
+#else
+#define GUI_HAS_TOUCH       0
+#define GUI_PAGE_CYCLE_MS   10000   /* no input device, alternate main and debug page */
+#endif
+#define GUI_AGE_PERIOD_MS   1000    /* age column refresh, cells are set only when the shown text changes */
+#define GUI_CHART_POINTS    60      /* readings of the selected sensor in the trend */
+#define GUI_CHART_HEIGHT    80
+#define GUI_CHART_TEMP_MAX  400     /* 0.1 degC, primary axis 0..40 degC */
+#define GUI_CHART_HUMID_MAX 100     /* %RH, secondary axis */
+#define GUI_NO_SENSOR       (-1)
+#define GUI_OFF_MS          60000   /* display off without touch nor network change, 0: always on */
+#define GUI_OFF_IDLE_PCT    90      /* lv_task_get_idle() needed, no animation or redraw running */
+#define GUI_OFF_POLL_MS     200     /* status and touch check while the display is off */
+
+/* TYPE DEFINITIONS */
+/* sensor table columns, row 0 is the header, row idx + 1 shows status entry idx */
+typedef enum {
+    GUI_COL_SENSOR = 0,
+    GUI_COL_TEMP,
+    GUI_COL_HUMID,
+    GUI_COL_RSSI,
+    GUI_COL_AGE,
+    GUI_COL_MAX,
+} gui_col_t;
 
 /* STATIC VARIABLES */
+static const char *const COL_TXT[GUI_COL_MAX] = {"Sensor", "degC", "%RH", "dBm", "Age"};
+static const lv_coord_t COL_W[GUI_COL_MAX] = {64, 60, 52, 52, 60};
 static lv_obj_t* main_page = NULL;
-static lv_obj_t* sensor_txt = NULL;
+static lv_obj_t* net_txt = NULL;
+static lv_obj_t* trend_chart = NULL;
+static lv_chart_series_t* temp_ser = NULL;
+static lv_chart_series_t* humid_ser = NULL;
+static lv_obj_t* sensor_table = NULL;
+static lv_obj_t* debug_page = NULL;
+static lv_obj_t* debug_txt = NULL;
 static lv_disp_buf_t disp_buf;
+static esp_timer_handle_t tick_timer;
+#if GUI_HAS_TOUCH
+static lv_indev_drv_t indev_drv;
+static lv_indev_t *touch_indev = NULL;
+#endif
+static power_mgr_t gui_power;               /* GUI task only */
+static power_mgr_t gui_power_pub;           /* copy for gui_power_stat, under gui_power_lock */
+static SemaphoreHandle_t gui_power_lock = NULL;
+#if CONFIG_PM_ENABLE
+static esp_pm_lock_handle_t gui_pm_lock;    /* held while the display is on */
+#endif
+static status_view_t gui_view;     /* last status rendered */
+static int gui_sel = GUI_NO_SENSOR; /* status entry shown in the trend chart */
 
 /* STATIC PROTOTYPES */
 static void lv_tick_cb(void *arg);
+static void gui_power_init(void);
+static void gui_power_set(bool on);
+static void gui_power_publish(void);
+static void gui_backlight(bool on);
+static bool gui_touched(void);
 static void gui_create_main_page(void);
+static void gui_create_debug_page(void);
+static void gui_page_btn_cb(lv_obj_t *btn, lv_event_t event);
+static void gui_page_cycle_cb(lv_task_t *task);
+static void gui_page_toggle(void);
+static uint32_t gui_status_render(void);
+static void gui_cell_set(int idx, int col, const char *txt);
+static void gui_sensor_render(int idx);
+static void gui_age_render(int idx, int64_t now_us);
+static void gui_age_cb(lv_task_t *task);
+static void gui_chart_add(int idx);
+static void gui_select(int idx);
+static void gui_table_cb(lv_obj_t *table, lv_event_t event);
 
 /**
  * @brief GUI task function: create GUI components
@@ -30,12 +106,14 @@ void gui_task_fcn(void *pvParameter) {
     lv_init();
     lvgl_driver_init();
 
-    /* prepare display buffer from heap */
+    /* prepare ring of band buffers from DMA heap */
     lv_disp_drv_t disp_drv;
-    lv_color_t* px_buf = heap_caps_malloc(DISP_BUF_SIZE * sizeof(lv_color_t), MALLOC_CAP_DMA);
-    assert(px_buf != NULL);
-    uint32_t size_in_px = (SCR_WIDTH*SCR_HEIGHT)/10; //DISP_BUF_SIZE;
-    lv_disp_buf_init(&disp_buf, px_buf, NULL, size_in_px);
+    void* px_bufs[GUI_BAND_BUFS];
+    for (int i = 0; i < GUI_BAND_BUFS; i++) {
+        px_bufs[i] = heap_caps_malloc(GUI_BAND_PX * sizeof(lv_color_t), MALLOC_CAP_DMA);
+        assert(px_bufs[i] != NULL);
+    }
+    lv_disp_buf_init_ring(&disp_buf, px_bufs, GUI_BAND_BUFS, GUI_BAND_PX);
     lv_disp_drv_init(&disp_drv);
     disp_drv.hor_res  = SCR_WIDTH;
     disp_drv.ver_res  = SCR_HEIGHT;
@@ -43,28 +121,58 @@ void gui_task_fcn(void *pvParameter) {
     disp_drv.flush_cb = disp_driver_flush;
     disp_drv.buffer = &disp_buf;
     lv_disp_drv_register(&disp_drv);
+#if GUI_HAS_TOUCH
+    lv_indev_drv_init(&indev_drv);
+    indev_drv.read_cb = touch_driver_read;
+    indev_drv.type = LV_INDEV_TYPE_POINTER;
+    touch_indev = lv_indev_drv_register(&indev_drv);
+#endif
 
     /* Create and start a periodic timer interrupt to call lv_tick_inc */
     const esp_timer_create_args_t tick_timer_args = {
         .callback = &lv_tick_cb,
         .name = "periodic_gui"
     };
-    esp_timer_handle_t tick_timer;
     esp_timer_create(&tick_timer_args, &tick_timer);
     esp_timer_start_periodic(tick_timer, LV_TICK_PERIOD_MS * 1000);
 
     gui_create_main_page();
+    gui_create_debug_page();
+    if (GUI_PAGE_CYCLE_MS > 0) {
+        lv_task_create(gui_page_cycle_cb, GUI_PAGE_CYCLE_MS, LV_TASK_PRIO_LOW, NULL);
+    }
+    lv_task_create(gui_age_cb, GUI_AGE_PERIOD_MS, LV_TASK_PRIO_LOW, NULL);
 
+    status_view_init(&gui_view);
+    gui_power_init();
     while (1) {         
-        if (xSemaphoreTake(label_txt_sem, pdMS_TO_TICKS(LV_TICK_PERIOD_MS)) == pdPASS ) {
-            lv_label_set_text(sensor_txt, label_txt);
-            xSemaphoreGive(label_txt_sem);
-        }        
+        /* no lock, widgets are set only for fields with a new version */
+        uint32_t in = 0;
+        if (status_snap_read(&status_snap, &gui_view) > 0) {
+            in = gui_status_render();
+        }
+        if (gui_power.state == POWER_MGR_OFF && gui_touched()) {
+            in |= POWER_MGR_IN_TOUCH;
+        }
+        /* display off on touch inactivity, readings are redrawn without lighting it */
+        power_mgr_act_t act = power_mgr_step(&gui_power, in, lv_disp_get_inactive_time(NULL), lv_task_get_idle(),
+                                             esp_timer_get_time());
+        if (act != POWER_MGR_ACT_NONE) {
+            gui_power_set(act == POWER_MGR_ACT_ON);
+        }
+        if (gui_power.state == POWER_MGR_OFF) {
+            /* LVGL suspended, widgets keep collecting changes until the display is on again */
+            vTaskDelay(pdMS_TO_TICKS(GUI_OFF_POLL_MS));
+            continue;
+        }
         lv_task_handler();        
+        vTaskDelay(pdMS_TO_TICKS(LV_TICK_PERIOD_MS));
     }
 
     /* A task should NEVER return */
-    free(px_buf);
+    for (int i = 0; i < GUI_BAND_BUFS; i++) {
+        free(px_bufs[i]);
+    }
     vTaskDelete(NULL);
 }
 
@@ -78,17 +186,377 @@ static void lv_tick_cb(void *arg) {
 }
 
 /**
- * @brief create main page for GUI
+ * @brief start with display on, light sleep allowed only while it is off
+ * 
+ */
+static void gui_power_init(void) {
+    power_mgr_init(&gui_power, &(power_mgr_cfg_t){GUI_OFF_MS, GUI_OFF_IDLE_PCT}, esp_timer_get_time());
+    gui_power_pub = gui_power;
+    gui_power_lock = xSemaphoreCreateMutex();
+#if CONFIG_PM_ENABLE
+    /* automatic light sleep when all tasks block, BLE and WiFi keep their links in modem sleep */
+    esp_pm_config_esp32_t pm_cfg = {
+        .max_freq_mhz = CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = rtc_clk_xtal_freq_get(),     /* detected crystal in MHz, CONFIG_ESP32_XTAL_FREQ is 0 on auto */
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+        .light_sleep_enable = true,
+#endif
+    };
+    ESP_ERROR_CHECK(esp_pm_configure(&pm_cfg));
+    ESP_ERROR_CHECK(esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "gui", &gui_pm_lock));
+    esp_pm_lock_acquire(gui_pm_lock);
+#endif
+}
+
+/**
+ * @brief turn display on or off, LVGL tick runs only while it is on
+ * 
+ * @param on 
+ */
+static void gui_power_set(bool on) {
+    if (on) {
+#if CONFIG_PM_ENABLE
+        esp_pm_lock_acquire(gui_pm_lock);
+#endif
+        /* tick was stopped, inactive time would still read as before the display went off */
+        lv_disp_trig_activity(NULL);
+        esp_timer_start_periodic(tick_timer, LV_TICK_PERIOD_MS * 1000);
+#if GUI_HAS_TOUCH
+        /* the touch that woke the display is not a click */
+        lv_indev_wait_release(touch_indev);
+#endif
+        gui_backlight(true);
+    } else {
+        gui_backlight(false);
+        esp_timer_stop(tick_timer);
+#if CONFIG_PM_ENABLE
+        esp_pm_lock_release(gui_pm_lock);
+#endif
+    }
+    gui_power_publish();
+}
+
+/**
+ * @brief copy power state for gui_power_stat, only on changes, time in state is counted by the reader
+ * 
+ */
+static void gui_power_publish(void) {
+    xSemaphoreTake(gui_power_lock, portMAX_DELAY);
+    gui_power_pub = gui_power;
+    xSemaphoreGive(gui_power_lock);
+}
+
+/**
+ * @brief display power since boot, called by the metrics sampler
+ * 
+ * @param stat 
+ * @return false before the GUI task started
+ */
+bool gui_power_stat(sys_power_stat_t *stat) {
+    if (gui_power_lock == NULL) {
+        return false;
+    }
+    int64_t now_us = esp_timer_get_time();
+    xSemaphoreTake(gui_power_lock, portMAX_DELAY);
+    stat->on_s = (uint32_t)(power_mgr_time(&gui_power_pub, POWER_MGR_ON, now_us) / 1000000);
+    stat->off_s = (uint32_t)(power_mgr_time(&gui_power_pub, POWER_MGR_OFF, now_us) / 1000000);
+    stat->off_count = gui_power_pub.off_count;
+    xSemaphoreGive(gui_power_lock);
+    return true;
+}
+
+/**
+ * @brief backlight and panel sleep, controller RAM keeps the picture
+ * 
+ * @param on 
+ */
+static void gui_backlight(bool on) {
+#if defined(CONFIG_LV_TFT_DISPLAY_CONTROLLER_ILI9341)
+    if (on) {
+        ili9341_sleep_out();
+        ili9341_enable_backlight(true);
+    } else {
+        ili9341_enable_backlight(false);
+        ili9341_sleep_in();
+    }
+#endif
+}
+
+/**
+ * @brief touch panel pressed, read directly while LVGL is suspended
+ * 
+ * @return true if pressed
+ */
+static bool gui_touched(void) {
+#if GUI_HAS_TOUCH
+    lv_indev_data_t data;
+    memset(&data, 0, sizeof(data));
+    touch_driver_read(&indev_drv, &data);
+    return data.state == LV_INDEV_STATE_PR;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief create main page for GUI: network status, trend of the selected sensor, one table row per sensor
  * 
  */
 static void gui_create_main_page() {
     // show init screen
     main_page = lv_win_create(lv_scr_act(), NULL);
     lv_win_set_title(main_page, "BLE2MQTT");
-    // create text label
-    sensor_txt = lv_label_create(main_page, NULL);
-    lv_label_set_long_mode(sensor_txt, LV_LABEL_LONG_BREAK);
-    lv_obj_set_width(sensor_txt, SCR_WIDTH-30);
-    lv_label_set_recolor(sensor_txt, true);
-    lv_label_set_text(sensor_txt, "Booting");
+    lv_win_set_layout(main_page, LV_LAYOUT_COLUMN_LEFT);
+    net_txt = lv_label_create(main_page, NULL);
+    lv_label_set_text(net_txt, "Booting");
+    // circular update: a new point redraws only a strip of the chart
+    trend_chart = lv_chart_create(main_page, NULL);
+    lv_obj_set_size(trend_chart, SCR_WIDTH-30, GUI_CHART_HEIGHT);
+    lv_chart_set_type(trend_chart, LV_CHART_TYPE_LINE);
+    lv_chart_set_update_mode(trend_chart, LV_CHART_UPDATE_MODE_CIRCULAR);
+    lv_chart_set_point_count(trend_chart, GUI_CHART_POINTS);
+    lv_chart_set_div_line_count(trend_chart, 3, 0);
+    lv_chart_set_y_range(trend_chart, LV_CHART_AXIS_PRIMARY_Y, 0, GUI_CHART_TEMP_MAX);
+    lv_chart_set_y_range(trend_chart, LV_CHART_AXIS_SECONDARY_Y, 0, GUI_CHART_HUMID_MAX);
+    lv_obj_set_style_local_size(trend_chart, LV_CHART_PART_SERIES, LV_STATE_DEFAULT, 0);
+    temp_ser = lv_chart_add_series(trend_chart, LV_COLOR_RED);
+    humid_ser = lv_chart_add_series(trend_chart, LV_COLOR_BLUE);
+    lv_chart_set_series_axis(trend_chart, humid_ser, LV_CHART_AXIS_SECONDARY_Y);
+    // sensor table, rows added as sensors appear
+    sensor_table = lv_table_create(main_page, NULL);
+    lv_obj_set_style_local_text_font(sensor_table, LV_TABLE_PART_CELL1, LV_STATE_DEFAULT, lv_theme_get_font_small());
+    lv_obj_set_style_local_pad_top(sensor_table, LV_TABLE_PART_CELL1, LV_STATE_DEFAULT, 2);
+    lv_obj_set_style_local_pad_bottom(sensor_table, LV_TABLE_PART_CELL1, LV_STATE_DEFAULT, 2);
+    lv_obj_set_style_local_pad_left(sensor_table, LV_TABLE_PART_CELL1, LV_STATE_DEFAULT, 4);
+    lv_obj_set_style_local_pad_right(sensor_table, LV_TABLE_PART_CELL1, LV_STATE_DEFAULT, 4);
+    lv_table_set_col_cnt(sensor_table, GUI_COL_MAX);
+    lv_table_set_row_cnt(sensor_table, 1);
+    for (int col = 0; col < GUI_COL_MAX; col++) {
+        lv_table_set_col_width(sensor_table, col, COL_W[col]);
+        lv_table_set_cell_value(sensor_table, 0, col, COL_TXT[col]);
+    }
+    lv_obj_set_event_cb(sensor_table, gui_table_cb);
+    lv_obj_t *btn = lv_win_add_btn_right(main_page, LV_SYMBOL_SETTINGS);
+    lv_obj_set_event_cb(btn, gui_page_btn_cb);
+}
+
+/**
+ * @brief create debug page with task, queue and heap metrics, hidden at start
+ * 
+ */
+static void gui_create_debug_page(void) {
+    debug_page = lv_win_create(lv_scr_act(), NULL);
+    lv_win_set_title(debug_page, "BLE2MQTT debug");
+    debug_txt = lv_label_create(debug_page, NULL);
+    lv_label_set_long_mode(debug_txt, LV_LABEL_LONG_BREAK);
+    lv_obj_set_width(debug_txt, SCR_WIDTH-30);
+    lv_obj_set_style_local_text_font(debug_txt, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, lv_theme_get_font_small());
+    lv_label_set_text(debug_txt, "Waiting for metrics");
+    lv_obj_t *btn = lv_win_add_btn_right(debug_page, LV_SYMBOL_HOME);
+    lv_obj_set_event_cb(btn, gui_page_btn_cb);
+    lv_obj_set_hidden(debug_page, true);
+}
+
+/**
+ * @brief update widgets of status fields changed by the last status_snap_read
+ * 
+ * @return POWER_MGR_IN_NET and POWER_MGR_IN_READING for a network or sensor change, metrics give none
+ */
+static uint32_t gui_status_render(void) {
+    char line[GUI_LINE_LEN];
+    int len;
+    uint32_t in = 0;
+    if (STATUS_VIEW_CHANGED(&gui_view, STATUS_FIELD_NET)) {
+        in |= POWER_MGR_IN_NET;
+        len = fmt_str(line, "WiFi: ");
+        len += fmt_u32(&line[len], gui_view.data.net.wifi);
+        len += fmt_str(&line[len], ", MQTT: ");
+        len += fmt_u32(&line[len], gui_view.data.net.mqtt);
+        line[len] = '\0';
+        lv_label_set_text(net_txt, line);
+    }
+    if (STATUS_VIEW_CHANGED(&gui_view, STATUS_FIELD_METRICS)) {
+        lv_label_set_text(debug_txt, gui_view.data.metrics);
+    }
+    int64_t now_us = esp_timer_get_time();
+    for (int idx = 0; idx < STATUS_SENSOR_MAX; idx++) {
+        if (STATUS_VIEW_CHANGED(&gui_view, STATUS_FIELD_SENSOR + idx)) {
+            in |= POWER_MGR_IN_READING;
+            if (gui_sel == GUI_NO_SENSOR) {
+                gui_sel = idx;
+            }
+            gui_sensor_render(idx);
+            gui_age_render(idx, now_us);
+            if (idx == gui_sel) {
+                gui_chart_add(idx);
+            }
+        }
+    }
+    return in;
+}
+
+/**
+ * @brief set a table cell if the shown text differs, only that cell is redrawn
+ * 
+ * @param idx status entry
+ * @param col GUI_COL_x
+ * @param txt 
+ */
+static void gui_cell_set(int idx, int col, const char *txt) {
+    uint16_t row = idx + 1;
+    if (row < lv_table_get_row_cnt(sensor_table) && strcmp(lv_table_get_cell_value(sensor_table, row, col), txt) == 0) {
+        return;
+    }
+    lv_table_set_cell_value(sensor_table, row, col, txt);
+}
+
+/**
+ * @brief sensor, temperature, humidity and RSSI cells of a sensor row
+ * 
+ * @param idx status entry
+ */
+static void gui_sensor_render(int idx) {
+    const status_sensor_t *sensor = &gui_view.data.sensor[idx];
+    char cell[GUI_CELL_LEN];
+    int len;
+    len = fmt_str(cell, (idx == gui_sel) ? ">" : "");
+    len += fmt_u32(&cell[len], sensor->dev_id);
+    cell[len] = '\0';
+    gui_cell_set(idx, GUI_COL_SENSOR, cell);
+    len = fmt_centi(cell, sensor->temp_centi, 1);
+    cell[len] = '\0';
+    gui_cell_set(idx, GUI_COL_TEMP, cell);
+    len = fmt_u32(cell, (sensor->humid_centi + 50) / 100);
+    cell[len] = '\0';
+    gui_cell_set(idx, GUI_COL_HUMID, cell);
+    if (sensor->rssi == 0) {
+        gui_cell_set(idx, GUI_COL_RSSI, "-");
+    } else {
+        len = fmt_i32(cell, sensor->rssi);
+        cell[len] = '\0';
+        gui_cell_set(idx, GUI_COL_RSSI, cell);
+    }
+}
+
+/**
+ * @brief age cell of a sensor row, coarse steps so the text changes rarely
+ * 
+ * @param idx status entry
+ * @param now_us esp_timer_get_time()
+ */
+static void gui_age_render(int idx, int64_t now_us) {
+    char cell[GUI_CELL_LEN];
+    int len;
+    int64_t age_s = (now_us - gui_view.data.sensor[idx].ts_us) / 1000000;
+    if (age_s < 10) {
+        len = fmt_str(cell, "now");
+    } else if (age_s < 60) {
+        len = fmt_u32(cell, (uint32_t)(age_s / 10 * 10));
+        len += fmt_str(&cell[len], " s");
+    } else if (age_s < 3600) {
+        len = fmt_u32(cell, (uint32_t)(age_s / 60));
+        len += fmt_str(&cell[len], " min");
+    } else {
+        len = fmt_u32(cell, (uint32_t)(age_s / 3600));
+        len += fmt_str(&cell[len], " h");
+    }
+    cell[len] = '\0';
+    gui_cell_set(idx, GUI_COL_AGE, cell);
+}
+
+/**
+ * @brief age readings without a new sample
+ * 
+ * @param task 
+ */
+static void gui_age_cb(lv_task_t *task) {
+    int64_t now_us = esp_timer_get_time();
+    for (int idx = 0; idx < STATUS_SENSOR_MAX && gui_view.data.sensor[idx].used; idx++) {
+        gui_age_render(idx, now_us);
+    }
+}
+
+/**
+ * @brief append reading of a sensor to the trend
+ * 
+ * @param idx status entry
+ */
+static void gui_chart_add(int idx) {
+    const status_sensor_t *sensor = &gui_view.data.sensor[idx];
+    lv_coord_t temp = LV_MATH_MAX(0, LV_MATH_MIN(GUI_CHART_TEMP_MAX, sensor->temp_centi / 10));
+    lv_coord_t humid = LV_MATH_MIN(GUI_CHART_HUMID_MAX, (sensor->humid_centi + 50) / 100);
+    lv_chart_set_next(trend_chart, temp_ser, temp);
+    lv_chart_set_next(trend_chart, humid_ser, humid);
+}
+
+/**
+ * @brief show another sensor in the trend, history starts over
+ * 
+ * @param idx status entry
+ */
+static void gui_select(int idx) {
+    if (idx == gui_sel || idx < 0 || idx >= STATUS_SENSOR_MAX || !gui_view.data.sensor[idx].used) {
+        return;
+    }
+    int prev = gui_sel;
+    gui_sel = idx;
+    if (prev != GUI_NO_SENSOR) {
+        gui_sensor_render(prev);
+    }
+    gui_sensor_render(idx);
+    lv_chart_clear_series(trend_chart, temp_ser);
+    lv_chart_clear_series(trend_chart, humid_ser);
+    gui_chart_add(idx);
+    lv_chart_refresh(trend_chart);
+}
+
+/**
+ * @brief touched row selects the sensor of the trend
+ * 
+ * @param table 
+ * @param event 
+ */
+static void gui_table_cb(lv_obj_t *table, lv_event_t event) {
+    uint16_t row;
+    if (event == LV_EVENT_CLICKED && lv_table_get_pressed_cell(table, &row, NULL) == LV_RES_OK && row > 0) {
+        gui_select(row - 1);
+    }
+}
+
+/**
+ * @brief show the other page
+ * 
+ */
+static void gui_page_toggle(void) {
+    bool show_debug = lv_obj_get_hidden(debug_page);
+    lv_obj_set_hidden(debug_page, !show_debug);
+    lv_obj_set_hidden(main_page, show_debug);
+}
+
+/**
+ * @brief header button of either page
+ * 
+ * @param btn 
+ * @param event 
+ */
+static void gui_page_btn_cb(lv_obj_t *btn, lv_event_t event) {
+    if (event == LV_EVENT_CLICKED) {
+        gui_page_toggle();
+    }
+}
+
+/**
+ * @brief switch page periodically when there is no touch input, next sensor in the trend on each return to main page
+ * 
+ * @param task 
+ */
+static void gui_page_cycle_cb(lv_task_t *task) {
+    gui_page_toggle();
+    if (!lv_obj_get_hidden(main_page) && gui_sel != GUI_NO_SENSOR) {
+        int next = gui_sel + 1;
+        if (next >= STATUS_SENSOR_MAX || !gui_view.data.sensor[next].used) {
+            next = 0;
+        }
+        gui_select(next);
+    }
 }
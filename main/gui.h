@@ -1,9 +1,14 @@
 #ifndef _GUI_H
 #define _GUI_H
 
+#include <stdbool.h>
+
+#include "sys_metrics.h"
+
 /**********************
  *  PUBLIC PROTOTYPES
  **********************/
 void gui_task_fcn(void *pvParameter);
+bool gui_power_stat(sys_power_stat_t *stat);
 
 #endif
\ No newline at end of file
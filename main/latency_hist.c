@@ -0,0 +1,65 @@
+#include <string.h>
+
+#include "latency_hist.h"
+
+/**
+ * @brief clear histogram
+ *
+ * @param hist
+ */
+void latency_hist_init(latency_hist_t *hist) {
+    memset(hist, 0, sizeof(latency_hist_t));
+}
+
+/**
+ * @brief count one latency value in its log2 bin
+ *
+ * @param hist
+ * @param latency_us negative values are counted as 0
+ */
+void latency_hist_add(latency_hist_t *hist, int64_t latency_us) {
+    uint32_t us = (latency_us < 0) ? 0 : (latency_us > UINT32_MAX) ? UINT32_MAX : (uint32_t)latency_us;
+    int idx = 0;
+    while ((us >> (idx + 1)) != 0 && idx < LATENCY_HIST_BINS - 1) {
+        idx++;
+    }
+    hist->bin[idx]++;
+    hist->count++;
+    hist->sum_us += us;
+    if (us > hist->max_us) {
+        hist->max_us = us;
+    }
+}
+
+/**
+ * @brief upper bound of the bin holding the given percentile
+ *
+ * @param hist
+ * @param pct 0..100
+ * @return latency in us, 0 if empty
+ */
+uint32_t latency_hist_percentile(const latency_hist_t *hist, uint32_t pct) {
+    if (hist->count == 0) {
+        return 0;
+    }
+    uint32_t rank = (uint32_t)(((uint64_t)hist->count * pct + 99) / 100);
+    uint32_t acc = 0;
+    for (int idx = 0; idx < LATENCY_HIST_BINS - 1; idx++) {
+        acc += hist->bin[idx];
+        if (acc >= rank && acc > 0) {
+            uint32_t upper = (2u << idx) - 1;
+            return upper < hist->max_us ? upper : hist->max_us;
+        }
+    }
+    return hist->max_us;
+}
+
+/**
+ * @brief mean latency
+ *
+ * @param hist
+ * @return latency in us, 0 if empty
+ */
+uint32_t latency_hist_mean(const latency_hist_t *hist) {
+    return hist->count ? (uint32_t)(hist->sum_us / hist->count) : 0;
+}
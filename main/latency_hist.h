@@ -0,0 +1,23 @@
+#ifndef _LATENCY_HIST_H_
+#define _LATENCY_HIST_H_
+
+#include <stdint.h>
+
+/* DEFINES */
+#define LATENCY_HIST_BINS   24      /* bin i counts [2^i, 2^(i+1)) us, last bin open ended */
+
+/* TYPE DEFINITIONS */
+typedef struct latency_hist_t {
+    uint32_t bin[LATENCY_HIST_BINS];
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t sum_us;
+} latency_hist_t;
+
+/* PUBLIC PROTOTYPES */
+void latency_hist_init(latency_hist_t *hist);
+void latency_hist_add(latency_hist_t *hist, int64_t latency_us);
+uint32_t latency_hist_percentile(const latency_hist_t *hist, uint32_t pct);
+uint32_t latency_hist_mean(const latency_hist_t *hist);
+
+#endif
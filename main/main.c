@@ -2,31 +2,438 @@
 
 #include "driver/gpio.h"
 #include "nvs_flash.h"
+#include "nvs.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
 
 #include "gui.h"
 #include "ble_gatt.h"
 #include "wifi_mqtt.h"
+#include "fmt_fixed.h"
+#include "latency_hist.h"
+#include "ble_link.h"
+#include "mqtt_batch.h"
+#include "mqtt_window.h"
+#include "remote_cfg.h"
+#include "sample_agg.h"
+#include "sample_backlog.h"
+#include "sys_metrics.h"
+#include "pipe_trace.h"
 
 /* DEFINES */
 #define TAG "BLE2MQTT"
-
-const char LABEL_TXT_TMPL[] = "Demo app for TESA Tech Update: RTOS\n"
-                              "Feb 25, 2022 by Supachai Vorapojpisut\n"
-                              "WiFi: %d, MQTT: %d\n"
-                              "Temperature: %.1f degC\n"
-                              "Humidity: %d %%RH\n";
+#define LATENCY_LOG_COUNT   100     /* log latency histogram every N samples */
+#define BATCH_FORMAT        MQTT_BATCH_FMT_JSON
+#define BATCH_COUNT         16      /* publish when this many samples are pending */
+#define BATCH_WINDOW_MS     1000    /* or when the oldest one is this old */
+#define BATCH_ROUTE         false   /* true: one topic per device */
+#define AGG_WINDOW_MS       0       /* e.g. 60000: per-minute min/max/mean per device, 0: forward every reading */
+#define AGG_TEMP_DEADBAND   0       /* 0.01 degC, e.g. 20: skip summaries that moved less, report bigger steps at once */
+#define AGG_HUMID_DEADBAND  0       /* 0.01 %RH */
+#define AGG_MAX_SILENT_MS   900000  /* summary sent at least this often despite the deadband */
+#define BACKLOG_CAPACITY    512     /* samples kept while MQTT is down */
+#define BACKLOG_DRAIN_RATE  20      /* samples/s replayed after reconnect, on top of live traffic */
+#define BACKLOG_DRAIN_BURST 16
+#define BACKLOG_FILE        NULL    /* e.g. "/spiffs/backlog.bin" once a filesystem is mounted, NULL: RAM */
+#define GUI_TASK_STACK      (4096*2)
+#define METRICS_PERIOD_MS   5000    /* task/heap sampling, published to MQTT_TOPIC/metrics */
+#define COEX_BURST_HOLD_MS  100     /* BLE scan pause around each MQTT publish, shared 2.4 GHz radio */
+#define PUBLISH_QOS         1       /* 0: fire and forget, window never fills */
+#define PUBLISH_WINDOW      4       /* batches awaiting PUBACK before samples are held in the ring */
+#define PUBLISH_ACK_TIMEOUT_MS  2000
+#define PUBLISH_MAX_TRIES   5       /* then the batch is dropped, 0: retry forever */
+#define CONFIG_NVS_NAMESPACE    "cfg"
+#define CONFIG_NVS_KEY      "remote"    /* remote_cfg_t, written on each change received over MQTT */
+#define TRACE_PERIOD_MS     60000   /* with PIPE_TRACE_ENABLE: next capture starts this long after a dump */
 
 /* PUBLIC VARIABLES */
+TaskHandle_t main_task = NULL;
 EventGroupHandle_t net_evt_group;
-QueueHandle_t env_sensor_q;
-SemaphoreHandle_t label_txt_sem;
-char label_txt[200] = {0};
+sample_ring_t sample_ring;
+status_snap_t status_snap;     /* written by main task only, read by GUI */
 
 /* STATIC VARIABLES */
 static bool wifi_status_flag = false;
 static bool mqtt_status_flag = false;
-static float temp_val = 0.0;
-static uint8_t humid_val = 0;
+static latency_hist_t publish_latency;
+static mqtt_batch_t publish_batch;
+static mqtt_window_t publish_window;
+static sample_agg_t sample_agg;
+static remote_cfg_t remote_cfg;     /* batch, aggregation and BLE settings, defaults above until changed remotely */
+static char config_cmd[REMOTE_CFG_MSG_MAX];
+static char config_text[REMOTE_CFG_TEXT_LEN + 1];
+static sensor_sample_t backlog_buf[BACKLOG_CAPACITY];
+static sample_store_t backlog_store;
+static sample_backlog_t backlog;
+static sys_metrics_t metrics;
+static int metrics_q_ring;
+static int metrics_q_batch;
+static int metrics_q_backlog;
+static int metrics_q_window;
+#if configUSE_TRACE_FACILITY
+static TaskStatus_t task_status[SYS_METRICS_TASK_MAX];
+#endif
+static sys_task_stat_t task_stat[SYS_METRICS_TASK_MAX];
+static char metrics_json[SYS_METRICS_JSON_LEN + 1];
+static char links_json[BLE_LINK_JSON_LEN + 1];
+#if PIPE_TRACE_ENABLE
+static char trace_json[PIPE_TRACE_CHUNK + 1];
+static int64_t trace_next_us;      /* next capture starts, 0: capturing */
+#endif
+
+/* STATIC PROTOTYPES */
+static void agg_emit_cb(const sensor_sample_t *rec, void *ctx);
+static void batch_publish_cb(int dev_id, const uint8_t *data, int len, void *ctx);
+static int window_send_cb(int dev_id, const uint8_t *data, int len, void *ctx);
+static bool publish_held(void);
+static TickType_t batch_wait_ticks(void);
+static void config_init(void);
+static void config_save(void);
+static void config_apply(int changed);
+static void config_report(void);
+static void config_process(void);
+static void backlog_init(void);
+static void backlog_sink_cb(const sensor_sample_t *sample, void *ctx);
+static void backlog_spill_batch(void);
+static void metrics_init(void);
+static void metrics_timer_cb(void *arg);
+static void metrics_sample(void);
+#if PIPE_TRACE_ENABLE
+static void trace_poll(void);
+#endif
+
+/**
+ * @brief summary or reading out of the aggregation stage: batched, or kept in backlog while MQTT is down
+ * 
+ * @param rec 
+ * @param ctx unused
+ */
+static void agg_emit_cb(const sensor_sample_t *rec, void *ctx) {
+    if (mqtt_status_flag) {
+        mqtt_batch_add(&publish_batch, rec, esp_timer_get_time());
+    } else {
+        sample_backlog_store(&backlog, rec);
+    }
+}
+
+/**
+ * @brief hand encoded batch to the publish window, kept there until acknowledged
+ * 
+ * @param dev_id 
+ * @param data 
+ * @param len 
+ * @param ctx unused
+ */
+static void batch_publish_cb(int dev_id, const uint8_t *data, int len, void *ctx) {
+    if (!mqtt_window_publish(&publish_window, dev_id, data, len, esp_timer_get_time())) {
+        ESP_LOGW(TAG, "publish window overflow, batch of %d bytes dropped", len);
+    }
+}
+
+/**
+ * @brief forward batch or its retry to MQTT client
+ * 
+ * @param dev_id 
+ * @param data 
+ * @param len 
+ * @param ctx unused
+ * @return msg_id, see mqtt_publish_data
+ */
+static int window_send_cb(int dev_id, const uint8_t *data, int len, void *ctx) {
+    ble_gatt_coex_burst(COEX_BURST_HOLD_MS);
+    return mqtt_publish_data(dev_id, data, len, PUBLISH_QOS);
+}
+
+/**
+ * @brief backpressure: window is full, samples stay in the ring and no new batch is built
+ * 
+ * @return true if held
+ */
+static bool publish_held(void) {
+    return mqtt_status_flag && mqtt_window_full(&publish_window);
+}
+
+/**
+ * @brief time to wait until aggregation window, pending batch, backlog drain or PUBACK timeout is due
+ * 
+ * @return ticks, portMAX_DELAY if nothing pending
+ */
+static TickType_t batch_wait_ticks(void) {
+    int64_t now = esp_timer_get_time();
+    int64_t deadline = mqtt_window_deadline(&publish_window);
+    if (!publish_held()) {
+        int64_t batch_us = mqtt_batch_deadline(&publish_batch);
+        int64_t agg_us = sample_agg_deadline(&sample_agg);
+        deadline = (batch_us < deadline) ? batch_us : deadline;
+        deadline = (agg_us < deadline) ? agg_us : deadline;
+        if (mqtt_status_flag) {
+            int64_t drain_us = sample_backlog_next_us(&backlog, now);
+            deadline = (drain_us < deadline) ? drain_us : deadline;
+        }
+    }
+    if (deadline == INT64_MAX) {
+        return portMAX_DELAY;
+    }
+    int64_t wait_us = deadline - now;
+    return (wait_us <= 0) ? 0 : pdMS_TO_TICKS(wait_us / 1000) + 1;
+}
+
+/**
+ * @brief built-in settings, replaced by the ones saved in NVS if any
+ * 
+ */
+static void config_init(void) {
+    nvs_handle_t nvs;
+    remote_cfg_t blob;
+    size_t len = sizeof(blob);
+    memset(&remote_cfg, 0, sizeof(remote_cfg));
+    remote_cfg.magic = REMOTE_CFG_MAGIC;
+    remote_cfg.batch_ms = BATCH_WINDOW_MS;
+    remote_cfg.batch_count = BATCH_COUNT;
+    remote_cfg.agg_ms = AGG_WINDOW_MS;
+    remote_cfg.agg_temp_deadband = AGG_TEMP_DEADBAND;
+    remote_cfg.agg_humid_deadband = AGG_HUMID_DEADBAND;
+    ble_gatt_cfg_defaults(&remote_cfg);
+    if (nvs_open(CONFIG_NVS_NAMESPACE, NVS_READONLY, &nvs) == ESP_OK) {
+        if (nvs_get_blob(nvs, CONFIG_NVS_KEY, &blob, &len) == ESP_OK && remote_cfg_load(&remote_cfg, &blob, len)) {
+            ESP_LOGI(TAG, "remote config loaded");
+        }
+        nvs_close(nvs);
+    }
+}
+
+/**
+ * @brief persist settings, they survive reboots until changed again
+ * 
+ */
+static void config_save(void) {
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(CONFIG_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(nvs, CONFIG_NVS_KEY, &remote_cfg, sizeof(remote_cfg_t));
+        if (err == ESP_OK) {
+            err = nvs_commit(nvs);
+        }
+        nvs_close(nvs);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "remote config not saved, error %d", err);
+    }
+}
+
+/**
+ * @brief take changed settings into the running stages, no restart
+ * 
+ * @param changed REMOTE_CFG_F_x
+ */
+static void config_apply(int changed) {
+    if (changed & REMOTE_CFG_F_BATCH) {
+        /* a batch above the new count goes out with the next sample or its window */
+        publish_batch.cfg.window_us = remote_cfg.batch_ms * 1000;
+        publish_batch.cfg.max_count = remote_cfg.batch_count;
+    }
+    if (changed & REMOTE_CFG_F_AGG) {
+        /* windows of the old length are summarized before the new one applies */
+        sample_agg_flush(&sample_agg);
+        sample_agg.cfg.window_us = remote_cfg.agg_ms * 1000;
+        sample_agg.cfg.temp_deadband = remote_cfg.agg_temp_deadband;
+        sample_agg.cfg.humid_deadband = remote_cfg.agg_humid_deadband;
+    }
+    if (changed & (REMOTE_CFG_F_SCAN | REMOTE_CFG_F_ALLOW)) {
+        ble_gatt_configure(&remote_cfg);
+    }
+}
+
+/**
+ * @brief publish settings in force as a command restoring them
+ * 
+ */
+static void config_report(void) {
+    int len = remote_cfg_text(&remote_cfg, config_text, sizeof(config_text));
+    mqtt_publish_config(config_text, len);
+}
+
+/**
+ * @brief apply commands received on the config topic, a refused one changes nothing
+ * 
+ */
+static void config_process(void) {
+    int len;
+    while ((len = mqtt_take_config(config_cmd, sizeof(config_cmd))) >= 0) {
+        int err_pos = 0;
+        int changed = remote_cfg_parse(&remote_cfg, config_cmd, len, &err_pos);
+        if (changed == REMOTE_CFG_ERR) {
+            ESP_LOGW(TAG, "config command refused at \"%.*s\"", len - err_pos, &config_cmd[err_pos]);
+            int text_len = fmt_str(config_text, "error at ");
+            text_len += fmt_u32(&config_text[text_len], (uint32_t)err_pos);
+            mqtt_publish_config_error(config_text, text_len);
+            continue;
+        }
+        if (changed) {
+            ESP_LOGI(TAG, "config changed: 0x%x", changed);
+            config_apply(changed);
+            config_save();
+        }
+        config_report();
+    }
+}
+
+/**
+ * @brief select backlog storage, log file if configured and available, else RAM
+ * 
+ */
+static void backlog_init(void) {
+    const char *path = BACKLOG_FILE;
+    if (path == NULL || !sample_store_file_open(&backlog_store, path, BACKLOG_CAPACITY)) {
+        sample_store_ram_init(&backlog_store, backlog_buf, BACKLOG_CAPACITY);
+    }
+    sample_backlog_init(&backlog, &backlog_store, BACKLOG_DRAIN_RATE, BACKLOG_DRAIN_BURST);
+}
+
+/**
+ * @brief replay stored sample through the publish batch
+ * 
+ * @param sample 
+ * @param ctx unused
+ */
+static void backlog_sink_cb(const sensor_sample_t *sample, void *ctx) {
+    mqtt_batch_add(&publish_batch, sample, esp_timer_get_time());
+}
+
+/**
+ * @brief MQTT went down, keep samples of the unsent batch in backlog
+ * 
+ */
+static void backlog_spill_batch(void) {
+    for (int idx = 0; idx < publish_batch.count; idx++) {
+        sample_backlog_store(&backlog, &publish_batch.pending[idx]);
+    }
+    publish_batch.count = 0;
+}
+
+/**
+ * @brief register queues and start periodic sampling timer
+ *
+ */
+static void metrics_init(void) {
+    sys_metrics_init(&metrics, portNUM_PROCESSORS);
+    metrics_q_ring = sys_metrics_queue_add(&metrics, "ring", SAMPLE_RING_SIZE);
+    /* batch_n can be raised at runtime up to the size of the pending array */
+    metrics_q_batch = sys_metrics_queue_add(&metrics, "batch", MQTT_BATCH_MAX);
+    metrics_q_backlog = sys_metrics_queue_add(&metrics, "backlog", BACKLOG_CAPACITY);
+    metrics_q_window = sys_metrics_queue_add(&metrics, "inflight", PUBLISH_WINDOW);
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = &metrics_timer_cb,
+        .name = "metrics"
+    };
+    esp_timer_handle_t timer;
+    esp_timer_create(&timer_args, &timer);
+    esp_timer_start_periodic(timer, METRICS_PERIOD_MS * 1000);
+}
+
+/**
+ * @brief sampling is due, done in main loop
+ *
+ * @param arg unused
+ */
+static void metrics_timer_cb(void *arg) {
+    main_notify(MAIN_NOTIFY_METRICS);
+}
+
+/**
+ * @brief sample tasks and heap, publish JSON and refresh debug screen text
+ *        CPU share needs CONFIG_FREERTOS_USE_TRACE_FACILITY and CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+ *
+ */
+static void metrics_sample(void) {
+    int task_num = 0;
+    uint32_t total_runtime = 0;
+#if configUSE_TRACE_FACILITY
+    /* fails if more tasks exist than entries, then only heap and queues are reported */
+    task_num = uxTaskGetSystemState(task_status, SYS_METRICS_TASK_MAX, &total_runtime);
+    for (int idx = 0; idx < task_num; idx++) {
+        task_stat[idx] = (sys_task_stat_t){
+            .name = task_status[idx].pcTaskName,
+            .id = task_status[idx].xTaskNumber,
+            .runtime = task_status[idx].ulRunTimeCounter,
+            .stack_free = task_status[idx].usStackHighWaterMark,
+            .core = -1,
+            .priority = (uint8_t)task_status[idx].uxCurrentPriority,
+        };
+#if configTASKLIST_INCLUDE_COREID
+        if (task_status[idx].xCoreID != tskNO_AFFINITY) {
+            task_stat[idx].core = (int8_t)task_status[idx].xCoreID;
+        }
+#endif
+    }
+#endif
+    const sys_heap_stat_t heap = {
+        .free = heap_caps_get_free_size(MALLOC_CAP_8BIT),
+        .min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT),
+        .dma_free = heap_caps_get_free_size(MALLOC_CAP_DMA),
+        .dma_min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_DMA),
+        .dma_largest = heap_caps_get_largest_free_block(MALLOC_CAP_DMA),
+    };
+    sys_power_stat_t power;
+    if (gui_power_stat(&power)) {
+        sys_metrics_power_set(&metrics, &power);
+    }
+    int low_stack = sys_metrics_update(&metrics, task_stat, task_num, total_runtime, &heap, esp_timer_get_time());
+    if (low_stack > 0) {
+        for (int idx = 0; idx < metrics.task_num; idx++) {
+            if (metrics.task[idx].stack_free < SYS_METRICS_STACK_WARN) {
+                ESP_LOGW(TAG, "task %s: %u bytes of stack left", metrics.task[idx].name, metrics.task[idx].stack_free);
+            }
+        }
+    }
+    if (mqtt_status_flag) {
+        int len = sys_metrics_json(&metrics, metrics_json, sizeof(metrics_json));
+        mqtt_publish_metrics(metrics_json, len);
+        len = ble_gatt_link_json(links_json, sizeof(links_json));
+        mqtt_publish_links(links_json, len);
+    }
+    /* formatted in place, GUI skips the field meanwhile, link quality below the metrics */
+    status_snap_write_begin(&status_snap, STATUS_FIELD_METRICS);
+    int text_len = sys_metrics_text(&metrics, status_snap.data.metrics, STATUS_TEXT_LEN);
+    ble_gatt_link_text(&status_snap.data.metrics[text_len], STATUS_TEXT_LEN - text_len);
+    status_snap_write_end(&status_snap, STATUS_FIELD_METRICS);
+}
+
+#if PIPE_TRACE_ENABLE
+/**
+ * @brief dump a full capture as Chrome trace JSON to the log and MQTT_TOPIC/trace, restart it later
+ *
+ */
+static void trace_poll(void) {
+    int64_t now_us = esp_timer_get_time();
+    if (trace_next_us == 0 && pipe_trace_full(&pipe_trace)) {
+        uint32_t pos = 0;
+        int len;
+        while ((len = pipe_trace_json(&pipe_trace, &pos, trace_json, sizeof(trace_json))) > 0) {
+            ESP_LOGI(TAG, "trace\n%s", trace_json);
+            if (mqtt_status_flag) {
+                mqtt_publish_trace(trace_json, len);
+            }
+        }
+        trace_next_us = now_us + TRACE_PERIOD_MS * 1000;
+    } else if (trace_next_us != 0 && now_us >= trace_next_us) {
+        trace_next_us = 0;
+        pipe_trace_reset(&pipe_trace);
+    }
+}
+#endif
+
+/**
+ * @brief wake main loop, called from BLE/WiFi/MQTT callbacks
+ * 
+ * @param bits MAIN_NOTIFY_x
+ */
+void main_notify(uint32_t bits) {
+    if (main_task != NULL) {
+        xTaskNotify(main_task, bits, eSetBits);
+    }
+}
 
 /**
  * @brief Main application, create GUI task, forward BLE to MQTT
@@ -41,46 +448,120 @@ void app_main() {
         nvs_flash_init();
     }
     /* create FreeRTOS objects */
+    main_task = xTaskGetCurrentTaskHandle();
     net_evt_group = xEventGroupCreate();
-    env_sensor_q = xQueueCreate(1, sizeof(env_sensor_msg_t*));
-    label_txt_sem = xSemaphoreCreateMutex();
+    sample_ring_init(&sample_ring, SAMPLE_RING_DROP_OLDEST);
+    status_snap_init(&status_snap);
+    status_snap_set_net(&status_snap, false, false);
+    latency_hist_init(&publish_latency);
+    config_init();
+    const mqtt_batch_cfg_t batch_cfg = {
+        .fmt = BATCH_FORMAT,
+        .max_count = remote_cfg.batch_count,
+        .window_us = remote_cfg.batch_ms * 1000,
+        .route = BATCH_ROUTE,
+    };
+    mqtt_batch_init(&publish_batch, &batch_cfg, batch_publish_cb, NULL);
+    publish_batch.latency = &publish_latency;
+    const mqtt_window_cfg_t window_cfg = {
+        .size = PUBLISH_WINDOW,
+        .ack_timeout_ms = PUBLISH_ACK_TIMEOUT_MS,
+        .max_tries = PUBLISH_MAX_TRIES,
+    };
+    mqtt_window_init(&publish_window, &window_cfg, window_send_cb, NULL);
+    const sample_agg_cfg_t agg_cfg = {
+        .window_us = remote_cfg.agg_ms * 1000,
+        .temp_deadband = remote_cfg.agg_temp_deadband,
+        .humid_deadband = remote_cfg.agg_humid_deadband,
+        .max_silent_us = AGG_MAX_SILENT_MS * 1000,
+    };
+    sample_agg_init(&sample_agg, &agg_cfg, agg_emit_cb, NULL);
+    backlog_init();
+    metrics_init();
+#if PIPE_TRACE_ENABLE
+    pipe_trace_init(&pipe_trace);
+#endif
 
     /* create GUI task on core 1 */
-    xTaskCreatePinnedToCore(gui_task_fcn, "gui", 4096*2, NULL, 1, NULL, 1);
+    xTaskCreatePinnedToCore(gui_task_fcn, "gui", GUI_TASK_STACK, NULL, 1, NULL, 1);
 
     /* init Bluetooth and WiFi */
     ble_gatt_init();
+    ble_gatt_configure(&remote_cfg);
     vTaskDelay(pdMS_TO_TICKS(100));
     wifi_init_sta();
     vTaskDelay(pdMS_TO_TICKS(100));
 
     for (;;) {
-        /* wait for network status upto 100 ms */
-        EventBits_t bits = xEventGroupWaitBits(net_evt_group,
-                                               WIFI_CONNECTED_BIT | WIFI_FAIL_BIT | MQTT_CONNECTED_BIT,
-                                               pdFALSE,
-                                               pdFALSE,
-                                               pdMS_TO_TICKS(100));
-        if (bits & WIFI_CONNECTED_BIT) {
-            wifi_status_flag = true;
-        } 
-        if (bits & WIFI_FAIL_BIT) {
-            wifi_status_flag = false;
-        } 
-        if (bits & MQTT_CONNECTED_BIT) {
-            mqtt_status_flag = true;
-        } 
-        // non-blocking check for new sensor value
-        env_sensor_msg_t *p_msg;
-        if (xQueueReceive(env_sensor_q, &(p_msg), (TickType_t)0) == pdPASS) {
-            temp_val = p_msg->temp_val;
-            humid_val = p_msg->humid_val;
-            mqtt_publish_val(temp_val, humid_val);
-        } 
-        // non-blocking update label text
-        if (xSemaphoreTake(label_txt_sem, (TickType_t)0) == pdPASS) {
-            sprintf(label_txt, LABEL_TXT_TMPL, wifi_status_flag, mqtt_status_flag, temp_val, humid_val);
-            xSemaphoreGive(label_txt_sem);
+        /* block until network status, sensor samples, PUBACKs or commands come, or pending batch is due */
+        uint32_t notify = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &notify, batch_wait_ticks());
+        if (notify & MAIN_NOTIFY_NET) {
+            EventBits_t bits = xEventGroupGetBits(net_evt_group);
+            bool wifi_flag = (bits & WIFI_CONNECTED_BIT) && !(bits & WIFI_FAIL_BIT);
+            bool mqtt_flag = (bits & MQTT_CONNECTED_BIT) != 0;
+            status_snap_set_net(&status_snap, wifi_flag, mqtt_flag);
+            if (mqtt_status_flag && !mqtt_flag) {
+                backlog_spill_batch();
+            }
+            if (!mqtt_status_flag && mqtt_flag) {
+                config_report();
+            }
+            wifi_status_flag = wifi_flag;
+            mqtt_status_flag = mqtt_flag;
+            // batches in flight are published again once reconnected
+            mqtt_window_set_connected(&publish_window, mqtt_flag, esp_timer_get_time());
+        }
+        if (notify & MAIN_NOTIFY_ACK) {
+            int msg_id;
+            while (mqtt_take_ack(&msg_id)) {
+                mqtt_window_on_ack(&publish_window, msg_id);
+            }
+        }
+        if (notify & MAIN_NOTIFY_CONFIG) {
+            config_process();
+        }
+        // republish batches whose PUBACK is overdue
+        mqtt_window_poll(&publish_window, esp_timer_get_time());
+        sys_metrics_queue_set(&metrics, metrics_q_window, publish_window.count);
+        if (notify & (MAIN_NOTIFY_SAMPLE | MAIN_NOTIFY_ACK)) {
+            // drain buffered sensor samples, held in the ring while the publish window is full
+            sensor_sample_t sample;
+            sys_metrics_queue_set(&metrics, metrics_q_ring, sample_ring_count(&sample_ring));
+            while (!publish_held() && sample_ring_pop(&sample_ring, &sample)) {
+                PIPE_TRACE_STAMP(PIPE_TRACE_POP, sample.seq, sample.dev_id, PIPE_TRACE_NOW());
+                status_snap_set_sensor(&status_snap, &sample);
+                sample_agg_add(&sample_agg, &sample);
+            }
+        }
+        // summarize devices whose aggregation window has elapsed
+        if (!publish_held()) {
+            sample_agg_poll(&sample_agg, esp_timer_get_time());
+        }
+        // replay backlog at limited rate while connected
+        if (mqtt_status_flag && !publish_held()) {
+            sample_backlog_drain(&backlog, esp_timer_get_time(), backlog_sink_cb, NULL);
+        }
+        // publish batch whose window has elapsed
+        sys_metrics_queue_set(&metrics, metrics_q_batch, publish_batch.count);
+        if (!publish_held()) {
+            mqtt_batch_poll(&publish_batch, esp_timer_get_time());
+        }
+        sys_metrics_queue_set(&metrics, metrics_q_backlog, sample_backlog_count(&backlog));
+        if (notify & MAIN_NOTIFY_METRICS) {
+            metrics_sample();
+        }
+#if PIPE_TRACE_ENABLE
+        trace_poll();
+#endif
+        if (publish_latency.count >= LATENCY_LOG_COUNT) {
+            ESP_LOGI(TAG, "notify->publish latency us: n %u, mean %u, p50 %u, p99 %u, max %u",
+                     publish_latency.count,
+                     latency_hist_mean(&publish_latency),
+                     latency_hist_percentile(&publish_latency, 50),
+                     latency_hist_percentile(&publish_latency, 99),
+                     publish_latency.max_us);
+            latency_hist_init(&publish_latency);
         }
     }
 
@@ -1,32 +1,44 @@
-#ifndef _MAIN_H
-#define _MAIN_H
-
-/* Common include files */
-#include <stdio.h>
-#include <stdint.h>
-#include <string.h>
-#include <stdbool.h>
-#include <stdio.h>
-
-#include "freertos/FreeRTOS.h"
-#include "freertos/task.h"
-#include "freertos/semphr.h"
-#include "freertos/event_groups.h"
-#include "freertos/queue.h"
-#include "esp_freertos_hooks.h"
-#include "esp_event.h"
-#include "esp_system.h"
-#include "esp_log.h"
-
-/* FreeRTOS synchronization objects */
-extern EventGroupHandle_t net_evt_group;
-extern QueueHandle_t env_sensor_q;
-extern SemaphoreHandle_t label_txt_sem;
-extern char label_txt[];
-
-/* Event group definition */
-#define WIFI_CONNECTED_BIT BIT0
-#define WIFI_FAIL_BIT      BIT1
-#define MQTT_CONNECTED_BIT BIT2
-
+#ifndef _MAIN_H
+#define _MAIN_H
+
+/* Common include files */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "freertos/queue.h"
+#include "esp_freertos_hooks.h"
+#include "esp_event.h"
+#include "esp_system.h"
+#include "esp_log.h"
+
+#include "sample_ring.h"
+#include "status_snap.h"
+
+/* FreeRTOS synchronization objects */
+extern TaskHandle_t main_task;
+extern EventGroupHandle_t net_evt_group;
+extern sample_ring_t sample_ring;
+extern status_snap_t status_snap;
+
+/* Event group definition */
+#define WIFI_CONNECTED_BIT BIT0
+#define WIFI_FAIL_BIT      BIT1
+#define MQTT_CONNECTED_BIT BIT2
+
+/* Task notification bits to wake main loop */
+#define MAIN_NOTIFY_NET    BIT0
+#define MAIN_NOTIFY_SAMPLE BIT1
+#define MAIN_NOTIFY_METRICS BIT2
+#define MAIN_NOTIFY_ACK    BIT3
+#define MAIN_NOTIFY_CONFIG BIT4
+
+void main_notify(uint32_t bits);
+
 #endif
\ No newline at end of file
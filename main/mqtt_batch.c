@@ -0,0 +1,307 @@
+#include <string.h>
+
+#include "mqtt_batch.h"
+#include "fmt_fixed.h"
+#include "pipe_trace.h"
+
+/* STATIC PROTOTYPES */
+static uint32_t age_ms(int64_t ts_us, int64_t now_us);
+static int encode_json(const sensor_sample_t *sample, bool with_dev, int64_t now_us, char *buf, int size);
+static int encode_binary(const sensor_sample_t *sample, int64_t base_us, bool agg, uint8_t *buf);
+static void put_u16(uint8_t *buf, uint16_t val);
+static void put_u32(uint8_t *buf, uint32_t val);
+#if PIPE_TRACE_ENABLE
+static void trace_mask(const mqtt_batch_t *batch, uint32_t mask, pipe_trace_stage_t stage, int64_t ts_us);
+#endif
+
+/**
+ * @brief time since sample was taken, replayed backlog samples can be hours old
+ *
+ * @param ts_us sample timestamp
+ * @param now_us publish time
+ * @return age in ms, saturated
+ */
+static uint32_t age_ms(int64_t ts_us, int64_t now_us) {
+    int64_t age = (now_us - ts_us) / 1000;
+    return (age < 0) ? 0 : (age > UINT32_MAX) ? UINT32_MAX : (uint32_t)age;
+}
+
+/**
+ * @brief one JSON object, values printed as fixed-point integers, age appended
+ *
+ * @param sample
+ * @param with_dev include device id
+ * @param now_us publish time
+ * @param buf
+ * @param size
+ * @return length written, 0 if buffer too small
+ */
+static int encode_json(const sensor_sample_t *sample, bool with_dev, int64_t now_us, char *buf, int size) {
+    int len;
+    if (sample->count) {
+        if (size < FMT_AGG_JSON_LEN + MQTT_BATCH_JSON_AGE) {
+            return 0;
+        }
+        len = fmt_agg_json(buf, sample, with_dev);
+    } else {
+        if (size < FMT_SAMPLE_JSON_LEN + MQTT_BATCH_JSON_AGE) {
+            return 0;
+        }
+        len = fmt_sample_json(buf, sample, with_dev);
+    }
+    len--;      /* reopen the object */
+    len += fmt_str(&buf[len], ",\"age\":");
+    len += fmt_u32(&buf[len], age_ms(sample->ts_us, now_us));
+    buf[len++] = '}';
+    return len;
+}
+
+#if PIPE_TRACE_ENABLE
+/**
+ * @brief stamp pending samples of one message
+ *
+ * @param batch
+ * @param mask pending samples
+ * @param stage
+ * @param ts_us
+ */
+static void trace_mask(const mqtt_batch_t *batch, uint32_t mask, pipe_trace_stage_t stage, int64_t ts_us) {
+    for (int idx = 0; idx < batch->count; idx++) {
+        if (mask & (1u << idx)) {
+            PIPE_TRACE_STAMP(stage, batch->pending[idx].seq, batch->pending[idx].dev_id, ts_us);
+        }
+    }
+}
+#endif
+
+/**
+ * @brief little-endian 16-bit field
+ *
+ * @param buf
+ * @param val
+ */
+static void put_u16(uint8_t *buf, uint16_t val) {
+    buf[0] = (uint8_t)val;
+    buf[1] = (uint8_t)(val >> 8);
+}
+
+/**
+ * @brief little-endian 32-bit field
+ *
+ * @param buf
+ * @param val
+ */
+static void put_u32(uint8_t *buf, uint32_t val) {
+    put_u16(&buf[0], (uint16_t)val);
+    put_u16(&buf[2], (uint16_t)(val >> 16));
+}
+
+/**
+ * @brief one fixed-size little-endian record
+ *
+ * @param sample
+ * @param base_us ts_us of oldest sample in message, dt_ms is relative to it
+ * @param agg summary layout, a single reading has n 1 and min = max = value
+ * @param buf MQTT_BATCH_BIN_REC or MQTT_BATCH_BIN_AGG_REC bytes
+ * @return record length
+ */
+static int encode_binary(const sensor_sample_t *sample, int64_t base_us, bool agg, uint8_t *buf) {
+    int64_t dt_ms = (sample->ts_us - base_us) / 1000;
+    uint16_t dt = (dt_ms < 0) ? 0 : (dt_ms > UINT16_MAX) ? UINT16_MAX : (uint16_t)dt_ms;
+    put_u16(&buf[0], sample->dev_id);
+    put_u16(&buf[2], (uint16_t)sample->seq);
+    put_u16(&buf[4], (uint16_t)sample->temp_centi);
+    put_u16(&buf[6], sample->humid_centi);
+    put_u16(&buf[8], dt);
+    if (!agg) {
+        return MQTT_BATCH_BIN_REC;
+    }
+    bool single = sample->count == 0;
+    put_u16(&buf[10], single ? 1 : sample->count);
+    put_u16(&buf[12], (uint16_t)(single ? sample->temp_centi : sample->temp_min_centi));
+    put_u16(&buf[14], (uint16_t)(single ? sample->temp_centi : sample->temp_max_centi));
+    put_u16(&buf[16], single ? sample->humid_centi : sample->humid_min_centi);
+    put_u16(&buf[18], single ? sample->humid_centi : sample->humid_max_centi);
+    return MQTT_BATCH_BIN_AGG_REC;
+}
+
+/**
+ * @brief set up batch stage
+ *
+ * @param batch
+ * @param cfg max_count is clamped to MQTT_BATCH_MAX
+ * @param publish sink for encoded messages
+ * @param ctx passed to publish
+ */
+void mqtt_batch_init(mqtt_batch_t *batch, const mqtt_batch_cfg_t *cfg, mqtt_batch_publish_t publish, void *ctx) {
+    memset(batch, 0, sizeof(mqtt_batch_t));
+    batch->cfg = *cfg;
+    if (batch->cfg.max_count == 0 || batch->cfg.max_count > MQTT_BATCH_MAX) {
+        batch->cfg.max_count = MQTT_BATCH_MAX;
+    }
+    batch->publish = publish;
+    batch->ctx = ctx;
+}
+
+/**
+ * @brief queue sample, publish when count limit is reached, or before
+ *        when the JSON message could outgrow the buffer or the binary
+ *        dt_ms of a replayed sample would not fit
+ *
+ * @param batch
+ * @param sample
+ * @param now_us
+ */
+void mqtt_batch_add(mqtt_batch_t *batch, const sensor_sample_t *sample, int64_t now_us) {
+    uint16_t rec_max = sample->count ? MQTT_BATCH_JSON_AGG_REC : MQTT_BATCH_JSON_REC;
+    if (batch->count) {
+        int64_t lo_us = (sample->ts_us < batch->ts_lo_us) ? sample->ts_us : batch->ts_lo_us;
+        int64_t hi_us = (sample->ts_us > batch->ts_hi_us) ? sample->ts_us : batch->ts_hi_us;
+        if ((batch->cfg.fmt == MQTT_BATCH_FMT_JSON && batch->json_max + rec_max > MQTT_BATCH_BUF_SIZE - 2) ||
+            (batch->cfg.fmt == MQTT_BATCH_FMT_BINARY && (hi_us - lo_us) / 1000 > UINT16_MAX)) {
+            mqtt_batch_flush(batch, now_us);
+        }
+    }
+    if (batch->count == 0) {
+        batch->first_us = now_us;
+        batch->json_max = 0;
+        batch->ts_lo_us = sample->ts_us;
+        batch->ts_hi_us = sample->ts_us;
+    }
+    if (sample->ts_us < batch->ts_lo_us) {
+        batch->ts_lo_us = sample->ts_us;
+    }
+    if (sample->ts_us > batch->ts_hi_us) {
+        batch->ts_hi_us = sample->ts_us;
+    }
+    batch->json_max += rec_max;
+    batch->pending[batch->count++] = *sample;
+    PIPE_TRACE_STAMP(PIPE_TRACE_BATCH, sample->seq, sample->dev_id, now_us);
+    if (batch->count >= batch->cfg.max_count) {
+        mqtt_batch_flush(batch, now_us);
+    }
+}
+
+/**
+ * @brief publish when window of oldest pending sample has elapsed
+ *
+ * @param batch
+ * @param now_us
+ * @return true if flushed
+ */
+bool mqtt_batch_poll(mqtt_batch_t *batch, int64_t now_us) {
+    if (batch->count > 0 && now_us >= mqtt_batch_deadline(batch)) {
+        mqtt_batch_flush(batch, now_us);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief time at which pending samples must be published
+ *
+ * @param batch
+ * @return timestamp in us, INT64_MAX if nothing pending
+ */
+int64_t mqtt_batch_deadline(const mqtt_batch_t *batch) {
+    return batch->count ? batch->first_us + batch->cfg.window_us : INT64_MAX;
+}
+
+/**
+ * @brief encode selected pending samples
+ *
+ * @param batch
+ * @param dev_mask bit n selects pending[n]
+ * @param with_dev include device id in JSON records
+ * @param now_us publish time, sample ages are relative to it
+ * @param buf
+ * @param size
+ * @return encoded length
+ */
+int mqtt_batch_encode(const mqtt_batch_t *batch, uint32_t dev_mask, bool with_dev, int64_t now_us,
+                      uint8_t *buf, int size) {
+    int len = 0;
+    int n = 0;
+    if (batch->cfg.fmt == MQTT_BATCH_FMT_BINARY) {
+        bool agg = false;
+        int64_t base_us = INT64_MAX;
+        for (int idx = 0; idx < batch->count; idx++) {
+            if (dev_mask & (1u << idx)) {
+                agg |= batch->pending[idx].count != 0;
+                if (batch->pending[idx].ts_us < base_us) {
+                    base_us = batch->pending[idx].ts_us;
+                }
+            }
+        }
+        int rec_len = agg ? MQTT_BATCH_BIN_AGG_REC : MQTT_BATCH_BIN_REC;
+        len = MQTT_BATCH_BIN_HDR;
+        for (int idx = 0; idx < batch->count; idx++) {
+            if ((dev_mask & (1u << idx)) && len + rec_len <= size) {
+                len += encode_binary(&batch->pending[idx], base_us, agg, &buf[len]);
+                n++;
+            }
+        }
+        buf[0] = agg ? MQTT_BATCH_BIN_AGG_VERSION : MQTT_BATCH_BIN_VERSION;
+        buf[1] = (uint8_t)n;
+        put_u32(&buf[2], n ? age_ms(base_us, now_us) : 0);
+        return len;
+    }
+    buf[len++] = '[';
+    for (int idx = 0; idx < batch->count; idx++) {
+        if (dev_mask & (1u << idx)) {
+            if (n > 0) {
+                buf[len++] = ',';
+            }
+            len += encode_json(&batch->pending[idx], with_dev, now_us, (char *)&buf[len], size - len - 1);
+            n++;
+        }
+    }
+    buf[len++] = ']';
+    return len;
+}
+
+/**
+ * @brief publish all pending samples, one message per device when routed
+ *
+ * @param batch
+ * @param now_us
+ */
+void mqtt_batch_flush(mqtt_batch_t *batch, int64_t now_us) {
+    uint32_t all = (batch->count >= 32) ? UINT32_MAX : ((1u << batch->count) - 1);
+    uint32_t left = all;
+    while (left) {
+        uint32_t mask = all;
+        int dev_id = MQTT_BATCH_NO_ROUTE;
+        if (batch->cfg.route) {
+            /* select every pending sample of the first unsent device */
+            int first = __builtin_ctz(left);
+            dev_id = batch->pending[first].dev_id;
+            mask = 0;
+            for (int idx = first; idx < batch->count; idx++) {
+                if (batch->pending[idx].dev_id == dev_id) {
+                    mask |= 1u << idx;
+                }
+            }
+        }
+        int len = mqtt_batch_encode(batch, mask, !batch->cfg.route, now_us, batch->buf, MQTT_BATCH_BUF_SIZE);
+#if PIPE_TRACE_ENABLE
+        trace_mask(batch, mask, PIPE_TRACE_PUBLISH, PIPE_TRACE_NOW());
+#endif
+        if (batch->publish) {
+            batch->publish(dev_id, batch->buf, len, batch->ctx);
+        }
+#if PIPE_TRACE_ENABLE
+        trace_mask(batch, mask, PIPE_TRACE_WIRE, PIPE_TRACE_NOW());
+#endif
+        batch->msg_count++;
+        batch->byte_count += len;
+        batch->sample_count += __builtin_popcount(mask);
+        left &= ~mask;
+    }
+    if (batch->latency) {
+        for (int idx = 0; idx < batch->count; idx++) {
+            latency_hist_add(batch->latency, now_us - batch->pending[idx].ts_us);
+        }
+    }
+    batch->count = 0;
+}
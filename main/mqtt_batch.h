@@ -0,0 +1,65 @@
+#ifndef _MQTT_BATCH_H_
+#define _MQTT_BATCH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sample_ring.h"
+#include "latency_hist.h"
+
+/* DEFINES */
+#define MQTT_BATCH_MAX          32      /* samples per batch, <= 32 */
+#define MQTT_BATCH_JSON_AGE     17      /* ,"age":<u32> appended to each JSON record */
+#define MQTT_BATCH_JSON_REC     (64 + MQTT_BATCH_JSON_AGE)  /* worst-case JSON record length */
+#define MQTT_BATCH_JSON_AGG_REC (104 + MQTT_BATCH_JSON_AGE) /* worst-case JSON summary record length */
+#define MQTT_BATCH_BIN_HDR      6       /* version, count, age_ms u32 of oldest record at publish */
+#define MQTT_BATCH_BIN_REC      10      /* dev u16, seq u16, temp i16, humid u16, dt_ms u16 after oldest */
+#define MQTT_BATCH_BIN_VERSION  0xB3
+#define MQTT_BATCH_BIN_AGG_REC  20      /* BIN_REC + n u16, temp min/max i16, humid min/max u16 */
+#define MQTT_BATCH_BIN_AGG_VERSION  0xB4    /* used if any record is a summary */
+#define MQTT_BATCH_BUF_SIZE     (MQTT_BATCH_MAX * MQTT_BATCH_JSON_REC + 2)
+#define MQTT_BATCH_NO_ROUTE     (-1)    /* dev_id passed to publish when not routed per device */
+
+/* TYPE DEFINITIONS */
+typedef enum {
+    MQTT_BATCH_FMT_JSON = 0,    /* [{"dev":1,"seq":7,"temp":23.45,"humid":53.00,"age":120},...], summaries see fmt_agg_json */
+    MQTT_BATCH_FMT_BINARY,      /* fixed little-endian records, see MQTT_BATCH_BIN_x */
+} mqtt_batch_fmt_t;
+
+/* sink for an encoded batch, dev_id is MQTT_BATCH_NO_ROUTE or the device of every sample in it */
+typedef void (*mqtt_batch_publish_t)(int dev_id, const uint8_t *data, int len, void *ctx);
+
+typedef struct mqtt_batch_cfg_t {
+    mqtt_batch_fmt_t fmt;
+    uint8_t max_count;          /* flush when this many samples are pending */
+    uint32_t window_us;         /* flush when oldest pending sample is this old */
+    bool route;                 /* one message per device topic */
+} mqtt_batch_cfg_t;
+
+typedef struct mqtt_batch_t {
+    mqtt_batch_cfg_t cfg;
+    mqtt_batch_publish_t publish;
+    void *ctx;
+    latency_hist_t *latency;    /* optional, sample timestamp to publish call */
+    sensor_sample_t pending[MQTT_BATCH_MAX];
+    uint8_t count;
+    uint16_t json_max;          /* worst-case JSON length of pending records */
+    int64_t first_us;           /* arrival of oldest pending sample */
+    int64_t ts_lo_us;           /* range of pending sample timestamps */
+    int64_t ts_hi_us;
+    uint32_t msg_count;         /* published messages */
+    uint32_t byte_count;        /* published payload bytes */
+    uint32_t sample_count;      /* published samples */
+    uint8_t buf[MQTT_BATCH_BUF_SIZE];
+} mqtt_batch_t;
+
+/* PUBLIC PROTOTYPES */
+void mqtt_batch_init(mqtt_batch_t *batch, const mqtt_batch_cfg_t *cfg, mqtt_batch_publish_t publish, void *ctx);
+void mqtt_batch_add(mqtt_batch_t *batch, const sensor_sample_t *sample, int64_t now_us);
+bool mqtt_batch_poll(mqtt_batch_t *batch, int64_t now_us);
+int64_t mqtt_batch_deadline(const mqtt_batch_t *batch);
+void mqtt_batch_flush(mqtt_batch_t *batch, int64_t now_us);
+int mqtt_batch_encode(const mqtt_batch_t *batch, uint32_t dev_mask, bool with_dev, int64_t now_us,
+                      uint8_t *buf, int size);
+
+#endif
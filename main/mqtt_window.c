@@ -0,0 +1,194 @@
+#include <string.h>
+
+#include "mqtt_window.h"
+
+/* DEFINES */
+#define MS_TO_US(ms)    ((int64_t)(ms) * 1000)
+
+/* STATIC PROTOTYPES */
+static void msg_send(mqtt_window_t *window, mqtt_window_msg_t *msg, int64_t now_us);
+static void msg_free(mqtt_window_t *window, mqtt_window_msg_t *msg);
+
+/**
+ * @brief one publish attempt, a message needing no PUBACK is done at once
+ *
+ * @param window
+ * @param msg
+ * @param now_us
+ */
+static void msg_send(mqtt_window_t *window, mqtt_window_msg_t *msg, int64_t now_us) {
+    msg->tries++;
+    msg->sent_us = now_us;
+    msg->msg_id = window->send(msg->dev_id, msg->data, msg->len, window->ctx);
+    if (msg->msg_id == 0) {
+        msg_free(window, msg);
+    }
+}
+
+/**
+ * @brief release slot
+ *
+ * @param window
+ * @param msg
+ */
+static void msg_free(mqtt_window_t *window, mqtt_window_msg_t *msg) {
+    msg->used = false;
+    window->count--;
+}
+
+/**
+ * @brief empty window, disconnected until told otherwise
+ *
+ * @param window
+ * @param cfg size is clamped to 1..MQTT_WINDOW_MAX
+ * @param send
+ * @param ctx passed to send
+ */
+void mqtt_window_init(mqtt_window_t *window, const mqtt_window_cfg_t *cfg, mqtt_window_send_t send, void *ctx) {
+    memset(window, 0, sizeof(mqtt_window_t));
+    window->cfg = *cfg;
+    if (window->cfg.size == 0 || window->cfg.size > MQTT_WINDOW_MAX) {
+        window->cfg.size = MQTT_WINDOW_MAX;
+    }
+    window->send = send;
+    window->ctx = ctx;
+}
+
+/**
+ * @brief no more messages should be produced until PUBACKs come
+ *
+ * @param window
+ * @return true if cfg.size messages are in flight
+ */
+bool mqtt_window_full(const mqtt_window_t *window) {
+    return window->count >= window->cfg.size;
+}
+
+/**
+ * @brief copy message into the window and publish it, sent on reconnect if disconnected
+ *
+ * @param window
+ * @param dev_id
+ * @param data
+ * @param len <= MQTT_WINDOW_MSG_MAX
+ * @param now_us
+ * @return false if dropped: too long or every slot in use
+ */
+bool mqtt_window_publish(mqtt_window_t *window, int dev_id, const uint8_t *data, int len, int64_t now_us) {
+    mqtt_window_msg_t *msg = NULL;
+    for (int idx = 0; idx < MQTT_WINDOW_MAX && msg == NULL; idx++) {
+        if (!window->msg[idx].used) {
+            msg = &window->msg[idx];
+        }
+    }
+    if (msg == NULL || len < 0 || len > MQTT_WINDOW_MSG_MAX) {
+        window->drop_count++;
+        return false;
+    }
+    msg->used = true;
+    msg->msg_id = -1;
+    msg->dev_id = dev_id;
+    msg->tries = 0;
+    msg->sent_us = now_us;
+    msg->len = (uint16_t)len;
+    memcpy(msg->data, data, len);
+    window->count++;
+    window->publish_count++;
+    if (window->connected) {
+        msg_send(window, msg, now_us);
+    }
+    return true;
+}
+
+/**
+ * @brief PUBACK received, MQTT_EVENT_PUBLISHED
+ *
+ * @param window
+ * @param msg_id
+ * @return true if a message in flight was completed
+ */
+bool mqtt_window_on_ack(mqtt_window_t *window, int msg_id) {
+    for (int idx = 0; idx < MQTT_WINDOW_MAX; idx++) {
+        mqtt_window_msg_t *msg = &window->msg[idx];
+        if (msg->used && msg->msg_id > 0 && msg->msg_id == msg_id) {
+            msg_free(window, msg);
+            window->ack_count++;
+            return true;
+        }
+    }
+    window->stray_ack_count++;
+    return false;
+}
+
+/**
+ * @brief broker connection changed, on reconnect every message in flight is published again
+ *        since a clean session forgets unacknowledged ones
+ *
+ * @param window
+ * @param connected
+ * @param now_us
+ */
+void mqtt_window_set_connected(mqtt_window_t *window, bool connected, int64_t now_us) {
+    bool was_connected = window->connected;
+    window->connected = connected;
+    if (!connected || was_connected) {
+        return;
+    }
+    for (int idx = 0; idx < MQTT_WINDOW_MAX; idx++) {
+        mqtt_window_msg_t *msg = &window->msg[idx];
+        if (msg->used) {
+            window->retry_count += msg->tries > 0;
+            msg_send(window, msg, now_us);
+        }
+    }
+}
+
+/**
+ * @brief republish messages whose PUBACK is overdue, drop the ones out of tries
+ *
+ * @param window
+ * @param now_us
+ * @return messages republished
+ */
+int mqtt_window_poll(mqtt_window_t *window, int64_t now_us) {
+    int resent = 0;
+    if (!window->connected) {
+        return 0;
+    }
+    for (int idx = 0; idx < MQTT_WINDOW_MAX; idx++) {
+        mqtt_window_msg_t *msg = &window->msg[idx];
+        if (!msg->used || now_us - msg->sent_us < MS_TO_US(window->cfg.ack_timeout_ms)) {
+            continue;
+        }
+        if (window->cfg.max_tries && msg->tries >= window->cfg.max_tries) {
+            msg_free(window, msg);
+            window->drop_count++;
+            continue;
+        }
+        window->retry_count++;
+        msg_send(window, msg, now_us);
+        resent++;
+    }
+    return resent;
+}
+
+/**
+ * @brief next PUBACK timeout
+ *
+ * @param window
+ * @return time in us, INT64_MAX if nothing in flight or disconnected
+ */
+int64_t mqtt_window_deadline(const mqtt_window_t *window) {
+    int64_t deadline = INT64_MAX;
+    if (!window->connected) {
+        return INT64_MAX;
+    }
+    for (int idx = 0; idx < MQTT_WINDOW_MAX; idx++) {
+        const mqtt_window_msg_t *msg = &window->msg[idx];
+        int64_t due = msg->sent_us + MS_TO_US(window->cfg.ack_timeout_ms);
+        if (msg->used && due < deadline) {
+            deadline = due;
+        }
+    }
+    return deadline;
+}
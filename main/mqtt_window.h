@@ -0,0 +1,58 @@
+#ifndef _MQTT_WINDOW_H_
+#define _MQTT_WINDOW_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "mqtt_batch.h"
+
+/* DEFINES */
+#define MQTT_WINDOW_MAX     8                   /* slots, cfg.size plus room for a flush routed to several topics */
+#define MQTT_WINDOW_MSG_MAX MQTT_BATCH_BUF_SIZE /* payload kept for republishing */
+
+/* TYPE DEFINITIONS */
+/* hands message to the MQTT client, returns msg_id, 0 if no PUBACK will come (QoS 0), negative if not sent */
+typedef int (*mqtt_window_send_t)(int dev_id, const uint8_t *data, int len, void *ctx);
+
+typedef struct mqtt_window_cfg_t {
+    uint8_t size;               /* messages awaiting PUBACK before the window is full, <= MQTT_WINDOW_MAX */
+    uint32_t ack_timeout_ms;    /* republish when no PUBACK came within this time */
+    uint8_t max_tries;          /* publish attempts before a message is dropped, 0: no limit */
+} mqtt_window_cfg_t;
+
+/* message in flight */
+typedef struct mqtt_window_msg_t {
+    bool used;
+    int msg_id;                 /* of the last attempt, negative while not sent */
+    int dev_id;                 /* topic, see mqtt_batch_publish_t */
+    int64_t sent_us;            /* last attempt */
+    uint8_t tries;
+    uint16_t len;
+    uint8_t data[MQTT_WINDOW_MSG_MAX];
+} mqtt_window_msg_t;
+
+/* QoS 1 publishes awaiting PUBACK, owned by one task, acks are handed over by the caller */
+typedef struct mqtt_window_t {
+    mqtt_window_cfg_t cfg;
+    mqtt_window_send_t send;
+    void *ctx;
+    bool connected;             /* attempts are made only while connected */
+    int count;                  /* messages in flight */
+    uint32_t publish_count;     /* messages accepted */
+    uint32_t ack_count;
+    uint32_t retry_count;       /* republished after timeout or reconnect */
+    uint32_t drop_count;        /* given up after max_tries, or no slot left */
+    uint32_t stray_ack_count;   /* PUBACK matching no message in flight, e.g. of an earlier attempt */
+    mqtt_window_msg_t msg[MQTT_WINDOW_MAX];
+} mqtt_window_t;
+
+/* PUBLIC PROTOTYPES */
+void mqtt_window_init(mqtt_window_t *window, const mqtt_window_cfg_t *cfg, mqtt_window_send_t send, void *ctx);
+bool mqtt_window_full(const mqtt_window_t *window);
+bool mqtt_window_publish(mqtt_window_t *window, int dev_id, const uint8_t *data, int len, int64_t now_us);
+bool mqtt_window_on_ack(mqtt_window_t *window, int msg_id);
+void mqtt_window_set_connected(mqtt_window_t *window, bool connected, int64_t now_us);
+int mqtt_window_poll(mqtt_window_t *window, int64_t now_us);
+int64_t mqtt_window_deadline(const mqtt_window_t *window);
+
+#endif
@@ -0,0 +1,198 @@
+#include <string.h>
+
+#include "pipe_trace.h"
+#include "fmt_fixed.h"
+
+/* DEFINES */
+#define REC_JSON_MAX    (4 * PIPE_TRACE_EVENT_LEN)  /* stage span and whole pipeline span, begin and end each */
+#define JSON_HEAD       "[\n"
+#define JSON_TAIL       "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"ble2mqtt\"}}]\n"
+
+/* STATIC VARIABLES */
+#if PIPE_TRACE_ENABLE
+pipe_trace_t pipe_trace;
+#endif
+
+/* span ending at each stage */
+static const char *const span_name[PIPE_TRACE_STAGE_MAX] = {
+    [PIPE_TRACE_NOTIFY] = "pipeline",   /* notify to wire, drawn around the others */
+    [PIPE_TRACE_RING] = "decode",
+    [PIPE_TRACE_POP] = "ring",
+    [PIPE_TRACE_BATCH] = "agg",
+    [PIPE_TRACE_PUBLISH] = "batch",
+    [PIPE_TRACE_WIRE] = "publish",
+};
+
+/* STATIC PROTOTYPES */
+static const pipe_trace_rec_t *rec_find(const pipe_trace_t *trace, uint32_t count, uint32_t seq, uint8_t stage);
+static int event_json(char *buf, const char *name, const char *ph, const pipe_trace_rec_t *rec);
+static int span_json(char *buf, const char *name, const pipe_trace_rec_t *from, const pipe_trace_rec_t *to);
+
+/**
+ * @brief record of a sample at a stage, anywhere in the capture: the main loop may stamp a pop
+ *        before the BTC task stamps the push
+ *
+ * @param trace
+ * @param count records to search
+ * @param seq
+ * @param stage
+ * @return record or NULL
+ */
+static const pipe_trace_rec_t *rec_find(const pipe_trace_t *trace, uint32_t count, uint32_t seq, uint8_t stage) {
+    for (uint32_t idx = 0; idx < count; idx++) {
+        if (trace->rec[idx].seq == seq && trace->rec[idx].stage == stage) {
+            return &trace->rec[idx];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief one async event, nested by sample seq, one thread per device
+ *
+ * @param buf at least PIPE_TRACE_EVENT_LEN chars
+ * @param name
+ * @param ph "b" or "e"
+ * @param rec
+ * @return length written
+ */
+static int event_json(char *buf, const char *name, const char *ph, const pipe_trace_rec_t *rec) {
+    int len = fmt_str(buf, "{\"name\":\"");
+    len += fmt_str(&buf[len], name);
+    len += fmt_str(&buf[len], "\",\"cat\":\"sample\",\"ph\":\"");
+    len += fmt_str(&buf[len], ph);
+    len += fmt_str(&buf[len], "\",\"id\":");
+    len += fmt_u32(&buf[len], rec->seq);
+    len += fmt_str(&buf[len], ",\"pid\":1,\"tid\":");
+    len += fmt_u32(&buf[len], rec->dev_id);
+    len += fmt_str(&buf[len], ",\"ts\":");
+    len += fmt_u64(&buf[len], (uint64_t)rec->ts_us);
+    len += fmt_str(&buf[len], "},\n");
+    return len;
+}
+
+/**
+ * @brief begin and end event of a span
+ *
+ * @param buf at least 2 * PIPE_TRACE_EVENT_LEN chars
+ * @param name
+ * @param from
+ * @param to
+ * @return length written
+ */
+static int span_json(char *buf, const char *name, const pipe_trace_rec_t *from, const pipe_trace_rec_t *to) {
+    int len = event_json(buf, name, "b", from);
+    return len + event_json(&buf[len], name, "e", to);
+}
+
+/**
+ * @brief empty capture, started
+ *
+ * @param trace
+ */
+void pipe_trace_init(pipe_trace_t *trace) {
+    memset(trace, 0, sizeof(pipe_trace_t));
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief record sample at stage, non-blocking, callable from several tasks, dropped once full
+ *
+ * @param trace
+ * @param stage
+ * @param seq sample_ring seq
+ * @param dev_id
+ * @param ts_us esp_timer_get_time()
+ */
+void pipe_trace_stamp(pipe_trace_t *trace, pipe_trace_stage_t stage, uint32_t seq, uint16_t dev_id, int64_t ts_us) {
+    if (__atomic_load_n(&trace->head, __ATOMIC_RELAXED) >= PIPE_TRACE_SIZE) {
+        return;
+    }
+    uint32_t idx = __atomic_fetch_add(&trace->head, 1, __ATOMIC_RELAXED);
+    if (idx >= PIPE_TRACE_SIZE) {
+        return;
+    }
+    trace->rec[idx] = (pipe_trace_rec_t){
+        .ts_us = ts_us,
+        .seq = seq,
+        .dev_id = dev_id,
+        .stage = (uint8_t)stage,
+    };
+    __atomic_fetch_add(&trace->done, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief every record written, capture may be dumped
+ *
+ * @param trace
+ * @return true if full
+ */
+bool pipe_trace_full(pipe_trace_t *trace) {
+    return __atomic_load_n(&trace->done, __ATOMIC_ACQUIRE) >= PIPE_TRACE_SIZE;
+}
+
+/**
+ * @brief start next capture, only once full: no stamp is being written then
+ *
+ * @param trace
+ */
+void pipe_trace_reset(pipe_trace_t *trace) {
+    __atomic_store_n(&trace->done, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&trace->head, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief name of the span ending at a stage
+ *
+ * @param stage PIPE_TRACE_RING..PIPE_TRACE_WIRE, PIPE_TRACE_NOTIFY for notify to wire
+ * @return name, "" if out of range
+ */
+const char *pipe_trace_span_name(pipe_trace_stage_t stage) {
+    return ((unsigned)stage < PIPE_TRACE_STAGE_MAX) ? span_name[stage] : "";
+}
+
+/**
+ * @brief full capture as Chrome trace JSON array (chrome://tracing, ui.perfetto.dev), in pieces:
+ *        one async span per sample and stage, begin and end on a line each, e.g.
+ *        {"name":"ring","cat":"sample","ph":"b","id":7,"pid":1,"tid":0,"ts":5003121},
+ *        Records without the previous stage of their sample in the capture are skipped.
+ *
+ * @param trace full, see pipe_trace_full
+ * @param pos [in/out] 0 for the first piece, advanced past the records written
+ * @param buf
+ * @param size more than 4 * PIPE_TRACE_EVENT_LEN + 2, e.g. PIPE_TRACE_CHUNK + 1
+ * @return length without terminator, 0 once done or if buf is too small
+ */
+int pipe_trace_json(const pipe_trace_t *trace, uint32_t *pos, char *buf, int size) {
+    uint32_t count = __atomic_load_n(&trace->done, __ATOMIC_ACQUIRE);
+    if (count > PIPE_TRACE_SIZE) {
+        count = PIPE_TRACE_SIZE;
+    }
+    if (*pos > count || size <= REC_JSON_MAX + (int)sizeof(JSON_HEAD)) {
+        return 0;
+    }
+    int len = 0;
+    if (*pos == 0) {
+        len = fmt_str(buf, JSON_HEAD);
+    }
+    for (; *pos < count && len + REC_JSON_MAX < size; (*pos)++) {
+        const pipe_trace_rec_t *rec = &trace->rec[*pos];
+        if (rec->stage == PIPE_TRACE_NOTIFY || rec->stage >= PIPE_TRACE_STAGE_MAX) {
+            continue;
+        }
+        const pipe_trace_rec_t *from = rec_find(trace, count, rec->seq, rec->stage - 1);
+        if (from) {
+            len += span_json(&buf[len], span_name[rec->stage], from, rec);
+        }
+        from = (rec->stage == PIPE_TRACE_WIRE) ? rec_find(trace, count, rec->seq, PIPE_TRACE_NOTIFY) : NULL;
+        if (from) {
+            len += span_json(&buf[len], span_name[PIPE_TRACE_NOTIFY], from, rec);
+        }
+    }
+    if (*pos == count && len + (int)sizeof(JSON_TAIL) <= size) {
+        len += fmt_str(&buf[len], JSON_TAIL);
+        (*pos)++;
+    }
+    buf[len] = '\0';
+    return len;
+}
@@ -0,0 +1,63 @@
+#ifndef _PIPE_TRACE_H_
+#define _PIPE_TRACE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* DEFINES */
+#ifndef PIPE_TRACE_ENABLE
+#define PIPE_TRACE_ENABLE   0       /* 1: stamp samples at every pipeline stage, e.g. -DPIPE_TRACE_ENABLE=1 */
+#endif
+#define PIPE_TRACE_SIZE     512     /* records per capture */
+#define PIPE_TRACE_EVENT_LEN 112    /* worst-case JSON line of one event */
+#define PIPE_TRACE_CHUNK    1024    /* dump piece, one MQTT message */
+
+/* stamps vanish with their arguments when disabled */
+#if PIPE_TRACE_ENABLE
+#include "esp_timer.h"
+#define PIPE_TRACE_STAMP(stage, seq, dev_id, ts_us) pipe_trace_stamp(&pipe_trace, (stage), (seq), (dev_id), (ts_us))
+#define PIPE_TRACE_NOW()    esp_timer_get_time()
+#else
+#define PIPE_TRACE_STAMP(stage, seq, dev_id, ts_us) do { } while (0)
+#define PIPE_TRACE_NOW()    0
+#endif
+
+/* TYPE DEFINITIONS */
+/* where a sample is seen, spans between consecutive stages are named by pipe_trace_span_name */
+typedef enum {
+    PIPE_TRACE_NOTIFY = 0,  /* ESP_GATTC_NOTIFY_EVT or new advert, BTC task */
+    PIPE_TRACE_RING,        /* decoded and queued in the sample ring */
+    PIPE_TRACE_POP,         /* taken by the main loop */
+    PIPE_TRACE_BATCH,       /* out of aggregation or backlog, added to the batch */
+    PIPE_TRACE_PUBLISH,     /* batch encoded, handed to the publish window */
+    PIPE_TRACE_WIRE,        /* esp_mqtt_client_publish returned */
+    PIPE_TRACE_STAGE_MAX,
+} pipe_trace_stage_t;
+
+typedef struct pipe_trace_rec_t {
+    int64_t ts_us;
+    uint32_t seq;           /* sample_ring seq */
+    uint16_t dev_id;
+    uint8_t stage;
+} pipe_trace_rec_t;
+
+/* one capture, filled lock-free from any task until full, then dumped and restarted */
+typedef struct pipe_trace_t {
+    pipe_trace_rec_t rec[PIPE_TRACE_SIZE];
+    uint32_t head;          /* next record claimed */
+    uint32_t done;          /* records written */
+} pipe_trace_t;
+
+#if PIPE_TRACE_ENABLE
+extern pipe_trace_t pipe_trace;
+#endif
+
+/* PUBLIC PROTOTYPES */
+void pipe_trace_init(pipe_trace_t *trace);
+void pipe_trace_stamp(pipe_trace_t *trace, pipe_trace_stage_t stage, uint32_t seq, uint16_t dev_id, int64_t ts_us);
+bool pipe_trace_full(pipe_trace_t *trace);
+void pipe_trace_reset(pipe_trace_t *trace);
+const char *pipe_trace_span_name(pipe_trace_stage_t stage);
+int pipe_trace_json(const pipe_trace_t *trace, uint32_t *pos, char *buf, int size);
+
+#endif
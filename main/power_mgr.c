@@ -0,0 +1,113 @@
+#include <string.h>
+
+#include "power_mgr.h"
+
+/* STATIC PROTOTYPES */
+static void state_enter(power_mgr_t *pm, power_mgr_state_t state, int64_t now_us);
+
+/**
+ * @brief close time of current state and enter another
+ *
+ * @param pm
+ * @param state
+ * @param now_us
+ */
+static void state_enter(power_mgr_t *pm, power_mgr_state_t state, int64_t now_us) {
+    pm->time_us[pm->state] += now_us - pm->since_us;
+    pm->state = state;
+    pm->since_us = now_us;
+}
+
+/**
+ * @brief start with display on, inactivity counted from now
+ *
+ * @param pm
+ * @param cfg
+ * @param now_us
+ */
+void power_mgr_init(power_mgr_t *pm, const power_mgr_cfg_t *cfg, int64_t now_us) {
+    memset(pm, 0, sizeof(power_mgr_t));
+    pm->cfg = *cfg;
+    pm->state = POWER_MGR_ON;
+    pm->since_us = now_us;
+    pm->event_us = now_us;
+}
+
+/**
+ * @brief wake event: network change or touch while the display is off, restarts inactivity
+ *
+ * @param pm
+ * @param now_us
+ * @return POWER_MGR_ACT_ON if the display was off
+ */
+power_mgr_act_t power_mgr_event(power_mgr_t *pm, int64_t now_us) {
+    pm->event_us = now_us;
+    if (pm->state == POWER_MGR_OFF) {
+        state_enter(pm, POWER_MGR_ON, now_us);
+        pm->wake_count++;
+        return POWER_MGR_ACT_ON;
+    }
+    return POWER_MGR_ACT_NONE;
+}
+
+/**
+ * @brief turn the display off once there was neither input nor wake event for off_ms and LVGL is idle
+ *
+ * @param pm
+ * @param inactive_ms lv_disp_get_inactive_time(), time since last input
+ * @param idle_pct lv_task_get_idle()
+ * @param now_us
+ * @return POWER_MGR_ACT_OFF when the display is to be turned off
+ */
+power_mgr_act_t power_mgr_poll(power_mgr_t *pm, uint32_t inactive_ms, uint8_t idle_pct, int64_t now_us) {
+    if (pm->state != POWER_MGR_ON || pm->cfg.off_ms == 0) {
+        return POWER_MGR_ACT_NONE;
+    }
+    int64_t quiet_ms = (now_us - pm->event_us) / 1000;
+    if (inactive_ms < quiet_ms) {
+        quiet_ms = inactive_ms;
+    }
+    if (quiet_ms < pm->cfg.off_ms || idle_pct < pm->cfg.idle_min) {
+        return POWER_MGR_ACT_NONE;
+    }
+    state_enter(pm, POWER_MGR_OFF, now_us);
+    pm->off_count++;
+    return POWER_MGR_ACT_OFF;
+}
+
+/**
+ * @brief one pass of the GUI loop: wake events turn the display on, readings only redraw,
+ *        so sensors notifying every few seconds do not keep it lit
+ *
+ * @param pm
+ * @param in POWER_MGR_IN_x seen since the last pass
+ * @param inactive_ms lv_disp_get_inactive_time(), time since last touch
+ * @param idle_pct lv_task_get_idle()
+ * @param now_us
+ * @return POWER_MGR_ACT_ON or POWER_MGR_ACT_OFF when the display is to be switched
+ */
+power_mgr_act_t power_mgr_step(power_mgr_t *pm, uint32_t in, uint32_t inactive_ms, uint8_t idle_pct, int64_t now_us) {
+    if (in & (POWER_MGR_IN_TOUCH | POWER_MGR_IN_NET)) {
+        power_mgr_act_t act = power_mgr_event(pm, now_us);
+        if (act != POWER_MGR_ACT_NONE) {
+            return act;
+        }
+    }
+    return power_mgr_poll(pm, inactive_ms, idle_pct, now_us);
+}
+
+/**
+ * @brief time spent in a state since init, current state counted up to now
+ *
+ * @param pm
+ * @param state
+ * @param now_us
+ * @return us
+ */
+int64_t power_mgr_time(const power_mgr_t *pm, power_mgr_state_t state, int64_t now_us) {
+    int64_t time_us = pm->time_us[state];
+    if (state == pm->state) {
+        time_us += now_us - pm->since_us;
+    }
+    return time_us;
+}
@@ -0,0 +1,48 @@
+#ifndef _POWER_MGR_H_
+#define _POWER_MGR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* DEFINES */
+#define POWER_MGR_IN_TOUCH      0x01    /* touch while the display is off */
+#define POWER_MGR_IN_NET        0x02    /* WiFi or MQTT link changed */
+#define POWER_MGR_IN_READING    0x04    /* sensor reading, redrawn but not a reason to light the display */
+
+/* TYPE DEFINITIONS */
+typedef enum {
+    POWER_MGR_ON = 0,           /* display lit, LVGL refreshing */
+    POWER_MGR_OFF,              /* backlight off, LVGL suspended, light sleep allowed */
+    POWER_MGR_STATE_MAX,
+} power_mgr_state_t;
+
+/* what the caller does after power_mgr_poll or power_mgr_event */
+typedef enum {
+    POWER_MGR_ACT_NONE = 0,
+    POWER_MGR_ACT_OFF,          /* blank backlight, stop LVGL tick, allow light sleep */
+    POWER_MGR_ACT_ON,           /* light backlight, restart LVGL tick, restart inactivity */
+} power_mgr_act_t;
+
+typedef struct power_mgr_cfg_t {
+    uint32_t off_ms;            /* no touch nor wake event for this long turns the display off, 0: always on */
+    uint8_t idle_min;           /* lv_task_get_idle() percent needed, no animation or redraw running */
+} power_mgr_cfg_t;
+
+typedef struct power_mgr_t {
+    power_mgr_cfg_t cfg;
+    power_mgr_state_t state;
+    int64_t since_us;           /* current state entered */
+    int64_t event_us;           /* last wake event, see power_mgr_event */
+    int64_t time_us[POWER_MGR_STATE_MAX];   /* time in each state, current one up to since_us */
+    uint32_t off_count;         /* display turned off */
+    uint32_t wake_count;        /* display turned on by an event */
+} power_mgr_t;
+
+/* PUBLIC PROTOTYPES */
+void power_mgr_init(power_mgr_t *pm, const power_mgr_cfg_t *cfg, int64_t now_us);
+power_mgr_act_t power_mgr_event(power_mgr_t *pm, int64_t now_us);
+power_mgr_act_t power_mgr_poll(power_mgr_t *pm, uint32_t inactive_ms, uint8_t idle_pct, int64_t now_us);
+power_mgr_act_t power_mgr_step(power_mgr_t *pm, uint32_t in, uint32_t inactive_ms, uint8_t idle_pct, int64_t now_us);
+int64_t power_mgr_time(const power_mgr_t *pm, power_mgr_state_t state, int64_t now_us);
+
+#endif
@@ -0,0 +1,393 @@
+#include <string.h>
+#include <stddef.h>
+
+#include "remote_cfg.h"
+#include "mqtt_batch.h"
+#include "fmt_fixed.h"
+
+/* DEFINES */
+#define SCAN_MS_MIN     3           /* 2.5 ms controller minimum, rounded up */
+#define SCAN_MS_MAX     10240
+
+/* TYPE DEFINITIONS */
+typedef enum {
+    KEY_U32 = 0,
+    KEY_U16,
+    KEY_U8,
+    KEY_DUTY,       /* "interval/window" */
+    KEY_ALLOW,      /* "*" or comma separated addresses */
+} key_kind_t;
+
+/* command key, value stored at offset in remote_cfg_t */
+typedef struct key_def_t {
+    const char *name;
+    key_kind_t kind;
+    uint8_t group;
+    uint16_t offset;
+    uint32_t min;
+    uint32_t max;
+} key_def_t;
+
+/* STATIC VARIABLES */
+static const key_def_t key_tab[] = {
+    {"batch_ms", KEY_U32, REMOTE_CFG_F_BATCH, offsetof(remote_cfg_t, batch_ms), 0, REMOTE_CFG_MS_MAX},
+    {"batch_n", KEY_U8, REMOTE_CFG_F_BATCH, offsetof(remote_cfg_t, batch_count), 1, MQTT_BATCH_MAX},
+    {"agg_ms", KEY_U32, REMOTE_CFG_F_AGG, offsetof(remote_cfg_t, agg_ms), 0, REMOTE_CFG_MS_MAX},
+    {"agg_dt", KEY_U16, REMOTE_CFG_F_AGG, offsetof(remote_cfg_t, agg_temp_deadband), 0, UINT16_MAX},
+    {"agg_dh", KEY_U16, REMOTE_CFG_F_AGG, offsetof(remote_cfg_t, agg_humid_deadband), 0, UINT16_MAX},
+    {"scan_fast", KEY_DUTY, REMOTE_CFG_F_SCAN, offsetof(remote_cfg_t, scan_fast), SCAN_MS_MIN, SCAN_MS_MAX},
+    {"scan_slow", KEY_DUTY, REMOTE_CFG_F_SCAN, offsetof(remote_cfg_t, scan_slow), SCAN_MS_MIN, SCAN_MS_MAX},
+    {"scan_idle", KEY_U32, REMOTE_CFG_F_SCAN, offsetof(remote_cfg_t, scan_idle_ms), 0, REMOTE_CFG_MS_MAX},
+    {"allow", KEY_ALLOW, REMOTE_CFG_F_ALLOW, offsetof(remote_cfg_t, allow), 0, REMOTE_CFG_ALLOW_MAX},
+};
+#define KEY_NUM (sizeof(key_tab) / sizeof(key_tab[0]))
+
+/* STATIC PROTOTYPES */
+static bool is_sep(char c);
+static int hex_digit(char c);
+static bool parse_u32(const char *str, int len, uint32_t min, uint32_t max, uint32_t *val);
+static bool parse_bda(const char *str, int len, uint8_t *bda);
+static bool parse_allow(remote_cfg_t *cfg, const char *str, int len);
+static bool parse_pair(remote_cfg_t *cfg, const char *str, int len, uint8_t *groups);
+static bool duty_valid(const remote_cfg_duty_t *duty);
+static int fmt_duty(char *buf, const remote_cfg_duty_t *duty);
+
+/**
+ * @brief separator between key=value pairs
+ *
+ * @param c
+ * @return true if separator
+ */
+static bool is_sep(char c) {
+    return c == ' ' || c == ';' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/**
+ * @brief value of hex digit
+ *
+ * @param c
+ * @return 0..15, -1 if not a hex digit
+ */
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+/**
+ * @brief decimal number within range, digits only
+ *
+ * @param str
+ * @param len
+ * @param min
+ * @param max
+ * @param val [out]
+ * @return true if valid
+ */
+static bool parse_u32(const char *str, int len, uint32_t min, uint32_t max, uint32_t *val) {
+    uint64_t num = 0;
+    if (len <= 0 || len > 10) {
+        return false;
+    }
+    for (int idx = 0; idx < len; idx++) {
+        if (str[idx] < '0' || str[idx] > '9') {
+            return false;
+        }
+        num = num * 10 + (uint64_t)(str[idx] - '0');
+    }
+    if (num < min || num > max) {
+        return false;
+    }
+    *val = (uint32_t)num;
+    return true;
+}
+
+/**
+ * @brief device address "a4:c1:38:00:00:01", most significant byte first as printed by the stack
+ *
+ * @param str
+ * @param len
+ * @param bda [out]
+ * @return true if valid
+ */
+static bool parse_bda(const char *str, int len, uint8_t *bda) {
+    if (len != FMT_BDA_LEN) {
+        return false;
+    }
+    for (int idx = 0; idx < BLE_BDA_LEN; idx++) {
+        int hi = hex_digit(str[idx * 3]);
+        int lo = hex_digit(str[idx * 3 + 1]);
+        if (hi < 0 || lo < 0 || (idx < BLE_BDA_LEN - 1 && str[idx * 3 + 2] != ':')) {
+            return false;
+        }
+        bda[idx] = (uint8_t)(hi << 4 | lo);
+    }
+    return true;
+}
+
+/**
+ * @brief allow list, "*" for any device
+ *
+ * @param cfg
+ * @param str
+ * @param len
+ * @return true if valid
+ */
+static bool parse_allow(remote_cfg_t *cfg, const char *str, int len) {
+    int count = 0;
+    if (len == 1 && str[0] == '*') {
+        cfg->allow_count = 0;
+        memset(cfg->allow, 0, sizeof(cfg->allow));
+        return true;
+    }
+    uint8_t allow[REMOTE_CFG_ALLOW_MAX][BLE_BDA_LEN] = {{0}};
+    int start = 0;
+    for (int idx = 0; idx <= len; idx++) {
+        if (idx < len && str[idx] != ',') {
+            continue;
+        }
+        if (count == REMOTE_CFG_ALLOW_MAX || !parse_bda(&str[start], idx - start, allow[count])) {
+            return false;
+        }
+        count++;
+        start = idx + 1;
+    }
+    cfg->allow_count = (uint8_t)count;
+    memcpy(cfg->allow, allow, sizeof(cfg->allow));
+    return true;
+}
+
+/**
+ * @brief one key=value pair
+ *
+ * @param cfg
+ * @param str
+ * @param len
+ * @param groups [in,out] REMOTE_CFG_F_x of keys seen
+ * @return true if valid
+ */
+static bool parse_pair(remote_cfg_t *cfg, const char *str, int len, uint8_t *groups) {
+    int eq = 0;
+    while (eq < len && str[eq] != '=') {
+        eq++;
+    }
+    const key_def_t *key = NULL;
+    for (int idx = 0; idx < (int)KEY_NUM; idx++) {
+        if ((int)strlen(key_tab[idx].name) == eq && memcmp(key_tab[idx].name, str, eq) == 0) {
+            key = &key_tab[idx];
+            break;
+        }
+    }
+    if (key == NULL || eq == len) {
+        return false;
+    }
+    const char *val = &str[eq + 1];
+    int val_len = len - eq - 1;
+    uint8_t *field = (uint8_t *)cfg + key->offset;
+    uint32_t num;
+    bool ok = false;
+    switch (key->kind) {
+    case KEY_U32:
+        if ((ok = parse_u32(val, val_len, key->min, key->max, &num))) {
+            memcpy(field, &num, sizeof(uint32_t));
+        }
+        break;
+    case KEY_U16:
+        if ((ok = parse_u32(val, val_len, key->min, key->max, &num))) {
+            uint16_t num16 = (uint16_t)num;
+            memcpy(field, &num16, sizeof(uint16_t));
+        }
+        break;
+    case KEY_U8:
+        if ((ok = parse_u32(val, val_len, key->min, key->max, &num))) {
+            *field = (uint8_t)num;
+        }
+        break;
+    case KEY_DUTY: {
+        int slash = 0;
+        uint32_t window;
+        while (slash < val_len && val[slash] != '/') {
+            slash++;
+        }
+        ok = parse_u32(val, slash, key->min, key->max, &num) &&
+             parse_u32(&val[slash + 1], val_len - slash - 1, key->min, num, &window);
+        if (ok) {
+            remote_cfg_duty_t duty = {(uint16_t)num, (uint16_t)window};
+            memcpy(field, &duty, sizeof(duty));
+        }
+        break;
+    }
+    case KEY_ALLOW:
+        ok = parse_allow(cfg, val, val_len);
+        break;
+    }
+    *groups |= key->group;
+    return ok;
+}
+
+/**
+ * @brief scan duty within controller limits
+ *
+ * @param duty
+ * @return true if valid
+ */
+static bool duty_valid(const remote_cfg_duty_t *duty) {
+    return duty->interval >= SCAN_MS_MIN && duty->interval <= SCAN_MS_MAX &&
+           duty->window >= SCAN_MS_MIN && duty->window <= duty->interval;
+}
+
+/**
+ * @brief "interval/window", no terminator
+ *
+ * @param buf
+ * @param duty
+ * @return length written
+ */
+static int fmt_duty(char *buf, const remote_cfg_duty_t *duty) {
+    int len = fmt_u32(buf, duty->interval);
+    buf[len++] = '/';
+    return len + fmt_u32(&buf[len], duty->window);
+}
+
+/**
+ * @brief apply command "key=value key=value ...", pairs separated by space or ';',
+ *        all or nothing: a bad pair leaves cfg unchanged
+ *
+ * @param cfg
+ * @param cmd not terminated
+ * @param len
+ * @param err_pos [out] optional, offset of refused pair
+ * @return REMOTE_CFG_F_x of groups whose values changed, REMOTE_CFG_ERR if refused
+ */
+int remote_cfg_parse(remote_cfg_t *cfg, const char *cmd, int len, int *err_pos) {
+    remote_cfg_t next = *cfg;
+    uint8_t groups = 0;
+    int start = 0;
+    if (len > REMOTE_CFG_MSG_MAX) {
+        if (err_pos) {
+            *err_pos = REMOTE_CFG_MSG_MAX;
+        }
+        return REMOTE_CFG_ERR;
+    }
+    for (int idx = 0; idx <= len; idx++) {
+        if (idx < len && !is_sep(cmd[idx])) {
+            continue;
+        }
+        if (idx > start && !parse_pair(&next, &cmd[start], idx - start, &groups)) {
+            if (err_pos) {
+                *err_pos = start;
+            }
+            return REMOTE_CFG_ERR;
+        }
+        start = idx + 1;
+    }
+
+    int changed = 0;
+    if ((groups & REMOTE_CFG_F_BATCH) && (next.batch_ms != cfg->batch_ms || next.batch_count != cfg->batch_count)) {
+        changed |= REMOTE_CFG_F_BATCH;
+    }
+    if ((groups & REMOTE_CFG_F_AGG) &&
+        (next.agg_ms != cfg->agg_ms || next.agg_temp_deadband != cfg->agg_temp_deadband ||
+         next.agg_humid_deadband != cfg->agg_humid_deadband)) {
+        changed |= REMOTE_CFG_F_AGG;
+    }
+    if ((groups & REMOTE_CFG_F_SCAN) &&
+        (memcmp(&next.scan_fast, &cfg->scan_fast, sizeof(remote_cfg_duty_t)) ||
+         memcmp(&next.scan_slow, &cfg->scan_slow, sizeof(remote_cfg_duty_t)) || next.scan_idle_ms != cfg->scan_idle_ms)) {
+        changed |= REMOTE_CFG_F_SCAN;
+    }
+    if ((groups & REMOTE_CFG_F_ALLOW) &&
+        (next.allow_count != cfg->allow_count || memcmp(next.allow, cfg->allow, sizeof(next.allow)))) {
+        changed |= REMOTE_CFG_F_ALLOW;
+    }
+    *cfg = next;
+    return changed;
+}
+
+/**
+ * @brief take settings from NVS blob if it is of this layout and in range
+ *
+ * @param cfg left unchanged if blob is refused
+ * @param blob
+ * @param len
+ * @return true if loaded
+ */
+bool remote_cfg_load(remote_cfg_t *cfg, const void *blob, size_t len) {
+    remote_cfg_t next;
+    if (len != sizeof(remote_cfg_t)) {
+        return false;
+    }
+    memcpy(&next, blob, sizeof(remote_cfg_t));
+    if (next.magic != REMOTE_CFG_MAGIC || next.batch_ms > REMOTE_CFG_MS_MAX || next.agg_ms > REMOTE_CFG_MS_MAX ||
+        next.batch_count < 1 || next.batch_count > MQTT_BATCH_MAX || next.allow_count > REMOTE_CFG_ALLOW_MAX ||
+        !duty_valid(&next.scan_fast) || !duty_valid(&next.scan_slow) || next.scan_idle_ms > REMOTE_CFG_MS_MAX) {
+        return false;
+    }
+    *cfg = next;
+    return true;
+}
+
+/**
+ * @brief device may be connected and its readings forwarded
+ *
+ * @param cfg
+ * @param bda
+ * @return true if allow list is empty or holds bda
+ */
+bool remote_cfg_allowed(const remote_cfg_t *cfg, const uint8_t *bda) {
+    for (int idx = 0; idx < cfg->allow_count; idx++) {
+        if (memcmp(cfg->allow[idx], bda, BLE_BDA_LEN) == 0) {
+            return true;
+        }
+    }
+    return cfg->allow_count == 0;
+}
+
+/**
+ * @brief settings as a command that restores them, published as config state
+ *
+ * @param cfg
+ * @param buf
+ * @param size at least REMOTE_CFG_TEXT_LEN + 1
+ * @return length without terminator, 0 if buf is too small
+ */
+int remote_cfg_text(const remote_cfg_t *cfg, char *buf, int size) {
+    if (size <= REMOTE_CFG_TEXT_LEN) {
+        return 0;
+    }
+    int len = fmt_str(buf, "batch_ms=");
+    len += fmt_u32(&buf[len], cfg->batch_ms);
+    len += fmt_str(&buf[len], " batch_n=");
+    len += fmt_u32(&buf[len], cfg->batch_count);
+    len += fmt_str(&buf[len], " agg_ms=");
+    len += fmt_u32(&buf[len], cfg->agg_ms);
+    len += fmt_str(&buf[len], " agg_dt=");
+    len += fmt_u32(&buf[len], cfg->agg_temp_deadband);
+    len += fmt_str(&buf[len], " agg_dh=");
+    len += fmt_u32(&buf[len], cfg->agg_humid_deadband);
+    len += fmt_str(&buf[len], " scan_fast=");
+    len += fmt_duty(&buf[len], &cfg->scan_fast);
+    len += fmt_str(&buf[len], " scan_slow=");
+    len += fmt_duty(&buf[len], &cfg->scan_slow);
+    len += fmt_str(&buf[len], " scan_idle=");
+    len += fmt_u32(&buf[len], cfg->scan_idle_ms);
+    len += fmt_str(&buf[len], " allow=");
+    for (int idx = 0; idx < cfg->allow_count; idx++) {
+        if (idx > 0) {
+            buf[len++] = ',';
+        }
+        len += fmt_bda(&buf[len], cfg->allow[idx]);
+    }
+    if (cfg->allow_count == 0) {
+        buf[len++] = '*';
+    }
+    buf[len] = '\0';
+    return len;
+}
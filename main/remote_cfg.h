@@ -0,0 +1,52 @@
+#ifndef _REMOTE_CFG_H_
+#define _REMOTE_CFG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "ble_conn.h"
+
+/* DEFINES */
+#define REMOTE_CFG_MAGIC        0x52434631  /* "RCF1", bump when remote_cfg_t changes */
+#define REMOTE_CFG_ALLOW_MAX    8           /* devices in the allow list */
+#define REMOTE_CFG_MSG_MAX      320         /* longest command accepted, a full one fits */
+#define REMOTE_CFG_TEXT_LEN     320         /* max chars of remote_cfg_text */
+#define REMOTE_CFG_MS_MAX       3600000     /* longest period accepted */
+#define REMOTE_CFG_ERR          (-1)        /* remote_cfg_parse: command refused, nothing changed */
+
+/* groups changed by a command, applied by the owner of each stage */
+#define REMOTE_CFG_F_BATCH      0x01        /* batch_ms, batch_n */
+#define REMOTE_CFG_F_AGG        0x02        /* agg_ms, agg_dt, agg_dh */
+#define REMOTE_CFG_F_SCAN       0x04        /* scan_fast, scan_slow, scan_idle */
+#define REMOTE_CFG_F_ALLOW      0x08        /* allow */
+
+/* TYPE DEFINITIONS */
+/* BLE scan duty, ms */
+typedef struct remote_cfg_duty_t {
+    uint16_t interval;
+    uint16_t window;
+} remote_cfg_duty_t;
+
+/* settings tunable over MQTT, persisted as one NVS blob */
+typedef struct remote_cfg_t {
+    uint32_t magic;
+    uint32_t batch_ms;              /* publish interval, oldest pending sample age */
+    uint32_t agg_ms;                /* summary window per device, 0: forward every reading */
+    uint32_t scan_idle_ms;          /* gap between sparse scans */
+    uint16_t agg_temp_deadband;     /* 0.01 degC */
+    uint16_t agg_humid_deadband;    /* 0.01 %RH */
+    remote_cfg_duty_t scan_fast;
+    remote_cfg_duty_t scan_slow;
+    uint8_t batch_count;            /* publish when this many samples are pending */
+    uint8_t allow_count;            /* 0: any device */
+    uint8_t allow[REMOTE_CFG_ALLOW_MAX][BLE_BDA_LEN];
+} remote_cfg_t;
+
+/* PUBLIC PROTOTYPES */
+int remote_cfg_parse(remote_cfg_t *cfg, const char *cmd, int len, int *err_pos);
+bool remote_cfg_load(remote_cfg_t *cfg, const void *blob, size_t len);
+bool remote_cfg_allowed(const remote_cfg_t *cfg, const uint8_t *bda);
+int remote_cfg_text(const remote_cfg_t *cfg, char *buf, int size);
+
+#endif
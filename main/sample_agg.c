@@ -0,0 +1,211 @@
+#include <string.h>
+#include <stdlib.h>
+
+#include "sample_agg.h"
+
+/* STATIC PROTOTYPES */
+static sample_agg_dev_t *find_dev(sample_agg_t *agg, uint16_t dev_id);
+static int32_t mean_of(int32_t sum, int count);
+static bool beyond_deadband(const sample_agg_t *agg, const sample_agg_dev_t *dev, int16_t temp, uint16_t humid);
+static void window_close(sample_agg_t *agg, sample_agg_dev_t *dev, int64_t now_us, bool force);
+
+/**
+ * @brief window of device, a free one is claimed for a new device
+ *
+ * @param agg
+ * @param dev_id
+ * @return window or NULL if table is full
+ */
+static sample_agg_dev_t *find_dev(sample_agg_t *agg, uint16_t dev_id) {
+    sample_agg_dev_t *free_dev = NULL;
+    for (int idx = 0; idx < SAMPLE_AGG_DEV_MAX; idx++) {
+        sample_agg_dev_t *dev = &agg->dev[idx];
+        if (dev->used && dev->dev_id == dev_id) {
+            return dev;
+        }
+        if (!dev->used && free_dev == NULL) {
+            free_dev = dev;
+        }
+    }
+    if (free_dev) {
+        memset(free_dev, 0, sizeof(sample_agg_dev_t));
+        free_dev->used = true;
+        free_dev->dev_id = dev_id;
+    }
+    return free_dev;
+}
+
+/**
+ * @brief mean rounded to nearest
+ *
+ * @param sum
+ * @param count > 0
+ * @return mean
+ */
+static int32_t mean_of(int32_t sum, int count) {
+    return (sum >= 0) ? (sum + count / 2) / count : (sum - count / 2) / count;
+}
+
+/**
+ * @brief reading moved away from the last summary sent
+ *
+ * @param agg
+ * @param dev
+ * @param temp
+ * @param humid
+ * @return true if temperature or humidity differ by at least their deadband
+ */
+static bool beyond_deadband(const sample_agg_t *agg, const sample_agg_dev_t *dev, int16_t temp, uint16_t humid) {
+    return (agg->cfg.temp_deadband && abs(temp - dev->last_temp) >= agg->cfg.temp_deadband) ||
+           (agg->cfg.humid_deadband && abs(humid - dev->last_humid) >= agg->cfg.humid_deadband);
+}
+
+/**
+ * @brief emit summary of open window and start a new one
+ *
+ * @param agg
+ * @param dev count > 0
+ * @param now_us
+ * @param force report even if within the deadband
+ */
+static void window_close(sample_agg_t *agg, sample_agg_dev_t *dev, int64_t now_us, bool force) {
+    sensor_sample_t rec = dev->last;
+    rec.temp_centi = (int16_t)mean_of(dev->temp_sum, dev->count);
+    rec.humid_centi = (uint16_t)mean_of((int32_t)dev->humid_sum, dev->count);
+    rec.rssi = (int8_t)mean_of(dev->rssi_sum, dev->count);
+    rec.count = dev->count;
+    rec.temp_min_centi = dev->temp_min;
+    rec.temp_max_centi = dev->temp_max;
+    rec.humid_min_centi = dev->humid_min;
+    rec.humid_max_centi = dev->humid_max;
+    dev->count = 0;
+
+    bool deadband = agg->cfg.temp_deadband || agg->cfg.humid_deadband;
+    bool silent_due = agg->cfg.max_silent_us && now_us - dev->report_us >= agg->cfg.max_silent_us;
+    if (!force && deadband && dev->reported && !silent_due &&
+        !beyond_deadband(agg, dev, rec.temp_centi, rec.humid_centi)) {
+        agg->suppress_count++;
+        return;
+    }
+    dev->reported = true;
+    dev->report_us = now_us;
+    dev->last_temp = rec.temp_centi;
+    dev->last_humid = rec.humid_centi;
+    agg->out_count++;
+    if (agg->emit) {
+        agg->emit(&rec, agg->ctx);
+    }
+}
+
+/**
+ * @brief set up aggregation stage, no device windows open
+ *
+ * @param agg
+ * @param cfg
+ * @param emit sink for summaries
+ * @param ctx passed to emit
+ */
+void sample_agg_init(sample_agg_t *agg, const sample_agg_cfg_t *cfg, sample_agg_emit_t emit, void *ctx) {
+    memset(agg, 0, sizeof(sample_agg_t));
+    agg->cfg = *cfg;
+    agg->emit = emit;
+    agg->ctx = ctx;
+}
+
+/**
+ * @brief fold reading into the window of its device, a reading beyond the deadband
+ *        of the last summary closes the window at once
+ *
+ * @param agg
+ * @param sample single reading, ts_us is taken as current time
+ */
+void sample_agg_add(sample_agg_t *agg, const sensor_sample_t *sample) {
+    agg->in_count++;
+    sample_agg_dev_t *dev = (agg->cfg.window_us) ? find_dev(agg, sample->dev_id) : NULL;
+    if (dev == NULL) {
+        agg->overflow_count += agg->cfg.window_us != 0;
+        agg->out_count++;
+        if (agg->emit) {
+            agg->emit(sample, agg->ctx);
+        }
+        return;
+    }
+    if (dev->count == 0) {
+        dev->first_us = sample->ts_us;
+        dev->temp_sum = 0;
+        dev->humid_sum = 0;
+        dev->rssi_sum = 0;
+        dev->temp_min = dev->temp_max = sample->temp_centi;
+        dev->humid_min = dev->humid_max = sample->humid_centi;
+    }
+    dev->count++;
+    dev->temp_sum += sample->temp_centi;
+    dev->humid_sum += sample->humid_centi;
+    dev->rssi_sum += sample->rssi;
+    dev->temp_min = (sample->temp_centi < dev->temp_min) ? sample->temp_centi : dev->temp_min;
+    dev->temp_max = (sample->temp_centi > dev->temp_max) ? sample->temp_centi : dev->temp_max;
+    dev->humid_min = (sample->humid_centi < dev->humid_min) ? sample->humid_centi : dev->humid_min;
+    dev->humid_max = (sample->humid_centi > dev->humid_max) ? sample->humid_centi : dev->humid_max;
+    dev->last = *sample;
+
+    if (dev->reported && beyond_deadband(agg, dev, sample->temp_centi, sample->humid_centi)) {
+        agg->change_count++;
+        window_close(agg, dev, sample->ts_us, true);
+        /* the mean still carries the old level, later readings are compared to the new one */
+        dev->last_temp = sample->temp_centi;
+        dev->last_humid = sample->humid_centi;
+    } else if (dev->count == UINT16_MAX) {
+        window_close(agg, dev, sample->ts_us, false);
+    }
+}
+
+/**
+ * @brief close windows that have elapsed
+ *
+ * @param agg
+ * @param now_us
+ * @return windows closed, reported or not
+ */
+int sample_agg_poll(sample_agg_t *agg, int64_t now_us) {
+    int closed = 0;
+    for (int idx = 0; idx < SAMPLE_AGG_DEV_MAX; idx++) {
+        sample_agg_dev_t *dev = &agg->dev[idx];
+        if (dev->used && dev->count && now_us - dev->first_us >= agg->cfg.window_us) {
+            window_close(agg, dev, now_us, false);
+            closed++;
+        }
+    }
+    return closed;
+}
+
+/**
+ * @brief time at which the next window ends
+ *
+ * @param agg
+ * @return timestamp in us, INT64_MAX if no window is open
+ */
+int64_t sample_agg_deadline(const sample_agg_t *agg) {
+    int64_t deadline = INT64_MAX;
+    for (int idx = 0; idx < SAMPLE_AGG_DEV_MAX; idx++) {
+        const sample_agg_dev_t *dev = &agg->dev[idx];
+        int64_t end_us = dev->first_us + agg->cfg.window_us;
+        if (dev->used && dev->count && end_us < deadline) {
+            deadline = end_us;
+        }
+    }
+    return deadline;
+}
+
+/**
+ * @brief report every open window now, deadband ignored
+ *
+ * @param agg
+ */
+void sample_agg_flush(sample_agg_t *agg) {
+    for (int idx = 0; idx < SAMPLE_AGG_DEV_MAX; idx++) {
+        sample_agg_dev_t *dev = &agg->dev[idx];
+        if (dev->used && dev->count) {
+            window_close(agg, dev, dev->last.ts_us, true);
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef _SAMPLE_AGG_H_
+#define _SAMPLE_AGG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sample_ring.h"
+
+/* DEFINES */
+#define SAMPLE_AGG_DEV_MAX  64      /* devices summarized, later ones are forwarded as single readings */
+
+/* TYPE DEFINITIONS */
+/* sink for a summary, or a single reading when aggregation is off */
+typedef void (*sample_agg_emit_t)(const sensor_sample_t *rec, void *ctx);
+
+typedef struct sample_agg_cfg_t {
+    uint32_t window_us;         /* summary period per device, 0: forward every reading */
+    uint16_t temp_deadband;     /* 0.01 degC, 0: report every window */
+    uint16_t humid_deadband;    /* 0.01 %RH */
+    uint32_t max_silent_us;     /* report even without change after this long, 0: never */
+} sample_agg_cfg_t;
+
+/* open window of one device, constant size whatever the reading rate */
+typedef struct sample_agg_dev_t {
+    bool used;
+    bool reported;              /* last_temp/last_humid valid */
+    uint16_t dev_id;
+    uint16_t count;
+    int64_t first_us;           /* arrival of first reading of the window */
+    int64_t report_us;          /* last summary sent */
+    int32_t temp_sum;
+    uint32_t humid_sum;
+    int32_t rssi_sum;
+    int16_t temp_min;
+    int16_t temp_max;
+    uint16_t humid_min;
+    uint16_t humid_max;
+    int16_t last_temp;          /* mean of last summary sent */
+    uint16_t last_humid;
+    sensor_sample_t last;       /* newest reading, timestamp and seq of the summary */
+} sample_agg_dev_t;
+
+typedef struct sample_agg_t {
+    sample_agg_cfg_t cfg;
+    sample_agg_emit_t emit;
+    void *ctx;
+    uint32_t in_count;          /* readings added */
+    uint32_t out_count;         /* records emitted */
+    uint32_t change_count;      /* windows closed early by a reading beyond the deadband */
+    uint32_t suppress_count;    /* windows not reported, mean within the deadband */
+    uint32_t overflow_count;    /* readings forwarded unsummarized, device table full */
+    sample_agg_dev_t dev[SAMPLE_AGG_DEV_MAX];
+} sample_agg_t;
+
+/* PUBLIC PROTOTYPES */
+void sample_agg_init(sample_agg_t *agg, const sample_agg_cfg_t *cfg, sample_agg_emit_t emit, void *ctx);
+void sample_agg_add(sample_agg_t *agg, const sensor_sample_t *sample);
+int sample_agg_poll(sample_agg_t *agg, int64_t now_us);
+int64_t sample_agg_deadline(const sample_agg_t *agg);
+void sample_agg_flush(sample_agg_t *agg);
+
+#endif
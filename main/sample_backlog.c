@@ -0,0 +1,115 @@
+#include <string.h>
+
+#include "sample_backlog.h"
+
+/* STATIC PROTOTYPES */
+static void backlog_refill(sample_backlog_t *backlog, int64_t now_us);
+
+/**
+ * @brief add tokens for the time elapsed since last refill
+ *
+ * @param backlog
+ * @param now_us
+ */
+static void backlog_refill(sample_backlog_t *backlog, int64_t now_us) {
+    int64_t dt_us = now_us - backlog->last_us;
+    if (dt_us <= 0) {
+        return;
+    }
+    uint64_t credit = backlog->credit + (uint64_t)dt_us * backlog->rate;
+    uint64_t max_credit = (uint64_t)backlog->burst * SAMPLE_BACKLOG_TOKEN;
+    backlog->credit = (credit > max_credit) ? max_credit : credit;
+    backlog->last_us = now_us;
+}
+
+/**
+ * @brief set up backlog on top of a storage backend
+ *
+ * @param backlog
+ * @param store
+ * @param rate drained samples per second
+ * @param burst max samples drained at once
+ */
+void sample_backlog_init(sample_backlog_t *backlog, sample_store_t *store, uint32_t rate, uint32_t burst) {
+    memset(backlog, 0, sizeof(sample_backlog_t));
+    backlog->store = store;
+    backlog->rate = rate;
+    backlog->burst = burst;
+}
+
+/**
+ * @brief keep sample while the broker is unreachable
+ *
+ * @param backlog
+ * @param sample
+ * @return false on storage error
+ */
+bool sample_backlog_store(sample_backlog_t *backlog, const sensor_sample_t *sample) {
+    backlog->stored++;
+    return backlog->store->ops->append(backlog->store, sample);
+}
+
+/**
+ * @brief pass stored samples to sink, oldest first, as far as the rate limit allows
+ *
+ * @param backlog
+ * @param now_us
+ * @param sink
+ * @param ctx passed to sink
+ * @return number drained
+ */
+int sample_backlog_drain(sample_backlog_t *backlog, int64_t now_us, sample_backlog_sink_t sink, void *ctx) {
+    sensor_sample_t chunk[SAMPLE_BACKLOG_CHUNK];
+    int total = 0;
+
+    backlog_refill(backlog, now_us);
+    if (sample_backlog_count(backlog) == 0) {
+        /* do not bank tokens while idle */
+        backlog->credit = (backlog->credit > SAMPLE_BACKLOG_TOKEN) ? SAMPLE_BACKLOG_TOKEN : backlog->credit;
+        return 0;
+    }
+    while (backlog->credit >= SAMPLE_BACKLOG_TOKEN) {
+        int max = (int)(backlog->credit / SAMPLE_BACKLOG_TOKEN);
+        int n = backlog->store->ops->peek(backlog->store, chunk, (max < SAMPLE_BACKLOG_CHUNK) ? max : SAMPLE_BACKLOG_CHUNK);
+        if (n == 0) {
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            sink(&chunk[i], ctx);
+        }
+        backlog->store->ops->consume(backlog->store, n);
+        backlog->credit -= (uint64_t)n * SAMPLE_BACKLOG_TOKEN;
+        backlog->drained += n;
+        total += n;
+    }
+    return total;
+}
+
+/**
+ * @brief time at which the next stored sample may be drained
+ *
+ * @param backlog
+ * @param now_us
+ * @return timestamp in us, INT64_MAX if backlog is empty
+ */
+int64_t sample_backlog_next_us(const sample_backlog_t *backlog, int64_t now_us) {
+    if (sample_backlog_count(backlog) == 0 || backlog->rate == 0) {
+        return INT64_MAX;
+    }
+    if (backlog->credit >= SAMPLE_BACKLOG_TOKEN) {
+        return now_us;
+    }
+    uint64_t missing = SAMPLE_BACKLOG_TOKEN - backlog->credit;
+    int64_t next_us = backlog->last_us + (int64_t)((missing + backlog->rate - 1) / backlog->rate);
+    return (next_us > now_us) ? next_us : now_us;
+}
+
+/**
+ * @brief number of samples waiting to be drained
+ *
+ * @param backlog
+ * @return count
+ */
+uint32_t sample_backlog_count(const sample_backlog_t *backlog) {
+    return sample_store_count(backlog->store);
+}
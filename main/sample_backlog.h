@@ -0,0 +1,35 @@
+#ifndef _SAMPLE_BACKLOG_H_
+#define _SAMPLE_BACKLOG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sample_store.h"
+
+/* DEFINES */
+#define SAMPLE_BACKLOG_CHUNK    16      /* samples read from store at once */
+#define SAMPLE_BACKLOG_TOKEN    1000000 /* credit per drained sample, rate x us gives exact credit */
+
+/* TYPE DEFINITIONS */
+/* receives drained samples, e.g. the publish batch */
+typedef void (*sample_backlog_sink_t)(const sensor_sample_t *sample, void *ctx);
+
+/* offline buffer with token-bucket rate limited drain */
+typedef struct sample_backlog_t {
+    sample_store_t *store;
+    uint32_t rate;          /* drained samples per second */
+    uint32_t burst;         /* max tokens */
+    uint64_t credit;        /* available tokens x SAMPLE_BACKLOG_TOKEN */
+    int64_t last_us;        /* last token refill */
+    uint32_t stored;
+    uint32_t drained;
+} sample_backlog_t;
+
+/* PUBLIC PROTOTYPES */
+void sample_backlog_init(sample_backlog_t *backlog, sample_store_t *store, uint32_t rate, uint32_t burst);
+bool sample_backlog_store(sample_backlog_t *backlog, const sensor_sample_t *sample);
+int sample_backlog_drain(sample_backlog_t *backlog, int64_t now_us, sample_backlog_sink_t sink, void *ctx);
+int64_t sample_backlog_next_us(const sample_backlog_t *backlog, int64_t now_us);
+uint32_t sample_backlog_count(const sample_backlog_t *backlog);
+
+#endif
@@ -0,0 +1,124 @@
+#include <string.h>
+
+#include "sample_ring.h"
+
+/* DEFINES */
+#define RING_MASK       (SAMPLE_RING_SIZE - 1)
+#define PUSH_RETRY_MAX  16
+
+/* STATIC PROTOTYPES */
+static bool ring_enqueue(sample_ring_t *ring, const sensor_sample_t *sample);
+
+/**
+ * @brief claim a free cell and store sample (bounded MPMC queue, D. Vyukov)
+ *
+ * @param ring
+ * @param sample
+ * @return false if ring is full
+ */
+static bool ring_enqueue(sample_ring_t *ring, const sensor_sample_t *sample) {
+    uint32_t pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    sample_ring_cell_t *cell;
+    for (;;) {
+        cell = &ring->cell[pos & RING_MASK];
+        uint32_t seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+        int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0) {
+            /* cell is free for this lap */
+            if (__atomic_compare_exchange_n(&ring->head, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            /* consumer has not released the cell yet */
+            return false;
+        } else {
+            pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+        }
+    }
+    cell->sample = *sample;
+    __atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/**
+ * @brief clear ring and counters
+ *
+ * @param ring
+ * @param policy overflow policy
+ */
+void sample_ring_init(sample_ring_t *ring, sample_ring_policy_t policy) {
+    memset(ring, 0, sizeof(sample_ring_t));
+    for (uint32_t i = 0; i < SAMPLE_RING_SIZE; i++) {
+        ring->cell[i].seq = i;
+    }
+    ring->policy = policy;
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief queue a copy of sample, non-blocking, callable from several tasks
+ *
+ * @param ring
+ * @param sample [in/out] seq is assigned here
+ * @return false if sample was dropped
+ */
+bool sample_ring_push(sample_ring_t *ring, sensor_sample_t *sample) {
+    sample->seq = __atomic_fetch_add(&ring->next_seq, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&ring->push_count, 1, __ATOMIC_RELAXED);
+    for (int retry = 0; !ring_enqueue(ring, sample); retry++) {
+        /* give up if another producer keeps the oldest cell busy */
+        if (ring->policy == SAMPLE_RING_DROP_NEWEST || retry >= PUSH_RETRY_MAX) {
+            __atomic_fetch_add(&ring->drop_newest, 1, __ATOMIC_RELAXED);
+            return false;
+        }
+        /* make room by consuming the oldest sample, safe as pop is multi-consumer */
+        sensor_sample_t oldest;
+        if (sample_ring_pop(ring, &oldest)) {
+            __atomic_fetch_add(&ring->drop_oldest, 1, __ATOMIC_RELAXED);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief take oldest sample, non-blocking
+ *
+ * @param ring
+ * @param sample [out]
+ * @return false if ring is empty
+ */
+bool sample_ring_pop(sample_ring_t *ring, sensor_sample_t *sample) {
+    uint32_t pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    sample_ring_cell_t *cell;
+    for (;;) {
+        cell = &ring->cell[pos & RING_MASK];
+        uint32_t seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+        int32_t diff = (int32_t)(seq - (pos + 1));
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&ring->tail, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            /* empty, or producer still writing the cell */
+            return false;
+        } else {
+            pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+        }
+    }
+    *sample = cell->sample;
+    /* release cell for the next lap */
+    __atomic_store_n(&cell->seq, pos + SAMPLE_RING_SIZE, __ATOMIC_RELEASE);
+    return true;
+}
+
+/**
+ * @brief approximate number of queued samples
+ *
+ * @param ring
+ * @return count
+ */
+uint32_t sample_ring_count(sample_ring_t *ring) {
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    return head - tail;
+}
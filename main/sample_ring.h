@@ -0,0 +1,55 @@
+#ifndef _SAMPLE_RING_H_
+#define _SAMPLE_RING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* DEFINES */
+#define SAMPLE_RING_SIZE    64      /* power of 2 */
+
+/* TYPE DEFINITIONS */
+/* one sensor reading, or a summary of several (sample_agg.c), passed by value */
+typedef struct sensor_sample_t {
+    int64_t ts_us;          /* esp_timer_get_time() when received, of the last one if summarized */
+    uint32_t seq;           /* assigned by sample_ring_push, gaps show drops */
+    uint16_t dev_id;        /* connection slot or advertiser index */
+    int16_t temp_centi;     /* 0.01 degC, mean if summarized */
+    uint16_t humid_centi;   /* 0.01 %RH, mean if summarized */
+    int8_t rssi;            /* dBm, 0 if unknown */
+    uint16_t count;         /* readings summarized, 0 for a single reading and fields below unused */
+    int16_t temp_min_centi;
+    int16_t temp_max_centi;
+    uint16_t humid_min_centi;
+    uint16_t humid_max_centi;
+} sensor_sample_t;
+
+/* what to discard when the ring is full */
+typedef enum {
+    SAMPLE_RING_DROP_NEWEST = 0,    /* reject incoming sample */
+    SAMPLE_RING_DROP_OLDEST,        /* overwrite oldest queued sample */
+} sample_ring_policy_t;
+
+typedef struct sample_ring_cell_t {
+    uint32_t seq;           /* cell sequence, owned by producers/consumer in turn */
+    sensor_sample_t sample;
+} sample_ring_cell_t;
+
+/* bounded lock-free multi-producer ring, safe for several consumers as well */
+typedef struct sample_ring_t {
+    sample_ring_cell_t cell[SAMPLE_RING_SIZE];
+    uint32_t head;          /* next push position */
+    uint32_t tail;          /* next pop position */
+    uint32_t next_seq;
+    uint32_t push_count;
+    uint32_t drop_newest;   /* samples rejected while full */
+    uint32_t drop_oldest;   /* queued samples overwritten while full */
+    sample_ring_policy_t policy;
+} sample_ring_t;
+
+/* PUBLIC PROTOTYPES */
+void sample_ring_init(sample_ring_t *ring, sample_ring_policy_t policy);
+bool sample_ring_push(sample_ring_t *ring, sensor_sample_t *sample);
+bool sample_ring_pop(sample_ring_t *ring, sensor_sample_t *sample);
+uint32_t sample_ring_count(sample_ring_t *ring);
+
+#endif
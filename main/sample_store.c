@@ -0,0 +1,207 @@
+#include <string.h>
+
+#include "sample_store.h"
+
+/* STATIC PROTOTYPES */
+static bool ram_append(sample_store_t *store, const sensor_sample_t *sample);
+static int ram_peek(sample_store_t *store, sensor_sample_t *samples, int max);
+static void store_consume(sample_store_t *store, int n);
+static bool file_append(sample_store_t *store, const sensor_sample_t *sample);
+static int file_peek(sample_store_t *store, sensor_sample_t *samples, int max);
+static void file_consume(sample_store_t *store, int n);
+static bool file_write_hdr(sample_store_t *store);
+
+/* STATIC VARIABLES */
+static const sample_store_ops_t ram_ops = {
+    .append = ram_append,
+    .peek = ram_peek,
+    .consume = store_consume,
+};
+static const sample_store_ops_t file_ops = {
+    .append = file_append,
+    .peek = file_peek,
+    .consume = file_consume,
+};
+
+/**
+ * @brief append to RAM ring, overwrite oldest when full
+ *
+ * @param store
+ * @param sample
+ * @return true
+ */
+static bool ram_append(sample_store_t *store, const sensor_sample_t *sample) {
+    if (sample_store_count(store) >= store->capacity) {
+        store->tail++;
+        store->drop_count++;
+    }
+    store->ram[store->head % store->capacity] = *sample;
+    store->head++;
+    return true;
+}
+
+/**
+ * @brief copy oldest samples from RAM ring without removing them
+ *
+ * @param store
+ * @param samples [out]
+ * @param max
+ * @return number copied
+ */
+static int ram_peek(sample_store_t *store, sensor_sample_t *samples, int max) {
+    int n = 0;
+    for (uint32_t pos = store->tail; pos != store->head && n < max; pos++) {
+        samples[n++] = store->ram[pos % store->capacity];
+    }
+    return n;
+}
+
+/**
+ * @brief remove oldest samples
+ *
+ * @param store
+ * @param n
+ */
+static void store_consume(sample_store_t *store, int n) {
+    uint32_t count = sample_store_count(store);
+    store->tail += ((uint32_t)n < count) ? (uint32_t)n : count;
+}
+
+/**
+ * @brief persist head/tail so the backlog survives a reboot
+ *
+ * @param store
+ * @return false on I/O error
+ */
+static bool file_write_hdr(sample_store_t *store) {
+    sample_store_hdr_t hdr = {
+        .magic = SAMPLE_STORE_MAGIC,
+        .capacity = store->capacity,
+        .head = store->head,
+        .tail = store->tail,
+        .drop_count = store->drop_count,
+    };
+    if (fseek(store->file, 0, SEEK_SET) != 0 || fwrite(&hdr, sizeof(hdr), 1, store->file) != 1) {
+        return false;
+    }
+    return fflush(store->file) == 0;
+}
+
+/**
+ * @brief append record to log file ring, then commit it in header
+ *
+ * @param store
+ * @param sample
+ * @return false on I/O error
+ */
+static bool file_append(sample_store_t *store, const sensor_sample_t *sample) {
+    long offset = sizeof(sample_store_hdr_t) + (long)(store->head % store->capacity) * sizeof(sensor_sample_t);
+    if (fseek(store->file, offset, SEEK_SET) != 0 || fwrite(sample, sizeof(sensor_sample_t), 1, store->file) != 1) {
+        return false;
+    }
+    if (sample_store_count(store) >= store->capacity) {
+        store->tail++;
+        store->drop_count++;
+    }
+    store->head++;
+    return file_write_hdr(store);
+}
+
+/**
+ * @brief read oldest records from log file
+ *
+ * @param store
+ * @param samples [out]
+ * @param max
+ * @return number read
+ */
+static int file_peek(sample_store_t *store, sensor_sample_t *samples, int max) {
+    int n = 0;
+    for (uint32_t pos = store->tail; pos != store->head && n < max; pos++) {
+        long offset = sizeof(sample_store_hdr_t) + (long)(pos % store->capacity) * sizeof(sensor_sample_t);
+        if (fseek(store->file, offset, SEEK_SET) != 0 || fread(&samples[n], sizeof(sensor_sample_t), 1, store->file) != 1) {
+            break;
+        }
+        n++;
+    }
+    return n;
+}
+
+/**
+ * @brief remove oldest records and commit header
+ *
+ * @param store
+ * @param n
+ */
+static void file_consume(sample_store_t *store, int n) {
+    store_consume(store, n);
+    file_write_hdr(store);
+}
+
+/**
+ * @brief set up RAM spill buffer backend
+ *
+ * @param store
+ * @param buf capacity samples
+ * @param capacity
+ */
+void sample_store_ram_init(sample_store_t *store, sensor_sample_t *buf, uint32_t capacity) {
+    memset(store, 0, sizeof(sample_store_t));
+    store->ops = &ram_ops;
+    store->ram = buf;
+    store->capacity = capacity;
+}
+
+/**
+ * @brief open log file backend, resume backlog if file matches capacity, else start empty
+ *
+ * @param store
+ * @param path file on a mounted filesystem
+ * @param capacity
+ * @return false if file cannot be opened or created
+ */
+bool sample_store_file_open(sample_store_t *store, const char *path, uint32_t capacity) {
+    sample_store_hdr_t hdr;
+
+    memset(store, 0, sizeof(sample_store_t));
+    store->ops = &file_ops;
+    store->capacity = capacity;
+    store->file = fopen(path, "r+b");
+    if (store->file) {
+        if (fread(&hdr, sizeof(hdr), 1, store->file) == 1 && hdr.magic == SAMPLE_STORE_MAGIC &&
+            hdr.capacity == capacity && hdr.head - hdr.tail <= capacity) {
+            store->head = hdr.head;
+            store->tail = hdr.tail;
+            store->drop_count = hdr.drop_count;
+            return true;
+        }
+    } else {
+        store->file = fopen(path, "w+b");
+        if (store->file == NULL) {
+            return false;
+        }
+    }
+    return file_write_hdr(store);
+}
+
+/**
+ * @brief close log file backend
+ *
+ * @param store
+ */
+void sample_store_file_close(sample_store_t *store) {
+    if (store->file) {
+        fclose(store->file);
+        store->file = NULL;
+    }
+}
+
+/**
+ * @brief number of stored samples
+ *
+ * @param store
+ * @return count
+ */
+uint32_t sample_store_count(const sample_store_t *store) {
+    return store->head - store->tail;
+}
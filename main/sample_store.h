@@ -0,0 +1,48 @@
+#ifndef _SAMPLE_STORE_H_
+#define _SAMPLE_STORE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sample_ring.h"
+
+/* DEFINES */
+#define SAMPLE_STORE_MAGIC  0x53424C33  /* "SBL3" */
+
+/* TYPE DEFINITIONS */
+typedef struct sample_store_t sample_store_t;
+
+/* storage backend, samples are kept oldest first and the oldest is dropped when full */
+typedef struct sample_store_ops_t {
+    bool (*append)(sample_store_t *store, const sensor_sample_t *sample);
+    int (*peek)(sample_store_t *store, sensor_sample_t *samples, int max);
+    void (*consume)(sample_store_t *store, int n);
+} sample_store_ops_t;
+
+struct sample_store_t {
+    const sample_store_ops_t *ops;
+    uint32_t capacity;      /* samples */
+    uint32_t head;          /* total appended */
+    uint32_t tail;          /* total consumed or dropped */
+    uint32_t drop_count;    /* overwritten while full */
+    sensor_sample_t *ram;   /* RAM backend buffer */
+    FILE *file;             /* file backend */
+};
+
+/* log file header, followed by capacity fixed-size records */
+typedef struct sample_store_hdr_t {
+    uint32_t magic;
+    uint32_t capacity;
+    uint32_t head;
+    uint32_t tail;
+    uint32_t drop_count;
+} sample_store_hdr_t;
+
+/* PUBLIC PROTOTYPES */
+void sample_store_ram_init(sample_store_t *store, sensor_sample_t *buf, uint32_t capacity);
+bool sample_store_file_open(sample_store_t *store, const char *path, uint32_t capacity);
+void sample_store_file_close(sample_store_t *store);
+uint32_t sample_store_count(const sample_store_t *store);
+
+#endif
@@ -0,0 +1,166 @@
+#include <string.h>
+
+#include "status_snap.h"
+
+/* STATIC PROTOTYPES */
+static void *field_ptr(const status_data_t *data, int field, int *size);
+
+/**
+ * @brief location and size of a field in status data
+ *
+ * @param data
+ * @param field STATUS_FIELD_x
+ * @param size out
+ * @return start of field
+ */
+static void *field_ptr(const status_data_t *data, int field, int *size) {
+    if (field == STATUS_FIELD_NET) {
+        *size = sizeof(status_net_t);
+        return (void *)&data->net;
+    }
+    if (field == STATUS_FIELD_METRICS) {
+        *size = sizeof(data->metrics);
+        return (void *)data->metrics;
+    }
+    *size = sizeof(status_sensor_t);
+    return (void *)&data->sensor[field - STATUS_FIELD_SENSOR];
+}
+
+/**
+ * @brief clear status, every field at version 0 until first written
+ *
+ * @param snap
+ */
+void status_snap_init(status_snap_t *snap) {
+    memset(snap, 0, sizeof(status_snap_t));
+}
+
+/**
+ * @brief open field for writing in place, readers skip it until status_snap_write_end
+ *
+ * @param snap
+ * @param field STATUS_FIELD_x
+ */
+void status_snap_write_begin(status_snap_t *snap, int field) {
+    uint32_t seq = __atomic_load_n(&snap->seq[field], __ATOMIC_RELAXED);
+    __atomic_store_n(&snap->seq[field], seq + 1, __ATOMIC_RELAXED);
+    /* odd seq is visible before any data store */
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/**
+ * @brief publish field as new version
+ *
+ * @param snap
+ * @param field STATUS_FIELD_x
+ */
+void status_snap_write_end(status_snap_t *snap, int field) {
+    uint32_t seq = __atomic_load_n(&snap->seq[field], __ATOMIC_RELAXED);
+    __atomic_store_n(&snap->seq[field], seq + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief set network status
+ *
+ * @param snap
+ * @param wifi
+ * @param mqtt
+ * @return true if changed, a new version was published
+ */
+bool status_snap_set_net(status_snap_t *snap, bool wifi, bool mqtt) {
+    if (snap->seq[STATUS_FIELD_NET] != 0 && snap->data.net.wifi == wifi && snap->data.net.mqtt == mqtt) {
+        return false;
+    }
+    status_snap_write_begin(snap, STATUS_FIELD_NET);
+    snap->data.net.wifi = wifi;
+    snap->data.net.mqtt = mqtt;
+    status_snap_write_end(snap, STATUS_FIELD_NET);
+    return true;
+}
+
+/**
+ * @brief set last sample of a sensor, first sample of a new device takes the next free entry
+ *
+ * @param snap
+ * @param sample
+ * @return true if changed, false if unchanged or no entry left
+ */
+bool status_snap_set_sensor(status_snap_t *snap, const sensor_sample_t *sample) {
+    int found = -1;
+    for (int idx = 0; idx < STATUS_SENSOR_MAX; idx++) {
+        const status_sensor_t *sensor = &snap->data.sensor[idx];
+        if (sensor->used && sensor->dev_id == sample->dev_id) {
+            found = idx;
+            break;
+        }
+        if (!sensor->used && found < 0) {
+            found = idx;
+        }
+    }
+    if (found < 0) {
+        snap->sensor_overflow++;
+        return false;
+    }
+    status_sensor_t *sensor = &snap->data.sensor[found];
+    if (sensor->used && sensor->ts_us == sample->ts_us && sensor->temp_centi == sample->temp_centi &&
+        sensor->humid_centi == sample->humid_centi && sensor->rssi == sample->rssi) {
+        return false;
+    }
+    int field = STATUS_FIELD_SENSOR + found;
+    status_snap_write_begin(snap, field);
+    sensor->used = true;
+    sensor->dev_id = sample->dev_id;
+    sensor->temp_centi = sample->temp_centi;
+    sensor->humid_centi = sample->humid_centi;
+    sensor->rssi = sample->rssi;
+    sensor->ts_us = sample->ts_us;
+    status_snap_write_end(snap, field);
+    return true;
+}
+
+/**
+ * @brief reader copy holding nothing yet
+ *
+ * @param view
+ */
+void status_view_init(status_view_t *view) {
+    memset(view, 0, sizeof(status_view_t));
+}
+
+/**
+ * @brief copy fields whose version differs from the reader's copy,
+ *        a field torn by a concurrent write keeps its last whole version until the next call
+ *
+ * @param snap
+ * @param view reader copy, fields set in view->changed were updated, every field holds a whole version
+ * @return number of fields updated in view
+ */
+int status_snap_read(const status_snap_t *snap, status_view_t *view) {
+    int changed = 0;
+    memset(view->changed, 0, sizeof(view->changed));
+    for (int field = 0; field < STATUS_FIELD_MAX; field++) {
+        int size;
+        const void *src = field_ptr(&snap->data, field, &size);
+        void *dst = field_ptr(&view->data, field, &size);
+        for (int tries = 0; tries < STATUS_READ_TRIES; tries++) {
+            uint32_t seq = __atomic_load_n(&snap->seq[field], __ATOMIC_ACQUIRE);
+            if (seq == view->seen[field] || (seq & 1)) {
+                /* unchanged, or writer inside: keep last copy */
+                break;
+            }
+            memcpy(&view->scratch, src, size);
+            /* data loads complete before seq is checked again */
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&snap->seq[field], __ATOMIC_RELAXED) == seq) {
+                memcpy(dst, &view->scratch, size);
+                view->seen[field] = seq;
+                view->changed[field / 32] |= 1u << (field % 32);
+                changed++;
+                break;
+            }
+            /* torn, view still holds the last whole version */
+            view->retry_count++;
+        }
+    }
+    return changed;
+}
@@ -0,0 +1,77 @@
+#ifndef _STATUS_SNAP_H_
+#define _STATUS_SNAP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sys_metrics.h"
+#include "ble_link.h"
+#include "sample_ring.h"
+
+/* DEFINES */
+#define STATUS_SENSOR_MAX   64      /* sensors shown, later ones are counted in sensor_overflow */
+#define STATUS_TEXT_LEN     (SYS_METRICS_TEXT_LEN + BLE_LINK_TEXT_LEN + 1)
+#define STATUS_READ_TRIES   3       /* copies of a field per read before leaving it to the next read */
+#define STATUS_FIELD_WORDS  ((STATUS_FIELD_MAX + 31) / 32)
+#define STATUS_VIEW_CHANGED(view, field)    ((((view)->changed[(field) / 32]) >> ((field) % 32)) & 1u)
+
+/* TYPE DEFINITIONS */
+/* independently versioned parts of the status */
+typedef enum {
+    STATUS_FIELD_NET = 0,
+    STATUS_FIELD_METRICS,
+    STATUS_FIELD_SENSOR,    /* first of STATUS_SENSOR_MAX, one per sensor */
+    STATUS_FIELD_MAX = STATUS_FIELD_SENSOR + STATUS_SENSOR_MAX,
+} status_field_t;
+
+typedef struct status_net_t {
+    bool wifi;
+    bool mqtt;
+} status_net_t;
+
+/* last sample of a sensor */
+typedef struct status_sensor_t {
+    bool used;
+    uint16_t dev_id;
+    int16_t temp_centi;     /* 0.01 degC */
+    uint16_t humid_centi;   /* 0.01 %RH */
+    int8_t rssi;            /* dBm, 0 if unknown */
+    int64_t ts_us;          /* received, for the age of the reading */
+} status_sensor_t;
+
+typedef struct status_data_t {
+    status_net_t net;
+    char metrics[STATUS_TEXT_LEN];  /* debug page text, see sys_metrics_text and ble_link_text */
+    status_sensor_t sensor[STATUS_SENSOR_MAX];
+} status_data_t;
+
+/* published status, one writer task, any number of readers, no lock on either side */
+typedef struct status_snap_t {
+    uint32_t seq[STATUS_FIELD_MAX]; /* per-field seqlock: odd while written, even value is the version */
+    status_data_t data;
+    uint32_t sensor_overflow;       /* samples of sensors beyond STATUS_SENSOR_MAX */
+} status_snap_t;
+
+/* reader's private copy, the second buffer */
+typedef struct status_view_t {
+    uint32_t seen[STATUS_FIELD_MAX];    /* version held in data, 0: never read */
+    uint32_t changed[STATUS_FIELD_WORDS];   /* fields updated by last read, see STATUS_VIEW_CHANGED */
+    status_data_t data;                 /* whole versions only */
+    union {                             /* copy of one field until it is known consistent */
+        status_net_t net;
+        char metrics[STATUS_TEXT_LEN];
+        status_sensor_t sensor;
+    } scratch;
+    uint32_t retry_count;               /* copies torn by a concurrent write */
+} status_view_t;
+
+/* PUBLIC PROTOTYPES */
+void status_snap_init(status_snap_t *snap);
+void status_snap_write_begin(status_snap_t *snap, int field);
+void status_snap_write_end(status_snap_t *snap, int field);
+bool status_snap_set_net(status_snap_t *snap, bool wifi, bool mqtt);
+bool status_snap_set_sensor(status_snap_t *snap, const sensor_sample_t *sample);
+void status_view_init(status_view_t *view);
+int status_snap_read(const status_snap_t *snap, status_view_t *view);
+
+#endif
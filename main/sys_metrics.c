@@ -0,0 +1,409 @@
+#include <string.h>
+
+#include "sys_metrics.h"
+#include "fmt_fixed.h"
+
+/* DEFINES */
+#define IDLE_TASK_PREFIX    "IDLE"  /* IDLE0/IDLE1 on ESP-IDF, IDLE on vanilla FreeRTOS */
+
+/* STATIC PROTOTYPES */
+static void name_copy(char *dst, const char *src);
+static sys_metrics_task_t *task_find_id(sys_metrics_t *metrics, uint32_t id);
+static int fmt_pad(char *buf, int len, int width);
+static int fmt_permille(char *buf, uint16_t permille);
+static uint16_t power_off_permille(const sys_power_stat_t *power);
+
+/**
+ * @brief copy name truncated to SYS_METRICS_NAME_LEN, characters that need JSON escaping are replaced
+ *
+ * @param dst
+ * @param src
+ */
+static void name_copy(char *dst, const char *src) {
+    int len = 0;
+    while (src && src[len] != '\0' && len < SYS_METRICS_NAME_LEN - 1) {
+        char c = src[len];
+        dst[len++] = (c < ' ' || c == '"' || c == '\\') ? '_' : c;
+    }
+    dst[len] = '\0';
+}
+
+/**
+ * @brief find tracked task by task number
+ *
+ * @param metrics
+ * @param id
+ * @return entry or NULL
+ */
+static sys_metrics_task_t *task_find_id(sys_metrics_t *metrics, uint32_t id) {
+    for (int idx = 0; idx < metrics->task_num; idx++) {
+        if (metrics->task[idx].id == id) {
+            return &metrics->task[idx];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief pad text with spaces up to column
+ *
+ * @param buf start of column
+ * @param len chars already written from buf
+ * @param width column width
+ * @return chars written from buf
+ */
+static int fmt_pad(char *buf, int len, int width) {
+    while (len < width) {
+        buf[len++] = ' ';
+    }
+    return len;
+}
+
+/**
+ * @brief format 0..1000 permille as percent with one decimal
+ *
+ * @param buf
+ * @param permille
+ * @return length
+ */
+static int fmt_permille(char *buf, uint16_t permille) {
+    return fmt_centi(buf, (int32_t)permille * 10, 1);
+}
+
+/**
+ * @brief share of time with the display off
+ *
+ * @param power
+ * @return 0..1000
+ */
+static uint16_t power_off_permille(const sys_power_stat_t *power) {
+    uint64_t total = (uint64_t)power->on_s + power->off_s;
+    return total ? (uint16_t)((power->off_s * 1000ULL + total / 2) / total) : 0;
+}
+
+/**
+ * @brief clear all metrics
+ *
+ * @param metrics
+ * @param cores number of CPUs sharing the run-time counter period
+ */
+void sys_metrics_init(sys_metrics_t *metrics, int cores) {
+    memset(metrics, 0, sizeof(sys_metrics_t));
+    metrics->cores = (uint8_t)((cores > 0) ? cores : 1);
+}
+
+/**
+ * @brief register a bounded queue whose depth is reported
+ *
+ * @param metrics
+ * @param name
+ * @param capacity
+ * @return queue index or -1 if table is full
+ */
+int sys_metrics_queue_add(sys_metrics_t *metrics, const char *name, uint32_t capacity) {
+    if (metrics->queue_num >= SYS_METRICS_QUEUE_MAX) {
+        return -1;
+    }
+    sys_metrics_queue_t *queue = &metrics->queue[metrics->queue_num];
+    name_copy(queue->name, name);
+    queue->capacity = capacity;
+    queue->depth = 0;
+    queue->depth_max = 0;
+    return metrics->queue_num++;
+}
+
+/**
+ * @brief record current depth of a queue, cheap enough to call on every drain
+ *
+ * @param metrics
+ * @param idx returned by sys_metrics_queue_add
+ * @param depth
+ */
+void sys_metrics_queue_set(sys_metrics_t *metrics, int idx, uint32_t depth) {
+    if (idx < 0 || idx >= metrics->queue_num) {
+        return;
+    }
+    sys_metrics_queue_t *queue = &metrics->queue[idx];
+    queue->depth = depth;
+    if (depth > queue->depth_max) {
+        queue->depth_max = depth;
+    }
+}
+
+/**
+ * @brief display power state, sampled by its owner
+ *
+ * @param metrics
+ * @param power
+ */
+void sys_metrics_power_set(sys_metrics_t *metrics, const sys_power_stat_t *power) {
+    metrics->power = *power;
+    metrics->have_power = true;
+}
+
+/**
+ * @brief take one sample of task and heap state, CPU share is the run-time delta since the previous sample
+ *
+ * @param metrics
+ * @param tasks all tasks alive now, tasks missing from the list are dropped
+ * @param task_num
+ * @param total_runtime run-time counter of the same snapshot, 0 if run-time stats are disabled
+ * @param heap
+ * @param now_us
+ * @return number of tasks with less than SYS_METRICS_STACK_WARN bytes of stack left
+ */
+int sys_metrics_update(sys_metrics_t *metrics, const sys_task_stat_t *tasks, int task_num, uint32_t total_runtime,
+                       const sys_heap_stat_t *heap, int64_t now_us) {
+    /* counters wrap, unsigned difference stays correct over one wrap */
+    uint32_t period = total_runtime - metrics->total_runtime;
+    bool have_cpu = (metrics->update_count > 0) && (period > 0);
+    uint64_t scale = (uint64_t)period * metrics->cores;
+    uint32_t alive = 0;     /* bit per task entry seen in this snapshot */
+    int low_stack = 0;
+
+    for (int idx = 0; idx < task_num; idx++) {
+        const sys_task_stat_t *stat = &tasks[idx];
+        sys_metrics_task_t *task = task_find_id(metrics, stat->id);
+        uint32_t delta = stat->runtime;
+        if (task) {
+            delta = stat->runtime - task->runtime;
+        } else if (metrics->task_num < SYS_METRICS_TASK_MAX) {
+            /* new task, its counter started from 0 during the period */
+            task = &metrics->task[metrics->task_num++];
+            memset(task, 0, sizeof(sys_metrics_task_t));
+            task->id = stat->id;
+        } else {
+            metrics->task_overflow++;
+            continue;
+        }
+        name_copy(task->name, stat->name);
+        task->runtime = stat->runtime;
+        task->stack_free = stat->stack_free;
+        task->core = stat->core;
+        task->priority = stat->priority;
+        task->cpu_permille = 0;
+        if (have_cpu) {
+            uint64_t permille = ((uint64_t)delta * 1000 + scale / 2) / scale;
+            task->cpu_permille = (uint16_t)((permille > 1000) ? 1000 : permille);
+        }
+        if (task->cpu_permille > task->cpu_peak) {
+            task->cpu_peak = task->cpu_permille;
+        }
+        if (stat->stack_free < SYS_METRICS_STACK_WARN) {
+            low_stack++;
+        }
+        alive |= 1u << (task - metrics->task);
+    }
+    /* drop deleted tasks, keep order of the rest */
+    int keep = 0;
+    for (int idx = 0; idx < metrics->task_num; idx++) {
+        if (alive & (1u << idx)) {
+            metrics->task[keep++] = metrics->task[idx];
+        }
+    }
+    metrics->task_num = (uint8_t)keep;
+
+    metrics->have_cpu = have_cpu;
+    metrics->total_runtime = total_runtime;
+    metrics->uptime_us = now_us;
+    if (heap) {
+        metrics->heap = *heap;
+    }
+    metrics->update_count++;
+    return low_stack;
+}
+
+/**
+ * @brief find tracked task by name
+ *
+ * @param metrics
+ * @param name
+ * @return entry or NULL
+ */
+const sys_metrics_task_t *sys_metrics_task_find(const sys_metrics_t *metrics, const char *name) {
+    for (int idx = 0; idx < metrics->task_num; idx++) {
+        if (strncmp(metrics->task[idx].name, name, SYS_METRICS_NAME_LEN) == 0) {
+            return &metrics->task[idx];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief CPU load over all cores during last period, time not spent in idle tasks
+ *
+ * @param metrics
+ * @return permille, 0 if unknown
+ */
+uint16_t sys_metrics_load(const sys_metrics_t *metrics) {
+    uint32_t idle = 0;
+    uint32_t busy = 0;
+    bool have_idle = false;
+    if (!metrics->have_cpu) {
+        return 0;
+    }
+    for (int idx = 0; idx < metrics->task_num; idx++) {
+        const sys_metrics_task_t *task = &metrics->task[idx];
+        if (strncmp(task->name, IDLE_TASK_PREFIX, sizeof(IDLE_TASK_PREFIX) - 1) == 0) {
+            idle += task->cpu_permille;
+            have_idle = true;
+        } else {
+            busy += task->cpu_permille;
+        }
+    }
+    if (have_idle) {
+        return (uint16_t)((idle >= 1000) ? 0 : 1000 - idle);
+    }
+    return (uint16_t)((busy >= 1000) ? 1000 : busy);
+}
+
+/**
+ * @brief encode metrics as JSON, no stdio
+ *        {"up":12,"load":7.5,"heap":{...},"queue":{"ring":[depth,max,capacity],...},"task":[{...},...]}
+ *
+ * @param metrics
+ * @param buf
+ * @param size at least SYS_METRICS_JSON_LEN + 1
+ * @return length without terminator, 0 if buf is too small
+ */
+int sys_metrics_json(const sys_metrics_t *metrics, char *buf, int size) {
+    if (size <= SYS_METRICS_JSON_LEN) {
+        return 0;
+    }
+    int len = fmt_str(buf, "{\"up\":");
+    len += fmt_u32(&buf[len], (uint32_t)(metrics->uptime_us / 1000000));
+    if (metrics->have_cpu) {
+        len += fmt_str(&buf[len], ",\"load\":");
+        len += fmt_permille(&buf[len], sys_metrics_load(metrics));
+    }
+    len += fmt_str(&buf[len], ",\"heap\":{\"free\":");
+    len += fmt_u32(&buf[len], metrics->heap.free);
+    len += fmt_str(&buf[len], ",\"min\":");
+    len += fmt_u32(&buf[len], metrics->heap.min_free);
+    len += fmt_str(&buf[len], ",\"dma\":");
+    len += fmt_u32(&buf[len], metrics->heap.dma_free);
+    len += fmt_str(&buf[len], ",\"dma_min\":");
+    len += fmt_u32(&buf[len], metrics->heap.dma_min_free);
+    len += fmt_str(&buf[len], ",\"dma_blk\":");
+    len += fmt_u32(&buf[len], metrics->heap.dma_largest);
+    if (metrics->have_power) {
+        len += fmt_str(&buf[len], "},\"power\":{\"off\":");
+        len += fmt_permille(&buf[len], power_off_permille(&metrics->power));
+        len += fmt_str(&buf[len], ",\"off_s\":");
+        len += fmt_u32(&buf[len], metrics->power.off_s);
+        len += fmt_str(&buf[len], ",\"off_n\":");
+        len += fmt_u32(&buf[len], metrics->power.off_count);
+    }
+    len += fmt_str(&buf[len], "},\"queue\":{");
+    for (int idx = 0; idx < metrics->queue_num; idx++) {
+        const sys_metrics_queue_t *queue = &metrics->queue[idx];
+        len += fmt_str(&buf[len], (idx > 0) ? ",\"" : "\"");
+        len += fmt_str(&buf[len], queue->name);
+        len += fmt_str(&buf[len], "\":[");
+        len += fmt_u32(&buf[len], queue->depth);
+        buf[len++] = ',';
+        len += fmt_u32(&buf[len], queue->depth_max);
+        buf[len++] = ',';
+        len += fmt_u32(&buf[len], queue->capacity);
+        buf[len++] = ']';
+    }
+    len += fmt_str(&buf[len], "},\"task\":[");
+    for (int idx = 0; idx < metrics->task_num; idx++) {
+        const sys_metrics_task_t *task = &metrics->task[idx];
+        len += fmt_str(&buf[len], (idx > 0) ? ",{\"name\":\"" : "{\"name\":\"");
+        len += fmt_str(&buf[len], task->name);
+        len += fmt_str(&buf[len], "\",\"core\":");
+        len += fmt_i32(&buf[len], task->core);
+        len += fmt_str(&buf[len], ",\"prio\":");
+        len += fmt_u32(&buf[len], task->priority);
+        if (metrics->have_cpu) {
+            len += fmt_str(&buf[len], ",\"cpu\":");
+            len += fmt_permille(&buf[len], task->cpu_permille);
+            len += fmt_str(&buf[len], ",\"peak\":");
+            len += fmt_permille(&buf[len], task->cpu_peak);
+        }
+        len += fmt_str(&buf[len], ",\"stack\":");
+        len += fmt_u32(&buf[len], task->stack_free);
+        buf[len++] = '}';
+    }
+    len += fmt_str(&buf[len], "]}");
+    buf[len] = '\0';
+    return len;
+}
+
+/**
+ * @brief format metrics as text for the debug screen, one line per queue and task
+ *
+ * @param metrics
+ * @param buf
+ * @param size at least SYS_METRICS_TEXT_LEN + 1
+ * @return length without terminator, 0 if buf is too small
+ */
+int sys_metrics_text(const sys_metrics_t *metrics, char *buf, int size) {
+    if (size <= SYS_METRICS_TEXT_LEN) {
+        return 0;
+    }
+    int len = fmt_str(buf, "Up ");
+    len += fmt_u32(&buf[len], (uint32_t)(metrics->uptime_us / 1000000));
+    len += fmt_str(&buf[len], " s, CPU load ");
+    if (metrics->have_cpu) {
+        len += fmt_permille(&buf[len], sys_metrics_load(metrics));
+        len += fmt_str(&buf[len], " %\n");
+    } else {
+        len += fmt_str(&buf[len], "n/a\n");
+    }
+    len += fmt_str(&buf[len], "Heap ");
+    len += fmt_u32(&buf[len], metrics->heap.free);
+    len += fmt_str(&buf[len], " B, min ");
+    len += fmt_u32(&buf[len], metrics->heap.min_free);
+    len += fmt_str(&buf[len], " B\nDMA ");
+    len += fmt_u32(&buf[len], metrics->heap.dma_free);
+    len += fmt_str(&buf[len], " B, min ");
+    len += fmt_u32(&buf[len], metrics->heap.dma_min_free);
+    len += fmt_str(&buf[len], " B, block ");
+    len += fmt_u32(&buf[len], metrics->heap.dma_largest);
+    len += fmt_str(&buf[len], " B\n");
+    if (metrics->have_power) {
+        len += fmt_str(&buf[len], "Display off ");
+        len += fmt_permille(&buf[len], power_off_permille(&metrics->power));
+        len += fmt_str(&buf[len], " %, ");
+        len += fmt_u32(&buf[len], metrics->power.off_s);
+        len += fmt_str(&buf[len], " s in ");
+        len += fmt_u32(&buf[len], metrics->power.off_count);
+        len += fmt_str(&buf[len], " times\n");
+    }
+    for (int idx = 0; idx < metrics->queue_num; idx++) {
+        const sys_metrics_queue_t *queue = &metrics->queue[idx];
+        int col = len;
+        len += fmt_str(&buf[len], queue->name);
+        len = col + fmt_pad(&buf[col], len - col, SYS_METRICS_NAME_LEN);
+        len += fmt_u32(&buf[len], queue->depth);
+        buf[len++] = '/';
+        len += fmt_u32(&buf[len], queue->capacity);
+        len += fmt_str(&buf[len], " max ");
+        len += fmt_u32(&buf[len], queue->depth_max);
+        buf[len++] = '\n';
+    }
+    for (int idx = 0; idx < metrics->task_num; idx++) {
+        const sys_metrics_task_t *task = &metrics->task[idx];
+        int col = len;
+        len += fmt_str(&buf[len], task->name);
+        len = col + fmt_pad(&buf[col], len - col, SYS_METRICS_NAME_LEN);
+        if (task->core >= 0) {
+            buf[len++] = 'c';
+            len += fmt_u32(&buf[len], (uint32_t)task->core);
+            buf[len++] = ' ';
+        }
+        buf[len++] = 'p';
+        len += fmt_u32(&buf[len], task->priority);
+        buf[len++] = ' ';
+        if (metrics->have_cpu) {
+            len += fmt_permille(&buf[len], task->cpu_permille);
+            len += fmt_str(&buf[len], "% ");
+        }
+        len += fmt_u32(&buf[len], task->stack_free);
+        len += fmt_str(&buf[len], (task->stack_free < SYS_METRICS_STACK_WARN) ? " B stack LOW\n" : " B stack\n");
+    }
+    buf[len] = '\0';
+    return len;
+}
@@ -0,0 +1,92 @@
+#ifndef _SYS_METRICS_H_
+#define _SYS_METRICS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* DEFINES */
+#define SYS_METRICS_TASK_MAX    24      /* <= 32, ESP-IDF runs ~15 tasks with WiFi, BT and MQTT */
+#define SYS_METRICS_QUEUE_MAX   4
+#define SYS_METRICS_NAME_LEN    16      /* configMAX_TASK_NAME_LEN */
+#define SYS_METRICS_STACK_WARN  512     /* bytes left, below this a task is reported as low on stack */
+#define SYS_METRICS_TASK_JSON   96      /* worst-case JSON per task */
+#define SYS_METRICS_QUEUE_JSON  (SYS_METRICS_NAME_LEN + 40)
+#define SYS_METRICS_POWER_JSON  64
+#define SYS_METRICS_JSON_LEN    (192 + SYS_METRICS_POWER_JSON + SYS_METRICS_QUEUE_MAX * SYS_METRICS_QUEUE_JSON + SYS_METRICS_TASK_MAX * SYS_METRICS_TASK_JSON)
+#define SYS_METRICS_TEXT_LEN    (216 + SYS_METRICS_QUEUE_MAX * 56 + SYS_METRICS_TASK_MAX * 64)
+
+/* TYPE DEFINITIONS */
+/* one task as reported by the RTOS, e.g. from uxTaskGetSystemState */
+typedef struct sys_task_stat_t {
+    const char *name;
+    uint32_t id;            /* task number, unique for the lifetime of the task */
+    uint32_t runtime;       /* run-time counter, may wrap */
+    uint32_t stack_free;    /* stack high water mark, bytes never used */
+    int8_t core;            /* affinity, -1 if not pinned */
+    uint8_t priority;
+} sys_task_stat_t;
+
+/* heap state, min values are the all-time low water marks kept by the allocator */
+typedef struct sys_heap_stat_t {
+    uint32_t free;
+    uint32_t min_free;
+    uint32_t dma_free;      /* MALLOC_CAP_DMA pool, display buffer */
+    uint32_t dma_min_free;
+    uint32_t dma_largest;   /* largest free DMA block */
+} sys_heap_stat_t;
+
+/* display power since boot, reported by the power manager of the GUI */
+typedef struct sys_power_stat_t {
+    uint32_t on_s;
+    uint32_t off_s;         /* display off, light sleep allowed */
+    uint32_t off_count;     /* display turned off */
+} sys_power_stat_t;
+
+typedef struct sys_metrics_task_t {
+    char name[SYS_METRICS_NAME_LEN];
+    uint32_t id;
+    uint32_t runtime;       /* counter at last update */
+    uint32_t stack_free;
+    uint16_t cpu_permille;  /* share of all cores during last period */
+    uint16_t cpu_peak;      /* highest cpu_permille seen */
+    int8_t core;
+    uint8_t priority;
+} sys_metrics_task_t;
+
+/* depth of a bounded queue, sampled by its owner */
+typedef struct sys_metrics_queue_t {
+    char name[SYS_METRICS_NAME_LEN];
+    uint32_t capacity;
+    uint32_t depth;
+    uint32_t depth_max;     /* high water mark */
+} sys_metrics_queue_t;
+
+typedef struct sys_metrics_t {
+    uint8_t cores;
+    uint8_t task_num;
+    uint8_t queue_num;
+    bool have_cpu;          /* cpu_permille valid, needs two updates with a running counter */
+    bool have_power;        /* power set at least once */
+    uint32_t total_runtime; /* counter at last update */
+    uint32_t update_count;
+    uint32_t task_overflow; /* tasks not tracked because the table was full */
+    int64_t uptime_us;
+    sys_heap_stat_t heap;
+    sys_power_stat_t power;
+    sys_metrics_task_t task[SYS_METRICS_TASK_MAX];
+    sys_metrics_queue_t queue[SYS_METRICS_QUEUE_MAX];
+} sys_metrics_t;
+
+/* PUBLIC PROTOTYPES */
+void sys_metrics_init(sys_metrics_t *metrics, int cores);
+int sys_metrics_queue_add(sys_metrics_t *metrics, const char *name, uint32_t capacity);
+void sys_metrics_queue_set(sys_metrics_t *metrics, int idx, uint32_t depth);
+void sys_metrics_power_set(sys_metrics_t *metrics, const sys_power_stat_t *power);
+int sys_metrics_update(sys_metrics_t *metrics, const sys_task_stat_t *tasks, int task_num, uint32_t total_runtime,
+                       const sys_heap_stat_t *heap, int64_t now_us);
+const sys_metrics_task_t *sys_metrics_task_find(const sys_metrics_t *metrics, const char *name);
+uint16_t sys_metrics_load(const sys_metrics_t *metrics);
+int sys_metrics_json(const sys_metrics_t *metrics, char *buf, int size);
+int sys_metrics_text(const sys_metrics_t *metrics, char *buf, int size);
+
+#endif
@@ -8,6 +8,8 @@
 
 #include "mqtt_client.h"
 
+#include "remote_cfg.h"
+
 /* DEFINES */
 #define TAG            "WIFI_MQTT"
 
@@ -16,10 +18,22 @@
 #define WIFI_MAXIMUM_RETRY  10
 #define MQTT_BROKER    "mqtt://broker.hivemq.com"
 #define MQTT_TOPIC     "your_topic/sensor"
+#define MQTT_ACK_QUEUE_LEN  16  /* PUBACKs waiting for main loop, an overflow shows up as ack timeout */
+#define MQTT_CONFIG_TOPIC   MQTT_TOPIC "/config"   /* remote_cfg commands, state published to MQTT_CONFIG_TOPIC/state, refusals to /error */
+#define MQTT_CONFIG_QUEUE_LEN   2
+
+/* TYPE DEFINITIONS */
+/* command received on MQTT_CONFIG_TOPIC, copied for main loop */
+typedef struct config_msg_t {
+    int len;
+    char data[REMOTE_CFG_MSG_MAX];
+} config_msg_t;
 
 /* STATIC VARIABLES */
 static int retry_num = 0;
 static esp_mqtt_client_handle_t mqtt_client;
+static QueueHandle_t ack_queue;
+static QueueHandle_t config_queue;
 
 /* STATIC PROTOTYPES */
 static void esp_wifi_cb(void* args, esp_event_base_t event_base, int32_t event_id, void* event_data);
@@ -38,17 +52,23 @@ static void esp_wifi_cb(void* args, esp_event_base_t event_base, int32_t event_i
     if ((event_base == WIFI_EVENT) && (event_id == WIFI_EVENT_STA_START)) {
         esp_wifi_connect();
     } else if ((event_base == WIFI_EVENT) && (event_id == WIFI_EVENT_STA_DISCONNECTED)) {
+        if (xEventGroupClearBits(net_evt_group, WIFI_CONNECTED_BIT) & WIFI_CONNECTED_BIT) {
+            main_notify(MAIN_NOTIFY_NET);
+        }
         if (retry_num < WIFI_MAXIMUM_RETRY) {
             esp_wifi_connect();
             retry_num++;
             ESP_LOGI(TAG, "retry to connect to the AP");
         } else {
             xEventGroupSetBits(net_evt_group, WIFI_FAIL_BIT);
+            main_notify(MAIN_NOTIFY_NET);
             ESP_LOGI(TAG, "Failed to connect to SSID:%s, password:%s", WIFI_SSID, WIFI_PASS);
         }
         ESP_LOGI(TAG,"connect to the AP fail");
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+        xEventGroupClearBits(net_evt_group, WIFI_FAIL_BIT);
         xEventGroupSetBits(net_evt_group, WIFI_CONNECTED_BIT);
+        main_notify(MAIN_NOTIFY_NET);
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
         ESP_LOGI(TAG, "connected to ap SSID:%s password:%s", WIFI_SSID, WIFI_PASS);
         ESP_LOGI(TAG, "got ip:" IPSTR, IP2STR(&event->ip_info.ip));
@@ -115,9 +135,14 @@ static void esp_mqtt_cb(void *args, esp_event_base_t event_base, int32_t event_i
     case MQTT_EVENT_CONNECTED:
         ESP_LOGI(TAG, "MQTT_EVENT_CONNECTED");
         xEventGroupSetBits(net_evt_group, MQTT_CONNECTED_BIT);
+        main_notify(MAIN_NOTIFY_NET);
+        msg_id = esp_mqtt_client_subscribe(client, MQTT_CONFIG_TOPIC, 1);
+        ESP_LOGI(TAG, "subscribe %s, msg_id=%d", MQTT_CONFIG_TOPIC, msg_id);
         break;
     case MQTT_EVENT_DISCONNECTED:
         ESP_LOGI(TAG, "MQTT_EVENT_DISCONNECTED");
+        xEventGroupClearBits(net_evt_group, MQTT_CONNECTED_BIT);
+        main_notify(MAIN_NOTIFY_NET);
         break;
     case MQTT_EVENT_SUBSCRIBED:
         ESP_LOGI(TAG, "MQTT_EVENT_SUBSCRIBED, msg_id=%d", event->msg_id);
@@ -126,10 +151,24 @@ static void esp_mqtt_cb(void *args, esp_event_base_t event_base, int32_t event_i
         ESP_LOGI(TAG, "MQTT_EVENT_UNSUBSCRIBED, msg_id=%d", event->msg_id);
         break;
     case MQTT_EVENT_PUBLISHED:
-        ESP_LOGI(TAG, "MQTT_EVENT_PUBLISHED, msg_id=%d", event->msg_id);
+        ESP_LOGD(TAG, "MQTT_EVENT_PUBLISHED, msg_id=%d", event->msg_id);
+        xQueueSend(ack_queue, &event->msg_id, 0);
+        main_notify(MAIN_NOTIFY_ACK);
         break;
     case MQTT_EVENT_DATA:
         ESP_LOGI(TAG, "MQTT_EVENT_DATA");
+        if (event->topic_len != sizeof(MQTT_CONFIG_TOPIC) - 1 || memcmp(event->topic, MQTT_CONFIG_TOPIC, event->topic_len) != 0) {
+            break;
+        }
+        /* commands fit one event, fragments of a longer message are refused */
+        if (event->data_len != event->total_data_len || event->data_len > REMOTE_CFG_MSG_MAX) {
+            ESP_LOGW(TAG, "config command of %d bytes refused", event->total_data_len);
+            break;
+        }
+        config_msg_t msg = {.len = event->data_len};
+        memcpy(msg.data, event->data, event->data_len);
+        xQueueSend(config_queue, &msg, 0);
+        main_notify(MAIN_NOTIFY_CONFIG);
         break;
     case MQTT_EVENT_ERROR:
         ESP_LOGI(TAG, "MQTT_EVENT_ERROR");
@@ -145,6 +184,10 @@ static void esp_mqtt_cb(void *args, esp_event_base_t event_base, int32_t event_i
  * 
  */
 static void mqtt_init(void) {
+    if (ack_queue == NULL) {
+        ack_queue = xQueueCreate(MQTT_ACK_QUEUE_LEN, sizeof(int));
+        config_queue = xQueueCreate(MQTT_CONFIG_QUEUE_LEN, sizeof(config_msg_t));
+    }
     esp_mqtt_client_config_t mqtt_cfg = {
         .uri = MQTT_BROKER,
         .port = 1883,
@@ -155,13 +198,95 @@ static void mqtt_init(void) {
 }
 
 /**
- * @brief publish JSON data to broker
+ * @brief publish encoded batch to broker
+ * 
+ * @param dev_id publish to MQTT_TOPIC/<dev_id>, or MQTT_TOPIC if negative
+ * @param data JSON or binary payload
+ * @param len 
+ * @param qos 0 or 1, PUBACK of QoS 1 is handed over by mqtt_take_ack
+ * @return msg_id, 0 for QoS 0, -1 if not sent
+ */
+int mqtt_publish_data(int dev_id, const uint8_t *data, int len, int qos) {
+    char topic[sizeof(MQTT_TOPIC) + 12];    /* "/" + int */
+    if (dev_id < 0) {
+        return esp_mqtt_client_publish(mqtt_client, MQTT_TOPIC, (const char *)data, len, qos, 0);
+    }
+    snprintf(topic, sizeof(topic), MQTT_TOPIC "/%d", dev_id);
+    return esp_mqtt_client_publish(mqtt_client, topic, (const char *)data, len, qos, 0);
+}
+
+/**
+ * @brief next PUBACK received, main loop is woken by MAIN_NOTIFY_ACK
+ * 
+ * @param msg_id [out]
+ * @return true if one was pending
+ */
+bool mqtt_take_ack(int *msg_id) {
+    return ack_queue != NULL && xQueueReceive(ack_queue, msg_id, 0) == pdTRUE;
+}
+
+/**
+ * @brief next configuration command received, main loop is woken by MAIN_NOTIFY_CONFIG
+ * 
+ * @param buf [out] command, not terminated
+ * @param size at least REMOTE_CFG_MSG_MAX
+ * @return length, -1 if none pending
+ */
+int mqtt_take_config(char *buf, int size) {
+    config_msg_t msg;
+    if (config_queue == NULL || size < REMOTE_CFG_MSG_MAX || xQueueReceive(config_queue, &msg, 0) != pdTRUE) {
+        return -1;
+    }
+    memcpy(buf, msg.data, msg.len);
+    return msg.len;
+}
+
+/**
+ * @brief publish configuration in force, retained for fleet tools
+ * 
+ * @param data text
+ * @param len 
+ */
+void mqtt_publish_config(const char *data, int len) {
+    esp_mqtt_client_publish(mqtt_client, MQTT_CONFIG_TOPIC "/state", data, len, 0, 1);
+}
+
+/**
+ * @brief publish refusal of a command, not retained so the state topic keeps the settings in force
+ * 
+ * @param data text
+ * @param len 
+ */
+void mqtt_publish_config_error(const char *data, int len) {
+    esp_mqtt_client_publish(mqtt_client, MQTT_CONFIG_TOPIC "/error", data, len, 0, 0);
+}
+
+/**
+ * @brief publish task/heap metrics to MQTT_TOPIC/metrics
+ * 
+ * @param data JSON
+ * @param len 
+ */
+void mqtt_publish_metrics(const char *data, int len) {
+    esp_mqtt_client_publish(mqtt_client, MQTT_TOPIC "/metrics", data, len, 0, 0);
+}
+
+/**
+ * @brief publish link quality of BLE devices to MQTT_TOPIC/links
+ * 
+ * @param data JSON
+ * @param len 
+ */
+void mqtt_publish_links(const char *data, int len) {
+    esp_mqtt_client_publish(mqtt_client, MQTT_TOPIC "/links", data, len, 0, 0);
+}
+
+/**
+ * @brief publish a piece of a pipeline trace capture to MQTT_TOPIC/trace
  * 
- * @param temp_val 
- * @param humid_val 
+ * @param data Chrome trace JSON, pieces concatenated in order
+ * @param len 
  */
-void mqtt_publish_val(float temp_val, uint8_t humid_val) {
-    char buf[50];
-    sprintf(buf, "{\"temp\":%.1f, \"humid\":%d}", temp_val, humid_val);
-    esp_mqtt_client_publish(mqtt_client, MQTT_TOPIC, buf, strlen(buf), 0, 0);
+void mqtt_publish_trace(const char *data, int len) {
+    esp_mqtt_client_publish(mqtt_client, MQTT_TOPIC "/trace", data, len, 0, 0);
 }
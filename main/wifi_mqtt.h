@@ -5,6 +5,13 @@
  *  PUBLIC PROTOTYPES
  **********************/
 void wifi_init_sta(void);
-void mqtt_publish_val(float temp_val, uint8_t humid_val);
+int mqtt_publish_data(int dev_id, const uint8_t *data, int len, int qos);
+bool mqtt_take_ack(int *msg_id);
+int mqtt_take_config(char *buf, int size);
+void mqtt_publish_config(const char *data, int len);
+void mqtt_publish_config_error(const char *data, int len);
+void mqtt_publish_metrics(const char *data, int len);
+void mqtt_publish_links(const char *data, int len);
+void mqtt_publish_trace(const char *data, int len);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,6 @@
+#ifndef _SHIM_DRIVER_GPIO_H_
+#define _SHIM_DRIVER_GPIO_H_
+
+/* host stand-in: GPIO is not used by main/ */
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef _SHIM_ESP_BT_H_
+#define _SHIM_ESP_BT_H_
+
+#include "esp_err.h"
+#include "esp_bt_defs.h"
+
+/* host stand-in: controller bring-up always succeeds */
+typedef enum {
+    ESP_BT_MODE_IDLE = 0x00,
+    ESP_BT_MODE_BLE = 0x01,
+    ESP_BT_MODE_CLASSIC_BT = 0x02,
+    ESP_BT_MODE_BTDM = 0x03,
+} esp_bt_mode_t;
+
+typedef struct {
+    uint8_t mode;
+} esp_bt_controller_config_t;
+#define BT_CONTROLLER_INIT_CONFIG_DEFAULT() {.mode = ESP_BT_MODE_BLE}
+
+esp_err_t esp_bt_controller_mem_release(esp_bt_mode_t mode);
+esp_err_t esp_bt_controller_init(esp_bt_controller_config_t *cfg);
+esp_err_t esp_bt_controller_enable(esp_bt_mode_t mode);
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef _SHIM_ESP_BT_MAIN_H_
+#define _SHIM_ESP_BT_MAIN_H_
+
+#include "esp_err.h"
+
+/* host stand-in: host stack bring-up starts the "btc" callback worker (shim_ble.c) */
+esp_err_t esp_bluedroid_init(void);
+esp_err_t esp_bluedroid_enable(void);
+
+#endif
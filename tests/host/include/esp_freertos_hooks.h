@@ -0,0 +1,6 @@
+#ifndef _SHIM_ESP_FREERTOS_HOOKS_H_
+#define _SHIM_ESP_FREERTOS_HOOKS_H_
+
+/* host stand-in: idle/tick hooks are not used by main/ */
+
+#endif
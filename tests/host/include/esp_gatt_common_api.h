@@ -0,0 +1,9 @@
+#ifndef _SHIM_ESP_GATT_COMMON_API_H_
+#define _SHIM_ESP_GATT_COMMON_API_H_
+
+#include "esp_err.h"
+
+/* host stand-in: local MTU is accepted and ignored */
+esp_err_t esp_ble_gatt_set_local_mtu(uint16_t mtu);
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef _SHIM_ESP_GATT_DEFS_H_
+#define _SHIM_ESP_GATT_DEFS_H_
+
+#include "esp_bt_defs.h"
+
+/* host stand-in: GATT definitions used by main/ */
+#define ESP_GATT_IF_NONE                0xff
+typedef uint8_t esp_gatt_if_t;
+
+#define ESP_GATT_CHAR_PROP_BIT_BROADCAST    (1 << 0)
+#define ESP_GATT_CHAR_PROP_BIT_READ         (1 << 1)
+#define ESP_GATT_CHAR_PROP_BIT_WRITE_NR     (1 << 2)
+#define ESP_GATT_CHAR_PROP_BIT_WRITE        (1 << 3)
+#define ESP_GATT_CHAR_PROP_BIT_NOTIFY       (1 << 4)
+#define ESP_GATT_CHAR_PROP_BIT_INDICATE     (1 << 5)
+typedef uint8_t esp_gatt_char_prop_t;
+
+typedef enum {
+    ESP_GATT_OK = 0x0,
+    ESP_GATT_INVALID_HANDLE = 0x01,
+    ESP_GATT_ERROR = 0x85,
+    ESP_GATT_NOT_FOUND = 0x8a,
+    ESP_GATT_BUSY = 0x84,
+} esp_gatt_status_t;
+
+typedef enum {
+    ESP_GATT_CONN_UNKNOWN = 0,
+    ESP_GATT_CONN_TIMEOUT = 0x08,
+    ESP_GATT_CONN_TERMINATE_PEER_USER = 0x13,
+    ESP_GATT_CONN_TERMINATE_LOCAL_HOST = 0x16,
+    ESP_GATT_CONN_FAIL_ESTABLISH = 0x3e,
+} esp_gatt_conn_reason_t;
+
+typedef struct {
+    esp_bt_uuid_t uuid;
+    uint8_t inst_id;
+} esp_gatt_id_t;
+
+typedef enum {
+    ESP_GATT_DB_PRIMARY_SERVICE,
+    ESP_GATT_DB_SECONDARY_SERVICE,
+    ESP_GATT_DB_CHARACTERISTIC,
+    ESP_GATT_DB_DESCRIPTOR,
+    ESP_GATT_DB_INCLUDED_SERVICE,
+    ESP_GATT_DB_ALL,
+} esp_gatt_db_attr_type_t;
+
+typedef struct {
+    uint16_t char_handle;
+    esp_gatt_char_prop_t properties;
+    esp_bt_uuid_t uuid;
+} esp_gattc_char_elem_t;
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef _SHIM_ESP_GATTC_API_H_
+#define _SHIM_ESP_GATTC_API_H_
+
+#include "esp_bt_defs.h"
+#include "esp_gatt_defs.h"
+
+/* host stand-in: every simulated device exposes the LYWSD03MMC service with one notify characteristic */
+typedef enum {
+    ESP_GATTC_REG_EVT = 0,
+    ESP_GATTC_UNREG_EVT = 1,
+    ESP_GATTC_OPEN_EVT = 2,
+    ESP_GATTC_READ_CHAR_EVT = 3,
+    ESP_GATTC_WRITE_CHAR_EVT = 4,
+    ESP_GATTC_CLOSE_EVT = 5,
+    ESP_GATTC_SEARCH_CMPL_EVT = 6,
+    ESP_GATTC_SEARCH_RES_EVT = 7,
+    ESP_GATTC_NOTIFY_EVT = 10,
+    ESP_GATTC_CFG_MTU_EVT = 18,
+    ESP_GATTC_REG_FOR_NOTIFY_EVT = 38,
+    ESP_GATTC_CONNECT_EVT = 40,
+    ESP_GATTC_DISCONNECT_EVT = 41,
+    ESP_GATTC_DIS_SRVC_CMPL_EVT = 46,
+} esp_gattc_cb_event_t;
+
+typedef union {
+    struct gattc_reg_evt_param {
+        esp_gatt_status_t status;
+        uint16_t app_id;
+    } reg;
+    struct gattc_open_evt_param {
+        esp_gatt_status_t status;
+        uint16_t conn_id;
+        esp_bd_addr_t remote_bda;
+        uint16_t mtu;
+    } open;
+    struct gattc_close_evt_param {
+        esp_gatt_status_t status;
+        uint16_t conn_id;
+        esp_bd_addr_t remote_bda;
+        esp_gatt_conn_reason_t reason;
+    } close;
+    struct gattc_cfg_mtu_evt_param {
+        esp_gatt_status_t status;
+        uint16_t conn_id;
+        uint16_t mtu;
+    } cfg_mtu;
+    struct gattc_search_cmpl_evt_param {
+        esp_gatt_status_t status;
+        uint16_t conn_id;
+    } search_cmpl;
+    struct gattc_search_res_evt_param {
+        uint16_t conn_id;
+        uint16_t start_handle;
+        uint16_t end_handle;
+        esp_gatt_id_t srvc_id;
+        bool is_primary;
+    } search_res;
+    struct gattc_notify_evt_param {
+        uint16_t conn_id;
+        esp_bd_addr_t remote_bda;
+        uint16_t handle;
+        uint16_t value_len;
+        uint8_t *value;
+        bool is_notify;
+    } notify;
+    struct gattc_reg_for_notify_evt_param {
+        esp_gatt_status_t status;
+        uint16_t handle;
+    } reg_for_notify;
+    struct gattc_connect_evt_param {
+        uint16_t conn_id;
+        esp_bd_addr_t remote_bda;
+    } connect;
+    struct gattc_disconnect_evt_param {
+        esp_gatt_conn_reason_t reason;
+        uint16_t conn_id;
+        esp_bd_addr_t remote_bda;
+    } disconnect;
+    struct gattc_dis_srvc_cmpl_evt_param {
+        esp_gatt_status_t status;
+        uint16_t conn_id;
+    } dis_srvc_cmpl;
+} esp_ble_gattc_cb_param_t;
+
+typedef void (*esp_gattc_cb_t)(esp_gattc_cb_event_t event, esp_gatt_if_t gattc_if, esp_ble_gattc_cb_param_t *param);
+
+esp_err_t esp_ble_gattc_register_callback(esp_gattc_cb_t callback);
+esp_err_t esp_ble_gattc_app_register(uint16_t app_id);
+esp_err_t esp_ble_gattc_open(esp_gatt_if_t gattc_if, esp_bd_addr_t remote_bda, esp_ble_addr_type_t remote_addr_type, bool is_direct);
+esp_err_t esp_ble_gattc_close(esp_gatt_if_t gattc_if, uint16_t conn_id);
+esp_err_t esp_ble_gattc_send_mtu_req(esp_gatt_if_t gattc_if, uint16_t conn_id);
+esp_err_t esp_ble_gattc_search_service(esp_gatt_if_t gattc_if, uint16_t conn_id, esp_bt_uuid_t *filter_uuid);
+esp_gatt_status_t esp_ble_gattc_get_attr_count(esp_gatt_if_t gattc_if, uint16_t conn_id, esp_gatt_db_attr_type_t type,
+                                               uint16_t start_handle, uint16_t end_handle, uint16_t char_handle,
+                                               uint16_t *count);
+esp_gatt_status_t esp_ble_gattc_get_char_by_uuid(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t start_handle,
+                                                 uint16_t end_handle, esp_bt_uuid_t char_uuid,
+                                                 esp_gattc_char_elem_t *result, uint16_t *count);
+esp_err_t esp_ble_gattc_register_for_notify(esp_gatt_if_t gattc_if, esp_bd_addr_t server_bda, uint16_t handle);
+
+#endif
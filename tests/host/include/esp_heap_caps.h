@@ -0,0 +1,24 @@
+#ifndef _SHIM_ESP_HEAP_CAPS_H_
+#define _SHIM_ESP_HEAP_CAPS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* host stand-in: capability based allocation maps to malloc, accounted against one
+   simulated DMA capable internal heap of SHIM_HEAP_SIZE bytes */
+#define SHIM_HEAP_SIZE          (160 * 1024)
+
+#define MALLOC_CAP_EXEC         (1 << 0)
+#define MALLOC_CAP_32BIT        (1 << 1)
+#define MALLOC_CAP_8BIT         (1 << 2)
+#define MALLOC_CAP_DMA          (1 << 3)
+#define MALLOC_CAP_INTERNAL     (1 << 11)
+#define MALLOC_CAP_DEFAULT      (1 << 12)
+
+void *heap_caps_malloc(size_t size, uint32_t caps);
+void heap_caps_free(void *ptr);
+size_t heap_caps_get_free_size(uint32_t caps);
+size_t heap_caps_get_minimum_free_size(uint32_t caps);
+size_t heap_caps_get_largest_free_block(uint32_t caps);
+
+#endif
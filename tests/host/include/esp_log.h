@@ -0,0 +1,26 @@
+#ifndef _SHIM_ESP_LOG_H_
+#define _SHIM_ESP_LOG_H_
+
+#include <stdint.h>
+
+/* host stand-in: log to stdout, level set by SHIM_LOG environment variable (E, W, I, D) */
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+void shim_log(esp_log_level_t level, const char *tag, const char *format, ...) __attribute__((format(printf, 3, 4)));
+void esp_log_buffer_hex(const char *tag, const void *buffer, uint16_t buff_len);
+void esp_log_level_set(const char *tag, esp_log_level_t level);
+
+#define ESP_LOGE(tag, format, ...) shim_log(ESP_LOG_ERROR, tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) shim_log(ESP_LOG_WARN, tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) shim_log(ESP_LOG_INFO, tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) shim_log(ESP_LOG_DEBUG, tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) shim_log(ESP_LOG_VERBOSE, tag, format, ##__VA_ARGS__)
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef _SHIM_ESP_SYSTEM_H_
+#define _SHIM_ESP_SYSTEM_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "esp_err.h"
+#include "esp_bit_defs.h"
+#include "esp_heap_caps.h"
+
+/* host stand-in: restart aborts the host process */
+void esp_restart(void) __attribute__((noreturn));
+
+#endif
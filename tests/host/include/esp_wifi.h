@@ -0,0 +1,106 @@
+#ifndef _SHIM_ESP_WIFI_H_
+#define _SHIM_ESP_WIFI_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "esp_event.h"
+
+/* host stand-in: station associates and gets an address right after esp_wifi_connect() */
+ESP_EVENT_DECLARE_BASE(WIFI_EVENT);
+ESP_EVENT_DECLARE_BASE(IP_EVENT);
+
+typedef enum {
+    WIFI_EVENT_WIFI_READY = 0,
+    WIFI_EVENT_SCAN_DONE,
+    WIFI_EVENT_STA_START,
+    WIFI_EVENT_STA_STOP,
+    WIFI_EVENT_STA_CONNECTED,
+    WIFI_EVENT_STA_DISCONNECTED,
+} wifi_event_t;
+
+typedef enum {
+    IP_EVENT_STA_GOT_IP = 0,
+    IP_EVENT_STA_LOST_IP,
+} ip_event_t;
+
+typedef struct {
+    uint32_t addr;
+} esp_ip4_addr_t;
+
+typedef struct {
+    esp_ip4_addr_t ip;
+    esp_ip4_addr_t netmask;
+    esp_ip4_addr_t gw;
+} esp_netif_ip_info_t;
+
+typedef struct {
+    int if_index;
+    esp_netif_ip_info_t ip_info;
+    bool ip_changed;
+} ip_event_got_ip_t;
+
+#define esp_ip4_addr1_16(ipaddr) ((uint16_t)(((ipaddr)->addr >> 0) & 0xff))
+#define esp_ip4_addr2_16(ipaddr) ((uint16_t)(((ipaddr)->addr >> 8) & 0xff))
+#define esp_ip4_addr3_16(ipaddr) ((uint16_t)(((ipaddr)->addr >> 16) & 0xff))
+#define esp_ip4_addr4_16(ipaddr) ((uint16_t)(((ipaddr)->addr >> 24) & 0xff))
+#define IPSTR "%d.%d.%d.%d"
+#define IP2STR(ipaddr) esp_ip4_addr1_16(ipaddr), esp_ip4_addr2_16(ipaddr), \
+                       esp_ip4_addr3_16(ipaddr), esp_ip4_addr4_16(ipaddr)
+
+typedef enum {
+    WIFI_MODE_NULL = 0,
+    WIFI_MODE_STA,
+    WIFI_MODE_AP,
+    WIFI_MODE_APSTA,
+} wifi_mode_t;
+
+typedef enum {
+    WIFI_IF_STA = 0,
+    WIFI_IF_AP,
+} wifi_interface_t;
+
+typedef enum {
+    WIFI_AUTH_OPEN = 0,
+    WIFI_AUTH_WEP,
+    WIFI_AUTH_WPA_PSK,
+    WIFI_AUTH_WPA2_PSK,
+    WIFI_AUTH_WPA_WPA2_PSK,
+} wifi_auth_mode_t;
+
+typedef struct {
+    int reserved;
+} wifi_init_config_t;
+#define WIFI_INIT_CONFIG_DEFAULT() {0}
+
+typedef struct {
+    wifi_auth_mode_t authmode;
+} wifi_scan_threshold_t;
+
+typedef struct {
+    bool capable;
+    bool required;
+} wifi_pmf_config_t;
+
+typedef struct {
+    uint8_t ssid[32];
+    uint8_t password[64];
+    wifi_scan_threshold_t threshold;
+    wifi_pmf_config_t pmf_cfg;
+} wifi_sta_config_t;
+
+typedef union {
+    wifi_sta_config_t sta;
+} wifi_config_t;
+
+esp_err_t esp_netif_init(void);
+void *esp_netif_create_default_wifi_sta(void);
+esp_err_t esp_wifi_init(const wifi_init_config_t *config);
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode);
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t *conf);
+esp_err_t esp_wifi_start(void);
+esp_err_t esp_wifi_connect(void);
+esp_err_t esp_wifi_disconnect(void);
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef _SHIM_FREERTOS_H_
+#define _SHIM_FREERTOS_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#include "esp_bit_defs.h"
+
+/* host stand-in for the FreeRTOS subset used by main/, objects are backed by pthreads (shim_rtos.c) */
+#define configTICK_RATE_HZ      100     /* ESP-IDF default CONFIG_FREERTOS_HZ */
+#define portTICK_PERIOD_MS      (1000 / configTICK_RATE_HZ)
+#define portMAX_DELAY           ((TickType_t)0xffffffffUL)
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+#define portNUM_PROCESSORS      2
+#define configMAX_TASK_NAME_LEN 16
+
+/* run-time counter is esp_timer_get_time(), task counters are thread CPU time */
+#define configUSE_TRACE_FACILITY        1
+#define configGENERATE_RUN_TIME_STATS   1
+#define configTASKLIST_INCLUDE_COREID   1
+
+#define pdFALSE                 ((BaseType_t)0)
+#define pdTRUE                  ((BaseType_t)1)
+#define pdPASS                  pdTRUE
+#define pdFAIL                  pdFALSE
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint8_t StackType_t;
+
+BaseType_t xPortGetCoreID(void);
+
+#endif
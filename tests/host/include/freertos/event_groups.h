@@ -0,0 +1,17 @@
+#ifndef _SHIM_EVENT_GROUPS_H_
+#define _SHIM_EVENT_GROUPS_H_
+
+#include "freertos/FreeRTOS.h"
+
+/* host stand-in: event bits guarded by mutex + condition */
+typedef struct shim_evt_group *EventGroupHandle_t;
+typedef uint32_t EventBits_t;
+
+EventGroupHandle_t xEventGroupCreate(void);
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear_on_exit,
+                                BaseType_t wait_all, TickType_t ticks);
+#define xEventGroupGetBits(group) xEventGroupClearBits(group, 0)
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef _SHIM_QUEUE_H_
+#define _SHIM_QUEUE_H_
+
+#include "freertos/FreeRTOS.h"
+
+/* host stand-in: fixed-size copy queue guarded by mutex + condition */
+typedef struct shim_queue *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+#define xQueueSendToBack(queue, item, ticks) xQueueSend(queue, item, ticks)
+
+#endif
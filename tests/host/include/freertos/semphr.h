@@ -0,0 +1,16 @@
+#ifndef _SHIM_SEMPHR_H_
+#define _SHIM_SEMPHR_H_
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+/* host stand-in: counting semaphore on mutex + condition, mutex starts given, binary starts taken */
+typedef struct shim_sem *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+void vSemaphoreDelete(SemaphoreHandle_t sem);
+
+#endif
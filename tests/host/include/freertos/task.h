@@ -0,0 +1,58 @@
+#ifndef _SHIM_TASK_H_
+#define _SHIM_TASK_H_
+
+#include "freertos/FreeRTOS.h"
+
+/* host stand-in: one pthread per task, notification value guarded by mutex + condition */
+typedef struct shim_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *param);
+
+typedef enum {
+    eNoAction = 0,
+    eSetBits,
+    eIncrement,
+    eSetValueWithOverwrite,
+    eSetValueWithoutOverwrite,
+} eNotifyAction;
+
+#define tskNO_AFFINITY          0x7fffffff
+
+typedef enum {
+    eRunning = 0,
+    eReady,
+    eBlocked,
+    eSuspended,
+    eDeleted,
+    eInvalid,
+} eTaskState;
+
+/* uxTaskGetSystemState() entry, stack high water mark is the stack size passed on create (not measured) */
+typedef struct xTASK_STATUS {
+    TaskHandle_t xHandle;
+    const char *pcTaskName;
+    UBaseType_t xTaskNumber;
+    eTaskState eCurrentState;
+    UBaseType_t uxCurrentPriority;
+    UBaseType_t uxBasePriority;
+    uint32_t ulRunTimeCounter;
+    StackType_t *pxStackBase;
+    uint32_t usStackHighWaterMark;
+    BaseType_t xCoreID;
+} TaskStatus_t;
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fcn, const char *name, uint32_t stack_depth, void *param,
+                                   UBaseType_t priority, TaskHandle_t *created_task, BaseType_t core_id);
+#define xTaskCreate(fcn, name, stack_depth, param, priority, created_task) \
+    xTaskCreatePinnedToCore(fcn, name, stack_depth, param, priority, created_task, tskNO_AFFINITY)
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+char *pcTaskGetTaskName(TaskHandle_t task);
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action);
+UBaseType_t uxTaskGetNumberOfTasks(void);
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *status_array, UBaseType_t array_size, uint32_t *total_runtime);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t *value, TickType_t ticks);
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef _SHIM_LVGL_HELPERS_H_
+#define _SHIM_LVGL_HELPERS_H_
+
+#include "lvgl.h"
+
+/* host stand-in for lvgl_esp32_drivers: flush counts pixels and completes at once (shim_disp.c) */
+#define DISP_BUF_SIZE   (LV_HOR_RES_MAX * 40)
+
+void lvgl_driver_init(void);
+void disp_driver_flush(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map);
+
+#endif
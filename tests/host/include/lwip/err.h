@@ -0,0 +1,6 @@
+#ifndef _SHIM_LWIP_ERR_H_
+#define _SHIM_LWIP_ERR_H_
+
+/* host stand-in: lwIP is hidden behind esp_wifi.h shim */
+
+#endif
@@ -0,0 +1,29 @@
+/**
+ * @file lv_conf.h
+ * Host build configuration, mirrors the M5Stack Core settings from sdkconfig (ILI9341 320x240, RGB565 swapped)
+ */
+
+#ifndef LV_CONF_H
+#define LV_CONF_H
+
+#include <stdint.h>
+
+#define LV_HOR_RES_MAX          320
+#define LV_VER_RES_MAX          240
+#define LV_COLOR_DEPTH          16
+#define LV_COLOR_16_SWAP        1
+#define LV_MEM_SIZE             (32U * 1024U)
+#define LV_USE_LOG              0
+#define LV_USE_DEBUG            0
+#define LV_TICK_CUSTOM          0
+
+typedef int16_t lv_coord_t;
+typedef void * lv_anim_user_data_t;
+typedef void * lv_group_user_data_t;
+typedef void * lv_fs_drv_user_data_t;
+typedef void * lv_img_decoder_user_data_t;
+typedef void * lv_disp_drv_user_data_t;
+typedef void * lv_indev_drv_user_data_t;
+typedef void * lv_font_user_data_t;
+
+#endif
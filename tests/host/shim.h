@@ -0,0 +1,92 @@
+#ifndef _SHIM_H_
+#define _SHIM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/* DEFINES */
+#define SHIM_BLE_DEV_MAX        16
+#define SHIM_BLE_VALUE_MAX      32      /* notify payload bytes */
+#define SHIM_BLE_ADV_MAX        62      /* advert + scan response */
+
+/* TYPE DEFINITIONS */
+/* job run by a worker task, data is a private copy */
+typedef void (*shim_job_fcn_t)(void *data);
+typedef struct shim_job_t shim_job_t;
+
+/* callback thread of a host stack (btc, sys_evt, mqtt), runs posted jobs in order */
+typedef struct shim_worker_t {
+    const char *name;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    shim_job_t *head;
+    shim_job_t *tail;
+    uint32_t posted;
+    uint32_t done;
+    bool started;
+} shim_worker_t;
+
+/* one recorded notification: time since trace start, device index, raw characteristic value */
+typedef struct shim_trace_rec_t {
+    uint32_t t_ms;
+    uint8_t dev;
+    uint8_t len;
+    uint8_t value[SHIM_BLE_VALUE_MAX];
+} shim_trace_rec_t;
+
+/* publishes seen by the broker stand-in */
+typedef void (*shim_mqtt_hook_t)(const char *topic, const uint8_t *data, int len, void *ctx);
+typedef struct shim_mqtt_stats_t {
+    uint32_t msg_count;
+    uint64_t byte_count;
+    uint32_t fail_count;    /* publish attempts while disconnected */
+    uint32_t connect_count;
+    uint32_t publish_lost;  /* dropped by shim_mqtt_set_loss */
+    uint32_t ack_lost;
+} shim_mqtt_stats_t;
+
+/* PUBLIC PROTOTYPES */
+void app_main(void);
+void shim_app_start(void);
+void shim_sleep_ms(uint32_t ms);
+
+void shim_worker_start(shim_worker_t *worker, const char *name);
+void shim_worker_post(shim_worker_t *worker, shim_job_fcn_t fcn, const void *data, size_t size);
+bool shim_worker_idle(shim_worker_t *worker);
+
+void shim_wifi_set_ap(bool up);
+uint32_t shim_nvs_write_count(void);
+bool shim_wifi_idle(void);
+
+int shim_ble_add_device(const uint8_t *bda, const char *name);
+bool shim_ble_set_adv(int dev, const uint8_t *adv, int len);
+int shim_ble_ready_count(void);
+bool shim_ble_wait_ready(int count, uint32_t timeout_ms);
+bool shim_ble_notify(int dev, const uint8_t *value, int len);
+bool shim_ble_disconnect(int dev);
+bool shim_ble_set_handle(int dev, uint16_t handle);
+int32_t shim_ble_ready_ms(int dev);
+bool shim_ble_set_rssi(int dev, int8_t rssi);
+bool shim_ble_conn_params(int dev, uint16_t *interval, uint16_t *latency);
+uint32_t shim_ble_wl_scan_count(void);
+bool shim_ble_idle(void);
+int shim_trace_load(const char *path, shim_trace_rec_t *recs, int max);
+int shim_ble_replay(const shim_trace_rec_t *recs, int count, bool realtime, int64_t *sent_us);
+
+void shim_mqtt_set_hook(shim_mqtt_hook_t hook, void *ctx);
+void shim_mqtt_set_broker(bool up);
+void shim_mqtt_set_loss(int publish_permille, int ack_permille);
+bool shim_mqtt_receive(const char *suffix, const char *data, int len);
+bool shim_mqtt_connected(void);
+bool shim_mqtt_idle(void);
+shim_mqtt_stats_t shim_mqtt_stats(void);
+
+uint32_t shim_disp_flush_count(void);
+uint64_t shim_disp_px_count(void);
+
+#endif
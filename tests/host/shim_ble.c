@@ -0,0 +1,875 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_bt.h"
+#include "esp_bt_main.h"
+#include "esp_gap_ble_api.h"
+#include "esp_gattc_api.h"
+#include "esp_gatt_common_api.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+#include "shim.h"
+
+/* DEFINES */
+#define GATTC_IF            3
+#define ADV_INTERVAL_MS     100     /* advertising interval of simulated devices */
+#define CTRL_PERIOD_MS      10
+#define SERVICE_START       0x0020
+#define SERVICE_END         0x0040
+#define NOTIFY_HANDLE       0x0036
+#define DEV_MTU             247
+#define DISCOVERY_MS        800     /* Bluedroid service discovery after connect */
+#define DEV_RSSI            -60     /* dBm of adverts and links until shim_ble_set_rssi */
+#define CONN_INTERVAL       24      /* 30 ms, connection parameters the link starts with */
+#define CONN_TIMEOUT        400     /* 4 s */
+
+/* TYPE DEFINITIONS */
+/* simulated peripheral */
+typedef struct ble_dev_t {
+    uint8_t bda[ESP_BD_ADDR_LEN];
+    uint8_t adv[SHIM_BLE_ADV_MAX];
+    uint8_t adv_len;
+    bool connected;
+    bool notify_on;
+    bool db_ready;          /* discovery done on this link */
+    bool in_wl;             /* in controller whitelist */
+    uint16_t conn_id;
+    uint16_t notify_handle;
+    int8_t rssi;
+    uint16_t conn_int;      /* 1.25 ms units */
+    uint16_t latency;
+    uint16_t timeout;       /* 10 ms units */
+    int64_t connect_us;
+    int64_t ready_us;       /* notifications enabled, 0: not yet */
+    int64_t disc_due_us;    /* DIS_SRVC_CMPL time, 0: none pending */
+} ble_dev_t;
+
+typedef struct gap_job_t {
+    esp_gap_ble_cb_event_t event;
+    esp_ble_gap_cb_param_t param;
+} gap_job_t;
+
+typedef struct gattc_job_t {
+    esp_gattc_cb_event_t event;
+    esp_gatt_if_t gattc_if;
+    esp_ble_gattc_cb_param_t param;
+    uint8_t value[SHIM_BLE_VALUE_MAX];  /* storage behind param.notify.value */
+} gattc_job_t;
+
+/* STATIC VARIABLES */
+/* GATT database of LYWSD03MMC with custom firmware, as looked up by ble_gatt.c */
+static const uint8_t service_uuid[ESP_UUID_LEN_128]     = {0xA6, 0xA3, 0x7D, 0x99, 0xF2, 0x6F, 0x1A, 0x8A, 0x0C, 0x4B, 0x0A, 0x7A, 0xB0, 0xCC, 0xE0, 0xEB};
+static const uint8_t notify_char_uuid[ESP_UUID_LEN_128] = {0xA6, 0xA3, 0x7D, 0x99, 0xF2, 0x6F, 0x1A, 0x8A, 0x0C, 0x4B, 0x0A, 0x7A, 0xC1, 0xCC, 0xE0, 0xEB};
+
+static pthread_mutex_t ble_lock = PTHREAD_MUTEX_INITIALIZER;
+static shim_worker_t btc;
+static esp_gap_ble_cb_t gap_cb = NULL;
+static esp_gattc_cb_t gattc_cb = NULL;
+static ble_dev_t dev_tab[SHIM_BLE_DEV_MAX];
+static int dev_num = 0;
+static uint16_t next_conn_id = 0;
+static bool scanning = false;
+static int64_t scan_end_us = 0;         /* 0: scan until stopped */
+static int64_t next_adv_us = 0;
+static uint16_t scan_interval = 0x50;   /* 0.625 ms units */
+static uint16_t scan_window = 0x50;
+static esp_ble_scan_filter_t scan_filter = BLE_SCAN_FILTER_ALLOW_ALL;
+static uint32_t wl_scan_count = 0;
+static bool ctrl_started = false;
+
+/* STATIC PROTOTYPES */
+static void gap_job_fcn(void *data);
+static void gattc_job_fcn(void *data);
+static void gap_post(esp_gap_ble_cb_event_t event, const esp_ble_gap_cb_param_t *param);
+static void gattc_post(esp_gattc_cb_event_t event, const esp_ble_gattc_cb_param_t *param, const uint8_t *value, int len);
+static ble_dev_t *find_bda(const uint8_t *bda);
+static ble_dev_t *find_conn(uint16_t conn_id);
+static void adv_post(const ble_dev_t *dev);
+static void link_down(ble_dev_t *dev, esp_gatt_conn_reason_t reason);
+static void ctrl_task_fcn(void *param);
+static int hex_parse(const char *str, uint8_t *buf, int size);
+
+/**
+ * @brief deliver GAP event on btc task
+ * 
+ * @param data gap_job_t
+ */
+static void gap_job_fcn(void *data) {
+    gap_job_t *job = data;
+    if (gap_cb) {
+        gap_cb(job->event, &job->param);
+    }
+}
+
+/**
+ * @brief deliver GATTC event on btc task
+ * 
+ * @param data gattc_job_t
+ */
+static void gattc_job_fcn(void *data) {
+    gattc_job_t *job = data;
+    if (job->event == ESP_GATTC_NOTIFY_EVT) {
+        job->param.notify.value = job->value;
+    }
+    if (gattc_cb) {
+        gattc_cb(job->event, job->gattc_if, &job->param);
+    }
+}
+
+/**
+ * @brief queue GAP event
+ * 
+ * @param event 
+ * @param param 
+ */
+static void gap_post(esp_gap_ble_cb_event_t event, const esp_ble_gap_cb_param_t *param) {
+    gap_job_t job = {.event = event, .param = *param};
+    shim_worker_post(&btc, gap_job_fcn, &job, sizeof(job));
+}
+
+/**
+ * @brief queue GATTC event
+ * 
+ * @param event 
+ * @param param 
+ * @param value notify payload or NULL
+ * @param len 
+ */
+static void gattc_post(esp_gattc_cb_event_t event, const esp_ble_gattc_cb_param_t *param, const uint8_t *value, int len) {
+    gattc_job_t job = {.event = event, .gattc_if = GATTC_IF, .param = *param};
+    if (value) {
+        memcpy(job.value, value, len);
+    }
+    shim_worker_post(&btc, gattc_job_fcn, &job, sizeof(job));
+}
+
+/**
+ * @brief find device by address, caller holds ble_lock
+ * 
+ * @param bda 
+ * @return device or NULL
+ */
+static ble_dev_t *find_bda(const uint8_t *bda) {
+    for (int idx = 0; idx < dev_num; idx++) {
+        if (memcmp(dev_tab[idx].bda, bda, ESP_BD_ADDR_LEN) == 0) {
+            return &dev_tab[idx];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief find connected device, caller holds ble_lock
+ * 
+ * @param conn_id 
+ * @return device or NULL
+ */
+static ble_dev_t *find_conn(uint16_t conn_id) {
+    for (int idx = 0; idx < dev_num; idx++) {
+        if (dev_tab[idx].connected && dev_tab[idx].conn_id == conn_id) {
+            return &dev_tab[idx];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief report one advertisement, caller holds ble_lock
+ * 
+ * @param dev 
+ */
+static void adv_post(const ble_dev_t *dev) {
+    esp_ble_gap_cb_param_t param;
+    memset(&param, 0, sizeof(param));
+    param.scan_rst.search_evt = ESP_GAP_SEARCH_INQ_RES_EVT;
+    memcpy(param.scan_rst.bda, dev->bda, ESP_BD_ADDR_LEN);
+    param.scan_rst.ble_addr_type = BLE_ADDR_TYPE_PUBLIC;
+    param.scan_rst.ble_evt_type = ESP_BLE_EVT_CONN_ADV;
+    param.scan_rst.rssi = dev->rssi;
+    memcpy(param.scan_rst.ble_adv, dev->adv, dev->adv_len);
+    param.scan_rst.adv_data_len = dev->adv_len;
+    gap_post(ESP_GAP_BLE_SCAN_RESULT_EVT, &param);
+}
+
+/**
+ * @brief drop link and report disconnect, caller holds ble_lock
+ * 
+ * @param dev 
+ * @param reason 
+ */
+static void link_down(ble_dev_t *dev, esp_gatt_conn_reason_t reason) {
+    esp_ble_gattc_cb_param_t param;
+    memset(&param, 0, sizeof(param));
+    dev->connected = false;
+    dev->notify_on = false;
+    dev->disc_due_us = 0;
+    param.close.status = ESP_GATT_OK;
+    param.close.conn_id = dev->conn_id;
+    memcpy(param.close.remote_bda, dev->bda, ESP_BD_ADDR_LEN);
+    param.close.reason = reason;
+    gattc_post(ESP_GATTC_CLOSE_EVT, &param, NULL, 0);
+    memset(&param, 0, sizeof(param));
+    param.disconnect.reason = reason;
+    param.disconnect.conn_id = dev->conn_id;
+    memcpy(param.disconnect.remote_bda, dev->bda, ESP_BD_ADDR_LEN);
+    gattc_post(ESP_GATTC_DISCONNECT_EVT, &param, NULL, 0);
+}
+
+/**
+ * @brief controller: advertisements of unconnected devices and scan duration
+ * 
+ * @param param unused
+ */
+static void ctrl_task_fcn(void *param) {
+    (void)param;
+    for (;;) {
+        int64_t now = esp_timer_get_time();
+        pthread_mutex_lock(&ble_lock);
+        if (scanning && scan_end_us && now >= scan_end_us) {
+            esp_ble_gap_cb_param_t cmpl;
+            memset(&cmpl, 0, sizeof(cmpl));
+            cmpl.scan_rst.search_evt = ESP_GAP_SEARCH_INQ_CMPL_EVT;
+            scanning = false;
+            gap_post(ESP_GAP_BLE_SCAN_RESULT_EVT, &cmpl);
+        } else if (scanning && now >= next_adv_us && ((now / 625) % scan_interval) < scan_window) {
+            /* advertisements are only heard inside the scan window */
+            for (int idx = 0; idx < dev_num; idx++) {
+                if (!dev_tab[idx].connected && (scan_filter != BLE_SCAN_FILTER_ALLOW_ONLY_WLST || dev_tab[idx].in_wl)) {
+                    adv_post(&dev_tab[idx]);
+                }
+            }
+            next_adv_us = now + ADV_INTERVAL_MS * 1000;
+        }
+        for (int idx = 0; idx < dev_num; idx++) {
+            ble_dev_t *dev = &dev_tab[idx];
+            if (dev->connected && dev->disc_due_us && now >= dev->disc_due_us) {
+                /* Bluedroid discovers the database once the link is up */
+                esp_ble_gattc_cb_param_t disc;
+                memset(&disc, 0, sizeof(disc));
+                disc.dis_srvc_cmpl.status = ESP_GATT_OK;
+                disc.dis_srvc_cmpl.conn_id = dev->conn_id;
+                dev->disc_due_us = 0;
+                dev->db_ready = true;
+                gattc_post(ESP_GATTC_DIS_SRVC_CMPL_EVT, &disc, NULL, 0);
+            }
+        }
+        pthread_mutex_unlock(&ble_lock);
+        shim_sleep_ms(CTRL_PERIOD_MS);
+    }
+}
+
+esp_err_t esp_bt_controller_mem_release(esp_bt_mode_t mode) {
+    (void)mode;
+    return ESP_OK;
+}
+
+esp_err_t esp_bt_controller_init(esp_bt_controller_config_t *cfg) {
+    (void)cfg;
+    return ESP_OK;
+}
+
+esp_err_t esp_bt_controller_enable(esp_bt_mode_t mode) {
+    (void)mode;
+    if (!ctrl_started) {
+        ctrl_started = true;
+        xTaskCreatePinnedToCore(ctrl_task_fcn, "bt_ctrl", 4096, NULL, 22, NULL, 0);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_bluedroid_init(void) {
+    shim_worker_start(&btc, "btc");
+    return ESP_OK;
+}
+
+esp_err_t esp_bluedroid_enable(void) {
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_register_callback(esp_gap_ble_cb_t callback) {
+    gap_cb = callback;
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gattc_register_callback(esp_gattc_cb_t callback) {
+    gattc_cb = callback;
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gatt_set_local_mtu(uint16_t mtu) {
+    (void)mtu;
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gattc_app_register(uint16_t app_id) {
+    esp_ble_gattc_cb_param_t param;
+    memset(&param, 0, sizeof(param));
+    param.reg.status = ESP_GATT_OK;
+    param.reg.app_id = app_id;
+    gattc_post(ESP_GATTC_REG_EVT, &param, NULL, 0);
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_set_scan_params(esp_ble_scan_params_t *scan_params) {
+    esp_ble_gap_cb_param_t param;
+    memset(&param, 0, sizeof(param));
+    pthread_mutex_lock(&ble_lock);
+    if (scan_params->scan_interval > 0 && scan_params->scan_window <= scan_params->scan_interval) {
+        scan_interval = scan_params->scan_interval;
+        scan_window = scan_params->scan_window;
+        scan_filter = scan_params->scan_filter_policy;
+    }
+    pthread_mutex_unlock(&ble_lock);
+    param.scan_param_cmpl.status = ESP_BT_STATUS_SUCCESS;
+    gap_post(ESP_GAP_BLE_SCAN_PARAM_SET_COMPLETE_EVT, &param);
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_start_scanning(uint32_t duration) {
+    esp_ble_gap_cb_param_t param;
+    memset(&param, 0, sizeof(param));
+    pthread_mutex_lock(&ble_lock);
+    param.scan_start_cmpl.status = scanning ? ESP_BT_STATUS_BUSY : ESP_BT_STATUS_SUCCESS;
+    if (!scanning) {
+        int64_t now = esp_timer_get_time();
+        scanning = true;
+        scan_end_us = duration ? now + (int64_t)duration * 1000000 : 0;
+        next_adv_us = now;
+        wl_scan_count += scan_filter == BLE_SCAN_FILTER_ALLOW_ONLY_WLST;
+    }
+    gap_post(ESP_GAP_BLE_SCAN_START_COMPLETE_EVT, &param);
+    pthread_mutex_unlock(&ble_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_stop_scanning(void) {
+    esp_ble_gap_cb_param_t param;
+    memset(&param, 0, sizeof(param));
+    pthread_mutex_lock(&ble_lock);
+    scanning = false;
+    param.scan_stop_cmpl.status = ESP_BT_STATUS_SUCCESS;
+    gap_post(ESP_GAP_BLE_SCAN_STOP_COMPLETE_EVT, &param);
+    pthread_mutex_unlock(&ble_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_update_whitelist(bool add_remove, esp_bd_addr_t remote_bda, esp_ble_wl_addr_type_t wl_addr_type) {
+    (void)wl_addr_type;
+    esp_ble_gap_cb_param_t param;
+    memset(&param, 0, sizeof(param));
+    pthread_mutex_lock(&ble_lock);
+    ble_dev_t *dev = find_bda(remote_bda);
+    if (dev) {
+        dev->in_wl = add_remove;
+    }
+    /* unknown addresses take a whitelist entry that never matches */
+    param.update_whitelist_cmpl.status = ESP_BT_STATUS_SUCCESS;
+    param.update_whitelist_cmpl.wl_opration = add_remove ? ESP_BLE_WHITELIST_ADD : ESP_BLE_WHITELIST_REMOVE;
+    gap_post(ESP_GAP_BLE_UPDATE_WHITELIST_COMPLETE_EVT, &param);
+    pthread_mutex_unlock(&ble_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gap_update_conn_params(esp_ble_conn_update_params_t *params) {
+    esp_ble_gap_cb_param_t param;
+    memset(&param, 0, sizeof(param));
+    pthread_mutex_lock(&ble_lock);
+    ble_dev_t *dev = find_bda(params->bda);
+    /* controller checks of HCI LE Connection Update, peer accepts anything valid */
+    bool ok = dev && dev->connected && params->min_int >= 6 && params->min_int <= params->max_int &&
+              params->max_int <= 3200 && params->latency <= 499 && params->timeout >= 10 && params->timeout <= 3200 &&
+              (uint32_t)params->timeout * 4 > (uint32_t)(1 + params->latency) * params->max_int;
+    if (ok) {
+        dev->conn_int = params->max_int;
+        dev->latency = params->latency;
+        dev->timeout = params->timeout;
+    }
+    memcpy(param.update_conn_params.bda, params->bda, ESP_BD_ADDR_LEN);
+    param.update_conn_params.status = ok ? ESP_BT_STATUS_SUCCESS : ESP_BT_STATUS_FAIL;
+    param.update_conn_params.min_int = params->min_int;
+    param.update_conn_params.max_int = params->max_int;
+    if (dev) {
+        param.update_conn_params.conn_int = dev->conn_int;
+        param.update_conn_params.latency = dev->latency;
+        param.update_conn_params.timeout = dev->timeout;
+    }
+    gap_post(ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT, &param);
+    pthread_mutex_unlock(&ble_lock);
+    return dev && dev->connected ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_ble_gap_read_rssi(esp_bd_addr_t remote_addr) {
+    esp_ble_gap_cb_param_t param;
+    memset(&param, 0, sizeof(param));
+    pthread_mutex_lock(&ble_lock);
+    ble_dev_t *dev = find_bda(remote_addr);
+    bool ok = dev && dev->connected;
+    memcpy(param.read_rssi_cmpl.remote_addr, remote_addr, ESP_BD_ADDR_LEN);
+    param.read_rssi_cmpl.status = ok ? ESP_BT_STATUS_SUCCESS : ESP_BT_STATUS_FAIL;
+    param.read_rssi_cmpl.rssi = ok ? dev->rssi : 0;
+    gap_post(ESP_GAP_BLE_READ_RSSI_COMPLETE_EVT, &param);
+    pthread_mutex_unlock(&ble_lock);
+    return ok ? ESP_OK : ESP_FAIL;
+}
+
+uint8_t *esp_ble_resolve_adv_data(uint8_t *adv_data, uint8_t type, uint8_t *length) {
+    int pos = 0;
+    *length = 0;
+    while (pos + 1 < SHIM_BLE_ADV_MAX && adv_data[pos] != 0) {
+        int ad_len = adv_data[pos];
+        if (pos + 1 + ad_len > SHIM_BLE_ADV_MAX) {
+            break;
+        }
+        if (adv_data[pos + 1] == type) {
+            *length = (uint8_t)(ad_len - 1);
+            return &adv_data[pos + 2];
+        }
+        pos += 1 + ad_len;
+    }
+    return NULL;
+}
+
+esp_err_t esp_ble_gattc_open(esp_gatt_if_t gattc_if, esp_bd_addr_t remote_bda, esp_ble_addr_type_t remote_addr_type, bool is_direct) {
+    (void)gattc_if;
+    (void)remote_addr_type;
+    (void)is_direct;
+    esp_ble_gattc_cb_param_t param;
+    memset(&param, 0, sizeof(param));
+    pthread_mutex_lock(&ble_lock);
+    ble_dev_t *dev = find_bda(remote_bda);
+    memcpy(param.open.remote_bda, remote_bda, ESP_BD_ADDR_LEN);
+    if (dev == NULL || dev->connected) {
+        param.open.status = ESP_GATT_ERROR;
+    } else {
+        dev->connected = true;
+        dev->notify_on = false;
+        dev->db_ready = false;
+        dev->conn_id = next_conn_id++;
+        dev->conn_int = CONN_INTERVAL;
+        dev->latency = 0;
+        dev->timeout = CONN_TIMEOUT;
+        dev->connect_us = esp_timer_get_time();
+        dev->ready_us = 0;
+        dev->disc_due_us = dev->connect_us + DISCOVERY_MS * 1000;
+        esp_ble_gattc_cb_param_t connect;
+        memset(&connect, 0, sizeof(connect));
+        connect.connect.conn_id = dev->conn_id;
+        memcpy(connect.connect.remote_bda, dev->bda, ESP_BD_ADDR_LEN);
+        gattc_post(ESP_GATTC_CONNECT_EVT, &connect, NULL, 0);
+        param.open.status = ESP_GATT_OK;
+        param.open.conn_id = dev->conn_id;
+        param.open.mtu = 23;
+    }
+    gattc_post(ESP_GATTC_OPEN_EVT, &param, NULL, 0);
+    pthread_mutex_unlock(&ble_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gattc_close(esp_gatt_if_t gattc_if, uint16_t conn_id) {
+    (void)gattc_if;
+    pthread_mutex_lock(&ble_lock);
+    ble_dev_t *dev = find_conn(conn_id);
+    if (dev) {
+        link_down(dev, ESP_GATT_CONN_TERMINATE_LOCAL_HOST);
+    }
+    pthread_mutex_unlock(&ble_lock);
+    return dev ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_ble_gattc_send_mtu_req(esp_gatt_if_t gattc_if, uint16_t conn_id) {
+    (void)gattc_if;
+    esp_ble_gattc_cb_param_t param;
+    memset(&param, 0, sizeof(param));
+    param.cfg_mtu.status = ESP_GATT_OK;
+    param.cfg_mtu.conn_id = conn_id;
+    param.cfg_mtu.mtu = DEV_MTU;
+    gattc_post(ESP_GATTC_CFG_MTU_EVT, &param, NULL, 0);
+    return ESP_OK;
+}
+
+esp_err_t esp_ble_gattc_search_service(esp_gatt_if_t gattc_if, uint16_t conn_id, esp_bt_uuid_t *filter_uuid) {
+    (void)gattc_if;
+    esp_ble_gattc_cb_param_t param;
+    if (filter_uuid == NULL || (filter_uuid->len == ESP_UUID_LEN_128 &&
+                                memcmp(filter_uuid->uuid.uuid128, service_uuid, ESP_UUID_LEN_128) == 0)) {
+        memset(&param, 0, sizeof(param));
+        param.search_res.conn_id = conn_id;
+        param.search_res.start_handle = SERVICE_START;
+        param.search_res.end_handle = SERVICE_END;
+        param.search_res.srvc_id.uuid.len = ESP_UUID_LEN_128;
+        memcpy(param.search_res.srvc_id.uuid.uuid.uuid128, service_uuid, ESP_UUID_LEN_128);
+        param.search_res.is_primary = true;
+        gattc_post(ESP_GATTC_SEARCH_RES_EVT, &param, NULL, 0);
+    }
+    memset(&param, 0, sizeof(param));
+    param.search_cmpl.status = ESP_GATT_OK;
+    param.search_cmpl.conn_id = conn_id;
+    gattc_post(ESP_GATTC_SEARCH_CMPL_EVT, &param, NULL, 0);
+    return ESP_OK;
+}
+
+esp_gatt_status_t esp_ble_gattc_get_attr_count(esp_gatt_if_t gattc_if, uint16_t conn_id, esp_gatt_db_attr_type_t type,
+                                               uint16_t start_handle, uint16_t end_handle, uint16_t char_handle,
+                                               uint16_t *count) {
+    (void)gattc_if;
+    (void)char_handle;
+    pthread_mutex_lock(&ble_lock);
+    ble_dev_t *dev = find_conn(conn_id);
+    uint16_t handle = (dev && dev->db_ready) ? dev->notify_handle : 0;
+    pthread_mutex_unlock(&ble_lock);
+    *count = (type == ESP_GATT_DB_CHARACTERISTIC && handle && start_handle <= handle && handle <= end_handle) ? 1 : 0;
+    return ESP_GATT_OK;
+}
+
+esp_gatt_status_t esp_ble_gattc_get_char_by_uuid(esp_gatt_if_t gattc_if, uint16_t conn_id, uint16_t start_handle,
+                                                 uint16_t end_handle, esp_bt_uuid_t char_uuid,
+                                                 esp_gattc_char_elem_t *result, uint16_t *count) {
+    (void)gattc_if;
+    pthread_mutex_lock(&ble_lock);
+    ble_dev_t *dev = find_conn(conn_id);
+    uint16_t handle = (dev && dev->db_ready) ? dev->notify_handle : 0;
+    pthread_mutex_unlock(&ble_lock);
+    if (*count == 0 || handle == 0 || start_handle > handle || handle > end_handle ||
+        char_uuid.len != ESP_UUID_LEN_128 || memcmp(char_uuid.uuid.uuid128, notify_char_uuid, ESP_UUID_LEN_128) != 0) {
+        *count = 0;
+        return ESP_GATT_NOT_FOUND;
+    }
+    result[0].char_handle = handle;
+    result[0].properties = ESP_GATT_CHAR_PROP_BIT_READ | ESP_GATT_CHAR_PROP_BIT_NOTIFY;
+    result[0].uuid = char_uuid;
+    *count = 1;
+    return ESP_GATT_OK;
+}
+
+esp_err_t esp_ble_gattc_register_for_notify(esp_gatt_if_t gattc_if, esp_bd_addr_t server_bda, uint16_t handle) {
+    (void)gattc_if;
+    esp_ble_gattc_cb_param_t param;
+    memset(&param, 0, sizeof(param));
+    pthread_mutex_lock(&ble_lock);
+    ble_dev_t *dev = find_bda(server_bda);
+    bool ok = dev && dev->connected && handle == dev->notify_handle;
+    if (ok && !dev->notify_on) {
+        dev->notify_on = true;
+        dev->ready_us = esp_timer_get_time();
+    }
+    param.reg_for_notify.status = ok ? ESP_GATT_OK : ESP_GATT_INVALID_HANDLE;
+    param.reg_for_notify.handle = handle;
+    gattc_post(ESP_GATTC_REG_FOR_NOTIFY_EVT, &param, NULL, 0);
+    pthread_mutex_unlock(&ble_lock);
+    return ESP_OK;
+}
+
+/**
+ * @brief add simulated peripheral advertising its complete local name
+ * 
+ * @param bda 
+ * @param name 
+ * @return device index or -1 if table is full
+ */
+int shim_ble_add_device(const uint8_t *bda, const char *name) {
+    pthread_mutex_lock(&ble_lock);
+    if (dev_num >= SHIM_BLE_DEV_MAX) {
+        pthread_mutex_unlock(&ble_lock);
+        return -1;
+    }
+    ble_dev_t *dev = &dev_tab[dev_num];
+    memset(dev, 0, sizeof(ble_dev_t));
+    memcpy(dev->bda, bda, ESP_BD_ADDR_LEN);
+    dev->notify_handle = NOTIFY_HANDLE;
+    dev->rssi = DEV_RSSI;
+    int name_len = (int)strlen(name);
+    dev->adv[0] = 2;
+    dev->adv[1] = ESP_BLE_AD_TYPE_FLAG;
+    dev->adv[2] = 0x06;
+    dev->adv[3] = (uint8_t)(name_len + 1);
+    dev->adv[4] = ESP_BLE_AD_TYPE_NAME_CMPL;
+    memcpy(&dev->adv[5], name, name_len);
+    dev->adv_len = (uint8_t)(5 + name_len);
+    int idx = dev_num++;
+    pthread_mutex_unlock(&ble_lock);
+    return idx;
+}
+
+/**
+ * @brief replace advertising data, e.g. with sensor service data for passive scanning
+ * 
+ * @param dev 
+ * @param adv AD structures
+ * @param len 
+ * @return false if dev or len is invalid
+ */
+bool shim_ble_set_adv(int dev, const uint8_t *adv, int len) {
+    if (dev < 0 || dev >= dev_num || len > SHIM_BLE_ADV_MAX) {
+        return false;
+    }
+    pthread_mutex_lock(&ble_lock);
+    memcpy(dev_tab[dev].adv, adv, len);
+    dev_tab[dev].adv_len = (uint8_t)len;
+    pthread_mutex_unlock(&ble_lock);
+    return true;
+}
+
+/**
+ * @brief move the notify characteristic, e.g. new firmware, applies from the next connection
+ * 
+ * @param dev 
+ * @param handle within SERVICE_START..SERVICE_END
+ * @return false if dev or handle is invalid
+ */
+bool shim_ble_set_handle(int dev, uint16_t handle) {
+    if (dev < 0 || dev >= dev_num || handle <= SERVICE_START || handle > SERVICE_END) {
+        return false;
+    }
+    pthread_mutex_lock(&ble_lock);
+    dev_tab[dev].notify_handle = handle;
+    pthread_mutex_unlock(&ble_lock);
+    return true;
+}
+
+/**
+ * @brief time from CONNECT_EVT to notifications enabled on the current or last link
+ * 
+ * @param dev 
+ * @return ms, -1 if notifications were not enabled
+ */
+int32_t shim_ble_ready_ms(int dev) {
+    int32_t ms = -1;
+    if (dev < 0 || dev >= dev_num) {
+        return -1;
+    }
+    pthread_mutex_lock(&ble_lock);
+    if (dev_tab[dev].ready_us) {
+        ms = (int32_t)((dev_tab[dev].ready_us - dev_tab[dev].connect_us) / 1000);
+    }
+    pthread_mutex_unlock(&ble_lock);
+    return ms;
+}
+
+/**
+ * @brief signal strength of adverts and of the link from now on, e.g. device moved away
+ * 
+ * @param dev 
+ * @param rssi dBm
+ * @return false if dev is invalid
+ */
+bool shim_ble_set_rssi(int dev, int8_t rssi) {
+    if (dev < 0 || dev >= dev_num) {
+        return false;
+    }
+    pthread_mutex_lock(&ble_lock);
+    dev_tab[dev].rssi = rssi;
+    pthread_mutex_unlock(&ble_lock);
+    return true;
+}
+
+/**
+ * @brief connection parameters in force on the link
+ * 
+ * @param dev 
+ * @param interval [out] 1.25 ms units
+ * @param latency [out] connection events the device may skip
+ * @return false if not connected
+ */
+bool shim_ble_conn_params(int dev, uint16_t *interval, uint16_t *latency) {
+    if (dev < 0 || dev >= dev_num) {
+        return false;
+    }
+    pthread_mutex_lock(&ble_lock);
+    bool ok = dev_tab[dev].connected;
+    *interval = dev_tab[dev].conn_int;
+    *latency = dev_tab[dev].latency;
+    pthread_mutex_unlock(&ble_lock);
+    return ok;
+}
+
+/**
+ * @brief scans started with the whitelist filter
+ * 
+ * @return count
+ */
+uint32_t shim_ble_wl_scan_count(void) {
+    pthread_mutex_lock(&ble_lock);
+    uint32_t count = wl_scan_count;
+    pthread_mutex_unlock(&ble_lock);
+    return count;
+}
+
+/**
+ * @brief number of devices with notifications enabled
+ * 
+ * @return count
+ */
+int shim_ble_ready_count(void) {
+    int count = 0;
+    pthread_mutex_lock(&ble_lock);
+    for (int idx = 0; idx < dev_num; idx++) {
+        count += dev_tab[idx].connected && dev_tab[idx].notify_on;
+    }
+    pthread_mutex_unlock(&ble_lock);
+    return count;
+}
+
+/**
+ * @brief wait until count devices have notifications enabled and the events were handled
+ * 
+ * @param count 
+ * @param timeout_ms 
+ * @return false on timeout
+ */
+bool shim_ble_wait_ready(int count, uint32_t timeout_ms) {
+    for (uint32_t waited = 0; waited < timeout_ms; waited += CTRL_PERIOD_MS) {
+        if (shim_ble_ready_count() >= count && shim_ble_idle()) {
+            return true;
+        }
+        shim_sleep_ms(CTRL_PERIOD_MS);
+    }
+    return false;
+}
+
+/**
+ * @brief send notification from device
+ * 
+ * @param dev 
+ * @param value characteristic value
+ * @param len 
+ * @return false if device has notifications disabled
+ */
+bool shim_ble_notify(int dev, const uint8_t *value, int len) {
+    esp_ble_gattc_cb_param_t param;
+    if (dev < 0 || dev >= dev_num || len > SHIM_BLE_VALUE_MAX) {
+        return false;
+    }
+    memset(&param, 0, sizeof(param));
+    pthread_mutex_lock(&ble_lock);
+    ble_dev_t *d = &dev_tab[dev];
+    bool ok = d->connected && d->notify_on;
+    if (ok) {
+        param.notify.conn_id = d->conn_id;
+        memcpy(param.notify.remote_bda, d->bda, ESP_BD_ADDR_LEN);
+        param.notify.handle = d->notify_handle;
+        param.notify.value_len = (uint16_t)len;
+        param.notify.is_notify = true;
+        gattc_post(ESP_GATTC_NOTIFY_EVT, &param, value, len);
+    }
+    pthread_mutex_unlock(&ble_lock);
+    return ok;
+}
+
+/**
+ * @brief link loss, e.g. device out of range
+ * 
+ * @param dev 
+ * @return false if not connected
+ */
+bool shim_ble_disconnect(int dev) {
+    if (dev < 0 || dev >= dev_num) {
+        return false;
+    }
+    pthread_mutex_lock(&ble_lock);
+    bool ok = dev_tab[dev].connected;
+    if (ok) {
+        link_down(&dev_tab[dev], ESP_GATT_CONN_TIMEOUT);
+    }
+    pthread_mutex_unlock(&ble_lock);
+    return ok;
+}
+
+/**
+ * @brief btc task has handled all events
+ * 
+ * @return true if idle
+ */
+bool shim_ble_idle(void) {
+    return shim_worker_idle(&btc);
+}
+
+/**
+ * @brief parse hex string
+ * 
+ * @param str 
+ * @param buf 
+ * @param size 
+ * @return bytes parsed, -1 on error
+ */
+static int hex_parse(const char *str, uint8_t *buf, int size) {
+    int len = 0;
+    unsigned int byte;
+    while (sscanf(str, "%2x", &byte) == 1) {
+        if (len >= size) {
+            return -1;
+        }
+        buf[len++] = (uint8_t)byte;
+        str += 2;
+        if (*str == '\0' || *str == '\n' || *str == '\r' || *str == ' ') {
+            break;
+        }
+    }
+    return len;
+}
+
+/**
+ * @brief load recorded notify trace: one "<t_ms> <dev> <hex value>" per line, '#' starts a comment
+ * 
+ * @param path 
+ * @param recs 
+ * @param max 
+ * @return number of records, -1 if file cannot be read or is malformed
+ */
+int shim_trace_load(const char *path, shim_trace_rec_t *recs, int max) {
+    char line[128];
+    char hex[2 * SHIM_BLE_VALUE_MAX + 1];
+    int count = 0;
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return -1;
+    }
+    while (count < max && fgets(line, sizeof(line), f)) {
+        unsigned int t_ms, dev;
+        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') {
+            continue;
+        }
+        if (sscanf(line, "%u %u %64s", &t_ms, &dev, hex) != 3) {
+            count = -1;
+            break;
+        }
+        int len = hex_parse(hex, recs[count].value, SHIM_BLE_VALUE_MAX);
+        if (len <= 0) {
+            count = -1;
+            break;
+        }
+        recs[count].t_ms = t_ms;
+        recs[count].dev = (uint8_t)dev;
+        recs[count].len = (uint8_t)len;
+        count++;
+    }
+    fclose(f);
+    return count;
+}
+
+/**
+ * @brief send recorded notifications
+ * 
+ * @param recs 
+ * @param count 
+ * @param realtime keep recorded spacing, else send back to back
+ * @param sent_us [out] send time of each record (esp_timer clock), or NULL
+ * @return number of notifications sent
+ */
+int shim_ble_replay(const shim_trace_rec_t *recs, int count, bool realtime, int64_t *sent_us) {
+    int sent = 0;
+    int64_t start = esp_timer_get_time();
+    for (int idx = 0; idx < count; idx++) {
+        if (realtime) {
+            int64_t wait_us = start + (int64_t)recs[idx].t_ms * 1000 - esp_timer_get_time();
+            if (wait_us > 0) {
+                shim_sleep_ms((uint32_t)((wait_us + 999) / 1000));
+            }
+        }
+        if (sent_us) {
+            sent_us[idx] = esp_timer_get_time();
+        }
+        sent += shim_ble_notify(recs[idx].dev, recs[idx].value, recs[idx].len);
+    }
+    return sent;
+}
@@ -0,0 +1,35 @@
+#include "lvgl_helpers.h"
+
+#include "shim.h"
+
+/* STATIC VARIABLES */
+static volatile uint32_t flush_count = 0;
+static volatile uint64_t px_count = 0;
+
+void lvgl_driver_init(void) {
+}
+
+void disp_driver_flush(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map) {
+    (void)color_map;
+    flush_count++;
+    px_count += (uint64_t)lv_area_get_width(area) * lv_area_get_height(area);
+    lv_disp_flush_ready(drv);
+}
+
+/**
+ * @brief number of flushes to the display
+ * 
+ * @return count
+ */
+uint32_t shim_disp_flush_count(void) {
+    return flush_count;
+}
+
+/**
+ * @brief pixels sent to the display
+ * 
+ * @return count
+ */
+uint64_t shim_disp_px_count(void) {
+    return px_count;
+}
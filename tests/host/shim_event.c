@@ -0,0 +1,396 @@
+#include <string.h>
+
+#include "esp_event.h"
+#include "esp_wifi.h"
+#include "esp_log.h"
+#include "nvs_flash.h"
+#include "nvs.h"
+
+#include "shim.h"
+
+/* DEFINES */
+#define HANDLER_MAX         8
+#define WORKER_STACK        4096
+#define STA_IP_ADDR         0x6401a8c0      /* 192.168.1.100 */
+#define NVS_ENTRY_MAX       8
+#define NVS_NAME_LEN        16      /* namespace and key length limit incl. '\0' */
+#define NVS_BLOB_MAX        1024
+
+/* TYPE DEFINITIONS */
+struct shim_job_t {
+    shim_job_t *next;
+    shim_job_fcn_t fcn;
+    uint8_t data[];
+};
+
+typedef struct handler_t {
+    esp_event_base_t base;
+    int32_t id;
+    esp_event_handler_t fcn;
+    void *arg;
+} handler_t;
+
+/* event posted to default loop, data follows */
+typedef struct event_job_t {
+    esp_event_base_t base;
+    int32_t id;
+    size_t size;
+    uint8_t data[];
+} event_job_t;
+
+/* one blob, namespace index is the handle */
+typedef struct nvs_entry_t {
+    uint32_t ns;
+    char key[NVS_NAME_LEN];
+    size_t len;
+    uint8_t data[NVS_BLOB_MAX];
+} nvs_entry_t;
+
+/* PUBLIC VARIABLES */
+ESP_EVENT_DEFINE_BASE(WIFI_EVENT);
+ESP_EVENT_DEFINE_BASE(IP_EVENT);
+
+/* STATIC VARIABLES */
+static shim_worker_t sys_evt;
+static handler_t handler_tab[HANDLER_MAX];
+static int handler_num = 0;
+static pthread_mutex_t wifi_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool wifi_ap_up = true;
+static bool wifi_started = false;
+static bool wifi_connected = false;
+static pthread_mutex_t nvs_lock = PTHREAD_MUTEX_INITIALIZER;
+static char nvs_ns_tab[NVS_ENTRY_MAX][NVS_NAME_LEN];
+static nvs_entry_t nvs_tab[NVS_ENTRY_MAX];
+static uint32_t nvs_write_count = 0;
+
+/* STATIC PROTOTYPES */
+static void worker_task_fcn(void *param);
+static void event_job_fcn(void *data);
+
+/**
+ * @brief run posted jobs in order
+ * 
+ * @param param worker
+ */
+static void worker_task_fcn(void *param) {
+    shim_worker_t *worker = param;
+    for (;;) {
+        pthread_mutex_lock(&worker->lock);
+        while (worker->head == NULL) {
+            pthread_cond_wait(&worker->cond, &worker->lock);
+        }
+        shim_job_t *job = worker->head;
+        worker->head = job->next;
+        if (worker->head == NULL) {
+            worker->tail = NULL;
+        }
+        pthread_mutex_unlock(&worker->lock);
+
+        job->fcn(job->data);
+        free(job);
+
+        pthread_mutex_lock(&worker->lock);
+        worker->done++;
+        pthread_mutex_unlock(&worker->lock);
+    }
+}
+
+/**
+ * @brief start worker task, no-op if already running
+ * 
+ * @param worker 
+ * @param name task name
+ */
+void shim_worker_start(shim_worker_t *worker, const char *name) {
+    if (worker->started) {
+        return;
+    }
+    worker->name = name;
+    pthread_mutex_init(&worker->lock, NULL);
+    pthread_cond_init(&worker->cond, NULL);
+    worker->started = true;
+    xTaskCreatePinnedToCore(worker_task_fcn, name, WORKER_STACK, worker, 19, NULL, 0);
+}
+
+/**
+ * @brief queue a job, data is copied
+ * 
+ * @param worker 
+ * @param fcn 
+ * @param data 
+ * @param size 
+ */
+void shim_worker_post(shim_worker_t *worker, shim_job_fcn_t fcn, const void *data, size_t size) {
+    shim_job_t *job = malloc(sizeof(shim_job_t) + size);
+    assert(job != NULL);
+    job->next = NULL;
+    job->fcn = fcn;
+    memcpy(job->data, data, size);
+
+    pthread_mutex_lock(&worker->lock);
+    if (worker->tail) {
+        worker->tail->next = job;
+    } else {
+        worker->head = job;
+    }
+    worker->tail = job;
+    worker->posted++;
+    pthread_cond_signal(&worker->cond);
+    pthread_mutex_unlock(&worker->lock);
+}
+
+/**
+ * @brief all posted jobs have run
+ * 
+ * @param worker 
+ * @return true if idle
+ */
+bool shim_worker_idle(shim_worker_t *worker) {
+    if (!worker->started) {
+        return true;
+    }
+    pthread_mutex_lock(&worker->lock);
+    bool idle = (worker->posted == worker->done);
+    pthread_mutex_unlock(&worker->lock);
+    return idle;
+}
+
+/**
+ * @brief dispatch event to matching handlers
+ * 
+ * @param data event_job_t
+ */
+static void event_job_fcn(void *data) {
+    event_job_t *evt = data;
+    for (int idx = 0; idx < handler_num; idx++) {
+        handler_t *h = &handler_tab[idx];
+        if (strcmp(h->base, evt->base) == 0 && (h->id == ESP_EVENT_ANY_ID || h->id == evt->id)) {
+            h->fcn(h->arg, evt->base, evt->id, evt->size ? evt->data : NULL);
+        }
+    }
+}
+
+esp_err_t esp_event_loop_create_default(void) {
+    shim_worker_start(&sys_evt, "sys_evt");
+    return ESP_OK;
+}
+
+esp_err_t esp_event_handler_register(esp_event_base_t event_base, int32_t event_id,
+                                     esp_event_handler_t event_handler, void *event_handler_arg) {
+    return esp_event_handler_instance_register(event_base, event_id, event_handler, event_handler_arg, NULL);
+}
+
+esp_err_t esp_event_handler_instance_register(esp_event_base_t event_base, int32_t event_id,
+                                              esp_event_handler_t event_handler, void *event_handler_arg,
+                                              esp_event_handler_instance_t *instance) {
+    if (handler_num >= HANDLER_MAX) {
+        return ESP_ERR_NO_MEM;
+    }
+    handler_tab[handler_num] = (handler_t){event_base, event_id, event_handler, event_handler_arg};
+    if (instance) {
+        *instance = &handler_tab[handler_num];
+    }
+    handler_num++;
+    return ESP_OK;
+}
+
+esp_err_t esp_event_post(esp_event_base_t event_base, int32_t event_id, const void *event_data,
+                         size_t event_data_size, uint32_t ticks_to_wait) {
+    (void)ticks_to_wait;
+    uint8_t buf[sizeof(event_job_t) + 64];
+    event_job_t *evt = (event_job_t *)buf;
+    if (event_data_size > sizeof(buf) - sizeof(event_job_t)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    evt->base = event_base;
+    evt->id = event_id;
+    evt->size = event_data_size;
+    if (event_data_size) {
+        memcpy(evt->data, event_data, event_data_size);
+    }
+    shim_worker_post(&sys_evt, event_job_fcn, evt, sizeof(event_job_t) + event_data_size);
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_init(void) {
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void) {
+    pthread_mutex_lock(&nvs_lock);
+    memset(nvs_ns_tab, 0, sizeof(nvs_ns_tab));
+    memset(nvs_tab, 0, sizeof(nvs_tab));
+    pthread_mutex_unlock(&nvs_lock);
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle) {
+    (void)open_mode;
+    if (strlen(name) >= NVS_NAME_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&nvs_lock);
+    int idx = 0;
+    while (idx < NVS_ENTRY_MAX && nvs_ns_tab[idx][0] != '\0' && strcmp(nvs_ns_tab[idx], name) != 0) {
+        idx++;
+    }
+    if (idx < NVS_ENTRY_MAX && nvs_ns_tab[idx][0] == '\0') {
+        strcpy(nvs_ns_tab[idx], name);
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    if (idx == NVS_ENTRY_MAX) {
+        return ESP_ERR_NO_MEM;
+    }
+    /* 0 is never a valid handle */
+    *out_handle = (nvs_handle_t)(idx + 1);
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length) {
+    esp_err_t err = ESP_ERR_NVS_NOT_FOUND;
+    pthread_mutex_lock(&nvs_lock);
+    for (int idx = 0; idx < NVS_ENTRY_MAX; idx++) {
+        nvs_entry_t *entry = &nvs_tab[idx];
+        if (entry->ns == handle && strcmp(entry->key, key) == 0) {
+            if (out_value && *length < entry->len) {
+                err = ESP_ERR_INVALID_SIZE;
+            } else {
+                if (out_value) {
+                    memcpy(out_value, entry->data, entry->len);
+                }
+                err = ESP_OK;
+            }
+            *length = entry->len;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return err;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length) {
+    if (strlen(key) >= NVS_NAME_LEN || length > NVS_BLOB_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&nvs_lock);
+    nvs_entry_t *found = NULL;
+    for (int idx = 0; idx < NVS_ENTRY_MAX; idx++) {
+        nvs_entry_t *entry = &nvs_tab[idx];
+        if (entry->ns == handle && strcmp(entry->key, key) == 0) {
+            found = entry;
+            break;
+        }
+        if (entry->ns == 0 && found == NULL) {
+            found = entry;
+        }
+    }
+    if (found) {
+        found->ns = handle;
+        strcpy(found->key, key);
+        found->len = length;
+        memcpy(found->data, value, length);
+        nvs_write_count++;
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return found ? ESP_OK : ESP_ERR_NVS_NO_FREE_PAGES;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    (void)handle;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) {
+    (void)handle;
+}
+
+/**
+ * @brief number of nvs_set_blob calls, flash wear
+ * 
+ * @return count
+ */
+uint32_t shim_nvs_write_count(void) {
+    pthread_mutex_lock(&nvs_lock);
+    uint32_t count = nvs_write_count;
+    pthread_mutex_unlock(&nvs_lock);
+    return count;
+}
+
+esp_err_t esp_netif_init(void) {
+    return ESP_OK;
+}
+
+void *esp_netif_create_default_wifi_sta(void) {
+    return &wifi_started;
+}
+
+esp_err_t esp_wifi_init(const wifi_init_config_t *config) {
+    (void)config;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode) {
+    (void)mode;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t *conf) {
+    (void)interface;
+    (void)conf;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_start(void) {
+    pthread_mutex_lock(&wifi_lock);
+    wifi_started = true;
+    pthread_mutex_unlock(&wifi_lock);
+    return esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_START, NULL, 0, 0);
+}
+
+esp_err_t esp_wifi_connect(void) {
+    pthread_mutex_lock(&wifi_lock);
+    bool up = wifi_ap_up;
+    wifi_connected = up;
+    pthread_mutex_unlock(&wifi_lock);
+    if (!up) {
+        return esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, NULL, 0, 0);
+    }
+    ip_event_got_ip_t got_ip = {0};
+    got_ip.ip_info.ip.addr = STA_IP_ADDR;
+    esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_CONNECTED, NULL, 0, 0);
+    return esp_event_post(IP_EVENT, IP_EVENT_STA_GOT_IP, &got_ip, sizeof(got_ip), 0);
+}
+
+esp_err_t esp_wifi_disconnect(void) {
+    pthread_mutex_lock(&wifi_lock);
+    wifi_connected = false;
+    pthread_mutex_unlock(&wifi_lock);
+    return esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, NULL, 0, 0);
+}
+
+/**
+ * @brief access point reachability, losing it disconnects the station
+ * 
+ * @param up 
+ */
+void shim_wifi_set_ap(bool up) {
+    pthread_mutex_lock(&wifi_lock);
+    wifi_ap_up = up;
+    bool drop = !up && wifi_connected;
+    bool retry = up && wifi_started && !wifi_connected;
+    pthread_mutex_unlock(&wifi_lock);
+    if (drop) {
+        esp_wifi_disconnect();
+    } else if (retry) {
+        esp_wifi_connect();
+    }
+}
+
+/**
+ * @brief default event loop has no pending events
+ * 
+ * @return true if idle
+ */
+bool shim_wifi_idle(void) {
+    return shim_worker_idle(&sys_evt);
+}
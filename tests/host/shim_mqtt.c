@@ -0,0 +1,304 @@
+#include <string.h>
+
+#include "mqtt_client.h"
+#include "esp_log.h"
+
+#include "shim.h"
+
+/* DEFINES */
+#define MQTT_EVENT_BASE     "MQTT_EVENTS"
+#define SUB_MAX             4       /* topics subscribed */
+#define TOPIC_MAX           64
+#define DATA_MAX            512     /* message to subscriber, one event */
+
+/* TYPE DEFINITIONS */
+struct shim_mqtt_client {
+    esp_mqtt_client_config_t cfg;
+    esp_event_handler_t handler;
+    void *handler_arg;
+    bool started;
+    bool connected;
+    int next_msg_id;
+    int sub_count;
+    char sub[SUB_MAX][TOPIC_MAX];
+};
+
+typedef struct event_job_t {
+    esp_mqtt_event_id_t event_id;
+    int msg_id;
+    int topic_len;              /* MQTT_EVENT_DATA only */
+    int data_len;
+    char topic[TOPIC_MAX];
+    char data[DATA_MAX];
+} event_job_t;
+
+/* STATIC VARIABLES */
+static pthread_mutex_t mqtt_lock = PTHREAD_MUTEX_INITIALIZER;
+static shim_worker_t mqtt_task;
+static struct shim_mqtt_client client;
+static bool broker_up = true;
+static shim_mqtt_hook_t publish_hook = NULL;
+static void *publish_hook_ctx = NULL;
+static shim_mqtt_stats_t stats;
+static int publish_loss;    /* per mille */
+static int ack_loss;
+static uint32_t loss_seed = 1;
+
+/* STATIC PROTOTYPES */
+static void event_job_fcn(void *data);
+static void event_post(esp_mqtt_event_id_t event_id, int msg_id);
+static bool loss_roll(int permille);
+
+/**
+ * @brief deliver client event on mqtt task
+ * 
+ * @param data event_job_t
+ */
+static void event_job_fcn(void *data) {
+    event_job_t *job = data;
+    esp_mqtt_event_t event;
+    memset(&event, 0, sizeof(event));
+    event.event_id = job->event_id;
+    event.client = &client;
+    event.msg_id = job->msg_id;
+    if (job->event_id == MQTT_EVENT_DATA) {
+        event.topic = job->topic;
+        event.topic_len = job->topic_len;
+        event.data = job->data;
+        event.data_len = job->data_len;
+        event.total_data_len = job->data_len;
+    }
+    if (client.handler) {
+        client.handler(client.handler_arg, MQTT_EVENT_BASE, job->event_id, &event);
+    }
+}
+
+/**
+ * @brief queue client event
+ * 
+ * @param event_id 
+ * @param msg_id 
+ */
+static void event_post(esp_mqtt_event_id_t event_id, int msg_id) {
+    event_job_t job = {.event_id = event_id, .msg_id = msg_id};
+    shim_worker_post(&mqtt_task, event_job_fcn, &job, sizeof(job));
+}
+
+/**
+ * @brief deterministic loss decision, called with mqtt_lock held
+ * 
+ * @param permille 
+ * @return true if the packet is lost
+ */
+static bool loss_roll(int permille) {
+    if (permille <= 0) {
+        return false;
+    }
+    loss_seed = loss_seed * 1103515245 + 12345;
+    return (int)((loss_seed >> 16) % 1000) < permille;
+}
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t *config) {
+    shim_worker_start(&mqtt_task, "mqtt_task");
+    pthread_mutex_lock(&mqtt_lock);
+    client.cfg = *config;
+    pthread_mutex_unlock(&mqtt_lock);
+    return &client;
+}
+
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t handle, esp_mqtt_event_id_t event,
+                                         esp_event_handler_t event_handler, void *event_handler_arg) {
+    (void)event;
+    pthread_mutex_lock(&mqtt_lock);
+    handle->handler = event_handler;
+    handle->handler_arg = event_handler_arg;
+    pthread_mutex_unlock(&mqtt_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t handle) {
+    pthread_mutex_lock(&mqtt_lock);
+    handle->started = true;
+    if (broker_up && !handle->connected) {
+        handle->connected = true;
+        stats.connect_count++;
+        event_post(MQTT_EVENT_CONNECTED, 0);
+    }
+    pthread_mutex_unlock(&mqtt_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_stop(esp_mqtt_client_handle_t handle) {
+    pthread_mutex_lock(&mqtt_lock);
+    handle->started = false;
+    if (handle->connected) {
+        handle->connected = false;
+        event_post(MQTT_EVENT_DISCONNECTED, 0);
+    }
+    pthread_mutex_unlock(&mqtt_lock);
+    return ESP_OK;
+}
+
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t handle, const char *topic, const char *data, int len,
+                            int qos, int retain) {
+    (void)retain;
+    pthread_mutex_lock(&mqtt_lock);
+    if (!handle->connected) {
+        stats.fail_count++;
+        pthread_mutex_unlock(&mqtt_lock);
+        return -1;
+    }
+    if (len == 0) {
+        len = (int)strlen(data);
+    }
+    int msg_id = (qos > 0) ? ++handle->next_msg_id : 0;
+    stats.msg_count++;
+    stats.byte_count += len;
+    shim_mqtt_hook_t hook = publish_hook;
+    void *ctx = publish_hook_ctx;
+    if (loss_roll(publish_loss)) {
+        /* PUBLISH lost on the way, the client does not know */
+        stats.publish_lost++;
+        pthread_mutex_unlock(&mqtt_lock);
+        return msg_id;
+    }
+    if (qos > 0 && loss_roll(ack_loss)) {
+        stats.ack_lost++;
+    } else if (qos > 0) {
+        /* broker stand-in acknowledges at once */
+        event_post(MQTT_EVENT_PUBLISHED, msg_id);
+    }
+    pthread_mutex_unlock(&mqtt_lock);
+    if (hook) {
+        hook(topic, (const uint8_t *)data, len, ctx);
+    }
+    return msg_id;
+}
+
+int esp_mqtt_client_subscribe(esp_mqtt_client_handle_t handle, const char *topic, int qos) {
+    (void)qos;
+    pthread_mutex_lock(&mqtt_lock);
+    int msg_id = handle->connected ? ++handle->next_msg_id : -1;
+    if (msg_id > 0) {
+        /* subscriptions are kept across reconnects, as with a persistent session */
+        bool known = false;
+        for (int idx = 0; idx < handle->sub_count; idx++) {
+            known |= strcmp(handle->sub[idx], topic) == 0;
+        }
+        if (!known && handle->sub_count < SUB_MAX && strlen(topic) < TOPIC_MAX) {
+            strcpy(handle->sub[handle->sub_count++], topic);
+        }
+        event_post(MQTT_EVENT_SUBSCRIBED, msg_id);
+    }
+    pthread_mutex_unlock(&mqtt_lock);
+    return msg_id;
+}
+
+/**
+ * @brief capture publishes seen by the broker, called in the publisher's thread
+ * 
+ * @param hook 
+ * @param ctx 
+ */
+void shim_mqtt_set_hook(shim_mqtt_hook_t hook, void *ctx) {
+    pthread_mutex_lock(&mqtt_lock);
+    publish_hook = hook;
+    publish_hook_ctx = ctx;
+    pthread_mutex_unlock(&mqtt_lock);
+}
+
+/**
+ * @brief broker reachability, a started client follows it like esp-mqtt auto-reconnect
+ * 
+ * @param up 
+ */
+void shim_mqtt_set_broker(bool up) {
+    pthread_mutex_lock(&mqtt_lock);
+    broker_up = up;
+    if (client.started && up && !client.connected) {
+        client.connected = true;
+        stats.connect_count++;
+        event_post(MQTT_EVENT_CONNECTED, 0);
+    } else if (client.started && !up && client.connected) {
+        client.connected = false;
+        event_post(MQTT_EVENT_DISCONNECTED, 0);
+    }
+    pthread_mutex_unlock(&mqtt_lock);
+}
+
+/**
+ * @brief drop a share of PUBLISH packets before the broker or of PUBACKs after it
+ * 
+ * @param publish_permille 
+ * @param ack_permille QoS 1 only
+ */
+void shim_mqtt_set_loss(int publish_permille, int ack_permille) {
+    pthread_mutex_lock(&mqtt_lock);
+    publish_loss = publish_permille;
+    ack_loss = ack_permille;
+    pthread_mutex_unlock(&mqtt_lock);
+}
+
+/**
+ * @brief another client publishes to a topic the app subscribed to, delivered as one MQTT_EVENT_DATA
+ * 
+ * @param suffix end of the subscribed topic, e.g. "/config"
+ * @param data 
+ * @param len 
+ * @return false if not connected or not subscribed
+ */
+bool shim_mqtt_receive(const char *suffix, const char *data, int len) {
+    event_job_t job = {.event_id = MQTT_EVENT_DATA};
+    bool ok = false;
+    if (len > DATA_MAX) {
+        return false;
+    }
+    pthread_mutex_lock(&mqtt_lock);
+    for (int idx = 0; idx < client.sub_count && client.connected && !ok; idx++) {
+        int topic_len = (int)strlen(client.sub[idx]);
+        int suffix_len = (int)strlen(suffix);
+        if (topic_len >= suffix_len && strcmp(&client.sub[idx][topic_len - suffix_len], suffix) == 0) {
+            memcpy(job.topic, client.sub[idx], topic_len);
+            job.topic_len = topic_len;
+            memcpy(job.data, data, len);
+            job.data_len = len;
+            shim_worker_post(&mqtt_task, event_job_fcn, &job, sizeof(job));
+            ok = true;
+        }
+    }
+    pthread_mutex_unlock(&mqtt_lock);
+    return ok;
+}
+
+/**
+ * @brief client is connected to broker
+ * 
+ * @return true if connected
+ */
+bool shim_mqtt_connected(void) {
+    pthread_mutex_lock(&mqtt_lock);
+    bool connected = client.connected;
+    pthread_mutex_unlock(&mqtt_lock);
+    return connected;
+}
+
+/**
+ * @brief mqtt task has delivered all events
+ * 
+ * @return true if idle
+ */
+bool shim_mqtt_idle(void) {
+    return shim_worker_idle(&mqtt_task);
+}
+
+/**
+ * @brief publish counters
+ * 
+ * @return copy of counters
+ */
+shim_mqtt_stats_t shim_mqtt_stats(void) {
+    pthread_mutex_lock(&mqtt_lock);
+    shim_mqtt_stats_t copy = stats;
+    pthread_mutex_unlock(&mqtt_lock);
+    return copy;
+}
@@ -0,0 +1,764 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "freertos/queue.h"
+#include "esp_system.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+#include "shim.h"
+
+/* TYPE DEFINITIONS */
+struct shim_task {
+    struct shim_task *next;     /* task_list */
+    pthread_t thread;
+    char name[16];
+    TaskFunction_t fcn;
+    void *param;
+    UBaseType_t number;
+    UBaseType_t priority;
+    uint32_t stack_depth;
+    BaseType_t core_id;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify_value;
+    bool notify_pending;
+};
+
+struct shim_sem {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t count;
+    uint32_t max;
+};
+
+struct shim_evt_group {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    EventBits_t bits;
+};
+
+struct shim_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t length;
+    uint32_t item_size;
+    uint32_t head;
+    uint32_t count;
+    uint8_t *buf;
+};
+
+struct shim_timer {
+    esp_timer_create_args_t args;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint64_t period_us;
+    bool periodic;
+    bool running;
+    uint32_t gen;           /* bumped on start/stop, stale threads exit */
+};
+
+/* allocation header, keeps the 16 byte alignment of malloc */
+typedef union heap_hdr_t {
+    size_t size;
+    max_align_t align;
+} heap_hdr_t;
+
+/* STATIC VARIABLES */
+static __thread struct shim_task *current_task = NULL;
+static pthread_mutex_t task_list_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct shim_task *task_list = NULL;
+static UBaseType_t task_count = 0;
+static UBaseType_t task_number = 0;
+static pthread_mutex_t heap_lock = PTHREAD_MUTEX_INITIALIZER;
+static size_t heap_used = 0;
+static size_t heap_used_max = 0;
+static int log_level = -1;
+static int64_t boot_us = 0;
+
+/* STATIC PROTOTYPES */
+static void cond_init(pthread_cond_t *cond);
+static int64_t mono_us(void);
+static void deadline_ts(struct timespec *ts, int64_t abs_us);
+static int64_t ticks_deadline(TickType_t ticks);
+static int cond_wait_until(pthread_cond_t *cond, pthread_mutex_t *lock, int64_t abs_us);
+static struct shim_task *task_alloc(const char *name);
+static void task_list_add(struct shim_task *task);
+static void task_list_remove(struct shim_task *task);
+static uint32_t task_cpu_us(struct shim_task *task);
+static void *task_entry(void *arg);
+static void *timer_entry(void *arg);
+static void timer_start(struct shim_timer *timer, uint64_t period_us, bool periodic);
+static void app_task_fcn(void *param);
+static SemaphoreHandle_t sem_create(uint32_t max, uint32_t initial);
+
+/**
+ * @brief condition variable on the monotonic clock
+ * 
+ * @param cond 
+ */
+static void cond_init(pthread_cond_t *cond) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+/**
+ * @brief monotonic time
+ * 
+ * @return microseconds
+ */
+static int64_t mono_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief absolute monotonic time as timespec
+ * 
+ * @param ts [out]
+ * @param abs_us 
+ */
+static void deadline_ts(struct timespec *ts, int64_t abs_us) {
+    ts->tv_sec = abs_us / 1000000;
+    ts->tv_nsec = (abs_us % 1000000) * 1000;
+}
+
+/**
+ * @brief deadline of a blocking call
+ * 
+ * @param ticks 
+ * @return absolute monotonic time in us, INT64_MAX for portMAX_DELAY
+ */
+static int64_t ticks_deadline(TickType_t ticks) {
+    if (ticks == portMAX_DELAY) {
+        return INT64_MAX;
+    }
+    return mono_us() + (int64_t)ticks * portTICK_PERIOD_MS * 1000;
+}
+
+/**
+ * @brief wait on condition with optional deadline
+ * 
+ * @param cond 
+ * @param lock held by caller
+ * @param abs_us INT64_MAX to wait forever
+ * @return 0 or ETIMEDOUT
+ */
+static int cond_wait_until(pthread_cond_t *cond, pthread_mutex_t *lock, int64_t abs_us) {
+    if (abs_us == INT64_MAX) {
+        return pthread_cond_wait(cond, lock);
+    }
+    struct timespec ts;
+    deadline_ts(&ts, abs_us);
+    return pthread_cond_timedwait(cond, lock, &ts);
+}
+
+/**
+ * @brief allocate task control block
+ * 
+ * @param name 
+ * @return task
+ */
+static struct shim_task *task_alloc(const char *name) {
+    struct shim_task *task = calloc(1, sizeof(struct shim_task));
+    assert(task != NULL);
+    snprintf(task->name, sizeof(task->name), "%s", name);
+    pthread_mutex_init(&task->lock, NULL);
+    cond_init(&task->cond);
+    return task;
+}
+
+/**
+ * @brief make task visible to uxTaskGetSystemState
+ * 
+ * @param task task_list_lock held
+ */
+static void task_list_add(struct shim_task *task) {
+    task->number = ++task_number;
+    task->next = task_list;
+    task_list = task;
+    task_count++;
+}
+
+/**
+ * @brief task deleted or returned, its thread must not be queried any more
+ * 
+ * @param task 
+ */
+static void task_list_remove(struct shim_task *task) {
+    pthread_mutex_lock(&task_list_lock);
+    for (struct shim_task **link = &task_list; *link; link = &(*link)->next) {
+        if (*link == task) {
+            *link = task->next;
+            task_count--;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&task_list_lock);
+}
+
+/**
+ * @brief CPU time consumed by the thread of a listed task
+ * 
+ * @param task task_list_lock held
+ * @return microseconds, wraps like the FreeRTOS run-time counter
+ */
+static uint32_t task_cpu_us(struct shim_task *task) {
+    clockid_t clock;
+    struct timespec ts;
+    if (pthread_getcpuclockid(task->thread, &clock) != 0 || clock_gettime(clock, &ts) != 0) {
+        return 0;
+    }
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000);
+}
+
+/**
+ * @brief pthread entry of a task
+ * 
+ * @param arg task
+ * @return NULL
+ */
+static void *task_entry(void *arg) {
+    current_task = arg;
+    current_task->fcn(current_task->param);
+    task_list_remove(current_task);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fcn, const char *name, uint32_t stack_depth, void *param,
+                                   UBaseType_t priority, TaskHandle_t *created_task, BaseType_t core_id) {
+    struct shim_task *task = task_alloc(name);
+    task->fcn = fcn;
+    task->param = param;
+    task->priority = priority;
+    task->stack_depth = stack_depth;
+    task->core_id = core_id;
+    if (created_task) {
+        *created_task = task;
+    }
+    /* listed under the lock, the new thread cannot unlist itself before that */
+    pthread_mutex_lock(&task_list_lock);
+    if (pthread_create(&task->thread, NULL, task_entry, task) != 0) {
+        pthread_mutex_unlock(&task_list_lock);
+        return pdFAIL;
+    }
+    pthread_detach(task->thread);
+    task_list_add(task);
+    pthread_mutex_unlock(&task_list_lock);
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task == NULL || task == current_task) {
+        task_list_remove(current_task);
+        pthread_exit(NULL);
+    }
+    task_list_remove(task);
+    pthread_cancel(task->thread);
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void) {
+    pthread_mutex_lock(&task_list_lock);
+    UBaseType_t count = task_count;
+    pthread_mutex_unlock(&task_list_lock);
+    return count;
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *status_array, UBaseType_t array_size, uint32_t *total_runtime) {
+    UBaseType_t count = 0;
+    pthread_mutex_lock(&task_list_lock);
+    if (array_size >= task_count) {
+        for (struct shim_task *task = task_list; task; task = task->next) {
+            status_array[count++] = (TaskStatus_t){
+                .xHandle = task,
+                .pcTaskName = task->name,
+                .xTaskNumber = task->number,
+                .eCurrentState = (task == current_task) ? eRunning : eBlocked,
+                .uxCurrentPriority = task->priority,
+                .uxBasePriority = task->priority,
+                .ulRunTimeCounter = task_cpu_us(task),
+                .usStackHighWaterMark = task->stack_depth,
+                .xCoreID = task->core_id,
+            };
+        }
+        if (total_runtime) {
+            *total_runtime = (uint32_t)esp_timer_get_time();
+        }
+    }
+    pthread_mutex_unlock(&task_list_lock);
+    return count;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    return (task ? task : xTaskGetCurrentTaskHandle())->stack_depth;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    shim_sleep_ms(ticks * portTICK_PERIOD_MS);
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(esp_timer_get_time() / 1000 / portTICK_PERIOD_MS);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    if (current_task == NULL) {
+        /* thread not created by xTaskCreate, e.g. the test driver */
+        current_task = task_alloc("host");
+        current_task->thread = pthread_self();
+        current_task->core_id = tskNO_AFFINITY;
+    }
+    return current_task;
+}
+
+char *pcTaskGetTaskName(TaskHandle_t task) {
+    return (task ? task : xTaskGetCurrentTaskHandle())->name;
+}
+
+BaseType_t xPortGetCoreID(void) {
+    BaseType_t core_id = xTaskGetCurrentTaskHandle()->core_id;
+    return (core_id == tskNO_AFFINITY) ? 0 : core_id;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action) {
+    BaseType_t ret = pdPASS;
+    pthread_mutex_lock(&task->lock);
+    switch (action) {
+    case eSetBits:
+        task->notify_value |= value;
+        break;
+    case eIncrement:
+        task->notify_value++;
+        break;
+    case eSetValueWithOverwrite:
+        task->notify_value = value;
+        break;
+    case eSetValueWithoutOverwrite:
+        if (task->notify_pending) {
+            ret = pdFAIL;
+        } else {
+            task->notify_value = value;
+        }
+        break;
+    default:
+        break;
+    }
+    task->notify_pending = true;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+    return ret;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t *value, TickType_t ticks) {
+    struct shim_task *task = xTaskGetCurrentTaskHandle();
+    int64_t deadline = ticks_deadline(ticks);
+    BaseType_t ret = pdFALSE;
+
+    pthread_mutex_lock(&task->lock);
+    if (!task->notify_pending) {
+        task->notify_value &= ~clear_on_entry;
+    }
+    while (!task->notify_pending && ticks > 0) {
+        if (cond_wait_until(&task->cond, &task->lock, deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    if (value) {
+        *value = task->notify_value;
+    }
+    if (task->notify_pending) {
+        task->notify_value &= ~clear_on_exit;
+        task->notify_pending = false;
+        ret = pdTRUE;
+    }
+    pthread_mutex_unlock(&task->lock);
+    return ret;
+}
+
+/**
+ * @brief counting semaphore
+ * 
+ * @param max 
+ * @param initial 
+ * @return semaphore
+ */
+static SemaphoreHandle_t sem_create(uint32_t max, uint32_t initial) {
+    struct shim_sem *sem = calloc(1, sizeof(struct shim_sem));
+    assert(sem != NULL);
+    pthread_mutex_init(&sem->lock, NULL);
+    cond_init(&sem->cond);
+    sem->max = max;
+    sem->count = initial;
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    return sem_create(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return sem_create(1, 0);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+    int64_t deadline = ticks_deadline(ticks);
+    BaseType_t ret = pdFALSE;
+    pthread_mutex_lock(&sem->lock);
+    while (sem->count == 0 && ticks > 0) {
+        if (cond_wait_until(&sem->cond, &sem->lock, deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    if (sem->count > 0) {
+        sem->count--;
+        ret = pdTRUE;
+    }
+    pthread_mutex_unlock(&sem->lock);
+    return ret;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    BaseType_t ret = pdFALSE;
+    pthread_mutex_lock(&sem->lock);
+    if (sem->count < sem->max) {
+        sem->count++;
+        pthread_cond_signal(&sem->cond);
+        ret = pdTRUE;
+    }
+    pthread_mutex_unlock(&sem->lock);
+    return ret;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) {
+    free(sem);
+}
+
+EventGroupHandle_t xEventGroupCreate(void) {
+    struct shim_evt_group *group = calloc(1, sizeof(struct shim_evt_group));
+    assert(group != NULL);
+    pthread_mutex_init(&group->lock, NULL);
+    cond_init(&group->cond);
+    return group;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+    pthread_mutex_lock(&group->lock);
+    group->bits |= bits;
+    EventBits_t ret = group->bits;
+    pthread_cond_broadcast(&group->cond);
+    pthread_mutex_unlock(&group->lock);
+    return ret;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+    pthread_mutex_lock(&group->lock);
+    EventBits_t ret = group->bits;
+    group->bits &= ~bits;
+    pthread_mutex_unlock(&group->lock);
+    return ret;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear_on_exit,
+                                BaseType_t wait_all, TickType_t ticks) {
+    int64_t deadline = ticks_deadline(ticks);
+    pthread_mutex_lock(&group->lock);
+    for (;;) {
+        EventBits_t match = group->bits & bits;
+        if ((wait_all && match == bits) || (!wait_all && match) || ticks == 0) {
+            break;
+        }
+        if (cond_wait_until(&group->cond, &group->lock, deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    EventBits_t ret = group->bits;
+    if (clear_on_exit && ((wait_all && (ret & bits) == bits) || (!wait_all && (ret & bits)))) {
+        group->bits &= ~bits;
+    }
+    pthread_mutex_unlock(&group->lock);
+    return ret;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    struct shim_queue *queue = calloc(1, sizeof(struct shim_queue));
+    assert(queue != NULL);
+    queue->buf = calloc(length, item_size);
+    assert(queue->buf != NULL);
+    queue->length = length;
+    queue->item_size = item_size;
+    pthread_mutex_init(&queue->lock, NULL);
+    cond_init(&queue->cond);
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks) {
+    int64_t deadline = ticks_deadline(ticks);
+    BaseType_t ret = pdFALSE;
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->length && ticks > 0) {
+        if (cond_wait_until(&queue->cond, &queue->lock, deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    if (queue->count < queue->length) {
+        uint32_t tail = (queue->head + queue->count) % queue->length;
+        memcpy(&queue->buf[tail * queue->item_size], item, queue->item_size);
+        queue->count++;
+        pthread_cond_broadcast(&queue->cond);
+        ret = pdTRUE;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return ret;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks) {
+    int64_t deadline = ticks_deadline(ticks);
+    BaseType_t ret = pdFALSE;
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0 && ticks > 0) {
+        if (cond_wait_until(&queue->cond, &queue->lock, deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    if (queue->count > 0) {
+        memcpy(item, &queue->buf[queue->head * queue->item_size], queue->item_size);
+        queue->head = (queue->head + 1) % queue->length;
+        queue->count--;
+        pthread_cond_broadcast(&queue->cond);
+        ret = pdTRUE;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return ret;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&queue->lock);
+    return count;
+}
+
+int64_t esp_timer_get_time(void) {
+    if (boot_us == 0) {
+        boot_us = mono_us();
+    }
+    return mono_us() - boot_us;
+}
+
+/**
+ * @brief thread of one started timer, exits when stopped or restarted
+ * 
+ * @param arg timer
+ * @return NULL
+ */
+static void *timer_entry(void *arg) {
+    struct shim_timer *timer = arg;
+    pthread_mutex_lock(&timer->lock);
+    uint32_t gen = timer->gen;
+    int64_t next = mono_us() + (int64_t)timer->period_us;
+    while (timer->running && timer->gen == gen) {
+        if (cond_wait_until(&timer->cond, &timer->lock, next) != ETIMEDOUT) {
+            continue;
+        }
+        if (!timer->running || timer->gen != gen) {
+            break;
+        }
+        if (!timer->periodic) {
+            timer->running = false;
+        }
+        pthread_mutex_unlock(&timer->lock);
+        timer->args.callback(timer->args.arg);
+        pthread_mutex_lock(&timer->lock);
+        next += (int64_t)timer->period_us;
+    }
+    pthread_mutex_unlock(&timer->lock);
+    return NULL;
+}
+
+/**
+ * @brief arm timer on a new thread
+ * 
+ * @param timer 
+ * @param period_us 
+ * @param periodic 
+ */
+static void timer_start(struct shim_timer *timer, uint64_t period_us, bool periodic) {
+    pthread_t thread;
+    pthread_mutex_lock(&timer->lock);
+    timer->period_us = period_us;
+    timer->periodic = periodic;
+    timer->running = true;
+    timer->gen++;
+    pthread_mutex_unlock(&timer->lock);
+    pthread_create(&thread, NULL, timer_entry, timer);
+    pthread_detach(thread);
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle) {
+    struct shim_timer *timer = calloc(1, sizeof(struct shim_timer));
+    if (timer == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    timer->args = *create_args;
+    pthread_mutex_init(&timer->lock, NULL);
+    cond_init(&timer->cond);
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period) {
+    if (timer->running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer_start(timer, period, true);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+    if (timer->running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer_start(timer, timeout_us, false);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    pthread_mutex_lock(&timer->lock);
+    bool was_running = timer->running;
+    timer->running = false;
+    timer->gen++;
+    pthread_cond_broadcast(&timer->cond);
+    pthread_mutex_unlock(&timer->lock);
+    return was_running ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+void *heap_caps_malloc(size_t size, uint32_t caps) {
+    (void)caps;
+    pthread_mutex_lock(&heap_lock);
+    if (size > SHIM_HEAP_SIZE - heap_used) {
+        pthread_mutex_unlock(&heap_lock);
+        return NULL;
+    }
+    heap_used += size;
+    heap_used_max = (heap_used > heap_used_max) ? heap_used : heap_used_max;
+    pthread_mutex_unlock(&heap_lock);
+    heap_hdr_t *hdr = malloc(sizeof(heap_hdr_t) + size);
+    assert(hdr != NULL);
+    hdr->size = size;
+    return hdr + 1;
+}
+
+void heap_caps_free(void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    heap_hdr_t *hdr = (heap_hdr_t *)ptr - 1;
+    pthread_mutex_lock(&heap_lock);
+    heap_used -= hdr->size;
+    pthread_mutex_unlock(&heap_lock);
+    free(hdr);
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) {
+    (void)caps;
+    pthread_mutex_lock(&heap_lock);
+    size_t free_size = SHIM_HEAP_SIZE - heap_used;
+    pthread_mutex_unlock(&heap_lock);
+    return free_size;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps) {
+    (void)caps;
+    pthread_mutex_lock(&heap_lock);
+    size_t free_size = SHIM_HEAP_SIZE - heap_used_max;
+    pthread_mutex_unlock(&heap_lock);
+    return free_size;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps) {
+    /* no fragmentation in the stand-in */
+    return heap_caps_get_free_size(caps);
+}
+
+void esp_restart(void) {
+    fprintf(stderr, "esp_restart() called from task %s\n", pcTaskGetTaskName(NULL));
+    abort();
+}
+
+void shim_log(esp_log_level_t level, const char *tag, const char *format, ...) {
+    static const char letter[] = "NEWIDV";
+    if (log_level < 0) {
+        const char *env = getenv("SHIM_LOG");
+        const char *pos = env ? strchr(letter, env[0]) : NULL;
+        log_level = (pos && env[0]) ? (int)(pos - letter) : ESP_LOG_WARN;
+    }
+    if ((int)level > log_level) {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    printf("%c (%lld) %s: ", letter[level], (long long)(esp_timer_get_time() / 1000), tag);
+    vprintf(format, args);
+    printf("\n");
+    va_end(args);
+}
+
+void esp_log_buffer_hex(const char *tag, const void *buffer, uint16_t buff_len) {
+    char line[3 * 16 + 1];
+    const uint8_t *p = buffer;
+    for (int pos = 0; pos < buff_len; pos += 16) {
+        int len = 0;
+        for (int idx = pos; idx < buff_len && idx < pos + 16; idx++) {
+            len += snprintf(&line[len], sizeof(line) - len, "%02x ", p[idx]);
+        }
+        shim_log(ESP_LOG_INFO, tag, "%s", line);
+    }
+}
+
+void esp_log_level_set(const char *tag, esp_log_level_t level) {
+    (void)tag;
+    log_level = level;
+}
+
+/**
+ * @brief task running app_main(), as started by ESP-IDF
+ * 
+ * @param param unused
+ */
+static void app_task_fcn(void *param) {
+    (void)param;
+    app_main();
+}
+
+/**
+ * @brief start the application on its own "main" task
+ * 
+ */
+void shim_app_start(void) {
+    esp_timer_get_time();
+    xTaskCreatePinnedToCore(app_task_fcn, "main", 3584, NULL, 1, NULL, 0);
+}
+
+/**
+ * @brief block calling thread
+ * 
+ * @param ms 
+ */
+void shim_sleep_ms(uint32_t ms) {
+    struct timespec ts = {ms / 1000, (long)(ms % 1000) * 1000000};
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
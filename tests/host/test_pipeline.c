@@ -0,0 +1,733 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "main.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "lvgl_helpers.h"
+
+#include "test_assert.h"
+#include "latency_hist.h"
+#include "sys_metrics.h"
+#include "mqtt_window.h"
+#include "remote_cfg.h"
+#include "ble_link.h"
+#include "fmt_fixed.h"
+#include "pipe_trace.h"
+#include "shim.h"
+
+/* DEFINES */
+#define TRACE_PATH          "traces/lywsd03mmc.trace"
+#define TRACE_MAX           256
+#define DEV_NUM             3
+#define STARTUP_TIMEOUT_MS  5000
+#define DRAIN_TIMEOUT_MS    15000
+#define THROUGHPUT_SAMPLES  20000
+#define OUTAGE_SAMPLES      40
+#define LOSS_SAMPLES        300
+#define LOSS_PERMILLE       100     /* of PUBLISH and of PUBACK packets */
+#define LOSS_TIMEOUT_MS     30000   /* retries wait for PUBLISH_ACK_TIMEOUT_MS */
+#define STALL_SAMPLES       300     /* broker takes PUBLISH but sends no PUBACK meanwhile */
+#define STALL_PERIOD_MS     5
+#define POLL_MS             10
+#define METRICS_TIMEOUT_MS  12000   /* CPU share needs two samples, METRICS_PERIOD_MS apart */
+#define CONFIG_TIMEOUT_MS   2000
+#define CONFIG_SAMPLES      48
+#define CONFIG_HOLD_MS      500     /* removed devices must stay disconnected this long */
+#define LINK_DEV            2       /* never lost its link, so not left at default parameters */
+#define LINK_PERIOD_MS      1100    /* slowed down to this notify period */
+#define LINK_NOTIFIES       7       /* long gaps, period learnt again and trusted */
+#define LINK_RSSI           -72
+#define TRACE_TIMEOUT_MS    2000
+#define TRACE_JSON_MAX      (PIPE_TRACE_SIZE * 4 * PIPE_TRACE_EVENT_LEN)
+#define TRACE_JSON_PATH     "pipeline_trace.json"   /* summarized by trace_stats.bin */
+
+/* TYPE DEFINITIONS */
+/* samples of one run as seen by the broker, keyed by ring sequence number */
+typedef struct capture_t {
+    pthread_mutex_t lock;
+    uint32_t base_seq;
+    int count;
+    int64_t *sent_us;
+    uint8_t *seen;
+    int delivered;
+    int duplicated;
+    uint32_t dropped_base;
+    latency_hist_t latency;
+    uint32_t metrics_count;
+    char metrics[SYS_METRICS_JSON_LEN + 1];    /* last message on MQTT_TOPIC/metrics */
+    uint32_t config_count;                     /* replies on MQTT_TOPIC/config/state and /error */
+    char config[REMOTE_CFG_TEXT_LEN + 1];      /* last message on MQTT_TOPIC/config/state */
+    char config_error[REMOTE_CFG_TEXT_LEN + 1];    /* last message on MQTT_TOPIC/config/error */
+    uint32_t links_count;
+    char links[BLE_LINK_JSON_LEN + 1];         /* last message on MQTT_TOPIC/links */
+    int trace_len;
+    char trace[TRACE_JSON_MAX + 1];            /* messages on MQTT_TOPIC/trace, concatenated */
+} capture_t;
+
+/* STATIC VARIABLES */
+static const uint8_t dev_bda[DEV_NUM][6] = {
+    {0xa4, 0xc1, 0x38, 0x00, 0x00, 0x01},
+    {0xa4, 0xc1, 0x38, 0x00, 0x00, 0x02},
+    {0xa4, 0xc1, 0x38, 0x00, 0x00, 0x03},
+};
+static capture_t capture = {.lock = PTHREAD_MUTEX_INITIALIZER};
+static shim_trace_rec_t trace[TRACE_MAX];
+
+/* STATIC PROTOTYPES */
+static void broker_hook(const char *topic, const uint8_t *data, int len, void *ctx);
+static uint32_t ring_dropped(void);
+static void run_begin(int count);
+static int run_wait(uint32_t timeout_ms);
+static void run_end(void);
+static void run_report(const char *name, double dt);
+static void test_startup(void);
+static void test_trace_replay(void);
+static void test_throughput(void);
+static void test_pipe_trace(void);
+static void test_outage(void);
+static void test_qos_loss(void);
+static void test_backpressure(void);
+static void test_reconnect(void);
+static uint32_t metrics_field(const char *json, const char *key);
+static void test_metrics(void);
+static bool config_send(const char *cmd, char *state);
+static void test_remote_config(void);
+static void test_links(void);
+
+/**
+ * @brief broker side: match "seq" of every JSON record to its notification
+ * 
+ * @param topic 
+ * @param data 
+ * @param len 
+ * @param ctx capture_t
+ */
+static void broker_hook(const char *topic, const uint8_t *data, int len, void *ctx) {
+    capture_t *cap = ctx;
+    char payload[2048];
+    int64_t now = esp_timer_get_time();
+    const char *sub = strrchr(topic, '/');
+    if (sub && strcmp(sub, "/metrics") == 0) {
+        pthread_mutex_lock(&cap->lock);
+        if (len < (int)sizeof(cap->metrics)) {
+            memcpy(cap->metrics, data, len);
+            cap->metrics[len] = '\0';
+            cap->metrics_count++;
+        }
+        pthread_mutex_unlock(&cap->lock);
+        return;
+    }
+    if (sub && strcmp(sub, "/links") == 0) {
+        pthread_mutex_lock(&cap->lock);
+        if (len < (int)sizeof(cap->links)) {
+            memcpy(cap->links, data, len);
+            cap->links[len] = '\0';
+            cap->links_count++;
+        }
+        pthread_mutex_unlock(&cap->lock);
+        return;
+    }
+    if (sub && strcmp(sub, "/trace") == 0) {
+        pthread_mutex_lock(&cap->lock);
+        if (cap->trace_len + len < (int)sizeof(cap->trace)) {
+            memcpy(&cap->trace[cap->trace_len], data, len);
+            cap->trace_len += len;
+            cap->trace[cap->trace_len] = '\0';
+        }
+        pthread_mutex_unlock(&cap->lock);
+        return;
+    }
+    if (sub && strcmp(sub, "/state") == 0) {
+        pthread_mutex_lock(&cap->lock);
+        if (len < (int)sizeof(cap->config)) {
+            memcpy(cap->config, data, len);
+            cap->config[len] = '\0';
+            cap->config_count++;
+        }
+        pthread_mutex_unlock(&cap->lock);
+        return;
+    }
+    if (sub && strcmp(sub, "/error") == 0) {
+        pthread_mutex_lock(&cap->lock);
+        if (len < (int)sizeof(cap->config_error)) {
+            memcpy(cap->config_error, data, len);
+            cap->config_error[len] = '\0';
+            cap->config_count++;
+        }
+        pthread_mutex_unlock(&cap->lock);
+        return;
+    }
+    if (len >= (int)sizeof(payload)) {
+        return;
+    }
+    memcpy(payload, data, len);
+    payload[len] = '\0';
+    pthread_mutex_lock(&cap->lock);
+    for (char *p = strstr(payload, "\"seq\":"); p; p = strstr(p + 1, "\"seq\":")) {
+        uint32_t idx = (uint32_t)strtoul(p + 6, NULL, 10) - cap->base_seq;
+        if (cap->seen == NULL || idx >= (uint32_t)cap->count) {
+            continue;
+        }
+        if (cap->seen[idx]) {
+            cap->duplicated++;
+            continue;
+        }
+        cap->seen[idx] = 1;
+        cap->delivered++;
+        latency_hist_add(&cap->latency, (int32_t)(now - cap->sent_us[idx]));
+    }
+    pthread_mutex_unlock(&cap->lock);
+}
+
+/**
+ * @brief samples dropped by the ring so far
+ * 
+ * @return count
+ */
+static uint32_t ring_dropped(void) {
+    return __atomic_load_n(&sample_ring.drop_oldest, __ATOMIC_RELAXED) +
+           __atomic_load_n(&sample_ring.drop_newest, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief start capturing a run of count notifications
+ * 
+ * @param count 
+ */
+static void run_begin(int count) {
+    pthread_mutex_lock(&capture.lock);
+    capture.base_seq = __atomic_load_n(&sample_ring.next_seq, __ATOMIC_RELAXED);
+    capture.count = count;
+    capture.sent_us = calloc(count, sizeof(int64_t));
+    capture.seen = calloc(count, 1);
+    assert(capture.sent_us && capture.seen);
+    capture.delivered = 0;
+    capture.duplicated = 0;
+    capture.dropped_base = ring_dropped();
+    latency_hist_init(&capture.latency);
+    pthread_mutex_unlock(&capture.lock);
+}
+
+/**
+ * @brief wait until every sample of the run was delivered or dropped
+ * 
+ * @param timeout_ms 
+ * @return samples delivered
+ */
+static int run_wait(uint32_t timeout_ms) {
+    int delivered = 0;
+    for (uint32_t waited = 0; waited < timeout_ms; waited += POLL_MS) {
+        pthread_mutex_lock(&capture.lock);
+        delivered = capture.delivered;
+        int lost = (int)(ring_dropped() - capture.dropped_base);
+        pthread_mutex_unlock(&capture.lock);
+        if (delivered + lost >= capture.count) {
+            break;
+        }
+        shim_sleep_ms(POLL_MS);
+    }
+    return delivered;
+}
+
+/**
+ * @brief stop capturing
+ * 
+ */
+static void run_end(void) {
+    pthread_mutex_lock(&capture.lock);
+    free(capture.sent_us);
+    free(capture.seen);
+    capture.sent_us = NULL;
+    capture.seen = NULL;
+    capture.count = 0;
+    pthread_mutex_unlock(&capture.lock);
+}
+
+/**
+ * @brief print delivery, rate and notify->publish latency of the run
+ * 
+ * @param name 
+ * @param dt seconds from first notification to last delivery
+ */
+static void run_report(const char *name, double dt) {
+    latency_hist_t *h = &capture.latency;
+    test_print("   %-14s sent %6d  delivered %6d  dropped %5u  %8.0f samples/s  latency ms p50 %5u p99 %5u max %5u",
+               name, capture.count, capture.delivered, ring_dropped() - capture.dropped_base,
+               capture.delivered / dt,
+               latency_hist_percentile(h, 50) / 1000, latency_hist_percentile(h, 99) / 1000, h->max_us / 1000);
+}
+
+/**
+ * @brief boot app, WiFi and MQTT come up and all sensors get connected
+ * 
+ */
+static void test_startup(void) {
+    for (int dev = 0; dev < DEV_NUM; dev++) {
+        test_assert_int_eq(dev, shim_ble_add_device(dev_bda[dev], "LYWSD03MMC"), "add simulated sensor");
+    }
+    shim_mqtt_set_hook(broker_hook, &capture);
+    shim_app_start();
+
+    bool ready = shim_ble_wait_ready(DEV_NUM, STARTUP_TIMEOUT_MS);
+    test_assert_true(ready, "all sensors connected with notifications enabled");
+    for (uint32_t waited = 0; !shim_mqtt_connected() && waited < STARTUP_TIMEOUT_MS; waited += POLL_MS) {
+        shim_sleep_ms(POLL_MS);
+    }
+    test_assert_true(shim_mqtt_connected(), "MQTT connected");
+    test_print("   boot to ready %lld ms", (long long)(esp_timer_get_time() / 1000));
+    /* let main loop see MQTT up before sending */
+    shim_sleep_ms(100);
+}
+
+/**
+ * @brief replay recorded trace with its timing, every sample reaches the broker
+ * 
+ */
+static void test_trace_replay(void) {
+    int count = shim_trace_load(TRACE_PATH, trace, TRACE_MAX);
+    test_assert_true(count > 0, "trace loaded");
+
+    run_begin(count);
+    int64_t t0 = esp_timer_get_time();
+    int sent = shim_ble_replay(trace, count, true, capture.sent_us);
+    test_assert_int_eq(count, sent, "every notification sent");
+    int delivered = run_wait(DRAIN_TIMEOUT_MS);
+    run_report("recorded trace", (esp_timer_get_time() - t0) * 1e-6);
+    test_assert_int_eq(count, delivered, "every sample delivered");
+    test_assert_int_eq(0, capture.duplicated, "no duplicates");
+    test_assert_true(capture.latency.max_us < 1500000, "latency bounded by batch window");
+    test_assert_true(shim_disp_flush_count() > 0, "GUI rendered");
+    run_end();
+}
+
+/**
+ * @brief notifications back to back, samples are delivered or counted as dropped
+ * 
+ */
+static void test_throughput(void) {
+    shim_trace_rec_t *recs = calloc(THROUGHPUT_SAMPLES, sizeof(shim_trace_rec_t));
+    assert(recs != NULL);
+    for (int n = 0; n < THROUGHPUT_SAMPLES; n++) {
+        int16_t temp = (int16_t)(2000 + n % 500);
+        recs[n].dev = (uint8_t)(n % DEV_NUM);
+        recs[n].len = 5;
+        recs[n].value[0] = (uint8_t)temp;
+        recs[n].value[1] = (uint8_t)(temp >> 8);
+        recs[n].value[2] = (uint8_t)(40 + n % 20);
+    }
+    shim_mqtt_stats_t before = shim_mqtt_stats();
+
+    run_begin(THROUGHPUT_SAMPLES);
+    int64_t t0 = esp_timer_get_time();
+    int sent = shim_ble_replay(recs, THROUGHPUT_SAMPLES, false, capture.sent_us);
+    test_assert_int_eq(THROUGHPUT_SAMPLES, sent, "every notification sent");
+    int delivered = run_wait(DRAIN_TIMEOUT_MS);
+    run_report("back to back", (esp_timer_get_time() - t0) * 1e-6);
+    shim_mqtt_stats_t after = shim_mqtt_stats();
+    test_print("   %u messages, %.1f payload bytes/sample",
+               after.msg_count - before.msg_count, (double)(after.byte_count - before.byte_count) / delivered);
+    test_assert_int_eq(THROUGHPUT_SAMPLES, delivered + (int)(ring_dropped() - capture.dropped_base),
+                       "delivered + dropped == sent");
+    test_assert_int_eq(0, capture.duplicated, "no duplicates");
+    test_assert_int_eq(0, (int32_t)(after.fail_count - before.fail_count), "no failed publish");
+    run_end();
+    free(recs);
+}
+
+/**
+ * @brief first capture of pipeline stamps, full by now, is published as Chrome trace JSON
+ *        and saved for trace_stats.bin
+ * 
+ */
+static void test_pipe_trace(void) {
+    bool closed = false;
+    for (uint32_t waited = 0; !closed && waited < TRACE_TIMEOUT_MS; waited += POLL_MS) {
+        shim_sleep_ms(POLL_MS);
+        pthread_mutex_lock(&capture.lock);
+        closed = capture.trace_len > 2 && strcmp(&capture.trace[capture.trace_len - 2], "]\n") == 0;
+        pthread_mutex_unlock(&capture.lock);
+    }
+    test_assert_true(closed, "capture published");
+    test_assert_true(strncmp(capture.trace, "[\n{\"name\":", 10) == 0, "JSON array of events");
+    int spans = 0;
+    for (const char *p = strstr(capture.trace, "\"pipeline\",\"cat\":\"sample\",\"ph\":\"b\""); p;
+         p = strstr(p + 1, "\"pipeline\",\"cat\":\"sample\",\"ph\":\"b\"")) {
+        spans++;
+    }
+    test_print("   %d bytes, %d samples from notify to wire", capture.trace_len, spans);
+    test_assert_true(spans > 0, "samples traced through every stage");
+    test_assert_true(strstr(capture.trace, "{\"name\":\"ring\",") != NULL, "time in the ring");
+    FILE *file = fopen(TRACE_JSON_PATH, "w");
+    test_assert_true(file != NULL, "trace file opened");
+    fwrite(capture.trace, 1, capture.trace_len, file);
+    fclose(file);
+}
+
+/**
+ * @brief broker down while sensors report, backlog is replayed after reconnect
+ * 
+ */
+static void test_outage(void) {
+    shim_trace_rec_t recs[OUTAGE_SAMPLES];
+    memset(recs, 0, sizeof(recs));
+    for (int n = 0; n < OUTAGE_SAMPLES; n++) {
+        recs[n].t_ms = n * 10;
+        recs[n].dev = (uint8_t)(n % DEV_NUM);
+        recs[n].len = 5;
+        recs[n].value[0] = (uint8_t)(100 + n);
+        recs[n].value[1] = 0x09;
+        recs[n].value[2] = 50;
+    }
+    shim_mqtt_set_broker(false);
+    shim_sleep_ms(100);
+
+    run_begin(OUTAGE_SAMPLES);
+    shim_ble_replay(recs, OUTAGE_SAMPLES, true, capture.sent_us);
+    shim_sleep_ms(100);
+    test_assert_int_eq(0, capture.delivered, "nothing delivered while broker is down");
+    int64_t t0 = esp_timer_get_time();
+    shim_mqtt_set_broker(true);
+    int delivered = run_wait(DRAIN_TIMEOUT_MS);
+    double dt = (esp_timer_get_time() - t0) * 1e-6;
+    run_report("broker outage", dt);
+    test_assert_int_eq(OUTAGE_SAMPLES, delivered, "backlog delivered after reconnect");
+    test_print("   backlog drained %.2f s after reconnect", dt);
+    run_end();
+}
+
+/**
+ * @brief PUBLISH and PUBACK packets lost, QoS 1 window retries until every sample is delivered
+ * 
+ */
+static void test_qos_loss(void) {
+    shim_trace_rec_t recs[LOSS_SAMPLES];
+    memset(recs, 0, sizeof(recs));
+    for (int n = 0; n < LOSS_SAMPLES; n++) {
+        recs[n].t_ms = n * 10;
+        recs[n].dev = (uint8_t)(n % DEV_NUM);
+        recs[n].len = 5;
+        recs[n].value[0] = (uint8_t)n;
+        recs[n].value[1] = 0x08;
+        recs[n].value[2] = 45;
+    }
+    shim_mqtt_stats_t before = shim_mqtt_stats();
+    shim_mqtt_set_loss(LOSS_PERMILLE, LOSS_PERMILLE);
+
+    run_begin(LOSS_SAMPLES);
+    int64_t t0 = esp_timer_get_time();
+    shim_ble_replay(recs, LOSS_SAMPLES, true, capture.sent_us);
+    int delivered = run_wait(LOSS_TIMEOUT_MS);
+    run_report("lossy broker", (esp_timer_get_time() - t0) * 1e-6);
+    shim_mqtt_set_loss(0, 0);
+    shim_mqtt_stats_t after = shim_mqtt_stats();
+    uint32_t publish_lost = after.publish_lost - before.publish_lost;
+    uint32_t ack_lost = after.ack_lost - before.ack_lost;
+    test_print("   %u messages, %u PUBLISH and %u PUBACK lost, %d duplicate samples",
+               after.msg_count - before.msg_count, publish_lost, ack_lost, capture.duplicated);
+    test_assert_true(publish_lost > 0 && ack_lost > 0, "packets lost");
+    test_assert_int_eq(LOSS_SAMPLES, delivered, "every sample delivered");
+    test_assert_true(capture.duplicated <= (int)ack_lost * MQTT_BATCH_MAX, "duplicates only from lost PUBACKs");
+    run_end();
+}
+
+/**
+ * @brief no PUBACKs: window fills, samples are held in the ring instead of piling up as batches
+ * 
+ */
+static void test_backpressure(void) {
+    shim_trace_rec_t recs[STALL_SAMPLES];
+    memset(recs, 0, sizeof(recs));
+    for (int n = 0; n < STALL_SAMPLES; n++) {
+        recs[n].t_ms = n * STALL_PERIOD_MS;
+        recs[n].dev = (uint8_t)(n % DEV_NUM);
+        recs[n].len = 5;
+        recs[n].value[0] = (uint8_t)n;
+        recs[n].value[1] = 0x07;
+        recs[n].value[2] = 40;
+    }
+    shim_mqtt_stats_t before = shim_mqtt_stats();
+    shim_mqtt_set_loss(0, 1000);
+
+    run_begin(STALL_SAMPLES);
+    int64_t t0 = esp_timer_get_time();
+    shim_ble_replay(recs, STALL_SAMPLES, true, capture.sent_us);
+    shim_sleep_ms(100);
+    uint32_t stalled = shim_mqtt_stats().msg_count - before.msg_count;
+    uint32_t held = sample_ring_count(&sample_ring);
+    int stall_delivered = capture.delivered;
+    shim_mqtt_set_loss(0, 0);
+    /* stalled batches go out again after the ack timeout, then the ring drains */
+    for (uint32_t waited = 0; waited < LOSS_TIMEOUT_MS && capture.duplicated == 0; waited += POLL_MS) {
+        shim_sleep_ms(POLL_MS);
+    }
+    int delivered = run_wait(LOSS_TIMEOUT_MS);
+    run_report("no PUBACK", (esp_timer_get_time() - t0) * 1e-6);
+    test_print("   %u messages while stalled, %u samples held, %d duplicate samples after retry",
+               stalled, held, capture.duplicated);
+    test_assert_true(stalled > 0 && stalled <= MQTT_WINDOW_MAX, "publishing stops at full window");
+    test_assert_int_eq(SAMPLE_RING_SIZE, (int32_t)held, "samples held in ring");
+    test_assert_int_eq(STALL_SAMPLES, delivered + (int)(ring_dropped() - capture.dropped_base),
+                       "delivered + dropped == sent");
+    test_assert_true(delivered >= stall_delivered + (int)held, "held samples published after PUBACKs");
+    test_assert_true(capture.duplicated > 0, "unacknowledged batches republished");
+    test_assert_int_eq(0, sample_ring_count(&sample_ring), "ring drained");
+    run_end();
+}
+
+/**
+ * @brief sensor link lost, app scans again and reconnects it on cached GATT handles,
+ *        stale handles fall back to discovery
+ * 
+ */
+static void test_reconnect(void) {
+    int32_t first_ms = shim_ble_ready_ms(0);
+    uint32_t wl_scans = shim_ble_wl_scan_count();
+    uint32_t nvs_writes = shim_nvs_write_count();
+    test_assert_true(first_ms >= 0, "first connection ready");
+
+    /* cached handles: notifications on before discovery ends */
+    test_assert_true(shim_ble_disconnect(0), "sensor 0 disconnected");
+    int64_t t0 = esp_timer_get_time();
+    bool ready = shim_ble_wait_ready(DEV_NUM, STARTUP_TIMEOUT_MS);
+    test_assert_true(ready, "sensor 0 reconnected");
+    int32_t cached_ms = shim_ble_ready_ms(0);
+    test_print("   reconnect %lld ms, connect to ready %d ms, first connection %d ms",
+               (long long)((esp_timer_get_time() - t0) / 1000), cached_ms, first_ms);
+    test_assert_true(cached_ms >= 0 && cached_ms * 4 < first_ms, "cached handles skip discovery");
+    test_assert_true(shim_ble_wl_scan_count() > wl_scans, "known devices looked for on whitelist");
+    test_assert_int_eq((int32_t)nvs_writes, (int32_t)shim_nvs_write_count(), "same handles, no flash write");
+
+    /* new firmware moved the characteristic: fall back to discovery, cache updated */
+    test_assert_true(shim_ble_set_handle(0, 0x0039), "handle moved");
+    test_assert_true(shim_ble_disconnect(0), "sensor 0 disconnected again");
+    ready = shim_ble_wait_ready(DEV_NUM, STARTUP_TIMEOUT_MS);
+    test_assert_true(ready, "sensor 0 reconnected on new handle");
+    int32_t stale_ms = shim_ble_ready_ms(0);
+    test_print("   stale cache: connect to ready %d ms", stale_ms);
+    test_assert_true(stale_ms * 4 >= first_ms, "stale handle rediscovered");
+    test_assert_int_eq((int32_t)nvs_writes + 1, (int32_t)shim_nvs_write_count(), "new handle saved");
+
+    test_assert_true(shim_ble_disconnect(0), "sensor 0 disconnected once more");
+    ready = shim_ble_wait_ready(DEV_NUM, STARTUP_TIMEOUT_MS);
+    test_assert_true(ready && shim_ble_ready_ms(0) * 4 < first_ms, "updated cache used");
+}
+
+/**
+ * @brief numeric value following "key": in JSON
+ * 
+ * @param json 
+ * @param key with quotes, e.g. "\"dma_min\""
+ * @return value, UINT32_MAX if key is missing
+ */
+static uint32_t metrics_field(const char *json, const char *key) {
+    const char *p = json ? strstr(json, key) : NULL;
+    if (p == NULL) {
+        return UINT32_MAX;
+    }
+    return (uint32_t)strtoul(p + strlen(key) + 1, NULL, 10);
+}
+
+/**
+ * @brief periodic metrics reach the broker and the debug page, the display buffer shows in the DMA pool
+ * 
+ */
+static void test_metrics(void) {
+    char json[SYS_METRICS_JSON_LEN + 1];
+    /* wait for a message with CPU share */
+    for (uint32_t waited = 0; waited < METRICS_TIMEOUT_MS; waited += POLL_MS) {
+        pthread_mutex_lock(&capture.lock);
+        memcpy(json, capture.metrics, sizeof(json));
+        pthread_mutex_unlock(&capture.lock);
+        if (strstr(json, "\"load\":") != NULL) {
+            break;
+        }
+        shim_sleep_ms(POLL_MS);
+    }
+    test_assert_true(strstr(json, "\"load\":") != NULL, "metrics with CPU load published");
+    const char *gui = strstr(json, "{\"name\":\"gui\"");
+    const char *main_task = strstr(json, "{\"name\":\"main\"");
+    test_assert_true(gui != NULL && main_task != NULL, "gui and main task reported");
+    test_assert_true(strstr(gui, "\"core\":1,") == gui + strlen("{\"name\":\"gui\","), "gui pinned to core 1");
+    test_assert_true(metrics_field(gui, "\"cpu\"") != UINT32_MAX, "gui CPU share reported");
+    uint32_t px_buf = 2 * (LV_HOR_RES_MAX * LV_VER_RES_MAX / 10) * sizeof(lv_color_t);
+    test_assert_true(metrics_field(json, "\"dma_min\"") <= SHIM_HEAP_SIZE - px_buf, "both band buffers in DMA pool");
+    test_assert_true(strstr(json, "\"ring\":[") != NULL, "sample ring depth reported");
+    test_assert_true(strstr(json, "},\"power\":{\"off\":") != NULL, "display power reported");
+    static status_view_t view;
+    status_view_init(&view);
+    test_assert_true(status_snap_read(&status_snap, &view) > 0, "status read");
+    test_assert_true(STATUS_VIEW_CHANGED(&view, STATUS_FIELD_METRICS) && strstr(view.data.metrics, "gui") != NULL,
+                     "metrics on debug page");
+    test_assert_true(STATUS_VIEW_CHANGED(&view, STATUS_FIELD_SENSOR) && view.data.sensor[0].used, "sensor on main page");
+    test_assert_true(metrics_field(gui, "\"cpu\"") < 10, "gui task sleeps between frames");
+    test_print("   %s", json);
+}
+
+/**
+ * @brief publish command to the config topic and wait for the state reply
+ * 
+ * @param cmd 
+ * @param state [out] reply, REMOTE_CFG_TEXT_LEN + 1 chars
+ * @return true if replied
+ */
+static bool config_send(const char *cmd, char *state) {
+    pthread_mutex_lock(&capture.lock);
+    uint32_t count = capture.config_count;
+    pthread_mutex_unlock(&capture.lock);
+    if (!shim_mqtt_receive("/config", cmd, (int)strlen(cmd))) {
+        return false;
+    }
+    for (uint32_t waited = 0; waited < CONFIG_TIMEOUT_MS; waited += POLL_MS) {
+        pthread_mutex_lock(&capture.lock);
+        bool replied = capture.config_count > count;
+        memcpy(state, capture.config, REMOTE_CFG_TEXT_LEN + 1);
+        pthread_mutex_unlock(&capture.lock);
+        if (replied) {
+            return true;
+        }
+        shim_sleep_ms(POLL_MS);
+    }
+    return false;
+}
+
+/**
+ * @brief commands on the config topic retune batching and the device allow list without restart,
+ *        accepted changes are saved, a bad command changes nothing
+ * 
+ */
+static void test_remote_config(void) {
+    char state[REMOTE_CFG_TEXT_LEN + 1];
+    uint32_t nvs_writes = shim_nvs_write_count();
+    test_assert_true(capture.config_count > 0, "config state published on connect");
+
+    /* smaller batches: more messages for the same samples */
+    test_assert_true(config_send("batch_n=4 batch_ms=200", state), "config command answered");
+    test_assert_true(strstr(state, "batch_ms=200 batch_n=4 ") == state, "new batch settings in force");
+    test_assert_int_eq((int32_t)nvs_writes + 1, (int32_t)shim_nvs_write_count(), "settings saved");
+    shim_trace_rec_t recs[CONFIG_SAMPLES];
+    memset(recs, 0, sizeof(recs));
+    for (int n = 0; n < CONFIG_SAMPLES; n++) {
+        recs[n].t_ms = n * 10;
+        recs[n].dev = (uint8_t)(n % DEV_NUM);
+        recs[n].len = 5;
+        recs[n].value[0] = (uint8_t)n;
+        recs[n].value[1] = 0x09;
+        recs[n].value[2] = 50;
+    }
+    shim_mqtt_stats_t before = shim_mqtt_stats();
+    run_begin(CONFIG_SAMPLES);
+    shim_ble_replay(recs, CONFIG_SAMPLES, true, capture.sent_us);
+    int delivered = run_wait(DRAIN_TIMEOUT_MS);
+    shim_mqtt_stats_t after = shim_mqtt_stats();
+    run_end();
+    test_print("   batch_n=4: %d samples in %u messages", delivered, after.msg_count - before.msg_count);
+    test_assert_int_eq(CONFIG_SAMPLES, delivered, "every sample delivered");
+    test_assert_true(after.msg_count - before.msg_count >= CONFIG_SAMPLES / 4, "batches of at most 4");
+
+    test_assert_true(config_send("batch_ms=100 color=red", state), "bad command answered");
+    test_assert_str_eq("error at 13", capture.config_error, "refused pair reported");
+    test_assert_true(strstr(state, "batch_ms=200 batch_n=4 ") == state, "state topic keeps the settings in force");
+    test_assert_int_eq((int32_t)nvs_writes + 1, (int32_t)shim_nvs_write_count(), "nothing saved");
+
+    /* allow list: other sensors dropped on their next notification and not reconnected */
+    test_assert_true(config_send("allow=a4:c1:38:00:00:01", state), "allow list set");
+    test_assert_true(strstr(state, " batch_ms=100") == NULL && strstr(state, "allow=a4:c1:38:00:00:01") != NULL,
+                     "allow list in force, refused command not applied");
+    const uint8_t value[5] = {0x10, 0x09, 50, 0, 0};
+    for (int dev = 1; dev < DEV_NUM; dev++) {
+        test_assert_true(shim_ble_notify(dev, value, sizeof(value)), "notification from removed sensor");
+    }
+    for (uint32_t waited = 0; shim_ble_ready_count() > 1 && waited < CONFIG_TIMEOUT_MS; waited += POLL_MS) {
+        shim_sleep_ms(POLL_MS);
+    }
+    shim_sleep_ms(CONFIG_HOLD_MS);
+    test_assert_int_eq(1, shim_ble_ready_count(), "removed sensors disconnected and left alone");
+    test_assert_true(shim_ble_notify(0, value, sizeof(value)), "allowed sensor still connected");
+
+    test_assert_true(config_send("allow=* batch_n=16 batch_ms=1000", state), "allow list cleared");
+    test_assert_true(shim_ble_wait_ready(DEV_NUM, STARTUP_TIMEOUT_MS), "every sensor connected again");
+    test_assert_int_eq((int32_t)nvs_writes + 3, (int32_t)shim_nvs_write_count(), "each change saved");
+}
+
+/**
+ * @brief a sensor that slowed down gets a longer connection interval and slave latency,
+ *        its link quality and connection RSSI reach the broker, the debug page and the samples
+ * 
+ */
+static void test_links(void) {
+    static char json[BLE_LINK_JSON_LEN + 1];
+    static status_view_t view;
+    uint16_t interval = 0;
+    uint16_t latency = 0;
+    test_assert_true(shim_ble_conn_params(LINK_DEV, &interval, &latency) && latency == 0, "default parameters");
+    uint16_t default_interval = interval;
+    test_assert_true(shim_ble_set_rssi(LINK_DEV, LINK_RSSI), "sensor moved away");
+    const uint8_t value[5] = {0x20, 0x09, 50, 0, 0};
+    for (int n = 0; n < LINK_NOTIFIES; n++) {
+        test_assert_true(shim_ble_notify(LINK_DEV, value, sizeof(value)), "notification from slow sensor");
+        shim_sleep_ms(LINK_PERIOD_MS);
+    }
+    test_assert_true(shim_ble_conn_params(LINK_DEV, &interval, &latency), "still connected");
+    test_print("   %u ms notify period: interval %u.%02u ms, latency %u", LINK_PERIOD_MS,
+               interval * 125 / 100, interval * 125 % 100, latency);
+    test_assert_true(interval > default_interval, "longer connection interval");
+    test_assert_int_eq(4, latency, "slave latency");
+
+    /* next metrics period publishes the tuned link */
+    char bda[FMT_BDA_LEN + 1];
+    fmt_bda(bda, dev_bda[LINK_DEV]);
+    char *link = NULL;
+    for (uint32_t waited = 0; waited < METRICS_TIMEOUT_MS; waited += POLL_MS) {
+        pthread_mutex_lock(&capture.lock);
+        memcpy(json, capture.links, sizeof(json));
+        pthread_mutex_unlock(&capture.lock);
+        link = strstr(json, bda);
+        if (link && strstr(link, "\"lat\":4") != NULL) {
+            break;
+        }
+        shim_sleep_ms(POLL_MS);
+    }
+    test_assert_true(link != NULL && strstr(link, "\"lat\":4") != NULL, "tuned link published");
+    test_assert_true(strstr(link, "\"rssi\":-72,") != NULL, "connection RSSI published");
+    test_assert_true(strstr(link, "\"upd\":1,") != NULL, "one update in force");
+    status_view_init(&view);
+    test_assert_true(status_snap_read(&status_snap, &view) > 0, "status read");
+    test_assert_true(strstr(view.data.metrics, " -72 dBm ") != NULL, "link on debug page");
+    bool rssi_seen = false;
+    for (int idx = 0; idx < STATUS_SENSOR_MAX; idx++) {
+        rssi_seen |= view.data.sensor[idx].used && view.data.sensor[idx].rssi == LINK_RSSI;
+    }
+    test_assert_true(rssi_seen, "samples carry connection RSSI");
+    const char *rec = link - strlen("{\"bda\":\"");
+    test_print("   %.*s", (int)(strchr(link, '}') - rec + 1), rec);
+}
+
+/**
+ * @brief end-to-end tests of main/ against ESP-IDF/FreeRTOS stand-ins
+ * 
+ * @return 0 on success, tests exit(1) on first failure
+ */
+int main(void) {
+    test_print("");
+    test_print("*********************");
+    test_print("Start pipeline tests");
+    test_print("*********************");
+
+    test_startup();
+    test_trace_replay();
+    test_throughput();
+    test_pipe_trace();
+    test_outage();
+    test_qos_loss();
+    test_backpressure();
+    test_reconnect();
+    test_metrics();
+    test_remote_config();
+    test_links();
+    test_print("   display: %u flushes, %llu px", shim_disp_flush_count(), (unsigned long long)shim_disp_px_count());
+
+    test_print("Exit with success!");
+    exit(0);
+}
@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+/* DEFINES */
+#define LINE_MAX_LEN    512
+#define NAME_LEN        16
+#define SPAN_MAX        8       /* distinct span names */
+#define OPEN_MAX        4096    /* begin events awaiting their end */
+
+/* TYPE DEFINITIONS */
+typedef struct open_t {
+    char name[NAME_LEN];
+    uint32_t id;
+    int64_t ts_us;
+} open_t;
+
+typedef struct span_t {
+    char name[NAME_LEN];
+    int count;
+    int size;
+    int64_t *dur_us;
+} span_t;
+
+/* STATIC VARIABLES */
+static open_t open_list[OPEN_MAX];
+static int open_num;
+static span_t span[SPAN_MAX];
+static int span_num;
+
+/* STATIC PROTOTYPES */
+static int parse_event(const char *line, char *name, char *ph, uint32_t *id, int64_t *ts_us);
+static void span_add(const char *name, int64_t dur_us);
+static void event_add(const char *name, char ph, uint32_t id, int64_t ts_us);
+static int dur_cmp(const void *a, const void *b);
+static int64_t percentile(const span_t *sp, int pct);
+
+/**
+ * @brief fields of one event line of pipe_trace_json, anywhere in the line: log prefixes are skipped
+ *
+ * @param line
+ * @param name [out] NAME_LEN chars
+ * @param ph [out] 'b' or 'e'
+ * @param id [out]
+ * @param ts_us [out]
+ * @return 1 if an async event was found
+ */
+static int parse_event(const char *line, char *name, char *ph, uint32_t *id, int64_t *ts_us) {
+    const char *p = strstr(line, "{\"name\":\"");
+    if (p == NULL) {
+        return 0;
+    }
+    p += strlen("{\"name\":\"");
+    const char *end = strchr(p, '"');
+    if (end == NULL || end - p >= NAME_LEN) {
+        return 0;
+    }
+    memcpy(name, p, end - p);
+    name[end - p] = '\0';
+    const char *f_ph = strstr(end, "\"ph\":\"");
+    const char *f_id = strstr(end, "\"id\":");
+    const char *f_ts = strstr(end, "\"ts\":");
+    if (f_ph == NULL || f_id == NULL || f_ts == NULL) {
+        return 0;
+    }
+    *ph = f_ph[strlen("\"ph\":\"")];
+    *id = (uint32_t)strtoul(f_id + strlen("\"id\":"), NULL, 10);
+    *ts_us = strtoll(f_ts + strlen("\"ts\":"), NULL, 10);
+    return *ph == 'b' || *ph == 'e';
+}
+
+/**
+ * @brief record duration of a span
+ *
+ * @param name
+ * @param dur_us
+ */
+static void span_add(const char *name, int64_t dur_us) {
+    span_t *sp = NULL;
+    for (int idx = 0; idx < span_num && sp == NULL; idx++) {
+        sp = (strcmp(span[idx].name, name) == 0) ? &span[idx] : NULL;
+    }
+    if (sp == NULL) {
+        if (span_num >= SPAN_MAX) {
+            return;
+        }
+        sp = &span[span_num++];
+        strcpy(sp->name, name);
+    }
+    if (sp->count == sp->size) {
+        sp->size = sp->size ? sp->size * 2 : 256;
+        sp->dur_us = realloc(sp->dur_us, sp->size * sizeof(int64_t));
+        if (sp->dur_us == NULL) {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+    sp->dur_us[sp->count++] = dur_us;
+}
+
+/**
+ * @brief pair begin and end of a span by name and sample id
+ *
+ * @param name
+ * @param ph
+ * @param id
+ * @param ts_us
+ */
+static void event_add(const char *name, char ph, uint32_t id, int64_t ts_us) {
+    if (ph == 'b') {
+        if (open_num < OPEN_MAX) {
+            open_list[open_num] = (open_t){.id = id, .ts_us = ts_us};
+            strcpy(open_list[open_num].name, name);
+            open_num++;
+        }
+        return;
+    }
+    for (int idx = open_num - 1; idx >= 0; idx--) {
+        if (open_list[idx].id == id && strcmp(open_list[idx].name, name) == 0) {
+            span_add(name, ts_us - open_list[idx].ts_us);
+            open_list[idx] = open_list[--open_num];
+            return;
+        }
+    }
+}
+
+/**
+ * @brief qsort ascending
+ *
+ */
+static int dur_cmp(const void *a, const void *b) {
+    int64_t da = *(const int64_t *)a;
+    int64_t db = *(const int64_t *)b;
+    return (da > db) - (da < db);
+}
+
+/**
+ * @brief nearest-rank percentile of sorted durations
+ *
+ * @param sp
+ * @param pct 0..100
+ * @return us
+ */
+static int64_t percentile(const span_t *sp, int pct) {
+    int rank = (sp->count * pct + 99) / 100;
+    return sp->dur_us[rank > 0 ? rank - 1 : 0];
+}
+
+/**
+ * @brief per-span latency summary of pipeline trace captures: MQTT_TOPIC/trace messages or
+ *        the serial log of a PIPE_TRACE_ENABLE build
+ *
+ * @return 0, 1 if a file cannot be read or holds no span
+ */
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s trace.json|log...\n", argv[0]);
+        return 1;
+    }
+    char line[LINE_MAX_LEN];
+    for (int arg = 1; arg < argc; arg++) {
+        FILE *file = fopen(argv[arg], "r");
+        if (file == NULL) {
+            perror(argv[arg]);
+            return 1;
+        }
+        while (fgets(line, sizeof(line), file)) {
+            char name[NAME_LEN];
+            char ph;
+            uint32_t id;
+            int64_t ts_us;
+            if (parse_event(line, name, &ph, &id, &ts_us)) {
+                event_add(name, ph, id, ts_us);
+            }
+        }
+        fclose(file);
+        /* ids restart with each capture */
+        open_num = 0;
+    }
+    if (span_num == 0) {
+        fprintf(stderr, "no span found\n");
+        return 1;
+    }
+    printf("%-10s %8s %10s %10s %10s\n", "span", "n", "p50 us", "p99 us", "max us");
+    for (int idx = 0; idx < span_num; idx++) {
+        span_t *sp = &span[idx];
+        qsort(sp->dur_us, sp->count, sizeof(int64_t), dur_cmp);
+        printf("%-10s %8d %10lld %10lld %10lld\n", sp->name, sp->count, (long long)percentile(sp, 50),
+               (long long)percentile(sp, 99), (long long)sp->dur_us[sp->count - 1]);
+        free(sp->dur_us);
+    }
+    return 0;
+}
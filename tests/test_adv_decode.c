@@ -0,0 +1,269 @@
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "test_assert.h"
+#include "tests.h"
+#include "adv_decode.h"
+
+/* DEFINES */
+#define FUZZ_ROUNDS         200000
+
+/* STATIC VARIABLES */
+/* captured advertisement dumps (adv data + scan response) */
+static const uint8_t adv_atc1441[] = {
+    0x02, 0x01, 0x06,
+    0x10, 0x16, 0x1A, 0x18, 0xA4, 0xC1, 0x38, 0x12, 0x34, 0x56, 0x00, 0xE6, 0x35, 0x5A, 0x0B, 0x8D, 0x2C,
+};
+static const uint8_t adv_pvvx[] = {
+    0x12, 0x16, 0x1A, 0x18, 0x56, 0x34, 0x12, 0x38, 0xC1, 0xA4, 0xF3, 0xFF, 0x6E, 0x17, 0x8D, 0x0B, 0x5A, 0x07, 0x04,
+    0x02, 0x01, 0x06,
+};
+static const uint8_t adv_bthome[] = {
+    0x02, 0x01, 0x06,
+    0x0E, 0x16, 0xD2, 0xFC, 0x40, 0x00, 0xA4, 0x01, 0x64, 0x02, 0xCA, 0x09, 0x03, 0xBF, 0x13,
+};
+static const uint8_t adv_bthome_encrypted[] = {
+    0x0A, 0x16, 0xD2, 0xFC, 0x41, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66,
+};
+static const uint8_t adv_phone[] = {
+    0x02, 0x01, 0x1A, 0x0A, 0xFF, 0x4C, 0x00, 0x10, 0x05, 0x41, 0x1C, 0x7D, 0x5E, 0x91,
+};
+static const uint8_t adv_truncated[] = {
+    0x02, 0x01, 0x06, 0x10, 0x16, 0x1A, 0x18, 0xA4, 0xC1,
+};
+/* Ruuvi RAWv2 valid data test vector */
+static const uint8_t adv_ruuvi[] = {
+    0x02, 0x01, 0x06,
+    0x1B, 0xFF, 0x99, 0x04, 0x05, 0x12, 0xFC, 0x53, 0x94, 0xC3, 0x7C, 0x00, 0x04, 0xFF, 0xFC, 0x04, 0x0C, 0xAC, 0x36,
+    0x42, 0x00, 0xCD, 0xCB, 0xB8, 0x33, 0x4C, 0x88, 0x4F,
+};
+static const uint8_t adv_ruuvi_invalid[] = {
+    0x1B, 0xFF, 0x99, 0x04, 0x05, 0x80, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0x80, 0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x00,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+static const uint8_t adv_lywsd03mmc[] = {
+    0x02, 0x01, 0x06, 0x0B, 0x09, 'L', 'Y', 'W', 'S', 'D', '0', '3', 'M', 'M', 'C',
+};
+static const uint8_t adv_lywsd03mmc_short[] = {
+    0x0A, 0x08, 'L', 'Y', 'W', 'S', 'D', '0', '3', 'M', 'M',
+};
+static const uint8_t notify_lywsd03mmc[] = {0x0A, 0x09, 0x32, 0xB8, 0x0B};
+static const uint8_t *const fuzz_seeds[] = {adv_atc1441, adv_pvvx, adv_bthome, adv_ruuvi, adv_lywsd03mmc};
+static const uint8_t fuzz_seed_len[] = {sizeof(adv_atc1441), sizeof(adv_pvvx), sizeof(adv_bthome), sizeof(adv_ruuvi), sizeof(adv_lywsd03mmc)};
+static uint32_t fuzz_state = 0x12345678;
+
+/* STATIC PROTOTYPES */
+static void test_formats(void);
+static void test_gatt(void);
+static uint32_t fuzz_rand(void);
+static uint8_t fuzz_input(uint8_t *buf);
+static void test_fuzz(void);
+static void test_dedup(void);
+static void test_fleet(void);
+
+/**
+ * @brief decode each captured format
+ * 
+ */
+static void test_formats(void) {
+    adv_reading_t r;
+
+    test_print("Advertisement formats");
+    adv_decode_init();
+    test_assert_str_eq("ATC1441", adv_decoder_get(adv_decode(adv_atc1441, sizeof(adv_atc1441), &r))->name, "ATC1441 decoder");
+    test_assert_int_eq(2300, r.temp_centi, "ATC1441 temperature");
+    test_assert_int_eq(5300, r.humid_centi, "ATC1441 humidity");
+    test_assert_int_eq(90, r.batt_pct, "ATC1441 battery");
+    test_assert_int_eq(0x2C, r.counter, "ATC1441 counter");
+
+    test_assert_str_eq("pvvx", adv_decoder_get(adv_decode(adv_pvvx, sizeof(adv_pvvx), &r))->name, "pvvx decoder");
+    test_assert_int_eq(-13, r.temp_centi, "pvvx negative temperature");
+    test_assert_int_eq(5998, r.humid_centi, "pvvx humidity");
+    test_assert_int_eq(7, r.counter, "pvvx counter");
+
+    test_assert_str_eq("BTHome", adv_decoder_get(adv_decode(adv_bthome, sizeof(adv_bthome), &r))->name, "BTHome decoder");
+    test_assert_int_eq(2506, r.temp_centi, "BTHome temperature");
+    test_assert_int_eq(5055, r.humid_centi, "BTHome humidity");
+    test_assert_int_eq(100, r.batt_pct, "BTHome battery");
+    test_assert_int_eq(0xA4, r.counter, "BTHome packet id");
+
+    test_assert_int_eq(-1, adv_decode(adv_bthome_encrypted, sizeof(adv_bthome_encrypted), &r), "encrypted BTHome skipped");
+    test_assert_int_eq(-1, adv_decode(adv_phone, sizeof(adv_phone), &r), "unrelated advert skipped");
+    test_assert_int_eq(-1, adv_decode(adv_truncated, sizeof(adv_truncated), &r), "truncated advert skipped");
+
+    test_assert_str_eq("Ruuvi", adv_decoder_get(adv_decode(adv_ruuvi, sizeof(adv_ruuvi), &r))->name, "Ruuvi decoder");
+    test_assert_int_eq(2430, r.temp_centi, "Ruuvi temperature");
+    test_assert_int_eq(5349, r.humid_centi, "Ruuvi humidity");
+    test_assert_int_eq(0xCD, r.counter, "Ruuvi sequence");
+    test_assert_int_eq(ADV_HAS_TEMP | ADV_HAS_HUMID | ADV_HAS_COUNTER, r.flags, "Ruuvi has no battery %");
+    test_assert_int_eq(-1, adv_decode(adv_ruuvi_invalid, sizeof(adv_ruuvi_invalid), &r), "Ruuvi without values skipped");
+    test_assert_int_eq(-1, adv_gatt_match(adv_ruuvi, sizeof(adv_ruuvi)), "advertising sensor is not connected to");
+}
+
+/**
+ * @brief sensor types read over GATT, found by name
+ * 
+ */
+static void test_gatt(void) {
+    adv_reading_t r;
+
+    test_print("GATT sensor types");
+    int type = adv_gatt_match(adv_lywsd03mmc, sizeof(adv_lywsd03mmc));
+    test_assert_true(type >= 0 && strcmp("LYWSD03MMC", adv_gatt_get(type)->name) == 0, "LYWSD03MMC by complete name");
+    test_assert_int_eq(-1, adv_gatt_match(adv_lywsd03mmc_short, sizeof(adv_lywsd03mmc_short)), "other name");
+    test_assert_int_eq(-1, adv_gatt_match(adv_lywsd03mmc, sizeof(adv_lywsd03mmc) - 1), "name cut by length");
+    test_assert_int_eq(-1, adv_decode(adv_lywsd03mmc, sizeof(adv_lywsd03mmc), &r), "no values in advert");
+
+    test_assert_true(adv_gatt_decode(type, notify_lywsd03mmc, sizeof(notify_lywsd03mmc), &r), "notification decoded");
+    test_assert_int_eq(2314, r.temp_centi, "LYWSD03MMC temperature");
+    test_assert_int_eq(5000, r.humid_centi, "LYWSD03MMC humidity");
+    test_assert_true(adv_gatt_decode(type, notify_lywsd03mmc, 3, &r), "notification without battery");
+    test_assert_true(!adv_gatt_decode(type, notify_lywsd03mmc, 2, &r), "short notification");
+    test_assert_true(!adv_gatt_decode(-1, notify_lywsd03mmc, sizeof(notify_lywsd03mmc), &r), "unknown type");
+}
+
+/**
+ * @brief xorshift32, fixed seed so failures reproduce
+ * 
+ * @return next value
+ */
+static uint32_t fuzz_rand(void) {
+    fuzz_state ^= fuzz_state << 13;
+    fuzz_state ^= fuzz_state >> 17;
+    fuzz_state ^= fuzz_state << 5;
+    return fuzz_state;
+}
+
+/**
+ * @brief random bytes, a mutated capture, or a known AD header with random payload
+ * 
+ * @param buf 255 bytes
+ * @return input length
+ */
+static uint8_t fuzz_input(uint8_t *buf) {
+    static const uint8_t heads[][4] = {
+        {0x16, 0x1A, 0x18}, {0x16, 0xD2, 0xFC}, {0xFF, 0x99, 0x04},
+    };
+    uint32_t kind = fuzz_rand() % 3;
+    uint8_t len = (uint8_t)(fuzz_rand() % 64);
+    for (int i = 0; i < len; i++) {
+        buf[i] = (uint8_t)fuzz_rand();
+    }
+    if (kind == 1) {
+        int seed = (int)(fuzz_rand() % (sizeof(fuzz_seeds) / sizeof(fuzz_seeds[0])));
+        len = fuzz_seed_len[seed];
+        memcpy(buf, fuzz_seeds[seed], len);
+        for (int flips = fuzz_rand() % 4; flips >= 0; flips--) {
+            buf[fuzz_rand() % len] = (uint8_t)fuzz_rand();
+        }
+        len = (uint8_t)(len - fuzz_rand() % 3);
+    } else if (kind == 2 && len >= 4) {
+        /* AD length may claim more than the input holds */
+        buf[0] = (uint8_t)(fuzz_rand() % 2 ? (uint32_t)len - 1 : fuzz_rand());
+        memcpy(&buf[1], heads[fuzz_rand() % 3], 3);
+    }
+    return len;
+}
+
+/**
+ * @brief random and mutated inputs end at a guard page, any read past them faults
+ * 
+ */
+static void test_fuzz(void) {
+    long page = sysconf(_SC_PAGESIZE);
+    uint8_t *map = mmap(NULL, page * 2, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    uint8_t buf[255];
+    adv_reading_t r;
+    int decoded = 0;
+    int bad = 0;
+
+    test_print("Fuzz %d inputs", FUZZ_ROUNDS);
+    test_assert_true(map != MAP_FAILED && mprotect(map + page, page, PROT_NONE) == 0, "guard page");
+    adv_decode_init();
+    for (int n = 0; n < FUZZ_ROUNDS; n++) {
+        uint8_t len = fuzz_input(buf);
+        uint8_t *in = map + page - len;
+        memcpy(in, buf, len);
+        int dec = adv_decode(in, len, &r);
+        if (dec >= 0) {
+            decoded++;
+            bad += (adv_decoder_get(dec) == NULL || r.flags == 0 || (r.flags & ~0x0F));
+        }
+        adv_gatt_match(in, len);
+        if (adv_gatt_decode(0, in, len, &r)) {
+            bad += (r.flags != (ADV_HAS_TEMP | ADV_HAS_HUMID));
+        }
+    }
+    test_print("   decoded %d", decoded);
+    test_assert_true(decoded > 0, "decoders reached");
+    test_assert_int_eq(0, bad, "decoded readings consistent");
+    munmap(map, page * 2);
+}
+
+/**
+ * @brief repeated adverts of the same frame are reported once
+ * 
+ */
+static void test_dedup(void) {
+    static const uint8_t bda[ADV_BDA_LEN] = {0xA4, 0xC1, 0x38, 0x12, 0x34, 0x56};
+    adv_reading_t r;
+    bool is_new;
+
+    test_print("Per-device dedup");
+    adv_decode_init();
+    int dec = adv_decode(adv_atc1441, sizeof(adv_atc1441), &r);
+    adv_dev_t *dev = adv_dev_update(bda, dec, &r, 0, &is_new);
+    test_assert_true(dev != NULL && is_new, "first advert is new");
+    for (uint32_t t = 1; t < 10; t++) {
+        adv_dev_update(bda, dec, &r, t, &is_new);
+        test_assert_true(!is_new, "repeat dropped");
+    }
+    r.counter++;
+    test_assert_true(adv_dev_update(bda, dec, &r, 10, &is_new) == dev && is_new, "next frame is new");
+    test_assert_int_eq(11, (int32_t)dev->rx_count, "rx count");
+    test_assert_int_eq(9, (int32_t)dev->dup_count, "dup count");
+    test_assert_int_eq(1, adv_dev_count(), "one device");
+}
+
+/**
+ * @brief hundreds of devices fill the fixed-size table without losing known ones
+ * 
+ */
+static void test_fleet(void) {
+    uint8_t bda[ADV_BDA_LEN] = {0xA4, 0xC1, 0x38, 0, 0, 0};
+    adv_reading_t r;
+    bool is_new;
+    int fit = ADV_DEV_MAX * 3 / 4;
+
+    test_print("Device fleet");
+    adv_decode_init();
+    int dec = adv_decode(adv_pvvx, sizeof(adv_pvvx), &r);
+    for (int n = 0; n < ADV_DEV_MAX; n++) {
+        bda[4] = (uint8_t)(n >> 8);
+        bda[5] = (uint8_t)n;
+        adv_dev_update(bda, dec, &r, 0, &is_new);
+    }
+    test_assert_int_eq(fit, adv_dev_count(), "table load capped");
+    test_assert_int_eq(ADV_DEV_MAX - fit, (int32_t)adv_dev_overflow(), "overflow counted");
+    bda[4] = 0;
+    bda[5] = 1;
+    test_assert_true(adv_dev_update(bda, dec, &r, 1, &is_new) != NULL && !is_new, "known device still found");
+}
+
+/**
+ * @brief decoder table and dedup against captured advert dumps
+ * 
+ */
+void test_adv_decode(void) {
+    test_print("");
+    test_print("***********************");
+    test_print("Start adv_decode tests");
+    test_print("***********************");
+
+    test_formats();
+    test_gatt();
+    test_fuzz();
+    test_dedup();
+    test_fleet();
+}
@@ -0,0 +1,62 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "test_assert.h"
+
+/**
+ * @brief print a line of test output
+ * 
+ * @param s printf-like format
+ */
+void test_print(const char *s, ...) {
+    va_list args;
+    va_start(args, s);
+    vfprintf(stdout, s, args);
+    fprintf(stdout, "\n");
+    va_end(args);
+}
+
+/**
+ * @brief fail the test run if expression is false
+ * 
+ * @param expression 
+ * @param s description
+ */
+void test_assert_true(int32_t expression, const char *s) {
+    if (!expression) {
+        fprintf(stderr, "   FAIL: %s\n", s);
+        exit(1);
+    }
+    test_print("   PASS: %s", s);
+}
+
+/**
+ * @brief fail the test run if integers differ
+ * 
+ * @param n_ref expected
+ * @param n_act actual
+ * @param s description
+ */
+void test_assert_int_eq(int32_t n_ref, int32_t n_act, const char *s) {
+    if (n_ref != n_act) {
+        fprintf(stderr, "   FAIL: %s. (Expected: %d, Actual: %d)\n", s, n_ref, n_act);
+        exit(1);
+    }
+    test_print("   PASS: %s. (Expected: %d)", s, n_ref);
+}
+
+/**
+ * @brief fail the test run if strings differ
+ * 
+ * @param str_ref expected
+ * @param str_act actual
+ * @param s description
+ */
+void test_assert_str_eq(const char *str_ref, const char *str_act, const char *s) {
+    if (strcmp(str_ref, str_act) != 0) {
+        fprintf(stderr, "   FAIL: %s. (Expected: %s, Actual: %s)\n", s, str_ref, str_act);
+        exit(1);
+    }
+    test_print("   PASS: %s. (Expected: %s)", s, str_ref);
+}
@@ -0,0 +1,16 @@
+#ifndef _TEST_ASSERT_H
+#define _TEST_ASSERT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/**********************
+ *  PUBLIC PROTOTYPES
+ **********************/
+void test_print(const char *s, ...);
+void test_assert_true(int32_t expression, const char *s);
+void test_assert_int_eq(int32_t n_ref, int32_t n_act, const char *s);
+void test_assert_str_eq(const char *str_ref, const char *str_act, const char *s);
+
+#endif
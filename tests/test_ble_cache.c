@@ -0,0 +1,128 @@
+#include <string.h>
+
+#include "test_assert.h"
+#include "tests.h"
+#include "ble_cache.h"
+
+/* STATIC VARIABLES */
+static ble_cache_t cache;
+
+/* STATIC PROTOTYPES */
+static ble_cache_dev_t sim_entry(int dev, uint16_t char_handle);
+static void test_lookup(void);
+static void test_evict(void);
+static void test_load(void);
+
+/**
+ * @brief handles of a simulated device
+ *
+ * @param dev
+ * @param char_handle
+ * @return entry
+ */
+static ble_cache_dev_t sim_entry(int dev, uint16_t char_handle) {
+    ble_cache_dev_t entry;
+    memset(&entry, 0, sizeof(entry));
+    memset(entry.bda, 0xA0, BLE_BDA_LEN);
+    entry.bda[BLE_BDA_LEN - 1] = (uint8_t)dev;
+    entry.service_start = 0x20;
+    entry.service_end = 0x40;
+    entry.char_handle = char_handle;
+    return entry;
+}
+
+/**
+ * @brief hit after store, handle change counted as mismatch, flash write only on change
+ *
+ */
+static void test_lookup(void) {
+    ble_cache_dev_t entry = sim_entry(1, 0x36);
+    ble_cache_init(&cache);
+
+    test_assert_true(ble_cache_lookup(&cache, entry.bda, 0) == NULL, "empty cache misses");
+    test_assert_int_eq(BLE_CACHE_ADDED, ble_cache_store(&cache, &entry, NULL), "first store adds");
+    test_assert_true(ble_cache_take_dirty(&cache), "new device saved");
+    test_assert_true(!ble_cache_take_dirty(&cache), "saved once");
+
+    const ble_cache_dev_t *dev = ble_cache_lookup(&cache, entry.bda, 0);
+    test_assert_true(dev != NULL && dev->char_handle == 0x36, "hit");
+    test_assert_true(ble_cache_lookup(&cache, entry.bda, 1) == NULL, "other sensor type misses");
+    test_assert_int_eq(1, (int32_t)cache.hit_count, "hits");
+    test_assert_int_eq(2, (int32_t)cache.miss_count, "misses");
+
+    test_assert_int_eq(BLE_CACHE_SAME, ble_cache_store(&cache, &entry, NULL), "reconnect on same handles");
+    test_assert_true(!ble_cache_take_dirty(&cache), "use time alone not saved");
+    entry.char_handle = 0x39;
+    test_assert_int_eq(BLE_CACHE_UPDATED, ble_cache_store(&cache, &entry, NULL), "new handle");
+    test_assert_int_eq(1, (int32_t)cache.mismatch_count, "mismatch counted");
+    test_assert_true(ble_cache_take_dirty(&cache), "new handle saved");
+    test_assert_int_eq(0x39, ble_cache_lookup(&cache, entry.bda, 0)->char_handle, "new handle cached");
+
+    test_assert_true(ble_cache_invalidate(&cache, entry.bda), "forget device");
+    test_assert_true(!ble_cache_invalidate(&cache, entry.bda), "forgotten");
+    test_assert_int_eq(0, ble_cache_count(&cache), "empty");
+    test_assert_true(ble_cache_take_dirty(&cache), "removal saved");
+}
+
+/**
+ * @brief full cache replaces the device not used for longest
+ *
+ */
+static void test_evict(void) {
+    ble_cache_dev_t evicted;
+    ble_cache_init(&cache);
+    for (int dev = 0; dev < BLE_CACHE_MAX; dev++) {
+        ble_cache_dev_t entry = sim_entry(dev, 0x36);
+        test_assert_int_eq(BLE_CACHE_ADDED, ble_cache_store(&cache, &entry, NULL), "fill");
+    }
+    /* device 0 reconnects, device 1 is now the oldest */
+    ble_cache_dev_t entry = sim_entry(0, 0x36);
+    ble_cache_store(&cache, &entry, NULL);
+    entry = sim_entry(BLE_CACHE_MAX, 0x36);
+    test_assert_int_eq(BLE_CACHE_REPLACED, ble_cache_store(&cache, &entry, &evicted), "full cache replaces");
+    test_assert_int_eq(1, evicted.bda[BLE_BDA_LEN - 1], "least recently used evicted");
+    test_assert_int_eq(BLE_CACHE_MAX, ble_cache_count(&cache), "still full");
+    test_assert_true(ble_cache_lookup(&cache, entry.bda, 0) != NULL, "new device cached");
+    test_assert_true(ble_cache_lookup(&cache, evicted.bda, 0) == NULL, "evicted device gone");
+    test_assert_true(ble_cache_get(&cache, BLE_CACHE_MAX) == NULL, "index range");
+}
+
+/**
+ * @brief blob round trip, foreign or damaged blobs are dropped
+ *
+ */
+static void test_load(void) {
+    static ble_cache_blob_t blob;
+    ble_cache_dev_t entry = sim_entry(3, 0x36);
+    ble_cache_init(&cache);
+    ble_cache_store(&cache, &entry, NULL);
+    memcpy(&blob, &cache.blob, sizeof(blob));
+
+    test_assert_true(ble_cache_load(&cache, &blob, sizeof(blob)), "saved blob loads");
+    test_assert_true(ble_cache_lookup(&cache, entry.bda, 0) != NULL, "device back after reboot");
+    test_assert_true(!ble_cache_take_dirty(&cache), "nothing to save after load");
+
+    test_assert_true(!ble_cache_load(&cache, &blob, sizeof(blob) - 4), "size of older layout");
+    test_assert_int_eq(0, ble_cache_count(&cache), "dropped");
+    blob.magic ^= 1;
+    test_assert_true(!ble_cache_load(&cache, &blob, sizeof(blob)), "wrong magic");
+    blob.magic ^= 1;
+    blob.count = BLE_CACHE_MAX + 1;
+    test_assert_true(!ble_cache_load(&cache, &blob, sizeof(blob)), "count out of range");
+    test_assert_int_eq(0, ble_cache_count(&cache), "empty after bad blob");
+}
+
+/**
+ * @brief GATT handle cache unit tests
+ *
+ */
+void test_ble_cache(void) {
+    test_print("");
+    test_print("*************************");
+    test_print("Start ble_cache tests");
+    test_print("*************************");
+
+    test_lookup();
+    test_evict();
+    test_load();
+}
@@ -0,0 +1,287 @@
+#include <string.h>
+
+#include "test_assert.h"
+#include "tests.h"
+#include "ble_conn.h"
+
+/* DEFINES */
+#define SIM_DEV_NUM     (BLE_CONN_MAX + 1)
+
+/* STATIC VARIABLES */
+static uint8_t sim_bda[SIM_DEV_NUM][BLE_BDA_LEN];
+
+/* STATIC PROTOTYPES */
+static void sim_bda_init(void);
+static void sim_connect(int dev, uint16_t conn_id);
+static void sim_discover(uint16_t conn_id, uint16_t char_handle);
+static void test_single(void);
+static void test_multi(void);
+static void test_interleaved(void);
+static void test_failures(void);
+static void test_cached(void);
+static void test_shared_handle(void);
+
+/**
+ * @brief fill distinct remote addresses
+ * 
+ */
+static void sim_bda_init(void) {
+    for (int dev = 0; dev < SIM_DEV_NUM; dev++) {
+        memset(sim_bda[dev], 0xA0, BLE_BDA_LEN);
+        sim_bda[dev][BLE_BDA_LEN - 1] = (uint8_t)dev;
+    }
+}
+
+/**
+ * @brief replay SCAN_RESULT -> CONNECT_EVT for one device
+ * 
+ * @param dev 
+ * @param conn_id 
+ */
+static void sim_connect(int dev, uint16_t conn_id) {
+    ble_conn_t *conn = NULL;
+    test_assert_int_eq(BLE_CONN_ACT_OPEN, ble_conn_on_adv(sim_bda[dev], &conn), "adv opens slot");
+    test_assert_int_eq(BLE_CONN_ACT_NONE, ble_conn_on_adv(sim_bda[dev], NULL), "repeated adv ignored");
+    test_assert_true(!ble_conn_scan_wanted(), "no scan while open pending");
+    test_assert_int_eq(BLE_CONN_ACT_MTU_REQ, ble_conn_on_connect(conn_id, sim_bda[dev], NULL), "connect sends MTU");
+    test_assert_true(ble_conn_find_id(conn_id) == conn, "conn_id bound to slot");
+}
+
+/**
+ * @brief replay DIS_SRVC_CMPL -> SEARCH_RES -> SEARCH_CMPL -> char lookup -> REG_FOR_NOTIFY
+ * 
+ * @param conn_id 
+ * @param char_handle 
+ */
+static void sim_discover(uint16_t conn_id, uint16_t char_handle) {
+    ble_conn_t *conn = NULL;
+    test_assert_int_eq(BLE_CONN_ACT_SEARCH, ble_conn_on_dis_srvc_cmpl(conn_id, &conn), "search service");
+    ble_conn_on_search_res(conn_id, 0x20, 0x40);
+    test_assert_int_eq(BLE_CONN_ACT_GET_CHAR, ble_conn_on_search_cmpl(conn_id, NULL), "service found");
+    test_assert_int_eq(BLE_CONN_ACT_REG_NOTIFY, ble_conn_on_char(conn_id, char_handle, NULL), "register notify");
+    test_assert_int_eq(BLE_CONN_ACT_NONE, ble_conn_on_reg_notify(char_handle, true, NULL), "notify registered");
+    test_assert_int_eq(BLE_CONN_READY, conn->state, "slot ready");
+}
+
+/**
+ * @brief one device, full discovery then disconnect
+ * 
+ */
+static void test_single(void) {
+    test_print("Single connection");
+    ble_conn_init();
+    test_assert_true(ble_conn_scan_wanted(), "scan at start");
+    sim_connect(0, 0);
+    test_assert_true(ble_conn_scan_wanted() == (BLE_CONN_MAX > 1), "scan resumes after connect");
+    sim_discover(0, 0x36);
+    test_assert_true(ble_conn_on_notify(0) != NULL, "notify routed");
+    test_assert_true(ble_conn_on_notify(7) == NULL, "unknown conn_id dropped");
+    ble_conn_on_disconnect(0, sim_bda[0]);
+    test_assert_int_eq(BLE_CONN_MAX, ble_conn_count(BLE_CONN_FREE), "slot released");
+}
+
+/**
+ * @brief N devices connected one after another, then table full
+ * 
+ */
+static void test_multi(void) {
+    test_print("Sequential connections 1..N");
+    ble_conn_init();
+    for (int dev = 0; dev < BLE_CONN_MAX; dev++) {
+        sim_connect(dev, (uint16_t)(dev + 1));
+        sim_discover((uint16_t)(dev + 1), 0x36);
+        test_assert_int_eq(dev + 1, ble_conn_count(BLE_CONN_READY), "ready count");
+    }
+    test_assert_true(!ble_conn_scan_wanted(), "scan stops when full");
+    test_assert_int_eq(BLE_CONN_ACT_NONE, ble_conn_on_adv(sim_bda[BLE_CONN_MAX], NULL), "no slot for extra device");
+    for (int dev = 0; dev < BLE_CONN_MAX; dev++) {
+        ble_conn_t *conn = ble_conn_on_notify((uint16_t)(dev + 1));
+        test_assert_int_eq(dev, ble_conn_index(conn), "notify maps to own slot");
+    }
+    ble_conn_on_disconnect(1, sim_bda[0]);
+    test_assert_true(ble_conn_scan_wanted(), "scan re-armed on disconnect");
+    sim_connect(BLE_CONN_MAX, 9);
+    test_assert_int_eq(0, ble_conn_index(ble_conn_find_id(9)), "freed slot reused");
+}
+
+/**
+ * @brief discovery steps of several links interleaved, same char handle on every device
+ * 
+ */
+static void test_interleaved(void) {
+    test_print("Interleaved discovery");
+    ble_conn_init();
+    for (int dev = 0; dev < BLE_CONN_MAX; dev++) {
+        sim_connect(dev, (uint16_t)(10 + dev));
+        test_assert_int_eq(BLE_CONN_ACT_SEARCH, ble_conn_on_dis_srvc_cmpl((uint16_t)(10 + dev), NULL), "search");
+    }
+    for (int dev = BLE_CONN_MAX - 1; dev >= 0; dev--) {
+        ble_conn_on_search_res((uint16_t)(10 + dev), 0x20, 0x40);
+        test_assert_int_eq(BLE_CONN_ACT_GET_CHAR, ble_conn_on_search_cmpl((uint16_t)(10 + dev), NULL), "search cmpl");
+        test_assert_int_eq((dev == BLE_CONN_MAX - 1) ? BLE_CONN_ACT_REG_NOTIFY : BLE_CONN_ACT_NONE,
+                           ble_conn_on_char((uint16_t)(10 + dev), 0x36, NULL), "char, one registration at a time");
+    }
+    test_assert_int_eq(1, ble_conn_count(BLE_CONN_REGISTERING), "one registering");
+    for (int dev = 0; dev < BLE_CONN_MAX; dev++) {
+        ble_conn_on_reg_notify(0x36, true, NULL);
+        ble_conn_next_reg(NULL);
+    }
+    test_assert_int_eq(BLE_CONN_MAX, ble_conn_count(BLE_CONN_READY), "all ready");
+    test_assert_int_eq(BLE_CONN_ACT_NONE, ble_conn_on_dis_srvc_cmpl(10, NULL), "stale event ignored");
+}
+
+/**
+ * @brief open failure, missing service, missing characteristic
+ * 
+ */
+static void test_failures(void) {
+    ble_conn_t *conn = NULL;
+
+    test_print("Failure paths");
+    ble_conn_init();
+    ble_conn_on_adv(sim_bda[0], NULL);
+    ble_conn_on_open_failed(sim_bda[0]);
+    test_assert_int_eq(BLE_CONN_MAX, ble_conn_count(BLE_CONN_FREE), "open failure releases slot");
+
+    sim_connect(0, 1);
+    ble_conn_on_dis_srvc_cmpl(1, NULL);
+    test_assert_int_eq(BLE_CONN_ACT_CLOSE, ble_conn_on_search_cmpl(1, &conn), "no service closes");
+    test_assert_int_eq(1, conn->conn_id, "close targets link");
+
+    sim_connect(1, 2);
+    ble_conn_on_dis_srvc_cmpl(2, NULL);
+    ble_conn_on_search_res(2, 0x20, 0x40);
+    ble_conn_on_search_cmpl(2, NULL);
+    test_assert_int_eq(BLE_CONN_ACT_CLOSE, ble_conn_on_char(2, 0, NULL), "no char closes");
+
+    test_assert_int_eq(BLE_CONN_ACT_MTU_REQ, ble_conn_on_connect(5, sim_bda[2], NULL), "unsolicited connect adopted");
+}
+
+/**
+ * @brief reconnect on cached handles: registered before discovery, checked after it,
+ *        stale handles fall back to discovery
+ * 
+ */
+static void test_cached(void) {
+    ble_conn_t *conn = NULL;
+
+    test_print("Cached handles");
+    ble_conn_init();
+
+    /* handles still valid: ready before discovery completes */
+    sim_connect(0, 1);
+    test_assert_int_eq(BLE_CONN_ACT_REG_NOTIFY, ble_conn_on_cached(1, 0x20, 0x40, 0x36, &conn), "register cached handle");
+    test_assert_int_eq(0x36, conn->char_handle, "cached handle used");
+    test_assert_int_eq(BLE_CONN_ACT_NONE, ble_conn_on_reg_notify(0x36, true, NULL), "registered");
+    test_assert_int_eq(BLE_CONN_READY, conn->state, "ready without discovery");
+    test_assert_int_eq(BLE_CONN_ACT_VERIFY, ble_conn_on_dis_srvc_cmpl(1, NULL), "discovery checks cache");
+    test_assert_int_eq(BLE_CONN_ACT_NONE, ble_conn_on_verify(1, 0x36, NULL), "handle holds");
+    test_assert_true(!conn->cached && conn->state == BLE_CONN_READY, "verified, still ready");
+    test_assert_int_eq(BLE_CONN_ACT_NONE, ble_conn_on_verify(1, 0x36, NULL), "verified once");
+    test_assert_int_eq(BLE_CONN_ACT_NONE, ble_conn_on_cached(1, 0x20, 0x40, 0x36, NULL), "only while waiting for discovery");
+
+    /* handle moved, registration accepted: discovery finds the new one */
+    sim_connect(1, 2);
+    ble_conn_on_cached(2, 0x20, 0x40, 0x36, &conn);
+    ble_conn_on_reg_notify(0x36, true, NULL);
+    test_assert_int_eq(BLE_CONN_ACT_VERIFY, ble_conn_on_dis_srvc_cmpl(2, NULL), "check cache");
+    test_assert_int_eq(BLE_CONN_ACT_SEARCH, ble_conn_on_verify(2, 0x39, NULL), "mismatch rediscovers");
+    test_assert_int_eq(BLE_CONN_SEARCHING, conn->state, "searching");
+    ble_conn_on_search_res(2, 0x20, 0x48);
+    test_assert_int_eq(BLE_CONN_ACT_GET_CHAR, ble_conn_on_search_cmpl(2, NULL), "service found");
+    test_assert_int_eq(BLE_CONN_ACT_REG_NOTIFY, ble_conn_on_char(2, 0x39, NULL), "new handle");
+    ble_conn_on_reg_notify(0x39, true, NULL);
+    test_assert_true(conn->state == BLE_CONN_READY && conn->service_end_handle == 0x48, "ready on new handles");
+
+    /* handle refused before discovery: wait for it, then search */
+    sim_connect(2, 3);
+    ble_conn_on_cached(3, 0x20, 0x40, 0x36, &conn);
+    test_assert_int_eq(BLE_CONN_ACT_NONE, ble_conn_on_reg_notify(0x36, false, NULL), "stale handle, no close");
+    test_assert_int_eq(BLE_CONN_MTU, conn->state, "waiting for discovery");
+    test_assert_int_eq(BLE_CONN_ACT_SEARCH, ble_conn_on_dis_srvc_cmpl(3, NULL), "full discovery");
+
+    /* handle refused after discovery: search at once */
+    ble_conn_on_disconnect(3, sim_bda[2]);
+    sim_connect(2, 4);
+    ble_conn_on_cached(4, 0x20, 0x40, 0x36, &conn);
+    test_assert_int_eq(BLE_CONN_ACT_VERIFY, ble_conn_on_dis_srvc_cmpl(4, NULL), "check cache");
+    test_assert_int_eq(BLE_CONN_ACT_SEARCH, ble_conn_on_reg_notify(0x36, false, NULL), "refused, search");
+
+    /* characteristic gone */
+    ble_conn_on_disconnect(4, sim_bda[2]);
+    sim_connect(2, 5);
+    ble_conn_on_cached(5, 0x20, 0x40, 0x36, NULL);
+    ble_conn_on_dis_srvc_cmpl(5, NULL);
+    test_assert_int_eq(BLE_CONN_ACT_CLOSE, ble_conn_on_verify(5, 0, &conn), "no char closes");
+    test_assert_int_eq(5, conn->conn_id, "close targets link");
+}
+
+/**
+ * @brief two sensors of the same model: REG_FOR_NOTIFY_EVT carries only the shared handle,
+ *        it must complete the slot that registered
+ * 
+ */
+static void test_shared_handle(void) {
+    ble_conn_t *first = NULL;
+    ble_conn_t *second = NULL;
+    ble_conn_t *conn = NULL;
+
+    test_print("Shared notify handle");
+    ble_conn_init();
+    sim_connect(0, 1);
+    sim_connect(1, 2);
+    ble_conn_on_dis_srvc_cmpl(2, NULL);
+    ble_conn_on_search_res(2, 0x20, 0x40);
+    ble_conn_on_search_cmpl(2, NULL);
+    test_assert_int_eq(BLE_CONN_ACT_REG_NOTIFY, ble_conn_on_char(2, 0x36, &second), "higher slot registers first");
+    ble_conn_on_dis_srvc_cmpl(1, NULL);
+    ble_conn_on_search_res(1, 0x20, 0x40);
+    ble_conn_on_search_cmpl(1, NULL);
+    test_assert_int_eq(BLE_CONN_ACT_NONE, ble_conn_on_char(1, 0x36, &first), "lower slot queued");
+    test_assert_int_eq(BLE_CONN_REG_QUEUED, first->state, "queued");
+    test_assert_int_eq(BLE_CONN_ACT_NONE, ble_conn_next_reg(NULL), "nothing started while one is outstanding");
+
+    test_assert_int_eq(BLE_CONN_ACT_CLOSE, ble_conn_on_reg_notify(0x36, false, &conn), "failure closes");
+    test_assert_true(conn == second, "close targets the slot that registered");
+    test_assert_int_eq(BLE_CONN_REG_QUEUED, first->state, "other slot untouched");
+    test_assert_int_eq(BLE_CONN_ACT_REG_NOTIFY, ble_conn_next_reg(&conn), "queued slot registers next");
+    test_assert_true(conn == first, "next is the queued slot");
+    test_assert_int_eq(BLE_CONN_ACT_NONE, ble_conn_on_reg_notify(0x36, true, &conn), "registered");
+    test_assert_true(conn == first && first->state == BLE_CONN_READY, "ready");
+
+    /* the registering link drops before its event: the queue moves on */
+    ble_conn_init();
+    sim_connect(0, 1);
+    sim_connect(1, 2);
+    ble_conn_on_cached(1, 0x20, 0x40, 0x36, &first);
+    test_assert_int_eq(BLE_CONN_ACT_NONE, ble_conn_on_cached(2, 0x20, 0x40, 0x36, &second), "cached queued too");
+    ble_conn_on_disconnect(1, sim_bda[0]);
+    test_assert_int_eq(BLE_CONN_ACT_REG_NOTIFY, ble_conn_next_reg(&conn), "next after disconnect");
+    test_assert_true(conn == second, "queued slot");
+
+    /* notification ahead of the event: the event still belongs to that slot */
+    ble_conn_on_notify(2);
+    test_assert_int_eq(BLE_CONN_READY, second->state, "ready on notify");
+    test_assert_int_eq(BLE_CONN_ACT_NONE, ble_conn_next_reg(NULL), "event still outstanding");
+    ble_conn_on_reg_notify(0x36, true, &conn);
+    test_assert_true(conn == second && !second->reg_pending, "late event completes it");
+}
+
+/**
+ * @brief simulate GAP/GATTC callback sequences against the connection table
+ * 
+ */
+void test_ble_conn(void) {
+    test_print("");
+    test_print("*********************");
+    test_print("Start ble_conn tests");
+    test_print("*********************");
+
+    sim_bda_init();
+    test_single();
+    test_multi();
+    test_interleaved();
+    test_failures();
+    test_cached();
+    test_shared_handle();
+}
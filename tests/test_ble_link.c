@@ -0,0 +1,259 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "test_assert.h"
+#include "tests.h"
+#include "ble_link.h"
+
+/* DEFINES */
+#define SEC_US          1000000LL
+#define REASON_REMOTE   0x13    /* remote user terminated */
+#define REASON_LOCAL    0x16
+
+/* STATIC VARIABLES */
+static const ble_link_cfg_t cfg_default = {
+    .rssi_period_ms = 30000,
+    .retry_ms = 60000,
+    .slow_ms = 1000,
+    .interval_min_ms = 30,
+    .interval_max_ms = 200,
+    .latency_max = 4,
+    .rssi_weak = -85,
+    .timeout_max = 3,
+};
+static const uint8_t bda_a[BLE_BDA_LEN] = {0xa4, 0xc1, 0x38, 0x00, 0x00, 0x01};
+static ble_link_tab_t tab;
+
+/* STATIC PROTOTYPES */
+static int notify_every(const uint8_t *bda, int64_t *now_us, int64_t period_us, int count, ble_link_params_t *req);
+static void test_period(void);
+static void test_policy(void);
+static void test_rssi(void);
+static void test_disconnect(void);
+static void test_replace(void);
+static void test_format(void);
+
+/**
+ * @brief notifications at a fixed period on the simulated clock
+ *
+ * @param bda
+ * @param now_us [in/out] time of the last notification
+ * @param period_us
+ * @param count
+ * @param req [out] last parameter request
+ * @return actions of all notifications or'ed
+ */
+static int notify_every(const uint8_t *bda, int64_t *now_us, int64_t period_us, int count, ble_link_params_t *req) {
+    int act = 0;
+    for (int idx = 0; idx < count; idx++) {
+        *now_us += period_us;
+        act |= ble_link_on_notify(&tab, bda, *now_us, req);
+    }
+    return act;
+}
+
+/**
+ * @brief notify period is learnt, longer gaps count missed notifies until the sensor is seen slower
+ *
+ */
+static void test_period(void) {
+    ble_link_params_t req;
+    int64_t now_us = SEC_US;
+    ble_link_init(&tab, &cfg_default);
+    ble_link_t *link = ble_link_on_connect(&tab, bda_a, now_us);
+    test_assert_true(link != NULL && link->connected && link->connect_count == 1, "link tracked");
+    notify_every(bda_a, &now_us, 6 * SEC_US, 4, &req);
+    test_assert_int_eq(6000, (int32_t)link->period_ms, "period learnt");
+    test_assert_int_eq(BLE_LINK_GAPS_MIN, link->gaps, "period trusted");
+    test_assert_int_eq(4, (int32_t)link->notify_count, "notifies counted");
+    notify_every(bda_a, &now_us, 18 * SEC_US, 1, &req);
+    test_assert_int_eq(2, (int32_t)link->missed_count, "two notifies missed");
+    test_assert_int_eq(6000, (int32_t)link->period_ms, "period kept");
+    notify_every(bda_a, &now_us, 8 * SEC_US, 1, &req);
+    test_assert_int_eq(2, (int32_t)link->missed_count, "late notify is not a miss");
+    test_assert_int_eq(6250, (int32_t)link->period_ms, "period follows");
+    notify_every(bda_a, &now_us, 60 * SEC_US, BLE_LINK_GAPS_MIN, &req);
+    test_assert_int_eq(29, (int32_t)link->missed_count, "slowed down, counted as missed first");
+    test_assert_int_eq(60000, (int32_t)link->period_ms, "period learnt again");
+    test_assert_int_eq(1, link->gaps, "new period not trusted yet");
+    test_assert_int_eq(0, ble_link_on_notify(&tab, (const uint8_t *)"\x01\x02\x03\x04\x05\x06", now_us, &req),
+                       "unknown device");
+}
+
+/**
+ * @brief slow sensors get long intervals and latency, fast, weak and unstable ones do not
+ *
+ */
+static void test_policy(void) {
+    ble_link_params_t req;
+    int64_t now_us = SEC_US;
+    ble_link_init(&tab, &cfg_default);
+    ble_link_t *link = ble_link_on_connect(&tab, bda_a, now_us);
+    int act = notify_every(bda_a, &now_us, 6 * SEC_US, 3, &req);
+    test_assert_int_eq(0, act & BLE_LINK_ACT_UPDATE, "no request before the period is trusted");
+    act = notify_every(bda_a, &now_us, 6 * SEC_US, 1, &req);
+    test_assert_int_eq(BLE_LINK_ACT_UPDATE, act & BLE_LINK_ACT_UPDATE, "slow sensor tuned");
+    test_assert_int_eq(160, req.interval, "200 ms interval");
+    test_assert_int_eq(4, req.latency, "latency capped");
+    test_assert_int_eq(600, req.timeout, "6 s supervision timeout");
+    test_assert_int_eq(0, notify_every(bda_a, &now_us, 6 * SEC_US, 1, &req) & BLE_LINK_ACT_UPDATE, "one request in flight");
+    ble_link_on_params(&tab, bda_a, &req, true);
+    test_assert_int_eq(1, (int32_t)link->update_count, "update in force");
+    now_us += 120 * SEC_US;
+    link->notify_us = 0;
+    test_assert_int_eq(0, notify_every(bda_a, &now_us, 6 * SEC_US, 2, &req) & BLE_LINK_ACT_UPDATE, "nothing to change");
+
+    /* 1.2 s period: short interval, latency still fits a quarter period */
+    link->period_ms = 1200;
+    test_assert_true(ble_link_target(&cfg_default, link, &req), "1.2 s sensor tuned");
+    test_assert_true(req.interval == 48 && req.latency == 4 && req.timeout == 200, "60 ms, latency 4, 2 s timeout");
+    link->period_ms = 500;
+    test_assert_true(!ble_link_target(&cfg_default, link, &req), "fast sensor left alone");
+    link->period_ms = 6000;
+    link->rssi = -90;
+    test_assert_true(ble_link_target(&cfg_default, link, &req) && req.latency == 0, "weak link without latency");
+    test_assert_int_eq(200, req.timeout, "timeout at least 2 s");
+    link->rssi = -60;
+    link->timeout_count = cfg_default.timeout_max;
+    test_assert_true(!ble_link_target(&cfg_default, link, &req), "unstable link left at defaults");
+
+    /* refused request is retried after retry_ms */
+    link->timeout_count = 0;
+    memset(&link->params, 0, sizeof(link->params));
+    link->request_us = 0;
+    test_assert_int_eq(BLE_LINK_ACT_UPDATE, notify_every(bda_a, &now_us, 6 * SEC_US, 1, &req) & BLE_LINK_ACT_UPDATE, "request");
+    ble_link_on_params(&tab, bda_a, &req, false);
+    test_assert_int_eq(1, (int32_t)link->reject_count, "refusal counted");
+    test_assert_int_eq(0, notify_every(bda_a, &now_us, 6 * SEC_US, 9, &req) & BLE_LINK_ACT_UPDATE, "no retry within 60 s");
+    test_assert_int_eq(BLE_LINK_ACT_UPDATE, notify_every(bda_a, &now_us, 6 * SEC_US, 1, &req) & BLE_LINK_ACT_UPDATE, "retry");
+}
+
+/**
+ * @brief connection RSSI is read every rssi_period_ms, lowest value kept
+ *
+ */
+static void test_rssi(void) {
+    ble_link_params_t req;
+    int64_t now_us = SEC_US;
+    ble_link_init(&tab, &cfg_default);
+    ble_link_t *link = ble_link_on_connect(&tab, bda_a, now_us);
+    test_assert_int_eq(BLE_LINK_ACT_READ_RSSI, notify_every(bda_a, &now_us, 6 * SEC_US, 1, &req), "first notify reads RSSI");
+    ble_link_on_rssi(&tab, bda_a, -70);
+    test_assert_int_eq(0, notify_every(bda_a, &now_us, 6 * SEC_US, 4, &req) & BLE_LINK_ACT_READ_RSSI, "not again within 30 s");
+    test_assert_int_eq(BLE_LINK_ACT_READ_RSSI, notify_every(bda_a, &now_us, 6 * SEC_US, 1, &req) & BLE_LINK_ACT_READ_RSSI,
+                       "read again after 30 s");
+    ble_link_on_rssi(&tab, bda_a, -80);
+    ble_link_on_rssi(&tab, bda_a, -65);
+    test_assert_true(link->rssi == -65 && link->rssi_min == -80, "latest and lowest RSSI");
+}
+
+/**
+ * @brief disconnect reasons, stats kept across connections
+ *
+ */
+static void test_disconnect(void) {
+    ble_link_params_t req;
+    int64_t now_us = SEC_US;
+    ble_link_init(&tab, &cfg_default);
+    ble_link_t *link = ble_link_on_connect(&tab, bda_a, now_us);
+    notify_every(bda_a, &now_us, 6 * SEC_US, 4, &req);
+    ble_link_on_params(&tab, bda_a, &req, true);
+    ble_link_on_disconnect(&tab, bda_a, BLE_LINK_REASON_TIMEOUT);
+    test_assert_true(!link->connected && link->timeout_count == 1, "supervision timeout");
+    ble_link_on_disconnect(&tab, bda_a, BLE_LINK_REASON_TIMEOUT);
+    test_assert_int_eq(1, (int32_t)link->timeout_count, "counted once per link");
+    test_assert_int_eq(0, ble_link_on_notify(&tab, bda_a, now_us, &req), "no action while down");
+
+    test_assert_true(ble_link_on_connect(&tab, bda_a, now_us) == link, "same entry on reconnect");
+    test_assert_int_eq(2, (int32_t)link->connect_count, "reconnect counted");
+    test_assert_true(link->period_ms == 6000 && link->params.interval == 0, "period kept, parameters of new link unknown");
+    ble_link_on_disconnect(&tab, bda_a, REASON_REMOTE);
+    ble_link_on_connect(&tab, bda_a, now_us);
+    ble_link_on_disconnect(&tab, bda_a, REASON_LOCAL);
+    test_assert_true(link->drop_count == 1 && link->timeout_count == 1, "own close not counted");
+}
+
+/**
+ * @brief least recently connected device is replaced, connected ones never
+ *
+ */
+static void test_replace(void) {
+    uint8_t bda[BLE_BDA_LEN] = {0xa4, 0xc1, 0x38, 0x00, 0x00, 0x00};
+    ble_link_init(&tab, &cfg_default);
+    for (int idx = 0; idx < BLE_LINK_DEV_MAX; idx++) {
+        bda[5] = (uint8_t)idx;
+        ble_link_on_connect(&tab, bda, (idx + 1) * SEC_US);
+    }
+    bda[5] = BLE_LINK_DEV_MAX;
+    test_assert_true(ble_link_on_connect(&tab, bda, 100 * SEC_US) == NULL, "every entry connected");
+    for (int idx = 2; idx < 5; idx++) {
+        bda[5] = (uint8_t)idx;
+        ble_link_on_disconnect(&tab, bda, REASON_REMOTE);
+    }
+    bda[5] = BLE_LINK_DEV_MAX;
+    ble_link_t *link = ble_link_on_connect(&tab, bda, 100 * SEC_US);
+    test_assert_true(link == &tab.dev[2] && link->connect_count == 1 && link->drop_count == 0, "oldest unconnected replaced");
+    bda[5] = 2;
+    test_assert_true(ble_link_find(&tab, bda) == NULL, "replaced device gone");
+}
+
+/**
+ * @brief JSON and text layout, worst-case lengths
+ *
+ */
+static void test_format(void) {
+    static char buf[BLE_LINK_JSON_LEN + 1];
+    ble_link_params_t req;
+    int64_t now_us = SEC_US;
+    ble_link_init(&tab, &cfg_default);
+    ble_link_json(&tab, buf, sizeof(buf));
+    test_assert_str_eq("[]", buf, "no device");
+    ble_link_on_connect(&tab, bda_a, now_us);
+    notify_every(bda_a, &now_us, 6 * SEC_US, 4, &req);
+    ble_link_on_params(&tab, bda_a, &req, true);
+    ble_link_on_rssi(&tab, bda_a, -72);
+    int len = ble_link_json(&tab, buf, sizeof(buf));
+    test_assert_str_eq("[{\"bda\":\"a4:c1:38:00:00:01\",\"up\":1,\"rssi\":-72,\"rssi_min\":-72,\"n\":4,\"miss\":0,\"conn\":1,"
+                       "\"to\":0,\"drop\":0,\"upd\":1,\"rej\":0,\"per\":6000,\"int\":200.00,\"lat\":4,\"tmo\":6000}]",
+                       buf, "JSON");
+    test_assert_int_eq((int32_t)strlen(buf), len, "JSON length");
+    ble_link_text(&tab, buf, sizeof(buf));
+    test_assert_str_eq("a4:c1:38:00:00:01 -72 dBm 200.00 ms L4 miss 0 to 0\n", buf, "debug screen text");
+    ble_link_on_disconnect(&tab, bda_a, BLE_LINK_REASON_TIMEOUT);
+    ble_link_text(&tab, buf, sizeof(buf));
+    test_assert_str_eq("a4:c1:38:00:00:01 down miss 0 to 1\n", buf, "link down");
+    test_assert_int_eq(0, ble_link_json(&tab, buf, BLE_LINK_JSON_LEN), "JSON buffer too small");
+    test_assert_int_eq(0, ble_link_text(&tab, buf, BLE_LINK_TEXT_LEN), "text buffer too small");
+
+    /* every field at its widest */
+    for (int idx = 0; idx < BLE_LINK_DEV_MAX; idx++) {
+        ble_link_t *link = &tab.dev[idx];
+        memset(link, 0xff, sizeof(ble_link_t));
+        link->used = true;
+        link->connected = true;
+        link->rssi = -128;
+        link->rssi_min = -128;
+    }
+    len = ble_link_json(&tab, buf, BLE_LINK_JSON_LEN + 1);
+    test_assert_true(len > 0 && len <= BLE_LINK_JSON_LEN, "JSON worst case fits BLE_LINK_JSON_LEN");
+    len = ble_link_text(&tab, buf, BLE_LINK_TEXT_LEN + 1);
+    test_assert_true(len > 0 && len <= BLE_LINK_TEXT_LEN, "text worst case fits BLE_LINK_TEXT_LEN");
+}
+
+/**
+ * @brief link statistics and connection parameter policy unit tests
+ *
+ */
+void test_ble_link(void) {
+    test_print("");
+    test_print("*************************");
+    test_print("Start ble_link tests");
+    test_print("*************************");
+
+    test_period();
+    test_policy();
+    test_rssi();
+    test_disconnect();
+    test_replace();
+    test_format();
+}
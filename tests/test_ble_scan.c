@@ -0,0 +1,289 @@
+#include "test_assert.h"
+#include "tests.h"
+#include "ble_scan.h"
+
+/* DEFINES */
+#define SEC_US(s)   ((int64_t)(s) * 1000000)
+
+/* TYPE DEFINITIONS */
+/* simulated clock and what the controller was told */
+typedef struct sim_t {
+    ble_scan_t scan;
+    int64_t now;
+    int start_count;
+    int stop_count;
+    bool scanning;
+    ble_scan_params_t params;
+} sim_t;
+
+/* STATIC VARIABLES */
+static const ble_scan_cfg_t scan_cfg = {
+    .fast = {0x50, 0x30},
+    .slow = {0x320, 0x50},
+    .fast_max_ms = 30000,
+    .slow_scan_ms = 5000,
+    .slow_idle_ms = 55000,
+    .pause_max_ms = 2000,
+    .pause_gap_ms = 1000,
+};
+
+/* STATIC PROTOTYPES */
+static void sim_exec(sim_t *sim, ble_scan_act_t act);
+static void sim_run(sim_t *sim, int64_t until);
+static int sim_duty_permille(sim_t *sim, int64_t from, int64_t on_from);
+static void test_discovery(void);
+static void test_burst_pause(void);
+static void test_slots(void);
+static void test_whitelist(void);
+static void test_reconfig(void);
+
+/**
+ * @brief apply action to the simulated controller
+ *
+ * @param sim
+ * @param act
+ */
+static void sim_exec(sim_t *sim, ble_scan_act_t act) {
+    if (act == BLE_SCAN_ACT_START) {
+        sim->start_count++;
+        sim->scanning = true;
+        sim->params = sim->scan.params;
+    } else if (act == BLE_SCAN_ACT_STOP) {
+        sim->stop_count++;
+        sim->scanning = false;
+    }
+}
+
+/**
+ * @brief advance clock, firing the scheduler timer at each deadline
+ *
+ * @param sim
+ * @param until
+ */
+static void sim_run(sim_t *sim, int64_t until) {
+    for (int guard = 0; guard < 10000; guard++) {
+        int64_t deadline = ble_scan_deadline(&sim->scan);
+        if (deadline > until) {
+            break;
+        }
+        test_assert_true(deadline > sim->now || deadline == INT64_MAX, "deadline in the future");
+        sim->now = deadline;
+        sim_exec(sim, ble_scan_poll(&sim->scan, sim->now));
+    }
+    sim->now = until;
+}
+
+/**
+ * @brief share of time scanning since from
+ *
+ * @param sim
+ * @param from
+ * @param on_from ble_scan_on_time at from
+ * @return permille
+ */
+static int sim_duty_permille(sim_t *sim, int64_t from, int64_t on_from) {
+    return (int)((ble_scan_on_time(&sim->scan, sim->now) - on_from) * 1000 / (sim->now - from));
+}
+
+/**
+ * @brief fast scan while discovering, sparse when every known device is connected, re-armed on disconnect
+ *
+ */
+static void test_discovery(void) {
+    sim_t sim = {0};
+    ble_scan_init(&sim.scan, &scan_cfg, 0);
+    test_assert_true(ble_scan_deadline(&sim.scan) == INT64_MAX, "idle until links known");
+
+    /* boot: nothing connected yet */
+    sim_exec(&sim, ble_scan_on_links(&sim.scan, 0, true, 0));
+    test_assert_int_eq(BLE_SCAN_FAST, sim.scan.state, "boot scans fast");
+    test_assert_true(sim.scanning && sim.params.window == scan_cfg.fast.window, "fast duty");
+
+    /* device found at 5 s: window restarts, no controller traffic */
+    sim_run(&sim, SEC_US(5));
+    sim_exec(&sim, ble_scan_on_links(&sim.scan, 1, true, sim.now));
+    test_assert_int_eq(1, sim.start_count, "no restart while fast");
+    sim_run(&sim, SEC_US(34));
+    test_assert_int_eq(BLE_SCAN_FAST, sim.scan.state, "fast for fast_max after last discovery");
+    sim_run(&sim, SEC_US(35));
+    test_assert_int_eq(BLE_SCAN_SLOW, sim.scan.state, "nothing new for fast_max: sparse");
+    test_assert_true(sim.scanning && sim.params.interval == scan_cfg.slow.interval, "restarted with slow duty");
+
+    /* sparse cycles: 5 s of every 60 s */
+    int64_t from = sim.now;
+    int64_t on_from = ble_scan_on_time(&sim.scan, from);
+    sim_run(&sim, SEC_US(35 + 600));
+    test_assert_int_eq(5000 * 1000 / 60000, sim_duty_permille(&sim, from, on_from), "sparse scan share");
+    test_assert_int_eq(11 + 1, sim.start_count, "one start per cycle");
+    test_print("   sparse mode: scanning %d permille of time, radio duty %d permille",
+               sim_duty_permille(&sim, from, on_from),
+               sim_duty_permille(&sim, from, on_from) * scan_cfg.slow.window / scan_cfg.slow.interval);
+
+    /* disconnect re-arms fast scanning at once */
+    sim_exec(&sim, ble_scan_on_links(&sim.scan, 0, true, sim.now));
+    test_assert_int_eq(BLE_SCAN_FAST, sim.scan.state, "disconnect re-arms fast scan");
+    test_assert_true(sim.scanning && sim.params.window == scan_cfg.fast.window, "fast duty after disconnect");
+
+    /* known device back: sparse again without waiting for fast_max */
+    sim_run(&sim, sim.now + SEC_US(2));
+    sim_exec(&sim, ble_scan_on_links(&sim.scan, 1, true, sim.now));
+    test_assert_int_eq(BLE_SCAN_SLOW, sim.scan.state, "all known devices back: sparse");
+
+    /* lost device that never comes back: fast for fast_max only */
+    sim_exec(&sim, ble_scan_on_links(&sim.scan, 0, true, sim.now));
+    int64_t lost = sim.now;
+    sim_run(&sim, lost + SEC_US(29));
+    test_assert_int_eq(BLE_SCAN_FAST, sim.scan.state, "missing device: fast");
+    sim_run(&sim, lost + SEC_US(31));
+    test_assert_true(sim.scan.state == BLE_SCAN_SLOW, "missing too long: sparse");
+
+    /* controller ended scan by itself */
+    sim_exec(&sim, ble_scan_on_stopped(&sim.scan, sim.now));
+    test_assert_true(sim.scanning, "restarted after controller stop");
+
+    /* fast_max 0: scan continuously, e.g. advertisement only mode */
+    ble_scan_cfg_t cfg = scan_cfg;
+    cfg.fast_max_ms = 0;
+    ble_scan_init(&sim.scan, &cfg, 0);
+    sim.now = 0;
+    sim_exec(&sim, ble_scan_on_links(&sim.scan, 0, true, 0));
+    test_assert_true(ble_scan_deadline(&sim.scan) == INT64_MAX, "no timer in continuous mode");
+    sim_run(&sim, SEC_US(3600));
+    test_assert_int_eq(BLE_SCAN_FAST, sim.scan.state, "continuous scan");
+}
+
+/**
+ * @brief MQTT bursts pause scanning, pauses are bounded
+ *
+ */
+static void test_burst_pause(void) {
+    sim_t sim = {0};
+    ble_scan_init(&sim.scan, &scan_cfg, 0);
+    sim_exec(&sim, ble_scan_on_links(&sim.scan, 0, true, 0));
+
+    /* short burst */
+    sim_run(&sim, SEC_US(1));
+    sim_exec(&sim, ble_scan_on_burst(&sim.scan, 200, sim.now));
+    test_assert_int_eq(BLE_SCAN_PAUSED, sim.scan.state, "burst pauses scan");
+    test_assert_true(!sim.scanning, "scan stopped for burst");
+    sim_run(&sim, SEC_US(1) + 199000);
+    test_assert_true(!sim.scanning, "paused for hold time");
+    sim_run(&sim, SEC_US(1) + 200000);
+    test_assert_true(sim.scanning, "scan resumed after burst");
+    test_assert_int_eq(BLE_SCAN_FAST, sim.scan.state, "back to fast");
+
+    /* continuous publishing: 2 s pauses with 1 s of scanning in between */
+    int64_t from = sim.now;
+    int64_t on_from = ble_scan_on_time(&sim.scan, from);
+    for (int64_t t = from; t < from + SEC_US(9); t += 100000) {
+        sim_run(&sim, t);
+        sim_exec(&sim, ble_scan_on_burst(&sim.scan, 200, sim.now));
+    }
+    sim_run(&sim, from + SEC_US(9));
+    test_assert_int_eq(333, sim_duty_permille(&sim, from, on_from), "scan keeps a third of the time");
+    test_assert_int_eq(4, (int32_t)sim.scan.pause_count, "three pauses plus the first");
+
+    /* nothing to pause between sparse scans */
+    sim_run(&sim, SEC_US(60));
+    test_assert_int_eq(BLE_SCAN_SLOW_IDLE, sim.scan.state, "between sparse scans");
+    uint32_t pauses = sim.scan.pause_count;
+    sim_exec(&sim, ble_scan_on_burst(&sim.scan, 200, sim.now));
+    test_assert_int_eq((int32_t)pauses, (int32_t)sim.scan.pause_count, "no pause while idle");
+}
+
+/**
+ * @brief no scanning while all slots are used or an open is pending
+ *
+ */
+static void test_slots(void) {
+    sim_t sim = {0};
+    ble_scan_init(&sim.scan, &scan_cfg, 0);
+    sim_exec(&sim, ble_scan_on_links(&sim.scan, 0, true, 0));
+
+    /* open pending */
+    sim_exec(&sim, ble_scan_on_links(&sim.scan, 0, false, 1000));
+    test_assert_int_eq(BLE_SCAN_OFF, sim.scan.state, "open pending: off");
+    test_assert_true(!sim.scanning, "stopped for open");
+    sim_exec(&sim, ble_scan_on_links(&sim.scan, 1, true, 2000));
+    test_assert_true(sim.scanning, "scan resumed after connect");
+
+    /* table full */
+    sim_exec(&sim, ble_scan_on_links(&sim.scan, 3, false, 3000));
+    test_assert_true(!sim.scanning, "all slots used: off");
+    test_assert_true(ble_scan_deadline(&sim.scan) == INT64_MAX, "no timer while off");
+    sim_exec(&sim, ble_scan_on_burst(&sim.scan, 200, 4000));
+    test_assert_true(!sim.scanning && sim.scan.pause_count == 0, "burst ignored while off");
+    test_assert_int_eq(2, sim.start_count, "starts");
+    test_assert_int_eq(2, sim.stop_count, "stops");
+}
+
+/**
+ * @brief fast scan after link loss filters on known devices, discovery scans do not
+ *
+ */
+static void test_whitelist(void) {
+    sim_t sim = {0};
+    ble_scan_init(&sim.scan, &scan_cfg, 0);
+    ble_scan_set_whitelist(&sim.scan, true);
+    sim_exec(&sim, ble_scan_on_links(&sim.scan, 0, true, 0));
+    test_assert_true(sim.scanning && !sim.params.known_only, "boot scan sees new devices");
+    sim_exec(&sim, ble_scan_on_links(&sim.scan, 2, true, SEC_US(1)));
+
+    /* link lost: filter until it is back */
+    sim_exec(&sim, ble_scan_on_links(&sim.scan, 1, true, SEC_US(2)));
+    test_assert_true(sim.scanning && sim.params.known_only, "link loss scans known devices only");
+    test_assert_int_eq(sim.params.window, scan_cfg.fast.window, "at fast duty");
+    sim_exec(&sim, ble_scan_on_links(&sim.scan, 2, true, SEC_US(3)));
+    test_assert_true(sim.scanning && !sim.params.known_only && sim.scan.state == BLE_SCAN_SLOW, "all back: sparse, unfiltered");
+
+    /* lost device gone for good: sparse scans look for new devices again */
+    sim_exec(&sim, ble_scan_on_links(&sim.scan, 1, true, SEC_US(4)));
+    test_assert_true(sim.params.known_only, "filtered");
+    sim_run(&sim, SEC_US(35));
+    test_assert_true(sim.scan.state == BLE_SCAN_SLOW && !sim.params.known_only, "sparse scan unfiltered");
+
+    /* advertising sensors are not in the whitelist */
+    sim_exec(&sim, ble_scan_on_links(&sim.scan, 2, true, SEC_US(36)));
+    ble_scan_set_whitelist(&sim.scan, false);
+    sim_exec(&sim, ble_scan_on_links(&sim.scan, 1, true, SEC_US(37)));
+    test_assert_true(sim.scanning && !sim.params.known_only, "no filter without usable whitelist");
+}
+
+/**
+ * @brief duty changed at run time: running scan restarted only if its parameters changed
+ *
+ */
+static void test_reconfig(void) {
+    sim_t sim = {0};
+    ble_scan_init(&sim.scan, &scan_cfg, 0);
+    sim_exec(&sim, ble_scan_on_links(&sim.scan, 0, true, 0));
+    test_assert_int_eq(1, sim.start_count, "fast scan");
+
+    ble_scan_cfg_t cfg = scan_cfg;
+    cfg.slow.window = 0x30;
+    sim_exec(&sim, ble_scan_set_cfg(&sim.scan, &cfg, SEC_US(1)));
+    test_assert_int_eq(1, sim.start_count, "slow duty changed, fast scan left running");
+    cfg.fast = (ble_scan_params_t){0xA0, 0x20, false};
+    sim_exec(&sim, ble_scan_set_cfg(&sim.scan, &cfg, SEC_US(2)));
+    test_assert_int_eq(2, sim.start_count, "fast duty changed, restarted");
+    test_assert_true(sim.scanning && sim.params.interval == 0xA0 && sim.params.window == 0x20, "new fast duty");
+    sim_run(&sim, SEC_US(31));
+    test_assert_true(sim.scan.state == BLE_SCAN_SLOW && sim.params.window == 0x30, "new slow duty");
+}
+
+/**
+ * @brief scan scheduler on a simulated clock
+ *
+ */
+void test_ble_scan(void) {
+    test_print("");
+    test_print("*************************");
+    test_print("Start ble_scan tests");
+    test_print("*************************");
+
+    test_discovery();
+    test_burst_pause();
+    test_slots();
+    test_whitelist();
+    test_reconfig();
+}
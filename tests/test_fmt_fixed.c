@@ -0,0 +1,241 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "test_assert.h"
+#include "tests.h"
+#include "fmt_fixed.h"
+
+/* DEFINES */
+#define BENCH_COUNT         1000000
+
+/* STATIC PROTOTYPES */
+static double now_s(void);
+static int ref_centi(char *buf, int32_t centi, int decimals);
+static void test_values(void);
+static void test_json(void);
+static void bench_json(void);
+static void bench_label(void);
+
+/* STATIC VARIABLES */
+static volatile int bench_sink;
+
+/**
+ * @brief monotonic time
+ * 
+ * @return seconds
+ */
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief reference formatting with snprintf, rounded half away from zero
+ * 
+ * @param buf 
+ * @param centi 
+ * @param decimals 
+ * @return length
+ */
+static int ref_centi(char *buf, int32_t centi, int decimals) {
+    static const int32_t div[] = {100, 10, 1};
+    int32_t mag = (centi < 0) ? -centi : centi;
+    int32_t scaled = (mag + div[decimals] / 2) / div[decimals];
+    const char *sign = (centi < 0 && scaled != 0) ? "-" : "";
+    switch (decimals) {
+    case 0:
+        return sprintf(buf, "%s%d", sign, scaled);
+    case 1:
+        return sprintf(buf, "%s%d.%d", sign, scaled / 10, scaled % 10);
+    default:
+        return sprintf(buf, "%s%d.%02d", sign, scaled / 100, scaled % 100);
+    }
+}
+
+/**
+ * @brief integers and fixed-point against snprintf over the full sample range
+ * 
+ */
+static void test_values(void) {
+    char buf[32];
+    char ref[32];
+    int len;
+
+    len = fmt_u32(buf, 0);
+    test_assert_true(len == 1 && memcmp(buf, "0", 1) == 0, "u32 zero");
+    len = fmt_u32(buf, 4294967295u);
+    test_assert_true(len == FMT_U32_LEN && memcmp(buf, "4294967295", len) == 0, "u32 max");
+    len = fmt_i32(buf, -2147483647 - 1);
+    test_assert_true(len == FMT_I32_LEN && memcmp(buf, "-2147483648", len) == 0, "i32 min");
+    len = fmt_u64(buf, 4294967296ull);
+    test_assert_true(len == 10 && memcmp(buf, "4294967296", len) == 0, "u64 above u32");
+    len = fmt_u64(buf, 5000000000007ull);
+    test_assert_true(len == 13 && memcmp(buf, "5000000000007", len) == 0, "u64 zero padded low digits");
+    len = fmt_u64(buf, UINT64_MAX);
+    test_assert_true(len == FMT_U64_LEN && memcmp(buf, "18446744073709551615", len) == 0, "u64 max");
+
+    len = fmt_centi(buf, 2345, 1);
+    buf[len] = '\0';
+    test_assert_str_eq("23.5", buf, "round half up");
+    len = fmt_centi(buf, -2345, 1);
+    buf[len] = '\0';
+    test_assert_str_eq("-23.5", buf, "round half away from zero");
+    len = fmt_centi(buf, -4, 1);
+    buf[len] = '\0';
+    test_assert_str_eq("0.0", buf, "no negative zero");
+    len = fmt_centi(buf, -5, 2);
+    buf[len] = '\0';
+    test_assert_str_eq("-0.05", buf, "negative below one");
+
+    /* every int16 temperature and uint16 humidity value */
+    for (int decimals = 0; decimals <= 2; decimals++) {
+        int bad = 0;
+        for (int32_t v = -32768; v <= 65535; v++) {
+            len = fmt_centi(buf, v, decimals);
+            buf[len] = '\0';
+            ref_centi(ref, v, decimals);
+            bad += strcmp(buf, ref) != 0;
+        }
+        test_assert_int_eq(0, bad, "fmt_centi matches snprintf");
+    }
+    int bad = 0;
+    for (int32_t v = -100000; v <= 100000; v += 7) {
+        len = fmt_i32(buf, v);
+        buf[len] = '\0';
+        sprintf(ref, "%d", v);
+        bad += strcmp(buf, ref) != 0;
+    }
+    test_assert_int_eq(0, bad, "fmt_i32 matches snprintf");
+}
+
+/**
+ * @brief JSON record layout and worst-case length
+ * 
+ */
+static void test_json(void) {
+    char buf[FMT_SAMPLE_JSON_LEN + 1];
+    sensor_sample_t s = {0};
+    int len;
+
+    s.dev_id = 3;
+    s.seq = 7;
+    s.temp_centi = -105;
+    s.humid_centi = 5301;
+    len = fmt_sample_json(buf, &s, true);
+    buf[len] = '\0';
+    test_assert_str_eq("{\"dev\":3,\"seq\":7,\"temp\":-1.05,\"humid\":53.01}", buf, "json with dev");
+    len = fmt_sample_json(buf, &s, false);
+    buf[len] = '\0';
+    test_assert_str_eq("{\"seq\":7,\"temp\":-1.05,\"humid\":53.01}", buf, "json without dev");
+
+    s.dev_id = 65535;
+    s.seq = 4294967295u;
+    s.temp_centi = -32768;
+    s.humid_centi = 65535;
+    len = fmt_sample_json(buf, &s, true);
+    test_assert_true(len <= FMT_SAMPLE_JSON_LEN, "worst case fits FMT_SAMPLE_JSON_LEN");
+
+    static const uint8_t bda[6] = {0xa4, 0xc1, 0x38, 0x0f, 0xf0, 0x01};
+    len = fmt_bda(buf, bda);
+    buf[len] = '\0';
+    test_assert_str_eq("a4:c1:38:0f:f0:01", buf, "address");
+    test_assert_int_eq(FMT_BDA_LEN, len, "address length");
+}
+
+/**
+ * @brief JSON record: snprintf as mqtt_batch used before vs fmt_sample_json
+ * 
+ */
+static void bench_json(void) {
+    char buf[FMT_SAMPLE_JSON_LEN + 1];
+    sensor_sample_t s = {0};
+    int sum = 0;
+
+    double t0 = now_s();
+    for (int n = 0; n < BENCH_COUNT; n++) {
+        s.seq = n;
+        s.dev_id = n % 50;
+        s.temp_centi = (int16_t)(2000 + n % 500);
+        s.humid_centi = (uint16_t)(4000 + n % 1000);
+        int temp = s.temp_centi;
+        const char *sign = (temp < 0) ? "-" : "";
+        if (temp < 0) {
+            temp = -temp;
+        }
+        sum += snprintf(buf, sizeof(buf), "{\"dev\":%u,\"seq\":%u,\"temp\":%s%d.%02d,\"humid\":%u.%02u}",
+                        s.dev_id, (unsigned)s.seq, sign, temp / 100, temp % 100,
+                        s.humid_centi / 100, s.humid_centi % 100);
+    }
+    double dt_ref = now_s() - t0;
+
+    t0 = now_s();
+    for (int n = 0; n < BENCH_COUNT; n++) {
+        s.seq = n;
+        s.dev_id = n % 50;
+        s.temp_centi = (int16_t)(2000 + n % 500);
+        s.humid_centi = (uint16_t)(4000 + n % 1000);
+        sum -= fmt_sample_json(buf, &s, true);
+    }
+    double dt = now_s() - t0;
+    bench_sink = sum;
+    test_assert_int_eq(0, sum, "same total length");
+    test_print("   JSON record     snprintf %6.1f ns  fmt %6.1f ns  x%.1f",
+               dt_ref * 1e9 / BENCH_COUNT, dt * 1e9 / BENCH_COUNT, dt_ref / dt);
+}
+
+/**
+ * @brief label value lines: sprintf with float as main.c used before vs fmt_x
+ * 
+ */
+static void bench_label(void) {
+    char buf[64];
+    int sum = 0;
+
+    double t0 = now_s();
+    for (int n = 0; n < BENCH_COUNT; n++) {
+        float temp = (2000 + n % 500) / 100.0f;
+        int humid = 40 + n % 10;
+        sum += sprintf(buf, "WiFi: %d, MQTT: %d\nTemperature: %.1f degC\nHumidity: %d %%RH\n",
+                       n & 1, 1, (double)temp, humid);
+    }
+    double dt_ref = now_s() - t0;
+
+    t0 = now_s();
+    for (int n = 0; n < BENCH_COUNT; n++) {
+        int len = fmt_str(buf, "WiFi: ");
+        len += fmt_u32(&buf[len], n & 1);
+        len += fmt_str(&buf[len], ", MQTT: ");
+        len += fmt_u32(&buf[len], 1);
+        len += fmt_str(&buf[len], "\nTemperature: ");
+        len += fmt_centi(&buf[len], 2000 + n % 500, 1);
+        len += fmt_str(&buf[len], " degC\nHumidity: ");
+        len += fmt_u32(&buf[len], 40 + n % 10);
+        len += fmt_str(&buf[len], " %RH\n");
+        buf[len] = '\0';
+        sum -= len;
+    }
+    double dt = now_s() - t0;
+    bench_sink = sum;
+    test_print("   label lines     sprintf  %6.1f ns  fmt %6.1f ns  x%.1f",
+               dt_ref * 1e9 / BENCH_COUNT, dt * 1e9 / BENCH_COUNT, dt_ref / dt);
+}
+
+/**
+ * @brief fixed-point formatting tests and micro-benchmark against sprintf
+ * 
+ */
+void test_fmt_fixed(void) {
+    test_print("");
+    test_print("**********************");
+    test_print("Start fmt_fixed tests");
+    test_print("**********************");
+
+    test_values();
+    test_json();
+
+    test_print("Benchmark %d iterations", BENCH_COUNT);
+    bench_json();
+    bench_label();
+}
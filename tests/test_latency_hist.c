@@ -0,0 +1,31 @@
+#include "test_assert.h"
+#include "tests.h"
+#include "latency_hist.h"
+
+/**
+ * @brief log2 binning and percentiles
+ * 
+ */
+void test_latency_hist(void) {
+    latency_hist_t hist;
+
+    test_print("");
+    test_print("*************************");
+    test_print("Start latency_hist tests");
+    test_print("*************************");
+
+    latency_hist_init(&hist);
+    test_assert_int_eq(0, (int32_t)latency_hist_percentile(&hist, 50), "empty histogram");
+    for (int n = 0; n < 99; n++) {
+        latency_hist_add(&hist, 100);       /* bin [64, 128) */
+    }
+    latency_hist_add(&hist, 100000);        /* one 100 ms outlier */
+    latency_hist_add(&hist, -5);            /* clock skew counted as 0 */
+    test_assert_int_eq(101, (int32_t)hist.count, "count");
+    test_assert_int_eq(1, (int32_t)hist.bin[0], "negative in first bin");
+    test_assert_int_eq(99, (int32_t)hist.bin[6], "100 us in bin 6");
+    test_assert_int_eq(127, (int32_t)latency_hist_percentile(&hist, 50), "p50 bin upper bound");
+    test_assert_int_eq(127, (int32_t)latency_hist_percentile(&hist, 99), "p99 bin upper bound");
+    test_assert_int_eq(100000, (int32_t)latency_hist_percentile(&hist, 100), "p100 is max");
+    test_assert_int_eq((99 * 100 + 100000) / 101, (int32_t)latency_hist_mean(&hist), "mean");
+}
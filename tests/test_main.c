@@ -0,0 +1,30 @@
+#include "test_assert.h"
+#include "tests.h"
+
+/**
+ * @brief run host tests of main/ modules
+ * 
+ * @return 0 on success, tests exit(1) on first failure
+ */
+int main(void) {
+    test_ble_conn();
+    test_adv_decode();
+    test_sample_ring();
+    test_latency_hist();
+    test_mqtt_batch();
+    test_sample_backlog();
+    test_fmt_fixed();
+    test_sys_metrics();
+    test_ble_scan();
+    test_status_snap();
+    test_ble_cache();
+    test_mqtt_window();
+    test_sample_agg();
+    test_remote_cfg();
+    test_power_mgr();
+    test_ble_link();
+    test_pipe_trace();
+
+    test_print("Exit with success!");
+    return 0;
+}
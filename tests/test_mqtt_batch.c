@@ -0,0 +1,242 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "test_assert.h"
+#include "tests.h"
+#include "mqtt_batch.h"
+
+/* DEFINES */
+#define BENCH_TOPIC         "your_topic/sensor"
+#define BENCH_DEV_NUM       50
+#define BENCH_SAMPLES       200000
+#define TCPIP_OVERHEAD      40      /* IPv4 + TCP header per publish write */
+
+/* TYPE DEFINITIONS */
+/* stand-in for the broker side: counts messages and bytes on the wire */
+typedef struct broker_standin_t {
+    uint32_t msg_count;
+    uint64_t wire_bytes;
+    uint32_t samples;           /* records decoded back from payloads */
+    int last_dev;
+    char last_payload[MQTT_BATCH_BUF_SIZE + 1];
+} broker_standin_t;
+
+/* STATIC PROTOTYPES */
+static int publish_wire_size(int topic_len, int payload_len);
+static void broker_publish(int dev_id, const uint8_t *data, int len, void *ctx);
+static double now_s(void);
+static void test_encoding(void);
+static void test_triggers(void);
+static void bench_run(const char *name, const mqtt_batch_cfg_t *cfg);
+static void bench_raw(void);
+
+/**
+ * @brief size of a QoS 0 PUBLISH packet plus TCP/IP headers
+ * 
+ * @param topic_len 
+ * @param payload_len 
+ * @return bytes
+ */
+static int publish_wire_size(int topic_len, int payload_len) {
+    int remaining = 2 + topic_len + payload_len;
+    int len_bytes = (remaining < 128) ? 1 : (remaining < 16384) ? 2 : 3;
+    return TCPIP_OVERHEAD + 1 + len_bytes + remaining;
+}
+
+/**
+ * @brief broker stand-in publish sink
+ * 
+ * @param dev_id 
+ * @param data 
+ * @param len 
+ * @param ctx broker_standin_t
+ */
+static void broker_publish(int dev_id, const uint8_t *data, int len, void *ctx) {
+    broker_standin_t *broker = ctx;
+    int topic_len = sizeof(BENCH_TOPIC) - 1;
+    if (dev_id >= 0) {
+        char suffix[8];
+        topic_len += snprintf(suffix, sizeof(suffix), "/%d", dev_id);
+    }
+    broker->msg_count++;
+    broker->wire_bytes += publish_wire_size(topic_len, len);
+    broker->last_dev = dev_id;
+    if (data[0] == MQTT_BATCH_BIN_VERSION) {
+        broker->samples += data[1];
+    } else {
+        for (int i = 0; i < len; i++) {
+            broker->samples += (data[i] == '{');
+        }
+        memcpy(broker->last_payload, data, len);
+        broker->last_payload[len] = '\0';
+    }
+}
+
+/**
+ * @brief monotonic time
+ * 
+ * @return seconds
+ */
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief JSON and binary encoding of a known batch
+ * 
+ */
+static void test_encoding(void) {
+    broker_standin_t broker = {0};
+    mqtt_batch_t batch;
+    mqtt_batch_cfg_t cfg = {MQTT_BATCH_FMT_JSON, 2, 1000000, false};
+    sensor_sample_t s1 = {.ts_us = 0, .seq = 7, .dev_id = 1, .temp_centi = 2345, .humid_centi = 5300};
+    sensor_sample_t s2 = {.ts_us = 1500, .seq = 8, .dev_id = 2, .temp_centi = -5, .humid_centi = 4001};
+
+    test_print("Encoding");
+    mqtt_batch_init(&batch, &cfg, broker_publish, &broker);
+    mqtt_batch_add(&batch, &s1, 0);
+    mqtt_batch_add(&batch, &s2, 2000);
+    test_assert_str_eq("[{\"dev\":1,\"seq\":7,\"temp\":23.45,\"humid\":53.00,\"age\":2},"
+                       "{\"dev\":2,\"seq\":8,\"temp\":-0.05,\"humid\":40.01,\"age\":0}]",
+                       broker.last_payload, "JSON array");
+
+    cfg.route = true;
+    mqtt_batch_init(&batch, &cfg, broker_publish, &broker);
+    mqtt_batch_add(&batch, &s1, 0);
+    mqtt_batch_add(&batch, &s2, 2000);
+    test_assert_int_eq(3, (int32_t)broker.msg_count, "one message per device");
+    test_assert_int_eq(2, broker.last_dev, "routed to device topic");
+    test_assert_str_eq("[{\"seq\":8,\"temp\":-0.05,\"humid\":40.01,\"age\":0}]", broker.last_payload,
+                       "device id in topic only");
+
+    cfg.fmt = MQTT_BATCH_FMT_BINARY;
+    cfg.route = false;
+    mqtt_batch_init(&batch, &cfg, NULL, NULL);
+    mqtt_batch_add(&batch, &s1, 0);
+    batch.pending[batch.count++] = s2;
+    int len = mqtt_batch_encode(&batch, 0x3, true, 3000, batch.buf, MQTT_BATCH_BUF_SIZE);
+    const uint8_t bin_ref[] = {MQTT_BATCH_BIN_VERSION, 2, 3, 0, 0, 0,
+                               1, 0, 7, 0, 0x29, 0x09, 0xB4, 0x14, 0, 0,
+                               2, 0, 8, 0, 0xFB, 0xFF, 0xA1, 0x0F, 1, 0
+                              };
+    test_assert_int_eq(sizeof(bin_ref), len, "binary length");
+    test_assert_true(memcmp(bin_ref, batch.buf, sizeof(bin_ref)) == 0, "binary records");
+
+    /* dt counts from the oldest sample, not the first one added */
+    mqtt_batch_init(&batch, &cfg, NULL, NULL);
+    mqtt_batch_add(&batch, &s2, 5000);
+    batch.pending[batch.count++] = s1;
+    mqtt_batch_encode(&batch, 0x3, true, 5000, batch.buf, MQTT_BATCH_BUF_SIZE);
+    test_assert_true(batch.buf[2] == 5 && batch.buf[14] == 1 && batch.buf[24] == 0, "dt from oldest sample");
+}
+
+/**
+ * @brief count and window triggers, latency recorded at publish
+ * 
+ */
+static void test_triggers(void) {
+    broker_standin_t broker = {0};
+    latency_hist_t latency;
+    mqtt_batch_t batch;
+    mqtt_batch_cfg_t cfg = {MQTT_BATCH_FMT_JSON, 4, 1000000, false};
+    sensor_sample_t s = {0};
+
+    test_print("Flush triggers");
+    latency_hist_init(&latency);
+    mqtt_batch_init(&batch, &cfg, broker_publish, &broker);
+    batch.latency = &latency;
+    test_assert_true(mqtt_batch_deadline(&batch) == INT64_MAX, "no deadline when empty");
+    mqtt_batch_add(&batch, &s, 100);
+    test_assert_true(mqtt_batch_deadline(&batch) == 1000100, "deadline from first sample");
+    test_assert_true(!mqtt_batch_poll(&batch, 1000099), "window not elapsed");
+    test_assert_true(mqtt_batch_poll(&batch, 1000100), "window elapsed");
+    test_assert_int_eq(1, (int32_t)broker.msg_count, "window flush");
+    for (int n = 0; n < 4; n++) {
+        mqtt_batch_add(&batch, &s, 2000000);
+    }
+    test_assert_int_eq(2, (int32_t)broker.msg_count, "count flush");
+    test_assert_int_eq(5, (int32_t)broker.samples, "all samples published");
+    test_assert_int_eq(5, (int32_t)latency.count, "latency per sample");
+}
+
+/**
+ * @brief publish BENCH_SAMPLES from BENCH_DEV_NUM devices, one sample per device per second
+ * 
+ * @param name 
+ * @param cfg 
+ */
+static void bench_run(const char *name, const mqtt_batch_cfg_t *cfg) {
+    broker_standin_t broker = {0};
+    static mqtt_batch_t batch;
+    sensor_sample_t s = {0};
+    int64_t now_us = 0;
+
+    mqtt_batch_init(&batch, cfg, broker_publish, &broker);
+    double t0 = now_s();
+    for (int n = 0; n < BENCH_SAMPLES; n++) {
+        now_us += 1000000 / BENCH_DEV_NUM;
+        s.ts_us = now_us;
+        s.seq = n;
+        s.dev_id = n % BENCH_DEV_NUM;
+        s.temp_centi = (int16_t)(2000 + n % 500);
+        s.humid_centi = (uint16_t)(4000 + n % 1000);
+        mqtt_batch_add(&batch, &s, now_us);
+        mqtt_batch_poll(&batch, now_us);
+    }
+    mqtt_batch_flush(&batch, now_us);
+    double dt = now_s() - t0;
+    test_print("   %-22s msgs %7u  wire bytes %9llu  B/sample %6.1f  %8.0f ksamples/s",
+               name, broker.msg_count, (unsigned long long)broker.wire_bytes,
+               (double)broker.wire_bytes / BENCH_SAMPLES, BENCH_SAMPLES / dt / 1000);
+    test_assert_int_eq(BENCH_SAMPLES, (int32_t)broker.samples, "every sample delivered");
+}
+
+/**
+ * @brief baseline: one JSON message per sample as mqtt_publish_val did
+ * 
+ */
+static void bench_raw(void) {
+    uint64_t wire_bytes = 0;
+    char buf[50];
+
+    double t0 = now_s();
+    for (int n = 0; n < BENCH_SAMPLES; n++) {
+        float temp_val = (2000 + n % 500) / 100.0f;
+        int humid_val = (4000 + n % 1000) / 100;
+        sprintf(buf, "{\"temp\":%.1f, \"humid\":%d}", (double)temp_val, humid_val);
+        wire_bytes += publish_wire_size(sizeof(BENCH_TOPIC) - 1, strlen(buf));
+    }
+    double dt = now_s() - t0;
+    test_print("   %-22s msgs %7u  wire bytes %9llu  B/sample %6.1f  %8.0f ksamples/s",
+               "raw per-sample JSON", BENCH_SAMPLES, (unsigned long long)wire_bytes,
+               (double)wire_bytes / BENCH_SAMPLES, BENCH_SAMPLES / dt / 1000);
+}
+
+/**
+ * @brief batch encoding tests and bytes-on-wire benchmark against broker stand-in
+ * 
+ */
+void test_mqtt_batch(void) {
+    test_print("");
+    test_print("***********************");
+    test_print("Start mqtt_batch tests");
+    test_print("***********************");
+
+    test_encoding();
+    test_triggers();
+
+    test_print("Benchmark %d devices, %d samples, 1 s window, 16 samples max", BENCH_DEV_NUM, BENCH_SAMPLES);
+    bench_raw();
+    mqtt_batch_cfg_t cfg = {MQTT_BATCH_FMT_JSON, 16, 1000000, false};
+    bench_run("JSON batch", &cfg);
+    cfg.route = true;
+    bench_run("JSON batch per device", &cfg);
+    cfg.fmt = MQTT_BATCH_FMT_BINARY;
+    cfg.route = false;
+    bench_run("binary batch", &cfg);
+    cfg.max_count = MQTT_BATCH_MAX;
+    bench_run("binary batch of 32", &cfg);
+}
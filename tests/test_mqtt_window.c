@@ -0,0 +1,248 @@
+#include <string.h>
+
+#include "test_assert.h"
+#include "tests.h"
+#include "mqtt_window.h"
+
+/* DEFINES */
+#define SIM_MSGS        400     /* messages pushed through the lossy broker */
+#define SIM_ACKS_MAX    64
+#define SIM_RTT_US      20000
+#define SIM_TIMEOUT_MS  200
+
+/* TYPE DEFINITIONS */
+/* broker stand-in, drops PUBLISH or PUBACK at a given rate */
+typedef struct sim_broker_t {
+    uint32_t seed;
+    int publish_loss;           /* per mille */
+    int ack_loss;               /* per mille */
+    int qos;
+    int next_msg_id;
+    int64_t now_us;
+    int delivered[SIM_MSGS];    /* copies received per payload */
+    int ack_count;
+    struct {
+        int msg_id;
+        int64_t due_us;
+    } acks[SIM_ACKS_MAX];
+} sim_broker_t;
+
+/* STATIC VARIABLES */
+static mqtt_window_t window;
+static sim_broker_t broker;
+
+/* STATIC PROTOTYPES */
+static uint32_t sim_rand(void);
+static int sim_send(int dev_id, const uint8_t *data, int len, void *ctx);
+static void sim_ack_due(void);
+static void sim_init(int publish_loss, int ack_loss, uint8_t size, uint8_t max_tries);
+static void test_lossy(void);
+static void test_give_up(void);
+static void test_reconnect(void);
+static void test_qos0(void);
+
+/**
+ * @brief deterministic pseudo random
+ *
+ * @return next value
+ */
+static uint32_t sim_rand(void) {
+    broker.seed = broker.seed * 1103515245 + 12345;
+    return (broker.seed >> 16) & 0x7FFF;
+}
+
+/**
+ * @brief publish to broker stand-in, PUBACK comes one round trip later unless lost
+ *
+ * @param dev_id
+ * @param data payload index as uint16_t
+ * @param len
+ * @param ctx
+ * @return msg_id, 0 for QoS 0
+ */
+static int sim_send(int dev_id, const uint8_t *data, int len, void *ctx) {
+    uint16_t seq;
+    (void)dev_id;
+    (void)ctx;
+    if (len != sizeof(seq)) {
+        return -1;
+    }
+    memcpy(&seq, data, sizeof(seq));
+    int msg_id = broker.qos ? ++broker.next_msg_id : 0;
+    if ((int)(sim_rand() % 1000) < broker.publish_loss) {
+        return msg_id;
+    }
+    broker.delivered[seq]++;
+    if (msg_id == 0 || (int)(sim_rand() % 1000) < broker.ack_loss) {
+        return msg_id;
+    }
+    for (int idx = 0; idx < SIM_ACKS_MAX; idx++) {
+        if (broker.acks[idx].msg_id == 0) {
+            broker.acks[idx].msg_id = msg_id;
+            broker.acks[idx].due_us = broker.now_us + SIM_RTT_US;
+            break;
+        }
+    }
+    return msg_id;
+}
+
+/**
+ * @brief hand PUBACKs due by now to the window
+ *
+ */
+static void sim_ack_due(void) {
+    for (int idx = 0; idx < SIM_ACKS_MAX; idx++) {
+        if (broker.acks[idx].msg_id && broker.acks[idx].due_us <= broker.now_us) {
+            mqtt_window_on_ack(&window, broker.acks[idx].msg_id);
+            broker.acks[idx].msg_id = 0;
+            broker.ack_count++;
+        }
+    }
+}
+
+/**
+ * @brief fresh broker and connected window
+ *
+ * @param publish_loss per mille
+ * @param ack_loss per mille
+ * @param size
+ * @param max_tries
+ */
+static void sim_init(int publish_loss, int ack_loss, uint8_t size, uint8_t max_tries) {
+    mqtt_window_cfg_t cfg = {
+        .size = size,
+        .ack_timeout_ms = SIM_TIMEOUT_MS,
+        .max_tries = max_tries,
+    };
+    memset(&broker, 0, sizeof(broker));
+    broker.seed = 1;
+    broker.qos = 1;
+    broker.publish_loss = publish_loss;
+    broker.ack_loss = ack_loss;
+    mqtt_window_init(&window, &cfg, sim_send, NULL);
+    mqtt_window_set_connected(&window, true, 0);
+}
+
+/**
+ * @brief every message arrives through 10% PUBLISH and 10% PUBACK loss, producer held while full
+ *
+ */
+static void test_lossy(void) {
+    int next = 0;
+    int max_count = 0;
+    int full_ticks = 0;
+    sim_init(100, 100, 4, 0);
+
+    while ((next < SIM_MSGS || window.count > 0) && broker.now_us < 60000000) {
+        /* producer stops while window is full */
+        while (next < SIM_MSGS && !mqtt_window_full(&window)) {
+            uint16_t seq = (uint16_t)next++;
+            mqtt_window_publish(&window, 0, (const uint8_t *)&seq, sizeof(seq), broker.now_us);
+        }
+        full_ticks += mqtt_window_full(&window);
+        max_count = window.count > max_count ? window.count : max_count;
+        broker.now_us += 1000;
+        sim_ack_due();
+        mqtt_window_poll(&window, broker.now_us);
+    }
+
+    int missing = 0;
+    int duplicates = 0;
+    for (int idx = 0; idx < SIM_MSGS; idx++) {
+        missing += broker.delivered[idx] == 0;
+        duplicates += broker.delivered[idx] > 1 ? broker.delivered[idx] - 1 : 0;
+    }
+    test_print("  %d msgs: %u retries, %d duplicates, %u stray acks, %.1f s",
+               SIM_MSGS, window.retry_count, duplicates, window.stray_ack_count, broker.now_us / 1e6);
+    test_assert_int_eq(0, missing, "every message delivered");
+    test_assert_int_eq(0, window.count, "window drained");
+    test_assert_int_eq(SIM_MSGS, (int32_t)window.ack_count, "every message acknowledged");
+    test_assert_int_eq(0, (int32_t)window.drop_count, "nothing dropped without try limit");
+    test_assert_true(max_count <= 4, "in flight bounded by window size");
+    test_assert_true(full_ticks > 0, "producer held back");
+    test_assert_true(window.retry_count > 0, "lost messages retried");
+    test_assert_true(duplicates <= (int)window.retry_count, "duplicates only from retries");
+}
+
+/**
+ * @brief dead broker: message dropped after max_tries, timing follows deadline
+ *
+ */
+static void test_give_up(void) {
+    uint16_t seq = 7;
+    sim_init(1000, 0, 4, 3);
+
+    test_assert_true(mqtt_window_deadline(&window) == INT64_MAX, "idle window has no deadline");
+    test_assert_true(mqtt_window_publish(&window, 0, (const uint8_t *)&seq, sizeof(seq), 0), "accepted");
+    test_assert_true(mqtt_window_deadline(&window) == SIM_TIMEOUT_MS * 1000, "deadline at ack timeout");
+    test_assert_int_eq(0, mqtt_window_poll(&window, SIM_TIMEOUT_MS * 1000 - 1), "not yet due");
+    test_assert_int_eq(1, mqtt_window_poll(&window, SIM_TIMEOUT_MS * 1000), "second try");
+    test_assert_int_eq(1, mqtt_window_poll(&window, SIM_TIMEOUT_MS * 2000), "third try");
+    test_assert_int_eq(0, mqtt_window_poll(&window, SIM_TIMEOUT_MS * 3000), "out of tries");
+    test_assert_int_eq(1, (int32_t)window.drop_count, "dropped");
+    test_assert_int_eq(0, window.count, "slot freed");
+    test_assert_true(!mqtt_window_on_ack(&window, 1), "late ack of dropped message");
+    test_assert_int_eq(1, (int32_t)window.stray_ack_count, "counted as stray");
+
+    uint8_t big[MQTT_WINDOW_MSG_MAX + 1] = { 0 };
+    test_assert_true(!mqtt_window_publish(&window, 0, big, sizeof(big), 0), "oversize refused");
+}
+
+/**
+ * @brief messages queued while disconnected go out on connect, unacked ones again on reconnect
+ *
+ */
+static void test_reconnect(void) {
+    sim_init(0, 1000, 4, 0);
+    mqtt_window_set_connected(&window, false, 0);
+    for (uint16_t seq = 0; seq < 3; seq++) {
+        mqtt_window_publish(&window, 0, (const uint8_t *)&seq, sizeof(seq), 0);
+    }
+    test_assert_int_eq(0, broker.next_msg_id, "nothing sent while disconnected");
+    test_assert_true(mqtt_window_deadline(&window) == INT64_MAX, "no timeout while disconnected");
+    test_assert_int_eq(0, mqtt_window_poll(&window, 10000000), "no retry while disconnected");
+
+    mqtt_window_set_connected(&window, true, 1000);
+    test_assert_int_eq(3, broker.next_msg_id, "sent on connect");
+    test_assert_int_eq(0, (int32_t)window.retry_count, "first try is no retry");
+    mqtt_window_set_connected(&window, false, 2000);
+    mqtt_window_set_connected(&window, true, 3000);
+    test_assert_int_eq(6, broker.next_msg_id, "sent again on reconnect");
+    test_assert_int_eq(3, (int32_t)window.retry_count, "counted as retries");
+    test_assert_int_eq(2, broker.delivered[1], "duplicate from lost ack");
+
+    test_assert_true(!mqtt_window_on_ack(&window, 1), "ack of earlier attempt");
+    test_assert_true(mqtt_window_on_ack(&window, 5), "ack of last attempt");
+    test_assert_int_eq(2, window.count, "one completed");
+}
+
+/**
+ * @brief QoS 0 sends leave nothing in flight
+ *
+ */
+static void test_qos0(void) {
+    sim_init(0, 0, 2, 0);
+    broker.qos = 0;
+    for (uint16_t seq = 0; seq < 10; seq++) {
+        test_assert_true(mqtt_window_publish(&window, 0, (const uint8_t *)&seq, sizeof(seq), 0), "accepted");
+    }
+    test_assert_int_eq(0, window.count, "nothing in flight");
+    test_assert_true(!mqtt_window_full(&window), "never full");
+    test_assert_int_eq(1, broker.delivered[9], "delivered once");
+}
+
+/**
+ * @brief MQTT in-flight window unit tests
+ *
+ */
+void test_mqtt_window(void) {
+    test_print("");
+    test_print("*************************");
+    test_print("Start mqtt_window tests");
+    test_print("*************************");
+
+    test_lossy();
+    test_give_up();
+    test_reconnect();
+    test_qos0();
+}
@@ -0,0 +1,195 @@
+#include <string.h>
+#include <pthread.h>
+
+#include "test_assert.h"
+#include "tests.h"
+#include "pipe_trace.h"
+
+/* DEFINES */
+#define STAMPER_NUM     4
+#define DUMP_MAX        (PIPE_TRACE_SIZE * 4 * PIPE_TRACE_EVENT_LEN)
+
+/* STATIC VARIABLES */
+static pipe_trace_t trace;
+static char dump[DUMP_MAX];
+
+/* STATIC PROTOTYPES */
+static void *stamper_fcn(void *arg);
+static int dump_all(int piece, int *pieces);
+static int count_str(const char *str, const char *sub);
+static void test_capture(void);
+static void test_json(void);
+static void test_stress(void);
+
+/**
+ * @brief stamp every stage of consecutive samples until the capture is full
+ *
+ * @param arg device index
+ * @return NULL
+ */
+static void *stamper_fcn(void *arg) {
+    uint16_t dev_id = (uint16_t)(intptr_t)arg;
+    for (uint32_t seq = dev_id * 1000000u; !pipe_trace_full(&trace); seq++) {
+        for (int stage = 0; stage < PIPE_TRACE_STAGE_MAX; stage++) {
+            pipe_trace_stamp(&trace, (pipe_trace_stage_t)stage, seq, dev_id, seq * 10 + stage);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief concatenate the JSON pieces of the capture
+ *
+ * @param piece buffer size per call
+ * @param pieces [out] calls returning data
+ * @return length, -1 if a piece overran its buffer
+ */
+static int dump_all(int piece, int *pieces) {
+    char buf[PIPE_TRACE_CHUNK * 4];
+    uint32_t pos = 0;
+    int len = 0;
+    int n;
+    *pieces = 0;
+    memset(buf, 0x55, sizeof(buf));
+    while ((n = pipe_trace_json(&trace, &pos, buf, piece)) > 0) {
+        if (n >= piece || buf[n] != '\0' || len + n >= DUMP_MAX) {
+            return -1;
+        }
+        memcpy(&dump[len], buf, n);
+        len += n;
+        (*pieces)++;
+    }
+    dump[len] = '\0';
+    return len;
+}
+
+/**
+ * @brief occurrences of sub in str
+ *
+ * @param str
+ * @param sub
+ * @return count
+ */
+static int count_str(const char *str, const char *sub) {
+    int count = 0;
+    for (const char *p = strstr(str, sub); p; p = strstr(p + 1, sub)) {
+        count++;
+    }
+    return count;
+}
+
+/**
+ * @brief records kept until full, later stamps dropped, reset starts over
+ *
+ */
+static void test_capture(void) {
+    pipe_trace_init(&trace);
+    pipe_trace_stamp(&trace, PIPE_TRACE_NOTIFY, 7, 2, 1000);
+    test_assert_int_eq(1, (int32_t)trace.done, "stamp recorded");
+    test_assert_true(trace.rec[0].seq == 7 && trace.rec[0].dev_id == 2 && trace.rec[0].ts_us == 1000, "record fields");
+    test_assert_true(!pipe_trace_full(&trace), "not full");
+    for (uint32_t n = 1; n < PIPE_TRACE_SIZE; n++) {
+        pipe_trace_stamp(&trace, PIPE_TRACE_RING, n, 0, n);
+    }
+    test_assert_true(pipe_trace_full(&trace), "full");
+    pipe_trace_stamp(&trace, PIPE_TRACE_WIRE, 99, 0, 99);
+    test_assert_int_eq(PIPE_TRACE_SIZE, (int32_t)trace.done, "stamp dropped once full");
+    test_assert_int_eq(PIPE_TRACE_RING, trace.rec[PIPE_TRACE_SIZE - 1].stage, "last record kept");
+    pipe_trace_reset(&trace);
+    test_assert_true(!pipe_trace_full(&trace), "capture restarted");
+    pipe_trace_stamp(&trace, PIPE_TRACE_WIRE, 99, 0, 99);
+    test_assert_true(trace.done == 1 && trace.rec[0].seq == 99, "first record of next capture");
+    test_assert_str_eq("ring", pipe_trace_span_name(PIPE_TRACE_POP), "span ending at pop");
+    test_assert_str_eq("", pipe_trace_span_name(PIPE_TRACE_STAGE_MAX), "no span");
+}
+
+/**
+ * @brief spans per stage and notify to wire, in pieces of any size, stamps out of order
+ *
+ */
+static void test_json(void) {
+    int pieces;
+    pipe_trace_init(&trace);
+    /* sample 1: main loop pops before the BTC task stamps the push */
+    pipe_trace_stamp(&trace, PIPE_TRACE_NOTIFY, 1, 2, 1000000);
+    pipe_trace_stamp(&trace, PIPE_TRACE_POP, 1, 2, 1000150);
+    pipe_trace_stamp(&trace, PIPE_TRACE_RING, 1, 2, 1000100);
+    pipe_trace_stamp(&trace, PIPE_TRACE_BATCH, 1, 2, 1000160);
+    /* sample 0 from an earlier capture, only its end is seen */
+    pipe_trace_stamp(&trace, PIPE_TRACE_WIRE, 0, 1, 1000170);
+    pipe_trace_stamp(&trace, PIPE_TRACE_PUBLISH, 1, 2, 2000000);
+    pipe_trace_stamp(&trace, PIPE_TRACE_WIRE, 1, 2, 5000002100ll);
+
+    int len = dump_all(PIPE_TRACE_CHUNK * 4, &pieces);
+    test_assert_true(len > 0 && pieces == 1, "one piece");
+    const char *first = "[\n{\"name\":\"ring\",\"cat\":\"sample\",\"ph\":\"b\",\"id\":1,\"pid\":1,\"tid\":2,"
+                        "\"ts\":1000100},\n";
+    test_assert_true(strncmp(dump, first, strlen(first)) == 0, "array of events, a line each");
+    test_assert_true(strstr(dump, "{\"name\":\"ring\",\"cat\":\"sample\",\"ph\":\"e\",\"id\":1,\"pid\":1,\"tid\":2,"
+                                  "\"ts\":1000150},\n") != NULL, "span from push to pop, stamped earlier");
+    test_assert_true(strstr(dump, "{\"name\":\"decode\",\"cat\":\"sample\",\"ph\":\"b\",\"id\":1,\"pid\":1,\"tid\":2,"
+                                  "\"ts\":1000000},\n") != NULL, "span from notify to push");
+    test_assert_true(strstr(dump, "\"name\":\"pipeline\",\"cat\":\"sample\",\"ph\":\"e\",\"id\":1,\"pid\":1,\"tid\":2,"
+                                  "\"ts\":5000002100}") != NULL, "notify to wire, 64-bit time");
+    test_assert_int_eq(6, count_str(dump, "\"ph\":\"b\""), "5 stages and the whole, id 0 skipped");
+    test_assert_int_eq(6, count_str(dump, "\"ph\":\"e\""), "every span ended");
+    test_assert_true(strcmp(&dump[len - 3], "}]\n") == 0, "array closed");
+
+    /* capture of 512 records in pieces of at least one record, same text */
+    pipe_trace_init(&trace);
+    for (uint32_t seq = 0; seq * PIPE_TRACE_STAGE_MAX < PIPE_TRACE_SIZE; seq++) {
+        for (int stage = 0; stage < PIPE_TRACE_STAGE_MAX; stage++) {
+            pipe_trace_stamp(&trace, (pipe_trace_stage_t)stage, seq, (uint16_t)(seq % 3), seq * 1000 + stage * 10);
+        }
+    }
+    len = dump_all(PIPE_TRACE_CHUNK * 4, &pieces);
+    static char whole[DUMP_MAX];
+    memcpy(whole, dump, len + 1);
+    int small = dump_all(4 * PIPE_TRACE_EVENT_LEN + 4, &pieces);
+    test_print("  %d records: %d bytes of JSON, %d pieces of %d bytes", PIPE_TRACE_SIZE, len, pieces,
+               4 * PIPE_TRACE_EVENT_LEN + 4);
+    test_assert_true(small == len && strcmp(whole, dump) == 0, "pieces add up to the whole");
+    /* 85 full samples, the 86th only pushed */
+    test_assert_int_eq(85 * 6 + 1, count_str(dump, "\"ph\":\"b\""), "spans of full and cut samples");
+    char buf[16];
+    uint32_t pos = 0;
+    test_assert_int_eq(0, pipe_trace_json(&trace, &pos, buf, sizeof(buf)), "buffer too small");
+}
+
+/**
+ * @brief stamps from several threads fill every record exactly once
+ *
+ */
+static void test_stress(void) {
+    pthread_t th[STAMPER_NUM];
+    pipe_trace_init(&trace);
+    for (int t = 0; t < STAMPER_NUM; t++) {
+        pthread_create(&th[t], NULL, stamper_fcn, (void *)(intptr_t)t);
+    }
+    for (int t = 0; t < STAMPER_NUM; t++) {
+        pthread_join(th[t], NULL);
+    }
+    int bad = 0;
+    for (int idx = 0; idx < PIPE_TRACE_SIZE; idx++) {
+        const pipe_trace_rec_t *rec = &trace.rec[idx];
+        bad += rec->stage >= PIPE_TRACE_STAGE_MAX || rec->dev_id >= STAMPER_NUM ||
+               rec->ts_us != (int64_t)rec->seq * 10 + rec->stage || rec->seq / 1000000u != rec->dev_id;
+    }
+    test_assert_true(pipe_trace_full(&trace), "filled by threads");
+    test_assert_int_eq(0, bad, "no torn or lost record");
+}
+
+/**
+ * @brief pipeline trace unit and pthread stress tests
+ *
+ */
+void test_pipe_trace(void) {
+    test_print("");
+    test_print("*************************");
+    test_print("Start pipe_trace tests");
+    test_print("*************************");
+
+    test_capture();
+    test_json();
+    test_stress();
+}
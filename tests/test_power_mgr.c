@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "test_assert.h"
+#include "tests.h"
+#include "power_mgr.h"
+
+/* DEFINES */
+#define SEC_US      1000000LL
+#define IDLE_PCT    95      /* lv_task_get_idle() with nothing to redraw */
+
+/* STATIC VARIABLES */
+static const power_mgr_cfg_t cfg_default = {
+    .off_ms = 60000,
+    .idle_min = 90,
+};
+
+/* STATIC PROTOTYPES */
+static int64_t run_until_off(power_mgr_t *pm, int64_t now_us, int64_t end_us, int64_t input_us, int64_t step_us);
+static void test_inactivity(void);
+static void test_busy(void);
+static void test_wake(void);
+static void test_time(void);
+static void test_readings(void);
+
+/**
+ * @brief poll like the GUI loop on a simulated clock until the display goes off
+ *
+ * @param pm
+ * @param now_us start
+ * @param end_us stop polling
+ * @param input_us time of last touch, inactive time counted from it
+ * @param step_us GUI loop period
+ * @return time the display went off, -1 if it stayed on
+ */
+static int64_t run_until_off(power_mgr_t *pm, int64_t now_us, int64_t end_us, int64_t input_us, int64_t step_us) {
+    for (; now_us < end_us; now_us += step_us) {
+        uint32_t inactive_ms = (uint32_t)((now_us - input_us) / 1000);
+        if (power_mgr_poll(pm, inactive_ms, IDLE_PCT, now_us) == POWER_MGR_ACT_OFF) {
+            return now_us;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief display goes off after off_ms without input nor event, never with off_ms 0
+ *
+ */
+static void test_inactivity(void) {
+    power_mgr_t pm;
+    power_mgr_init(&pm, &cfg_default, 0);
+    test_assert_int_eq(POWER_MGR_ON, pm.state, "display on at start");
+    int64_t off_us = run_until_off(&pm, 0, 120 * SEC_US, 0, 25000);
+    test_assert_true(off_us == 60 * SEC_US, "off after 60 s without input");
+    test_assert_int_eq(POWER_MGR_OFF, pm.state, "display off");
+    test_assert_int_eq(1, (int32_t)pm.off_count, "counted once");
+    test_assert_int_eq(POWER_MGR_ACT_NONE, power_mgr_poll(&pm, 90000, IDLE_PCT, 90 * SEC_US), "already off");
+
+    /* touch half way resets LVGL inactivity */
+    power_mgr_init(&pm, &cfg_default, 0);
+    off_us = run_until_off(&pm, 0, 120 * SEC_US, 30 * SEC_US, 25000);
+    test_assert_true(off_us == 90 * SEC_US, "off 60 s after last touch");
+
+    /* network events keep the display on even without touch */
+    power_mgr_init(&pm, &cfg_default, 0);
+    test_assert_int_eq(POWER_MGR_ACT_NONE, power_mgr_event(&pm, 50 * SEC_US), "event while on");
+    off_us = run_until_off(&pm, 0, 120 * SEC_US, 0, 25000);
+    test_assert_true(off_us == 110 * SEC_US, "off 60 s after last event");
+
+    power_mgr_cfg_t cfg = cfg_default;
+    cfg.off_ms = 0;
+    power_mgr_init(&pm, &cfg, 0);
+    test_assert_true(run_until_off(&pm, 0, 3600 * SEC_US, 0, SEC_US) < 0, "always on");
+}
+
+/**
+ * @brief a busy LVGL (animation, full redraw) delays turning off
+ *
+ */
+static void test_busy(void) {
+    power_mgr_t pm;
+    power_mgr_init(&pm, &cfg_default, 0);
+    test_assert_int_eq(POWER_MGR_ACT_NONE, power_mgr_poll(&pm, 61000, 40, 61 * SEC_US), "busy, stays on");
+    test_assert_int_eq(POWER_MGR_ACT_NONE, power_mgr_poll(&pm, 62000, 89, 62 * SEC_US), "below idle_min");
+    test_assert_int_eq(POWER_MGR_ACT_OFF, power_mgr_poll(&pm, 63000, 90, 63 * SEC_US), "idle, off");
+}
+
+/**
+ * @brief an event while off turns the display on, inactivity starts over
+ *
+ */
+static void test_wake(void) {
+    power_mgr_t pm;
+    power_mgr_init(&pm, &cfg_default, 0);
+    run_until_off(&pm, 0, 120 * SEC_US, 0, SEC_US);
+    test_assert_int_eq(POWER_MGR_ACT_ON, power_mgr_event(&pm, 100 * SEC_US), "reading wakes");
+    test_assert_int_eq(POWER_MGR_ON, pm.state, "display on");
+    test_assert_int_eq(1, (int32_t)pm.wake_count, "wake counted");
+    /* LVGL tick was stopped, inactive time is restarted by the caller */
+    int64_t off_us = run_until_off(&pm, 100 * SEC_US, 300 * SEC_US, 100 * SEC_US, SEC_US);
+    test_assert_true(off_us == 160 * SEC_US, "off again 60 s later");
+    test_assert_int_eq(2, (int32_t)pm.off_count, "second off");
+}
+
+/**
+ * @brief time in each state over a day of touches every 5 minutes, shown for 60 s each
+ *
+ */
+static void test_time(void) {
+    power_mgr_t pm;
+    power_mgr_init(&pm, &cfg_default, 0);
+    int64_t now_us = 0;
+    int64_t input_us = 0;
+    for (int64_t event_us = 0; event_us < 24 * 3600 * SEC_US; event_us += 300 * SEC_US) {
+        for (; now_us < event_us; now_us += SEC_US) {
+            power_mgr_poll(&pm, (uint32_t)((now_us - input_us) / 1000), IDLE_PCT, now_us);
+        }
+        if (power_mgr_event(&pm, event_us) == POWER_MGR_ACT_ON) {
+            input_us = event_us;
+        }
+    }
+    int64_t on_us = power_mgr_time(&pm, POWER_MGR_ON, now_us);
+    int64_t off_us = power_mgr_time(&pm, POWER_MGR_OFF, now_us);
+    test_assert_true(on_us + off_us == now_us, "all time accounted");
+    test_assert_int_eq(287, (int32_t)pm.off_count, "off between readings");
+    test_assert_int_eq(287, (int32_t)pm.wake_count, "woken by each touch");
+    test_assert_int_eq(80, (int32_t)(off_us * 100 / now_us), "display off 80 % of the day");
+    test_print("  display off %lld of %lld s", off_us / SEC_US, now_us / SEC_US);
+}
+
+/**
+ * @brief GUI loop with a sensor reading every 2 s and no touch: readings are redrawn,
+ *        the display still goes off and stays off until a wake event
+ *
+ */
+static void test_readings(void) {
+    power_mgr_t pm;
+    int64_t off_us = -1;
+    power_mgr_init(&pm, &cfg_default, 0);
+    for (int64_t now_us = 0; now_us < 600 * SEC_US; now_us += 25000) {
+        uint32_t in = (now_us % (2 * SEC_US) == 0) ? POWER_MGR_IN_READING : 0;
+        power_mgr_act_t act = power_mgr_step(&pm, in, (uint32_t)(now_us / 1000), IDLE_PCT, now_us);
+        if (act == POWER_MGR_ACT_OFF && off_us < 0) {
+            off_us = now_us;
+        }
+    }
+    test_assert_true(off_us == 60 * SEC_US, "off 60 s after last touch despite readings");
+    test_assert_int_eq(POWER_MGR_OFF, pm.state, "readings do not wake");
+    test_assert_int_eq(0, (int32_t)pm.wake_count, "no wake");
+    test_assert_int_eq(POWER_MGR_ACT_ON, power_mgr_step(&pm, POWER_MGR_IN_NET | POWER_MGR_IN_READING, 600000,
+                       IDLE_PCT, 600 * SEC_US), "network change wakes");
+    test_assert_int_eq(POWER_MGR_ACT_NONE, power_mgr_step(&pm, POWER_MGR_IN_READING, 0, IDLE_PCT, 601 * SEC_US),
+                       "stays on after wake");
+    power_mgr_step(&pm, 0, 61000, IDLE_PCT, 661 * SEC_US);
+    test_assert_int_eq(POWER_MGR_ACT_ON, power_mgr_step(&pm, POWER_MGR_IN_TOUCH, 0, IDLE_PCT, 700 * SEC_US),
+                       "touch wakes");
+}
+
+/**
+ * @brief power manager unit tests
+ *
+ */
+void test_power_mgr(void) {
+    test_print("");
+    test_print("*************************");
+    test_print("Start power_mgr tests");
+    test_print("*************************");
+
+    test_inactivity();
+    test_busy();
+    test_wake();
+    test_time();
+    test_readings();
+}
@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "test_assert.h"
+#include "tests.h"
+#include "remote_cfg.h"
+
+/* STATIC VARIABLES */
+static const remote_cfg_t cfg_default = {
+    .magic = REMOTE_CFG_MAGIC,
+    .batch_ms = 1000,
+    .batch_count = 16,
+    .agg_ms = 0,
+    .scan_fast = {50, 30},
+    .scan_slow = {500, 50},
+    .scan_idle_ms = 55000,
+};
+static const uint8_t bda_a[BLE_BDA_LEN] = {0xa4, 0xc1, 0x38, 0x00, 0x00, 0x01};
+static const uint8_t bda_b[BLE_BDA_LEN] = {0xa4, 0xc1, 0x38, 0x00, 0x00, 0x02};
+
+/* STATIC PROTOTYPES */
+static int parse(remote_cfg_t *cfg, const char *cmd, int *err_pos);
+static void test_parse(void);
+static void test_refuse(void);
+static void test_allow(void);
+static void test_persist(void);
+
+/**
+ * @brief parse terminated command
+ *
+ * @param cfg
+ * @param cmd
+ * @param err_pos
+ * @return see remote_cfg_parse
+ */
+static int parse(remote_cfg_t *cfg, const char *cmd, int *err_pos) {
+    return remote_cfg_parse(cfg, cmd, (int)strlen(cmd), err_pos);
+}
+
+/**
+ * @brief values applied, only groups whose values moved are reported
+ *
+ */
+static void test_parse(void) {
+    remote_cfg_t cfg = cfg_default;
+    int changed = parse(&cfg, "batch_ms=5000 batch_n=32;agg_ms=60000 agg_dt=20", NULL);
+    test_assert_int_eq(REMOTE_CFG_F_BATCH | REMOTE_CFG_F_AGG, changed, "batch and aggregation changed");
+    test_assert_int_eq(5000, (int32_t)cfg.batch_ms, "publish interval");
+    test_assert_int_eq(32, cfg.batch_count, "batch count");
+    test_assert_int_eq(60000, (int32_t)cfg.agg_ms, "aggregation window");
+    test_assert_int_eq(20, cfg.agg_temp_deadband, "temperature deadband");
+    test_assert_int_eq(0, cfg.agg_humid_deadband, "humidity deadband untouched");
+
+    changed = parse(&cfg, "batch_ms=5000\r\n", NULL);
+    test_assert_int_eq(0, changed, "same value, nothing changed");
+    changed = parse(&cfg, "scan_fast=100/20 scan_idle=25000", NULL);
+    test_assert_int_eq(REMOTE_CFG_F_SCAN, changed, "scan changed");
+    test_assert_true(cfg.scan_fast.interval == 100 && cfg.scan_fast.window == 20, "fast duty");
+    test_assert_int_eq(25000, (int32_t)cfg.scan_idle_ms, "sparse period");
+    test_assert_int_eq(0, parse(&cfg, "", NULL), "empty command");
+}
+
+/**
+ * @brief a bad pair refuses the whole command, offset points at it
+ *
+ */
+static void test_refuse(void) {
+    static const struct {
+        const char *cmd;
+        int err_pos;
+    } bad[] = {
+        {"batch_ms=5000 color=red", 14},
+        {"batch_n=0", 0},
+        {"batch_n=33", 0},
+        {"agg_ms=-1", 0},
+        {"agg_ms=3600001", 0},
+        {"agg_dt=65536", 0},
+        {"batch_ms=", 0},
+        {"batch_ms", 0},
+        {"batch_ms=1e3", 0},
+        {"scan_fast=100", 0},
+        {"scan_fast=100/200", 0},
+        {"scan_slow=2/2", 0},
+        {"agg_ms=0 allow=a4:c1:38:00:00", 9},
+        {"allow=a4-c1-38-00-00-01", 0},
+        {"allow=a4:c1:38:00:00:0g", 0},
+        {"allow=a4:c1:38:00:00:01,", 0},
+    };
+    for (int idx = 0; idx < (int)(sizeof(bad) / sizeof(bad[0])); idx++) {
+        remote_cfg_t cfg = cfg_default;
+        int err_pos = -1;
+        test_assert_int_eq(REMOTE_CFG_ERR, parse(&cfg, bad[idx].cmd, &err_pos), bad[idx].cmd);
+        test_assert_int_eq(bad[idx].err_pos, err_pos, "offset of refused pair");
+        test_assert_true(memcmp(&cfg, &cfg_default, sizeof(cfg)) == 0, "nothing changed");
+    }
+    char big[REMOTE_CFG_MSG_MAX + 1];
+    memset(big, ' ', sizeof(big));
+    remote_cfg_t cfg = cfg_default;
+    test_assert_int_eq(REMOTE_CFG_ERR, remote_cfg_parse(&cfg, big, sizeof(big), NULL), "oversize refused");
+}
+
+/**
+ * @brief allow list filters devices, "*" lets any in again
+ *
+ */
+static void test_allow(void) {
+    remote_cfg_t cfg = cfg_default;
+    test_assert_true(remote_cfg_allowed(&cfg, bda_a) && remote_cfg_allowed(&cfg, bda_b), "any device by default");
+    test_assert_int_eq(REMOTE_CFG_F_ALLOW, parse(&cfg, "allow=A4:C1:38:00:00:01", NULL), "allow list set");
+    test_assert_true(remote_cfg_allowed(&cfg, bda_a), "listed device allowed");
+    test_assert_true(!remote_cfg_allowed(&cfg, bda_b), "other device filtered");
+    test_assert_int_eq(REMOTE_CFG_F_ALLOW, parse(&cfg, "allow=a4:c1:38:00:00:01,a4:c1:38:00:00:02", NULL), "two devices");
+    test_assert_true(remote_cfg_allowed(&cfg, bda_b), "second device allowed");
+    test_assert_int_eq(0, parse(&cfg, "allow=a4:c1:38:00:00:01,a4:c1:38:00:00:02", NULL), "same list");
+
+    char cmd[REMOTE_CFG_MSG_MAX];
+    int len = 0;
+    len += sprintf(&cmd[len], "allow=");
+    for (int idx = 0; idx <= REMOTE_CFG_ALLOW_MAX; idx++) {
+        len += sprintf(&cmd[len], "%sa4:c1:38:00:00:%02x", idx ? "," : "", idx);
+    }
+    test_assert_int_eq(REMOTE_CFG_ERR, remote_cfg_parse(&cfg, cmd, len, NULL), "list too long");
+    test_assert_int_eq(REMOTE_CFG_F_ALLOW, parse(&cfg, "allow=*", NULL), "list cleared");
+    test_assert_true(remote_cfg_allowed(&cfg, bda_b) && cfg.allow_count == 0, "any device again");
+}
+
+/**
+ * @brief state text restores the settings, NVS blob checked before use
+ *
+ */
+static void test_persist(void) {
+    remote_cfg_t cfg = cfg_default;
+    char text[REMOTE_CFG_TEXT_LEN + 1];
+    int len = remote_cfg_text(&cfg, text, sizeof(text));
+    test_assert_str_eq("batch_ms=1000 batch_n=16 agg_ms=0 agg_dt=0 agg_dh=0 scan_fast=50/30 scan_slow=500/50 "
+                       "scan_idle=55000 allow=*", text, "state text");
+    test_assert_int_eq((int32_t)strlen(text), len, "length");
+    test_assert_int_eq(0, remote_cfg_text(&cfg, text, REMOTE_CFG_TEXT_LEN), "buffer too small");
+
+    /* longest state still fits and is accepted back as a command */
+    char cmd[REMOTE_CFG_MSG_MAX];
+    int cmd_len = sprintf(cmd, "batch_ms=3600000 agg_ms=3600000 agg_dt=65535 agg_dh=65535 scan_fast=10240/10240 "
+                               "scan_slow=10240/10240 scan_idle=3600000 allow=");
+    for (int idx = 0; idx < REMOTE_CFG_ALLOW_MAX; idx++) {
+        cmd_len += sprintf(&cmd[cmd_len], "%sa4:c1:38:00:00:%02x", idx ? "," : "", idx);
+    }
+    test_assert_true(remote_cfg_parse(&cfg, cmd, cmd_len, NULL) > 0, "longest command accepted");
+    len = remote_cfg_text(&cfg, text, sizeof(text));
+    remote_cfg_t copy = cfg_default;
+    char copy_text[REMOTE_CFG_TEXT_LEN + 1];
+    test_assert_true(remote_cfg_parse(&copy, text, len, NULL) > 0, "state text accepted");
+    remote_cfg_text(&copy, copy_text, sizeof(copy_text));
+    test_assert_str_eq(text, copy_text, "state text restores settings");
+    test_print("  longest state text %d of %d chars", len, REMOTE_CFG_TEXT_LEN);
+
+    remote_cfg_t loaded = cfg_default;
+    test_assert_true(remote_cfg_load(&loaded, &cfg, sizeof(cfg)), "blob loaded");
+    remote_cfg_text(&loaded, copy_text, sizeof(copy_text));
+    test_assert_str_eq(text, copy_text, "blob restores settings");
+    remote_cfg_t blob = cfg;
+    blob.magic ^= 1;
+    test_assert_true(!remote_cfg_load(&loaded, &blob, sizeof(blob)), "other layout refused");
+    blob = cfg;
+    blob.batch_count = 0;
+    test_assert_true(!remote_cfg_load(&loaded, &blob, sizeof(blob)), "out of range refused");
+    test_assert_true(!remote_cfg_load(&loaded, &cfg, sizeof(cfg) - 1), "short blob refused");
+    remote_cfg_text(&loaded, copy_text, sizeof(copy_text));
+    test_assert_str_eq(text, copy_text, "refused blob changes nothing");
+}
+
+/**
+ * @brief remote configuration unit tests
+ *
+ */
+void test_remote_cfg(void) {
+    test_print("");
+    test_print("*************************");
+    test_print("Start remote_cfg tests");
+    test_print("*************************");
+
+    test_parse();
+    test_refuse();
+    test_allow();
+    test_persist();
+}
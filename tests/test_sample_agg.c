@@ -0,0 +1,323 @@
+#include <string.h>
+
+#include "test_assert.h"
+#include "tests.h"
+#include "sample_agg.h"
+#include "mqtt_batch.h"
+#include "fmt_fixed.h"
+
+/* DEFINES */
+#define SIM_DEV         3
+#define SIM_PERIOD_US   6000000     /* LYWSD03MMC notifies every few seconds */
+#define SIM_HOURS       4
+#define OUT_MAX         16
+
+/* STATIC VARIABLES */
+static sample_agg_t agg;
+static mqtt_batch_t batch;
+static sensor_sample_t out[OUT_MAX];
+static int out_count;
+
+/* STATIC PROTOTYPES */
+static void capture_cb(const sensor_sample_t *rec, void *ctx);
+static void batch_cb(const sensor_sample_t *rec, void *ctx);
+static sensor_sample_t sim_reading(uint16_t dev_id, int64_t ts_us, int16_t temp, uint16_t humid);
+static void test_window(void);
+static void test_deadband(void);
+static void test_overflow(void);
+static void test_encode(void);
+static uint32_t sim_publish(const sample_agg_cfg_t *cfg, mqtt_batch_fmt_t fmt, uint32_t *msg_count);
+static void test_bytes(void);
+
+/**
+ * @brief keep emitted records
+ *
+ * @param rec
+ * @param ctx unused
+ */
+static void capture_cb(const sensor_sample_t *rec, void *ctx) {
+    (void)ctx;
+    if (out_count < OUT_MAX) {
+        out[out_count] = *rec;
+    }
+    out_count++;
+}
+
+/**
+ * @brief forward emitted records to the publish batch, as the main loop does
+ *
+ * @param rec
+ * @param ctx unused
+ */
+static void batch_cb(const sensor_sample_t *rec, void *ctx) {
+    (void)ctx;
+    mqtt_batch_add(&batch, rec, rec->ts_us);
+}
+
+/**
+ * @brief one reading
+ *
+ * @param dev_id
+ * @param ts_us
+ * @param temp
+ * @param humid
+ * @return sample
+ */
+static sensor_sample_t sim_reading(uint16_t dev_id, int64_t ts_us, int16_t temp, uint16_t humid) {
+    static uint32_t seq;
+    sensor_sample_t sample = {
+        .ts_us = ts_us,
+        .seq = seq++,
+        .dev_id = dev_id,
+        .temp_centi = temp,
+        .humid_centi = humid,
+        .rssi = -70,
+    };
+    return sample;
+}
+
+/**
+ * @brief min/max/mean/count per device and window, windows close on poll
+ *
+ */
+static void test_window(void) {
+    const sample_agg_cfg_t cfg = {.window_us = 60000000};
+    const int16_t temps[] = {2310, 2290, 2350, 2301};
+    sample_agg_init(&agg, &cfg, capture_cb, NULL);
+    out_count = 0;
+
+    for (int n = 0; n < 4; n++) {
+        sensor_sample_t s = sim_reading(1, n * 10000000LL, temps[n], (uint16_t)(5000 + n));
+        sample_agg_add(&agg, &s);
+        s = sim_reading(2, n * 10000000LL + 1, -150, 4000);
+        sample_agg_add(&agg, &s);
+    }
+    test_assert_int_eq(0, out_count, "nothing before window end");
+    test_assert_true(sample_agg_deadline(&agg) == 60000000, "deadline at end of first window");
+    test_assert_int_eq(0, sample_agg_poll(&agg, 59999999), "not yet");
+    test_assert_int_eq(1, sample_agg_poll(&agg, 60000000), "device 1 closed");
+    test_assert_int_eq(1, sample_agg_poll(&agg, 60000001), "device 2 closed");
+    test_assert_int_eq(2, out_count, "one record per device");
+    test_assert_int_eq(1, out[0].dev_id, "device");
+    test_assert_int_eq(4, out[0].count, "count");
+    test_assert_int_eq(2313, out[0].temp_centi, "mean rounded");
+    test_assert_int_eq(2290, out[0].temp_min_centi, "min");
+    test_assert_int_eq(2350, out[0].temp_max_centi, "max");
+    test_assert_int_eq(5002, out[0].humid_centi, "humid mean");
+    test_assert_int_eq(5000, out[0].humid_min_centi, "humid min");
+    test_assert_int_eq(5003, out[0].humid_max_centi, "humid max");
+    test_assert_true(out[0].ts_us == 30000000, "time of last reading");
+    test_assert_int_eq(-150, out[1].temp_centi, "negative mean");
+    test_assert_int_eq(-70, out[1].rssi, "rssi mean");
+    test_assert_true(sample_agg_deadline(&agg) == INT64_MAX, "no window open");
+
+    /* pass-through */
+    const sample_agg_cfg_t raw_cfg = {.window_us = 0};
+    sample_agg_init(&agg, &raw_cfg, capture_cb, NULL);
+    out_count = 0;
+    sensor_sample_t s = sim_reading(1, 0, 2000, 5000);
+    sample_agg_add(&agg, &s);
+    test_assert_true(out_count == 1 && out[0].count == 0 && out[0].seq == s.seq, "window 0 forwards readings");
+}
+
+/**
+ * @brief report on change: steady windows suppressed, a step is reported at once, heartbeat after silence
+ *
+ */
+static void test_deadband(void) {
+    const sample_agg_cfg_t cfg = {
+        .window_us = 60000000,
+        .temp_deadband = 20,
+        .humid_deadband = 100,
+        .max_silent_us = 600000000,
+    };
+    sample_agg_init(&agg, &cfg, capture_cb, NULL);
+    out_count = 0;
+    int64_t t = 0;
+
+    /* first window always reported, then 5 steady minutes */
+    for (; t < 360000000; t += SIM_PERIOD_US) {
+        sensor_sample_t s = sim_reading(1, t, (int16_t)(2300 + (t / SIM_PERIOD_US) % 3), 5000);
+        sample_agg_add(&agg, &s);
+        sample_agg_poll(&agg, t);
+    }
+    test_assert_int_eq(1, out_count, "steady values reported once");
+    test_assert_int_eq(4, (int32_t)agg.suppress_count, "steady windows suppressed");
+
+    /* door opened: temperature step */
+    sensor_sample_t s = sim_reading(1, t, 2150, 5000);
+    sample_agg_add(&agg, &s);
+    test_assert_int_eq(2, out_count, "step reported without waiting for window end");
+    test_assert_int_eq(1, (int32_t)agg.change_count, "counted as change");
+    test_assert_true(out[1].temp_min_centi == 2150 && out[1].temp_max_centi > 2300, "summary spans the step");
+
+    /* steady again until heartbeat */
+    int before = out_count;
+    int64_t step_t = t;
+    for (t += SIM_PERIOD_US; t < step_t + 720000000; t += SIM_PERIOD_US) {
+        s = sim_reading(1, t, 2150, 5000);
+        sample_agg_add(&agg, &s);
+        sample_agg_poll(&agg, t);
+    }
+    test_assert_int_eq(before + 1, out_count, "one heartbeat in 12 silent minutes");
+    test_assert_true(out[out_count - 1].count > 0, "heartbeat is a summary");
+
+    s = sim_reading(1, t, 2150, 5200);
+    sample_agg_add(&agg, &s);
+    test_assert_int_eq(before + 2, out_count, "humidity step reported");
+    s = sim_reading(1, t + 1, 2150, 5200);
+    sample_agg_add(&agg, &s);
+    sample_agg_flush(&agg);
+    test_assert_int_eq(before + 3, out_count, "flush reports open window");
+}
+
+/**
+ * @brief devices beyond the table are forwarded unsummarized
+ *
+ */
+static void test_overflow(void) {
+    const sample_agg_cfg_t cfg = {.window_us = 60000000};
+    sample_agg_init(&agg, &cfg, capture_cb, NULL);
+    out_count = 0;
+    for (int dev = 0; dev <= SAMPLE_AGG_DEV_MAX; dev++) {
+        sensor_sample_t s = sim_reading((uint16_t)dev, 0, 2000, 5000);
+        sample_agg_add(&agg, &s);
+    }
+    test_assert_int_eq(1, out_count, "last device forwarded");
+    test_assert_int_eq(SAMPLE_AGG_DEV_MAX, out[0].dev_id, "as single reading");
+    test_assert_int_eq(0, out[0].count, "not summarized");
+    test_assert_int_eq(1, (int32_t)agg.overflow_count, "counted");
+}
+
+/**
+ * @brief summaries in JSON and binary batches
+ *
+ */
+static void test_encode(void) {
+    char json[MQTT_BATCH_BUF_SIZE + 1];
+    sensor_sample_t rec = sim_reading(3, 0, 2313, 5002);
+    rec.seq = 7;
+    rec.count = 4;
+    rec.temp_min_centi = -105;
+    rec.temp_max_centi = 2350;
+    rec.humid_min_centi = 5000;
+    rec.humid_max_centi = 5003;
+
+    int len = fmt_agg_json(json, &rec, true);
+    json[len] = '\0';
+    test_assert_str_eq("{\"dev\":3,\"seq\":7,\"n\":4,\"temp\":[-1.05,23.13,23.50],\"humid\":[50.00,50.02,50.03]}",
+                       json, "summary JSON");
+    rec.dev_id = 65535;
+    rec.seq = 4294967295u;
+    rec.count = 65535;
+    rec.temp_min_centi = rec.temp_centi = rec.temp_max_centi = -32768;
+    rec.humid_min_centi = rec.humid_centi = rec.humid_max_centi = 65535;
+    test_assert_true(fmt_agg_json(json, &rec, true) <= FMT_AGG_JSON_LEN, "worst case fits FMT_AGG_JSON_LEN");
+
+    /* JSON batch of summaries flushed before the buffer could overflow */
+    const mqtt_batch_cfg_t json_cfg = {.fmt = MQTT_BATCH_FMT_JSON, .max_count = MQTT_BATCH_MAX, .window_us = 1000000};
+    mqtt_batch_init(&batch, &json_cfg, NULL, NULL);
+    for (int n = 0; n < MQTT_BATCH_MAX; n++) {
+        mqtt_batch_add(&batch, &rec, 0);
+    }
+    int per_msg = (MQTT_BATCH_BUF_SIZE - 2) / MQTT_BATCH_JSON_AGG_REC;
+    test_assert_int_eq(1, (int32_t)batch.msg_count, "flushed early");
+    test_assert_int_eq(per_msg, (int32_t)batch.sample_count, "as many worst-case summaries as fit");
+    test_assert_true(batch.byte_count <= MQTT_BATCH_BUF_SIZE, "within buffer");
+
+    /* binary: summary layout for the whole message */
+    const mqtt_batch_cfg_t bin_cfg = {.fmt = MQTT_BATCH_FMT_BINARY, .max_count = 4, .window_us = 1000000};
+    mqtt_batch_init(&batch, &bin_cfg, NULL, NULL);
+    sensor_sample_t single = sim_reading(1, 0, 2000, 4000);
+    mqtt_batch_add(&batch, &single, 0);
+    mqtt_batch_add(&batch, &rec, 0);
+    uint8_t bin[MQTT_BATCH_BUF_SIZE];
+    len = mqtt_batch_encode(&batch, 3, true, 0, bin, sizeof(bin));
+    test_assert_int_eq(MQTT_BATCH_BIN_HDR + 2 * MQTT_BATCH_BIN_AGG_REC, len, "summary record length");
+    test_assert_int_eq(MQTT_BATCH_BIN_AGG_VERSION, bin[0], "summary version");
+    test_assert_int_eq(1, bin[MQTT_BATCH_BIN_HDR + 10] | bin[MQTT_BATCH_BIN_HDR + 11] << 8, "single reading counts 1");
+    test_assert_int_eq(2000, bin[MQTT_BATCH_BIN_HDR + 12] | bin[MQTT_BATCH_BIN_HDR + 13] << 8, "single reading min = value");
+    test_assert_int_eq(0xFFFF, bin[MQTT_BATCH_BIN_HDR + 20 + 10] | bin[MQTT_BATCH_BIN_HDR + 20 + 11] << 8, "summary count");
+    len = mqtt_batch_encode(&batch, 1, true, 0, bin, sizeof(bin));
+    test_assert_true(len == MQTT_BATCH_BIN_HDR + MQTT_BATCH_BIN_REC && bin[0] == MQTT_BATCH_BIN_VERSION,
+                     "single readings keep the short layout");
+}
+
+/**
+ * @brief publish a simulated fleet through the aggregation stage and batches of 16 samples or 1 s
+ *
+ * @param cfg
+ * @param fmt
+ * @param msg_count [out]
+ * @return payload bytes published
+ */
+static uint32_t sim_publish(const sample_agg_cfg_t *cfg, mqtt_batch_fmt_t fmt, uint32_t *msg_count) {
+    const mqtt_batch_cfg_t batch_cfg = {.fmt = fmt, .max_count = 16, .window_us = 1000000};
+    uint32_t seed = 1;
+    mqtt_batch_init(&batch, &batch_cfg, NULL, NULL);
+    sample_agg_init(&agg, cfg, batch_cb, NULL);
+    for (int64_t t = 0; t < SIM_HOURS * 3600000000LL; t += SIM_PERIOD_US / SIM_DEV) {
+        uint16_t dev = (uint16_t)((t / (SIM_PERIOD_US / SIM_DEV)) % SIM_DEV);
+        /* slow drift over the day plus sensor noise of a few 0.01 degC */
+        seed = seed * 1103515245 + 12345;
+        int16_t temp = (int16_t)(2200 + dev * 100 + (t / 60000000) % 50 + (int)((seed >> 16) % 7) - 3);
+        uint16_t humid = (uint16_t)(5000 + (t / 120000000) % 200 + (seed >> 20) % 20);
+        sensor_sample_t s = sim_reading(dev, t, temp, humid);
+        sample_agg_add(&agg, &s);
+        sample_agg_poll(&agg, t);
+        mqtt_batch_poll(&batch, t);
+    }
+    sample_agg_flush(&agg);
+    mqtt_batch_flush(&batch, SIM_HOURS * 3600000000LL);
+    *msg_count = batch.msg_count;
+    return batch.byte_count;
+}
+
+/**
+ * @brief bytes published for raw readings vs per-minute summaries, with and without deadband
+ *
+ */
+static void test_bytes(void) {
+    const sample_agg_cfg_t raw = {.window_us = 0};
+    const sample_agg_cfg_t minute = {.window_us = 60000000};
+    const sample_agg_cfg_t deadband = {
+        .window_us = 60000000,
+        .temp_deadband = 20,
+        .humid_deadband = 100,
+        .max_silent_us = 900000000,
+    };
+    const struct {
+        const char *name;
+        const sample_agg_cfg_t *cfg;
+    } runs[] = {{"raw", &raw}, {"1 min", &minute}, {"1 min+deadband", &deadband}};
+    uint32_t bytes[3][2];
+    uint32_t msgs[3][2];
+
+    for (int run = 0; run < 3; run++) {
+        bytes[run][0] = sim_publish(runs[run].cfg, MQTT_BATCH_FMT_JSON, &msgs[run][0]);
+        bytes[run][1] = sim_publish(runs[run].cfg, MQTT_BATCH_FMT_BINARY, &msgs[run][1]);
+        test_print("   %-15s JSON %7u bytes %5u msgs   binary %7u bytes %5u msgs   records %u",
+                   runs[run].name, bytes[run][0], msgs[run][0], bytes[run][1], msgs[run][1], agg.out_count);
+    }
+    test_assert_true(bytes[1][0] * 5 < bytes[0][0], "summaries: JSON bytes under 1/5 of raw");
+    test_assert_true(bytes[1][1] * 5 < bytes[0][1], "summaries: binary bytes under 1/5 of raw");
+    test_assert_true(bytes[2][0] < bytes[1][0], "deadband saves more");
+    test_assert_true(msgs[1][0] * 5 < msgs[0][0], "fewer messages");
+}
+
+/**
+ * @brief aggregation stage unit tests
+ *
+ */
+void test_sample_agg(void) {
+    test_print("");
+    test_print("*************************");
+    test_print("Start sample_agg tests");
+    test_print("*************************");
+
+    test_window();
+    test_deadband();
+    test_overflow();
+    test_encode();
+    test_bytes();
+}
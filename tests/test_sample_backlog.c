@@ -0,0 +1,247 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "test_assert.h"
+#include "tests.h"
+#include "sample_backlog.h"
+#include "mqtt_batch.h"
+
+/* DEFINES */
+#define STORE_PATH      "backlog_test.bin"
+#define STORE_CAPACITY  100
+
+/* TYPE DEFINITIONS */
+typedef struct sink_t {
+    uint32_t count;
+    uint32_t next_seq;      /* expected seq, checks order */
+    uint32_t order_errors;
+} sink_t;
+
+/* last message published by the batch stage */
+typedef struct broker_msg_t {
+    uint32_t msg_count;
+    int len;
+    uint8_t data[MQTT_BATCH_BUF_SIZE + 1];
+} broker_msg_t;
+
+/* STATIC PROTOTYPES */
+static void sink_cb(const sensor_sample_t *sample, void *ctx);
+static void test_store(sample_store_t *store, const char *name);
+static void test_file_resume(void);
+static void test_drain(void);
+static void batch_sink_cb(const sensor_sample_t *sample, void *ctx);
+static void broker_publish(int dev_id, const uint8_t *data, int len, void *ctx);
+static void test_replay_age(void);
+
+/**
+ * @brief collect drained samples
+ * 
+ * @param sample 
+ * @param ctx sink_t
+ */
+static void sink_cb(const sensor_sample_t *sample, void *ctx) {
+    sink_t *sink = ctx;
+    if (sample->seq != sink->next_seq) {
+        sink->order_errors++;
+    }
+    sink->next_seq = sample->seq + 1;
+    sink->count++;
+}
+
+/**
+ * @brief common backend behaviour: FIFO, wrap-around, drop oldest when full
+ * 
+ * @param store 
+ * @param name 
+ */
+static void test_store(sample_store_t *store, const char *name) {
+    sensor_sample_t s = {0};
+    sensor_sample_t out[8];
+
+    test_print("Store backend: %s", name);
+    for (uint32_t n = 0; n < STORE_CAPACITY + 10; n++) {
+        s.seq = n;
+        test_assert_true(store->ops->append(store, &s), "append");
+    }
+    test_assert_int_eq(STORE_CAPACITY, (int32_t)sample_store_count(store), "capacity reached");
+    test_assert_int_eq(10, (int32_t)store->drop_count, "oldest dropped");
+    test_assert_int_eq(8, store->ops->peek(store, out, 8), "peek");
+    test_assert_int_eq(10, (int32_t)out[0].seq, "oldest kept first");
+    test_assert_int_eq(17, (int32_t)out[7].seq, "in order");
+    store->ops->consume(store, 95);
+    test_assert_int_eq(5, store->ops->peek(store, out, 8), "peek across wrap");
+    test_assert_int_eq(105, (int32_t)out[0].seq, "wrapped record");
+    store->ops->consume(store, 10);
+    test_assert_int_eq(0, (int32_t)sample_store_count(store), "empty");
+}
+
+/**
+ * @brief file backlog survives close/reopen, header mismatch starts empty
+ * 
+ */
+static void test_file_resume(void) {
+    sample_store_t store;
+    sensor_sample_t s = {0};
+    sensor_sample_t out;
+
+    test_print("File backend resume");
+    unlink(STORE_PATH);
+    test_assert_true(sample_store_file_open(&store, STORE_PATH, STORE_CAPACITY), "create");
+    for (uint32_t n = 0; n < 30; n++) {
+        s.seq = n;
+        store.ops->append(&store, &s);
+    }
+    store.ops->consume(&store, 12);
+    sample_store_file_close(&store);
+
+    test_assert_true(sample_store_file_open(&store, STORE_PATH, STORE_CAPACITY), "reopen");
+    test_assert_int_eq(18, (int32_t)sample_store_count(&store), "backlog resumed");
+    store.ops->peek(&store, &out, 1);
+    test_assert_int_eq(12, (int32_t)out.seq, "resume position");
+    sample_store_file_close(&store);
+
+    test_assert_true(sample_store_file_open(&store, STORE_PATH, STORE_CAPACITY * 2), "reopen other size");
+    test_assert_int_eq(0, (int32_t)sample_store_count(&store), "layout change starts empty");
+    sample_store_file_close(&store);
+    unlink(STORE_PATH);
+}
+
+/**
+ * @brief rate-limited drain on a simulated clock
+ * 
+ */
+static void test_drain(void) {
+    static sensor_sample_t buf[STORE_CAPACITY];
+    sample_store_t store;
+    sample_backlog_t backlog;
+    sink_t sink = {0};
+    sensor_sample_t s = {0};
+
+    test_print("Rate limited drain");
+    sample_store_ram_init(&store, buf, STORE_CAPACITY);
+    sample_backlog_init(&backlog, &store, 20, 5);
+    test_assert_true(sample_backlog_next_us(&backlog, 0) == INT64_MAX, "nothing to drain");
+    for (uint32_t n = 0; n < 60; n++) {
+        s.seq = n;
+        sample_backlog_store(&backlog, &s);
+    }
+    int64_t now = 10000000;
+    test_assert_int_eq(5, sample_backlog_drain(&backlog, now, sink_cb, &sink), "burst after reconnect");
+    test_assert_int_eq(0, sample_backlog_drain(&backlog, now, sink_cb, &sink), "no tokens left");
+    test_assert_true(sample_backlog_next_us(&backlog, now) == now + 50000, "next token at 1/rate");
+    test_assert_int_eq(0, sample_backlog_drain(&backlog, now + 49999, sink_cb, &sink), "too early");
+    test_assert_int_eq(1, sample_backlog_drain(&backlog, now + 50000, sink_cb, &sink), "one per 50 ms");
+    /* 1 s later: at most burst, never the whole backlog at once */
+    test_assert_int_eq(5, sample_backlog_drain(&backlog, now + 1050000, sink_cb, &sink), "capped by burst");
+    for (int64_t t = now + 1100000; sample_backlog_count(&backlog) > 0; t += 50000) {
+        sample_backlog_drain(&backlog, t, sink_cb, &sink);
+    }
+    test_assert_int_eq(60, (int32_t)sink.count, "everything drained");
+    test_assert_int_eq(0, (int32_t)sink.order_errors, "oldest first");
+}
+
+/**
+ * @brief drained samples go to the batch stage, as in the main loop
+ * 
+ * @param sample 
+ * @param ctx mqtt_batch_t, clock is the sample's replay time
+ */
+static void batch_sink_cb(const sensor_sample_t *sample, void *ctx) {
+    mqtt_batch_add(ctx, sample, 600000000);
+}
+
+/**
+ * @brief keep last published message
+ * 
+ * @param dev_id 
+ * @param data 
+ * @param len 
+ * @param ctx broker_msg_t
+ */
+static void broker_publish(int dev_id, const uint8_t *data, int len, void *ctx) {
+    broker_msg_t *msg = ctx;
+    (void)dev_id;
+    msg->msg_count++;
+    msg->len = len;
+    memcpy(msg->data, data, len);
+    msg->data[len] = '\0';
+}
+
+/**
+ * @brief samples replayed 10 minutes after capture keep their original time
+ * 
+ */
+static void test_replay_age(void) {
+    static sensor_sample_t buf[STORE_CAPACITY];
+    static mqtt_batch_t batch;
+    sample_store_t store;
+    sample_backlog_t backlog;
+    broker_msg_t broker = {0};
+    sensor_sample_t s = {.dev_id = 1};
+    int64_t now = 600000000;
+
+    test_print("Replayed sample age");
+    sample_store_ram_init(&store, buf, STORE_CAPACITY);
+    sample_backlog_init(&backlog, &store, 20, 5);
+    for (uint32_t n = 0; n < 2; n++) {
+        s.seq = n;
+        s.ts_us = 1000000 + n * 1500000;
+        sample_backlog_store(&backlog, &s);
+    }
+
+    mqtt_batch_cfg_t cfg = {MQTT_BATCH_FMT_JSON, 2, 1000000, false};
+    mqtt_batch_init(&batch, &cfg, broker_publish, &broker);
+    sample_backlog_drain(&backlog, now, batch_sink_cb, &batch);
+    test_assert_str_eq("[{\"dev\":1,\"seq\":0,\"temp\":0.00,\"humid\":0.00,\"age\":599000},"
+                       "{\"dev\":1,\"seq\":1,\"temp\":0.00,\"humid\":0.00,\"age\":597500}]",
+                       (const char *)broker.data, "JSON age at publish");
+
+    /* binary: a live sample does not share a message with old ones, dt_ms would overflow */
+    cfg.fmt = MQTT_BATCH_FMT_BINARY;
+    cfg.max_count = 3;
+    mqtt_batch_init(&batch, &cfg, broker_publish, &broker);
+    broker.msg_count = 0;
+    s.seq = 2;
+    s.ts_us = now;
+    mqtt_batch_add(&batch, &s, now);
+    for (uint32_t n = 0; n < 2; n++) {
+        s.seq = n;
+        s.ts_us = 1000000 + n * 1500000;
+        sample_backlog_store(&backlog, &s);
+    }
+    sample_backlog_drain(&backlog, now, batch_sink_cb, &batch);
+    test_assert_int_eq(1, (int32_t)broker.msg_count, "live sample published alone");
+    test_assert_int_eq(1, broker.data[1], "one record");
+    mqtt_batch_flush(&batch, now);
+    uint32_t age = broker.data[2] | broker.data[3] << 8 | broker.data[4] << 16 | (uint32_t)broker.data[5] << 24;
+    test_assert_int_eq(2, broker.data[1], "replayed records together");
+    test_assert_int_eq(599000, (int32_t)age, "binary age of oldest record");
+    test_assert_int_eq(0, broker.data[MQTT_BATCH_BIN_HDR + 8], "dt of oldest");
+    test_assert_int_eq(1500, broker.data[MQTT_BATCH_BIN_HDR + MQTT_BATCH_BIN_REC + 8] |
+                       broker.data[MQTT_BATCH_BIN_HDR + MQTT_BATCH_BIN_REC + 9] << 8, "dt keeps capture offset");
+}
+
+/**
+ * @brief store-and-forward backends and drain logic
+ * 
+ */
+void test_sample_backlog(void) {
+    static sensor_sample_t buf[STORE_CAPACITY];
+    sample_store_t store;
+
+    test_print("");
+    test_print("***************************");
+    test_print("Start sample_backlog tests");
+    test_print("***************************");
+
+    sample_store_ram_init(&store, buf, STORE_CAPACITY);
+    test_store(&store, "RAM");
+    unlink(STORE_PATH);
+    test_assert_true(sample_store_file_open(&store, STORE_PATH, STORE_CAPACITY), "open file store");
+    test_store(&store, "file");
+    sample_store_file_close(&store);
+    test_file_resume();
+    test_drain();
+    test_replay_age();
+}
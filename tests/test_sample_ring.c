@@ -0,0 +1,151 @@
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "test_assert.h"
+#include "tests.h"
+#include "sample_ring.h"
+
+/* DEFINES */
+#define PRODUCER_NUM        4
+#define SAMPLES_PER_PRODUCER 200000
+
+/* TYPE DEFINITIONS */
+typedef struct stress_result_t {
+    uint32_t popped;
+    uint32_t order_errors;      /* per-producer FIFO order violated */
+    uint32_t seq_errors;        /* ring sequence not increasing */
+} stress_result_t;
+
+/* STATIC VARIABLES */
+static sample_ring_t ring;
+static volatile int producers_done;
+
+/* STATIC PROTOTYPES */
+static void *producer_fcn(void *arg);
+static void stress_run(sample_ring_policy_t policy, stress_result_t *res);
+static void test_single_thread(void);
+static void test_stress(sample_ring_policy_t policy, const char *name);
+
+/**
+ * @brief push samples with per-producer counter in temp_centi
+ * 
+ * @param arg producer index
+ * @return NULL
+ */
+static void *producer_fcn(void *arg) {
+    uint16_t dev_id = (uint16_t)(intptr_t)arg;
+    for (int n = 0; n < SAMPLES_PER_PRODUCER; n++) {
+        sensor_sample_t sample = {
+            .ts_us = n,
+            .dev_id = dev_id,
+            .temp_centi = (int16_t)n,
+        };
+        sample_ring_push(&ring, &sample);
+        if ((n & 0x3F) == 0) {
+            /* bursts of 64, let the consumer catch up in between */
+            sched_yield();
+        }
+    }
+    __atomic_fetch_add(&producers_done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+/**
+ * @brief run producers against one consumer until all samples are accounted for
+ * 
+ * @param policy 
+ * @param res [out]
+ */
+static void stress_run(sample_ring_policy_t policy, stress_result_t *res) {
+    pthread_t th[PRODUCER_NUM];
+    int64_t last_ts[PRODUCER_NUM];
+    sensor_sample_t sample;
+
+    memset(res, 0, sizeof(stress_result_t));
+    for (int p = 0; p < PRODUCER_NUM; p++) {
+        last_ts[p] = -1;
+    }
+    sample_ring_init(&ring, policy);
+    producers_done = 0;
+    for (int p = 0; p < PRODUCER_NUM; p++) {
+        pthread_create(&th[p], NULL, producer_fcn, (void *)(intptr_t)p);
+    }
+    for (;;) {
+        int done = __atomic_load_n(&producers_done, __ATOMIC_ACQUIRE) == PRODUCER_NUM;
+        while (sample_ring_pop(&ring, &sample)) {
+            res->popped++;
+            if (sample.ts_us <= last_ts[sample.dev_id]) {
+                res->order_errors++;
+            }
+            last_ts[sample.dev_id] = sample.ts_us;
+        }
+        if (done) {
+            break;
+        }
+    }
+    for (int p = 0; p < PRODUCER_NUM; p++) {
+        pthread_join(th[p], NULL);
+    }
+}
+
+/**
+ * @brief ordering, sequence numbers and both overflow policies without threads
+ * 
+ */
+static void test_single_thread(void) {
+    sensor_sample_t sample = {0};
+
+    test_print("Single thread");
+    sample_ring_init(&ring, SAMPLE_RING_DROP_NEWEST);
+    test_assert_true(!sample_ring_pop(&ring, &sample), "empty ring");
+    for (int n = 0; n < SAMPLE_RING_SIZE + 3; n++) {
+        sample.temp_centi = (int16_t)n;
+        sample_ring_push(&ring, &sample);
+    }
+    test_assert_int_eq(SAMPLE_RING_SIZE, (int32_t)sample_ring_count(&ring), "ring full");
+    test_assert_int_eq(3, (int32_t)ring.drop_newest, "drop-newest counted");
+    test_assert_true(sample_ring_pop(&ring, &sample) && sample.temp_centi == 0 && sample.seq == 0, "oldest kept");
+
+    sample_ring_init(&ring, SAMPLE_RING_DROP_OLDEST);
+    for (int n = 0; n < SAMPLE_RING_SIZE + 3; n++) {
+        sample.temp_centi = (int16_t)n;
+        test_assert_true(sample_ring_push(&ring, &sample), "push accepted");
+    }
+    test_assert_int_eq(3, (int32_t)ring.drop_oldest, "drop-oldest counted");
+    test_assert_true(sample_ring_pop(&ring, &sample) && sample.temp_centi == 3 && sample.seq == 3, "newest kept");
+}
+
+/**
+ * @brief multi-producer stress, every pushed sample is popped or counted as dropped
+ * 
+ * @param policy 
+ * @param name 
+ */
+static void test_stress(sample_ring_policy_t policy, const char *name) {
+    stress_result_t res;
+
+    test_print("Stress %d producers, %s", PRODUCER_NUM, name);
+    stress_run(policy, &res);
+    uint32_t dropped = ring.drop_newest + ring.drop_oldest;
+    test_print("   popped %u, drop-newest %u, drop-oldest %u", res.popped, ring.drop_newest, ring.drop_oldest);
+    test_assert_int_eq(PRODUCER_NUM * SAMPLES_PER_PRODUCER, (int32_t)ring.push_count, "push count");
+    test_assert_int_eq(PRODUCER_NUM * SAMPLES_PER_PRODUCER, (int32_t)(res.popped + dropped), "no sample lost");
+    test_assert_int_eq(0, (int32_t)res.order_errors, "per-producer order kept");
+    test_assert_int_eq(0, (int32_t)sample_ring_count(&ring), "ring drained");
+}
+
+/**
+ * @brief sample ring unit and pthread stress tests
+ * 
+ */
+void test_sample_ring(void) {
+    test_print("");
+    test_print("************************");
+    test_print("Start sample_ring tests");
+    test_print("************************");
+
+    test_single_thread();
+    test_stress(SAMPLE_RING_DROP_NEWEST, "drop-newest");
+    test_stress(SAMPLE_RING_DROP_OLDEST, "drop-oldest");
+}
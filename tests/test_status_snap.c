@@ -0,0 +1,234 @@
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "test_assert.h"
+#include "tests.h"
+#include "status_snap.h"
+
+/* DEFINES */
+#define STRESS_WRITES       60000   /* < 65536, version kept in a uint16_t sensor value */
+#define STRESS_TEXT_LEN     1500    /* about the size of a full debug page */
+
+/* TYPE DEFINITIONS */
+typedef struct stress_result_t {
+    uint32_t reads;
+    uint32_t updates;           /* fields reported as changed */
+    uint32_t torn;              /* fields held in the view with mixed content */
+    uint32_t order_errors;      /* version or content went backwards */
+} stress_result_t;
+
+/* STATIC VARIABLES */
+static status_snap_t snap;
+static status_view_t view;
+static volatile int writer_done;
+
+/* STATIC PROTOTYPES */
+static bool set_sensor(uint16_t dev_id, int16_t temp, uint16_t humid, int64_t ts);
+static void *writer_fcn(void *arg);
+static void stress_check(int changed, stress_result_t *res, int *last);
+static void test_fields(void);
+static void test_sensor_table(void);
+static void test_concurrent_write(void);
+static void test_stress(void);
+
+/**
+ * @brief publish a sensor sample
+ *
+ * @param dev_id
+ * @param temp
+ * @param humid
+ * @param ts
+ * @return status_snap_set_sensor result
+ */
+static bool set_sensor(uint16_t dev_id, int16_t temp, uint16_t humid, int64_t ts) {
+    sensor_sample_t sample = {.dev_id = dev_id, .temp_centi = temp, .humid_centi = humid, .rssi = -60, .ts_us = ts};
+    return status_snap_set_sensor(&snap, &sample);
+}
+
+/**
+ * @brief rewrite text and one sensor, each version with uniform content
+ *
+ * @param arg unused
+ * @return NULL
+ */
+static void *writer_fcn(void *arg) {
+    (void)arg;
+    for (int n = 1; n <= STRESS_WRITES; n++) {
+        status_snap_write_begin(&snap, STATUS_FIELD_METRICS);
+        memset(snap.data.metrics, 'a' + n % 26, STRESS_TEXT_LEN);
+        snap.data.metrics[STRESS_TEXT_LEN] = '\0';
+        status_snap_write_end(&snap, STATUS_FIELD_METRICS);
+        set_sensor(7, (int16_t)n, (uint16_t)n, n);
+        if ((n & 0x3F) == 0) {
+            sched_yield();
+        }
+    }
+    __atomic_store_n(&writer_done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+/**
+ * @brief check every field held in the view is a whole version, changed ones newer than the last ones
+ *
+ * @param changed count from status_snap_read
+ * @param res
+ * @param last last sensor value seen
+ */
+static void stress_check(int changed, stress_result_t *res, int *last) {
+    const char *txt = view.data.metrics;
+    const status_sensor_t *sensor = &view.data.sensor[0];
+    res->reads++;
+    /* unchanged fields too, the GUI reads them on its own timers */
+    if (txt[0] != '\0') {
+        int len = 0;
+        while (txt[len] == txt[0] && len < STRESS_TEXT_LEN) {
+            len++;
+        }
+        if (len != STRESS_TEXT_LEN || txt[len] != '\0') {
+            res->torn++;
+        }
+    }
+    if (sensor->used && (uint16_t)sensor->temp_centi != sensor->humid_centi) {
+        res->torn++;
+    }
+    if (changed == 0) {
+        return;
+    }
+    if (STATUS_VIEW_CHANGED(&view, STATUS_FIELD_METRICS)) {
+        res->updates++;
+    }
+    if (STATUS_VIEW_CHANGED(&view, STATUS_FIELD_SENSOR)) {
+        res->updates++;
+        if (sensor->humid_centi <= *last) {
+            res->order_errors++;
+        }
+        *last = sensor->humid_centi;
+    }
+}
+
+/**
+ * @brief versions move only on change, reader gets each changed field once
+ *
+ */
+static void test_fields(void) {
+    status_snap_init(&snap);
+    status_view_init(&view);
+
+    test_assert_int_eq(0, status_snap_read(&snap, &view), "nothing written yet");
+    test_assert_true(status_snap_set_net(&snap, false, false), "first net status published");
+    test_assert_int_eq(1, status_snap_read(&snap, &view), "net read");
+    test_assert_true(STATUS_VIEW_CHANGED(&view, STATUS_FIELD_NET), "net changed");
+    test_assert_int_eq(0, status_snap_read(&snap, &view), "read once");
+    test_assert_true(!STATUS_VIEW_CHANGED(&view, STATUS_FIELD_NET), "changed cleared");
+
+    test_assert_true(!status_snap_set_net(&snap, false, false), "same net status");
+    test_assert_true(status_snap_set_net(&snap, true, false), "wifi up");
+    test_assert_true(status_snap_set_net(&snap, true, true), "mqtt up");
+    test_assert_int_eq(1, status_snap_read(&snap, &view), "two writes, one read");
+    test_assert_true(view.data.net.wifi && view.data.net.mqtt, "latest net status");
+
+    status_snap_write_begin(&snap, STATUS_FIELD_METRICS);
+    strcpy(snap.data.metrics, "Up 5 s");
+    status_snap_write_end(&snap, STATUS_FIELD_METRICS);
+    set_sensor(2, 2512, 4800, 5000000);
+    test_assert_int_eq(2, status_snap_read(&snap, &view), "metrics and sensor read");
+    test_assert_true(STATUS_VIEW_CHANGED(&view, STATUS_FIELD_METRICS) && STATUS_VIEW_CHANGED(&view, STATUS_FIELD_SENSOR) &&
+                     !STATUS_VIEW_CHANGED(&view, STATUS_FIELD_NET), "metrics and sensor changed");
+    test_assert_str_eq("Up 5 s", view.data.metrics, "metrics text");
+    test_assert_int_eq(2512, view.data.sensor[0].temp_centi, "sensor value");
+    test_assert_int_eq(-60, view.data.sensor[0].rssi, "sensor rssi");
+    test_assert_true(view.data.sensor[0].ts_us == 5000000, "sensor time");
+
+    /* second reader starts from nothing */
+    static status_view_t other;
+    status_view_init(&other);
+    test_assert_int_eq(3, status_snap_read(&snap, &other), "new reader gets all written fields");
+}
+
+/**
+ * @brief sensors keep their entry, table overflow is counted
+ *
+ */
+static void test_sensor_table(void) {
+    status_snap_init(&snap);
+    status_view_init(&view);
+
+    for (int idx = 0; idx < STATUS_SENSOR_MAX; idx++) {
+        set_sensor((uint16_t)(100 + idx), 2000, 5000, 0);
+    }
+    status_snap_read(&snap, &view);
+    test_assert_true(!set_sensor(103, 2000, 5000, 0), "same values");
+    test_assert_true(set_sensor(103, 2001, 5000, 0), "new temperature");
+    test_assert_true(set_sensor(104, 2000, 5000, 1000000), "same values, new reading");
+    test_assert_int_eq(2, status_snap_read(&snap, &view), "only those sensors");
+    test_assert_true(STATUS_VIEW_CHANGED(&view, STATUS_FIELD_SENSOR + 3) && STATUS_VIEW_CHANGED(&view, STATUS_FIELD_SENSOR + 4),
+                     "changed sensors flagged");
+    test_assert_int_eq(103, view.data.sensor[3].dev_id, "entry kept");
+
+    test_assert_true(!set_sensor(200, 2000, 5000, 0), "table full");
+    test_assert_int_eq(1, (int32_t)snap.sensor_overflow, "overflow counted");
+}
+
+/**
+ * @brief field being written is skipped, the others are still read
+ *
+ */
+static void test_concurrent_write(void) {
+    status_snap_init(&snap);
+    status_view_init(&view);
+    status_snap_set_net(&snap, true, true);
+    status_snap_read(&snap, &view);
+
+    status_snap_write_begin(&snap, STATUS_FIELD_METRICS);
+    strcpy(snap.data.metrics, "half");
+    status_snap_set_net(&snap, true, false);
+    test_assert_int_eq(1, status_snap_read(&snap, &view), "field in write skipped");
+    test_assert_true(STATUS_VIEW_CHANGED(&view, STATUS_FIELD_NET), "net read");
+    status_snap_write_end(&snap, STATUS_FIELD_METRICS);
+    test_assert_int_eq(1, status_snap_read(&snap, &view), "read after write");
+    test_assert_true(STATUS_VIEW_CHANGED(&view, STATUS_FIELD_METRICS), "metrics read");
+    test_assert_str_eq("half", view.data.metrics, "complete text");
+}
+
+/**
+ * @brief writer thread against a polling reader, every reported field is a whole version
+ *
+ */
+static void test_stress(void) {
+    stress_result_t res = {0};
+    int last = 0;
+    pthread_t th;
+
+    status_snap_init(&snap);
+    status_view_init(&view);
+    writer_done = 0;
+    test_print("Stress 1 writer, 1 reader");
+    pthread_create(&th, NULL, writer_fcn, NULL);
+    while (!__atomic_load_n(&writer_done, __ATOMIC_ACQUIRE)) {
+        stress_check(status_snap_read(&snap, &view), &res, &last);
+    }
+    pthread_join(th, NULL);
+    stress_check(status_snap_read(&snap, &view), &res, &last);
+    test_print("   reads %u, updates %u, torn copies retried %u", res.reads, res.updates, view.retry_count);
+    test_assert_int_eq(0, (int32_t)res.torn, "no torn field held in view");
+    test_assert_int_eq(0, (int32_t)res.order_errors, "versions in order");
+    test_assert_int_eq(STRESS_WRITES, last, "last version read");
+    test_assert_int_eq('a' + STRESS_WRITES % 26, view.data.metrics[0], "last text read");
+}
+
+/**
+ * @brief status snapshot unit and pthread stress tests
+ *
+ */
+void test_status_snap(void) {
+    test_print("");
+    test_print("************************");
+    test_print("Start status_snap tests");
+    test_print("************************");
+
+    test_fields();
+    test_sensor_table();
+    test_concurrent_write();
+    test_stress();
+}
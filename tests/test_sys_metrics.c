@@ -0,0 +1,231 @@
+#include <string.h>
+
+#include "test_assert.h"
+#include "tests.h"
+#include "sys_metrics.h"
+
+/* STATIC PROTOTYPES */
+static void test_cpu_share(void);
+static void test_task_table(void);
+static void test_queue_heap(void);
+static void test_format(void);
+
+/**
+ * @brief CPU share from run-time counter deltas, two cores, counter wrap
+ *
+ */
+static void test_cpu_share(void) {
+    sys_metrics_t metrics;
+    sys_task_stat_t tasks[] = {
+        {"IDLE0", 1, 0, 600, 0, 0},
+        {"IDLE1", 2, 0, 600, 1, 0},
+        {"main",  3, 0, 1500, -1, 1},
+        {"gui",   4, 0, 3000, 1, 1},
+    };
+    sys_metrics_init(&metrics, 2);
+
+    /* first sample is the baseline */
+    uint32_t total = 0xFFFFF000u;
+    tasks[0].runtime = 0x80000000u;
+    tasks[1].runtime = 0xFFFFFF00u;
+    tasks[2].runtime = 1000;
+    tasks[3].runtime = 2000;
+    sys_metrics_update(&metrics, tasks, 4, total, NULL, 0);
+    test_assert_true(!metrics.have_cpu, "no CPU share after first sample");
+    test_assert_int_eq(0, sys_metrics_load(&metrics), "load unknown");
+
+    /* 10000 ticks on each of 2 cores, IDLE1 counter wraps */
+    total += 10000;
+    tasks[0].runtime += 9000;       /* core 0: 90 % idle */
+    tasks[1].runtime += 5000;       /* core 1: 50 % idle */
+    tasks[2].runtime += 1000;
+    tasks[3].runtime += 5000;
+    sys_metrics_update(&metrics, tasks, 4, total, NULL, 1000000);
+    test_assert_true(metrics.have_cpu, "CPU share after second sample");
+    test_assert_int_eq(450, sys_metrics_task_find(&metrics, "IDLE0")->cpu_permille, "IDLE0 share of both cores");
+    test_assert_int_eq(250, sys_metrics_task_find(&metrics, "IDLE1")->cpu_permille, "IDLE1 across wrap");
+    test_assert_int_eq(50, sys_metrics_task_find(&metrics, "main")->cpu_permille, "main share");
+    test_assert_int_eq(250, sys_metrics_task_find(&metrics, "gui")->cpu_permille, "gui share");
+    test_assert_int_eq(300, sys_metrics_load(&metrics), "load is time not idle");
+
+    /* quiet period keeps the peak */
+    total += 10000;
+    tasks[0].runtime += 10000;
+    tasks[1].runtime += 10000;
+    sys_metrics_update(&metrics, tasks, 4, total, NULL, 2000000);
+    test_assert_int_eq(0, sys_metrics_task_find(&metrics, "gui")->cpu_permille, "gui idle");
+    test_assert_int_eq(250, sys_metrics_task_find(&metrics, "gui")->cpu_peak, "gui peak kept");
+    test_assert_int_eq(0, sys_metrics_load(&metrics), "no load");
+
+    /* run-time stats disabled: counter never moves */
+    sys_metrics_update(&metrics, tasks, 4, total, NULL, 3000000);
+    test_assert_true(!metrics.have_cpu, "no CPU share without counter");
+}
+
+/**
+ * @brief tasks appear, are deleted and overflow the table
+ *
+ */
+static void test_task_table(void) {
+    sys_metrics_t metrics;
+    sys_task_stat_t tasks[SYS_METRICS_TASK_MAX + 2];
+    char names[SYS_METRICS_TASK_MAX + 2][8];
+    sys_metrics_init(&metrics, 1);
+
+    for (int idx = 0; idx < SYS_METRICS_TASK_MAX + 2; idx++) {
+        names[idx][0] = 't';
+        names[idx][1] = (char)('a' + idx);
+        names[idx][2] = '\0';
+        tasks[idx] = (sys_task_stat_t){names[idx], (uint32_t)(100 + idx), 0, 4096, -1, 1};
+    }
+    sys_metrics_update(&metrics, tasks, 2, 0, NULL, 0);
+    test_assert_int_eq(2, metrics.task_num, "two tasks");
+
+    /* task started during the period: whole counter counts */
+    tasks[0].runtime = 500;
+    tasks[2].runtime = 500;
+    int low = sys_metrics_update(&metrics, tasks, 3, 1000, NULL, 0);
+    test_assert_int_eq(3, metrics.task_num, "new task tracked");
+    test_assert_int_eq(500, sys_metrics_task_find(&metrics, "tc")->cpu_permille, "new task share");
+    test_assert_int_eq(0, low, "no task low on stack");
+
+    /* tb deleted, order of the others kept */
+    tasks[1] = tasks[2];
+    tasks[1].stack_free = SYS_METRICS_STACK_WARN - 1;
+    low = sys_metrics_update(&metrics, tasks, 2, 2000, NULL, 0);
+    test_assert_int_eq(2, metrics.task_num, "deleted task dropped");
+    test_assert_str_eq("ta", metrics.task[0].name, "order kept");
+    test_assert_str_eq("tc", metrics.task[1].name, "order kept");
+    test_assert_true(sys_metrics_task_find(&metrics, "tb") == NULL, "deleted task gone");
+    test_assert_int_eq(1, low, "low stack reported");
+
+    /* more tasks than table entries */
+    tasks[1] = (sys_task_stat_t){names[1], 101, 0, 4096, -1, 1};
+    sys_metrics_init(&metrics, 1);
+    sys_metrics_update(&metrics, tasks, SYS_METRICS_TASK_MAX + 2, 0, NULL, 0);
+    test_assert_int_eq(SYS_METRICS_TASK_MAX, metrics.task_num, "table full");
+    test_assert_int_eq(2, (int32_t)metrics.task_overflow, "overflow counted");
+
+    /* names are truncated and made JSON safe */
+    sys_task_stat_t odd = {"a\"b\\c_very_long_task_name", 1, 0, 0, 0, 0};
+    sys_metrics_init(&metrics, 1);
+    sys_metrics_update(&metrics, &odd, 1, 0, NULL, 0);
+    test_assert_str_eq("a_b_c_very_long", metrics.task[0].name, "name sanitized");
+}
+
+/**
+ * @brief queue depth high water mark and heap snapshot
+ *
+ */
+static void test_queue_heap(void) {
+    sys_metrics_t metrics;
+    sys_metrics_init(&metrics, 1);
+
+    int ring = sys_metrics_queue_add(&metrics, "ring", 64);
+    int backlog = sys_metrics_queue_add(&metrics, "backlog", 512);
+    test_assert_int_eq(0, ring, "first queue");
+    test_assert_int_eq(1, backlog, "second queue");
+    for (int idx = 2; idx < SYS_METRICS_QUEUE_MAX; idx++) {
+        sys_metrics_queue_add(&metrics, "q", 1);
+    }
+    test_assert_int_eq(-1, sys_metrics_queue_add(&metrics, "q", 1), "queue table full");
+
+    sys_metrics_queue_set(&metrics, ring, 10);
+    sys_metrics_queue_set(&metrics, ring, 3);
+    sys_metrics_queue_set(&metrics, -1, 3);
+    test_assert_int_eq(3, (int32_t)metrics.queue[ring].depth, "current depth");
+    test_assert_int_eq(10, (int32_t)metrics.queue[ring].depth_max, "depth high water mark");
+
+    sys_heap_stat_t heap = {200000, 150000, 90000, 80000, 60000};
+    sys_metrics_update(&metrics, NULL, 0, 0, &heap, 5000000);
+    test_assert_int_eq(80000, (int32_t)metrics.heap.dma_min_free, "DMA low water mark");
+}
+
+/**
+ * @brief JSON and text layout, worst-case lengths
+ *
+ */
+static void test_format(void) {
+    static sys_metrics_t metrics;
+    static char buf[SYS_METRICS_JSON_LEN + SYS_METRICS_TEXT_LEN + 2];
+    sys_task_stat_t tasks[] = {
+        {"IDLE0", 1, 0, 600, 0, 0},
+        {"gui",   4, 0, 300, 1, 1},
+    };
+    sys_heap_stat_t heap = {200000, 150000, 90000, 80000, 60000};
+    sys_metrics_init(&metrics, 1);
+    sys_metrics_queue_add(&metrics, "ring", 64);
+    sys_metrics_queue_set(&metrics, 0, 2);
+    sys_metrics_update(&metrics, tasks, 2, 0, &heap, 0);
+
+    int len = sys_metrics_json(&metrics, buf, sizeof(buf));
+    test_assert_str_eq("{\"up\":0,\"heap\":{\"free\":200000,\"min\":150000,\"dma\":90000,\"dma_min\":80000,\"dma_blk\":60000},"
+                       "\"queue\":{\"ring\":[2,2,64]},"
+                       "\"task\":[{\"name\":\"IDLE0\",\"core\":0,\"prio\":0,\"stack\":600},"
+                       "{\"name\":\"gui\",\"core\":1,\"prio\":1,\"stack\":300}]}",
+                       buf, "JSON without CPU share");
+    test_assert_int_eq((int32_t)strlen(buf), len, "JSON length");
+
+    tasks[0].runtime = 750;
+    tasks[1].runtime = 250;
+    sys_metrics_update(&metrics, tasks, 2, 1000, &heap, 61000000);
+    sys_metrics_json(&metrics, buf, sizeof(buf));
+    test_assert_true(strstr(buf, "{\"up\":61,\"load\":25.0,") == buf, "JSON load");
+    test_assert_true(strstr(buf, "{\"name\":\"gui\",\"core\":1,\"prio\":1,\"cpu\":25.0,\"peak\":25.0,\"stack\":300}") != NULL,
+                     "JSON task CPU share");
+
+    sys_metrics_text(&metrics, buf, sizeof(buf));
+    test_assert_str_eq("Up 61 s, CPU load 25.0 %\n"
+                       "Heap 200000 B, min 150000 B\n"
+                       "DMA 90000 B, min 80000 B, block 60000 B\n"
+                       "ring            2/64 max 2\n"
+                       "IDLE0           c0 p0 75.0% 600 B stack\n"
+                       "gui             c1 p1 25.0% 300 B stack LOW\n",
+                       buf, "debug screen text");
+    sys_metrics_power_set(&metrics, &(sys_power_stat_t){600, 1800, 3});
+    sys_metrics_json(&metrics, buf, sizeof(buf));
+    test_assert_true(strstr(buf, "\"dma_blk\":60000},\"power\":{\"off\":75.0,\"off_s\":1800,\"off_n\":3},\"queue\"") != NULL,
+                     "JSON display power");
+    sys_metrics_text(&metrics, buf, sizeof(buf));
+    test_assert_true(strstr(buf, " B\nDisplay off 75.0 %, 1800 s in 3 times\nring ") != NULL, "debug screen power line");
+    test_assert_int_eq(0, sys_metrics_json(&metrics, buf, SYS_METRICS_JSON_LEN), "JSON buffer too small");
+    test_assert_int_eq(0, sys_metrics_text(&metrics, buf, SYS_METRICS_TEXT_LEN), "text buffer too small");
+
+    /* every field at its widest */
+    sys_task_stat_t wide[SYS_METRICS_TASK_MAX];
+    heap = (sys_heap_stat_t){UINT32_MAX, UINT32_MAX, UINT32_MAX, UINT32_MAX, UINT32_MAX};
+    sys_metrics_init(&metrics, 1);
+    for (int idx = 0; idx < SYS_METRICS_QUEUE_MAX; idx++) {
+        sys_metrics_queue_add(&metrics, "queue_name_long", UINT32_MAX);
+        sys_metrics_queue_set(&metrics, idx, UINT32_MAX);
+    }
+    for (int idx = 0; idx < SYS_METRICS_TASK_MAX; idx++) {
+        wide[idx] = (sys_task_stat_t){"task_name_long_", (uint32_t)idx, 0, UINT32_MAX, -128, 255};
+    }
+    sys_metrics_update(&metrics, wide, SYS_METRICS_TASK_MAX, 0, &heap, INT64_MAX / 2);
+    sys_metrics_power_set(&metrics, &(sys_power_stat_t){UINT32_MAX, UINT32_MAX, UINT32_MAX});
+    for (int idx = 0; idx < SYS_METRICS_TASK_MAX; idx++) {
+        wide[idx].runtime = UINT32_MAX;
+    }
+    sys_metrics_update(&metrics, wide, SYS_METRICS_TASK_MAX, UINT32_MAX, &heap, (int64_t)UINT32_MAX * 1000000);
+    len = sys_metrics_json(&metrics, buf, SYS_METRICS_JSON_LEN + 1);
+    test_assert_true(len > 0 && len <= SYS_METRICS_JSON_LEN, "JSON worst case fits SYS_METRICS_JSON_LEN");
+    len = sys_metrics_text(&metrics, buf, SYS_METRICS_TEXT_LEN + 1);
+    test_assert_true(len > 0 && len <= SYS_METRICS_TEXT_LEN, "text worst case fits SYS_METRICS_TEXT_LEN");
+}
+
+/**
+ * @brief CPU share, task table, queue depths, heap and formatting
+ *
+ */
+void test_sys_metrics(void) {
+    test_print("");
+    test_print("*************************");
+    test_print("Start sys_metrics tests");
+    test_print("*************************");
+
+    test_cpu_share();
+    test_task_table();
+    test_queue_heap();
+    test_format();
+}
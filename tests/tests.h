@@ -0,0 +1,25 @@
+#ifndef _TESTS_H
+#define _TESTS_H
+
+/**********************
+ *  PUBLIC PROTOTYPES
+ **********************/
+void test_ble_conn(void);
+void test_adv_decode(void);
+void test_sample_ring(void);
+void test_latency_hist(void);
+void test_mqtt_batch(void);
+void test_sample_backlog(void);
+void test_fmt_fixed(void);
+void test_sys_metrics(void);
+void test_ble_scan(void);
+void test_status_snap(void);
+void test_ble_cache(void);
+void test_mqtt_window(void);
+void test_sample_agg(void);
+void test_remote_cfg(void);
+void test_power_mgr(void);
+void test_ble_link(void);
+void test_pipe_trace(void);
+
+#endif